@@ -0,0 +1,603 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file null_sink.c
+ * @author Rafael Antoniello
+ */
+
+#include "null_sink.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <libcjson/cJSON.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/uri_parser.h>
+#include <libmediaprocsutils/fifo.h>
+#include <libmediaprocsutils/bench_stats.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/proc.h>
+#include "synth_src.h"
+
+/* **** Definitions **** */
+
+/**
+ * Maximum number of latency samples kept for percentiles computation.
+ */
+#define NULL_SINK_LATENCY_SAMPLES_MAX 8192
+
+/**
+ * Null sink processor settings context structure.
+ */
+typedef struct null_sink_settings_ctx_s {
+	// Reserved for future use
+} null_sink_settings_ctx_t;
+
+/**
+ * Null sink processor context structure.
+ */
+typedef struct null_sink_ctx_s {
+	/**
+	 * Generic processor context structure.
+	 * *MUST* be the first field in order to be able to cast to proc_ctx_t.
+	 */
+	struct proc_ctx_s proc_ctx;
+	/**
+	 * Null sink processor settings.
+	 */
+	volatile struct null_sink_settings_ctx_s null_sink_settings_ctx;
+	/**
+	 * Critical region to access the statistics below.
+	 */
+	pthread_mutex_t stats_mutex;
+	//@{
+	/**
+	 * Throughput statistics: number of frames and data bytes received, and
+	 * monotonic time [usecs] of the first and last arrivals.
+	 */
+	uint64_t frame_cnt;
+	uint64_t byte_cnt;
+	int64_t usecs_first;
+	int64_t usecs_last;
+	//@}
+	//@{
+	/**
+	 * Sequence statistics: number of missing frames (gaps) and of frames
+	 * arriving out of order.
+	 * Frames stamped by the synthetic source (see .synth_src.h) are checked
+	 * using the stamped sequence number. Otherwise, presentation time-stamps
+	 * are used: a frame is assumed missing when two consecutive time-stamps
+	 * differ in more than one and a half of the smallest difference
+	 * observed (which is taken as the frame period).
+	 */
+	uint64_t gap_cnt;
+	uint64_t reorder_cnt;
+	int flag_seq_valid;
+	uint64_t seq_last;
+	int flag_pts_valid;
+	int64_t pts_last;
+	int64_t pts_period;
+	//@}
+	/**
+	 * Latency statistics [usecs] (only for stamped frames): time elapsed
+	 * since the frame was generated.
+	 */
+	bench_stats_ctx_t *latency_stats;
+} null_sink_ctx_t;
+
+/* **** Prototypes **** */
+
+static proc_ctx_t* null_sink_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg);
+static void null_sink_close(proc_ctx_t **ref_proc_ctx);
+static int null_sink_send_frame(proc_ctx_t *proc_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx);
+static int null_sink_rest_put(proc_ctx_t *proc_ctx, const char *str);
+static int null_sink_rest_get(proc_ctx_t *proc_ctx,
+		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
+
+static int null_sink_settings_ctx_init(
+		volatile null_sink_settings_ctx_t *null_sink_settings_ctx,
+		log_ctx_t *log_ctx);
+static void null_sink_settings_ctx_deinit(
+		volatile null_sink_settings_ctx_t *null_sink_settings_ctx,
+		log_ctx_t *log_ctx);
+static void null_sink_stats_reset(null_sink_ctx_t *null_sink_ctx);
+
+/* **** Implementations **** */
+
+const proc_if_t proc_if_null_sink=
+{
+	"null_sink", "sink", "application/octet-stream",
+	(uint64_t)0,
+	null_sink_open,
+	null_sink_close,
+	null_sink_send_frame,
+	NULL, // send-no-dup
+	NULL, // does not output frames
+	NULL, // no specific unblock function extension
+	null_sink_rest_put,
+	null_sink_rest_get,
+	NULL, // frames are processed on arrival (no processing thread)
+	NULL, // no extra options
+	NULL, // no input FIFO elements
+	NULL, // no input FIFO elements
+	NULL // no output FIFO elements
+};
+
+/**
+ * Implements the proc_if_s::open callback.
+ * See .proc_if.h for further details.
+ */
+static proc_ctx_t* null_sink_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg)
+{
+	int ret_code, end_code= STAT_ERROR;
+	null_sink_ctx_t *null_sink_ctx= NULL;
+	volatile null_sink_settings_ctx_t *null_sink_settings_ctx=
+			NULL; // Do not release
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_if!= NULL, return NULL);
+	CHECK_DO(settings_str!= NULL, return NULL);
+	// Parameter 'href' is allowed to be NULL
+	// Parameter 'log_ctx' is allowed to be NULL
+
+	/* Allocate context structure */
+	null_sink_ctx= (null_sink_ctx_t*)calloc(1, sizeof(null_sink_ctx_t));
+	CHECK_DO(null_sink_ctx!= NULL, goto end);
+
+	/* Statistics */
+	ret_code= pthread_mutex_init(&null_sink_ctx->stats_mutex, NULL);
+	CHECK_DO(ret_code== 0, free(null_sink_ctx); return NULL);
+	null_sink_ctx->latency_stats= bench_stats_open(
+			NULL_SINK_LATENCY_SAMPLES_MAX);
+	CHECK_DO(null_sink_ctx->latency_stats!= NULL, goto end);
+	null_sink_stats_reset(null_sink_ctx);
+
+	/* Get settings structure */
+	null_sink_settings_ctx= &null_sink_ctx->null_sink_settings_ctx;
+
+	/* Initialize settings to defaults */
+	ret_code= null_sink_settings_ctx_init(null_sink_settings_ctx,
+			LOG_CTX_GET());
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	/* Parse and put given settings */
+	ret_code= null_sink_rest_put((proc_ctx_t*)null_sink_ctx, settings_str);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS)
+		null_sink_close((proc_ctx_t**)&null_sink_ctx);
+	return (proc_ctx_t*)null_sink_ctx;
+}
+
+/**
+ * Implements the proc_if_s::close callback.
+ * See .proc_if.h for further details.
+ */
+static void null_sink_close(proc_ctx_t **ref_proc_ctx)
+{
+	null_sink_ctx_t *null_sink_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+
+	if(ref_proc_ctx== NULL ||
+			(null_sink_ctx= (null_sink_ctx_t*)*ref_proc_ctx)== NULL)
+		return;
+
+	LOG_CTX_SET(((proc_ctx_t*)null_sink_ctx)->log_ctx);
+
+	/* Release settings */
+	null_sink_settings_ctx_deinit(&null_sink_ctx->null_sink_settings_ctx,
+			LOG_CTX_GET());
+
+	/* Release statistics */
+	bench_stats_close(&null_sink_ctx->latency_stats);
+	pthread_mutex_destroy(&null_sink_ctx->stats_mutex);
+
+	/* Release context structure */
+	free(null_sink_ctx);
+	*ref_proc_ctx= NULL;
+}
+
+/**
+ * Implements the proc_if_s::send_frame callback.
+ * See .proc_if.h for further details.
+ * The frame is accounted and discarded (it is neither copied nor queued).
+ */
+static int null_sink_send_frame(proc_ctx_t *proc_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx)
+{
+	int i;
+	int64_t usecs_now, pts_delta;
+	uint64_t byte_cnt= 0;
+	null_sink_ctx_t *null_sink_ctx= NULL;
+	synth_src_stamp_t synth_src_stamp;
+	int flag_stamped;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_frame_ctx!= NULL, return STAT_ERROR);
+
+	null_sink_ctx= (null_sink_ctx_t*)proc_ctx;
+	usecs_now= bench_now_usecs();
+
+	/* Data size (sum of all the data planes) */
+	for(i= 0; i< PROC_FRAME_NUM_DATA_POINTERS; i++) {
+		if(proc_frame_ctx->p_data[i]!= NULL)
+			byte_cnt+= (uint64_t)proc_frame_ctx->width[i]*
+					proc_frame_ctx->height[i];
+	}
+	flag_stamped= (synth_src_stamp_read(proc_frame_ctx, &synth_src_stamp)==
+			STAT_SUCCESS);
+
+	pthread_mutex_lock(&null_sink_ctx->stats_mutex);
+
+	/* Throughput */
+	if(null_sink_ctx->frame_cnt== 0)
+		null_sink_ctx->usecs_first= usecs_now;
+	null_sink_ctx->usecs_last= usecs_now;
+	null_sink_ctx->frame_cnt++;
+	null_sink_ctx->byte_cnt+= byte_cnt;
+
+	/* Gaps and reordering */
+	if(flag_stamped) {
+		if(null_sink_ctx->flag_seq_valid) {
+			if(synth_src_stamp.seq<= null_sink_ctx->seq_last)
+				null_sink_ctx->reorder_cnt++;
+			else
+				null_sink_ctx->gap_cnt+= synth_src_stamp.seq-
+						null_sink_ctx->seq_last- 1;
+		}
+		if(!null_sink_ctx->flag_seq_valid ||
+				synth_src_stamp.seq> null_sink_ctx->seq_last)
+			null_sink_ctx->seq_last= synth_src_stamp.seq;
+		null_sink_ctx->flag_seq_valid= 1;
+	} else {
+		if(null_sink_ctx->flag_pts_valid) {
+			pts_delta= proc_frame_ctx->pts- null_sink_ctx->pts_last;
+			if(pts_delta<= 0) {
+				null_sink_ctx->reorder_cnt++;
+			} else {
+				if(null_sink_ctx->pts_period<= 0 ||
+						pts_delta< null_sink_ctx->pts_period)
+					null_sink_ctx->pts_period= pts_delta;
+				if(pts_delta> null_sink_ctx->pts_period+
+						(null_sink_ctx->pts_period>> 1))
+					null_sink_ctx->gap_cnt+= (pts_delta+
+							(null_sink_ctx->pts_period>> 1))/
+							null_sink_ctx->pts_period- 1;
+			}
+		}
+		if(!null_sink_ctx->flag_pts_valid ||
+				proc_frame_ctx->pts> null_sink_ctx->pts_last)
+			null_sink_ctx->pts_last= proc_frame_ctx->pts;
+		null_sink_ctx->flag_pts_valid= 1;
+	}
+
+	pthread_mutex_unlock(&null_sink_ctx->stats_mutex);
+
+	/* Latency */
+	if(flag_stamped)
+		bench_stats_add(null_sink_ctx->latency_stats,
+				usecs_now- synth_src_stamp.gen_usecs);
+
+	return STAT_SUCCESS;
+}
+
+/**
+ * Implements the proc_if_s::rest_put callback.
+ * See .proc_if.h for further details.
+ * Besides settings, the following action is supported:
+ * - "reset": if set to true, statistics are reset.
+ */
+static int null_sink_rest_put(proc_ctx_t *proc_ctx, const char *str)
+{
+	int flag_is_query, flag_reset= 0, end_code= STAT_ERROR;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+	char *reset_str= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(str!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	/* Guess string representation format (JSON-REST or Query) */
+	flag_is_query= (str[0]=='{' && str[strlen(str)-1]=='}')? 0: 1;
+
+	/* Parse RESTful string */
+	if(flag_is_query== 1) {
+
+		/* 'reset' */
+		reset_str= uri_parser_query_str_get_value("reset", str);
+		if(reset_str!= NULL)
+			flag_reset= (strncmp(reset_str, "true", strlen("true"))== 0)?
+					1: 0;
+
+	} else {
+
+		/* In the case string format is JSON-REST, parse to cJSON structure */
+		cjson_rest= cJSON_Parse(str);
+		CHECK_DO(cjson_rest!= NULL, goto end);
+
+		/* 'reset' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "reset");
+		if(cjson_aux!= NULL)
+			flag_reset= (cjson_aux->type==cJSON_True)? 1: 0;
+	}
+
+	if(flag_reset)
+		null_sink_stats_reset((null_sink_ctx_t*)proc_ctx);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(reset_str!= NULL)
+		free(reset_str);
+	return end_code;
+}
+
+/**
+ * Implements the proc_if_s::rest_get callback.
+ * See .proc_if.h for further details.
+ */
+static int null_sink_rest_get(proc_ctx_t *proc_ctx,
+		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse)
+{
+	int i, end_code= STAT_ERROR;
+	int64_t usecs_elapsed;
+	uint64_t frame_cnt, byte_cnt, gap_cnt, reorder_cnt;
+	double fps= 0, bytes_per_sec= 0;
+	null_sink_ctx_t *null_sink_ctx= NULL;
+	bench_stats_summary_t latency_summary;
+	cJSON *cjson_rest= NULL, *cjson_settings= NULL, *cjson_latency= NULL;
+	cJSON *cjson_aux= NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(rest_fmt< PROC_IF_REST_FMT_ENUM_MAX, return STAT_ERROR);
+	CHECK_DO(ref_reponse!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	*ref_reponse= NULL;
+
+	/* Create cJSON tree root object */
+	cjson_rest= cJSON_CreateObject();
+	CHECK_DO(cjson_rest!= NULL, goto end);
+
+	/* JSON string to be returned:
+	 * {
+	 *     "settings":
+	 *     {
+	 *         ... // Reserved for future use
+	 *     },
+	 *     "frames":number,
+	 *     "bytes":number,
+	 *     "fps":number,
+	 *     "bytes_per_sec":number,
+	 *     "gaps":number,
+	 *     "reorders":number,
+	 *     "latency_usecs":
+	 *     {
+	 *         "count":number,
+	 *         "min":number,
+	 *         "mean":number,
+	 *         "p50":number,
+	 *         "p90":number,
+	 *         "p99":number,
+	 *         "p999":number,
+	 *         "max":number
+	 *     }
+	 * }
+	 * Rates are computed over the interval between the first and the last
+	 * frames received.
+	 */
+
+	/* Get processor context and a snapshot of the statistics */
+	null_sink_ctx= (null_sink_ctx_t*)proc_ctx;
+	pthread_mutex_lock(&null_sink_ctx->stats_mutex);
+	frame_cnt= null_sink_ctx->frame_cnt;
+	byte_cnt= null_sink_ctx->byte_cnt;
+	gap_cnt= null_sink_ctx->gap_cnt;
+	reorder_cnt= null_sink_ctx->reorder_cnt;
+	usecs_elapsed= null_sink_ctx->usecs_last- null_sink_ctx->usecs_first;
+	pthread_mutex_unlock(&null_sink_ctx->stats_mutex);
+	if(frame_cnt> 1 && usecs_elapsed> 0) {
+		fps= (double)(frame_cnt- 1)* 1000000.0/ usecs_elapsed;
+		bytes_per_sec= (double)byte_cnt* (frame_cnt- 1)/ frame_cnt*
+				1000000.0/ usecs_elapsed;
+	}
+	bench_stats_summary_get(null_sink_ctx->latency_stats, &latency_summary);
+
+	/* Create cJSON settings object */
+	cjson_settings= cJSON_CreateObject();
+	CHECK_DO(cjson_settings!= NULL, goto end);
+
+	/* GET specific processor settings */
+	// Reserved for future use: attach to 'cjson_settings' (should be != NULL)
+
+	/* Attach settings object to REST response */
+	cJSON_AddItemToObject(cjson_rest, "settings", cjson_settings);
+	cjson_settings= NULL; // Attached; avoid double referencing
+
+	/* **** Attach data to REST response **** */
+
+	/* 'frames' */
+	cjson_aux= cJSON_CreateNumber((double)frame_cnt);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "frames", cjson_aux);
+
+	/* 'bytes' */
+	cjson_aux= cJSON_CreateNumber((double)byte_cnt);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "bytes", cjson_aux);
+
+	/* 'fps' */
+	cjson_aux= cJSON_CreateNumber(fps);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "fps", cjson_aux);
+
+	/* 'bytes_per_sec' */
+	cjson_aux= cJSON_CreateNumber(bytes_per_sec);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "bytes_per_sec", cjson_aux);
+
+	/* 'gaps' */
+	cjson_aux= cJSON_CreateNumber((double)gap_cnt);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "gaps", cjson_aux);
+
+	/* 'reorders' */
+	cjson_aux= cJSON_CreateNumber((double)reorder_cnt);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "reorders", cjson_aux);
+
+	/* 'latency_usecs' */
+	cjson_latency= cJSON_CreateObject();
+	CHECK_DO(cjson_latency!= NULL, goto end);
+	{
+		const struct {
+			const char *name;
+			double value;
+		} latency_fields[]= {
+			{"count", (double)latency_summary.count},
+			{"min", (double)latency_summary.min},
+			{"mean", latency_summary.mean},
+			{"p50", (double)latency_summary.p50},
+			{"p90", (double)latency_summary.p90},
+			{"p99", (double)latency_summary.p99},
+			{"p999", (double)latency_summary.p999},
+			{"max", (double)latency_summary.max}
+		};
+		for(i= 0; i< (int)(sizeof(latency_fields)/
+				sizeof(latency_fields[0])); i++) {
+			cjson_aux= cJSON_CreateNumber(latency_fields[i].value);
+			CHECK_DO(cjson_aux!= NULL, goto end);
+			cJSON_AddItemToObject(cjson_latency, latency_fields[i].name,
+					cjson_aux);
+		}
+	}
+	cJSON_AddItemToObject(cjson_rest, "latency_usecs", cjson_latency);
+	cjson_latency= NULL; // Attached; avoid double referencing
+
+	/* Format response to be returned */
+	switch(rest_fmt) {
+	case PROC_IF_REST_FMT_CHAR:
+		/* Print cJSON structure data to char string */
+		*ref_reponse= (void*)CJSON_PRINT(cjson_rest);
+		CHECK_DO(*ref_reponse!= NULL && strlen((char*)*ref_reponse)> 0,
+				goto end);
+		break;
+	case PROC_IF_REST_FMT_CJSON:
+		*ref_reponse= (void*)cjson_rest;
+		cjson_rest= NULL; // Avoid double referencing
+		break;
+	default:
+		LOGE("Unknown format requested for processor REST\n");
+		goto end;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(cjson_settings!= NULL)
+		cJSON_Delete(cjson_settings);
+	if(cjson_latency!= NULL)
+		cJSON_Delete(cjson_latency);
+	return end_code;
+}
+
+/**
+ * Initialize specific null sink processor settings to defaults.
+ * @param null_sink_settings_ctx
+ * @param log_ctx
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int null_sink_settings_ctx_init(
+		volatile null_sink_settings_ctx_t *null_sink_settings_ctx,
+		log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(null_sink_settings_ctx!= NULL, return STAT_ERROR);
+
+	/* Initialize specific processor settings */
+	// Reserved for future use
+
+	return STAT_SUCCESS;
+}
+
+/**
+ * Release specific null sink processor settings (allocated in heap memory).
+ * @param null_sink_settings_ctx
+ * @param log_ctx
+ */
+static void null_sink_settings_ctx_deinit(
+		volatile null_sink_settings_ctx_t *null_sink_settings_ctx,
+		log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(null_sink_settings_ctx!= NULL, return);
+
+	/* Release specific processor settings */
+	// Reserved for future use
+}
+
+/**
+ * Reset null sink statistics.
+ * @param null_sink_ctx
+ */
+static void null_sink_stats_reset(null_sink_ctx_t *null_sink_ctx)
+{
+	pthread_mutex_lock(&null_sink_ctx->stats_mutex);
+	null_sink_ctx->frame_cnt= 0;
+	null_sink_ctx->byte_cnt= 0;
+	null_sink_ctx->usecs_first= 0;
+	null_sink_ctx->usecs_last= 0;
+	null_sink_ctx->gap_cnt= 0;
+	null_sink_ctx->reorder_cnt= 0;
+	null_sink_ctx->flag_seq_valid= 0;
+	null_sink_ctx->seq_last= 0;
+	null_sink_ctx->flag_pts_valid= 0;
+	null_sink_ctx->pts_last= 0;
+	null_sink_ctx->pts_period= 0;
+	bench_stats_reset(null_sink_ctx->latency_stats);
+	pthread_mutex_unlock(&null_sink_ctx->stats_mutex);
+}
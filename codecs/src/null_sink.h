@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file null_sink.h
+ * @brief Null sink processor.
+ * Consumes (discards) the frames sent to it, reporting throughput, sequence
+ * gaps and latency statistics (see the REST representation at
+ * null_sink.c). Frames are accounted on arrival, without being copied nor
+ * queued. Mainly intended for load generation in tests and benchmarks,
+ * together with the synthetic source processor (see .synth_src.h).
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_CODECS_SRC_NULL_SINK_H_
+#define MEDIAPROCESSORS_CODECS_SRC_NULL_SINK_H_
+
+/* **** Definitions **** */
+
+/* Forward definitions */
+typedef struct proc_if_s proc_if_t;
+
+/* **** prototypes **** */
+
+/**
+ * Processor interface implementing the null sink processor.
+ */
+extern const proc_if_t proc_if_null_sink;
+
+#endif /* MEDIAPROCESSORS_CODECS_SRC_NULL_SINK_H_ */
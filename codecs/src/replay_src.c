@@ -0,0 +1,800 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file replay_src.c
+ * @author Rafael Antoniello
+ */
+
+#include "replay_src.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <libcjson/cJSON.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/uri_parser.h>
+#include <libmediaprocsutils/fifo.h>
+#include <libmediaprocsutils/interr_usleep.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/proc.h>
+#include <libmediaprocs/proc_capture.h>
+
+/* **** Definitions **** */
+
+/**
+ * Maximum lag allowed with respect to the output schedule [usecs]. If
+ * output is delayed more than this (e.g. the consumer stalled), the output
+ * schedule is re-anchored to the current time instead of trying to catch
+ * up with a burst of frames.
+ */
+#define REPLAY_SRC_LAG_MAX_USECS 1000000
+
+/**
+ * Idle period when there is nothing to replay (no capture file set, or end
+ * of the capture reached and looping disabled) [usecs].
+ */
+#define REPLAY_SRC_IDLE_USECS 100000
+
+/**
+ * Capture replay source processor settings context structure.
+ */
+typedef struct replay_src_settings_ctx_s {
+	/**
+	 * Capture file name, relative to the capture directory (empty string if
+	 * not set).
+	 */
+	char *file;
+	/**
+	 * If set, frames are output as fast as the consumer reads them instead
+	 * of reproducing the recorded arrival times.
+	 */
+	int flag_max_rate;
+	/**
+	 * If set, replay restarts from the first frame when the end of the
+	 * capture is reached (presentation time-stamps are kept increasing).
+	 */
+	int flag_loop;
+} replay_src_settings_ctx_t;
+
+/**
+ * Capture replay source processor context structure.
+ */
+typedef struct replay_src_ctx_s {
+	/**
+	 * Generic processor context structure.
+	 * *MUST* be the first field in order to be able to cast to proc_ctx_t.
+	 */
+	struct proc_ctx_s proc_ctx;
+	/**
+	 * Capture replay source processor settings.
+	 * Settings are only modified within the settings critical section, and
+	 * each modification increments 'settings_version' (the processing
+	 * thread uses this to know when to re-open the capture file).
+	 */
+	struct replay_src_settings_ctx_s replay_src_settings_ctx;
+	pthread_mutex_t settings_mutex;
+	volatile uint32_t settings_version;
+	/**
+	 * Interruptible usleep used to pace the output; unblocked when the
+	 * processor is closed.
+	 */
+	interr_usleep_ctx_t *interr_usleep_ctx;
+	//@{
+	/**
+	 * Replay state (only accessed by the processing thread):
+	 * - Copy of the settings the replay was set up for, and the
+	 * corresponding settings version;
+	 * - Opened (memory-mapped) capture file;
+	 * - Presentation time-stamp span of the capture (added to the recorded
+	 * time-stamps on each loop).
+	 */
+	replay_src_settings_ctx_t settings_cur;
+	uint32_t settings_version_cur;
+	proc_capture_replay_ctx_t *proc_capture_replay_ctx;
+	int64_t pts_span;
+	int64_t pts_offset;
+	//@}
+	//@{
+	/**
+	 * Output schedule (only accessed by the processing thread):
+	 * - Set if the schedule has to be re-anchored on the next frame;
+	 * - Schedule anchor: monotonic time [usecs] and recorded arrival time
+	 * [usecs] of the frame output at the anchor.
+	 */
+	int flag_anchor;
+	int64_t usecs_anchor;
+	int64_t arrival_usecs_anchor;
+	//@}
+	//@{
+	/**
+	 * Status: number of frames in the capture file, index of the next frame
+	 * to output, number of frames output and last output presentation
+	 * time-stamp.
+	 */
+	volatile uint64_t frames_num;
+	volatile uint64_t position;
+	volatile uint64_t frame_oput_cnt;
+	volatile int64_t pts_oput;
+	//@}
+} replay_src_ctx_t;
+
+/* **** Prototypes **** */
+
+static proc_ctx_t* replay_src_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg);
+static void replay_src_close(proc_ctx_t **ref_proc_ctx);
+static int replay_src_unblock(proc_ctx_t *proc_ctx);
+static int replay_src_process_frame(proc_ctx_t *proc_ctx,
+		fifo_ctx_t *iput_fifo_ctx, fifo_ctx_t *oput_fifo_ctx);
+static int replay_src_rest_put(proc_ctx_t *proc_ctx, const char *str);
+static int replay_src_rest_get(proc_ctx_t *proc_ctx,
+		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
+
+static int replay_src_settings_ctx_init(
+		replay_src_settings_ctx_t *replay_src_settings_ctx,
+		log_ctx_t *log_ctx);
+static void replay_src_settings_ctx_deinit(
+		replay_src_settings_ctx_t *replay_src_settings_ctx,
+		log_ctx_t *log_ctx);
+static char* replay_src_rest_value_get(const char *name, const char *str,
+		cJSON *cjson_rest);
+
+static int replay_src_replay_build(replay_src_ctx_t *replay_src_ctx,
+		log_ctx_t *log_ctx);
+static int replay_src_idle(replay_src_ctx_t *replay_src_ctx);
+static int64_t replay_src_mono_usecs();
+
+/* **** Implementations **** */
+
+const proc_if_t proc_if_replay_src=
+{
+	"replay_src", "source", "application/octet-stream",
+	(uint64_t)PROC_FEATURE_BITRATE,
+	replay_src_open,
+	replay_src_close,
+	NULL, // does not accept input frames
+	NULL, // send-no-dup
+	proc_recv_frame_default1,
+	replay_src_unblock,
+	replay_src_rest_put,
+	replay_src_rest_get,
+	replay_src_process_frame,
+	NULL, // no extra options
+	NULL, // no input FIFO elements
+	NULL, // no input FIFO elements
+	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+};
+
+/**
+ * Implements the proc_if_s::open callback.
+ * See .proc_if.h for further details.
+ */
+static proc_ctx_t* replay_src_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg)
+{
+	int ret_code, end_code= STAT_ERROR;
+	replay_src_ctx_t *replay_src_ctx= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_if!= NULL, return NULL);
+	CHECK_DO(settings_str!= NULL, return NULL);
+	// Parameter 'href' is allowed to be NULL
+	// Parameter 'log_ctx' is allowed to be NULL
+
+	/* Allocate context structure */
+	replay_src_ctx= (replay_src_ctx_t*)calloc(1, sizeof(replay_src_ctx_t));
+	CHECK_DO(replay_src_ctx!= NULL, goto end);
+
+	/* Settings critical section */
+	ret_code= pthread_mutex_init(&replay_src_ctx->settings_mutex, NULL);
+	CHECK_DO(ret_code== 0, free(replay_src_ctx); return NULL);
+
+	/* Initialize settings to defaults */
+	ret_code= replay_src_settings_ctx_init(
+			&replay_src_ctx->replay_src_settings_ctx, LOG_CTX_GET());
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+	ret_code= replay_src_settings_ctx_init(&replay_src_ctx->settings_cur,
+			LOG_CTX_GET());
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	/* Parse and put given settings */
+	ret_code= replay_src_rest_put((proc_ctx_t*)replay_src_ctx, settings_str);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	/* Interruptible usleep used for output pacing */
+	replay_src_ctx->interr_usleep_ctx= interr_usleep_open();
+	CHECK_DO(replay_src_ctx->interr_usleep_ctx!= NULL, goto end);
+
+	/* Force the replay to be set up on the first frame */
+	replay_src_ctx->settings_version_cur= replay_src_ctx->settings_version- 1;
+	replay_src_ctx->pts_oput= -1;
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS)
+		replay_src_close((proc_ctx_t**)&replay_src_ctx);
+	return (proc_ctx_t*)replay_src_ctx;
+}
+
+/**
+ * Implements the proc_if_s::close callback.
+ * See .proc_if.h for further details.
+ */
+static void replay_src_close(proc_ctx_t **ref_proc_ctx)
+{
+	replay_src_ctx_t *replay_src_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+
+	if(ref_proc_ctx== NULL ||
+			(replay_src_ctx= (replay_src_ctx_t*)*ref_proc_ctx)== NULL)
+		return;
+
+	LOG_CTX_SET(((proc_ctx_t*)replay_src_ctx)->log_ctx);
+
+	/* Release settings */
+	replay_src_settings_ctx_deinit(&replay_src_ctx->replay_src_settings_ctx,
+			LOG_CTX_GET());
+	replay_src_settings_ctx_deinit(&replay_src_ctx->settings_cur,
+			LOG_CTX_GET());
+	pthread_mutex_destroy(&replay_src_ctx->settings_mutex);
+
+	/* Release interruptible usleep */
+	interr_usleep_close(&replay_src_ctx->interr_usleep_ctx);
+
+	/* Release (un-map) capture file */
+	proc_capture_replay_close(&replay_src_ctx->proc_capture_replay_ctx);
+
+	/* Release context structure */
+	free(replay_src_ctx);
+	*ref_proc_ctx= NULL;
+}
+
+/**
+ * Implements the proc_if_s::unblock callback.
+ * See .proc_if.h for further details.
+ */
+static int replay_src_unblock(proc_ctx_t *proc_ctx)
+{
+	replay_src_ctx_t *replay_src_ctx= (replay_src_ctx_t*)proc_ctx;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+
+	if(replay_src_ctx->interr_usleep_ctx!= NULL)
+		interr_usleep_unblock(replay_src_ctx->interr_usleep_ctx);
+	return STAT_SUCCESS;
+}
+
+/**
+ * Implements the proc_if_s::process_frame callback.
+ * See .proc_if.h for further details.
+ */
+static int replay_src_process_frame(proc_ctx_t *proc_ctx,
+		fifo_ctx_t* iput_fifo_ctx, fifo_ctx_t* oput_fifo_ctx)
+{
+	proc_frame_ctx_t proc_frame_ctx;
+	int64_t arrival_usecs, usecs_due, usecs_now;
+	int ret_code, end_code= STAT_ERROR;
+	replay_src_ctx_t *replay_src_ctx= NULL;
+	replay_src_settings_ctx_t *settings_cur= NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(oput_fifo_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	replay_src_ctx= (replay_src_ctx_t*)proc_ctx;
+	settings_cur= &replay_src_ctx->settings_cur;
+
+	/* (Re-)set up the replay if settings were modified */
+	if(replay_src_ctx->settings_version_cur!=
+			replay_src_ctx->settings_version) {
+		ret_code= replay_src_replay_build(replay_src_ctx, LOG_CTX_GET());
+		CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+	}
+
+	/* Check if there is something to replay; loop if applicable */
+	if(replay_src_ctx->proc_capture_replay_ctx== NULL ||
+			replay_src_ctx->frames_num== 0) {
+		end_code= replay_src_idle(replay_src_ctx);
+		goto end;
+	}
+	if(replay_src_ctx->position>= replay_src_ctx->frames_num) {
+		if(!settings_cur->flag_loop) {
+			end_code= replay_src_idle(replay_src_ctx);
+			goto end;
+		}
+		replay_src_ctx->position= 0;
+		replay_src_ctx->pts_offset+= replay_src_ctx->pts_span;
+		replay_src_ctx->flag_anchor= 1;
+	}
+
+	/* Get frame (data planes refer to the mapped capture file) */
+	ret_code= proc_capture_replay_get_frame(
+			replay_src_ctx->proc_capture_replay_ctx, replay_src_ctx->position,
+			&proc_frame_ctx, &arrival_usecs);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	/* Pace output reproducing the recorded arrival times (if applicable) */
+	usecs_now= replay_src_mono_usecs();
+	if(replay_src_ctx->flag_anchor) {
+		replay_src_ctx->flag_anchor= 0;
+		replay_src_ctx->usecs_anchor= usecs_now;
+		replay_src_ctx->arrival_usecs_anchor= arrival_usecs;
+	}
+	if(!settings_cur->flag_max_rate) {
+		usecs_due= replay_src_ctx->usecs_anchor+ (arrival_usecs-
+				replay_src_ctx->arrival_usecs_anchor);
+		if(usecs_due> usecs_now) {
+			ret_code= interr_usleep(replay_src_ctx->interr_usleep_ctx,
+					(uint32_t)(usecs_due- usecs_now));
+			if(ret_code== STAT_EINTR) {
+				/* This means processor was unblocked, go out with EOF */
+				end_code= STAT_EOF;
+				goto end;
+			}
+		} else if(usecs_now- usecs_due> REPLAY_SRC_LAG_MAX_USECS) {
+			replay_src_ctx->usecs_anchor= usecs_now;
+			replay_src_ctx->arrival_usecs_anchor= arrival_usecs;
+		}
+	}
+
+	/* Shift time-stamps when looping (unknown time-stamps are kept) */
+	if(proc_frame_ctx.pts>= 0)
+		proc_frame_ctx.pts+= replay_src_ctx->pts_offset;
+	if(proc_frame_ctx.dts>= 0)
+		proc_frame_ctx.dts+= replay_src_ctx->pts_offset;
+
+	/* Write frame to the output FIFO.
+	 * The FIFO duplicates the frame (this is the only copy of the recorded
+	 * data). The output FIFO is blocking, thus, when the consumer is slower
+	 * than the recorded rate, this just waits until a slot is freed (the
+	 * schedule is re-anchored if the wait is too long).
+	 */
+	ret_code= fifo_put_dup(oput_fifo_ctx, &proc_frame_ctx, sizeof(void*));
+	if(ret_code== STAT_ENOMEM) {
+		/* FIFO was unblocked (processor is being closed) */
+		end_code= STAT_EOF;
+		goto end;
+	}
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	replay_src_ctx->position++;
+	replay_src_ctx->pts_oput= proc_frame_ctx.pts;
+	replay_src_ctx->frame_oput_cnt++;
+
+	end_code= STAT_SUCCESS;
+end:
+	return end_code;
+}
+
+/**
+ * Implements the proc_if_s::rest_put callback.
+ * See .proc_if.h for further details.
+ */
+static int replay_src_rest_put(proc_ctx_t *proc_ctx, const char *str)
+{
+	int flag_is_query, end_code= STAT_ERROR;
+	replay_src_ctx_t *replay_src_ctx= NULL;
+	replay_src_settings_ctx_t settings= {0};
+	cJSON *cjson_rest= NULL;
+	char *file_str= NULL, *flag_max_rate_str= NULL, *flag_loop_str= NULL;
+	char path[PROC_CAPTURE_PATH_MAX];
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(str!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	/* Get processor context and a copy of the current settings (new
+	 * settings are applied all at once, and only if all are valid).
+	 */
+	replay_src_ctx= (replay_src_ctx_t*)proc_ctx;
+	pthread_mutex_lock(&replay_src_ctx->settings_mutex);
+	settings.flag_max_rate=
+			replay_src_ctx->replay_src_settings_ctx.flag_max_rate;
+	settings.flag_loop= replay_src_ctx->replay_src_settings_ctx.flag_loop;
+	pthread_mutex_unlock(&replay_src_ctx->settings_mutex);
+
+	/* Guess string representation format (JSON-REST or Query) */
+	flag_is_query= (str[0]=='{' && str[strlen(str)-1]=='}')? 0: 1;
+
+	/* In the case string format is JSON-REST, parse to cJSON structure */
+	if(flag_is_query== 0) {
+		cjson_rest= cJSON_Parse(str);
+		CHECK_DO(cjson_rest!= NULL, goto end);
+	}
+
+	/* 'file' (the file is actually opened by the processing thread; it is
+	 * restricted to the capture directory, see .proc_capture.h)
+	 */
+	file_str= replay_src_rest_value_get("file", str, cjson_rest);
+	if(file_str!= NULL && strlen(file_str)> 0) {
+		if(proc_capture_path_get(file_str, path, sizeof(path),
+				LOG_CTX_GET())!= STAT_SUCCESS) {
+			end_code= STAT_EINVAL;
+			goto end;
+		}
+		if(access(path, R_OK)!= 0) {
+			LOGE("Capture file '%s' can not be read\n", path);
+			end_code= STAT_EINVAL;
+			goto end;
+		}
+	}
+
+	/* 'flag_max_rate' */
+	flag_max_rate_str= replay_src_rest_value_get("flag_max_rate", str,
+			cjson_rest);
+	if(flag_max_rate_str!= NULL)
+		settings.flag_max_rate= (strncmp(flag_max_rate_str, "true",
+				strlen("true"))== 0)? 1: 0;
+
+	/* 'flag_loop' */
+	flag_loop_str= replay_src_rest_value_get("flag_loop", str, cjson_rest);
+	if(flag_loop_str!= NULL)
+		settings.flag_loop= (strncmp(flag_loop_str, "true",
+				strlen("true"))== 0)? 1: 0;
+
+	/* Apply new settings */
+	pthread_mutex_lock(&replay_src_ctx->settings_mutex);
+	if(file_str!= NULL) {
+		free(replay_src_ctx->replay_src_settings_ctx.file);
+		replay_src_ctx->replay_src_settings_ctx.file= file_str;
+		file_str= NULL; // Avoid double referencing
+	}
+	replay_src_ctx->replay_src_settings_ctx.flag_max_rate=
+			settings.flag_max_rate;
+	replay_src_ctx->replay_src_settings_ctx.flag_loop= settings.flag_loop;
+	replay_src_ctx->settings_version++;
+	pthread_mutex_unlock(&replay_src_ctx->settings_mutex);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(file_str!= NULL)
+		free(file_str);
+	if(flag_max_rate_str!= NULL)
+		free(flag_max_rate_str);
+	if(flag_loop_str!= NULL)
+		free(flag_loop_str);
+	return end_code;
+}
+
+/**
+ * Implements the proc_if_s::rest_get callback.
+ * See .proc_if.h for further details.
+ */
+static int replay_src_rest_get(proc_ctx_t *proc_ctx,
+		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse)
+{
+	int end_code= STAT_ERROR;
+	replay_src_ctx_t *replay_src_ctx= NULL;
+	cJSON *cjson_rest= NULL, *cjson_settings= NULL;
+	cJSON *cjson_aux= NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(rest_fmt< PROC_IF_REST_FMT_ENUM_MAX, return STAT_ERROR);
+	CHECK_DO(ref_reponse!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	*ref_reponse= NULL;
+
+	/* Create cJSON tree root object */
+	cjson_rest= cJSON_CreateObject();
+	CHECK_DO(cjson_rest!= NULL, goto end);
+
+	/* JSON string to be returned:
+	 * {
+	 *     "settings":
+	 *     {
+	 *         "file":string,
+	 *         "flag_max_rate":boolean,
+	 *         "flag_loop":boolean
+	 *     },
+	 *     "frames_num":number,
+	 *     "position":number,
+	 *     "frames_output":number,
+	 *     "pts_last":number
+	 * }
+	 */
+
+	replay_src_ctx= (replay_src_ctx_t*)proc_ctx;
+
+	/* Create cJSON settings object */
+	cjson_settings= cJSON_CreateObject();
+	CHECK_DO(cjson_settings!= NULL, goto end);
+
+	pthread_mutex_lock(&replay_src_ctx->settings_mutex);
+
+	/* 'file' */
+	cjson_aux= cJSON_CreateString(replay_src_ctx->replay_src_settings_ctx.file);
+	CHECK_DO(cjson_aux!= NULL,
+			pthread_mutex_unlock(&replay_src_ctx->settings_mutex); goto end);
+	cJSON_AddItemToObject(cjson_settings, "file", cjson_aux);
+
+	/* 'flag_max_rate' */
+	cjson_aux= cJSON_CreateBool(
+			replay_src_ctx->replay_src_settings_ctx.flag_max_rate);
+	CHECK_DO(cjson_aux!= NULL,
+			pthread_mutex_unlock(&replay_src_ctx->settings_mutex); goto end);
+	cJSON_AddItemToObject(cjson_settings, "flag_max_rate", cjson_aux);
+
+	/* 'flag_loop' */
+	cjson_aux= cJSON_CreateBool(
+			replay_src_ctx->replay_src_settings_ctx.flag_loop);
+	CHECK_DO(cjson_aux!= NULL,
+			pthread_mutex_unlock(&replay_src_ctx->settings_mutex); goto end);
+	cJSON_AddItemToObject(cjson_settings, "flag_loop", cjson_aux);
+
+	pthread_mutex_unlock(&replay_src_ctx->settings_mutex);
+
+	/* Attach settings object to REST response */
+	cJSON_AddItemToObject(cjson_rest, "settings", cjson_settings);
+	cjson_settings= NULL; // Attached; avoid double referencing
+
+	/* **** Attach data to REST response **** */
+
+	/* 'frames_num' */
+	cjson_aux= cJSON_CreateNumber((double)replay_src_ctx->frames_num);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "frames_num", cjson_aux);
+
+	/* 'position' */
+	cjson_aux= cJSON_CreateNumber((double)replay_src_ctx->position);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "position", cjson_aux);
+
+	/* 'frames_output' */
+	cjson_aux= cJSON_CreateNumber((double)replay_src_ctx->frame_oput_cnt);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "frames_output", cjson_aux);
+
+	/* 'pts_last' */
+	cjson_aux= cJSON_CreateNumber((double)replay_src_ctx->pts_oput);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "pts_last", cjson_aux);
+
+	/* Format response to be returned */
+	switch(rest_fmt) {
+	case PROC_IF_REST_FMT_CHAR:
+		/* Print cJSON structure data to char string */
+		*ref_reponse= (void*)CJSON_PRINT(cjson_rest);
+		CHECK_DO(*ref_reponse!= NULL && strlen((char*)*ref_reponse)> 0,
+				goto end);
+		break;
+	case PROC_IF_REST_FMT_CJSON:
+		*ref_reponse= (void*)cjson_rest;
+		cjson_rest= NULL; // Avoid double referencing
+		break;
+	default:
+		LOGE("Unknown format requested for processor REST\n");
+		goto end;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(cjson_settings!= NULL)
+		cJSON_Delete(cjson_settings);
+	return end_code;
+}
+
+/**
+ * Initialize specific capture replay source processor settings to defaults.
+ * @param replay_src_settings_ctx
+ * @param log_ctx
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int replay_src_settings_ctx_init(
+		replay_src_settings_ctx_t *replay_src_settings_ctx,
+		log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(replay_src_settings_ctx!= NULL, return STAT_ERROR);
+
+	/* Initialize specific processor settings */
+	replay_src_settings_ctx->file= strdup("");
+	CHECK_DO(replay_src_settings_ctx->file!= NULL, return STAT_ENOMEM);
+	replay_src_settings_ctx->flag_max_rate= 0;
+	replay_src_settings_ctx->flag_loop= 0;
+
+	return STAT_SUCCESS;
+}
+
+/**
+ * Release specific capture replay source processor settings (allocated in
+ * heap memory).
+ * @param replay_src_settings_ctx
+ * @param log_ctx
+ */
+static void replay_src_settings_ctx_deinit(
+		replay_src_settings_ctx_t *replay_src_settings_ctx,
+		log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(replay_src_settings_ctx!= NULL, return);
+
+	/* Release specific processor settings */
+	if(replay_src_settings_ctx->file!= NULL) {
+		free(replay_src_settings_ctx->file);
+		replay_src_settings_ctx->file= NULL;
+	}
+}
+
+/**
+ * Get the value of a setting from a REST string, as a character string.
+ * @param name Setting name.
+ * @param str REST string (used if it is a query-string).
+ * @param cjson_rest Parsed REST string (used if it is JSON formatted; NULL
+ * otherwise).
+ * @return Setting value (to be released by the caller); NULL if the setting
+ * is not specified.
+ */
+static char* replay_src_rest_value_get(const char *name, const char *str,
+		cJSON *cjson_rest)
+{
+	cJSON *cjson_aux= NULL; // Do not release
+
+	if(cjson_rest== NULL)
+		return uri_parser_query_str_get_value(name, str);
+
+	if((cjson_aux= cJSON_GetObjectItem(cjson_rest, name))== NULL)
+		return NULL;
+	switch(cjson_aux->type& 0xFF) {
+	case cJSON_True:
+		return strdup("true");
+	case cJSON_False:
+		return strdup("false");
+	case cJSON_String:
+		return cjson_aux->valuestring!= NULL?
+				strdup(cjson_aux->valuestring): NULL;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * (Re-)set up the replay according to the current settings: take a copy of
+ * the settings and, if the capture file changed, (re-)open it and rewind.
+ * The output schedule is re-anchored in any case.
+ * A capture file that can not be opened is reported and left closed
+ * (nothing is replayed until a valid file is set).
+ * @param replay_src_ctx
+ * @param log_ctx
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int replay_src_replay_build(replay_src_ctx_t *replay_src_ctx,
+		log_ctx_t *log_ctx)
+{
+	proc_frame_ctx_t proc_frame_ctx_first, proc_frame_ctx_last;
+	uint64_t frames_num;
+	int flag_file_changed;
+	char *file= NULL;
+	replay_src_settings_ctx_t *settings_cur= NULL; // Do not release
+	LOG_CTX_INIT(log_ctx);
+
+	settings_cur= &replay_src_ctx->settings_cur;
+
+	/* Take a copy of the settings */
+	pthread_mutex_lock(&replay_src_ctx->settings_mutex);
+	flag_file_changed= strcmp(settings_cur->file,
+			replay_src_ctx->replay_src_settings_ctx.file)!= 0;
+	if(flag_file_changed) {
+		file= strdup(replay_src_ctx->replay_src_settings_ctx.file);
+		CHECK_DO(file!= NULL,
+				pthread_mutex_unlock(&replay_src_ctx->settings_mutex);
+				return STAT_ENOMEM);
+	}
+	settings_cur->flag_max_rate=
+			replay_src_ctx->replay_src_settings_ctx.flag_max_rate;
+	settings_cur->flag_loop= replay_src_ctx->replay_src_settings_ctx.flag_loop;
+	replay_src_ctx->settings_version_cur= replay_src_ctx->settings_version;
+	pthread_mutex_unlock(&replay_src_ctx->settings_mutex);
+
+	replay_src_ctx->flag_anchor= 1;
+	if(!flag_file_changed)
+		return STAT_SUCCESS;
+
+	/* (Re-)open capture file and rewind */
+	free(settings_cur->file);
+	settings_cur->file= file;
+	proc_capture_replay_close(&replay_src_ctx->proc_capture_replay_ctx);
+	replay_src_ctx->frames_num= 0;
+	replay_src_ctx->position= 0;
+	replay_src_ctx->pts_span= 0;
+	replay_src_ctx->pts_offset= 0;
+	if(strlen(file)== 0)
+		return STAT_SUCCESS;
+	replay_src_ctx->proc_capture_replay_ctx= proc_capture_replay_open(file,
+			LOG_CTX_GET());
+	if(replay_src_ctx->proc_capture_replay_ctx== NULL) {
+		LOGE("Could not open capture file '%s' for replay\n", file);
+		return STAT_SUCCESS;
+	}
+	frames_num= proc_capture_replay_get_frames_num(
+			replay_src_ctx->proc_capture_replay_ctx);
+	replay_src_ctx->frames_num= frames_num;
+
+	/* Compute the presentation time-stamp span of the capture (duration
+	 * plus an average frame period), used to keep time-stamps increasing
+	 * when looping.
+	 */
+	if(frames_num> 1 && proc_capture_replay_get_frame(
+			replay_src_ctx->proc_capture_replay_ctx, 0,
+			&proc_frame_ctx_first, NULL)== STAT_SUCCESS &&
+			proc_capture_replay_get_frame(
+					replay_src_ctx->proc_capture_replay_ctx, frames_num- 1,
+					&proc_frame_ctx_last, NULL)== STAT_SUCCESS &&
+			proc_frame_ctx_last.pts> proc_frame_ctx_first.pts) {
+		int64_t duration= proc_frame_ctx_last.pts- proc_frame_ctx_first.pts;
+		replay_src_ctx->pts_span= duration+ duration/
+				(int64_t)(frames_num- 1);
+	}
+	return STAT_SUCCESS;
+}
+
+/**
+ * Wait (interruptibly) while there is nothing to replay.
+ * @return STAT_EOF if the processor was unblocked; STAT_EAGAIN otherwise.
+ */
+static int replay_src_idle(replay_src_ctx_t *replay_src_ctx)
+{
+	if(interr_usleep(replay_src_ctx->interr_usleep_ctx,
+			REPLAY_SRC_IDLE_USECS)== STAT_EINTR)
+		return STAT_EOF;
+	return STAT_EAGAIN;
+}
+
+/**
+ * Get monotonic clock time, in microseconds.
+ */
+static int64_t replay_src_mono_usecs()
+{
+	struct timespec monotime_curr= {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime_curr);
+	return (int64_t)monotime_curr.tv_sec* 1000000+
+			monotime_curr.tv_nsec/ 1000;
+}
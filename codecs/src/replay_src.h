@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file replay_src.h
+ * @brief Capture replay source processor.
+ * Outputs the frames recorded in a capture file (see .proc_capture.h and
+ * the generic "capture" setting of the processors), either reproducing the
+ * original arrival timing or as fast as the consumer reads them (see the
+ * settings structure at replay_src.c). The capture file is memory-mapped
+ * and frames are read directly from the mapping.
+ * The processor does not accept input frames.
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_CODECS_SRC_REPLAY_SRC_H_
+#define MEDIAPROCESSORS_CODECS_SRC_REPLAY_SRC_H_
+
+/* **** Definitions **** */
+
+/* Forward definitions */
+typedef struct proc_if_s proc_if_t;
+
+/* **** prototypes **** */
+
+/**
+ * Processor interface implementing the capture replay source processor.
+ */
+extern const proc_if_t proc_if_replay_src;
+
+#endif /* MEDIAPROCESSORS_CODECS_SRC_REPLAY_SRC_H_ */
@@ -0,0 +1,1084 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file synth_src.c
+ * @author Rafael Antoniello
+ */
+
+#include "synth_src.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include <libcjson/cJSON.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/uri_parser.h>
+#include <libmediaprocsutils/fifo.h>
+#include <libmediaprocsutils/interr_usleep.h>
+#include <libmediaprocsutils/bench_stats.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/proc.h>
+
+/* **** Definitions **** */
+
+/**
+ * Media types supported by the synthetic source.
+ */
+typedef enum synth_src_media_type_enum {
+	SYNTH_SRC_MEDIA_VIDEO= 0, ///< Raw video, YUV 4:2:0 planar
+	SYNTH_SRC_MEDIA_AUDIO, ///< Raw audio, interleaved signed 16 bits, stereo
+	SYNTH_SRC_MEDIA_ENUM_MAX
+} synth_src_media_type_t;
+
+/**
+ * Patterns supported by the synthetic source.
+ */
+typedef enum synth_src_pattern_enum {
+	SYNTH_SRC_PATTERN_MOVING= 0, ///< Moving gradients / 440Hz tone
+	SYNTH_SRC_PATTERN_NOISE, ///< Pseudo-random data
+	SYNTH_SRC_PATTERN_STATIC, ///< Color bars / silence
+	SYNTH_SRC_PATTERN_ENUM_MAX
+} synth_src_pattern_t;
+
+static const char *synth_src_media_type_lut[SYNTH_SRC_MEDIA_ENUM_MAX]=
+{
+	"video", "audio"
+};
+
+static const char *synth_src_pattern_lut[SYNTH_SRC_PATTERN_ENUM_MAX]=
+{
+	"moving", "noise", "static"
+};
+
+/**
+ * Number of audio channels generated.
+ */
+#define SYNTH_SRC_AUDIO_CHANNELS 2
+
+/**
+ * Frequency of the audio 'moving' pattern tone [Hz].
+ */
+#define SYNTH_SRC_AUDIO_TONE_HZ 440
+
+/**
+ * Maximum lag allowed with respect to the output schedule [usecs]. If
+ * output is delayed more than this (e.g. the consumer stalled), the output
+ * schedule is re-anchored to the current time instead of trying to catch
+ * up with a burst of frames.
+ */
+#define SYNTH_SRC_LAG_MAX_USECS 1000000
+
+/**
+ * Synthetic source processor settings context structure.
+ */
+typedef struct synth_src_settings_ctx_s {
+	/**
+	 * Media type (see synth_src_media_type_t).
+	 */
+	int media_type;
+	/**
+	 * Pattern (see synth_src_pattern_t).
+	 */
+	int pattern;
+	/**
+	 * Video picture width and height [pixels]. Must be even values.
+	 */
+	int width_output;
+	int height_output;
+	/**
+	 * Video frame rate [frames per second].
+	 */
+	int frame_rate_output;
+	/**
+	 * Audio sampling rate [Hz].
+	 */
+	int sample_rate_output;
+	/**
+	 * Audio frame size [samples per channel].
+	 */
+	int frame_size_output;
+	/**
+	 * If set, frames are output as fast as the consumer reads them instead
+	 * of at the rate given by the settings. Presentation time-stamps keep
+	 * following the configured rate anyway.
+	 */
+	int flag_max_rate;
+	/**
+	 * If set, each frame carries a stamp (see synth_src_stamp_t).
+	 */
+	int flag_stamp;
+} synth_src_settings_ctx_t;
+
+/**
+ * Synthetic source processor context structure.
+ */
+typedef struct synth_src_ctx_s {
+	/**
+	 * Generic processor context structure.
+	 * *MUST* be the first field in order to be able to cast to proc_ctx_t.
+	 */
+	struct proc_ctx_s proc_ctx;
+	/**
+	 * Synthetic source processor settings.
+	 * Settings are only modified within the settings critical section, and
+	 * each modification increments 'settings_version' (the processing
+	 * thread uses this to know when to re-build the frame generator).
+	 */
+	volatile struct synth_src_settings_ctx_s synth_src_settings_ctx;
+	pthread_mutex_t settings_mutex;
+	volatile uint32_t settings_version;
+	/**
+	 * Interruptible usleep used to pace the output; unblocked when the
+	 * processor is closed.
+	 */
+	interr_usleep_ctx_t *interr_usleep_ctx;
+	//@{
+	/**
+	 * Frame generator state (only accessed by the processing thread):
+	 * - Copy of the settings the generator was built for, and the
+	 * corresponding settings version;
+	 * - Output frame; it is re-used for every frame (the output FIFO
+	 * duplicates it) and its data buffer is allocated when the generator is
+	 * built;
+	 * - Auxiliary pattern table: luma/chroma ramp (video) or one second of
+	 * interleaved tone samples (audio);
+	 * - Pseudo-random generator state ('noise' pattern).
+	 */
+	synth_src_settings_ctx_t settings_cur;
+	uint32_t settings_version_cur;
+	proc_frame_ctx_t proc_frame_ctx;
+	size_t buf_size;
+	uint8_t *pattern_tab;
+	uint64_t rand_state;
+	//@}
+	//@{
+	/**
+	 * Output schedule (only accessed by the processing thread):
+	 * - Next frame sequence number;
+	 * - Schedule anchor: sequence number, monotonic time [usecs] and
+	 * presentation time-stamp of the frame preceding the anchor.
+	 */
+	uint64_t seq;
+	uint64_t seq_anchor;
+	int64_t usecs_anchor;
+	int64_t pts_anchor;
+	//@}
+	//@{
+	/**
+	 * Status: number of frames output and last output presentation
+	 * time-stamp.
+	 */
+	volatile uint64_t frame_oput_cnt;
+	volatile int64_t pts_oput;
+	//@}
+} synth_src_ctx_t;
+
+/* **** Prototypes **** */
+
+static proc_ctx_t* synth_src_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg);
+static void synth_src_close(proc_ctx_t **ref_proc_ctx);
+static int synth_src_unblock(proc_ctx_t *proc_ctx);
+static int synth_src_process_frame(proc_ctx_t *proc_ctx,
+		fifo_ctx_t *iput_fifo_ctx, fifo_ctx_t *oput_fifo_ctx);
+static int synth_src_rest_put(proc_ctx_t *proc_ctx, const char *str);
+static int synth_src_rest_get(proc_ctx_t *proc_ctx,
+		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
+
+static int synth_src_settings_ctx_init(
+		volatile synth_src_settings_ctx_t *synth_src_settings_ctx,
+		log_ctx_t *log_ctx);
+static void synth_src_settings_ctx_deinit(
+		volatile synth_src_settings_ctx_t *synth_src_settings_ctx,
+		log_ctx_t *log_ctx);
+static char* synth_src_rest_value_get(const char *name, const char *str,
+		cJSON *cjson_rest);
+static int synth_src_lut_index(const char **lut, int lut_size,
+		const char *value);
+
+static int synth_src_gen_build(synth_src_ctx_t *synth_src_ctx,
+		log_ctx_t *log_ctx);
+static void synth_src_gen_release(synth_src_ctx_t *synth_src_ctx);
+static void synth_src_render(synth_src_ctx_t *synth_src_ctx);
+static void synth_src_render_noise(synth_src_ctx_t *synth_src_ctx);
+static void synth_src_render_bars(synth_src_ctx_t *synth_src_ctx);
+
+/* **** Implementations **** */
+
+const proc_if_t proc_if_synth_src=
+{
+	"synth_src", "source", "application/octet-stream",
+	(uint64_t)PROC_FEATURE_BITRATE,
+	synth_src_open,
+	synth_src_close,
+	NULL, // does not accept input frames
+	NULL, // send-no-dup
+	proc_recv_frame_default1,
+	synth_src_unblock,
+	synth_src_rest_put,
+	synth_src_rest_get,
+	synth_src_process_frame,
+	NULL, // no extra options
+	NULL, // no input FIFO elements
+	NULL, // no input FIFO elements
+	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+};
+
+int synth_src_stamp_read(const proc_frame_ctx_t *proc_frame_ctx,
+		synth_src_stamp_t *synth_src_stamp)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_frame_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(synth_src_stamp!= NULL, return STAT_ERROR);
+
+	if(proc_frame_ctx->p_data[0]== NULL ||
+			proc_frame_ctx->width[0]< sizeof(synth_src_stamp_t))
+		return STAT_ENOTFOUND;
+
+	/* Note that data planes are not guaranteed to be aligned */
+	memcpy(synth_src_stamp, proc_frame_ctx->p_data[0],
+			sizeof(synth_src_stamp_t));
+	if(synth_src_stamp->magic!= SYNTH_SRC_STAMP_MAGIC)
+		return STAT_ENOTFOUND;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Implements the proc_if_s::open callback.
+ * See .proc_if.h for further details.
+ */
+static proc_ctx_t* synth_src_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg)
+{
+	int ret_code, end_code= STAT_ERROR;
+	synth_src_ctx_t *synth_src_ctx= NULL;
+	volatile synth_src_settings_ctx_t *synth_src_settings_ctx=
+			NULL; // Do not release
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_if!= NULL, return NULL);
+	CHECK_DO(settings_str!= NULL, return NULL);
+	// Parameter 'href' is allowed to be NULL
+	// Parameter 'log_ctx' is allowed to be NULL
+
+	/* Allocate context structure */
+	synth_src_ctx= (synth_src_ctx_t*)calloc(1, sizeof(synth_src_ctx_t));
+	CHECK_DO(synth_src_ctx!= NULL, goto end);
+
+	/* Settings critical section */
+	ret_code= pthread_mutex_init(&synth_src_ctx->settings_mutex, NULL);
+	CHECK_DO(ret_code== 0, free(synth_src_ctx); return NULL);
+
+	/* Get settings structure */
+	synth_src_settings_ctx= &synth_src_ctx->synth_src_settings_ctx;
+
+	/* Initialize settings to defaults */
+	ret_code= synth_src_settings_ctx_init(synth_src_settings_ctx,
+			LOG_CTX_GET());
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	/* Parse and put given settings */
+	ret_code= synth_src_rest_put((proc_ctx_t*)synth_src_ctx, settings_str);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	/* Interruptible usleep used for output pacing */
+	synth_src_ctx->interr_usleep_ctx= interr_usleep_open();
+	CHECK_DO(synth_src_ctx->interr_usleep_ctx!= NULL, goto end);
+
+	/* Force the frame generator to be built on the first frame */
+	synth_src_ctx->settings_version_cur= synth_src_ctx->settings_version- 1;
+	synth_src_ctx->rand_state= 0x9E3779B97F4A7C15ULL;
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS)
+		synth_src_close((proc_ctx_t**)&synth_src_ctx);
+	return (proc_ctx_t*)synth_src_ctx;
+}
+
+/**
+ * Implements the proc_if_s::close callback.
+ * See .proc_if.h for further details.
+ */
+static void synth_src_close(proc_ctx_t **ref_proc_ctx)
+{
+	synth_src_ctx_t *synth_src_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+
+	if(ref_proc_ctx== NULL ||
+			(synth_src_ctx= (synth_src_ctx_t*)*ref_proc_ctx)== NULL)
+		return;
+
+	LOG_CTX_SET(((proc_ctx_t*)synth_src_ctx)->log_ctx);
+
+	/* Release settings */
+	synth_src_settings_ctx_deinit(&synth_src_ctx->synth_src_settings_ctx,
+			LOG_CTX_GET());
+	pthread_mutex_destroy(&synth_src_ctx->settings_mutex);
+
+	/* Release interruptible usleep */
+	interr_usleep_close(&synth_src_ctx->interr_usleep_ctx);
+
+	/* Release frame generator */
+	synth_src_gen_release(synth_src_ctx);
+
+	/* Release context structure */
+	free(synth_src_ctx);
+	*ref_proc_ctx= NULL;
+}
+
+/**
+ * Implements the proc_if_s::unblock callback.
+ * See .proc_if.h for further details.
+ */
+static int synth_src_unblock(proc_ctx_t *proc_ctx)
+{
+	synth_src_ctx_t *synth_src_ctx= (synth_src_ctx_t*)proc_ctx;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+
+	if(synth_src_ctx->interr_usleep_ctx!= NULL)
+		interr_usleep_unblock(synth_src_ctx->interr_usleep_ctx);
+	return STAT_SUCCESS;
+}
+
+/**
+ * Implements the proc_if_s::process_frame callback.
+ * See .proc_if.h for further details.
+ */
+static int synth_src_process_frame(proc_ctx_t *proc_ctx,
+		fifo_ctx_t* iput_fifo_ctx, fifo_ctx_t* oput_fifo_ctx)
+{
+	int64_t period_num, period_den, usecs_due, usecs_now, pts;
+	int ret_code, end_code= STAT_ERROR;
+	synth_src_ctx_t *synth_src_ctx= NULL;
+	synth_src_settings_ctx_t *settings_cur= NULL; // Do not release
+	proc_frame_ctx_t *proc_frame_ctx= NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(oput_fifo_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	synth_src_ctx= (synth_src_ctx_t*)proc_ctx;
+	settings_cur= &synth_src_ctx->settings_cur;
+	proc_frame_ctx= &synth_src_ctx->proc_frame_ctx;
+
+	/* (Re-)build the frame generator if settings were modified */
+	if(synth_src_ctx->settings_version_cur!= synth_src_ctx->settings_version) {
+		ret_code= synth_src_gen_build(synth_src_ctx, LOG_CTX_GET());
+		CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+	}
+
+	/* Frame period is 'period_num/period_den' seconds */
+	if(settings_cur->media_type== SYNTH_SRC_MEDIA_AUDIO) {
+		period_num= settings_cur->frame_size_output;
+		period_den= settings_cur->sample_rate_output;
+	} else {
+		period_num= 1;
+		period_den= settings_cur->frame_rate_output;
+	}
+
+	/* Pace output according to the schedule (if applicable) */
+	if(!settings_cur->flag_max_rate) {
+		usecs_due= synth_src_ctx->usecs_anchor+ (int64_t)((synth_src_ctx->seq-
+				synth_src_ctx->seq_anchor)* 1000000* period_num/ period_den);
+		usecs_now= bench_now_usecs();
+		if(usecs_due> usecs_now) {
+			ret_code= interr_usleep(synth_src_ctx->interr_usleep_ctx,
+					(uint32_t)(usecs_due- usecs_now));
+			if(ret_code== STAT_EINTR) {
+				/* This means processor was unblocked, go out with EOF */
+				end_code= STAT_EOF;
+				goto end;
+			}
+		} else if(usecs_now- usecs_due> SYNTH_SRC_LAG_MAX_USECS) {
+			synth_src_ctx->seq_anchor= synth_src_ctx->seq;
+			synth_src_ctx->usecs_anchor= usecs_now;
+			synth_src_ctx->pts_anchor= synth_src_ctx->pts_oput;
+		}
+	}
+
+	/* Render frame. Presentation time-stamp is given in microseconds */
+	synth_src_render(synth_src_ctx);
+	pts= synth_src_ctx->pts_anchor+ (int64_t)(synth_src_ctx->seq-
+			synth_src_ctx->seq_anchor+ 1)* 1000000* period_num/ period_den;
+	proc_frame_ctx->pts= pts;
+	proc_frame_ctx->dts= pts;
+	if(settings_cur->flag_stamp) {
+		synth_src_stamp_t synth_src_stamp= {
+			SYNTH_SRC_STAMP_MAGIC, 0, synth_src_ctx->seq, bench_now_usecs()
+		};
+		memcpy(proc_frame_ctx->data, &synth_src_stamp,
+				sizeof(synth_src_stamp_t));
+	}
+
+	/* Write frame to the output FIFO.
+	 * Frame is duplicated by the FIFO (our buffer is re-used for the next
+	 * frame). The output FIFO is blocking, thus, when the consumer is
+	 * slower than the source, this just waits until a slot is freed (the
+	 * schedule is re-anchored if the wait is too long).
+	 */
+	ret_code= fifo_put_dup(oput_fifo_ctx, proc_frame_ctx, sizeof(void*));
+	if(ret_code== STAT_ENOMEM) {
+		/* FIFO was unblocked (processor is being closed) */
+		end_code= STAT_EOF;
+		goto end;
+	}
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	synth_src_ctx->seq++;
+	synth_src_ctx->pts_oput= pts;
+	synth_src_ctx->frame_oput_cnt++;
+
+	end_code= STAT_SUCCESS;
+end:
+	return end_code;
+}
+
+/**
+ * Implements the proc_if_s::rest_put callback.
+ * See .proc_if.h for further details.
+ */
+static int synth_src_rest_put(proc_ctx_t *proc_ctx, const char *str)
+{
+	int i, flag_is_query, end_code= STAT_ERROR;
+	synth_src_ctx_t *synth_src_ctx= NULL;
+	synth_src_settings_ctx_t settings;
+	cJSON *cjson_rest= NULL;
+	char *media_type_str= NULL, *pattern_str= NULL, *flag_max_rate_str= NULL,
+			*flag_stamp_str= NULL;
+	const struct {
+		const char *name;
+		int *ref_value;
+		int min, max, flag_even;
+	} int_fields[]= {
+		{"width_output", &settings.width_output, 32, 8192, 1},
+		{"height_output", &settings.height_output, 2, 8192, 1},
+		{"frame_rate_output", &settings.frame_rate_output, 1, 1000, 0},
+		{"sample_rate_output", &settings.sample_rate_output, 8000, 192000, 0},
+		{"frame_size_output", &settings.frame_size_output, 8, 65536, 0},
+		{NULL, NULL, 0, 0, 0}
+	};
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(str!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	/* Get processor context and a copy of the current settings (new
+	 * settings are applied all at once, and only if all are valid).
+	 */
+	synth_src_ctx= (synth_src_ctx_t*)proc_ctx;
+	pthread_mutex_lock(&synth_src_ctx->settings_mutex);
+	memcpy(&settings, (const void*)&synth_src_ctx->synth_src_settings_ctx,
+			sizeof(synth_src_settings_ctx_t));
+	pthread_mutex_unlock(&synth_src_ctx->settings_mutex);
+
+	/* Guess string representation format (JSON-REST or Query) */
+	flag_is_query= (str[0]=='{' && str[strlen(str)-1]=='}')? 0: 1;
+
+	/* In the case string format is JSON-REST, parse to cJSON structure */
+	if(flag_is_query== 0) {
+		cjson_rest= cJSON_Parse(str);
+		CHECK_DO(cjson_rest!= NULL, goto end);
+	}
+
+	/* 'media_type' */
+	media_type_str= synth_src_rest_value_get("media_type", str, cjson_rest);
+	if(media_type_str!= NULL) {
+		settings.media_type= synth_src_lut_index(synth_src_media_type_lut,
+				SYNTH_SRC_MEDIA_ENUM_MAX, media_type_str);
+		CHECK_DO(settings.media_type>= 0,
+				LOGE("Unknown media type '%s'\n", media_type_str);
+				end_code= STAT_EINVAL; goto end);
+	}
+
+	/* 'pattern' */
+	pattern_str= synth_src_rest_value_get("pattern", str, cjson_rest);
+	if(pattern_str!= NULL) {
+		settings.pattern= synth_src_lut_index(synth_src_pattern_lut,
+				SYNTH_SRC_PATTERN_ENUM_MAX, pattern_str);
+		CHECK_DO(settings.pattern>= 0,
+				LOGE("Unknown pattern '%s'\n", pattern_str);
+				end_code= STAT_EINVAL; goto end);
+	}
+
+	/* Integer fields: 'width_output', 'height_output', 'frame_rate_output',
+	 * 'sample_rate_output' and 'frame_size_output'.
+	 */
+	for(i= 0; int_fields[i].name!= NULL; i++) {
+		char *value_str= synth_src_rest_value_get(int_fields[i].name, str,
+				cjson_rest);
+		if(value_str== NULL)
+			continue;
+		*int_fields[i].ref_value= atoi(value_str);
+		free(value_str);
+		if(*int_fields[i].ref_value< int_fields[i].min ||
+				*int_fields[i].ref_value> int_fields[i].max ||
+				(int_fields[i].flag_even && (*int_fields[i].ref_value& 1))) {
+			LOGE("Invalid value for '%s' (valid range is [%d, %d]%s)\n",
+					int_fields[i].name, int_fields[i].min, int_fields[i].max,
+					int_fields[i].flag_even? ", even values": "");
+			end_code= STAT_EINVAL;
+			goto end;
+		}
+	}
+
+	/* 'flag_max_rate' */
+	flag_max_rate_str= synth_src_rest_value_get("flag_max_rate", str,
+			cjson_rest);
+	if(flag_max_rate_str!= NULL)
+		settings.flag_max_rate= (strncmp(flag_max_rate_str, "true",
+				strlen("true"))== 0)? 1: 0;
+
+	/* 'flag_stamp' */
+	flag_stamp_str= synth_src_rest_value_get("flag_stamp", str, cjson_rest);
+	if(flag_stamp_str!= NULL)
+		settings.flag_stamp= (strncmp(flag_stamp_str, "true",
+				strlen("true"))== 0)? 1: 0;
+
+	/* Apply new settings */
+	pthread_mutex_lock(&synth_src_ctx->settings_mutex);
+	memcpy((void*)&synth_src_ctx->synth_src_settings_ctx, &settings,
+			sizeof(synth_src_settings_ctx_t));
+	synth_src_ctx->settings_version++;
+	pthread_mutex_unlock(&synth_src_ctx->settings_mutex);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(media_type_str!= NULL)
+		free(media_type_str);
+	if(pattern_str!= NULL)
+		free(pattern_str);
+	if(flag_max_rate_str!= NULL)
+		free(flag_max_rate_str);
+	if(flag_stamp_str!= NULL)
+		free(flag_stamp_str);
+	return end_code;
+}
+
+/**
+ * Implements the proc_if_s::rest_get callback.
+ * See .proc_if.h for further details.
+ */
+static int synth_src_rest_get(proc_ctx_t *proc_ctx,
+		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse)
+{
+	int end_code= STAT_ERROR;
+	synth_src_ctx_t *synth_src_ctx= NULL;
+	synth_src_settings_ctx_t settings;
+	cJSON *cjson_rest= NULL, *cjson_settings= NULL;
+	cJSON *cjson_aux= NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(rest_fmt< PROC_IF_REST_FMT_ENUM_MAX, return STAT_ERROR);
+	CHECK_DO(ref_reponse!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	*ref_reponse= NULL;
+
+	/* Create cJSON tree root object */
+	cjson_rest= cJSON_CreateObject();
+	CHECK_DO(cjson_rest!= NULL, goto end);
+
+	/* JSON string to be returned:
+	 * {
+	 *     "settings":
+	 *     {
+	 *         "media_type":string,
+	 *         "pattern":string,
+	 *         "width_output":number,
+	 *         "height_output":number,
+	 *         "frame_rate_output":number,
+	 *         "sample_rate_output":number,
+	 *         "frame_size_output":number,
+	 *         "flag_max_rate":boolean,
+	 *         "flag_stamp":boolean
+	 *     },
+	 *     "frames_output":number,
+	 *     "pts_last":number
+	 * }
+	 */
+
+	/* Get processor context and a copy of the settings */
+	synth_src_ctx= (synth_src_ctx_t*)proc_ctx;
+	pthread_mutex_lock(&synth_src_ctx->settings_mutex);
+	memcpy(&settings, (const void*)&synth_src_ctx->synth_src_settings_ctx,
+			sizeof(synth_src_settings_ctx_t));
+	pthread_mutex_unlock(&synth_src_ctx->settings_mutex);
+
+	/* Create cJSON settings object */
+	cjson_settings= cJSON_CreateObject();
+	CHECK_DO(cjson_settings!= NULL, goto end);
+
+	/* 'media_type' */
+	cjson_aux= cJSON_CreateString(
+			synth_src_media_type_lut[settings.media_type]);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "media_type", cjson_aux);
+
+	/* 'pattern' */
+	cjson_aux= cJSON_CreateString(synth_src_pattern_lut[settings.pattern]);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "pattern", cjson_aux);
+
+	/* 'width_output' */
+	cjson_aux= cJSON_CreateNumber((double)settings.width_output);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "width_output", cjson_aux);
+
+	/* 'height_output' */
+	cjson_aux= cJSON_CreateNumber((double)settings.height_output);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "height_output", cjson_aux);
+
+	/* 'frame_rate_output' */
+	cjson_aux= cJSON_CreateNumber((double)settings.frame_rate_output);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "frame_rate_output", cjson_aux);
+
+	/* 'sample_rate_output' */
+	cjson_aux= cJSON_CreateNumber((double)settings.sample_rate_output);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "sample_rate_output", cjson_aux);
+
+	/* 'frame_size_output' */
+	cjson_aux= cJSON_CreateNumber((double)settings.frame_size_output);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "frame_size_output", cjson_aux);
+
+	/* 'flag_max_rate' */
+	cjson_aux= cJSON_CreateBool(settings.flag_max_rate);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "flag_max_rate", cjson_aux);
+
+	/* 'flag_stamp' */
+	cjson_aux= cJSON_CreateBool(settings.flag_stamp);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "flag_stamp", cjson_aux);
+
+	/* Attach settings object to REST response */
+	cJSON_AddItemToObject(cjson_rest, "settings", cjson_settings);
+	cjson_settings= NULL; // Attached; avoid double referencing
+
+	/* **** Attach data to REST response **** */
+
+	/* 'frames_output' */
+	cjson_aux= cJSON_CreateNumber((double)synth_src_ctx->frame_oput_cnt);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "frames_output", cjson_aux);
+
+	/* 'pts_last' */
+	cjson_aux= cJSON_CreateNumber((double)synth_src_ctx->pts_oput);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "pts_last", cjson_aux);
+
+	/* Format response to be returned */
+	switch(rest_fmt) {
+	case PROC_IF_REST_FMT_CHAR:
+		/* Print cJSON structure data to char string */
+		*ref_reponse= (void*)CJSON_PRINT(cjson_rest);
+		CHECK_DO(*ref_reponse!= NULL && strlen((char*)*ref_reponse)> 0,
+				goto end);
+		break;
+	case PROC_IF_REST_FMT_CJSON:
+		*ref_reponse= (void*)cjson_rest;
+		cjson_rest= NULL; // Avoid double referencing
+		break;
+	default:
+		LOGE("Unknown format requested for processor REST\n");
+		goto end;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(cjson_settings!= NULL)
+		cJSON_Delete(cjson_settings);
+	return end_code;
+}
+
+/**
+ * Initialize specific synthetic source processor settings to defaults.
+ * @param synth_src_settings_ctx
+ * @param log_ctx
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int synth_src_settings_ctx_init(
+		volatile synth_src_settings_ctx_t *synth_src_settings_ctx,
+		log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(synth_src_settings_ctx!= NULL, return STAT_ERROR);
+
+	/* Initialize specific processor settings */
+	synth_src_settings_ctx->media_type= SYNTH_SRC_MEDIA_VIDEO;
+	synth_src_settings_ctx->pattern= SYNTH_SRC_PATTERN_MOVING;
+	synth_src_settings_ctx->width_output= 352;
+	synth_src_settings_ctx->height_output= 288;
+	synth_src_settings_ctx->frame_rate_output= 30;
+	synth_src_settings_ctx->sample_rate_output= 44100;
+	synth_src_settings_ctx->frame_size_output= 1152;
+	synth_src_settings_ctx->flag_max_rate= 0;
+	synth_src_settings_ctx->flag_stamp= 1;
+
+	return STAT_SUCCESS;
+}
+
+/**
+ * Release specific synthetic source processor settings (allocated in heap
+ * memory).
+ * @param synth_src_settings_ctx
+ * @param log_ctx
+ */
+static void synth_src_settings_ctx_deinit(
+		volatile synth_src_settings_ctx_t *synth_src_settings_ctx,
+		log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(synth_src_settings_ctx!= NULL, return);
+
+	/* Release specific processor settings */
+	// Reserved for future use
+}
+
+/**
+ * Get the value of a setting from a REST string, as a character string.
+ * @param name Setting name.
+ * @param str REST string (used if it is a query-string).
+ * @param cjson_rest Parsed REST string (used if it is JSON formatted; NULL
+ * otherwise).
+ * @return Setting value (to be released by the caller); NULL if the setting
+ * is not specified.
+ */
+static char* synth_src_rest_value_get(const char *name, const char *str,
+		cJSON *cjson_rest)
+{
+	char buf[64];
+	cJSON *cjson_aux= NULL; // Do not release
+
+	if(cjson_rest== NULL)
+		return uri_parser_query_str_get_value(name, str);
+
+	if((cjson_aux= cJSON_GetObjectItem(cjson_rest, name))== NULL)
+		return NULL;
+	switch(cjson_aux->type& 0xFF) {
+	case cJSON_True:
+		return strdup("true");
+	case cJSON_False:
+		return strdup("false");
+	case cJSON_Number:
+		snprintf(buf, sizeof(buf), "%d", cjson_aux->valueint);
+		return strdup(buf);
+	case cJSON_String:
+		return cjson_aux->valuestring!= NULL?
+				strdup(cjson_aux->valuestring): NULL;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * Get the index of a value in a look-up table of names.
+ * @return Index of the value in the table; -1 if not found.
+ */
+static int synth_src_lut_index(const char **lut, int lut_size,
+		const char *value)
+{
+	int i;
+
+	for(i= 0; i< lut_size; i++) {
+		if(strcmp(lut[i], value)== 0)
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * (Re-)build the frame generator according to the current settings:
+ * take a copy of the settings, (re-)allocate the output frame buffer and
+ * pattern table, and re-anchor the output schedule (sequence numbers and
+ * time-stamps are kept continuous).
+ * Static patterns are rendered here, once.
+ * @param synth_src_ctx
+ * @param log_ctx
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int synth_src_gen_build(synth_src_ctx_t *synth_src_ctx,
+		log_ctx_t *log_ctx)
+{
+	int i, width, height, sample_rate;
+	size_t data_size;
+	synth_src_settings_ctx_t *settings_cur= &synth_src_ctx->settings_cur;
+	proc_frame_ctx_t *proc_frame_ctx= &synth_src_ctx->proc_frame_ctx;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Take a copy of the settings */
+	pthread_mutex_lock(&synth_src_ctx->settings_mutex);
+	memcpy(settings_cur, (const void*)&synth_src_ctx->synth_src_settings_ctx,
+			sizeof(synth_src_settings_ctx_t));
+	synth_src_ctx->settings_version_cur= synth_src_ctx->settings_version;
+	pthread_mutex_unlock(&synth_src_ctx->settings_mutex);
+
+	synth_src_gen_release(synth_src_ctx);
+	memset(proc_frame_ctx, 0, sizeof(proc_frame_ctx_t));
+
+	if(settings_cur->media_type== SYNTH_SRC_MEDIA_AUDIO) {
+		sample_rate= settings_cur->sample_rate_output;
+		data_size= (size_t)settings_cur->frame_size_output*
+				SYNTH_SRC_AUDIO_CHANNELS* sizeof(int16_t);
+
+		/* Pattern table: one second of interleaved tone samples (an integer
+		 * number of tone periods, thus, it can be read circularly).
+		 */
+		synth_src_ctx->pattern_tab= (uint8_t*)malloc((size_t)sample_rate*
+				SYNTH_SRC_AUDIO_CHANNELS* sizeof(int16_t));
+		CHECK_DO(synth_src_ctx->pattern_tab!= NULL, return STAT_ENOMEM);
+		for(i= 0; i< sample_rate; i++) {
+			int16_t sample= (int16_t)(8192.0* sin(2.0* M_PI*
+					SYNTH_SRC_AUDIO_TONE_HZ* i/ sample_rate));
+			((int16_t*)synth_src_ctx->pattern_tab)[2* i]= sample;
+			((int16_t*)synth_src_ctx->pattern_tab)[2* i+ 1]= sample;
+		}
+
+		proc_frame_ctx->width[0]= proc_frame_ctx->linesize[0]= data_size;
+		proc_frame_ctx->height[0]= 1;
+		proc_frame_ctx->proc_sample_fmt= PROC_IF_FMT_S16;
+		proc_frame_ctx->proc_sampling_rate= sample_rate;
+	} else {
+		width= settings_cur->width_output;
+		height= settings_cur->height_output;
+		data_size= ((size_t)width* height* 3)/ 2;
+
+		/* Pattern table: ramp of 8-bit values; any line of a gradient is a
+		 * window of this table.
+		 */
+		synth_src_ctx->pattern_tab= (uint8_t*)malloc(width+ 256);
+		CHECK_DO(synth_src_ctx->pattern_tab!= NULL, return STAT_ENOMEM);
+		for(i= 0; i< width+ 256; i++)
+			synth_src_ctx->pattern_tab[i]= (uint8_t)i;
+
+		proc_frame_ctx->width[0]= proc_frame_ctx->linesize[0]= width;
+		proc_frame_ctx->width[1]= proc_frame_ctx->linesize[1]= width>> 1;
+		proc_frame_ctx->width[2]= proc_frame_ctx->linesize[2]= width>> 1;
+		proc_frame_ctx->height[0]= height;
+		proc_frame_ctx->height[1]= height>> 1;
+		proc_frame_ctx->height[2]= height>> 1;
+		proc_frame_ctx->proc_sample_fmt= PROC_IF_FMT_YUV420P;
+		proc_frame_ctx->proc_sampling_rate= settings_cur->frame_rate_output;
+	}
+
+	/* Allocate frame data buffer (rounded up to 64-bit words, so that the
+	 * 'noise' pattern can be rendered word by word).
+	 */
+	synth_src_ctx->buf_size= (data_size+ 7)& ~((size_t)7);
+	proc_frame_ctx->data= (uint8_t*)calloc(1, synth_src_ctx->buf_size);
+	CHECK_DO(proc_frame_ctx->data!= NULL, return STAT_ENOMEM);
+	proc_frame_ctx->p_data[0]= proc_frame_ctx->data;
+	if(settings_cur->media_type== SYNTH_SRC_MEDIA_VIDEO) {
+		width= settings_cur->width_output;
+		height= settings_cur->height_output;
+		proc_frame_ctx->p_data[1]= proc_frame_ctx->p_data[0]+ width* height;
+		proc_frame_ctx->p_data[2]= proc_frame_ctx->p_data[1]+
+				(width* height)/ 4;
+	}
+	proc_frame_ctx->es_id= 0;
+
+	/* Render static patterns (silence is already rendered) */
+	if(settings_cur->pattern== SYNTH_SRC_PATTERN_STATIC &&
+			settings_cur->media_type== SYNTH_SRC_MEDIA_VIDEO)
+		synth_src_render_bars(synth_src_ctx);
+
+	/* Re-anchor output schedule */
+	synth_src_ctx->seq_anchor= synth_src_ctx->seq;
+	synth_src_ctx->usecs_anchor= bench_now_usecs();
+	synth_src_ctx->pts_anchor= synth_src_ctx->pts_oput;
+
+	return STAT_SUCCESS;
+}
+
+/**
+ * Release the frame generator buffers.
+ * @param synth_src_ctx
+ */
+static void synth_src_gen_release(synth_src_ctx_t *synth_src_ctx)
+{
+	if(synth_src_ctx->proc_frame_ctx.data!= NULL) {
+		free(synth_src_ctx->proc_frame_ctx.data);
+		synth_src_ctx->proc_frame_ctx.data= NULL;
+	}
+	if(synth_src_ctx->pattern_tab!= NULL) {
+		free(synth_src_ctx->pattern_tab);
+		synth_src_ctx->pattern_tab= NULL;
+	}
+}
+
+/**
+ * Render the next frame (sequence number 'synth_src_ctx_s::seq').
+ * Rendering is done on whole lines (or 64-bit words) copied or set from the
+ * pattern table, so it is not more costly than a memory copy of the frame.
+ * @param synth_src_ctx
+ */
+static void synth_src_render(synth_src_ctx_t *synth_src_ctx)
+{
+	int y, width, height;
+	size_t frame_bytes, tab_bytes, offset, len;
+	const synth_src_settings_ctx_t *settings_cur=
+			&synth_src_ctx->settings_cur;
+	proc_frame_ctx_t *proc_frame_ctx= &synth_src_ctx->proc_frame_ctx;
+	const uint8_t *pattern_tab= synth_src_ctx->pattern_tab;
+	const uint64_t seq= synth_src_ctx->seq;
+	uint8_t *p_data_y, *p_data_u, *p_data_v;
+
+	switch(settings_cur->pattern) {
+	case SYNTH_SRC_PATTERN_NOISE:
+		synth_src_render_noise(synth_src_ctx);
+		return;
+	case SYNTH_SRC_PATTERN_STATIC:
+		return; // Already rendered
+	default:
+		break;
+	}
+
+	if(settings_cur->media_type== SYNTH_SRC_MEDIA_AUDIO) {
+		/* 440Hz tone: circular copy of the tone table */
+		frame_bytes= proc_frame_ctx->width[0];
+		tab_bytes= (size_t)settings_cur->sample_rate_output*
+				SYNTH_SRC_AUDIO_CHANNELS* sizeof(int16_t);
+		offset= (size_t)((seq* (uint64_t)frame_bytes)% tab_bytes);
+		for(len= 0; len< frame_bytes; ) {
+			size_t chunk= frame_bytes- len;
+			if(chunk> tab_bytes- offset)
+				chunk= tab_bytes- offset;
+			memcpy(proc_frame_ctx->data+ len, pattern_tab+ offset, chunk);
+			len+= chunk;
+			offset= 0;
+		}
+		return;
+	}
+
+	/* Moving gradients (same picture as the loopback example producer):
+	 * Y[y][x]= x+ y+ 3*seq, U[y][x]= 128+ y+ 2*seq, V[y][x]= 64+ x+ 5*seq.
+	 */
+	width= settings_cur->width_output;
+	height= settings_cur->height_output;
+	p_data_y= (uint8_t*)proc_frame_ctx->p_data[0];
+	p_data_u= (uint8_t*)proc_frame_ctx->p_data[1];
+	p_data_v= (uint8_t*)proc_frame_ctx->p_data[2];
+	for(y= 0; y< height; y++)
+		memcpy(p_data_y+ y* proc_frame_ctx->linesize[0],
+				pattern_tab+ ((y+ seq* 3)& 0xFF), width);
+	for(y= 0; y< (height>> 1); y++) {
+		memset(p_data_u+ y* proc_frame_ctx->linesize[1],
+				(uint8_t)(128+ y+ seq* 2), width>> 1);
+		memcpy(p_data_v+ y* proc_frame_ctx->linesize[2],
+				pattern_tab+ ((64+ seq* 5)& 0xFF), width>> 1);
+	}
+}
+
+/**
+ * Render pseudo-random data (xorshift64 generator, one 64-bit word per
+ * step) over the whole frame buffer.
+ * @param synth_src_ctx
+ */
+static void synth_src_render_noise(synth_src_ctx_t *synth_src_ctx)
+{
+	size_t i, words_num= synth_src_ctx->buf_size/ sizeof(uint64_t);
+	uint64_t x= synth_src_ctx->rand_state;
+	uint64_t *p= (uint64_t*)synth_src_ctx->proc_frame_ctx.data;
+
+	for(i= 0; i< words_num; i++) {
+		x^= x<< 13;
+		x^= x>> 7;
+		x^= x<< 17;
+		p[i]= x;
+	}
+	synth_src_ctx->rand_state= x;
+}
+
+/**
+ * Render 75% color bars (white, yellow, cyan, green, magenta, red, blue,
+ * black).
+ * @param synth_src_ctx
+ */
+static void synth_src_render_bars(synth_src_ctx_t *synth_src_ctx)
+{
+	int x, y, bar;
+	static const uint8_t bars_yuv[8][3]= {
+		{180, 128, 128}, {162, 44, 142}, {131, 156, 44}, {112, 72, 58},
+		{84, 184, 198}, {65, 100, 212}, {35, 212, 114}, {16, 128, 128}
+	};
+	proc_frame_ctx_t *proc_frame_ctx= &synth_src_ctx->proc_frame_ctx;
+	const int width= synth_src_ctx->settings_cur.width_output;
+	const int height= synth_src_ctx->settings_cur.height_output;
+	uint8_t *p_data[3]= {
+		(uint8_t*)proc_frame_ctx->p_data[0],
+		(uint8_t*)proc_frame_ctx->p_data[1],
+		(uint8_t*)proc_frame_ctx->p_data[2]
+	};
+
+	/* Render first line of each plane, then replicate it */
+	for(x= 0; x< width; x++) {
+		bar= (x* 8)/ width;
+		p_data[0][x]= bars_yuv[bar][0];
+		if((x& 1)== 0) {
+			p_data[1][x>> 1]= bars_yuv[bar][1];
+			p_data[2][x>> 1]= bars_yuv[bar][2];
+		}
+	}
+	for(y= 1; y< height; y++)
+		memcpy(p_data[0]+ y* proc_frame_ctx->linesize[0], p_data[0], width);
+	for(y= 1; y< (height>> 1); y++) {
+		memcpy(p_data[1]+ y* proc_frame_ctx->linesize[1], p_data[1],
+				width>> 1);
+		memcpy(p_data[2]+ y* proc_frame_ctx->linesize[2], p_data[2],
+				width>> 1);
+	}
+}
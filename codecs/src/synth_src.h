@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file synth_src.h
+ * @brief Synthetic source processor.
+ * Generates raw video (YUV 4:2:0 planar) or audio (interleaved signed 16
+ * bits, stereo) frames, mainly intended for load generation in tests and
+ * benchmarks. Frames are output either at the configured rate or as fast as
+ * the consumer reads them (see the settings structure at synth_src.c).
+ * The processor does not accept input frames.
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_CODECS_SRC_SYNTH_SRC_H_
+#define MEDIAPROCESSORS_CODECS_SRC_SYNTH_SRC_H_
+
+#include <stdint.h>
+
+/* **** Definitions **** */
+
+/* Forward definitions */
+typedef struct proc_if_s proc_if_t;
+typedef struct proc_frame_ctx_s proc_frame_ctx_t;
+
+/**
+ * Stamp magic number ("SYNS").
+ */
+#define SYNTH_SRC_STAMP_MAGIC 0x53594E53
+
+/**
+ * Stamp written (if enabled) at the beginning of the first data plane of
+ * each frame output by the synthetic source processor.
+ * Note that the stamp only survives byte-exact paths (e.g. bypass or
+ * multiplexing processors); lossy encoding destroys it (the presentation
+ * time-stamp should be used instead in that case).
+ */
+typedef struct synth_src_stamp_s {
+	uint32_t magic;
+	uint32_t reserved;
+	/**
+	 * Frame sequence number (first frame is 0).
+	 */
+	uint64_t seq;
+	/**
+	 * Monotonic clock time at which the frame was generated, in
+	 * microseconds.
+	 */
+	int64_t gen_usecs;
+} synth_src_stamp_t;
+
+/* **** prototypes **** */
+
+/**
+ * Processor interface implementing the synthetic source processor.
+ */
+extern const proc_if_t proc_if_synth_src;
+
+/**
+ * Read the synthetic source stamp of a frame.
+ * @param proc_frame_ctx Frame to read the stamp from.
+ * @param synth_src_stamp Pointer to the structure to be filled with the
+ * stamp.
+ * @return Status code: STAT_SUCCESS if the frame carries a stamp;
+ * STAT_ENOTFOUND otherwise.
+ */
+int synth_src_stamp_read(const proc_frame_ctx_t *proc_frame_ctx,
+		synth_src_stamp_t *synth_src_stamp);
+
+#endif /* MEDIAPROCESSORS_CODECS_SRC_SYNTH_SRC_H_ */
@@ -0,0 +1,812 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_codecs.cpp
+ * @brief Codecs throughput benchmark.
+ * Drives the encoder and decoder processors through the PROCS API
+ * ('procs_send_frame()'/'procs_recv_frame()') with synthetic content, as
+ * fast as the processors accept it, sweeping the codec, the resolution, the
+ * encoder preset and the number of concurrent processor instances (each
+ * processor instance runs its own processing thread).
+ * Each configuration is measured in two stages: encoding of the synthetic
+ * raw frames and decoding of the resulting encoded frames. One result line
+ * (JSON or CSV) is printed per stage with the frames per second (all the
+ * instances), the process CPU time per frame, the frame latency
+ * percentiles (from sending a frame to receiving the corresponding output
+ * frame, queuing included) and the peak resident memory.
+ * Usage:
+ * mediaprocscodecs_bench [-c codecs] [-r resolutions] [-p presets]
+ * [-t instances] [-n frames] [-f json|csv]
+ * where lists are comma separated, e.g.:
+ * mediaprocscodecs_bench -c x264,m2v -r 640x360,1280x720 -p ultrafast,medium
+ * -t 1,2,4 -n 300 -f csv
+ * @author Rafael Antoniello
+ */
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <math.h>
+
+#include <libcjson/cJSON.h>
+#include <libavcodec/avcodec.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/bench_stats.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/procs.h>
+#include "../src/ffmpeg_x264.h"
+#include "../src/ffmpeg_m2v.h"
+#include "../src/ffmpeg_mp3.h"
+#include "../src/ffmpeg_lhe.h"
+}
+
+/* **** Definitions **** */
+
+#define BENCH_CODECS_DEFAULT "x264,m2v,mlhe,mp3"
+#define BENCH_RESOLUTIONS_DEFAULT "352x288,1280x720,1920x1080"
+#define BENCH_PRESETS_DEFAULT "ultrafast,medium"
+#define BENCH_INSTANCES_DEFAULT "1,2,4"
+#define BENCH_FRAMES_DEFAULT 300
+#define BENCH_LIST_MAX 16
+
+#define BENCH_FPS 30
+#define BENCH_AUDIO_SAMPLE_RATE 44100
+
+/**
+ * Number of distinct synthetic raw frames (generated beforehand, so that
+ * the producer does not limit the throughput; sent cyclically).
+ */
+#define BENCH_SOURCE_FRAMES 8
+
+/**
+ * A stage is considered finished when no output frame is received during
+ * this time (encoders and decoders may keep some frames buffered).
+ */
+#define BENCH_IDLE_USECS 1000000
+
+#define BENCH_LATENCY_SAMPLES_MAX 16384
+
+#define BENCH_MEDIA_VIDEO 0
+#define BENCH_MEDIA_AUDIO 1
+
+/**
+ * Benchmarked codec.
+ */
+typedef struct bench_codec_s {
+	const char *name;
+	const proc_if_t *proc_if_enc;
+	const proc_if_t *proc_if_dec;
+	int media_type;
+	/**
+	 * Set if the encoder supports the 'conf_preset' setting.
+	 */
+	int flag_presets;
+} bench_codec_t;
+
+static const bench_codec_t bench_codecs[]= {
+	{"x264", &proc_if_ffmpeg_x264_enc, &proc_if_ffmpeg_x264_dec,
+			BENCH_MEDIA_VIDEO, 1},
+	{"m2v", &proc_if_ffmpeg_m2v_enc, &proc_if_ffmpeg_m2v_dec,
+			BENCH_MEDIA_VIDEO, 0},
+	{"mlhe", &proc_if_ffmpeg_mlhe_enc, &proc_if_ffmpeg_mlhe_dec,
+			BENCH_MEDIA_VIDEO, 0},
+	{"mp3", &proc_if_ffmpeg_mp3_enc, &proc_if_ffmpeg_mp3_dec,
+			BENCH_MEDIA_AUDIO, 0},
+	{NULL, NULL, NULL, 0, 0}
+};
+
+/**
+ * Synthetic raw frames source (shared, read-only, by all the instances).
+ */
+typedef struct bench_source_s {
+	proc_frame_ctx_t *frames[BENCH_SOURCE_FRAMES];
+	/**
+	 * Frame period in microseconds.
+	 */
+	int64_t pts_period;
+} bench_source_t;
+
+/**
+ * Benchmark instance context: one processor (encoder or decoder) with its
+ * producer and consumer threads.
+ */
+typedef struct bench_instance_ctx_s {
+	procs_ctx_t *procs_ctx;
+	int proc_id;
+	/**
+	 * Input frames, sent cyclically up to 'frames_num' frames. If
+	 * 'flag_set_pts' is set, the presentation time-stamp of each sent frame
+	 * is set to (seq+ 1)* 'pts_period' (raw frames); otherwise the frames
+	 * are sent with their original time-stamps (encoded frames).
+	 */
+	proc_frame_ctx_t **iput_frames;
+	int iput_frames_num;
+	int frames_num;
+	int flag_set_pts;
+	int64_t pts_period;
+	/**
+	 * Output frames, kept if 'flag_keep_oput' is set (encoded frames, used
+	 * as the input of the decoding stage).
+	 */
+	int flag_keep_oput;
+	proc_frame_ctx_t **oput_frames;
+	volatile int oput_frames_num;
+	uint64_t oput_bytes;
+	/**
+	 * Send time of each frame, indexed by sequence number.
+	 */
+	int64_t *send_usecs;
+	bench_stats_ctx_t *latency_stats;
+	volatile int64_t last_recv_usecs;
+	pthread_t producer_thread;
+	pthread_t consumer_thread;
+	volatile int flag_exit;
+} bench_instance_ctx_t;
+
+/**
+ * Stage (encoding or decoding) results.
+ */
+typedef struct bench_result_s {
+	uint64_t frames;
+	double fps;
+	double cpu_usecs_per_frame;
+	double bytes_per_frame;
+	bench_stats_summary_t latency;
+} bench_result_t;
+
+/* **** Implementations **** */
+
+/**
+ * Get the number of samples per channel expected by an audio encoder.
+ */
+static int bench_audio_frame_size_get(procs_ctx_t *procs_ctx, int proc_id)
+{
+	int frame_size= -1;
+	char *rest_str= NULL;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+
+	if(procs_opt(procs_ctx, "PROCS_ID_GET", proc_id, &rest_str)==
+			STAT_SUCCESS && rest_str!= NULL &&
+			(cjson_rest= cJSON_Parse(rest_str))!= NULL &&
+			(cjson_aux= cJSON_GetObjectItem(cjson_rest,
+					"expected_frame_size_iput"))!= NULL)
+		frame_size= (int)cjson_aux->valuedouble;
+
+	if(rest_str!= NULL)
+		free(rest_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return frame_size;
+}
+
+static void bench_source_release(bench_source_t *bench_source)
+{
+	int i;
+
+	for(i= 0; i< BENCH_SOURCE_FRAMES; i++)
+		proc_frame_ctx_release(&bench_source->frames[i]);
+}
+
+/**
+ * Generate YUV 4:2:0 planar synthetic frames (moving gradients).
+ */
+static int bench_source_video_init(bench_source_t *bench_source, int width,
+		int height)
+{
+	int i, x, y;
+	proc_frame_ctx_t proc_frame_ctx;
+	uint8_t *buf= NULL;
+
+	memset(bench_source, 0, sizeof(bench_source_t));
+	bench_source->pts_period= 1000000/ BENCH_FPS;
+
+	buf= (uint8_t*)malloc((width* height* 3)/ 2);
+	if(buf== NULL)
+		return STAT_ENOMEM;
+	memset(&proc_frame_ctx, 0, sizeof(proc_frame_ctx));
+	proc_frame_ctx.data= buf;
+	proc_frame_ctx.p_data[0]= buf;
+	proc_frame_ctx.p_data[1]= proc_frame_ctx.p_data[0]+ (width* height);
+	proc_frame_ctx.p_data[2]= proc_frame_ctx.p_data[1]+ ((width* height)/4);
+	proc_frame_ctx.width[0]= proc_frame_ctx.linesize[0]= width;
+	proc_frame_ctx.width[1]= proc_frame_ctx.linesize[1]= width>> 1;
+	proc_frame_ctx.width[2]= proc_frame_ctx.linesize[2]= width>> 1;
+	proc_frame_ctx.height[0]= height;
+	proc_frame_ctx.height[1]= height>> 1;
+	proc_frame_ctx.height[2]= height>> 1;
+	proc_frame_ctx.proc_sample_fmt= PROC_IF_FMT_YUV420P;
+
+	for(i= 0; i< BENCH_SOURCE_FRAMES; i++) {
+		uint8_t *p_data_y= (uint8_t*)proc_frame_ctx.p_data[0];
+		uint8_t *p_data_cr= (uint8_t*)proc_frame_ctx.p_data[1];
+		uint8_t *p_data_cb= (uint8_t*)proc_frame_ctx.p_data[2];
+
+		for(y= 0; y< height; y++)
+			for(x= 0; x< width; x++)
+				p_data_y[y* width+ x]= x+ y+ i* 3;
+		for(y= 0; y< height>> 1; y++) {
+			for(x= 0; x< width>> 1; x++) {
+				p_data_cr[y* (width>> 1)+ x]= 128+ y+ i* 2;
+				p_data_cb[y* (width>> 1)+ x]= 64+ x+ i* 5;
+			}
+		}
+		if((bench_source->frames[i]= proc_frame_ctx_dup(&proc_frame_ctx))==
+				NULL)
+			break;
+	}
+	free(buf);
+	if(i< BENCH_SOURCE_FRAMES) {
+		bench_source_release(bench_source);
+		return STAT_ENOMEM;
+	}
+	return STAT_SUCCESS;
+}
+
+/**
+ * Generate S16 planar stereo synthetic frames (440Hz tone).
+ */
+static int bench_source_audio_init(bench_source_t *bench_source,
+		int frame_size)
+{
+	int i, j;
+	double t= 0, tincr= 2* M_PI* 440.0/ BENCH_AUDIO_SAMPLE_RATE;
+	proc_frame_ctx_t proc_frame_ctx;
+	int16_t *samples= NULL;
+
+	memset(bench_source, 0, sizeof(bench_source_t));
+	bench_source->pts_period= ((int64_t)frame_size* 1000000)/
+			BENCH_AUDIO_SAMPLE_RATE;
+
+	samples= (int16_t*)malloc(frame_size* 2* sizeof(int16_t));
+	if(samples== NULL)
+		return STAT_ENOMEM;
+	memset(&proc_frame_ctx, 0, sizeof(proc_frame_ctx));
+	proc_frame_ctx.data= (uint8_t*)samples;
+	proc_frame_ctx.p_data[0]= (uint8_t*)samples;
+	proc_frame_ctx.p_data[1]= (uint8_t*)(samples+ frame_size);
+	proc_frame_ctx.width[0]= proc_frame_ctx.linesize[0]=
+			frame_size* sizeof(int16_t);
+	proc_frame_ctx.width[1]= proc_frame_ctx.linesize[1]=
+			frame_size* sizeof(int16_t);
+	proc_frame_ctx.height[0]= proc_frame_ctx.height[1]= 1;
+	proc_frame_ctx.proc_sample_fmt= PROC_IF_FMT_S16P;
+	proc_frame_ctx.proc_sampling_rate= BENCH_AUDIO_SAMPLE_RATE;
+
+	for(i= 0; i< BENCH_SOURCE_FRAMES; i++) {
+		for(j= 0; j< frame_size; j++, t+= tincr) {
+			samples[j]= (int16_t)(sin(t)* 10000); // right channel
+			samples[j+ frame_size]= samples[j]; // left channel
+		}
+		if((bench_source->frames[i]= proc_frame_ctx_dup(&proc_frame_ctx))==
+				NULL)
+			break;
+	}
+	free(samples);
+	if(i< BENCH_SOURCE_FRAMES) {
+		bench_source_release(bench_source);
+		return STAT_ENOMEM;
+	}
+	return STAT_SUCCESS;
+}
+
+/**
+ * Sequence number of a frame; rounded as the period may be inexact.
+ */
+static inline int bench_seq_get(int64_t pts, int64_t pts_period)
+{
+	return (int)((pts+ pts_period/ 2)/ pts_period)- 1;
+}
+
+static void* bench_producer_thr(void *t)
+{
+	int seq;
+	proc_frame_ctx_t proc_frame_ctx;
+	bench_instance_ctx_t *bench_instance_ctx= (bench_instance_ctx_t*)t;
+
+	schedule_set_thread_name("bench-producer");
+
+	for(seq= 0; seq< bench_instance_ctx->frames_num &&
+			bench_instance_ctx->flag_exit== 0; seq++) {
+		int seq_pts;
+
+		/* Shallow copy: data is duplicated when sent to the processor */
+		memcpy(&proc_frame_ctx, bench_instance_ctx->iput_frames[seq%
+				bench_instance_ctx->iput_frames_num], sizeof(proc_frame_ctx));
+		if(bench_instance_ctx->flag_set_pts)
+			proc_frame_ctx.pts= (int64_t)(seq+ 1)*
+					bench_instance_ctx->pts_period;
+		seq_pts= bench_seq_get(proc_frame_ctx.pts,
+				bench_instance_ctx->pts_period);
+		if(seq_pts>= 0 && seq_pts< bench_instance_ctx->frames_num)
+			bench_instance_ctx->send_usecs[seq_pts]= bench_now_usecs();
+
+		procs_send_frame(bench_instance_ctx->procs_ctx,
+				bench_instance_ctx->proc_id, &proc_frame_ctx);
+	}
+	return NULL;
+}
+
+static void* bench_consumer_thr(void *t)
+{
+	int ret_code;
+	proc_frame_ctx_t *proc_frame_ctx= NULL;
+	bench_instance_ctx_t *bench_instance_ctx= (bench_instance_ctx_t*)t;
+
+	schedule_set_thread_name("bench-consumer");
+
+	while(bench_instance_ctx->flag_exit== 0 &&
+			bench_instance_ctx->oput_frames_num<
+			bench_instance_ctx->frames_num) {
+		int seq;
+		int64_t now_usecs;
+
+		ret_code= procs_recv_frame(bench_instance_ctx->procs_ctx,
+				bench_instance_ctx->proc_id, &proc_frame_ctx);
+		if(ret_code!= STAT_SUCCESS || proc_frame_ctx== NULL) {
+			schedule(); // Avoid closed loops
+			continue;
+		}
+		now_usecs= bench_now_usecs();
+
+		seq= bench_seq_get(proc_frame_ctx->pts,
+				bench_instance_ctx->pts_period);
+		if(seq>= 0 && seq< bench_instance_ctx->frames_num &&
+				bench_instance_ctx->send_usecs[seq]> 0)
+			bench_stats_add(bench_instance_ctx->latency_stats,
+					now_usecs- bench_instance_ctx->send_usecs[seq]);
+		bench_instance_ctx->oput_bytes+= proc_frame_ctx->width[0];
+		bench_instance_ctx->last_recv_usecs= now_usecs;
+
+		if(bench_instance_ctx->flag_keep_oput)
+			bench_instance_ctx->oput_frames[
+					bench_instance_ctx->oput_frames_num]= proc_frame_ctx;
+		else
+			proc_frame_ctx_release(&proc_frame_ctx);
+		proc_frame_ctx= NULL;
+		bench_instance_ctx->oput_frames_num++;
+	}
+	proc_frame_ctx_release(&proc_frame_ctx);
+	return NULL;
+}
+
+static int bench_instance_init(bench_instance_ctx_t *bench_instance_ctx,
+		procs_ctx_t *procs_ctx, int frames_num, int flag_keep_oput)
+{
+	memset(bench_instance_ctx, 0, sizeof(bench_instance_ctx_t));
+	bench_instance_ctx->procs_ctx= procs_ctx;
+	bench_instance_ctx->proc_id= -1;
+	bench_instance_ctx->frames_num= frames_num;
+	bench_instance_ctx->flag_keep_oput= flag_keep_oput;
+	bench_instance_ctx->send_usecs= (int64_t*)calloc(frames_num,
+			sizeof(int64_t));
+	bench_instance_ctx->oput_frames= (proc_frame_ctx_t**)calloc(frames_num,
+			sizeof(proc_frame_ctx_t*));
+	bench_instance_ctx->latency_stats= bench_stats_open(
+			BENCH_LATENCY_SAMPLES_MAX);
+	if(bench_instance_ctx->send_usecs== NULL ||
+			bench_instance_ctx->oput_frames== NULL ||
+			bench_instance_ctx->latency_stats== NULL)
+		return STAT_ENOMEM;
+	return STAT_SUCCESS;
+}
+
+static void bench_instance_deinit(bench_instance_ctx_t *bench_instance_ctx)
+{
+	int i;
+
+	if(bench_instance_ctx->oput_frames!= NULL) {
+		for(i= 0; i< bench_instance_ctx->oput_frames_num; i++)
+			proc_frame_ctx_release(&bench_instance_ctx->oput_frames[i]);
+		free(bench_instance_ctx->oput_frames);
+		bench_instance_ctx->oput_frames= NULL;
+	}
+	if(bench_instance_ctx->send_usecs!= NULL) {
+		free(bench_instance_ctx->send_usecs);
+		bench_instance_ctx->send_usecs= NULL;
+	}
+	bench_stats_close(&bench_instance_ctx->latency_stats);
+}
+
+/**
+ * Run one stage on the given instances (processors already opened and
+ * inputs set): send all the input frames and receive the output frames
+ * until all of them are received or the processors stay idle.
+ * Processors are deleted on return (this also unblocks the consumers).
+ */
+static void bench_stage_run(bench_instance_ctx_t *bench_instance_ctx_array,
+		int instances_num, bench_result_t *bench_result)
+{
+	int i, flag_done;
+	int64_t t0_usecs, t1_usecs= 0, cpu0_usecs, cpu1_usecs, progress_usecs;
+	uint64_t oput_bytes= 0, oput_frames_last= (uint64_t)-1;
+	bench_stats_ctx_t *latency_stats= NULL;
+
+	memset(bench_result, 0, sizeof(bench_result_t));
+
+	t0_usecs= bench_now_usecs();
+	cpu0_usecs= bench_cpu_usecs();
+	for(i= 0; i< instances_num; i++) {
+		bench_instance_ctx_t *bench_instance_ctx=
+				&bench_instance_ctx_array[i];
+		pthread_create(&bench_instance_ctx->consumer_thread, NULL,
+				bench_consumer_thr, bench_instance_ctx);
+		pthread_create(&bench_instance_ctx->producer_thread, NULL,
+				bench_producer_thr, bench_instance_ctx);
+	}
+
+	/* Wait until all the output frames are received or no progress */
+	progress_usecs= bench_now_usecs();
+	do {
+		uint64_t oput_frames= 0;
+
+		usleep(10000);
+		flag_done= 1;
+		for(i= 0; i< instances_num; i++) {
+			bench_instance_ctx_t *bench_instance_ctx=
+					&bench_instance_ctx_array[i];
+			oput_frames+= bench_instance_ctx->oput_frames_num;
+			if(bench_instance_ctx->oput_frames_num<
+					bench_instance_ctx->frames_num)
+				flag_done= 0;
+		}
+		if(oput_frames!= oput_frames_last) {
+			oput_frames_last= oput_frames;
+			progress_usecs= bench_now_usecs();
+		}
+	} while(!flag_done && bench_now_usecs()- progress_usecs<
+			BENCH_IDLE_USECS);
+	cpu1_usecs= bench_cpu_usecs();
+
+	/* Stop */
+	for(i= 0; i< instances_num; i++) {
+		bench_instance_ctx_t *bench_instance_ctx=
+				&bench_instance_ctx_array[i];
+		bench_instance_ctx->flag_exit= 1;
+		procs_opt(bench_instance_ctx->procs_ctx, "PROCS_ID_DELETE",
+				bench_instance_ctx->proc_id);
+		pthread_join(bench_instance_ctx->producer_thread, NULL);
+		pthread_join(bench_instance_ctx->consumer_thread, NULL);
+		bench_instance_ctx->proc_id= -1;
+	}
+
+	/* Aggregate results */
+	latency_stats= bench_stats_open(BENCH_LATENCY_SAMPLES_MAX* 4);
+	for(i= 0; i< instances_num; i++) {
+		bench_instance_ctx_t *bench_instance_ctx=
+				&bench_instance_ctx_array[i];
+		bench_result->frames+= bench_instance_ctx->oput_frames_num;
+		oput_bytes+= bench_instance_ctx->oput_bytes;
+		if(bench_instance_ctx->last_recv_usecs> t1_usecs)
+			t1_usecs= bench_instance_ctx->last_recv_usecs;
+		if(latency_stats!= NULL)
+			bench_stats_merge(latency_stats,
+					bench_instance_ctx->latency_stats);
+	}
+	if(bench_result->frames> 0 && t1_usecs> t0_usecs) {
+		bench_result->fps= (double)bench_result->frames* 1000000.0/
+				(double)(t1_usecs- t0_usecs);
+		bench_result->cpu_usecs_per_frame= (double)(cpu1_usecs- cpu0_usecs)/
+				(double)bench_result->frames;
+		bench_result->bytes_per_frame= (double)oput_bytes/
+				(double)bench_result->frames;
+	}
+	if(latency_stats!= NULL)
+		bench_stats_summary_get(latency_stats, &bench_result->latency);
+	bench_stats_close(&latency_stats);
+}
+
+static void bench_result_print(const char *codec, const char *stage,
+		const char *format, const char *preset, int instances_num,
+		const bench_result_t *bench_result, int flag_csv)
+{
+	if(flag_csv) {
+		printf("%s,%s,%s,%s,%d,%" PRIu64 ",%.2f,%.1f,%.1f,%" PRId64 ",%"
+				PRId64 ",%" PRId64 ",%" PRId64 ",%ld\n", codec, stage, format,
+				preset, instances_num, bench_result->frames, bench_result->fps,
+				bench_result->cpu_usecs_per_frame,
+				bench_result->bytes_per_frame, bench_result->latency.p50,
+				bench_result->latency.p90, bench_result->latency.p99,
+				bench_result->latency.max, bench_rss_peak_kbytes());
+	} else {
+		printf("{\"codec\":\"%s\",\"stage\":\"%s\",\"format\":\"%s\","
+				"\"preset\":\"%s\",\"instances\":%d,\"frames\":%" PRIu64 ","
+				"\"fps\":%.2f,\"cpu_usecs_per_frame\":%.1f,"
+				"\"bytes_per_frame\":%.1f,\"latency_usecs\":{\"p50\":%" PRId64
+				",\"p90\":%" PRId64 ",\"p99\":%" PRId64 ",\"max\":%" PRId64 "},"
+				"\"rss_peak_kbytes\":%ld}\n", codec, stage, format, preset,
+				instances_num, bench_result->frames, bench_result->fps,
+				bench_result->cpu_usecs_per_frame,
+				bench_result->bytes_per_frame, bench_result->latency.p50,
+				bench_result->latency.p90, bench_result->latency.p99,
+				bench_result->latency.max, bench_rss_peak_kbytes());
+	}
+	fflush(stdout);
+}
+
+/**
+ * Benchmark one configuration: encode with 'instances_num' encoders, then
+ * decode the encoded frames with 'instances_num' decoders.
+ */
+static int bench_config_run(procs_ctx_t *procs_ctx,
+		const bench_codec_t *bench_codec, int width, int height,
+		const char *preset, int instances_num, int frames_num, int flag_csv)
+{
+	int i, ret_code, end_code= STAT_ERROR;
+	char settings_str[256], format_str[32];
+	bench_source_t bench_source;
+	bench_result_t bench_result;
+	bench_instance_ctx_t *enc_array= NULL, *dec_array= NULL;
+
+	memset(&bench_source, 0, sizeof(bench_source));
+
+	if(bench_codec->media_type== BENCH_MEDIA_VIDEO) {
+		snprintf(settings_str, sizeof(settings_str), "width_output=%d"
+				"&height_output=%d&frame_rate_output=%d&gop_size=%d"
+				"&bit_rate_output=%d%s%s", width, height, BENCH_FPS, BENCH_FPS,
+				width* height* 3, bench_codec->flag_presets?
+				"&conf_preset=": "", bench_codec->flag_presets? preset: "");
+		snprintf(format_str, sizeof(format_str), "%dx%d", width, height);
+	} else {
+		snprintf(settings_str, sizeof(settings_str), "sample_rate_output=%d"
+				"&bit_rate_output=128000", BENCH_AUDIO_SAMPLE_RATE);
+		snprintf(format_str, sizeof(format_str), "%dHz",
+				BENCH_AUDIO_SAMPLE_RATE);
+	}
+	if(!bench_codec->flag_presets)
+		preset= "";
+
+	enc_array= (bench_instance_ctx_t*)calloc(instances_num,
+			sizeof(bench_instance_ctx_t));
+	dec_array= (bench_instance_ctx_t*)calloc(instances_num,
+			sizeof(bench_instance_ctx_t));
+	if(enc_array== NULL || dec_array== NULL)
+		goto end;
+	for(i= 0; i< instances_num; i++) {
+		enc_array[i].proc_id= dec_array[i].proc_id= -1;
+		if(bench_instance_init(&enc_array[i], procs_ctx, frames_num, 1)!=
+				STAT_SUCCESS ||
+				bench_instance_init(&dec_array[i], procs_ctx, frames_num, 0)!=
+				STAT_SUCCESS)
+			goto end;
+	}
+
+	/* Open encoders */
+	for(i= 0; i< instances_num; i++) {
+		ret_code= procs_opt(procs_ctx, "PROCS_POST_ID",
+				bench_codec->proc_if_enc->proc_name, settings_str,
+				&enc_array[i].proc_id);
+		if(ret_code!= STAT_SUCCESS) {
+			fprintf(stderr, "Could not open encoder '%s' (%s)\n",
+					bench_codec->proc_if_enc->proc_name, settings_str);
+			goto end;
+		}
+	}
+
+	/* Synthetic source */
+	if(bench_codec->media_type== BENCH_MEDIA_VIDEO) {
+		ret_code= bench_source_video_init(&bench_source, width, height);
+	} else {
+		int frame_size= bench_audio_frame_size_get(procs_ctx,
+				enc_array[0].proc_id);
+		ret_code= frame_size> 0? bench_source_audio_init(&bench_source,
+				frame_size): STAT_ERROR;
+	}
+	if(ret_code!= STAT_SUCCESS)
+		goto end;
+
+	/* Encoding stage */
+	for(i= 0; i< instances_num; i++) {
+		enc_array[i].iput_frames= bench_source.frames;
+		enc_array[i].iput_frames_num= BENCH_SOURCE_FRAMES;
+		enc_array[i].flag_set_pts= 1;
+		enc_array[i].pts_period= bench_source.pts_period;
+	}
+	bench_stage_run(enc_array, instances_num, &bench_result);
+	bench_result_print(bench_codec->name, "enc", format_str, preset,
+			instances_num, &bench_result, flag_csv);
+
+	/* Decoding stage (input: the frames output by each encoder) */
+	for(i= 0; i< instances_num; i++) {
+		ret_code= procs_opt(procs_ctx, "PROCS_POST_ID",
+				bench_codec->proc_if_dec->proc_name, "",
+				&dec_array[i].proc_id);
+		if(ret_code!= STAT_SUCCESS) {
+			fprintf(stderr, "Could not open decoder '%s'\n",
+					bench_codec->proc_if_dec->proc_name);
+			goto end;
+		}
+		dec_array[i].iput_frames= enc_array[i].oput_frames;
+		dec_array[i].iput_frames_num= enc_array[i].oput_frames_num;
+		dec_array[i].frames_num= enc_array[i].oput_frames_num;
+		dec_array[i].pts_period= bench_source.pts_period;
+		if(dec_array[i].frames_num== 0)
+			goto end;
+	}
+	bench_stage_run(dec_array, instances_num, &bench_result);
+	bench_result_print(bench_codec->name, "dec", format_str, preset,
+			instances_num, &bench_result, flag_csv);
+
+	end_code= STAT_SUCCESS;
+end:
+	for(i= 0; i< instances_num; i++) {
+		if(enc_array!= NULL) {
+			if(enc_array[i].proc_id>= 0)
+				procs_opt(procs_ctx, "PROCS_ID_DELETE", enc_array[i].proc_id);
+			bench_instance_deinit(&enc_array[i]);
+		}
+		if(dec_array!= NULL) {
+			if(dec_array[i].proc_id>= 0)
+				procs_opt(procs_ctx, "PROCS_ID_DELETE", dec_array[i].proc_id);
+			bench_instance_deinit(&dec_array[i]);
+		}
+	}
+	if(enc_array!= NULL)
+		free(enc_array);
+	if(dec_array!= NULL)
+		free(dec_array);
+	bench_source_release(&bench_source);
+	return end_code;
+}
+
+static void usage(const char *prog_name)
+{
+	fprintf(stderr, "Usage: %s [-c codecs] [-r resolutions] [-p presets] "
+			"[-t instances] [-n frames] [-f json|csv]\n"
+			"Lists are comma separated; defaults: -c " BENCH_CODECS_DEFAULT
+			" -r " BENCH_RESOLUTIONS_DEFAULT " -p " BENCH_PRESETS_DEFAULT
+			" -t " BENCH_INSTANCES_DEFAULT " -n %d -f json\n", prog_name,
+			BENCH_FRAMES_DEFAULT);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, i, c, r, p, t, end_code= EXIT_FAILURE, flag_csv= 0;
+	int frames_num= BENCH_FRAMES_DEFAULT;
+	int codecs_num, resolutions_num, presets_num, instances_list_num;
+	int instances_max= 1;
+	char codecs_str[256]= BENCH_CODECS_DEFAULT;
+	char resolutions_str[256]= BENCH_RESOLUTIONS_DEFAULT;
+	char presets_str[256]= BENCH_PRESETS_DEFAULT;
+	char instances_str[256]= BENCH_INSTANCES_DEFAULT;
+	char *codecs[BENCH_LIST_MAX], *resolutions[BENCH_LIST_MAX],
+			*presets[BENCH_LIST_MAX], *instances_list[BENCH_LIST_MAX];
+	procs_ctx_t *procs_ctx= NULL;
+
+	while((opt= getopt(argc, argv, "c:r:p:t:n:f:"))!= -1) {
+		switch(opt) {
+		case 'c':
+			snprintf(codecs_str, sizeof(codecs_str), "%s", optarg);
+			break;
+		case 'r':
+			snprintf(resolutions_str, sizeof(resolutions_str), "%s", optarg);
+			break;
+		case 'p':
+			snprintf(presets_str, sizeof(presets_str), "%s", optarg);
+			break;
+		case 't':
+			snprintf(instances_str, sizeof(instances_str), "%s", optarg);
+			break;
+		case 'n':
+			frames_num= atoi(optarg);
+			break;
+		case 'f':
+			flag_csv= (strcmp(optarg, "csv")== 0);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	codecs_num= bench_list_parse(codecs_str, codecs, BENCH_LIST_MAX);
+	resolutions_num= bench_list_parse(resolutions_str, resolutions,
+			BENCH_LIST_MAX);
+	presets_num= bench_list_parse(presets_str, presets, BENCH_LIST_MAX);
+	instances_list_num= bench_list_parse(instances_str, instances_list,
+			BENCH_LIST_MAX);
+	for(t= 0; t< instances_list_num; t++) {
+		if(atoi(instances_list[t])< 1) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		if(atoi(instances_list[t])> instances_max)
+			instances_max= atoi(instances_list[t]);
+	}
+	if(frames_num< 1 || codecs_num< 1 || resolutions_num< 1 ||
+			presets_num< 1 || instances_list_num< 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Open LOG and PROCS modules; register codecs processor types */
+	avcodec_register_all();
+	if(log_module_open()!= STAT_SUCCESS || procs_module_open(NULL)!=
+			STAT_SUCCESS)
+		goto end;
+	for(i= 0; bench_codecs[i].name!= NULL; i++) {
+		if(procs_module_opt("PROCS_REGISTER_TYPE",
+				bench_codecs[i].proc_if_enc)!= STAT_SUCCESS ||
+				procs_module_opt("PROCS_REGISTER_TYPE",
+						bench_codecs[i].proc_if_dec)!= STAT_SUCCESS)
+			goto end;
+	}
+	procs_ctx= procs_open(NULL, instances_max* 2+ 16, NULL, NULL);
+	if(procs_ctx== NULL)
+		goto end;
+
+	if(flag_csv)
+		printf("codec,stage,format,preset,instances,frames,fps,"
+				"cpu_usecs_per_frame,bytes_per_frame,latency_p50_usecs,"
+				"latency_p90_usecs,latency_p99_usecs,latency_max_usecs,"
+				"rss_peak_kbytes\n");
+
+	/* Sweep */
+	for(c= 0; c< codecs_num; c++) {
+		const bench_codec_t *bench_codec= NULL;
+
+		for(i= 0; bench_codecs[i].name!= NULL; i++)
+			if(strcmp(bench_codecs[i].name, codecs[c])== 0)
+				bench_codec= &bench_codecs[i];
+		if(bench_codec== NULL) {
+			fprintf(stderr, "Unknown codec '%s'\n", codecs[c]);
+			continue;
+		}
+		for(r= 0; r< resolutions_num; r++) {
+			int width= 0, height= 0;
+
+			if(bench_codec->media_type== BENCH_MEDIA_VIDEO &&
+					(sscanf(resolutions[r], "%dx%d", &width, &height)!= 2 ||
+					width<= 0 || height<= 0 || (width& 1) || (height& 1))) {
+				fprintf(stderr, "Invalid resolution '%s'\n", resolutions[r]);
+				continue;
+			}
+			for(p= 0; p< presets_num; p++) {
+				for(t= 0; t< instances_list_num; t++) {
+					if(bench_config_run(procs_ctx, bench_codec, width, height,
+							presets[p], atoi(instances_list[t]), frames_num,
+							flag_csv)!= STAT_SUCCESS)
+						fprintf(stderr, "Benchmark '%s' failed\n",
+								bench_codec->name);
+				}
+				/* Presets only apply to some encoders */
+				if(!bench_codec->flag_presets)
+					break;
+			}
+			/* Resolutions do not apply to audio */
+			if(bench_codec->media_type!= BENCH_MEDIA_VIDEO)
+				break;
+		}
+	}
+
+	end_code= EXIT_SUCCESS;
+end:
+	if(procs_ctx!= NULL)
+		procs_close(&procs_ctx);
+	procs_module_close();
+	log_module_close();
+	return end_code;
+}
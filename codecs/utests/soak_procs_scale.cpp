@@ -0,0 +1,732 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file soak_procs_scale.cpp
+ * @brief Processor-count scaling soak test.
+ * Grows the number of processors of a PROCS instance up to each of the
+ * requested scales (e.g. 1000, 4000 and 8000 processors), creating them in
+ * waves ("PROCS_POST"), and then churns the population (deletes
+ * "PROCS_ID_DELETE" and re-creates waves of randomly chosen processors)
+ * while traffic flows: a few client threads keep doing paced
+ * 'procs_send_frame()'/'procs_recv_frame()' round-trips through their own
+ * bypass processors all along the test.
+ * The population is made of bypass processors and a share of MPEG-2 video
+ * encoders (the latter are only created and deleted; no traffic is sent to
+ * them).
+ * One JSON line is printed per scale with the resident memory and the
+ * thread count (absolute and per processor), the creation, deletion and
+ * REST GET ("PROCS_ID_GET" of a random processor and "PROCS_GET" of the
+ * whole list) latency distributions, and the send and round-trip latency
+ * distributions of the traffic.
+ * The test fails (exit code different from zero) if any API call fails, if
+ * threads are leaked once all the processors are deleted, or if a baseline
+ * is given (a file with the JSON lines output by a previous run) and any
+ * metric exceeds its baseline value by more than the given tolerance.
+ * Usage:
+ * mediaprocscodecs_soak [-n scales] [-w wave_size] [-r churn_waves]
+ * [-c codec_percent] [-t traffic_threads] [-i traffic_interval_usecs]
+ * [-B baseline_file] [-T tolerance_percent]
+ * where the scales list is comma separated, e.g.:
+ * mediaprocscodecs_soak -n 1000,4000,8000 -B soak_baseline.json -T 25
+ * @author Rafael Antoniello
+ */
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include <libcjson/cJSON.h>
+#include <libavcodec/avcodec.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/bench_stats.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/procs.h>
+#include "../src/bypass.h"
+#include "../src/ffmpeg_m2v.h"
+}
+
+/* **** Definitions **** */
+
+#define SOAK_SCALES_DEFAULT "1000,4000,8000"
+#define SOAK_WAVE_SIZE_DEFAULT 250
+#define SOAK_CHURN_WAVES_DEFAULT 4
+#define SOAK_CODEC_PERCENT_DEFAULT 5
+#define SOAK_TRAFFIC_THREADS_DEFAULT 4
+#define SOAK_TRAFFIC_INTERVAL_USECS_DEFAULT 1000
+#define SOAK_TOLERANCE_PERCENT_DEFAULT 25
+#define SOAK_LIST_MAX 16
+
+#define SOAK_TRAFFIC_FRAME_SIZE 4096
+
+#define SOAK_CODEC_SETTINGS "width_output=176&height_output=144"\
+		"&frame_rate_output=30&gop_size=30&bit_rate_output=128000"
+
+/**
+ * Number of REST GET requests measured at each scale ("PROCS_ID_GET" and
+ * "PROCS_GET", respectively).
+ */
+#define SOAK_ID_GET_NUM 1000
+#define SOAK_GET_NUM 10
+
+/**
+ * Threads allowed to remain once all the processors are deleted (with
+ * respect to the count before any processor was created).
+ */
+#define SOAK_THREADS_LEAK_SLACK 2
+
+#define SOAK_LATENCY_SAMPLES_MAX 16384
+
+/**
+ * Processor kept by the test.
+ */
+typedef struct soak_proc_s {
+	int proc_id;
+	int flag_codec;
+} soak_proc_t;
+
+/**
+ * Traffic thread context structure.
+ */
+typedef struct soak_traffic_ctx_s {
+	pthread_t thread;
+	procs_ctx_t *procs_ctx;
+	int proc_id;
+	int interval_usecs;
+	volatile int *ref_flag_exit;
+	volatile uint64_t errors;
+	bench_stats_ctx_t *send_stats;
+	bench_stats_ctx_t *rtt_stats;
+} soak_traffic_ctx_t;
+
+/**
+ * Soak test context structure.
+ */
+typedef struct soak_ctx_s {
+	procs_ctx_t *procs_ctx;
+	/**
+	 * Processors population (not including the traffic processors).
+	 */
+	soak_proc_t *procs;
+	int procs_num;
+	int procs_max;
+	int codec_procs_num;
+	int codec_percent;
+	/**
+	 * Counter of created processors (selects the codec processors).
+	 */
+	uint64_t created_num;
+	uint64_t errors;
+	uint64_t rand_state;
+	bench_stats_ctx_t *create_stats;
+	bench_stats_ctx_t *delete_stats;
+	bench_stats_ctx_t *id_get_stats;
+	bench_stats_ctx_t *get_stats;
+} soak_ctx_t;
+
+/**
+ * Metric compared against the baseline. A regression is reported if the
+ * value exceeds the baseline by more than the tolerance percentage and by
+ * more than 'slack' (absolute; avoids failing on noise around tiny values).
+ */
+typedef struct soak_metric_s {
+	const char *name;
+	const char *subname;
+	double slack;
+} soak_metric_t;
+
+static const soak_metric_t soak_metrics[]= {
+	{"rss_kbytes_per_proc", NULL, 16},
+	{"threads_per_proc", NULL, 0.05},
+	{"create_usecs", "p99", 200},
+	{"delete_usecs", "p99", 200},
+	{"id_get_usecs", "p99", 100},
+	{"get_usecs", "p99", 1000},
+	{"send_usecs", "p99", 100},
+	{"rtt_usecs", "p99", 200},
+	{NULL, NULL, 0}
+};
+
+/* **** Implementations **** */
+
+static inline uint64_t soak_rand(soak_ctx_t *soak_ctx)
+{
+	/* xorshift64 */
+	uint64_t x= soak_ctx->rand_state;
+
+	x^= x<< 13;
+	x^= x>> 7;
+	x^= x<< 17;
+	return soak_ctx->rand_state= x;
+}
+
+static void* soak_traffic_thr(void *t)
+{
+	int ret_code;
+	int64_t seq, t0_usecs, t1_usecs;
+	uint8_t data[SOAK_TRAFFIC_FRAME_SIZE]= {0};
+	proc_frame_ctx_t proc_frame_ctx, *proc_frame_ctx_recv= NULL;
+	soak_traffic_ctx_t *soak_traffic_ctx= (soak_traffic_ctx_t*)t;
+
+	schedule_set_thread_name("soak-traffic");
+
+	memset(&proc_frame_ctx, 0, sizeof(proc_frame_ctx));
+	proc_frame_ctx.data= data;
+	proc_frame_ctx.p_data[0]= data;
+	proc_frame_ctx.width[0]= proc_frame_ctx.linesize[0]= sizeof(data);
+	proc_frame_ctx.height[0]= 1;
+	proc_frame_ctx.proc_sample_fmt= PROC_IF_FMT_UNDEF;
+
+	for(seq= 1; *soak_traffic_ctx->ref_flag_exit== 0; seq++) {
+		proc_frame_ctx.pts= proc_frame_ctx.dts= seq;
+
+		t0_usecs= bench_now_usecs();
+		ret_code= procs_send_frame(soak_traffic_ctx->procs_ctx,
+				soak_traffic_ctx->proc_id, &proc_frame_ctx);
+		t1_usecs= bench_now_usecs();
+		if(ret_code!= STAT_SUCCESS) {
+			soak_traffic_ctx->errors++;
+			break;
+		}
+		bench_stats_add(soak_traffic_ctx->send_stats, t1_usecs- t0_usecs);
+
+		ret_code= procs_recv_frame(soak_traffic_ctx->procs_ctx,
+				soak_traffic_ctx->proc_id, &proc_frame_ctx_recv);
+		if(ret_code!= STAT_SUCCESS || proc_frame_ctx_recv== NULL ||
+				proc_frame_ctx_recv->pts!= seq) {
+			soak_traffic_ctx->errors++;
+			proc_frame_ctx_release(&proc_frame_ctx_recv);
+			break;
+		}
+		bench_stats_add(soak_traffic_ctx->rtt_stats, bench_now_usecs()-
+				t0_usecs);
+		proc_frame_ctx_release(&proc_frame_ctx_recv);
+
+		if(soak_traffic_ctx->interval_usecs> 0)
+			usleep(soak_traffic_ctx->interval_usecs);
+	}
+	return NULL;
+}
+
+static int soak_proc_create(soak_ctx_t *soak_ctx)
+{
+	int ret_code, proc_id= -1;
+	int64_t t0_usecs;
+	soak_proc_t *soak_proc;
+	int flag_codec= 0;
+
+	if(soak_ctx->procs_num>= soak_ctx->procs_max)
+		return STAT_ENOMEM;
+
+	/* Every (100/'codec_percent')-th processor is a codec */
+	if(soak_ctx->codec_percent> 0 && (soak_ctx->created_num*
+			soak_ctx->codec_percent)% 100+ soak_ctx->codec_percent>= 100)
+		flag_codec= 1;
+	soak_ctx->created_num++;
+
+	t0_usecs= bench_now_usecs();
+	ret_code= procs_opt(soak_ctx->procs_ctx, "PROCS_POST_ID", flag_codec?
+			proc_if_ffmpeg_m2v_enc.proc_name: proc_if_bypass.proc_name,
+			flag_codec? SOAK_CODEC_SETTINGS: "", &proc_id);
+	if(ret_code!= STAT_SUCCESS) {
+		soak_ctx->errors++;
+		return ret_code;
+	}
+	bench_stats_add(soak_ctx->create_stats, bench_now_usecs()- t0_usecs);
+
+	soak_proc= &soak_ctx->procs[soak_ctx->procs_num++];
+	soak_proc->proc_id= proc_id;
+	soak_proc->flag_codec= flag_codec;
+	if(flag_codec)
+		soak_ctx->codec_procs_num++;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Delete the processor at the given population index (the last processor
+ * of the population takes its place).
+ */
+static int soak_proc_delete(soak_ctx_t *soak_ctx, int index)
+{
+	int ret_code;
+	int64_t t0_usecs;
+	soak_proc_t *soak_proc= &soak_ctx->procs[index];
+
+	t0_usecs= bench_now_usecs();
+	ret_code= procs_opt(soak_ctx->procs_ctx, "PROCS_ID_DELETE",
+			soak_proc->proc_id);
+	if(ret_code!= STAT_SUCCESS)
+		soak_ctx->errors++;
+	else
+		bench_stats_add(soak_ctx->delete_stats, bench_now_usecs()- t0_usecs);
+
+	if(soak_proc->flag_codec)
+		soak_ctx->codec_procs_num--;
+	*soak_proc= soak_ctx->procs[--soak_ctx->procs_num];
+	return ret_code;
+}
+
+/**
+ * Measure the REST GET latencies on the current population.
+ */
+static void soak_rest_get_measure(soak_ctx_t *soak_ctx)
+{
+	int i, ret_code;
+	int64_t t0_usecs;
+	char *rest_str= NULL;
+
+	for(i= 0; i< SOAK_ID_GET_NUM && soak_ctx->procs_num> 0; i++) {
+		int proc_id= soak_ctx->procs[soak_rand(soak_ctx)%
+				soak_ctx->procs_num].proc_id;
+
+		t0_usecs= bench_now_usecs();
+		ret_code= procs_opt(soak_ctx->procs_ctx, "PROCS_ID_GET", proc_id,
+				&rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL)
+			soak_ctx->errors++;
+		else
+			bench_stats_add(soak_ctx->id_get_stats, bench_now_usecs()-
+					t0_usecs);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+	}
+
+	for(i= 0; i< SOAK_GET_NUM; i++) {
+		t0_usecs= bench_now_usecs();
+		ret_code= procs_opt(soak_ctx->procs_ctx, "PROCS_GET", &rest_str,
+				NULL);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL)
+			soak_ctx->errors++;
+		else
+			bench_stats_add(soak_ctx->get_stats, bench_now_usecs()-
+					t0_usecs);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+	}
+}
+
+static int soak_stats_json(char *buf, size_t buf_size, const char *name,
+		bench_stats_ctx_t *bench_stats_ctx)
+{
+	bench_stats_summary_t bench_stats_summary;
+
+	bench_stats_summary_get(bench_stats_ctx, &bench_stats_summary);
+	return snprintf(buf, buf_size, "\"%s\":{\"count\":%" PRIu64 ",\"p50\":%"
+			PRId64 ",\"p90\":%" PRId64 ",\"p99\":%" PRId64 ",\"max\":%" PRId64
+			"}", name, bench_stats_summary.count, bench_stats_summary.p50,
+			bench_stats_summary.p90, bench_stats_summary.p99,
+			bench_stats_summary.max);
+}
+
+/**
+ * Aggregate the traffic statistics of all the traffic threads (and reset
+ * them for the next scale).
+ */
+static void soak_traffic_stats_get(soak_traffic_ctx_t *soak_traffic_ctx_array,
+		int traffic_threads_num, bench_stats_ctx_t *send_stats,
+		bench_stats_ctx_t *rtt_stats, uint64_t *ref_errors)
+{
+	int i;
+
+	bench_stats_reset(send_stats);
+	bench_stats_reset(rtt_stats);
+	for(i= 0; i< traffic_threads_num; i++) {
+		soak_traffic_ctx_t *soak_traffic_ctx= &soak_traffic_ctx_array[i];
+		bench_stats_merge(send_stats, soak_traffic_ctx->send_stats);
+		bench_stats_merge(rtt_stats, soak_traffic_ctx->rtt_stats);
+		bench_stats_reset(soak_traffic_ctx->send_stats);
+		bench_stats_reset(soak_traffic_ctx->rtt_stats);
+		*ref_errors+= soak_traffic_ctx->errors;
+	}
+}
+
+/**
+ * Get a metric value from a result JSON object.
+ */
+static int soak_metric_get(cJSON *cjson_result,
+		const soak_metric_t *soak_metric, double *ref_value)
+{
+	cJSON *cjson_aux= cJSON_GetObjectItem(cjson_result, soak_metric->name);
+
+	if(cjson_aux!= NULL && soak_metric->subname!= NULL)
+		cjson_aux= cJSON_GetObjectItem(cjson_aux, soak_metric->subname);
+	if(cjson_aux== NULL)
+		return STAT_ENOTFOUND;
+	*ref_value= cjson_aux->valuedouble;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Compare a scale result (JSON line) against the baseline result line of
+ * the same scale, if any.
+ * @return Number of regressed metrics.
+ */
+static int soak_baseline_check(const char *result_str,
+		const char *baseline_file, double tolerance_percent)
+{
+	int i, procs_num, regressions= 0;
+	char line[4096];
+	FILE *file= NULL;
+	cJSON *cjson_result= NULL, *cjson_baseline= NULL, *cjson_aux;
+
+	if(baseline_file== NULL)
+		return 0;
+	if((cjson_result= cJSON_Parse(result_str))== NULL ||
+			(cjson_aux= cJSON_GetObjectItem(cjson_result, "procs"))== NULL)
+		goto end;
+	procs_num= (int)cjson_aux->valuedouble;
+
+	/* Look for the baseline line of the same scale */
+	if((file= fopen(baseline_file, "r"))== NULL) {
+		fprintf(stderr, "Could not open baseline file '%s'\n",
+				baseline_file);
+		regressions++;
+		goto end;
+	}
+	while(fgets(line, sizeof(line), file)!= NULL) {
+		if((cjson_baseline= cJSON_Parse(line))!= NULL &&
+				(cjson_aux= cJSON_GetObjectItem(cjson_baseline, "procs"))!=
+						NULL && (int)cjson_aux->valuedouble== procs_num)
+			break;
+		if(cjson_baseline!= NULL) {
+			cJSON_Delete(cjson_baseline);
+			cjson_baseline= NULL;
+		}
+	}
+	if(cjson_baseline== NULL) {
+		fprintf(stderr, "No baseline for %d processors\n", procs_num);
+		goto end;
+	}
+
+	for(i= 0; soak_metrics[i].name!= NULL; i++) {
+		const soak_metric_t *soak_metric= &soak_metrics[i];
+		double value, value_baseline, value_max;
+
+		if(soak_metric_get(cjson_result, soak_metric, &value)!=
+				STAT_SUCCESS || soak_metric_get(cjson_baseline, soak_metric,
+						&value_baseline)!= STAT_SUCCESS)
+			continue;
+		value_max= value_baseline* (1.0+ tolerance_percent/ 100.0);
+		if(value> value_max && value- value_baseline> soak_metric->slack) {
+			fprintf(stderr, "REGRESSION (%d processors): %s%s%s= %.2f "
+					"(baseline: %.2f, tolerance: %.0f%%)\n", procs_num,
+					soak_metric->name, soak_metric->subname!= NULL? ".": "",
+					soak_metric->subname!= NULL? soak_metric->subname: "",
+					value, value_baseline, tolerance_percent);
+			regressions++;
+		}
+	}
+
+end:
+	if(file!= NULL)
+		fclose(file);
+	if(cjson_result!= NULL)
+		cJSON_Delete(cjson_result);
+	if(cjson_baseline!= NULL)
+		cJSON_Delete(cjson_baseline);
+	return regressions;
+}
+
+static void usage(const char *prog_name)
+{
+	fprintf(stderr, "Usage: %s [-n scales] [-w wave_size] [-r churn_waves] "
+			"[-c codec_percent] [-t traffic_threads] "
+			"[-i traffic_interval_usecs] [-B baseline_file] "
+			"[-T tolerance_percent]\nDefaults: -n " SOAK_SCALES_DEFAULT
+			" -w %d -r %d -c %d -t %d -i %d -T %d\n", prog_name,
+			SOAK_WAVE_SIZE_DEFAULT, SOAK_CHURN_WAVES_DEFAULT,
+			SOAK_CODEC_PERCENT_DEFAULT, SOAK_TRAFFIC_THREADS_DEFAULT,
+			SOAK_TRAFFIC_INTERVAL_USECS_DEFAULT,
+			SOAK_TOLERANCE_PERCENT_DEFAULT);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, i, s, w, end_code= EXIT_FAILURE, regressions= 0;
+	int wave_size= SOAK_WAVE_SIZE_DEFAULT;
+	int churn_waves= SOAK_CHURN_WAVES_DEFAULT;
+	int traffic_threads_num= SOAK_TRAFFIC_THREADS_DEFAULT;
+	int traffic_interval_usecs= SOAK_TRAFFIC_INTERVAL_USECS_DEFAULT;
+	int scales_num, scale_max= 0, threads_base;
+	volatile int flag_traffic_exit= 0;
+	double tolerance_percent= SOAK_TOLERANCE_PERCENT_DEFAULT;
+	long rss_base_kbytes;
+	uint64_t traffic_errors= 0;
+	const char *baseline_file= NULL;
+	char scales_str[256]= SOAK_SCALES_DEFAULT;
+	char *scales[SOAK_LIST_MAX];
+	soak_ctx_t soak_ctx;
+	soak_traffic_ctx_t *soak_traffic_ctx_array= NULL;
+	bench_stats_ctx_t *send_stats= NULL, *rtt_stats= NULL;
+
+	memset(&soak_ctx, 0, sizeof(soak_ctx));
+	soak_ctx.codec_percent= SOAK_CODEC_PERCENT_DEFAULT;
+	soak_ctx.rand_state= 0x9E3779B97F4A7C15ULL;
+
+	while((opt= getopt(argc, argv, "n:w:r:c:t:i:B:T:"))!= -1) {
+		switch(opt) {
+		case 'n':
+			snprintf(scales_str, sizeof(scales_str), "%s", optarg);
+			break;
+		case 'w':
+			wave_size= atoi(optarg);
+			break;
+		case 'r':
+			churn_waves= atoi(optarg);
+			break;
+		case 'c':
+			soak_ctx.codec_percent= atoi(optarg);
+			break;
+		case 't':
+			traffic_threads_num= atoi(optarg);
+			break;
+		case 'i':
+			traffic_interval_usecs= atoi(optarg);
+			break;
+		case 'B':
+			baseline_file= optarg;
+			break;
+		case 'T':
+			tolerance_percent= atof(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	scales_num= bench_list_parse(scales_str, scales, SOAK_LIST_MAX);
+	for(s= 0; s< scales_num; s++) {
+		if(atoi(scales[s])< 1) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		if(atoi(scales[s])> scale_max)
+			scale_max= atoi(scales[s]);
+	}
+	if(scales_num< 1 || wave_size< 1 || churn_waves< 0 ||
+			soak_ctx.codec_percent< 0 || soak_ctx.codec_percent> 100 ||
+			traffic_threads_num< 0 || traffic_interval_usecs< 0 ||
+			tolerance_percent< 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Open LOG and PROCS modules; register processor types */
+	avcodec_register_all();
+	if(log_module_open()!= STAT_SUCCESS || procs_module_open(NULL)!=
+			STAT_SUCCESS)
+		goto end;
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_bypass)!=
+			STAT_SUCCESS || procs_module_opt("PROCS_REGISTER_TYPE",
+					&proc_if_ffmpeg_m2v_enc)!= STAT_SUCCESS)
+		goto end;
+	soak_ctx.procs_ctx= procs_open(NULL, scale_max+ traffic_threads_num+ 16,
+			NULL, NULL);
+	if(soak_ctx.procs_ctx== NULL)
+		goto end;
+
+	/* Allocate population and statistics */
+	soak_ctx.procs_max= scale_max;
+	soak_ctx.procs= (soak_proc_t*)calloc(scale_max, sizeof(soak_proc_t));
+	soak_ctx.create_stats= bench_stats_open(SOAK_LATENCY_SAMPLES_MAX);
+	soak_ctx.delete_stats= bench_stats_open(SOAK_LATENCY_SAMPLES_MAX);
+	soak_ctx.id_get_stats= bench_stats_open(SOAK_LATENCY_SAMPLES_MAX);
+	soak_ctx.get_stats= bench_stats_open(SOAK_LATENCY_SAMPLES_MAX);
+	send_stats= bench_stats_open(SOAK_LATENCY_SAMPLES_MAX* 4);
+	rtt_stats= bench_stats_open(SOAK_LATENCY_SAMPLES_MAX* 4);
+	if(soak_ctx.procs== NULL || soak_ctx.create_stats== NULL ||
+			soak_ctx.delete_stats== NULL || soak_ctx.id_get_stats== NULL ||
+			soak_ctx.get_stats== NULL || send_stats== NULL ||
+			rtt_stats== NULL)
+		goto end;
+
+	threads_base= bench_threads_num();
+	rss_base_kbytes= bench_rss_kbytes();
+
+	/* Start traffic (one bypass processor per traffic thread) */
+	if(traffic_threads_num> 0) {
+		soak_traffic_ctx_array= (soak_traffic_ctx_t*)calloc(
+				traffic_threads_num, sizeof(soak_traffic_ctx_t));
+		if(soak_traffic_ctx_array== NULL)
+			goto end;
+	}
+	for(i= 0; i< traffic_threads_num; i++) {
+		soak_traffic_ctx_t *soak_traffic_ctx= &soak_traffic_ctx_array[i];
+		soak_traffic_ctx->procs_ctx= soak_ctx.procs_ctx;
+		soak_traffic_ctx->proc_id= -1;
+		soak_traffic_ctx->interval_usecs= traffic_interval_usecs;
+		soak_traffic_ctx->ref_flag_exit= &flag_traffic_exit;
+		if((soak_traffic_ctx->send_stats= bench_stats_open(
+				SOAK_LATENCY_SAMPLES_MAX))== NULL ||
+				(soak_traffic_ctx->rtt_stats= bench_stats_open(
+						SOAK_LATENCY_SAMPLES_MAX))== NULL ||
+				procs_opt(soak_ctx.procs_ctx, "PROCS_POST_ID",
+						proc_if_bypass.proc_name, "",
+						&soak_traffic_ctx->proc_id)!= STAT_SUCCESS)
+			goto end;
+	}
+	for(i= 0; i< traffic_threads_num; i++)
+		pthread_create(&soak_traffic_ctx_array[i].thread, NULL,
+				soak_traffic_thr, &soak_traffic_ctx_array[i]);
+
+	/* Scales (in the given order; the population shrinks if needed) */
+	for(s= 0; s< scales_num; s++) {
+		int scale= atoi(scales[s]);
+		int threads_num;
+		long rss_kbytes;
+		char result_str[2048];
+		size_t len;
+
+		bench_stats_reset(soak_ctx.create_stats);
+		bench_stats_reset(soak_ctx.delete_stats);
+		bench_stats_reset(soak_ctx.id_get_stats);
+		bench_stats_reset(soak_ctx.get_stats);
+		soak_traffic_stats_get(soak_traffic_ctx_array, traffic_threads_num,
+				send_stats, rtt_stats, &traffic_errors);
+
+		/* Grow or shrink population in waves */
+		while(soak_ctx.procs_num< scale) {
+			for(w= 0; w< wave_size && soak_ctx.procs_num< scale; w++)
+				if(soak_proc_create(&soak_ctx)!= STAT_SUCCESS)
+					break;
+			if(w< wave_size && soak_ctx.procs_num< scale)
+				break; // creation failed (already accounted as error)
+		}
+		while(soak_ctx.procs_num> scale)
+			soak_proc_delete(&soak_ctx, soak_ctx.procs_num- 1);
+
+		/* Steady state */
+		threads_num= bench_threads_num();
+		rss_kbytes= bench_rss_kbytes();
+		soak_rest_get_measure(&soak_ctx);
+
+		/* Churn: delete and re-create waves of random processors */
+		for(w= 0; w< churn_waves; w++) {
+			int j, wave= wave_size< soak_ctx.procs_num? wave_size:
+					soak_ctx.procs_num;
+
+			for(j= 0; j< wave; j++)
+				soak_proc_delete(&soak_ctx, soak_rand(&soak_ctx)%
+						soak_ctx.procs_num);
+			for(j= 0; j< wave; j++)
+				if(soak_proc_create(&soak_ctx)!= STAT_SUCCESS)
+					break;
+		}
+
+		soak_traffic_stats_get(soak_traffic_ctx_array, traffic_threads_num,
+				send_stats, rtt_stats, &traffic_errors);
+
+		/* Report */
+		len= snprintf(result_str, sizeof(result_str), "{\"procs\":%d,"
+				"\"codec_procs\":%d,\"rss_kbytes\":%ld,"
+				"\"rss_kbytes_per_proc\":%.2f,\"threads\":%d,"
+				"\"threads_per_proc\":%.3f,", soak_ctx.procs_num,
+				soak_ctx.codec_procs_num, rss_kbytes, soak_ctx.procs_num> 0?
+				(double)(rss_kbytes- rss_base_kbytes)/ soak_ctx.procs_num: 0,
+				threads_num, soak_ctx.procs_num> 0? (double)(threads_num-
+				threads_base)/ soak_ctx.procs_num: 0);
+		len+= soak_stats_json(result_str+ len, sizeof(result_str)- len,
+				"create_usecs", soak_ctx.create_stats);
+		len+= snprintf(result_str+ len, sizeof(result_str)- len, ",");
+		len+= soak_stats_json(result_str+ len, sizeof(result_str)- len,
+				"delete_usecs", soak_ctx.delete_stats);
+		len+= snprintf(result_str+ len, sizeof(result_str)- len, ",");
+		len+= soak_stats_json(result_str+ len, sizeof(result_str)- len,
+				"id_get_usecs", soak_ctx.id_get_stats);
+		len+= snprintf(result_str+ len, sizeof(result_str)- len, ",");
+		len+= soak_stats_json(result_str+ len, sizeof(result_str)- len,
+				"get_usecs", soak_ctx.get_stats);
+		len+= snprintf(result_str+ len, sizeof(result_str)- len, ",");
+		len+= soak_stats_json(result_str+ len, sizeof(result_str)- len,
+				"send_usecs", send_stats);
+		len+= snprintf(result_str+ len, sizeof(result_str)- len, ",");
+		len+= soak_stats_json(result_str+ len, sizeof(result_str)- len,
+				"rtt_usecs", rtt_stats);
+		len+= snprintf(result_str+ len, sizeof(result_str)- len,
+				",\"errors\":%" PRIu64 "}", soak_ctx.errors+ traffic_errors);
+		printf("%s\n", result_str);
+		fflush(stdout);
+
+		regressions+= soak_baseline_check(result_str, baseline_file,
+				tolerance_percent);
+	}
+
+	/* Tear down: stop traffic and delete all the processors */
+	flag_traffic_exit= 1;
+	for(i= 0; i< traffic_threads_num; i++) {
+		pthread_join(soak_traffic_ctx_array[i].thread, NULL);
+		procs_opt(soak_ctx.procs_ctx, "PROCS_ID_DELETE",
+				soak_traffic_ctx_array[i].proc_id);
+		soak_traffic_ctx_array[i].proc_id= -1;
+		traffic_errors+= soak_traffic_ctx_array[i].errors;
+	}
+	while(soak_ctx.procs_num> 0)
+		soak_proc_delete(&soak_ctx, soak_ctx.procs_num- 1);
+	if(bench_threads_num()> threads_base+ SOAK_THREADS_LEAK_SLACK) {
+		fprintf(stderr, "FAILURE: threads leaked (%d threads before "
+				"creating processors, %d after deleting them)\n",
+				threads_base, bench_threads_num());
+		regressions++;
+	}
+	if(soak_ctx.errors> 0 || traffic_errors> 0) {
+		fprintf(stderr, "FAILURE: %" PRIu64 " API errors, %" PRIu64
+				" traffic errors\n", soak_ctx.errors, traffic_errors);
+		regressions++;
+	}
+
+	end_code= regressions> 0? EXIT_FAILURE: EXIT_SUCCESS;
+end:
+	if(soak_traffic_ctx_array!= NULL) {
+		flag_traffic_exit= 1;
+		for(i= 0; i< traffic_threads_num; i++) {
+			soak_traffic_ctx_t *soak_traffic_ctx= &soak_traffic_ctx_array[i];
+			if(soak_traffic_ctx->proc_id>= 0)
+				procs_opt(soak_ctx.procs_ctx, "PROCS_ID_DELETE",
+						soak_traffic_ctx->proc_id);
+			bench_stats_close(&soak_traffic_ctx->send_stats);
+			bench_stats_close(&soak_traffic_ctx->rtt_stats);
+		}
+		free(soak_traffic_ctx_array);
+	}
+	if(soak_ctx.procs!= NULL)
+		free(soak_ctx.procs);
+	bench_stats_close(&soak_ctx.create_stats);
+	bench_stats_close(&soak_ctx.delete_stats);
+	bench_stats_close(&soak_ctx.id_get_stats);
+	bench_stats_close(&soak_ctx.get_stats);
+	bench_stats_close(&send_stats);
+	bench_stats_close(&rtt_stats);
+	if(soak_ctx.procs_ctx!= NULL)
+		procs_close(&soak_ctx.procs_ctx);
+	procs_module_close();
+	log_module_close();
+	return end_code;
+}
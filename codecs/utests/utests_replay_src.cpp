@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file utests_replay_src.cpp
+ * @brief Frames capture and capture replay source processor unit testing.
+ * @author Rafael Antoniello
+ */
+
+#include <UnitTest++/UnitTest++.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <libcjson/cJSON.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/procs.h>
+#include "../src/synth_src.h"
+#include "../src/replay_src.h"
+}
+
+#define UTESTS_REPLAY_SRC_FRAMES_NUM 50
+#define UTESTS_REPLAY_SRC_DIR "/tmp/utests_replay_src"
+#define UTESTS_REPLAY_SRC_FILE "utests_replay_src.mpcap"
+
+/**
+ * Open the PROCS module and instance, and register the synthetic source and
+ * capture replay source processor types.
+ */
+static procs_ctx_t* utests_replay_src_procs_open()
+{
+	log_module_open();
+	if(procs_module_open(NULL)!= STAT_SUCCESS)
+		return NULL;
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_synth_src)!=
+			STAT_SUCCESS ||
+			procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_replay_src)!=
+			STAT_SUCCESS ||
+			procs_module_opt("PROCS_SET_CAPTURE_DIR", UTESTS_REPLAY_SRC_DIR)!=
+			STAT_SUCCESS)
+		return NULL;
+	return procs_open(NULL, 16, NULL, NULL);
+}
+
+static void utests_replay_src_procs_close(procs_ctx_t **ref_procs_ctx)
+{
+	if(*ref_procs_ctx!= NULL)
+		procs_close(ref_procs_ctx);
+	procs_module_close();
+	log_module_close();
+}
+
+/**
+ * Register (open) a processor instance; returns its Id. or -1 on failure.
+ */
+static int utests_replay_src_post(procs_ctx_t *procs_ctx,
+		const char *proc_name, const char *settings_str)
+{
+	int proc_id= -1;
+	char *rest_str= NULL;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+
+	if(procs_opt(procs_ctx, "PROCS_POST", proc_name, settings_str,
+			&rest_str)!= STAT_SUCCESS || rest_str== NULL)
+		goto end;
+	if((cjson_rest= cJSON_Parse(rest_str))== NULL ||
+			(cjson_aux= cJSON_GetObjectItem(cjson_rest, "proc_id"))== NULL)
+		goto end;
+	proc_id= cjson_aux->valuedouble;
+end:
+	if(rest_str!= NULL)
+		free(rest_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return proc_id;
+}
+
+SUITE(UTESTS_REPLAY_SRC)
+{
+	/* Capture the output of a synthetic source and replay it at maximum
+	 * rate: replayed frames are byte-exact (same stamps, geometry and
+	 * time-stamps) and, when looping, time-stamps keep increasing.
+	 * Capture and replay files are restricted to the capture directory and
+	 * existing files are not overwritten.
+	 */
+	TEST(UTESTS_REPLAY_SRC_CAPTURE_REPLAY)
+	{
+		int i, synth_src_id, replay_src_id;
+		int64_t pts[UTESTS_REPLAY_SRC_FRAMES_NUM];
+		synth_src_stamp_t synth_src_stamp;
+		procs_ctx_t *procs_ctx= NULL;
+		proc_frame_ctx_t *proc_frame_ctx= NULL;
+
+		unlink(UTESTS_REPLAY_SRC_DIR "/" UTESTS_REPLAY_SRC_FILE);
+		procs_ctx= utests_replay_src_procs_open();
+		CHECK(procs_ctx!= NULL);
+		if(procs_ctx== NULL)
+			goto end;
+
+		/* Record */
+		synth_src_id= utests_replay_src_post(procs_ctx, "synth_src",
+				"flag_max_rate=true&width_output=176&height_output=144");
+		CHECK(synth_src_id>= 0);
+		if(synth_src_id< 0)
+			goto end;
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"capture=sideways")!= STAT_SUCCESS);
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"capture=output&capture_file=/tmp/" UTESTS_REPLAY_SRC_FILE)!=
+						STAT_SUCCESS);
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"capture=output&capture_file=../" UTESTS_REPLAY_SRC_FILE)!=
+						STAT_SUCCESS);
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"capture=output&capture_file=" UTESTS_REPLAY_SRC_FILE)==
+						STAT_SUCCESS);
+		for(i= 0; i< UTESTS_REPLAY_SRC_FRAMES_NUM; i++) {
+			CHECK(procs_recv_frame(procs_ctx, synth_src_id, &proc_frame_ctx)==
+					STAT_SUCCESS);
+			if(proc_frame_ctx== NULL)
+				break;
+			pts[i]= proc_frame_ctx->pts;
+			proc_frame_ctx_release(&proc_frame_ctx);
+		}
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"capture=stop")== STAT_SUCCESS);
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"capture=output&capture_file=" UTESTS_REPLAY_SRC_FILE)!=
+						STAT_SUCCESS);
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE", synth_src_id)==
+				STAT_SUCCESS);
+
+		/* Replay (twice) */
+		CHECK(utests_replay_src_post(procs_ctx, "replay_src",
+				"file=utests_replay_src_nonexistent.mpcap")< 0);
+		CHECK(utests_replay_src_post(procs_ctx, "replay_src",
+				"file=" UTESTS_REPLAY_SRC_DIR "/" UTESTS_REPLAY_SRC_FILE)< 0);
+		CHECK(utests_replay_src_post(procs_ctx, "replay_src",
+				"file=../utests_replay_src/" UTESTS_REPLAY_SRC_FILE)< 0);
+		replay_src_id= utests_replay_src_post(procs_ctx, "replay_src",
+				"{\"file\":\"" UTESTS_REPLAY_SRC_FILE "\","
+				"\"flag_max_rate\":true,\"flag_loop\":true}");
+		CHECK(replay_src_id>= 0);
+		if(replay_src_id< 0)
+			goto end;
+		for(i= 0; i< 2* UTESTS_REPLAY_SRC_FRAMES_NUM; i++) {
+			int idx= i% UTESTS_REPLAY_SRC_FRAMES_NUM;
+			CHECK(procs_recv_frame(procs_ctx, replay_src_id, &proc_frame_ctx)==
+					STAT_SUCCESS);
+			if(proc_frame_ctx== NULL)
+				break;
+			CHECK(proc_frame_ctx->width[0]== 176 &&
+					proc_frame_ctx->height[0]== 144 &&
+					proc_frame_ctx->width[1]== 88 &&
+					proc_frame_ctx->height[2]== 72);
+			CHECK(proc_frame_ctx->proc_sample_fmt== PROC_IF_FMT_YUV420P);
+			CHECK(synth_src_stamp_read(proc_frame_ctx, &synth_src_stamp)==
+					STAT_SUCCESS && synth_src_stamp.seq== (uint64_t)idx);
+			if(i< UTESTS_REPLAY_SRC_FRAMES_NUM)
+				CHECK(proc_frame_ctx->pts== pts[idx]);
+			else
+				CHECK(proc_frame_ctx->pts>
+						pts[UTESTS_REPLAY_SRC_FRAMES_NUM- 1]);
+			proc_frame_ctx_release(&proc_frame_ctx);
+		}
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE", replay_src_id)==
+				STAT_SUCCESS);
+end:
+		unlink(UTESTS_REPLAY_SRC_DIR "/" UTESTS_REPLAY_SRC_FILE);
+		rmdir(UTESTS_REPLAY_SRC_DIR);
+		utests_replay_src_procs_close(&procs_ctx);
+	}
+}
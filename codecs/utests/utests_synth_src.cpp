@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file utests_synth_src.cpp
+ * @brief Synthetic source and null sink processors unit testing.
+ * @author Rafael Antoniello
+ */
+
+#include <UnitTest++/UnitTest++.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <libcjson/cJSON.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/procs.h>
+#include "../src/synth_src.h"
+#include "../src/null_sink.h"
+}
+
+#define UTESTS_SYNTH_SRC_FRAMES_NUM 100
+
+/**
+ * Open the PROCS module and instance, and register the synthetic source and
+ * null sink processor types.
+ */
+static procs_ctx_t* utests_synth_src_procs_open()
+{
+	log_module_open();
+	if(procs_module_open(NULL)!= STAT_SUCCESS)
+		return NULL;
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_synth_src)!=
+			STAT_SUCCESS ||
+			procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_null_sink)!=
+			STAT_SUCCESS)
+		return NULL;
+	return procs_open(NULL, 16, NULL, NULL);
+}
+
+static void utests_synth_src_procs_close(procs_ctx_t **ref_procs_ctx)
+{
+	if(*ref_procs_ctx!= NULL)
+		procs_close(ref_procs_ctx);
+	procs_module_close();
+	log_module_close();
+}
+
+/**
+ * Register (open) a processor instance; returns its Id. or -1 on failure.
+ */
+static int utests_synth_src_post(procs_ctx_t *procs_ctx,
+		const char *proc_name, const char *settings_str)
+{
+	int proc_id= -1;
+	char *rest_str= NULL;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+
+	if(procs_opt(procs_ctx, "PROCS_POST", proc_name, settings_str,
+			&rest_str)!= STAT_SUCCESS || rest_str== NULL)
+		goto end;
+	if((cjson_rest= cJSON_Parse(rest_str))== NULL ||
+			(cjson_aux= cJSON_GetObjectItem(cjson_rest, "proc_id"))== NULL)
+		goto end;
+	proc_id= cjson_aux->valuedouble;
+end:
+	if(rest_str!= NULL)
+		free(rest_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return proc_id;
+}
+
+/**
+ * Get processor representational state; returns the cJSON tree (to be
+ * released by the caller) or NULL on failure.
+ */
+static cJSON* utests_synth_src_get(procs_ctx_t *procs_ctx, int proc_id)
+{
+	char *rest_str= NULL;
+	cJSON *cjson_rest= NULL;
+
+	if(procs_opt(procs_ctx, "PROCS_ID_GET", proc_id, &rest_str)==
+			STAT_SUCCESS && rest_str!= NULL)
+		cjson_rest= cJSON_Parse(rest_str);
+	if(rest_str!= NULL)
+		free(rest_str);
+	return cjson_rest;
+}
+
+/**
+ * Run 'frames_num' frames from a synthetic source to a null sink, skipping
+ * every frame whose index modulo 'skip_period' is 'skip_period- 1' (no frame
+ * is skipped if 'skip_period' is zero). Returns the null sink GET
+ * representation (to be released by the caller).
+ */
+static cJSON* utests_synth_src_run(const char *synth_src_settings,
+		int frames_num, int skip_period, int proc_sample_fmt)
+{
+	int i, synth_src_id= -1, null_sink_id= -1;
+	procs_ctx_t *procs_ctx= NULL;
+	proc_frame_ctx_t *proc_frame_ctx= NULL;
+	cJSON *cjson_rest= NULL;
+
+	procs_ctx= utests_synth_src_procs_open();
+	CHECK(procs_ctx!= NULL);
+	if(procs_ctx== NULL)
+		goto end;
+
+	synth_src_id= utests_synth_src_post(procs_ctx, "synth_src",
+			synth_src_settings);
+	CHECK(synth_src_id>= 0);
+	null_sink_id= utests_synth_src_post(procs_ctx, "null_sink", "");
+	CHECK(null_sink_id>= 0);
+	if(synth_src_id< 0 || null_sink_id< 0)
+		goto end;
+
+	for(i= 0; i< frames_num; i++) {
+		CHECK(procs_recv_frame(procs_ctx, synth_src_id, &proc_frame_ctx)==
+				STAT_SUCCESS);
+		if(proc_frame_ctx== NULL)
+			break;
+		CHECK(proc_frame_ctx->proc_sample_fmt== proc_sample_fmt);
+		if(skip_period== 0 || (i% skip_period)!= skip_period- 1)
+			CHECK(procs_send_frame(procs_ctx, null_sink_id, proc_frame_ctx)==
+					STAT_SUCCESS);
+		proc_frame_ctx_release(&proc_frame_ctx);
+	}
+
+	cjson_rest= utests_synth_src_get(procs_ctx, null_sink_id);
+	CHECK(cjson_rest!= NULL);
+
+	CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE", synth_src_id)==
+			STAT_SUCCESS);
+	CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE", null_sink_id)==
+			STAT_SUCCESS);
+end:
+	utests_synth_src_procs_close(&procs_ctx);
+	return cjson_rest;
+}
+
+static double utests_synth_src_number(cJSON *cjson_rest, const char *name)
+{
+	cJSON *cjson_aux= cJSON_GetObjectItem(cjson_rest, name);
+
+	CHECK(cjson_aux!= NULL);
+	return cjson_aux!= NULL? cjson_aux->valuedouble: -1;
+}
+
+SUITE(UTESTS_SYNTH_SRC)
+{
+	/* Stamped video frames at maximum rate; no frame is lost, latency is
+	 * measured for every frame.
+	 */
+	TEST(UTESTS_SYNTH_SRC_VIDEO_STAMPED)
+	{
+		cJSON *cjson_rest= NULL, *cjson_latency= NULL;
+
+		cjson_rest= utests_synth_src_run("flag_max_rate=true&pattern=moving",
+				UTESTS_SYNTH_SRC_FRAMES_NUM, 0, PROC_IF_FMT_YUV420P);
+		if(cjson_rest== NULL)
+			return;
+		CHECK(utests_synth_src_number(cjson_rest, "frames")==
+				UTESTS_SYNTH_SRC_FRAMES_NUM);
+		CHECK(utests_synth_src_number(cjson_rest, "bytes")==
+				(double)UTESTS_SYNTH_SRC_FRAMES_NUM* 352* 288* 3/ 2);
+		CHECK(utests_synth_src_number(cjson_rest, "gaps")== 0);
+		CHECK(utests_synth_src_number(cjson_rest, "reorders")== 0);
+		cjson_latency= cJSON_GetObjectItem(cjson_rest, "latency_usecs");
+		CHECK(cjson_latency!= NULL);
+		if(cjson_latency!= NULL)
+			CHECK(utests_synth_src_number(cjson_latency, "count")==
+					UTESTS_SYNTH_SRC_FRAMES_NUM);
+		cJSON_Delete(cjson_rest);
+	}
+
+	/* Stamped noise frames, one of each ten frames is not delivered to the
+	 * sink: gaps are detected using the stamped sequence numbers.
+	 */
+	TEST(UTESTS_SYNTH_SRC_VIDEO_GAPS)
+	{
+		cJSON *cjson_rest= utests_synth_src_run(
+				"{\"flag_max_rate\":true,\"pattern\":\"noise\","
+				"\"width_output\":176,\"height_output\":144}",
+				UTESTS_SYNTH_SRC_FRAMES_NUM+ 1, 10, PROC_IF_FMT_YUV420P);
+		if(cjson_rest== NULL)
+			return;
+		CHECK(utests_synth_src_number(cjson_rest, "frames")==
+				UTESTS_SYNTH_SRC_FRAMES_NUM+ 1-
+				UTESTS_SYNTH_SRC_FRAMES_NUM/ 10);
+		CHECK(utests_synth_src_number(cjson_rest, "gaps")==
+				UTESTS_SYNTH_SRC_FRAMES_NUM/ 10);
+		cJSON_Delete(cjson_rest);
+	}
+
+	/* Non-stamped audio frames at the configured rate: gaps are detected
+	 * using the presentation time-stamps, and no latency is measured.
+	 */
+	TEST(UTESTS_SYNTH_SRC_AUDIO_PTS_GAPS)
+	{
+		cJSON *cjson_rest= NULL, *cjson_latency= NULL;
+
+		cjson_rest= utests_synth_src_run("media_type=audio&flag_stamp=false"
+				"&sample_rate_output=48000&frame_size_output=480",
+				UTESTS_SYNTH_SRC_FRAMES_NUM+ 1, 10, PROC_IF_FMT_S16);
+		if(cjson_rest== NULL)
+			return;
+		CHECK(utests_synth_src_number(cjson_rest, "bytes")==
+				(double)(UTESTS_SYNTH_SRC_FRAMES_NUM+ 1-
+						UTESTS_SYNTH_SRC_FRAMES_NUM/ 10)* 480* 2* 2);
+		CHECK(utests_synth_src_number(cjson_rest, "gaps")==
+				UTESTS_SYNTH_SRC_FRAMES_NUM/ 10);
+		/* 10ms frames: about 100 frames per second */
+		CHECK(utests_synth_src_number(cjson_rest, "fps")> 80);
+		CHECK(utests_synth_src_number(cjson_rest, "fps")< 120);
+		cjson_latency= cJSON_GetObjectItem(cjson_rest, "latency_usecs");
+		CHECK(cjson_latency!= NULL);
+		if(cjson_latency!= NULL)
+			CHECK(utests_synth_src_number(cjson_latency, "count")== 0);
+		cJSON_Delete(cjson_rest);
+	}
+
+	/* Presentation time-stamps are given in microseconds */
+	TEST(UTESTS_SYNTH_SRC_PTS_USECS)
+	{
+		int i, j, synth_src_id;
+		procs_ctx_t *procs_ctx= NULL;
+		proc_frame_ctx_t *proc_frame_ctx= NULL;
+		cJSON *cjson_rest= NULL;
+		const char *settings[2]= {
+			"flag_max_rate=true&frame_rate_output=25",
+			"flag_max_rate=true&media_type=audio&sample_rate_output=48000"
+					"&frame_size_output=480"
+		};
+		const int64_t frame_period_usecs[2]= {40000, 10000};
+
+		procs_ctx= utests_synth_src_procs_open();
+		CHECK(procs_ctx!= NULL);
+		if(procs_ctx== NULL)
+			goto end;
+
+		for(j= 0; j< 2; j++) {
+			synth_src_id= utests_synth_src_post(procs_ctx, "synth_src",
+					settings[j]);
+			CHECK(synth_src_id>= 0);
+			if(synth_src_id< 0)
+				goto end;
+			for(i= 0; i< 10; i++) {
+				CHECK(procs_recv_frame(procs_ctx, synth_src_id,
+						&proc_frame_ctx)== STAT_SUCCESS);
+				if(proc_frame_ctx== NULL)
+					break;
+				CHECK(proc_frame_ctx->pts== (i+ 1)* frame_period_usecs[j]);
+				proc_frame_ctx_release(&proc_frame_ctx);
+			}
+			cjson_rest= utests_synth_src_get(procs_ctx, synth_src_id);
+			CHECK(cjson_rest!= NULL);
+			if(cjson_rest!= NULL) {
+				CHECK(utests_synth_src_number(cjson_rest, "pts_last")>=
+						10* frame_period_usecs[j]);
+				cJSON_Delete(cjson_rest);
+				cjson_rest= NULL;
+			}
+			CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE", synth_src_id)==
+					STAT_SUCCESS);
+		}
+end:
+		utests_synth_src_procs_close(&procs_ctx);
+	}
+
+	/* Settings are validated (and applied only if all of them are valid) */
+	TEST(UTESTS_SYNTH_SRC_SETTINGS)
+	{
+		int synth_src_id;
+		procs_ctx_t *procs_ctx= NULL;
+		cJSON *cjson_rest= NULL, *cjson_settings= NULL, *cjson_aux= NULL;
+
+		procs_ctx= utests_synth_src_procs_open();
+		CHECK(procs_ctx!= NULL);
+		if(procs_ctx== NULL)
+			goto end;
+
+		CHECK(utests_synth_src_post(procs_ctx, "synth_src",
+				"width_output=33")< 0);
+		CHECK(utests_synth_src_post(procs_ctx, "synth_src",
+				"pattern=unknown")< 0);
+
+		synth_src_id= utests_synth_src_post(procs_ctx, "synth_src",
+				"pattern=static&width_output=64&height_output=48");
+		CHECK(synth_src_id>= 0);
+		if(synth_src_id< 0)
+			goto end;
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_PUT", synth_src_id,
+				"width_output=128&height_output=3")!= STAT_SUCCESS);
+
+		cjson_rest= utests_synth_src_get(procs_ctx, synth_src_id);
+		CHECK(cjson_rest!= NULL);
+		if(cjson_rest!= NULL &&
+				(cjson_settings= cJSON_GetObjectItem(cjson_rest, "settings"))!=
+						NULL) {
+			CHECK(utests_synth_src_number(cjson_settings, "width_output")==
+					64);
+			CHECK(utests_synth_src_number(cjson_settings, "height_output")==
+					48);
+			cjson_aux= cJSON_GetObjectItem(cjson_settings, "pattern");
+			CHECK(cjson_aux!= NULL && cjson_aux->valuestring!= NULL &&
+					strcmp(cjson_aux->valuestring, "static")== 0);
+		} else {
+			CHECK(false);
+		}
+
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE", synth_src_id)==
+				STAT_SUCCESS);
+end:
+		if(cjson_rest!= NULL)
+			cJSON_Delete(cjson_rest);
+		utests_synth_src_procs_close(&procs_ctx);
+	}
+}
@@ -21,6 +21,12 @@
  * @file codecs_muxers_loopback.c
  * @brief Complete encoding->multiplexing->demultiplexing->decoding->rendering
  * loopback example.
+ * The example can also be run as a glass-to-glass latency benchmark (option
+ * '-b'): each synthetic frame is stamped with a sequence number (luma
+ * barcode) that is recovered after decoding, and per-stage and end-to-end
+ * latency percentiles and frame loss are reported on exit. Option '-m' runs
+ * the benchmark at maximum speed (no real-time pacing) to measure the
+ * pipeline throughput; option '-d' sets the measuring duration in seconds.
  * @author Rafael Antoniello
  *
  *
@@ -47,6 +53,7 @@
 #include <libmediaprocsutils/stat_codes.h>
 #include <libmediaprocsutils/fifo.h>
 #include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/bench_stats.h>
 #include <libmediaprocs/proc_if.h>
 #include <libmediaprocs/procs.h>
 #include <libmediaprocs/procs_api_http.h>
@@ -56,6 +63,9 @@
 #include <libmediaprocscodecs/ffmpeg_m2v.h>
 #include <libmediaprocscodecs/ffmpeg_mp3.h>
 #include <libmediaprocscodecs/ffmpeg_lhe.h>
+#include <libmediaprocscodecs/synth_src.h>
+#include <libmediaprocscodecs/null_sink.h>
+#include <libmediaprocscodecs/replay_src.h>
 
 /* **** Definitions **** */
 
@@ -68,8 +78,75 @@
 #define REFRESH_EVENT  (SDL_USEREVENT + 1)
 #define BREAK_EVENT  (SDL_USEREVENT + 2)
 
+/* **** Benchmark mode definitions **** */
+
+#define BENCH_DURATION_SECS_DEFAULT 10
+/**
+ * Time elapsed since the first frame is decoded before starting to
+ * register measures (avoids accounting for the session set-up transient).
+ */
+#define BENCH_WARMUP_USECS 1000000
+#define BENCH_SAMPLES_MAX 100000
+#define BENCH_STAMPS_RING_SIZE 1024
+
+/**
+ * The frame sequence number is stamped as a luma barcode at the top of the
+ * picture: 'BENCH_BARCODE_BITS' blocks of 'BENCH_BARCODE_BLOCK' x
+ * 'BENCH_BARCODE_BLOCK' pixels (macro-block aligned, so the code survives
+ * lossy compression) followed by the same number of blocks with the bits
+ * complemented (used to validate the reading).
+ */
+#define BENCH_BARCODE_BITS 32
+#define BENCH_BARCODE_BITS_PER_ROW 16
+#define BENCH_BARCODE_BLOCK 16
+#define BENCH_BARCODE_LUMA_LOW 16
+#define BENCH_BARCODE_LUMA_HIGH 235
+
 static volatile int flag_app_exit= 0;
 
+/**
+ * Benchmark time-stamp: monotonic time [usecs] at which the frame with the
+ * given identifier crossed a stage boundary.
+ */
+typedef struct bench_stamp_s {
+	int64_t id;
+	int64_t usecs;
+} bench_stamp_t;
+
+/**
+ * Glass-to-glass latency benchmark context.
+ * Frames are time-stamped at every stage boundary of the loopback pipeline:
+ * - 'send': raw frame sent to the encoder (producer thread);
+ * - 'enc': encoded frame received from the encoder (multiplexer thread);
+ * - 'dmux': frame received from the de-multiplexer (de-multiplexer thread);
+ * - decoded frame received from the decoder (consumer thread).
+ * Raw and encoded frames are identified by the sequence number (derived
+ * from the presentation time-stamp, which is kept by the encoder).
+ * De-multiplexed frames are identified by the de-multiplexer PTS (kept by
+ * the decoder). Decoded frames carry the sequence number in the barcode.
+ */
+typedef struct bench_ctx_s {
+	pthread_mutex_t mutex;
+	int flag_max_speed;
+	int duration_secs;
+	int64_t frame_period_usec;
+	bench_stamp_t send_stamps[BENCH_STAMPS_RING_SIZE];
+	bench_stamp_t enc_stamps[BENCH_STAMPS_RING_SIZE];
+	bench_stamp_t dmux_stamps[BENCH_STAMPS_RING_SIZE];
+	int64_t first_decoded_usecs;
+	int64_t last_decoded_usecs;
+	int flag_seq_started;
+	uint32_t seq_next;
+	uint64_t frames_sent;
+	uint64_t frames_decoded;
+	uint64_t frames_lost;
+	uint64_t frames_reordered;
+	uint64_t barcode_errors;
+	bench_stats_ctx_t *bench_stats_ctx_e2e;
+	bench_stats_ctx_t *bench_stats_ctx_enc;
+	bench_stats_ctx_t *bench_stats_ctx_transport;
+	bench_stats_ctx_t *bench_stats_ctx_dec;
+} bench_ctx_t;
 
 /**
  * Common data passed to all the threads launched by this application.
@@ -82,14 +159,248 @@ typedef struct thr_ctx_s {
 	int elem_strem_id_video_server;
 	const char *mime_setting_video;
 	procs_ctx_t *procs_ctx;
+	/**
+	 * Benchmark context; NULL if not running in benchmark mode.
+	 */
+	bench_ctx_t *bench_ctx;
 } thr_ctx_t;
 
-static void prepare_and_send_raw_video_data(procs_ctx_t *procs_ctx,
-		int enc_proc_id, volatile int *ref_flag_exit)
+static bench_ctx_t* bench_ctx_open(int flag_max_speed, int duration_secs)
+{
+	int i;
+	bench_ctx_t *bench_ctx= NULL;
+
+	bench_ctx= (bench_ctx_t*)calloc(1, sizeof(bench_ctx_t));
+	if(bench_ctx== NULL) {
+		fprintf(stderr, "Could not allocate benchmark context\n");
+		exit(-1);
+	}
+	pthread_mutex_init(&bench_ctx->mutex, NULL);
+	bench_ctx->flag_max_speed= flag_max_speed;
+	bench_ctx->duration_secs= duration_secs;
+	for(i= 0; i< BENCH_STAMPS_RING_SIZE; i++) {
+		bench_ctx->send_stamps[i].id= -1;
+		bench_ctx->enc_stamps[i].id= -1;
+		bench_ctx->dmux_stamps[i].id= -1;
+	}
+	bench_ctx->bench_stats_ctx_e2e= bench_stats_open(BENCH_SAMPLES_MAX);
+	bench_ctx->bench_stats_ctx_enc= bench_stats_open(BENCH_SAMPLES_MAX);
+	bench_ctx->bench_stats_ctx_transport= bench_stats_open(BENCH_SAMPLES_MAX);
+	bench_ctx->bench_stats_ctx_dec= bench_stats_open(BENCH_SAMPLES_MAX);
+	if(bench_ctx->bench_stats_ctx_e2e== NULL ||
+			bench_ctx->bench_stats_ctx_enc== NULL ||
+			bench_ctx->bench_stats_ctx_transport== NULL ||
+			bench_ctx->bench_stats_ctx_dec== NULL) {
+		fprintf(stderr, "Could not allocate benchmark statistics\n");
+		exit(-1);
+	}
+	return bench_ctx;
+}
+
+static void bench_ctx_close(bench_ctx_t **ref_bench_ctx)
+{
+	bench_ctx_t *bench_ctx;
+
+	if(ref_bench_ctx== NULL || (bench_ctx= *ref_bench_ctx)== NULL)
+		return;
+
+	bench_stats_close(&bench_ctx->bench_stats_ctx_e2e);
+	bench_stats_close(&bench_ctx->bench_stats_ctx_enc);
+	bench_stats_close(&bench_ctx->bench_stats_ctx_transport);
+	bench_stats_close(&bench_ctx->bench_stats_ctx_dec);
+	pthread_mutex_destroy(&bench_ctx->mutex);
+	free(bench_ctx);
+	*ref_bench_ctx= NULL;
+}
+
+/**
+ * Register the current time as the stage time-stamp of the frame with the
+ * given identifier. Rings are indexed by the identifier; an overwritten
+ * stamp just drops the corresponding latency sample.
+ */
+static void bench_stamp_put(bench_ctx_t *bench_ctx, bench_stamp_t *ring,
+		int64_t id)
+{
+	bench_stamp_t *bench_stamp= &ring[(uint64_t)id% BENCH_STAMPS_RING_SIZE];
+	int64_t now_usecs= bench_now_usecs();
+
+	pthread_mutex_lock(&bench_ctx->mutex);
+	bench_stamp->id= id;
+	bench_stamp->usecs= now_usecs;
+	pthread_mutex_unlock(&bench_ctx->mutex);
+}
+
+/**
+ * Get the stage time-stamp of the frame with the given identifier
+ * (benchmark context mutex must be locked).
+ * @return Time-stamp in microseconds, or -1 if not found.
+ */
+static int64_t bench_stamp_get_locked(bench_stamp_t *ring, int64_t id)
+{
+	bench_stamp_t *bench_stamp= &ring[(uint64_t)id% BENCH_STAMPS_RING_SIZE];
+
+	return bench_stamp->id== id? bench_stamp->usecs: -1;
+}
+
+static void bench_barcode_write(uint8_t *p_data_y, int linesize, uint32_t seq)
+{
+	int bit, y;
+
+	for(bit= 0; bit< BENCH_BARCODE_BITS* 2; bit++) {
+		int x0= (bit% BENCH_BARCODE_BITS_PER_ROW)* BENCH_BARCODE_BLOCK;
+		int y0= (bit/ BENCH_BARCODE_BITS_PER_ROW)* BENCH_BARCODE_BLOCK;
+		int val= (seq>> (bit% BENCH_BARCODE_BITS))& 1;
+		if(bit>= BENCH_BARCODE_BITS)
+			val^= 1; // complemented copy
+		for(y= y0; y< y0+ BENCH_BARCODE_BLOCK; y++)
+			memset(&p_data_y[y* linesize+ x0], val? BENCH_BARCODE_LUMA_HIGH:
+					BENCH_BARCODE_LUMA_LOW, BENCH_BARCODE_BLOCK);
+	}
+}
+
+/**
+ * Read back the sequence number stamped by 'bench_barcode_write()'.
+ * Each bit is decided by averaging the inner half of its block.
+ * @return STAT_SUCCESS if the code was read and validated, STAT_ERROR
+ * otherwise.
+ */
+static int bench_barcode_read(const uint8_t *p_data_y, int linesize,
+		int width, int height, uint32_t *ref_seq)
+{
+	int bit, x, y;
+	uint32_t seq= 0;
+	const int b0= BENCH_BARCODE_BLOCK/ 4, b1= (BENCH_BARCODE_BLOCK* 3)/ 4;
+
+	if(p_data_y== NULL ||
+			width< BENCH_BARCODE_BITS_PER_ROW* BENCH_BARCODE_BLOCK ||
+			height< ((BENCH_BARCODE_BITS* 2)/ BENCH_BARCODE_BITS_PER_ROW)*
+			BENCH_BARCODE_BLOCK)
+		return STAT_ERROR;
+
+	for(bit= 0; bit< BENCH_BARCODE_BITS* 2; bit++) {
+		int x0= (bit% BENCH_BARCODE_BITS_PER_ROW)* BENCH_BARCODE_BLOCK;
+		int y0= (bit/ BENCH_BARCODE_BITS_PER_ROW)* BENCH_BARCODE_BLOCK;
+		int sum= 0, val;
+		for(y= y0+ b0; y< y0+ b1; y++)
+			for(x= x0+ b0; x< x0+ b1; x++)
+				sum+= p_data_y[y* linesize+ x];
+		val= sum/ ((b1- b0)* (b1- b0))> (BENCH_BARCODE_LUMA_LOW+
+				BENCH_BARCODE_LUMA_HIGH)/ 2;
+		if(bit< BENCH_BARCODE_BITS)
+			seq|= (uint32_t)val<< bit;
+		else if(val== (int)((seq>> (bit- BENCH_BARCODE_BITS))& 1))
+			return STAT_ERROR; // complemented copy does not match
+	}
+	*ref_seq= seq;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Register the latencies of a decoded frame and account for frame loss.
+ * Frame loss is detected as gaps in the sequence numbers (frames arriving
+ * after a gap was accounted are registered as re-ordered).
+ */
+static void bench_frame_register(bench_ctx_t *bench_ctx, uint32_t seq,
+		int64_t pts_dmux, int64_t now_usecs)
+{
+	int64_t send_usecs, enc_usecs, dmux_usecs;
+
+	pthread_mutex_lock(&bench_ctx->mutex);
+
+	if(bench_ctx->first_decoded_usecs== 0)
+		bench_ctx->first_decoded_usecs= now_usecs;
+	if(now_usecs- bench_ctx->first_decoded_usecs< BENCH_WARMUP_USECS) {
+		bench_ctx->seq_next= seq+ 1;
+		goto end;
+	}
+
+	/* Frame loss */
+	if(!bench_ctx->flag_seq_started) {
+		bench_ctx->flag_seq_started= 1;
+		bench_ctx->seq_next= seq+ 1;
+	} else if((int32_t)(seq- bench_ctx->seq_next)>= 0) {
+		bench_ctx->frames_lost+= seq- bench_ctx->seq_next;
+		bench_ctx->seq_next= seq+ 1;
+	} else {
+		bench_ctx->frames_reordered++;
+		if(bench_ctx->frames_lost> 0)
+			bench_ctx->frames_lost--;
+	}
+	bench_ctx->frames_decoded++;
+	bench_ctx->last_decoded_usecs= now_usecs;
+
+	/* Latencies */
+	send_usecs= bench_stamp_get_locked(bench_ctx->send_stamps, seq);
+	enc_usecs= bench_stamp_get_locked(bench_ctx->enc_stamps, seq);
+	dmux_usecs= bench_stamp_get_locked(bench_ctx->dmux_stamps, pts_dmux);
+	if(send_usecs>= 0)
+		bench_stats_add(bench_ctx->bench_stats_ctx_e2e, now_usecs- send_usecs);
+	if(send_usecs>= 0 && enc_usecs>= 0)
+		bench_stats_add(bench_ctx->bench_stats_ctx_enc, enc_usecs- send_usecs);
+	if(enc_usecs>= 0 && dmux_usecs>= 0)
+		bench_stats_add(bench_ctx->bench_stats_ctx_transport,
+				dmux_usecs- enc_usecs);
+	if(dmux_usecs>= 0)
+		bench_stats_add(bench_ctx->bench_stats_ctx_dec, now_usecs- dmux_usecs);
+
+end:
+	pthread_mutex_unlock(&bench_ctx->mutex);
+}
+
+static void bench_report_stats(const char *name,
+		bench_stats_ctx_t *bench_stats_ctx, int flag_last)
+{
+	bench_stats_summary_t bench_stats_summary;
+
+	bench_stats_summary_get(bench_stats_ctx, &bench_stats_summary);
+	printf("\"%s\":{\"count\":%"PRIu64",\"min\":%"PRId64",\"mean\":%.1f,"
+			"\"p50\":%"PRId64",\"p90\":%"PRId64",\"p99\":%"PRId64","
+			"\"p999\":%"PRId64",\"max\":%"PRId64"}%s", name,
+			bench_stats_summary.count, bench_stats_summary.min,
+			bench_stats_summary.mean, bench_stats_summary.p50,
+			bench_stats_summary.p90, bench_stats_summary.p99,
+			bench_stats_summary.p999, bench_stats_summary.max,
+			flag_last? "": ",");
+}
+
+/**
+ * Print the benchmark results as a JSON object (latencies in microseconds).
+ */
+static void bench_report(bench_ctx_t *bench_ctx)
+{
+	double elapsed_secs, fps= 0;
+
+	pthread_mutex_lock(&bench_ctx->mutex);
+	elapsed_secs= (double)(bench_ctx->last_decoded_usecs-
+			bench_ctx->first_decoded_usecs- BENCH_WARMUP_USECS)/ 1000000.0;
+	if(bench_ctx->frames_decoded> 0 && elapsed_secs> 0)
+		fps= (double)bench_ctx->frames_decoded/ elapsed_secs;
+	printf("{\"mode\":\"%s\",\"duration_secs\":%.3f,"
+			"\"frames_sent\":%"PRIu64",\"frames_decoded\":%"PRIu64","
+			"\"frames_lost\":%"PRIu64",\"frames_reordered\":%"PRIu64","
+			"\"barcode_errors\":%"PRIu64",\"fps\":%.2f,"
+			"\"latency_usecs\":{",
+			bench_ctx->flag_max_speed? "max_speed": "paced",
+			elapsed_secs> 0? elapsed_secs: 0, bench_ctx->frames_sent,
+			bench_ctx->frames_decoded, bench_ctx->frames_lost,
+			bench_ctx->frames_reordered, bench_ctx->barcode_errors, fps);
+	pthread_mutex_unlock(&bench_ctx->mutex);
+	bench_report_stats("end_to_end", bench_ctx->bench_stats_ctx_e2e, 0);
+	bench_report_stats("encode", bench_ctx->bench_stats_ctx_enc, 0);
+	bench_report_stats("transport", bench_ctx->bench_stats_ctx_transport, 0);
+	bench_report_stats("decode", bench_ctx->bench_stats_ctx_dec, 1);
+	printf("}}\n");
+	fflush(stdout);
+}
+
+static void prepare_and_send_raw_video_data(thr_ctx_t *thr_ctx)
 {
     uint8_t *p_data_y, *p_data_cr, *p_data_cb;
-    int64_t frame_period_usec, frame_period_90KHz;
+    int64_t frame_period_usec;
 	int x, y;
+	uint32_t seq;
+	procs_ctx_t *procs_ctx= thr_ctx->procs_ctx;
+	bench_ctx_t *bench_ctx= thr_ctx->bench_ctx;
     const int width= atoi(VIDEO_WIDTH), height= atoi(VIDEO_HEIGHT);
     uint8_t *buf= NULL;
     proc_frame_ctx_t proc_frame_ctx= {0};
@@ -119,12 +430,16 @@ static void prepare_and_send_raw_video_data(procs_ctx_t *procs_ctx,
     p_data_cr= (uint8_t*)proc_frame_ctx.p_data[1];
     p_data_cb= (uint8_t*)proc_frame_ctx.p_data[2];
     frame_period_usec= 1000000/ atoi(fps_cstr); //usecs
-    frame_period_90KHz= (frame_period_usec/1000/*[msec]*/)*
-    		90/*[ticks/msec]*/; //ticks
-    for(; *ref_flag_exit== 0;) {
+	if(bench_ctx!= NULL) {
+		pthread_mutex_lock(&bench_ctx->mutex);
+		bench_ctx->frame_period_usec= frame_period_usec;
+		pthread_mutex_unlock(&bench_ctx->mutex);
+	}
+    for(seq= 0; thr_ctx->flag_exit== 0; seq++) {
 
-        usleep((unsigned int)frame_period_usec); //simulate real-time FPS
-        proc_frame_ctx.pts+= frame_period_90KHz;
+        if(bench_ctx== NULL || !bench_ctx->flag_max_speed)
+        	usleep((unsigned int)frame_period_usec); //simulate real-time FPS
+        proc_frame_ctx.pts+= frame_period_usec; // (seq+ 1)* period [usecs]
 
         /* Y */
         for(y= 0; y< height; y++)
@@ -141,8 +456,17 @@ static void prepare_and_send_raw_video_data(procs_ctx_t *procs_ctx,
             }
         }
 
+        /* Stamp sequence number if benchmarking */
+        if(bench_ctx!= NULL) {
+        	bench_barcode_write(p_data_y, proc_frame_ctx.linesize[0], seq);
+        	bench_stamp_put(bench_ctx, bench_ctx->send_stamps, seq);
+        	pthread_mutex_lock(&bench_ctx->mutex);
+        	bench_ctx->frames_sent++;
+        	pthread_mutex_unlock(&bench_ctx->mutex);
+        }
+
         /* Encode the image */
-        procs_send_frame(procs_ctx, enc_proc_id, &proc_frame_ctx);
+        procs_send_frame(procs_ctx, thr_ctx->enc_proc_id, &proc_frame_ctx);
     }
 
 	if(buf!= NULL) {
@@ -166,8 +490,7 @@ static void* producer_thr_video(void *t)
 
 	/* Producer loop */
 	while(thr_ctx->flag_exit== 0) {
-		prepare_and_send_raw_video_data(thr_ctx->procs_ctx,
-				thr_ctx->enc_proc_id, &thr_ctx->flag_exit);
+		prepare_and_send_raw_video_data(thr_ctx);
 	}
 
 	return NULL;
@@ -210,6 +533,17 @@ static void* mux_thr(void *t)
 		 */
 		if(proc_frame_ctx== NULL)
 			continue;
+		if(thr_ctx->bench_ctx!= NULL) {
+			/* Sequence number is recovered from the PTS (set by producer) */
+			bench_ctx_t *bench_ctx= thr_ctx->bench_ctx;
+			int64_t frame_period_usec;
+			pthread_mutex_lock(&bench_ctx->mutex);
+			frame_period_usec= bench_ctx->frame_period_usec;
+			pthread_mutex_unlock(&bench_ctx->mutex);
+			if(frame_period_usec> 0 && proc_frame_ctx->pts> 0)
+				bench_stamp_put(bench_ctx, bench_ctx->enc_stamps,
+						proc_frame_ctx->pts/ frame_period_usec- 1);
+		}
 		proc_frame_ctx->es_id= thr_ctx->elem_strem_id_video_server;
 		ret_code= procs_send_frame(thr_ctx->procs_ctx, thr_ctx->mux_proc_id,
 				proc_frame_ctx);
@@ -262,6 +596,9 @@ static void* dmux_thr(void *t)
 		fprintf(stderr, "Error at line: %d\n", __LINE__);
 		exit(-1);
 	}
+	if(thr_ctx->bench_ctx!= NULL)
+		bench_stamp_put(thr_ctx->bench_ctx, thr_ctx->bench_ctx->dmux_stamps,
+				proc_frame_ctx->pts);
 
 	/* Parse elementary streams Id's */
 	ret_code= procs_opt(thr_ctx->procs_ctx, "PROCS_ID_GET",
@@ -341,6 +678,9 @@ static void* dmux_thr(void *t)
 		/* Send received encoded frame to decoder */
 		if(proc_frame_ctx== NULL)
 			continue;
+		if(thr_ctx->bench_ctx!= NULL)
+			bench_stamp_put(thr_ctx->bench_ctx,
+					thr_ctx->bench_ctx->dmux_stamps, proc_frame_ctx->pts);
 		ret_code= procs_send_frame(thr_ctx->procs_ctx, thr_ctx->dec_proc_id,
 				proc_frame_ctx);
 		if(ret_code!= STAT_SUCCESS) {
@@ -488,6 +828,70 @@ static void* consumer_thr_video(void *t)
 	return NULL;
 }
 
+/**
+ * Benchmark mode consumer thread: instead of rendering, reads back the
+ * sequence number stamped in each decoded frame and registers latencies.
+ * Signals the application to finalize when the measuring time is elapsed.
+ */
+static void* consumer_thr_bench(void *t)
+{
+	thr_ctx_t *thr_ctx= (thr_ctx_t*)t;
+	bench_ctx_t *bench_ctx;
+	proc_frame_ctx_t *proc_frame_ctx= NULL;
+
+	/* Check argument */
+	if(thr_ctx== NULL || (bench_ctx= thr_ctx->bench_ctx)== NULL) {
+		fprintf(stderr, "Bad argument '%s'\n", __FUNCTION__);
+		exit(-1);
+	}
+
+	while(thr_ctx->flag_exit== 0) {
+		int ret_code;
+		uint32_t seq;
+		int64_t now_usecs, first_decoded_usecs;
+
+		/* Receive decoded frame */
+		if(proc_frame_ctx!= NULL)
+			proc_frame_ctx_release(&proc_frame_ctx);
+		ret_code= procs_recv_frame(thr_ctx->procs_ctx, thr_ctx->dec_proc_id,
+				&proc_frame_ctx);
+		if(ret_code!= STAT_SUCCESS) {
+			if(ret_code== STAT_EAGAIN)
+				schedule(); // Avoid closed loops
+			else
+				fprintf(stderr, "Error while receiving decoded frame'\n");
+			continue;
+		}
+		if(proc_frame_ctx== NULL)
+			continue;
+		now_usecs= bench_now_usecs();
+
+		/* Recover sequence number and register measures */
+		ret_code= bench_barcode_read(proc_frame_ctx->p_data[0],
+				proc_frame_ctx->linesize[0], proc_frame_ctx->width[0],
+				proc_frame_ctx->height[0], &seq);
+		if(ret_code!= STAT_SUCCESS) {
+			pthread_mutex_lock(&bench_ctx->mutex);
+			bench_ctx->barcode_errors++;
+			pthread_mutex_unlock(&bench_ctx->mutex);
+			continue;
+		}
+		bench_frame_register(bench_ctx, seq, proc_frame_ctx->pts, now_usecs);
+
+		/* Check measuring time */
+		pthread_mutex_lock(&bench_ctx->mutex);
+		first_decoded_usecs= bench_ctx->first_decoded_usecs;
+		pthread_mutex_unlock(&bench_ctx->mutex);
+		if(now_usecs- first_decoded_usecs>= BENCH_WARMUP_USECS+
+				(int64_t)bench_ctx->duration_secs* 1000000)
+			flag_app_exit= 1;
+	}
+
+	if(proc_frame_ctx!= NULL)
+		proc_frame_ctx_release(&proc_frame_ctx);
+	return NULL;
+}
+
 static void http_event_handler(struct mg_connection *c, int ev, void *p)
 {
 #define URI_MAX 4096
@@ -496,10 +900,13 @@ static void http_event_handler(struct mg_connection *c, int ev, void *p)
 
 	if(ev== MG_EV_HTTP_REQUEST) {
 		register size_t uri_len= 0, method_len= 0, qs_len= 0, body_len= 0;
+		int end_code;
 		const char *uri_p, *method_p, *qs_p, *body_p;
 		struct http_message *hm= (struct http_message*)p;
+		struct mg_str *if_none_match_hdr;
 		char *url_str= NULL, *method_str= NULL, *str_response= NULL,
-				*qstring_str= NULL, *body_str= NULL;
+				*qstring_str= NULL, *body_str= NULL, *if_none_match_str= NULL,
+				*etag_str= NULL;
 		thr_ctx_t *thr_ctx= (thr_ctx_t*)c->user_data;
 
 		if((uri_p= hm->uri.p)!= NULL && (uri_len= hm->uri.len)> 0 &&
@@ -527,15 +934,39 @@ static void http_event_handler(struct mg_connection *c, int ev, void *p)
 				memcpy(body_str, body_p, body_len);
 		}
 
+		if((if_none_match_hdr= mg_get_http_header(hm, "If-None-Match"))!=
+				NULL && if_none_match_hdr->len> 0 &&
+				if_none_match_hdr->len< URI_MAX) {
+			if_none_match_str= (char*)calloc(1, if_none_match_hdr->len+ 1);
+			if(if_none_match_str!= NULL)
+				memcpy(if_none_match_str, if_none_match_hdr->p,
+						if_none_match_hdr->len);
+		}
+
 		/* Process HTTP request */
+		end_code= STAT_ERROR;
 		if(url_str!= NULL && method_str!= NULL)
-			procs_api_http_req_handler(thr_ctx->procs_ctx, url_str,
-					qstring_str, method_str, body_str, body_len, &str_response);
+			end_code= procs_api_http_req_handler_etag(thr_ctx->procs_ctx,
+					url_str, qstring_str, method_str, if_none_match_str,
+					body_str, body_len, &str_response, &etag_str);
 		/* Send response */
-		if(str_response!= NULL && strlen(str_response)> 0) {
+		if(end_code== STAT_NOTMODIFIED && etag_str!= NULL) {
+			mg_printf(c, "%s", "HTTP/1.1 304 Not Modified\r\n");
+			mg_printf(c, "ETag: %s\r\n", etag_str);
+			mg_printf(c, "Content-Length: 0\r\n\r\n");
+		} else if(str_response!= NULL && strlen(str_response)> 0) {
 			//printf("str_response: %s (len: %d)\n", str_response,
 			//		(int)strlen(str_response)); //comment-me
 			mg_printf(c, "%s", "HTTP/1.1 200 OK\r\n");
+			if(strstr(url_str, "/procs/metrics")!= NULL)
+				mg_printf(c, "%s", "Content-Type: text/plain; version=0.0.4"
+						"\r\n");
+			else if(strstr(url_str, "/procs/trace.json")!= NULL)
+				mg_printf(c, "%s", "Content-Type: application/json\r\n"
+						"Content-Disposition: attachment; "
+						"filename=\"trace.json\"\r\n");
+			if(etag_str!= NULL)
+				mg_printf(c, "ETag: %s\r\n", etag_str);
 			mg_printf(c, "Content-Length: %d\r\n", (int)strlen(str_response));
 			mg_printf(c, "\r\n");
 			mg_printf(c, "%s", str_response);
@@ -553,6 +984,10 @@ static void http_event_handler(struct mg_connection *c, int ev, void *p)
 			free(qstring_str);
 		if(body_str!= NULL)
 			free(body_str);
+		if(if_none_match_str!= NULL)
+			free(if_none_match_str);
+		if(etag_str!= NULL)
+			free(etag_str);
 	} else if(ev== MG_EV_RECV) {
 		mg_printf(c, "%s", "HTTP/1.1 202 ACCEPTED\r\nContent-Length: 0\r\n");
 	} else if(ev== MG_EV_SEND) {
@@ -639,12 +1074,23 @@ static void procs_post(procs_ctx_t *procs_ctx, const char *proc_name,
 	cJSON_Delete(cjson_rest); cjson_rest= NULL;
 }
 
+static void usage(const char *prog_name)
+{
+	fprintf(stderr, "Usage: %s [-b] [-m] [-d duration_secs]\n"
+			"  -b  glass-to-glass latency benchmark mode (no rendering)\n"
+			"  -m  benchmark at maximum speed (no real-time pacing)\n"
+			"  -d  benchmark measuring duration in seconds (default %d)\n",
+			prog_name, BENCH_DURATION_SECS_DEFAULT);
+}
+
 int main(int argc, char* argv[])
 {
 	sigset_t set;
 	pthread_t producer_thread, mux_thread, dmux_thread, consumer_thread;
 	int ret_code, enc_proc_id= -1, dec_proc_id= -1, mux_proc_id= -1,
 			dmux_proc_id= -1, elem_strem_id_video_server= -1;
+	int opt, flag_bench= 0, flag_max_speed= 0,
+			duration_secs= BENCH_DURATION_SECS_DEFAULT;
 	procs_ctx_t *procs_ctx= NULL;
 	char *rest_str= NULL, *settings_str= NULL;
 	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
@@ -671,6 +1117,28 @@ int main(int argc, char* argv[])
     const proc_if_t *proc_if_mux= &proc_if_live555_rtsp_mux;
     const proc_if_t *proc_if_dmux= &proc_if_live555_rtsp_dmux;
 
+	/* Parse command-line options */
+	while((opt= getopt(argc, argv, "bmd:"))!= -1) {
+		switch(opt) {
+		case 'b':
+			flag_bench= 1;
+			break;
+		case 'm':
+			flag_bench= 1;
+			flag_max_speed= 1;
+			break;
+		case 'd':
+			if((duration_secs= atoi(optarg))<= 0) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			usage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	/* Set SIGNAL handlers to this process */
 	sigfillset(&set);
 	sigdelset(&set, SIGINT);
@@ -732,6 +1200,21 @@ int main(int argc, char* argv[])
 		fprintf(stderr, "Error at line: %d\n", __LINE__);
 		exit(-1);
 	}
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_synth_src)!=
+			STAT_SUCCESS) {
+		fprintf(stderr, "Error at line: %d\n", __LINE__);
+		exit(-1);
+	}
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_null_sink)!=
+			STAT_SUCCESS) {
+		fprintf(stderr, "Error at line: %d\n", __LINE__);
+		exit(-1);
+	}
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_replay_src)!=
+			STAT_SUCCESS) {
+		fprintf(stderr, "Error at line: %d\n", __LINE__);
+		exit(-1);
+	}
 
 	/* Get PROCS module's instance */
 	if((procs_ctx= procs_open(NULL, 16, NULL, NULL))== NULL) {
@@ -786,6 +1269,8 @@ int main(int argc, char* argv[])
     thr_ctx.mime_setting_video= mime_setting;
     thr_ctx.dmux_proc_id= dmux_proc_id;
     thr_ctx.procs_ctx= procs_ctx;
+    thr_ctx.bench_ctx= flag_bench? bench_ctx_open(flag_max_speed,
+    		duration_secs): NULL;
 	ret_code= pthread_create(&producer_thread, NULL, producer_thr_video,
 			&thr_ctx);
 	if(ret_code!= 0) {
@@ -802,8 +1287,8 @@ int main(int argc, char* argv[])
 		fprintf(stderr, "Error at line: %d\n", __LINE__);
 		exit(-1);
 	}
-	ret_code= pthread_create(&consumer_thread, NULL, consumer_thr_video,
-			&thr_ctx);
+	ret_code= pthread_create(&consumer_thread, NULL, thr_ctx.bench_ctx!=
+			NULL? consumer_thr_bench: consumer_thr_video, &thr_ctx);
 	if(ret_code!= 0) {
 		fprintf(stderr, "Error at line: %d\n", __LINE__);
 		exit(-1);
@@ -842,6 +1327,11 @@ int main(int argc, char* argv[])
 	pthread_join(dmux_thread, NULL);
 	pthread_join(consumer_thread, NULL);
 
+	if(thr_ctx.bench_ctx!= NULL) {
+		bench_report(thr_ctx.bench_ctx);
+		bench_ctx_close(&thr_ctx.bench_ctx);
+	}
+
 	if(procs_ctx!= NULL)
 		procs_close(&procs_ctx);
 	procs_module_close();
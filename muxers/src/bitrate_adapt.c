@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bitrate_adapt.c
+ * @author Rafael Antoniello
+ */
+
+#include "bitrate_adapt.h"
+
+#include <stdint.h>
+
+unsigned int bitrate_adapt_aimd(unsigned int bitrate, unsigned int bitrate_min,
+		unsigned int bitrate_max, unsigned int loss_high,
+		unsigned int loss_low, double loss_percent, int *ref_clear_reports)
+{
+	uint64_t bitrate_new= bitrate;
+
+	if(bitrate_min> bitrate_max)
+		bitrate_min= bitrate_max;
+
+	if(loss_percent>= loss_high) {
+		*ref_clear_reports= 0;
+		bitrate_new= (bitrate_new* BITRATE_ADAPT_DECREASE_PERCENT)/ 100;
+	} else if(loss_percent<= loss_low) {
+		if(++*ref_clear_reports>= BITRATE_ADAPT_INCREASE_REPORTS) {
+			*ref_clear_reports= 0;
+			bitrate_new+= ((uint64_t)bitrate_max*
+					BITRATE_ADAPT_INCREASE_PERCENT)/ 100;
+		}
+	} else {
+		*ref_clear_reports= 0;
+	}
+
+	if(bitrate_new< bitrate_min)
+		bitrate_new= bitrate_min;
+	if(bitrate_new> bitrate_max)
+		bitrate_new= bitrate_max;
+	return (unsigned int)bitrate_new;
+}
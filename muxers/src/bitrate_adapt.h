@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bitrate_adapt.h
+ * @brief Encoder bit-rate adaptation law: additive-increase/
+ * multiplicative-decrease (AIMD) driven by the loss reported by the
+ * receivers.
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_SRC_BITRATE_ADAPT_H_
+#define MEDIAPROCESSORS_SRC_BITRATE_ADAPT_H_
+
+/* **** Definitions **** */
+
+/**
+ * Bit-rate adaptation law parameters:
+ * - multiplicative decrease factor (percentage of the current bit-rate),
+ * applied on each congested report;
+ * - additive increase step (percentage of the maximum bit-rate), applied
+ * after BITRATE_ADAPT_INCREASE_REPORTS consecutive clear reports.
+ */
+#define BITRATE_ADAPT_DECREASE_PERCENT 85
+#define BITRATE_ADAPT_INCREASE_PERCENT 5
+#define BITRATE_ADAPT_INCREASE_REPORTS 3
+
+/* **** Prototypes **** */
+
+/**
+ * Additive-increase/multiplicative-decrease (AIMD) bit-rate law.
+ * A loss at or above the high threshold decreases the bit-rate
+ * multiplicatively at once; the bit-rate is increased additively only after
+ * a number of consecutive reports at or below the low threshold, and held
+ * in-between (hysteresis). The result is bounded to the given range.
+ * @param bitrate Current bit-rate, in bits per second.
+ * @param bitrate_min Lower bit-rate bound (bits per second); bounded to
+ * 'bitrate_max' if greater.
+ * @param bitrate_max Upper bit-rate bound (bits per second).
+ * @param loss_high Loss percentage threshold for decreasing the bit-rate.
+ * @param loss_low Loss percentage threshold for increasing the bit-rate.
+ * @param loss_percent Worst loss percentage reported.
+ * @param ref_clear_reports Reference to the consecutive clear reports
+ * counter (state kept by the caller between calls; initially zero).
+ * @return New bit-rate, in bits per second.
+ */
+unsigned int bitrate_adapt_aimd(unsigned int bitrate, unsigned int bitrate_min,
+		unsigned int bitrate_max, unsigned int loss_high,
+		unsigned int loss_low, double loss_percent, int *ref_clear_reports);
+
+#endif /* MEDIAPROCESSORS_SRC_BITRATE_ADAPT_H_ */
@@ -0,0 +1,793 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file live555_event_loop.cpp
+ * @author Rafael Antoniello
+ */
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <map>
+
+extern "C" {
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+}
+
+#include <BasicUsageEnvironment/BasicUsageEnvironment.hh>
+
+#include "live555_event_loop.h"
+
+/* **** Definitions **** */
+
+/**
+ * Maximum number of event-loop threads that can be configured.
+ */
+#define LIVE555_EVENT_LOOP_POOL_MAX 256
+
+/**
+ * Maximum number of I/O events retrieved by a single 'epoll_wait()' call.
+ */
+#define EPOLL_EVENTS_MAX 64
+
+/**
+ * Maximum time a single scheduler step may wait (1 second) [microseconds];
+ * very large 'epoll_wait()' time-out values are not needed (we are woken up
+ * on demand).
+ */
+#define EPOLL_WAIT_USECS_MAX ((int64_t)1000000)
+
+/**
+ * Live555's task scheduler using 'epoll()' instead of 'select()'.
+ * This scheduler also implements its own event-trigger mechanism: the number
+ * of event triggers is not limited (Live555's 'BasicTaskScheduler' only
+ * supports 32 triggers per scheduler, which is not enough when sharing the
+ * scheduler among many streams), and triggering an event wakes up the
+ * event-loop immediately (using an 'eventfd' registered in the epoll set)
+ * instead of relying on a periodic scheduler "tick".
+ */
+class EpollTaskScheduler: public BasicTaskScheduler0
+{
+public:
+	static EpollTaskScheduler* createNew(log_ctx_t *log_ctx);
+	virtual ~EpollTaskScheduler();
+
+	/* Redefined virtual functions (thread-safe) */
+	virtual EventTriggerId createEventTrigger(TaskFunc *eventHandlerProc);
+	virtual void deleteEventTrigger(EventTriggerId eventTriggerId);
+	virtual void triggerEvent(EventTriggerId eventTriggerId,
+			void *clientData= NULL);
+
+protected:
+	EpollTaskScheduler(int epoll_fd, int event_fd, log_ctx_t *log_ctx);
+
+	/* Redefined virtual functions (event-loop thread only) */
+	virtual void SingleStep(unsigned maxDelayTime);
+	virtual void setBackgroundHandling(int socketNum, int conditionSet,
+			BackgroundHandlerProc *handlerProc, void *clientData);
+	virtual void moveSocketHandling(int oldSocketNum, int newSocketNum);
+
+private:
+	/**
+	 * Execute the handlers of all the pending triggered events.
+	 */
+	void handleTriggeredEvents();
+
+	/**
+	 * Socket handler registered with 'setBackgroundHandling()'.
+	 */
+	typedef struct socket_handler_s {
+		int conditionSet;
+		BackgroundHandlerProc *handlerProc;
+		void *clientData;
+	} socket_handler_t;
+
+	/**
+	 * Event trigger registered with 'createEventTrigger()'.
+	 */
+	typedef struct event_trigger_s {
+		TaskFunc *handlerProc;
+		void *clientData;
+		int flag_pending;
+	} event_trigger_t;
+
+	/**
+	 * 'epoll' instance file descriptor.
+	 */
+	int m_epoll_fd;
+	/**
+	 * 'eventfd' used to wake-up the event-loop when an event is triggered.
+	 */
+	int m_event_fd;
+	/**
+	 * Registered socket handlers, indexed by socket number.
+	 */
+	std::map<int, socket_handler_t> m_socket_handlers;
+	/**
+	 * Event triggers related members (protected by the triggers MUTEX, as
+	 * events may be triggered from any thread).
+	 */
+	//@{
+	std::mutex m_event_triggers_mutex;
+	std::map<EventTriggerId, event_trigger_t> m_event_triggers;
+	std::vector<EventTriggerId> m_event_triggers_pending;
+	EventTriggerId m_event_trigger_id_next;
+	//@}
+	/**
+	 * Externally provided LOG module context structure instance.
+	 */
+	log_ctx_t *m_log_ctx;
+};
+
+/**
+ * Job to be executed in the event-loop thread
+ * (see 'live555_event_loop_run_sync()').
+ */
+typedef struct live555_event_loop_job_s {
+	int (*fxn)(void *arg);
+	void *arg;
+	int ret_code;
+	int flag_done;
+	std::mutex mutex;
+	std::condition_variable cond;
+} live555_event_loop_job_t;
+
+/**
+ * Event-loop context structure.
+ */
+typedef struct live555_event_loop_s {
+	/**
+	 * Index of this event-loop in the pool.
+	 */
+	int index;
+	/**
+	 * Number of instances currently using this event-loop (protected by the
+	 * pool MUTEX).
+	 */
+	int users_num;
+	/**
+	 * Event-loop task scheduler.
+	 */
+	EpollTaskScheduler *epollTaskScheduler;
+	/**
+	 * Jobs queue related members.
+	 */
+	//@{
+	EventTriggerId jobs_event_trigger_id;
+	std::mutex jobs_mutex;
+	std::deque<live555_event_loop_job_t*> jobs;
+	//@}
+	/**
+	 * Event-loop thread related members.
+	 */
+	//@{
+	volatile char flag_exit;
+	pthread_t thread;
+	int flag_thread_launched;
+	//@}
+	/**
+	 * Externally provided LOG module context structure instance.
+	 */
+	log_ctx_t *log_ctx;
+} live555_event_loop_t;
+
+/* **** Prototypes **** */
+
+static live555_event_loop_t* live555_event_loop_open(int index,
+		log_ctx_t *log_ctx);
+static void live555_event_loop_close(
+		live555_event_loop_t **ref_live555_event_loop);
+static void live555_event_loop_jobs_handler(void *clientData);
+static void* live555_event_loop_thr(void *t);
+
+/* **** Implementations **** */
+
+/**
+ * Pool of event-loops (protected by the pool MUTEX).
+ */
+static std::mutex live555_event_loop_pool_mutex;
+static live555_event_loop_t
+		*live555_event_loop_pool[LIVE555_EVENT_LOOP_POOL_MAX];
+static int live555_event_loop_pool_size= 0; // 0: default
+
+int live555_event_loop_pool_set_size(int loops_num)
+{
+	int i, end_code= STAT_ERROR;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(loops_num>= 0 && loops_num<= LIVE555_EVENT_LOOP_POOL_MAX,
+			return STAT_EINVAL);
+
+	live555_event_loop_pool_mutex.lock();
+
+	for(i= 0; i< LIVE555_EVENT_LOOP_POOL_MAX; i++) {
+		if(live555_event_loop_pool[i]!= NULL) {
+			end_code= STAT_ECONFLICT;
+			goto end;
+		}
+	}
+	live555_event_loop_pool_size= loops_num;
+
+	end_code= STAT_SUCCESS;
+end:
+	live555_event_loop_pool_mutex.unlock();
+	return end_code;
+}
+
+live555_event_loop_t* live555_event_loop_acquire(log_ctx_t *log_ctx)
+{
+	int i, loops_max, loops_num= 0, free_idx= -1;
+	live555_event_loop_t *live555_event_loop= NULL; // Do not release
+	LOG_CTX_INIT(log_ctx);
+
+	live555_event_loop_pool_mutex.lock();
+
+	/* Get the maximum number of event-loop threads */
+	if((loops_max= live555_event_loop_pool_size)<= 0)
+		loops_max= (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(loops_max< 1)
+		loops_max= 1;
+	if(loops_max> LIVE555_EVENT_LOOP_POOL_MAX)
+		loops_max= LIVE555_EVENT_LOOP_POOL_MAX;
+
+	/* Look for the least loaded running event-loop */
+	for(i= 0; i< LIVE555_EVENT_LOOP_POOL_MAX; i++) {
+		live555_event_loop_t *live555_event_loop_i=
+				live555_event_loop_pool[i];
+		if(live555_event_loop_i== NULL) {
+			if(free_idx< 0)
+				free_idx= i;
+			continue;
+		}
+		loops_num++;
+		if(live555_event_loop== NULL ||
+				live555_event_loop_i->users_num<
+				live555_event_loop->users_num)
+			live555_event_loop= live555_event_loop_i;
+	}
+
+	/* Launch a new event-loop thread if all the running ones are in use and
+	 * the maximum was not reached yet.
+	 */
+	if((live555_event_loop== NULL || live555_event_loop->users_num> 0) &&
+			loops_num< loops_max && free_idx>= 0) {
+		live555_event_loop_t *live555_event_loop_new=
+				live555_event_loop_open(free_idx, LOG_CTX_GET());
+		if(live555_event_loop_new!= NULL) {
+			live555_event_loop_pool[free_idx]= live555_event_loop_new;
+			live555_event_loop= live555_event_loop_new;
+		}
+	}
+
+	if(live555_event_loop!= NULL)
+		live555_event_loop->users_num++;
+
+	live555_event_loop_pool_mutex.unlock();
+	return live555_event_loop;
+}
+
+void live555_event_loop_release(live555_event_loop_t **ref_live555_event_loop)
+{
+	live555_event_loop_t *live555_event_loop= NULL;
+	LOG_CTX_INIT(NULL);
+
+	if(ref_live555_event_loop== NULL ||
+			(live555_event_loop= *ref_live555_event_loop)== NULL)
+		return;
+
+	LOG_CTX_SET(live555_event_loop->log_ctx);
+
+	/* Releasing from the event-loop thread would dead-lock when joining */
+	CHECK_DO(!pthread_equal(pthread_self(), live555_event_loop->thread),
+			return);
+
+	live555_event_loop_pool_mutex.lock();
+	ASSERT(live555_event_loop->users_num> 0);
+	if(--live555_event_loop->users_num> 0) {
+		live555_event_loop= NULL; // Still in use; do not release
+	} else {
+		/* Not in use anymore; remove from pool (will be closed below) */
+		ASSERT(live555_event_loop_pool[live555_event_loop->index]==
+				live555_event_loop);
+		live555_event_loop_pool[live555_event_loop->index]= NULL;
+	}
+	live555_event_loop_pool_mutex.unlock();
+
+	if(live555_event_loop!= NULL)
+		live555_event_loop_close(&live555_event_loop);
+	*ref_live555_event_loop= NULL;
+}
+
+TaskScheduler* live555_event_loop_get_scheduler(
+		live555_event_loop_t *live555_event_loop)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_event_loop!= NULL, return NULL);
+
+	return live555_event_loop->epollTaskScheduler;
+}
+
+int live555_event_loop_run_sync(live555_event_loop_t *live555_event_loop,
+		int (*fxn)(void *arg), void *arg)
+{
+	live555_event_loop_job_t live555_event_loop_job;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_event_loop!= NULL, return STAT_ERROR);
+	CHECK_DO(fxn!= NULL, return STAT_ERROR);
+	// Parameter 'arg' is allowed to be NULL
+
+	LOG_CTX_SET(live555_event_loop->log_ctx);
+
+	/* If we already are in the event-loop thread, just execute */
+	if(pthread_equal(pthread_self(), live555_event_loop->thread))
+		return fxn(arg);
+
+	/* Queue the job and wake-up the event-loop */
+	live555_event_loop_job.fxn= fxn;
+	live555_event_loop_job.arg= arg;
+	live555_event_loop_job.ret_code= STAT_ERROR;
+	live555_event_loop_job.flag_done= 0;
+	live555_event_loop->jobs_mutex.lock();
+	live555_event_loop->jobs.push_back(&live555_event_loop_job);
+	live555_event_loop->jobs_mutex.unlock();
+	live555_event_loop->epollTaskScheduler->triggerEvent(
+			live555_event_loop->jobs_event_trigger_id, live555_event_loop);
+
+	/* Wait for the job to be executed */
+	std::unique_lock<std::mutex> lock(live555_event_loop_job.mutex);
+	while(live555_event_loop_job.flag_done== 0)
+		live555_event_loop_job.cond.wait(lock);
+
+	return live555_event_loop_job.ret_code;
+}
+
+static live555_event_loop_t* live555_event_loop_open(int index,
+		log_ctx_t *log_ctx)
+{
+	int ret_code, end_code= STAT_ERROR;
+	live555_event_loop_t *live555_event_loop= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Allocate context structure */
+	live555_event_loop= new live555_event_loop_t();
+	CHECK_DO(live555_event_loop!= NULL, goto end);
+
+	live555_event_loop->index= index;
+	live555_event_loop->users_num= 0;
+	live555_event_loop->flag_exit= 0;
+	live555_event_loop->flag_thread_launched= 0;
+	live555_event_loop->log_ctx= LOG_CTX_GET();
+
+	/* Open scheduler */
+	live555_event_loop->epollTaskScheduler= EpollTaskScheduler::createNew(
+			LOG_CTX_GET());
+	CHECK_DO(live555_event_loop->epollTaskScheduler!= NULL, goto end);
+
+	/* Register jobs queue event */
+	live555_event_loop->jobs_event_trigger_id=
+			live555_event_loop->epollTaskScheduler->createEventTrigger(
+					live555_event_loop_jobs_handler);
+	CHECK_DO(live555_event_loop->jobs_event_trigger_id!= 0, goto end);
+
+	/* At last, launch event-loop thread */
+	ret_code= pthread_create(&live555_event_loop->thread, NULL,
+			live555_event_loop_thr, live555_event_loop);
+	CHECK_DO(ret_code== 0, goto end);
+	live555_event_loop->flag_thread_launched= 1;
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS)
+		live555_event_loop_close(&live555_event_loop);
+	return live555_event_loop;
+}
+
+static void live555_event_loop_close(
+		live555_event_loop_t **ref_live555_event_loop)
+{
+	live555_event_loop_t *live555_event_loop= NULL;
+	void *thread_end_code= NULL;
+	LOG_CTX_INIT(NULL);
+
+	if(ref_live555_event_loop== NULL ||
+			(live555_event_loop= *ref_live555_event_loop)== NULL)
+		return;
+
+	LOG_CTX_SET(live555_event_loop->log_ctx);
+
+	/* Join event-loop thread:
+	 * - set flag to notify we are exiting processing;
+	 * - wake-up the event-loop;
+	 * - join thread.
+	 */
+	if(live555_event_loop->flag_thread_launched!= 0) {
+		live555_event_loop->flag_exit= 1;
+		live555_event_loop->epollTaskScheduler->triggerEvent(
+				live555_event_loop->jobs_event_trigger_id, live555_event_loop);
+		pthread_join(live555_event_loop->thread, &thread_end_code);
+		if(thread_end_code!= NULL) {
+			ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
+			free(thread_end_code);
+			thread_end_code= NULL;
+		}
+	}
+	ASSERT(live555_event_loop->jobs.empty());
+
+	/* Release scheduler */
+	if(live555_event_loop->epollTaskScheduler!= NULL) {
+		if(live555_event_loop->jobs_event_trigger_id!= 0)
+			live555_event_loop->epollTaskScheduler->deleteEventTrigger(
+					live555_event_loop->jobs_event_trigger_id);
+		delete live555_event_loop->epollTaskScheduler;
+		live555_event_loop->epollTaskScheduler= NULL;
+	}
+
+	delete live555_event_loop;
+	*ref_live555_event_loop= NULL;
+}
+
+static void live555_event_loop_jobs_handler(void *clientData)
+{
+	live555_event_loop_t *live555_event_loop=
+			(live555_event_loop_t*)clientData;
+	std::deque<live555_event_loop_job_t*> jobs;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_event_loop!= NULL, return);
+
+	/* Get all the queued jobs */
+	live555_event_loop->jobs_mutex.lock();
+	jobs.swap(live555_event_loop->jobs);
+	live555_event_loop->jobs_mutex.unlock();
+
+	/* Execute jobs and signal waiting threads */
+	while(!jobs.empty()) {
+		live555_event_loop_job_t *live555_event_loop_job= jobs.front();
+		jobs.pop_front();
+		live555_event_loop_job->ret_code= live555_event_loop_job->fxn(
+				live555_event_loop_job->arg);
+		live555_event_loop_job->mutex.lock();
+		live555_event_loop_job->flag_done= 1;
+		live555_event_loop_job->cond.notify_one();
+		live555_event_loop_job->mutex.unlock();
+	}
+}
+
+static void* live555_event_loop_thr(void *t)
+{
+	live555_event_loop_t *live555_event_loop= (live555_event_loop_t*)t;
+	int *ref_end_code= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Allocate return context; initialize to a default 'ERROR' value */
+	ref_end_code= (int*)malloc(sizeof(int));
+	CHECK_DO(ref_end_code!= NULL, return NULL);
+	*ref_end_code= STAT_ERROR;
+
+	/* Check arguments */
+	CHECK_DO(live555_event_loop!= NULL, return (void*)ref_end_code);
+
+	LOG_CTX_SET(live555_event_loop->log_ctx);
+
+	schedule_set_thread_name("live555-loop-%d", live555_event_loop->index);
+
+	/* Run the scheduler until "exit flag" is set */
+	live555_event_loop->epollTaskScheduler->doEventLoop(
+			&live555_event_loop->flag_exit);
+
+	*ref_end_code= STAT_SUCCESS;
+	return (void*)ref_end_code;
+}
+
+/* **** So-called "epoll task scheduler" class implementation **** */
+
+EpollTaskScheduler* EpollTaskScheduler::createNew(log_ctx_t *log_ctx)
+{
+	int epoll_fd= -1, event_fd= -1;
+	struct epoll_event epoll_event_ctx;
+	EpollTaskScheduler *epollTaskScheduler= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	epoll_fd= epoll_create1(EPOLL_CLOEXEC);
+	CHECK_DO(epoll_fd>= 0, goto end);
+
+	event_fd= eventfd(0, EFD_NONBLOCK| EFD_CLOEXEC);
+	CHECK_DO(event_fd>= 0, goto end);
+
+	memset(&epoll_event_ctx, 0, sizeof(epoll_event_ctx));
+	epoll_event_ctx.events= EPOLLIN;
+	epoll_event_ctx.data.fd= event_fd;
+	CHECK_DO(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &epoll_event_ctx)
+			== 0, goto end);
+
+	epollTaskScheduler= new EpollTaskScheduler(epoll_fd, event_fd,
+			LOG_CTX_GET());
+	epoll_fd= event_fd= -1; // Now owned by the scheduler
+end:
+	if(event_fd>= 0)
+		close(event_fd);
+	if(epoll_fd>= 0)
+		close(epoll_fd);
+	return epollTaskScheduler;
+}
+
+EpollTaskScheduler::EpollTaskScheduler(int epoll_fd, int event_fd,
+		log_ctx_t *log_ctx):
+				BasicTaskScheduler0(),
+				m_epoll_fd(epoll_fd),
+				m_event_fd(event_fd),
+				m_event_trigger_id_next(1),
+				m_log_ctx(log_ctx)
+{
+}
+
+EpollTaskScheduler::~EpollTaskScheduler()
+{
+	if(m_event_fd>= 0)
+		close(m_event_fd);
+	if(m_epoll_fd>= 0)
+		close(m_epoll_fd);
+}
+
+EventTriggerId EpollTaskScheduler::createEventTrigger(
+		TaskFunc *eventHandlerProc)
+{
+	EventTriggerId eventTriggerId;
+	event_trigger_t event_trigger= {eventHandlerProc, NULL, 0};
+
+	m_event_triggers_mutex.lock();
+	do {
+		eventTriggerId= m_event_trigger_id_next++;
+	} while(eventTriggerId== 0 ||
+			m_event_triggers.find(eventTriggerId)!= m_event_triggers.end());
+	m_event_triggers[eventTriggerId]= event_trigger;
+	m_event_triggers_mutex.unlock();
+	return eventTriggerId;
+}
+
+void EpollTaskScheduler::deleteEventTrigger(EventTriggerId eventTriggerId)
+{
+	/* Note that the trigger may still be in the pending list; it will just
+	 * be skipped as it is not registered anymore.
+	 */
+	m_event_triggers_mutex.lock();
+	m_event_triggers.erase(eventTriggerId);
+	m_event_triggers_mutex.unlock();
+}
+
+void EpollTaskScheduler::triggerEvent(EventTriggerId eventTriggerId,
+		void *clientData)
+{
+	int flag_wakeup= 0;
+	std::map<EventTriggerId, event_trigger_t>::iterator it;
+
+	m_event_triggers_mutex.lock();
+	if((it= m_event_triggers.find(eventTriggerId))!= m_event_triggers.end()) {
+		it->second.clientData= clientData;
+		if(it->second.flag_pending== 0) {
+			it->second.flag_pending= 1;
+			m_event_triggers_pending.push_back(eventTriggerId);
+			flag_wakeup= 1;
+		}
+	}
+	m_event_triggers_mutex.unlock();
+
+	/* Wake-up the event-loop */
+	if(flag_wakeup!= 0) {
+		uint64_t cnt= 1;
+		if(write(m_event_fd, &cnt, sizeof(cnt))< 0 && errno!= EAGAIN) {
+			LOG_CTX_INIT(m_log_ctx);
+			LOGE("Could not wake-up Live555's event-loop: %s\n",
+					strerror(errno));
+		}
+	}
+}
+
+void EpollTaskScheduler::SingleStep(unsigned maxDelayTime)
+{
+	int i, events_num, timeout_msec;
+	int64_t delay_usec;
+	struct epoll_event epoll_events[EPOLL_EVENTS_MAX];
+	LOG_CTX_INIT(m_log_ctx);
+
+	/* Compute the time to wait (until next delayed task is due) */
+	DelayInterval const& timeToDelay= fDelayQueue.timeToNextAlarm();
+	delay_usec= (int64_t)timeToDelay.seconds()* 1000000+
+			(int64_t)timeToDelay.useconds();
+	if(delay_usec> EPOLL_WAIT_USECS_MAX)
+		delay_usec= EPOLL_WAIT_USECS_MAX;
+	if(maxDelayTime> 0 && delay_usec> (int64_t)maxDelayTime)
+		delay_usec= (int64_t)maxDelayTime;
+	timeout_msec= (int)((delay_usec+ 999)/ 1000); // Round up; avoid spinning
+
+	/* Wait for I/O events */
+	events_num= epoll_wait(m_epoll_fd, epoll_events, EPOLL_EVENTS_MAX,
+			timeout_msec);
+	if(events_num< 0) {
+		if(errno!= EINTR)
+			LOGE("'epoll_wait()' failed: %s\n", strerror(errno));
+		events_num= 0;
+	}
+
+	/* Call the handler function for each ready socket */
+	for(i= 0; i< events_num; i++) {
+		int resultConditionSet= 0;
+		uint32_t events= epoll_events[i].events;
+		int socketNum= epoll_events[i].data.fd;
+		std::map<int, socket_handler_t>::iterator it;
+
+		if(socketNum== m_event_fd) {
+			uint64_t cnt;
+			while(read(m_event_fd, &cnt, sizeof(cnt))> 0);
+			continue;
+		}
+
+		/* Note that handlers may have been modified by a previous handler */
+		if((it= m_socket_handlers.find(socketNum))== m_socket_handlers.end())
+			continue;
+
+		if(events& (EPOLLIN| EPOLLHUP| EPOLLERR))
+			resultConditionSet|= SOCKET_READABLE;
+		if(events& EPOLLOUT)
+			resultConditionSet|= SOCKET_WRITABLE;
+		if(events& EPOLLPRI)
+			resultConditionSet|= SOCKET_EXCEPTION;
+		resultConditionSet&= it->second.conditionSet;
+		if(resultConditionSet!= 0 && it->second.handlerProc!= NULL) {
+			BackgroundHandlerProc *handlerProc= it->second.handlerProc;
+			void *clientData= it->second.clientData;
+			(*handlerProc)(clientData, resultConditionSet);
+		}
+	}
+
+	/* Also handle any newly-triggered event (Note that we do this *after*
+	 * calling socket handlers, in case the triggered event handler modifies
+	 * the set of readable sockets).
+	 */
+	handleTriggeredEvents();
+
+	/* Also handle any delayed event that may have come due */
+	fDelayQueue.handleAlarm();
+}
+
+void EpollTaskScheduler::setBackgroundHandling(int socketNum,
+		int conditionSet, BackgroundHandlerProc *handlerProc,
+		void *clientData)
+{
+	int ret_code, op;
+	struct epoll_event epoll_event_ctx;
+	std::map<int, socket_handler_t>::iterator it;
+	LOG_CTX_INIT(m_log_ctx);
+
+	if(socketNum< 0)
+		return;
+
+	it= m_socket_handlers.find(socketNum);
+
+	/* Clear handler */
+	if(conditionSet== 0 || handlerProc== NULL) {
+		if(it!= m_socket_handlers.end()) {
+			epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, socketNum, NULL);
+			m_socket_handlers.erase(it);
+		}
+		return;
+	}
+
+	/* Assign handler.
+	 * Note that a socket may be closed without clearing its handler (the
+	 * kernel then removes it from the epoll set); thus, we fall-back to the
+	 * opposite operation if the expected one fails.
+	 */
+	memset(&epoll_event_ctx, 0, sizeof(epoll_event_ctx));
+	if(conditionSet& SOCKET_READABLE)
+		epoll_event_ctx.events|= EPOLLIN;
+	if(conditionSet& SOCKET_WRITABLE)
+		epoll_event_ctx.events|= EPOLLOUT;
+	if(conditionSet& SOCKET_EXCEPTION)
+		epoll_event_ctx.events|= EPOLLPRI;
+	epoll_event_ctx.data.fd= socketNum;
+	op= (it!= m_socket_handlers.end())? EPOLL_CTL_MOD: EPOLL_CTL_ADD;
+	ret_code= epoll_ctl(m_epoll_fd, op, socketNum, &epoll_event_ctx);
+	if(ret_code!= 0 && op== EPOLL_CTL_MOD && errno== ENOENT)
+		ret_code= epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, socketNum,
+				&epoll_event_ctx);
+	else if(ret_code!= 0 && op== EPOLL_CTL_ADD && errno== EEXIST)
+		ret_code= epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, socketNum,
+				&epoll_event_ctx);
+	if(ret_code!= 0) {
+		LOGE("Could not register socket %d in Live555's event-loop: %s\n",
+				socketNum, strerror(errno));
+		if(it!= m_socket_handlers.end())
+			m_socket_handlers.erase(it);
+		return;
+	}
+
+	m_socket_handlers[socketNum].conditionSet= conditionSet;
+	m_socket_handlers[socketNum].handlerProc= handlerProc;
+	m_socket_handlers[socketNum].clientData= clientData;
+}
+
+void EpollTaskScheduler::moveSocketHandling(int oldSocketNum,
+		int newSocketNum)
+{
+	socket_handler_t socket_handler;
+	std::map<int, socket_handler_t>::iterator it;
+
+	if(oldSocketNum< 0 || newSocketNum< 0 ||
+			(it= m_socket_handlers.find(oldSocketNum))==
+					m_socket_handlers.end())
+		return;
+
+	socket_handler= it->second;
+	setBackgroundHandling(oldSocketNum, 0, NULL, NULL);
+	setBackgroundHandling(newSocketNum, socket_handler.conditionSet,
+			socket_handler.handlerProc, socket_handler.clientData);
+}
+
+void EpollTaskScheduler::handleTriggeredEvents()
+{
+	std::vector<EventTriggerId> event_triggers_pending;
+	std::vector<EventTriggerId>::iterator it_pending;
+
+	m_event_triggers_mutex.lock();
+	event_triggers_pending.swap(m_event_triggers_pending);
+	m_event_triggers_mutex.unlock();
+
+	/* Note that each handler is executed out of the critical section (a
+	 * handler may trigger or delete events); handlers deleted by a previous
+	 * handler are skipped.
+	 */
+	for(it_pending= event_triggers_pending.begin();
+			it_pending!= event_triggers_pending.end(); ++it_pending) {
+		TaskFunc *handlerProc= NULL;
+		void *clientData= NULL;
+		std::map<EventTriggerId, event_trigger_t>::iterator it;
+
+		m_event_triggers_mutex.lock();
+		if((it= m_event_triggers.find(*it_pending))!= m_event_triggers.end()
+				&& it->second.flag_pending!= 0) {
+			it->second.flag_pending= 0;
+			handlerProc= it->second.handlerProc;
+			clientData= it->second.clientData;
+		}
+		m_event_triggers_mutex.unlock();
+
+		if(handlerProc!= NULL)
+			(*handlerProc)(clientData);
+	}
+}
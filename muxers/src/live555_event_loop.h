@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file live555_event_loop.h
+ * @brief Pool of Live555 event-loop threads shared by the RTSP multiplexer
+ * and de-multiplexer instances.
+ * Each event-loop thread runs an epoll-based Live555 task scheduler; the
+ * number of event-loop threads is bounded (by default, to the number of
+ * on-line processor cores) and does not depend on the number of streams.
+ * Instances are assigned to the least loaded event-loop.
+ * IMPORTANT: Live555 objects are not thread-safe; any object bound to a
+ * shared event-loop must be created, used and destroyed in the event-loop
+ * thread (see 'live555_event_loop_run_sync()'). The only exception is
+ * 'TaskScheduler::triggerEvent()', which may be called from any thread.
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_SRC_LIVE555_EVENT_LOOP_H_
+#define MEDIAPROCESSORS_SRC_LIVE555_EVENT_LOOP_H_
+
+/* **** Definitions **** */
+
+/* Forward definitions */
+class TaskScheduler;
+typedef struct log_ctx_s log_ctx_t;
+typedef struct live555_event_loop_s live555_event_loop_t;
+
+/* **** Prototypes **** */
+
+/**
+ * Set the maximum number of event-loop threads of the pool.
+ * This setting is only applicable while no event-loop is in use.
+ * @param loops_num Maximum number of event-loop threads; a value of 0 sets
+ * the default (number of on-line processor cores).
+ * @return Status code (STAT_SUCCESS code in case of success, STAT_ECONFLICT
+ * if any event-loop is currently in use; for other code values please refer
+ * to .stat_codes.h).
+ */
+int live555_event_loop_pool_set_size(int loops_num);
+
+/**
+ * Get an event-loop from the pool.
+ * The least loaded event-loop is returned; event-loop threads are launched
+ * on demand (a new thread is launched only if all the running event-loops
+ * are already in use and the maximum number of threads was not reached).
+ * @param log_ctx Pointer to the LOG module context structure (may be NULL).
+ * @return Pointer to the event-loop, or NULL if fails. The event-loop must be
+ * given back by calling 'live555_event_loop_release()'.
+ */
+live555_event_loop_t* live555_event_loop_acquire(log_ctx_t *log_ctx);
+
+/**
+ * Give back an event-loop obtained with 'live555_event_loop_acquire()'.
+ * The event-loop thread is stopped (joined) when it is not used anymore.
+ * This function must not be called from an event-loop thread.
+ * @param ref_live555_event_loop Reference to the pointer to the event-loop.
+ * Pointer is set to NULL on return.
+ */
+void live555_event_loop_release(live555_event_loop_t **ref_live555_event_loop);
+
+/**
+ * Get the Live555 task scheduler of the given event-loop.
+ * @param live555_event_loop Pointer to the event-loop.
+ * @return Pointer to the task scheduler, or NULL if fails.
+ */
+TaskScheduler* live555_event_loop_get_scheduler(
+		live555_event_loop_t *live555_event_loop);
+
+/**
+ * Execute the given function in the event-loop thread and wait for it to
+ * return.
+ * If called from the event-loop thread itself, the function is executed
+ * directly.
+ * @param live555_event_loop Pointer to the event-loop.
+ * @param fxn Function to be executed.
+ * @param arg Opaque argument to be passed to the function.
+ * @return The status code returned by the executed function, or STAT_ERROR
+ * if the function could not be executed.
+ */
+int live555_event_loop_run_sync(live555_event_loop_t *live555_event_loop,
+		int (*fxn)(void *arg), void *arg);
+
+#endif /* MEDIAPROCESSORS_SRC_LIVE555_EVENT_LOOP_H_ */
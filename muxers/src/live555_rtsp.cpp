@@ -23,6 +23,10 @@
  */
 
 #include <mutex>
+#include <list>
+#include <map>
+#include <deque>
+#include <algorithm>
 
 extern "C" {
 #include "live555_rtsp.h"
@@ -30,7 +34,9 @@ extern "C" {
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <limits.h>
 #include <pthread.h>
+#include <arpa/inet.h>
 
 #include <libcjson/cJSON.h>
 #include <libmediaprocsutils/uri_parser.h>
@@ -38,21 +44,28 @@ extern "C" {
 #include <libmediaprocsutils/stat_codes.h>
 #include <libmediaprocsutils/check_utils.h>
 #include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/usdt.h>
 #include <libmediaprocsutils/fair_lock.h>
 #include <libmediaprocsutils/fifo.h>
+#include <libmediaprocsutils/interr_usleep.h>
+#include <libmediaprocsutils/json_writer.h>
 #include <libmediaprocs/proc_if.h>
 #include <libmediaprocs/procs.h>
 #include <libmediaprocs/proc.h>
 #include "muxers_settings.h"
 #include "proc_muxer.h"
+#include "bitrate_adapt.h"
 }
 
 #include <liveMedia/liveMedia.hh>
 #include <BasicUsageEnvironment/BasicUsageEnvironment.hh>
+#include <groupsock/GroupsockHelper.hh>
 #ifndef _MULTI_FRAMED_RTP_SINK_HH
 #include "MultiFramedRTPSink.hh"
 #endif
 
+#include "live555_event_loop.h"
+
 using namespace std;
 
 /* **** Definitions **** */
@@ -61,8 +74,107 @@ using namespace std;
 
 #define FRAMED_SOURCE_FIFO_SLOTS 16
 
+/**
+ * Default maximum size, in bytes, of the per elementary stream GOP cache
+ * (see 'live555_rtsp_es_mux_settings_ctx_s::gop_cache_max_bytes').
+ */
+#define GOP_CACHE_MAX_BYTES_DEFAULT (8* 1024* 1024)
+
+/**
+ * If the presentation time-stamp of an incoming frame deviates more than
+ * this value (microseconds) from the wall-clock, the PTS to wall-clock
+ * mapping is re-anchored (e.g. PTS discontinuity or source restart).
+ */
+#define PTS_REANCHOR_THRESHOLD_USECS (2* 1000000)
+
+/**
+ * RTP pacing defaults: rate headroom (percentage over the target bit-rate)
+ * and maximum latency (milliseconds) added to a frame by the pacer
+ * (see 'live555_rtsp_es_mux_settings_ctx_s').
+ */
+#define RTP_PACING_HEADROOM_DEFAULT 25
+#define RTP_PACING_MAX_LATENCY_MSECS_DEFAULT 40
+
+/**
+ * RTP pacer token-bucket depth, in packets. Also, the bucket holds at least
+ * the tokens accumulated in RTP_PACING_BUCKET_MIN_USECS, so the event-loop
+ * timer resolution (one millisecond) does not limit the pacing rate.
+ */
+#define RTP_PACING_BUCKET_PACKETS 4
+#define RTP_PACING_BUCKET_MIN_USECS 2000
+
+/**
+ * Encoder bit-rate adaptation (AIMD) defaults: minimum bit-rate (bits per
+ * second), and RTCP receiver-reports loss thresholds (percentage) above
+ * which the bit-rate is decreased and below which it may be increased (see
+ * 'live555_rtsp_es_mux_settings_ctx_s').
+ */
+#define BITRATE_ADAPT_MIN_DEFAULT 64000
+#define BITRATE_ADAPT_LOSS_HIGH_DEFAULT 5
+#define BITRATE_ADAPT_LOSS_LOW_DEFAULT 1
+
+/**
+ * Encoder bit-rate adaptation control loop period (microseconds) at which
+ * RTCP receiver-reports are checked (see .bitrate_adapt.h for the law
+ * parameters).
+ */
+#define BITRATE_ADAPT_PERIOD_USECS 1000000
+
+/**
+ * Encoder setting driven by the bit-rate adaptation control loop.
+ */
+#define BITRATE_ADAPT_ENCODER_SETTING "bit_rate_output"
+
+/**
+ * Maximum number of RTCP receivers reported per elementary stream.
+ */
+#define RTCP_RECEIVERS_MAX 64
+
+/**
+ * Default size, in bytes, of both the multiplexer RTP output packet buffer
+ * and the de-multiplexer (initial) receive buffer (see
+ * 'live555_rtsp_mux_settings_ctx_s::packet_buffer_size' and
+ * 'live555_rtsp_dmux_settings_ctx_s::receive_buffer_size').
+ */
 #define SINK_BUFFER_SIZE 200000
 
+/**
+ * Default maximum size, in bytes, the de-multiplexer receive buffer may
+ * grow to on truncation, and upper limit for all the configurable buffer
+ * sizes.
+ */
+#define RECEIVE_BUFFER_SIZE_MAX_DEFAULT (16* 1024* 1024)
+#define BUFFER_SIZE_LIMIT (64* 1024* 1024)
+
+/**
+ * De-multiplexer jitter buffer depth default and maximum, in milliseconds
+ * (see 'live555_rtsp_dmux_settings_ctx_s::jitter_buffer_msecs').
+ */
+#define JITTER_BUFFER_MSECS_DEFAULT 100
+#define JITTER_BUFFER_MSECS_MAX 5000
+
+/**
+ * Multicast defaults: RTP port of the first elementary stream (the RTP/RTCP
+ * ports of the following elementary streams are consecutive pairs) and
+ * time-to-live (see 'live555_rtsp_mux_settings_ctx_s').
+ */
+#define MULTICAST_PORT_DEFAULT 18888
+#define MULTICAST_TTL_DEFAULT 16
+
+/**
+ * Check if the multicast ports of 'ES_NUM' elementary streams fit in the
+ * port range, given the RTP port of the first one ('PORT'): the last
+ * elementary stream uses RTP port 'PORT+ 2* (ES_NUM- 1)' and the next
+ * (RTCP) port.
+ */
+#define MULTICAST_PORTS_FIT(PORT, ES_NUM) \
+	((int64_t)(PORT)+ 2* (int64_t)(ES_NUM)- 1<= 65535)
+
+/**
+ * RTP payload type used for multicast streams (dynamic).
+ */
+#define MULTICAST_RTP_PAYLOAD_TYPE 96
+
 //#define ENABLE_DEBUG_LOGS
 #ifdef ENABLE_DEBUG_LOGS
 	#define LOGD_CTX_INIT(CTX) LOG_CTX_INIT(CTX)
@@ -92,6 +204,30 @@ typedef struct live555_rtsp_mux_settings_ctx_s {
 	 * mux_settings_ctx_s.
 	 */
 	struct muxers_settings_mux_ctx_s muxers_settings_mux_ctx;
+	/**
+	 * Multicast group address (e.g. "239.255.42.42"). If set, each
+	 * elementary stream is sent as a single multicast RTP stream serving
+	 * all the receivers (the session description is still announced over
+	 * RTSP); otherwise (NULL or empty string, default), elementary streams
+	 * are served as unicast on-demand sessions.
+	 */
+	char *multicast_address;
+	/**
+	 * Multicast RTP port of the first elementary stream; the following
+	 * elementary streams use the next even ports (RTCP uses RTP port + 1).
+	 */
+	int multicast_port;
+	/**
+	 * Multicast packets time-to-live.
+	 */
+	int multicast_ttl;
+	/**
+	 * RTP output packet buffer size, in bytes. Frames larger than this
+	 * buffer are delivered to the RTP sink in fragments.
+	 * Note that Live555 output packet buffer maximum size is process-wide
+	 * and can only be increased.
+	 */
+	int packet_buffer_size;
 } live555_rtsp_mux_settings_ctx_t;
 
 /**
@@ -111,7 +247,14 @@ typedef struct live555_rtsp_mux_ctx_s {
 	volatile struct live555_rtsp_mux_settings_ctx_s
 	live555_rtsp_mux_settings_ctx;
 	/**
-	 * Live555's TaskScheduler Class.
+	 * Shared Live555's event-loop (obtained from the event-loops pool).
+	 * All the Live555 objects of this multiplexer are bound to this
+	 * event-loop thread.
+	 */
+	live555_event_loop_t *live555_event_loop;
+	/**
+	 * Live555's TaskScheduler Class (shared event-loop scheduler; do not
+	 * release).
 	 * Used for scheduling MUXER and other processing when corresponding
 	 * events are signaled (e.g. multiplexing frame of data when a new frame
 	 * is available at the input).
@@ -125,10 +268,6 @@ typedef struct live555_rtsp_mux_ctx_s {
 	 * Live555's RTSPServer Class.
 	 */
 	RTSPServer *rtspServer;
-	/**
-	 * Live555's scheduler thread.
-	 */
-	pthread_t taskScheduler_thread;
 	/**
 	 * Live555's media sessions server.
 	 */
@@ -138,6 +277,16 @@ typedef struct live555_rtsp_mux_ctx_s {
 	 */
 } live555_rtsp_mux_ctx_t;
 
+/**
+ * Arguments for initializing the Live555's RTSP multiplexer resources in
+ * the event-loop thread (see 'live555_rtsp_mux_init_on_loop()').
+ */
+typedef struct live555_rtsp_mux_init_args_s {
+	live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx;
+	const muxers_settings_mux_ctx_t *muxers_settings_mux_ctx;
+	log_ctx_t *log_ctx;
+} live555_rtsp_mux_init_args_t;
+
 /**
  * Live555's RTSP elementary stream (ES) multiplexer settings context structure.
  */
@@ -152,8 +301,174 @@ typedef struct live555_rtsp_es_mux_settings_ctx_s {
 	 * (e.g. 9000)
 	 */
 	unsigned int rtp_timestamp_freq;
+	/**
+	 * Maximum size, in bytes, of the GOP cache: the most recent run of
+	 * frames, from the last key-frame to the present, that is sent in a
+	 * burst to each newly playing RTSP client so it can start rendering
+	 * immediately. If the run exceeds this size it is dropped until the
+	 * next key-frame. Zero disables the cache.
+	 */
+	size_t gop_cache_max_bytes;
+	/**
+	 * RTP packets pacing target bit-rate, in bits per second. If set, the
+	 * packets of each frame are not sent in a single burst but smoothed
+	 * out by a token-bucket at this rate plus the configured headroom.
+	 * Zero disables pacing (default).
+	 */
+	unsigned int rtp_pacing_bitrate;
+	/**
+	 * RTP pacing rate headroom, as a percentage over the target bit-rate.
+	 */
+	unsigned int rtp_pacing_headroom;
+	/**
+	 * Maximum latency, in milliseconds, the RTP pacer may add to a frame:
+	 * the pacing rate is raised as needed so that every frame is completely
+	 * sent within this time since it was ready to be sent (zero: no
+	 * latency bound).
+	 */
+	unsigned int rtp_pacing_max_latency_msecs;
+	/**
+	 * Encoder bit-rate adaptation lower bound, in bits per second.
+	 * Bit-rate adaptation applies only if an encoder is bound to the
+	 * elementary stream (see option "PROCS_ID_ES_MUX_BITRATE_ADAPT").
+	 */
+	unsigned int bitrate_adapt_min;
+	/**
+	 * Encoder bit-rate adaptation upper bound, in bits per second (zero:
+	 * the encoder bit-rate at the time it is bound).
+	 */
+	unsigned int bitrate_adapt_max;
+	/**
+	 * RTCP receiver-report loss percentage at or above which the encoder
+	 * bit-rate is decreased.
+	 */
+	unsigned int bitrate_adapt_loss_high;
+	/**
+	 * RTCP receiver-report loss percentage at or below which the encoder
+	 * bit-rate may be increased; between both thresholds the bit-rate is
+	 * held (hysteresis).
+	 */
+	unsigned int bitrate_adapt_loss_low;
 } live555_rtsp_es_mux_settings_ctx_t;
 
+/**
+ * Shared (reference counted) encoded frame.
+ * Frames delivered to an ES-multiplexer are shared -never copied- among the
+ * GOP cache and all the "framed-sources" (one per RTSP client) of the
+ * elementary stream. Once shared, the frame is read-only.
+ */
+typedef struct shared_frame_ctx_s {
+	/**
+	 * Encoded frame (owned by this structure).
+	 */
+	proc_frame_ctx_t *proc_frame_ctx;
+	/**
+	 * Frame presentation time, aligned with the wall-clock as required by
+	 * Live555 to compute the RTP time-stamps.
+	 */
+	struct timeval presentation_time;
+	/**
+	 * Reference counter; the frame is released when it reaches zero.
+	 */
+	volatile int ref_cnt;
+} shared_frame_ctx_t;
+
+/**
+ * Elementary stream codec types for which key-frames can be detected by
+ * parsing the bitstream (GOP cache is only enabled for these).
+ */
+typedef enum {
+	ES_CODEC_UNKNOWN= 0,
+	ES_CODEC_H264,
+	ES_CODEC_MPEG2_VIDEO,
+	ES_CODEC_MPEG4_VIDEO
+} es_codec_t;
+
+/**
+ * RTP packets pacing parameters (refer to the homonymous fields of
+ * 'live555_rtsp_es_mux_settings_ctx_s').
+ */
+typedef struct rtp_pacing_settings_s {
+	unsigned int bitrate;
+	unsigned int headroom;
+	unsigned int max_latency_msecs;
+} rtp_pacing_settings_t;
+
+/**
+ * RTCP receiver-report statistics of an RTSP client (RTP receiver).
+ */
+typedef struct rtcp_rr_stats_s {
+	/**
+	 * Receiver's SSRC and (last) source address.
+	 */
+	unsigned int ssrc;
+	char address[INET_ADDRSTRLEN];
+	/**
+	 * Fraction of packets lost (0 to 1) since the previous report.
+	 */
+	double fraction_lost;
+	/**
+	 * Cumulative number of packets lost.
+	 */
+	unsigned int packets_lost;
+	/**
+	 * Inter-arrival jitter, in milliseconds.
+	 */
+	double jitter_msecs;
+	/**
+	 * Round-trip time, in milliseconds, computed from the last sender-report
+	 * time-stamps (LSR/DLSR) echoed in the receiver-report (zero if not
+	 * available yet).
+	 */
+	double rtt_msecs;
+	/**
+	 * Time elapsed since the receiver-report was received, in microseconds.
+	 */
+	int64_t report_age_usecs;
+} rtcp_rr_stats_t;
+
+/**
+ * Encoder bit-rate adaptation context structure.
+ * A control thread periodically checks the RTCP receiver-reports of the
+ * elementary stream and adjusts, following an additive-increase/
+ * multiplicative-decrease (AIMD) law, the bit-rate of the bound encoder
+ * through its RESTful PUT.
+ */
+typedef struct bitrate_adapt_ctx_s {
+	/**
+	 * Encoder processor: PROCS module instance and processor Id. (not
+	 * owned by the ES-multiplexer; NULL if no encoder is bound).
+	 * The PROCS module instance must not be released while the encoder is
+	 * bound (the encoder processor itself may be deleted: see 'proc_name').
+	 */
+	procs_ctx_t *procs_ctx;
+	int proc_id;
+	/**
+	 * Encoder processor name, checked before each bit-rate update so that a
+	 * processor of another type registered with the Id. of a deleted
+	 * encoder is never modified.
+	 */
+	char *proc_name;
+	/**
+	 * Current encoder bit-rate, in bits per second (zero if unknown).
+	 */
+	volatile unsigned int bitrate;
+	/**
+	 * Upper bit-rate bound in use (bits per second).
+	 */
+	unsigned int bitrate_max;
+	/**
+	 * Consecutive clear receiver-reports count (hysteresis on increase).
+	 */
+	int clear_reports;
+	/**
+	 * Control thread, its exit flag and interruptible sleep instance.
+	 */
+	pthread_t thread;
+	volatile int flag_exit;
+	interr_usleep_ctx_t *interr_usleep_ctx;
+} bitrate_adapt_ctx_t;
+
 /**
  * Live555's RTSP elementary stream (ES) multiplexer context structure.
  */
@@ -184,11 +499,31 @@ typedef struct live555_rtsp_es_mux_ctx_s {
 	 * is available at the input).
 	 */
 	TaskScheduler *taskScheduler;
+	/**
+	 * Externally defined (multiplexer's) Live555's event-loop.
+	 */
+	live555_event_loop_t *live555_event_loop;
+	/**
+	 * Encoder bit-rate adaptation context structure.
+	 */
+	bitrate_adapt_ctx_t bitrate_adapt_ctx;
 	/**
 	 * Reserved for future use: other parameters here ...
 	 */
 } live555_rtsp_es_mux_ctx_t;
 
+/**
+ * Arguments for initializing the Live555's RTSP ES-multiplexer resources in
+ * the event-loop thread (see 'live555_rtsp_es_mux_init_on_loop()').
+ */
+typedef struct live555_rtsp_es_mux_init_args_s {
+	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx;
+	UsageEnvironment *usageEnvironment;
+	ServerMediaSession *serverMediaSession;
+	volatile live555_rtsp_mux_settings_ctx_t *live555_rtsp_mux_settings_ctx;
+	log_ctx_t *log_ctx;
+} live555_rtsp_es_mux_init_args_t;
+
 /**
  * Live555's RTSP de-multiplexer settings context structure.
  */
@@ -199,6 +534,23 @@ typedef struct live555_rtsp_dmux_settings_ctx_s {
 	 * mux_settings_ctx_s.
 	 */
 	struct muxers_settings_dmux_ctx_s muxers_settings_dmux_ctx;
+	/**
+	 * Jitter buffer depth, in milliseconds: maximum time an incoming RTP
+	 * packet is held waiting for the preceding (out-of-order or lost)
+	 * packets, so frames are reassembled in sequence before being delivered
+	 * to the output FIFO. Zero means packets are never waited for.
+	 */
+	int jitter_buffer_msecs;
+	/**
+	 * Initial size, in bytes, of the (per elementary stream) receive
+	 * buffer. The buffer grows automatically, up to
+	 * 'receive_buffer_size_max', each time an incoming frame is truncated.
+	 */
+	int receive_buffer_size;
+	/**
+	 * Maximum size, in bytes, the receive buffer may grow to.
+	 */
+	int receive_buffer_size_max;
 } live555_rtsp_dmux_settings_ctx_t;
 
 /**
@@ -219,10 +571,17 @@ typedef struct live555_rtsp_dmux_ctx_s {
 	volatile struct live555_rtsp_dmux_settings_ctx_s
 	live555_rtsp_dmux_settings_ctx;
 	/**
-	 * Live555's TaskScheduler Class.
-	 * Used for scheduling MUXER and other processing when corresponding
-	 * events are signaled (e.g. de-multiplexing frame of data when a new frame
-	 * is available at the input).
+	 * Shared Live555's event-loop (obtained from the event-loops pool).
+	 * All the Live555 objects of this de-multiplexer are bound to this
+	 * event-loop thread.
+	 */
+	live555_event_loop_t *live555_event_loop;
+	/**
+	 * Live555's TaskScheduler Class (shared event-loop scheduler; do not
+	 * release).
+	 * Used for scheduling DEMUXER and other processing when corresponding
+	 * events are signaled (e.g. de-multiplexing frame of data when new data
+	 * is available at the input socket).
 	 */
 	TaskScheduler *taskScheduler;
 	/**
@@ -233,8 +592,23 @@ typedef struct live555_rtsp_dmux_ctx_s {
 	 * Live555's RTSPClient simple extension.
 	 */
 	SimpleRTSPClient *simpleRTSPClient;
+	/**
+	 * Number of access units dropped because any of their fragments was
+	 * truncated (did not fit in the receive buffer).
+	 */
+	volatile uint64_t truncated_frames;
 } live555_rtsp_dmux_ctx_t;
 
+/**
+ * Arguments for initializing the Live555's RTSP de-multiplexer resources in
+ * the event-loop thread (see 'live555_rtsp_dmux_init_on_loop()').
+ */
+typedef struct live555_rtsp_dmux_init_args_s {
+	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx;
+	const muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx;
+	log_ctx_t *log_ctx;
+} live555_rtsp_dmux_init_args_t;
+
 /* **** Prototypes **** */
 
 /* **** Multiplexer **** */
@@ -246,9 +620,11 @@ static int live555_rtsp_mux_init_given_settings(
 		live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx,
 		const muxers_settings_mux_ctx_t *muxers_settings_mux_ctx,
 		log_ctx_t *log_ctx);
+static int live555_rtsp_mux_init_on_loop(void *t);
 static void live555_rtsp_mux_close(proc_ctx_t **ref_proc_ctx);
 static void live555_rtsp_mux_deinit_except_settings(
 		live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx, log_ctx_t *log_ctx);
+static int live555_rtsp_mux_deinit_on_loop(void *t);
 static int live555_rtsp_mux_process_frame(proc_ctx_t *proc_ctx,
 		fifo_ctx_t *iput_fifo_ctx, fifo_ctx_t *oput_fifo_ctx);
 static int live555_rtsp_mux_rest_put(proc_ctx_t *proc_ctx, const char *str);
@@ -258,6 +634,10 @@ static int live555_rtsp_mux_rest_get(proc_ctx_t *proc_ctx,
 		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
 static int live555_rtsp_mux_rest_get_es_array(procs_ctx_t *procs_ctx_es_muxers,
 		cJSON **ref_cjson_es_array, log_ctx_t *log_ctx);
+static int live555_rtsp_mux_es_num_get(procs_ctx_t *procs_ctx_es_muxers,
+		log_ctx_t *log_ctx);
+static int live555_rtsp_mux_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx);
 
 static int live555_rtsp_mux_settings_ctx_init(
 		volatile live555_rtsp_mux_settings_ctx_t *live555_rtsp_mux_settings_ctx,
@@ -265,17 +645,37 @@ static int live555_rtsp_mux_settings_ctx_init(
 static void live555_rtsp_mux_settings_ctx_deinit(
 		volatile live555_rtsp_mux_settings_ctx_t *live555_rtsp_mux_settings_ctx,
 		log_ctx_t *log_ctx);
-static void* taskScheduler_thr(void *t);
 
 static proc_ctx_t* live555_rtsp_es_mux_open(const proc_if_t *proc_if,
 		const char *settings_str, const char* href, log_ctx_t *log_ctx,
 		va_list arg);
+static int live555_rtsp_es_mux_init_on_loop(void *t);
 static void live555_rtsp_es_mux_close(proc_ctx_t **ref_proc_ctx);
-static int live555_rtsp_es_mux_process_frame(proc_ctx_t *proc_ctx,
-		fifo_ctx_t *iput_fifo_ctx, fifo_ctx_t *oput_fifo_ctx);
+static int live555_rtsp_es_mux_send_frame(proc_ctx_t *proc_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx);
 static int live555_rtsp_es_mux_rest_put(proc_ctx_t *proc_ctx, const char *str);
 static int live555_rtsp_es_mux_rest_get(proc_ctx_t *proc_ctx,
 		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
+static int live555_rtsp_es_mux_opt(proc_ctx_t *proc_ctx, const char *tag,
+		va_list arg);
+static int live555_rtsp_es_mux_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx);
+static int live555_rtsp_es_mux_rtcp_stats_get(
+		live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx,
+		rtcp_rr_stats_t *rtcp_rr_stats_array, int *ref_num);
+static int live555_rtsp_es_mux_rtcp_stats_get_on_loop(void *t);
+
+static int bitrate_adapt_start(
+		live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx,
+		procs_ctx_t *procs_ctx, int proc_id);
+static void bitrate_adapt_stop(
+		live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx);
+static void* bitrate_adapt_thr(void *t);
+static int bitrate_adapt_encoder_get(bitrate_adapt_ctx_t *bitrate_adapt_ctx,
+		char **ref_proc_name, unsigned int *ref_bitrate, log_ctx_t *log_ctx);
+static unsigned int bitrate_adapt_update(bitrate_adapt_ctx_t *bitrate_adapt_ctx,
+		volatile live555_rtsp_es_mux_settings_ctx_t *
+		live555_rtsp_es_mux_settings_ctx, double loss_percent);
 
 static int live555_rtsp_es_mux_settings_ctx_init(
 		volatile live555_rtsp_es_mux_settings_ctx_t *
@@ -284,9 +684,20 @@ static void live555_rtsp_es_mux_settings_ctx_deinit(
 		volatile live555_rtsp_es_mux_settings_ctx_t *
 		live555_rtsp_es_mux_settings_ctx, log_ctx_t *log_ctx);
 
+static shared_frame_ctx_t* shared_frame_ctx_create(
+		proc_frame_ctx_t **ref_proc_frame_ctx);
+static void* shared_frame_ctx_ref(const void *t);
+static void shared_frame_ctx_unref(void **ref_t);
+static size_t shared_frame_ctx_size(const shared_frame_ctx_t *shared_frame_ctx);
+
+static es_codec_t es_codec_get(const char *sdp_mimetype);
+static int es_frame_is_key(es_codec_t es_codec, const uint8_t *data,
+		size_t size);
+
 /**
  * So-called "framed-sink" class prototype.
  */
+class SimpleRTPPacer; // Forward declaration
 class SimpleRTPSink2: public MultiFramedRTPSink {
 public:
 	static SimpleRTPSink2* createNew(UsageEnvironment& env, Groupsock* RTPgs,
@@ -294,17 +705,22 @@ public:
 			char const* sdpMediaTypeString, char const* rtpPayloadFormatName,
 			unsigned numChannels= 1,
 			Boolean allowMultipleFramesPerPacket= True,
-			Boolean doNormalMBitRule= True);
+			Boolean doNormalMBitRule= True,
+			const rtp_pacing_settings_t *rtp_pacing_settings= NULL,
+			volatile size_t *ref_pacing_queue_bytes= NULL);
 
 protected:
 	SimpleRTPSink2(UsageEnvironment& env, Groupsock* RTPgs,
 			unsigned char rtpPayloadFormat, unsigned rtpTimestampFrequency,
 			char const* sdpMediaTypeString, char const* rtpPayloadFormatName,
 			unsigned numChannels, Boolean allowMultipleFramesPerPacket,
-			Boolean doNormalMBitRule);
+			Boolean doNormalMBitRule,
+			const rtp_pacing_settings_t *rtp_pacing_settings,
+			volatile size_t *ref_pacing_queue_bytes);
 	virtual ~SimpleRTPSink2();
 
 protected: // redefined virtual functions
+	virtual Boolean continuePlaying();
 	virtual void doSpecialFrameHandling(unsigned fragmentationOffset,
 			unsigned char* frameStart,
 			unsigned numBytesInFrame,
@@ -318,6 +734,101 @@ private:
 	char const* fSDPMediaTypeString;
 	Boolean fAllowMultipleFramesPerPacket;
 	Boolean fSetMBitOnLastFrames, fSetMBitOnNextPacket;
+	/**
+	 * RTP packets pacing parameters (pacing is disabled if the bit-rate is
+	 * zero).
+	 */
+	rtp_pacing_settings_t m_rtp_pacing_settings;
+	/**
+	 * Externally provided counter of the bytes queued in the pacer
+	 * (may be NULL).
+	 */
+	volatile size_t *m_ref_pacing_queue_bytes;
+	/**
+	 * Pacing filter inserted between the framed-source and this sink
+	 * (created when the sink starts playing, if pacing is enabled).
+	 */
+	SimpleRTPPacer *m_simpleRTPPacer;
+};
+
+/**
+ * RTP packets pacer class prototype.
+ * This filter is inserted by 'SimpleRTPSink2' between the framed-source and
+ * the sink (in the same way Live555's H.264 RTP sink inserts its
+ * "fragmenter"). Each frame is delivered to the sink in segments fitting in
+ * one RTP packet, and each segment is released when a token-bucket -filled
+ * at the target rate plus headroom- allows it; otherwise, delivery is
+ * deferred using a timer of the event-loop. The rate is raised as needed to
+ * send the whole frame within the configured maximum latency.
+ */
+class SimpleRTPPacer: public FramedFilter
+{
+public:
+	static SimpleRTPPacer* createNew(UsageEnvironment& env,
+			FramedSource* inputSource, unsigned inputBufferMax,
+			unsigned maxOutputPacketSize,
+			const rtp_pacing_settings_t *rtp_pacing_settings,
+			volatile size_t *ref_pacing_queue_bytes);
+	/**
+	 * Returns 'True' if the last delivered segment completes its frame
+	 * (used by the sink to apply the RTP 'M' bit rule).
+	 */
+	Boolean lastSegmentEndsFrame() const { return m_flag_frame_ended; }
+
+protected:
+	SimpleRTPPacer(UsageEnvironment& env, FramedSource* inputSource,
+			unsigned inputBufferMax, unsigned maxOutputPacketSize,
+			const rtp_pacing_settings_t *rtp_pacing_settings,
+			volatile size_t *ref_pacing_queue_bytes);
+	virtual ~SimpleRTPPacer();
+
+private:
+	virtual void doGetNextFrame();
+	virtual void doStopGettingFrames();
+	static void afterGettingFrame(void* clientData, unsigned frameSize,
+			unsigned numTruncatedBytes, struct timeval presentationTime,
+			unsigned durationInMicroseconds);
+	void afterGettingFrame1(unsigned frameSize,
+			struct timeval presentationTime);
+	static void deliverSegment0(void* clientData);
+	void deliverSegment();
+	void queueBytesSet(size_t queue_bytes);
+	/**
+	 * Current frame buffer.
+	 */
+	unsigned char *m_buf;
+	unsigned m_buf_size;
+	unsigned m_frame_size;
+	unsigned m_frame_offset;
+	struct timeval m_presentation_time;
+	Boolean m_flag_frame_ended;
+	/**
+	 * Maximum segment size (RTP packet payload).
+	 */
+	unsigned m_segment_size_max;
+	/**
+	 * Token-bucket: tokens (bytes) available, bucket depth, fill rate
+	 * (bytes per microsecond) and last fill time.
+	 */
+	double m_tokens;
+	double m_bucket_size;
+	double m_rate;
+	int64_t m_tokens_usecs;
+	/**
+	 * Current frame pacing start time and deadline (maximum latency).
+	 */
+	int64_t m_frame_start_usecs;
+	int64_t m_max_latency_usecs;
+	/**
+	 * Delayed segment delivery task.
+	 */
+	TaskToken m_task;
+	/**
+	 * Externally provided counter of the bytes queued in the pacer
+	 * (may be NULL), and our current contribution to it.
+	 */
+	volatile size_t *m_ref_pacing_queue_bytes;
+	size_t m_queue_bytes;
 };
 
 /**
@@ -334,13 +845,24 @@ public:
 	 */
 	void deliverFrame();
 	/**
-	 * Input frames FIFO buffer.
+	 * Queue a (GOP cache) frame to be delivered before any frame in the
+	 * input FIFO. Must be called in the event-loop thread, before the
+	 * source starts playing.
+	 */
+	void burstFrame(shared_frame_ctx_t *shared_frame_ctx);
+	/**
+	 * Input frames FIFO buffer (of shared frames).
 	 */
 	fifo_ctx_t *m_fifo_ctx;
 	/**
 	 * Unambiguous frame consuming method event trigger identifier.
 	 */
 	volatile EventTriggerId m_eventTriggerId;
+	/**
+	 * Bytes queued in the RTP pacer of the sink fed by this source
+	 * (updated by 'SimpleRTPPacer').
+	 */
+	volatile size_t m_pacing_queue_bytes;
 
 protected:
 	SimpleFramedSource(UsageEnvironment&, log_ctx_t*);
@@ -360,6 +882,17 @@ private:
 	 * Externally provided LOG module context structure instance.
 	 */
 	log_ctx_t *m_log_ctx;
+	/**
+	 * GOP cache frames burst, delivered before the input FIFO frames
+	 * (only accessed in the event-loop thread).
+	 */
+	std::deque<shared_frame_ctx_t*> m_burst;
+	/**
+	 * Offset, in bytes, of the data not yet delivered of the current frame
+	 * (frames larger than the output buffer are delivered in segments; the
+	 * shared frame itself is never modified).
+	 */
+	size_t m_frame_offset;
 };
 
 /**
@@ -369,32 +902,123 @@ class SimpleMediaSubsession: public OnDemandServerMediaSubsession
 {
 public:
 	static SimpleMediaSubsession *createNew(UsageEnvironment &env,
-			const char *sdp_mimetype, portNumBits initialPortNum= 6970,
+			const char *sdp_mimetype, size_t gop_cache_max_bytes,
+			portNumBits initialPortNum= 6970,
 			Boolean multiplexRTCPWithRTP= False);
 
-	void deliverFrame(proc_frame_ctx_t **);
+	int deliverFrame(proc_frame_ctx_t **);
+	void setGopCacheMaxBytes(size_t gop_cache_max_bytes);
+	void getGopCacheStats(size_t *ref_frames, size_t *ref_bytes,
+			uint64_t *ref_overflows);
+	void setRTPPacing(const rtp_pacing_settings_t *rtp_pacing_settings);
+	size_t getRTPPacingQueueBytes();
+	int getRTCPStats(rtcp_rr_stats_t *rtcp_rr_stats_array, int num_max);
 
 protected:
 	SimpleMediaSubsession(UsageEnvironment &env, const char *sdp_mimetype,
-			portNumBits initialPortNum=6970,
+			size_t gop_cache_max_bytes, portNumBits initialPortNum=6970,
 			Boolean multiplexRTCPWithRTP=False);
+	virtual ~SimpleMediaSubsession();
 
 	virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
 			unsigned& estBitrate);
+	virtual void startStream(unsigned clientSessionId, void* streamToken,
+			TaskFunc* rtcpRRHandler, void* rtcpRRHandlerClientData,
+			unsigned short& rtpSeqNum, unsigned& rtpTimestamp,
+			ServerRequestAlternativeByteHandler*
+			serverRequestAlternativeByteHandler,
+			void* serverRequestAlternativeByteHandlerClientData);
 	virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
 	virtual void closeStreamSource(FramedSource* inputSource);
 	virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock,
 			unsigned char rtpPayloadTypeIfDynamic, FramedSource* inputSource);
 private:
+	friend class SimpleMulticastMediaSubsession;
+	void sourceRegister(SimpleFramedSource *simpleFramedSource);
+	void gopCacheEmpty();
+	void presentationTimeGet(int64_t pts, struct timeval *ref_tv);
+	/**
+	 * Mutex protecting the playing sources list, the GOP cache and the
+	 * RTP pacing settings.
+	 */
 	std::mutex m_simpleFramedSource_mutex;
-	SimpleFramedSource *volatile m_simpleFramedSource;
+	/**
+	 * Playing "framed-sources", one per RTSP client (the media
+	 * sub-session does not reuse the first source, so each client can
+	 * start with its own GOP cache burst).
+	 */
+	std::list<SimpleFramedSource*> m_simpleFramedSources;
 	const char *m_sdp_mimetype;
+	es_codec_t m_es_codec;
+	/**
+	 * GOP cache: references to the frames from the last key-frame to the
+	 * present.
+	 */
+	std::deque<shared_frame_ctx_t*> m_gop_cache;
+	size_t m_gop_cache_bytes;
+	size_t m_gop_cache_max_bytes;
+	uint64_t m_gop_cache_overflows;
+	/**
+	 * Set while the current GOP is being cached (reset on overflow until
+	 * the next key-frame).
+	 */
+	int m_flag_gop_caching;
+	/**
+	 * PTS to wall-clock mapping anchor.
+	 */
+	int m_flag_pts_anchored;
+	int64_t m_pts_anchor;
+	int64_t m_wallclock_anchor_usecs;
+	/**
+	 * RTP pacing parameters; applied to the RTP sinks created from now on
+	 * (i.e. to new client sessions).
+	 */
+	rtp_pacing_settings_t m_rtp_pacing_settings;
+	/**
+	 * Playing RTP sinks, by client session Id. (the multicast sink, if
+	 * any, is registered with Id. 0); used to get the RTCP receiver-reports
+	 * statistics. Only accessed in the event-loop thread.
+	 */
+	std::map<unsigned, RTPSink*> m_rtpSinks;
 	/**
 	 * Externally provided LOG module context structure instance.
 	 */
 	log_ctx_t *m_log_ctx;
 };
 
+/**
+ * Multicast "media sub-session" class prototype.
+ * A single RTP (and RTCP) stream, sent to a multicast group, serves all the
+ * receivers; the stream is announced (SDP) over RTSP as a passive
+ * sub-session. The frames are fed by the given ES-multiplexer sub-session
+ * (used only as frames distributor; it is not added to the server media
+ * session), which is owned -and released- by this class.
+ */
+class SimpleMulticastMediaSubsession: public PassiveServerMediaSubsession
+{
+public:
+	static SimpleMulticastMediaSubsession* createNew(UsageEnvironment &env,
+			SimpleMediaSubsession *simpleMediaSubsession,
+			const char *multicast_address, portNumBits rtpPortNum,
+			u_int8_t ttl, log_ctx_t *log_ctx);
+
+protected:
+	SimpleMulticastMediaSubsession(RTPSink &rtpSink,
+			RTCPInstance *rtcpInstance,
+			SimpleMediaSubsession *simpleMediaSubsession,
+			FramedSource *framedSource, Groupsock *rtpGroupsock,
+			Groupsock *rtcpGroupsock);
+	virtual ~SimpleMulticastMediaSubsession();
+
+private:
+	SimpleMediaSubsession *m_simpleMediaSubsession;
+	FramedSource *m_framedSource;
+	RTPSink *m_rtpSink;
+	RTCPInstance *m_rtcpInstance;
+	Groupsock *m_rtpGroupsock;
+	Groupsock *m_rtcpGroupsock;
+};
+
 /* **** De-multiplexer **** */
 
 static proc_ctx_t* live555_rtsp_dmux_open(const proc_if_t *proc_if,
@@ -404,14 +1028,18 @@ static int live555_rtsp_dmux_init_given_settings(
 		live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx,
 		const muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx,
 		log_ctx_t *log_ctx);
+static int live555_rtsp_dmux_init_on_loop(void *t);
 static void live555_rtsp_dmux_close(proc_ctx_t **ref_proc_ctx);
 static void live555_rtsp_dmux_deinit_except_settings(
 		live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx, log_ctx_t *log_ctx);
+static int live555_rtsp_dmux_deinit_on_loop(void *t);
+static int live555_rtsp_dmux_unblock(proc_ctx_t *proc_ctx);
+static int live555_rtsp_dmux_stop_on_loop(void *t);
 static int live555_rtsp_dmux_rest_get(proc_ctx_t *proc_ctx,
 		const proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
-static int live555_rtsp_dmux_process_frame(proc_ctx_t *proc_ctx,
-		fifo_ctx_t* iput_fifo_ctx, fifo_ctx_t* oput_fifo_ctx);
 static int live555_rtsp_dmux_rest_put(proc_ctx_t *proc_ctx, const char *str);
+static int live555_rtsp_dmux_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx);
 
 static int live555_rtsp_dmux_settings_ctx_init(
 		volatile live555_rtsp_dmux_settings_ctx_t *
@@ -484,19 +1112,50 @@ class SimpleRTSPClient: public RTSPClient {
 public:
 	static SimpleRTSPClient* createNew(UsageEnvironment& env,
 			char const* rtspURL, volatile int *ref_flag_exit,
-			fifo_ctx_t *fifo_ctx, int verbosityLevel= 0,
+			fifo_ctx_t **ref_fifo_ctx,
+			SimpleRTSPClient **ref_simpleRTSPClient,
+			unsigned jitterBufferMSecs, unsigned receiveBufferSize,
+			unsigned receiveBufferSizeMax,
+			volatile uint64_t *ref_truncated_frames, int verbosityLevel= 0,
 			char const* applicationName= NULL,
 			portNumBits tunnelOverHTTPPortNum= 0, log_ctx_t *log_ctx= NULL);
 
 	StreamClientState streamClientState;
 	volatile int *m_ref_flag_exit;
 	log_ctx_t *m_log_ctx;
-	fifo_ctx_t *m_fifo_ctx;
+	/**
+	 * Reference to the de-multiplexer output FIFO pointer (the FIFO is
+	 * created by the PROC module after the client is instantiated, thus
+	 * it is resolved at delivery time).
+	 */
+	fifo_ctx_t **m_ref_fifo_ctx;
+	/**
+	 * Reference to the owner's client pointer; it is set to NULL when this
+	 * client is closed (e.g. on an unrecoverable error inside the
+	 * event-loop), so the owner never closes it twice.
+	 */
+	SimpleRTSPClient **m_ref_simpleRTSPClient;
+	/**
+	 * Jitter buffer depth, in milliseconds, applied to the RTP sources of
+	 * the set up sub-sessions.
+	 */
+	unsigned m_jitterBufferMSecs;
+	/**
+	 * Initial and maximum receive buffer sizes of the sub-sessions sinks,
+	 * and reference to the owner's truncated frames counter.
+	 */
+	unsigned m_receiveBufferSize;
+	unsigned m_receiveBufferSizeMax;
+	volatile uint64_t *m_ref_truncated_frames;
 protected:
 	SimpleRTSPClient(UsageEnvironment& env, char const* rtspURL,
-			volatile int *ref_flag_exit, fifo_ctx_t *fifo_ctx,
-			int verbosityLevel, char const* applicationName,
-			portNumBits tunnelOverHTTPPortNum, log_ctx_t *log_ctx= NULL);
+			volatile int *ref_flag_exit, fifo_ctx_t **ref_fifo_ctx,
+			SimpleRTSPClient **ref_simpleRTSPClient,
+			unsigned jitterBufferMSecs, unsigned receiveBufferSize,
+			unsigned receiveBufferSizeMax,
+			volatile uint64_t *ref_truncated_frames, int verbosityLevel,
+			char const* applicationName, portNumBits tunnelOverHTTPPortNum,
+			log_ctx_t *log_ctx= NULL);
 	virtual ~SimpleRTSPClient();
 };
 
@@ -512,12 +1171,17 @@ public:
 	 * @param streamId Identifies the stream itself (optional)
 	 */
 	static DummySink* createNew(UsageEnvironment& env,
-			MediaSubsession& subsession, fifo_ctx_t *fifo_ctx,
+			MediaSubsession& subsession, fifo_ctx_t **ref_fifo_ctx,
+			unsigned receiveBufferSize, unsigned receiveBufferSizeMax,
+			volatile uint64_t *ref_truncated_frames,
 			char const* streamId= NULL, log_ctx_t *log_ctx= NULL);
 
 private:
 	DummySink(UsageEnvironment& env, MediaSubsession& subsession,
-			fifo_ctx_t *fifo_ctx, char const* streamId, log_ctx_t *log_ctx);
+			fifo_ctx_t **ref_fifo_ctx, unsigned receiveBufferSize,
+			unsigned receiveBufferSizeMax,
+			volatile uint64_t *ref_truncated_frames, char const* streamId,
+			log_ctx_t *log_ctx);
 	virtual ~DummySink();
 
 	static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -529,14 +1193,52 @@ private:
 	/* redefined virtual functions */
 	virtual Boolean continuePlaying();
 
+	/**
+	 * Compute the presentation time-stamp (microseconds) of the frame
+	 * completed by the current RTP packet.
+	 * @param presentationTime Frame presentation time as given by Live555
+	 * (wall-clock based; sender's clock once synchronized using RTCP).
+	 * @return Presentation time-stamp in microseconds.
+	 */
+	int64_t ptsGet(struct timeval presentationTime);
+
+	/**
+	 * Grow the receive buffer (up to its maximum size) so it fits at least
+	 * the given size.
+	 * Must only be called when no frame is pending on the buffer.
+	 * @param sizeNeeded Size, in bytes, of the truncated incoming frame.
+	 */
+	void receiveBufferGrow(unsigned sizeNeeded);
+
 private:
 	u_int8_t* fReceiveBuffer;
+	unsigned fReceiveBufferSize;
+	unsigned fReceiveBufferSizeMax;
+	/**
+	 * Set when a fragment of the access unit being received was truncated;
+	 * the access unit is dropped when completed.
+	 */
+	bool m_flagTruncated;
+	volatile uint64_t *m_ref_truncated_frames;
 	MediaSubsession& fSubsession;
 	char* fStreamId;
 	log_ctx_t *m_log_ctx;
-	fifo_ctx_t *m_fifo_ctx;
+	fifo_ctx_t **m_ref_fifo_ctx;
 	proc_frame_ctx_t *m_proc_frame_ctx;
 	std::mutex m_dummySink_io_mutex;
+	/**
+	 * PTS computation state: the RTP time-stamp is extended to 64 bits
+	 * (handling wrap-around) and mapped to microseconds relative to an
+	 * anchor (presentation time, extended RTP time-stamp). The anchor is
+	 * set on the first frame, when the stream gets synchronized using RTCP,
+	 * and on time-line discontinuities.
+	 */
+	bool m_flagPTSAnchored;
+	bool m_flagRTCPSynced;
+	u_int32_t m_rtpTimestampLast;
+	int64_t m_rtpTimestampExt;
+	int64_t m_rtpTimestampExtAnchor;
+	int64_t m_ptsAnchorUSecs;
 };
 
 /* **** General **** */
@@ -567,7 +1269,9 @@ const proc_if_t proc_if_live555_rtsp_mux=
 	live555_rtsp_mux_opt,
 	(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
 	(void(*)(void**))proc_frame_ctx_release,
-	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup,
+	NULL, // no 'rest_get_stream'
+	live555_rtsp_mux_stats_get_stream
 };
 
 static const proc_if_t proc_if_live555_rtsp_es_mux=
@@ -576,17 +1280,19 @@ static const proc_if_t proc_if_live555_rtsp_es_mux=
 	(uint64_t)0, // no generic processor features implemented
 	live555_rtsp_es_mux_open,
 	live555_rtsp_es_mux_close,
-	proc_send_frame_default1,
+	live555_rtsp_es_mux_send_frame,
 	NULL, // no 'send-no-dup'
 	NULL, // no 'recv_frame'
 	NULL, // no specific unblock function extension
 	NULL, //live555_rtsp_es_mux_rest_put // used internally only (not in API)
 	live555_rtsp_es_mux_rest_get,
-	live555_rtsp_es_mux_process_frame,
-	NULL, //live555_rtsp_es_mux_opt
+	NULL, // no processing thread: frames are delivered on 'send_frame'
+	live555_rtsp_es_mux_opt,
 	(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
 	(void(*)(void**))proc_frame_ctx_release,
-	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup,
+	NULL, // no 'rest_get_stream'
+	live555_rtsp_es_mux_stats_get_stream
 };
 
 const proc_if_t proc_if_live555_rtsp_dmux=
@@ -598,14 +1304,16 @@ const proc_if_t proc_if_live555_rtsp_dmux=
 	NULL, // no 'send_frame'
 	NULL, // no 'send-no-dup'
 	proc_recv_frame_default1,
-	NULL, // no specific unblock function extension
+	live555_rtsp_dmux_unblock,
 	live555_rtsp_dmux_rest_put,
 	live555_rtsp_dmux_rest_get,
-	live555_rtsp_dmux_process_frame,
+	NULL, // no processing thread: de-multiplexing runs in the event-loop
 	NULL, //live555_rtsp_dmux_opt,
 	(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
 	(void(*)(void**))proc_frame_ctx_release,
-	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup,
+	NULL, // no 'rest_get_stream'
+	live555_rtsp_dmux_stats_get_stream
 };
 } //extern "C"
 
@@ -672,9 +1380,8 @@ static int live555_rtsp_mux_init_given_settings(
 		const muxers_settings_mux_ctx_t *muxers_settings_mux_ctx,
 		log_ctx_t *log_ctx)
 {
-	char *stream_session_name;
 	int ret_code, end_code= STAT_ERROR;
-	int port= 8554;
+	live555_rtsp_mux_init_args_t live555_rtsp_mux_init_args;
 	LOG_CTX_INIT(log_ctx);
 
 	/* Check arguments */
@@ -687,20 +1394,83 @@ static int live555_rtsp_mux_init_given_settings(
 			(proc_muxer_mux_ctx_t*)live555_rtsp_mux_ctx, LOG_CTX_GET());
 	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
 
-	/* Open Live555 scheduler */
-	live555_rtsp_mux_ctx->taskScheduler= BasicTaskScheduler::createNew();
+	/* Get a (shared) Live555 event-loop from the pool */
+	live555_rtsp_mux_ctx->live555_event_loop= live555_event_loop_acquire(
+			LOG_CTX_GET());
+	CHECK_DO(live555_rtsp_mux_ctx->live555_event_loop!= NULL, goto end);
+	live555_rtsp_mux_ctx->taskScheduler= live555_event_loop_get_scheduler(
+			live555_rtsp_mux_ctx->live555_event_loop);
 	CHECK_DO(live555_rtsp_mux_ctx->taskScheduler!= NULL, goto end);
 
-	/* Set up Live555 usage environment.
-	 * Unfortunate live555 implementation: we *must* initialize
-	 * 'liveMediaPriv' and 'groupsockPriv' to NULL to be able to successfully
-	 * delete -reclaim()- this class instance while releasing.
+	/* Register ES-MUXER processor type */
+	ret_code= procs_module_opt("PROCS_REGISTER_TYPE",
+			&proc_if_live555_rtsp_es_mux);
+	CHECK_DO(ret_code== STAT_SUCCESS || ret_code== STAT_ECONFLICT, goto end);
+
+	/* At last, create the RTSP server. Note that Live555 objects are not
+	 * thread-safe, thus are created in the event-loop thread.
 	 */
-	live555_rtsp_mux_ctx->usageEnvironment= BasicUsageEnvironment::createNew(
-			*live555_rtsp_mux_ctx->taskScheduler);
-	CHECK_DO(live555_rtsp_mux_ctx->usageEnvironment!= NULL, goto end);
-	live555_rtsp_mux_ctx->usageEnvironment->liveMediaPriv= NULL;
-	live555_rtsp_mux_ctx->usageEnvironment->groupsockPriv= NULL;
+	live555_rtsp_mux_init_args.live555_rtsp_mux_ctx= live555_rtsp_mux_ctx;
+	live555_rtsp_mux_init_args.muxers_settings_mux_ctx=
+			muxers_settings_mux_ctx;
+	live555_rtsp_mux_init_args.log_ctx= LOG_CTX_GET();
+	ret_code= live555_event_loop_run_sync(
+			live555_rtsp_mux_ctx->live555_event_loop,
+			live555_rtsp_mux_init_on_loop, &live555_rtsp_mux_init_args);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	end_code= STAT_SUCCESS;
+end:
+    if(end_code!= STAT_SUCCESS)
+    	live555_rtsp_mux_deinit_except_settings(live555_rtsp_mux_ctx,
+    			LOG_CTX_GET());
+	return end_code;
+}
+
+/**
+ * Create the Live555's RTSP multiplexer resources (this function is
+ * executed in the event-loop thread).
+ * @param t Pointer to the arguments structure (live555_rtsp_mux_init_args_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_mux_init_on_loop(void *t)
+{
+	char *stream_session_name;
+	int port= 8554;
+	live555_rtsp_mux_init_args_t *live555_rtsp_mux_init_args=
+			(live555_rtsp_mux_init_args_t*)t;
+	live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx= NULL; // Do not release
+	const muxers_settings_mux_ctx_t *muxers_settings_mux_ctx=
+			NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_mux_init_args!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(live555_rtsp_mux_init_args->log_ctx);
+
+	live555_rtsp_mux_ctx= live555_rtsp_mux_init_args->live555_rtsp_mux_ctx;
+	CHECK_DO(live555_rtsp_mux_ctx!= NULL, return STAT_ERROR);
+	muxers_settings_mux_ctx=
+			live555_rtsp_mux_init_args->muxers_settings_mux_ctx;
+	CHECK_DO(muxers_settings_mux_ctx!= NULL, return STAT_ERROR);
+
+	/* Set up Live555 usage environment.
+	 * Unfortunate live555 implementation: we *must* initialize
+	 * 'liveMediaPriv' and 'groupsockPriv' to NULL to be able to successfully
+	 * delete -reclaim()- this class instance while releasing.
+	 */
+	live555_rtsp_mux_ctx->usageEnvironment= BasicUsageEnvironment::createNew(
+			*live555_rtsp_mux_ctx->taskScheduler);
+	CHECK_DO(live555_rtsp_mux_ctx->usageEnvironment!= NULL,
+			return STAT_ERROR);
+	live555_rtsp_mux_ctx->usageEnvironment->liveMediaPriv= NULL;
+	live555_rtsp_mux_ctx->usageEnvironment->groupsockPriv= NULL;
+
+	/* Set the RTP output packet buffer size */
+	OutPacketBuffer::increaseMaxSizeTo((unsigned)live555_rtsp_mux_ctx->
+			live555_rtsp_mux_settings_ctx.packet_buffer_size);
 
 	/* Create the RTSP server */
 	port= muxers_settings_mux_ctx->rtsp_port;
@@ -709,7 +1479,7 @@ static int live555_rtsp_mux_init_given_settings(
 	if(live555_rtsp_mux_ctx->rtspServer== NULL) {
 		LOGE("Live555: %s\n",
 				live555_rtsp_mux_ctx->usageEnvironment->getResultMsg());
-		goto end;
+		return STAT_ERROR;
 	}
 
 	/* In run-time we will be able to set up each of the possible streams that
@@ -724,26 +1494,12 @@ static int live555_rtsp_mux_init_given_settings(
 			*live555_rtsp_mux_ctx->usageEnvironment,
 			stream_session_name!= NULL? stream_session_name: "session",
 			"n/a", "n/a");
-	CHECK_DO(live555_rtsp_mux_ctx->serverMediaSession!= NULL, goto end);
+	CHECK_DO(live555_rtsp_mux_ctx->serverMediaSession!= NULL,
+			return STAT_ERROR);
 	live555_rtsp_mux_ctx->rtspServer->addServerMediaSession(
 			live555_rtsp_mux_ctx->serverMediaSession);
 
-	/* Register ES-MUXER processor type */
-	ret_code= procs_module_opt("PROCS_REGISTER_TYPE",
-			&proc_if_live555_rtsp_es_mux);
-	CHECK_DO(ret_code== STAT_SUCCESS || ret_code== STAT_ECONFLICT, goto end);
-
-	/* At last, launch scheduler thread */
-	ret_code= pthread_create(&live555_rtsp_mux_ctx->taskScheduler_thread, NULL,
-			taskScheduler_thr, live555_rtsp_mux_ctx);
-	CHECK_DO(ret_code== 0, goto end);
-
-	end_code= STAT_SUCCESS;
-end:
-    if(end_code!= STAT_SUCCESS)
-    	live555_rtsp_mux_deinit_except_settings(live555_rtsp_mux_ctx,
-    			LOG_CTX_GET());
-	return end_code;
+	return STAT_SUCCESS;
 }
 
 /**
@@ -784,7 +1540,6 @@ static void live555_rtsp_mux_close(proc_ctx_t **ref_proc_ctx)
 static void live555_rtsp_mux_deinit_except_settings(
 		live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx, log_ctx_t *log_ctx)
 {
-	void *thread_end_code= NULL;
 	proc_muxer_mux_ctx_t *proc_muxer_mux_ctx= NULL; // Do not release
 	LOG_CTX_INIT(log_ctx);
 	LOGD(">>%s\n", __FUNCTION__); //comment-me
@@ -796,28 +1551,60 @@ static void live555_rtsp_mux_deinit_except_settings(
 	/* Get Multiplexer processing common context structure */
 	proc_muxer_mux_ctx= (proc_muxer_mux_ctx_t*)live555_rtsp_mux_ctx;
 
-	/* Join Join ES-threads first
+	/* Close ES-processors first
 	 * - set flag to notify we are exiting processing;
-	 * - unblock and close all running ES-processors;
-	 * - join thread.
+	 * - unblock and close all running ES-processors.
 	 */
 	((proc_ctx_t*)live555_rtsp_mux_ctx)->flag_exit= 1;
 	if(proc_muxer_mux_ctx!= NULL &&
 			proc_muxer_mux_ctx->procs_ctx_es_muxers!= NULL)
 		procs_close(&proc_muxer_mux_ctx->procs_ctx_es_muxers);
-	LOGD("Waiting thread to join... "); // comment-me
-	pthread_join(live555_rtsp_mux_ctx->taskScheduler_thread,
-			&thread_end_code);
-	if(thread_end_code!= NULL) {
-		ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
-		free(thread_end_code);
-		thread_end_code= NULL;
-	}
-	LOGD("joined O.K.\n"); // comment-me
 
 	// '&live555_rtsp_mux_ctx->live555_rtsp_mux_settings_ctx' preserved
 
-	/* **** Release the specific Live555 multiplexer resources **** */
+	/* **** Release the specific Live555 multiplexer resources ****
+	 * Live555 objects must be released in the event-loop thread; the
+	 * event-loop itself is shared, thus we just return it to the pool (the
+	 * scheduler is not ours to delete).
+	 */
+	if(live555_rtsp_mux_ctx->live555_event_loop!= NULL) {
+		int ret_code= live555_event_loop_run_sync(
+				live555_rtsp_mux_ctx->live555_event_loop,
+				live555_rtsp_mux_deinit_on_loop, live555_rtsp_mux_ctx);
+		ASSERT(ret_code== STAT_SUCCESS);
+	}
+	live555_event_loop_release(&live555_rtsp_mux_ctx->live555_event_loop);
+	live555_rtsp_mux_ctx->taskScheduler= NULL;
+
+	/* De-initialize generic multiplexing common context structure.
+	 * Implementation note: Do this after releasing 'rtspServer', as
+	 * processors are referenced inside 'rtspServer' media sub-sessions
+	 * related resources.
+	 */
+	proc_muxer_mux_ctx_deinit(proc_muxer_mux_ctx, LOG_CTX_GET());
+
+	// Reserved for future use: release other new variables here...
+
+	LOGD("<<%s\n", __FUNCTION__); //comment-me
+}
+
+/**
+ * Release the Live555's RTSP multiplexer resources (this function is
+ * executed in the event-loop thread).
+ * @param t Pointer to the multiplexer context structure
+ * (live555_rtsp_mux_ctx_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_mux_deinit_on_loop(void *t)
+{
+	live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx= (live555_rtsp_mux_ctx_t*)t;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_mux_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_mux_ctx)->log_ctx);
 
 	/* Note about 'live555_rtsp_mux_ctx::serverMediaSession': we do not
 	 * need to delete ServerMediaSession object before deleting a
@@ -838,21 +1625,7 @@ static void live555_rtsp_mux_deinit_except_settings(
 			live555_rtsp_mux_ctx->usageEnvironment= NULL;
 	}
 
-	if(live555_rtsp_mux_ctx->taskScheduler!= NULL) {
-		delete live555_rtsp_mux_ctx->taskScheduler;
-		live555_rtsp_mux_ctx->taskScheduler= NULL;
-	}
-
-	/* De-initialize generic multiplexing common context structure.
-	 * Implementation note: Do this after releasing 'rtspServer', as
-	 * processors are referenced inside 'rtspServer' media sub-sessions
-	 * related resources.
-	 */
-	proc_muxer_mux_ctx_deinit(proc_muxer_mux_ctx, LOG_CTX_GET());
-
-	// Reserved for future use: release other new variables here...
-
-	LOGD("<<%s\n", __FUNCTION__); //comment-me
+	return STAT_SUCCESS;
 }
 
 /**
@@ -900,7 +1673,8 @@ static int live555_rtsp_mux_process_frame(proc_ctx_t *proc_ctx,
 	/* Multiplex frame */
 	ret_code= procs_send_frame(procs_ctx_es_muxers, proc_frame_ctx_iput->es_id,
 			proc_frame_ctx_iput);
-	CHECK_DO(ret_code== STAT_SUCCESS || ret_code== STAT_EAGAIN, goto end);
+	CHECK_DO(ret_code== STAT_SUCCESS || ret_code== STAT_EAGAIN ||
+			ret_code== STAT_ENOMEM, goto end);
 
 	end_code= STAT_SUCCESS;
 end:
@@ -948,7 +1722,9 @@ static int live555_rtsp_mux_opt(proc_ctx_t *proc_ctx, const char *tag,
 		end_code= procs_opt(procs_ctx_es_muxers, "PROCS_POST",
 				"live555_rtsp_es_mux", settings_str, &rest_str,
 				live555_rtsp_mux_ctx->usageEnvironment,
-				live555_rtsp_mux_ctx->serverMediaSession);
+				live555_rtsp_mux_ctx->serverMediaSession,
+				live555_rtsp_mux_ctx->live555_event_loop,
+				&live555_rtsp_mux_ctx->live555_rtsp_mux_settings_ctx);
 		CHECK_DO(end_code== STAT_SUCCESS && rest_str!= NULL, goto end);
 
 		/* Get processor identifier */
@@ -962,6 +1738,16 @@ static int live555_rtsp_mux_opt(proc_ctx_t *proc_ctx, const char *tag,
 		snprintf(ref_id_str, sizeof(ref_id_str), PROC_ID_STR_FMT,
 				elementary_stream_id);
 		*ref_rest_str= strdup(ref_id_str);
+	} else if(TAG_IS("PROCS_ID_ES_MUX_BITRATE_ADAPT")) {
+		/* Bind (or unbind) an encoder to the elementary stream for
+		 * bit-rate adaptation (see 'live555_rtsp_es_mux_opt()').
+		 */
+		int elementary_stream_id= va_arg(arg, int);
+		procs_ctx_t *procs_ctx= va_arg(arg, procs_ctx_t*);
+		int proc_id= va_arg(arg, int);
+		end_code= procs_opt(procs_ctx_es_muxers,
+				"PROCS_ID_ES_MUX_BITRATE_ADAPT", elementary_stream_id,
+				procs_ctx, proc_id);
 	} else {
 		LOGE("Unknown option\n");
 		end_code= STAT_ENOTFOUND;
@@ -980,11 +1766,18 @@ end:
  */
 static int live555_rtsp_mux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 {
-	int ret_code;
+	int ret_code, flag_is_query, end_code= STAT_ERROR;
 	live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx= NULL;
 	volatile live555_rtsp_mux_settings_ctx_t *
 		live555_rtsp_mux_settings_ctx= NULL;
 	volatile muxers_settings_mux_ctx_t *muxers_settings_mux_ctx= NULL;
+	procs_ctx_t *procs_ctx_es_muxers= NULL; // Do not release
+	char *multicast_address_str= NULL, *multicast_port_str= NULL,
+			*multicast_ttl_str= NULL, *packet_buffer_size_str= NULL;
+	const char *multicast_address= NULL; // Do not release
+	const char *multicast_address_new= NULL; // Do not release
+	int multicast_port, multicast_ttl, packet_buffer_size;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
@@ -1008,12 +1801,122 @@ static int live555_rtsp_mux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 
 
 	/* PUT specific multiplexer settings */
-	// Reserved for future use
+
+	/* Guess string representation format (JSON-REST or Query) */
+	flag_is_query= (str[0]=='{' && str[strlen(str)-1]=='}')? 0: 1;
+
+	/* Get multicast settings (parse all before applying any) */
+	multicast_port= live555_rtsp_mux_settings_ctx->multicast_port;
+	multicast_ttl= live555_rtsp_mux_settings_ctx->multicast_ttl;
+	packet_buffer_size= live555_rtsp_mux_settings_ctx->packet_buffer_size;
+	if(flag_is_query== 1) {
+		multicast_address_str= uri_parser_query_str_get_value(
+				"multicast_address", str);
+		multicast_address= multicast_address_str;
+		multicast_port_str= uri_parser_query_str_get_value("multicast_port",
+				str);
+		if(multicast_port_str!= NULL)
+			multicast_port= atoi(multicast_port_str);
+		multicast_ttl_str= uri_parser_query_str_get_value("multicast_ttl",
+				str);
+		if(multicast_ttl_str!= NULL)
+			multicast_ttl= atoi(multicast_ttl_str);
+		packet_buffer_size_str= uri_parser_query_str_get_value(
+				"packet_buffer_size", str);
+		if(packet_buffer_size_str!= NULL)
+			packet_buffer_size= atoi(packet_buffer_size_str);
+	} else {
+		/* In the case string format is JSON-REST, parse to cJSON structure */
+		cjson_rest= cJSON_Parse(str);
+		CHECK_DO(cjson_rest!= NULL, goto end);
+
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "multicast_address");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuestring!= NULL,
+					end_code= STAT_EINVAL; goto end);
+			multicast_address= cjson_aux->valuestring;
+		}
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "multicast_port");
+		if(cjson_aux!= NULL)
+			multicast_port= (int)cjson_aux->valuedouble;
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "multicast_ttl");
+		if(cjson_aux!= NULL)
+			multicast_ttl= (int)cjson_aux->valuedouble;
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "packet_buffer_size");
+		if(cjson_aux!= NULL)
+			packet_buffer_size= (int)cjson_aux->valuedouble;
+	}
+
+	/* Check multicast settings: an empty address selects unicast mode;
+	 * RTP port is even (RTCP uses the next odd port).
+	 */
+	if(multicast_address!= NULL && strlen(multicast_address)> 0) {
+		struct in_addr in_addr;
+		if(inet_pton(AF_INET, multicast_address, &in_addr)!= 1 ||
+				!IN_MULTICAST(ntohl(in_addr.s_addr))) {
+			LOGE("Not a valid IPv4 multicast address: '%s'\n",
+					multicast_address);
+			end_code= STAT_EINVAL;
+			goto end;
+		}
+	}
+	CHECK_DO(multicast_port> 0 && multicast_port< 65535 &&
+			(multicast_port& 1)== 0, end_code= STAT_EINVAL; goto end);
+	CHECK_DO(multicast_ttl>= 0 && multicast_ttl<= 255,
+			end_code= STAT_EINVAL; goto end);
+
+	/* In multicast mode, the ports of the elementary streams already
+	 * registered (these are registered again on new settings) have to fit
+	 * in the port range.
+	 */
+	multicast_address_new= (multicast_address!= NULL)? multicast_address:
+			(const char*)live555_rtsp_mux_settings_ctx->multicast_address;
+	procs_ctx_es_muxers= ((proc_muxer_mux_ctx_t*)live555_rtsp_mux_ctx)->
+			procs_ctx_es_muxers;
+	if(multicast_address_new!= NULL && strlen(multicast_address_new)> 0 &&
+			procs_ctx_es_muxers!= NULL) {
+		int es_num= live555_rtsp_mux_es_num_get(procs_ctx_es_muxers,
+				LOG_CTX_GET());
+		CHECK_DO(es_num>= 0, goto end);
+		if(!MULTICAST_PORTS_FIT(multicast_port, es_num)) {
+			LOGE("Multicast port %d out of range for %d elementary "
+					"streams\n", multicast_port, es_num);
+			end_code= STAT_EINVAL;
+			goto end;
+		}
+	}
+	CHECK_DO(packet_buffer_size> 0 && packet_buffer_size<= BUFFER_SIZE_LIMIT,
+			end_code= STAT_EINVAL; goto end);
+
+	/* Set multicast settings */
+	if(multicast_address!= NULL) {
+		char *multicast_address_new= strdup(multicast_address);
+		CHECK_DO(multicast_address_new!= NULL, goto end);
+		if(live555_rtsp_mux_settings_ctx->multicast_address!= NULL)
+			free(live555_rtsp_mux_settings_ctx->multicast_address);
+		live555_rtsp_mux_settings_ctx->multicast_address=
+				multicast_address_new;
+	}
+	live555_rtsp_mux_settings_ctx->multicast_port= multicast_port;
+	live555_rtsp_mux_settings_ctx->multicast_ttl= multicast_ttl;
+	live555_rtsp_mux_settings_ctx->packet_buffer_size= packet_buffer_size;
 
 	/* Finally that we have new settings parsed, reset processor */
 	live555_rtsp_reset_on_new_settings(proc_ctx, 1, LOG_CTX_GET());
 
-	return STAT_SUCCESS;
+	end_code= STAT_SUCCESS;
+end:
+	if(multicast_address_str!= NULL)
+		free(multicast_address_str);
+	if(multicast_port_str!= NULL)
+		free(multicast_port_str);
+	if(multicast_ttl_str!= NULL)
+		free(multicast_ttl_str);
+	if(packet_buffer_size_str!= NULL)
+		free(packet_buffer_size_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return end_code;
 }
 
 /**
@@ -1030,6 +1933,7 @@ static int live555_rtsp_mux_rest_get(proc_ctx_t *proc_ctx,
 		live555_rtsp_mux_settings_ctx= NULL;
 	volatile muxers_settings_mux_ctx_t *muxers_settings_mux_ctx= NULL;
 	cJSON *cjson_rest= NULL, *cjson_settings= NULL, *cjson_es_array= NULL;
+	cJSON *cjson_aux= NULL; // Do not release
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
@@ -1073,7 +1977,31 @@ static int live555_rtsp_mux_rest_get(proc_ctx_t *proc_ctx,
 	CHECK_DO(ret_code== STAT_SUCCESS && cjson_settings!= NULL, goto end);
 
 	/* GET specific multiplexer settings */
-	// Reserved for future use: attach to 'cjson_settings' (should be != NULL)
+
+	/* 'multicast_address' */
+	cjson_aux= cJSON_CreateString(
+			(live555_rtsp_mux_settings_ctx->multicast_address!= NULL)?
+			live555_rtsp_mux_settings_ctx->multicast_address: "");
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "multicast_address", cjson_aux);
+
+	/* 'multicast_port' */
+	cjson_aux= cJSON_CreateNumber(
+			(double)live555_rtsp_mux_settings_ctx->multicast_port);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "multicast_port", cjson_aux);
+
+	/* 'multicast_ttl' */
+	cjson_aux= cJSON_CreateNumber(
+			(double)live555_rtsp_mux_settings_ctx->multicast_ttl);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "multicast_ttl", cjson_aux);
+
+	/* 'packet_buffer_size' */
+	cjson_aux= cJSON_CreateNumber(
+			(double)live555_rtsp_mux_settings_ctx->packet_buffer_size);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "packet_buffer_size", cjson_aux);
 
 	/* Attach settings object to REST response */
 	cJSON_AddItemToObject(cjson_rest, "settings", cjson_settings);
@@ -1228,6 +2156,110 @@ end:
 	return end_code;
 }
 
+/**
+ * Get the number of elementary streams registered in the multiplexer.
+ * @param procs_ctx_es_muxers Elementary stream multiplexers PROCS instance.
+ * @param log_ctx Pointer to the LOG module context structure.
+ * @return Number of elementary streams, or -1 on error.
+ */
+static int live555_rtsp_mux_es_num_get(procs_ctx_t *procs_ctx_es_muxers,
+		log_ctx_t *log_ctx)
+{
+	int ret_code, es_num= -1;
+	cJSON *cjson_procs_rest= NULL;
+	cJSON *cjson_procs= NULL; // Do not release
+	char *rest_str= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_ctx_es_muxers!= NULL, return -1);
+
+	ret_code= procs_opt(procs_ctx_es_muxers, "PROCS_GET", &rest_str, NULL);
+	CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL, goto end);
+	cjson_procs_rest= cJSON_Parse(rest_str);
+	CHECK_DO(cjson_procs_rest!= NULL, goto end);
+	cjson_procs= cJSON_GetObjectItem(cjson_procs_rest, "procs");
+	CHECK_DO(cjson_procs!= NULL, goto end);
+	es_num= cJSON_GetArraySize(cjson_procs);
+end:
+	if(rest_str!= NULL)
+		free(rest_str);
+	if(cjson_procs_rest!= NULL)
+		cJSON_Delete(cjson_procs_rest);
+	return es_num;
+}
+
+/**
+ * Implements the proc_if_s::stats_get_stream callback.
+ * See .proc_if.h for further details.
+ */
+static int live555_rtsp_mux_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx)
+{
+	int i, ret_code, procs_num= 0, end_code= STAT_ERROR;
+	procs_ctx_t *procs_ctx_es_muxers= NULL; // Do not release
+	cJSON *cjson_procs_rest= NULL;
+	cJSON *cjson_procs= NULL, *cjson_aux= NULL; // Do not release
+	char *rest_str_aux= NULL, *es_stats_str_aux= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	/* Members to be written:
+	 *     "elementary_streams":
+	 *     [
+	 *         {...}, // ES-processor statistics JSON
+	 *         ...
+	 *     ]
+	 *     ... // Reserved for future use
+	 */
+
+	procs_ctx_es_muxers= ((proc_muxer_mux_ctx_t*)proc_ctx)->
+			procs_ctx_es_muxers;
+	CHECK_DO(procs_ctx_es_muxers!= NULL, goto end);
+
+	ret_code= procs_opt(procs_ctx_es_muxers, "PROCS_GET", &rest_str_aux, NULL);
+	CHECK_DO(ret_code== STAT_SUCCESS && rest_str_aux!= NULL, goto end);
+	cjson_procs_rest= cJSON_Parse(rest_str_aux);
+	CHECK_DO(cjson_procs_rest!= NULL, goto end);
+	cjson_procs= cJSON_GetObjectItem(cjson_procs_rest, "procs");
+	CHECK_DO(cjson_procs!= NULL, goto end);
+
+	json_writer_array_start(json_writer_ctx, "elementary_streams");
+	procs_num= cJSON_GetArraySize(cjson_procs);
+	for(i= 0; i< procs_num; i++) {
+		cJSON *cjson_proc= cJSON_GetArrayItem(cjson_procs, i);
+		CHECK_DO(cjson_proc!= NULL, continue);
+
+		cjson_aux= cJSON_GetObjectItem(cjson_proc, "proc_id");
+		CHECK_DO(cjson_aux!= NULL, continue);
+
+		/* Get ES-processor statistics and copy "as is" */
+		if(es_stats_str_aux!= NULL) {
+			free(es_stats_str_aux);
+			es_stats_str_aux= NULL;
+		}
+		ret_code= procs_opt(procs_ctx_es_muxers, "PROCS_ID_STATS_GET",
+				(int)cjson_aux->valuedouble, &es_stats_str_aux);
+		CHECK_DO(ret_code== STAT_SUCCESS && es_stats_str_aux!= NULL,
+				continue);
+		json_writer_raw(json_writer_ctx, NULL, es_stats_str_aux);
+	}
+	end_code= json_writer_array_end(json_writer_ctx);
+end:
+	if(rest_str_aux!= NULL)
+		free(rest_str_aux);
+	if(cjson_procs_rest!= NULL)
+		cJSON_Delete(cjson_procs_rest);
+	if(es_stats_str_aux!= NULL)
+		free(es_stats_str_aux);
+	return end_code;
+}
+
 /**
  * Initialize specific Live555 RTSP multiplexer settings to defaults.
  * @param live555_rtsp_mux_settings_ctx
@@ -1255,7 +2287,10 @@ static int live555_rtsp_mux_settings_ctx_init(
 		return ret_code;
 
 	/* Initialize specific multiplexer settings */
-	// Reserved for future use
+	live555_rtsp_mux_settings_ctx->multicast_address= NULL; // unicast
+	live555_rtsp_mux_settings_ctx->multicast_port= MULTICAST_PORT_DEFAULT;
+	live555_rtsp_mux_settings_ctx->multicast_ttl= MULTICAST_TTL_DEFAULT;
+	live555_rtsp_mux_settings_ctx->packet_buffer_size= SINK_BUFFER_SIZE;
 
 	return STAT_SUCCESS;
 }
@@ -1283,38 +2318,10 @@ static void live555_rtsp_mux_settings_ctx_deinit(
 	muxers_settings_mux_ctx_deinit(muxers_settings_mux_ctx);
 
 	/* Release specific multiplexer settings */
-	// Reserved for future use
-}
-
-static void* taskScheduler_thr(void *t)
-{
-	char volatile *watchVariable;
-	live555_rtsp_mux_ctx_t* live555_rtsp_mux_ctx= (live555_rtsp_mux_ctx_t*)t;
-	int *ref_end_code= NULL;
-	UsageEnvironment *usageEnvironment= NULL;
-	LOG_CTX_INIT(NULL);
-
-	/* Allocate return context; initialize to a default 'ERROR' value */
-	ref_end_code= (int*)malloc(sizeof(int));
-	CHECK_DO(ref_end_code!= NULL, return NULL);
-	*ref_end_code= STAT_ERROR;
-
-	/* Check arguments */
-	CHECK_DO(live555_rtsp_mux_ctx!= NULL, return (void*)ref_end_code);
-
-	LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_mux_ctx)->log_ctx);
-
-	/* Get Live555's usage environment */
-	usageEnvironment= live555_rtsp_mux_ctx->usageEnvironment;
-	CHECK_DO(live555_rtsp_mux_ctx!= NULL, return (void*)ref_end_code);
-
-	/* Run the scheduler until "exit flag" is set */
-	watchVariable= (char volatile*)
-			&((proc_ctx_t*)live555_rtsp_mux_ctx)->flag_exit;
-	usageEnvironment->taskScheduler().doEventLoop(watchVariable);
-
-	*ref_end_code= STAT_SUCCESS;
-	return (void*)ref_end_code;
+	if(live555_rtsp_mux_settings_ctx->multicast_address!= NULL) {
+		free(live555_rtsp_mux_settings_ctx->multicast_address);
+		live555_rtsp_mux_settings_ctx->multicast_address= NULL;
+	}
 }
 
 /* **** Elementary stream instance related implementation **** */
@@ -1329,6 +2336,8 @@ static proc_ctx_t* live555_rtsp_es_mux_open(const proc_if_t *proc_if,
 			live555_rtsp_es_mux_settings_ctx= NULL; // Do not release
 	UsageEnvironment *usageEnvironment= NULL; // Do not release
 	ServerMediaSession *serverMediaSession= NULL; // Do not release
+	live555_event_loop_t *live555_event_loop= NULL; // Do not release
+	live555_rtsp_es_mux_init_args_t live555_rtsp_es_mux_init_args;
 	LOG_CTX_INIT(log_ctx);
 
 	/* Check arguments */
@@ -1366,18 +2375,30 @@ static proc_ctx_t* live555_rtsp_es_mux_open(const proc_if_t *proc_if,
 	serverMediaSession= va_arg(arg, ServerMediaSession*);
 	CHECK_DO(serverMediaSession!= NULL, goto end);
 
+	live555_event_loop= va_arg(arg, live555_event_loop_t*);
+	CHECK_DO(live555_event_loop!= NULL, goto end);
+
+	live555_rtsp_es_mux_init_args.live555_rtsp_mux_settings_ctx=
+			va_arg(arg, volatile live555_rtsp_mux_settings_ctx_t*);
+	CHECK_DO(live555_rtsp_es_mux_init_args.live555_rtsp_mux_settings_ctx!=
+			NULL, goto end);
+
 	live555_rtsp_es_mux_ctx->taskScheduler=
 			&(usageEnvironment->taskScheduler());
 	CHECK_DO(live555_rtsp_es_mux_ctx->taskScheduler!= NULL, goto end);
+	live555_rtsp_es_mux_ctx->live555_event_loop= live555_event_loop;
 
-	live555_rtsp_es_mux_ctx->simpleMediaSubsession=
-			SimpleMediaSubsession::createNew(*usageEnvironment,
-					live555_rtsp_es_mux_settings_ctx->sdp_mimetype);
-	CHECK_DO(live555_rtsp_es_mux_ctx->simpleMediaSubsession!= NULL, goto end);
-
-	ret_code= serverMediaSession->addSubsession(
-			live555_rtsp_es_mux_ctx->simpleMediaSubsession);
-	CHECK_DO(ret_code== True, goto end);
+	/* Create the media sub-session(s); Live555 objects are not thread-safe,
+	 * thus are created in the event-loop thread.
+	 */
+	live555_rtsp_es_mux_init_args.live555_rtsp_es_mux_ctx=
+			live555_rtsp_es_mux_ctx;
+	live555_rtsp_es_mux_init_args.usageEnvironment= usageEnvironment;
+	live555_rtsp_es_mux_init_args.serverMediaSession= serverMediaSession;
+	live555_rtsp_es_mux_init_args.log_ctx= LOG_CTX_GET();
+	ret_code= live555_event_loop_run_sync(live555_event_loop,
+			live555_rtsp_es_mux_init_on_loop, &live555_rtsp_es_mux_init_args);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
 
     end_code= STAT_SUCCESS;
  end:
@@ -1387,28 +2408,127 @@ static proc_ctx_t* live555_rtsp_es_mux_open(const proc_if_t *proc_if,
 }
 
 /**
- * Implements the proc_if_s::close callback.
- * See .proc_if.h for further details.
+ * Create the Live555's RTSP ES-multiplexer media sub-session(s) and add
+ * them to the server media session (this function is executed in the
+ * event-loop thread).
+ * In multicast mode, the ES-multiplexer sub-session only distributes the
+ * frames to a single multicast stream, announced by a passive sub-session.
+ * @param t Pointer to the arguments structure
+ * (live555_rtsp_es_mux_init_args_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
  */
-static void live555_rtsp_es_mux_close(proc_ctx_t **ref_proc_ctx)
+static int live555_rtsp_es_mux_init_on_loop(void *t)
 {
-	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx= NULL;
+	const char *multicast_address;
+	live555_rtsp_es_mux_init_args_t *live555_rtsp_es_mux_init_args=
+			(live555_rtsp_es_mux_init_args_t*)t;
+	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx= NULL; // Do not release
+	volatile live555_rtsp_es_mux_settings_ctx_t *
+			live555_rtsp_es_mux_settings_ctx= NULL; // Do not release
+	volatile live555_rtsp_mux_settings_ctx_t *
+			live555_rtsp_mux_settings_ctx= NULL; // Do not release
+	ServerMediaSession *serverMediaSession= NULL; // Do not release
+	SimpleMediaSubsession *simpleMediaSubsession= NULL;
+	ServerMediaSubsession *serverMediaSubsession= NULL;
+	rtp_pacing_settings_t rtp_pacing_settings;
 	LOG_CTX_INIT(NULL);
-	LOGD(">>%s\n", __FUNCTION__); //comment-me
-
-	if(ref_proc_ctx== NULL)
-		return;
 
-	if((live555_rtsp_es_mux_ctx= (live555_rtsp_es_mux_ctx_t*)*ref_proc_ctx)!=
-			NULL) {
-		LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_es_mux_ctx)->log_ctx);
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_es_mux_init_args!= NULL, return STAT_ERROR);
 
-		/* Release settings */
-		live555_rtsp_es_mux_settings_ctx_deinit(
-				&live555_rtsp_es_mux_ctx->live555_rtsp_es_mux_settings_ctx,
-				LOG_CTX_GET());
+	LOG_CTX_SET(live555_rtsp_es_mux_init_args->log_ctx);
 
-		// Reserved for future use: release other new variables here...
+	live555_rtsp_es_mux_ctx=
+			live555_rtsp_es_mux_init_args->live555_rtsp_es_mux_ctx;
+	CHECK_DO(live555_rtsp_es_mux_ctx!= NULL, return STAT_ERROR);
+	live555_rtsp_es_mux_settings_ctx=
+			&live555_rtsp_es_mux_ctx->live555_rtsp_es_mux_settings_ctx;
+	live555_rtsp_mux_settings_ctx=
+			live555_rtsp_es_mux_init_args->live555_rtsp_mux_settings_ctx;
+	serverMediaSession= live555_rtsp_es_mux_init_args->serverMediaSession;
+	multicast_address=
+			(const char*)live555_rtsp_mux_settings_ctx->multicast_address;
+
+	/* Multicast mode: check that the new ES ports (RTP/RTCP pair following
+	 * the ones of the sub-sessions already added) fit in the port range.
+	 */
+	if(multicast_address!= NULL && strlen(multicast_address)> 0 &&
+			!MULTICAST_PORTS_FIT(live555_rtsp_mux_settings_ctx->multicast_port,
+			serverMediaSession->numSubsessions()+ 1)) {
+		LOGE("Multicast port out of range for elementary stream number %u\n",
+				serverMediaSession->numSubsessions()+ 1);
+		return STAT_EINVAL;
+	}
+
+	/* ES-multiplexer sub-session */
+	simpleMediaSubsession= SimpleMediaSubsession::createNew(
+			*live555_rtsp_es_mux_init_args->usageEnvironment,
+			live555_rtsp_es_mux_settings_ctx->sdp_mimetype,
+			live555_rtsp_es_mux_settings_ctx->gop_cache_max_bytes);
+	CHECK_DO(simpleMediaSubsession!= NULL, return STAT_ERROR);
+
+	rtp_pacing_settings.bitrate=
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_bitrate;
+	rtp_pacing_settings.headroom=
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_headroom;
+	rtp_pacing_settings.max_latency_msecs=
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_max_latency_msecs;
+	simpleMediaSubsession->setRTPPacing(&rtp_pacing_settings);
+	serverMediaSubsession= simpleMediaSubsession;
+
+	/* Multicast mode: each ES uses the next RTP/RTCP ports pair */
+	if(multicast_address!= NULL && strlen(multicast_address)> 0) {
+		portNumBits rtpPortNum= live555_rtsp_mux_settings_ctx->multicast_port+
+				2* serverMediaSession->numSubsessions();
+		serverMediaSubsession= SimpleMulticastMediaSubsession::createNew(
+				*live555_rtsp_es_mux_init_args->usageEnvironment,
+				simpleMediaSubsession, multicast_address, rtpPortNum,
+				(u_int8_t)live555_rtsp_mux_settings_ctx->multicast_ttl,
+				LOG_CTX_GET());
+		if(serverMediaSubsession== NULL) {
+			Medium::close(simpleMediaSubsession);
+			return STAT_ERROR;
+		}
+	}
+
+	/* Add to server media session (that takes ownership) */
+	if(serverMediaSession->addSubsession(serverMediaSubsession)!= True) {
+		LOGE("Could not add media sub-session\n");
+		Medium::close(serverMediaSubsession);
+		return STAT_ERROR;
+	}
+
+	live555_rtsp_es_mux_ctx->simpleMediaSubsession= simpleMediaSubsession;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Implements the proc_if_s::close callback.
+ * See .proc_if.h for further details.
+ */
+static void live555_rtsp_es_mux_close(proc_ctx_t **ref_proc_ctx)
+{
+	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+	LOGD(">>%s\n", __FUNCTION__); //comment-me
+
+	if(ref_proc_ctx== NULL)
+		return;
+
+	if((live555_rtsp_es_mux_ctx= (live555_rtsp_es_mux_ctx_t*)*ref_proc_ctx)!=
+			NULL) {
+		LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_es_mux_ctx)->log_ctx);
+
+		/* Stop encoder bit-rate adaptation control loop, if running */
+		bitrate_adapt_stop(live555_rtsp_es_mux_ctx);
+
+		/* Release settings */
+		live555_rtsp_es_mux_settings_ctx_deinit(
+				&live555_rtsp_es_mux_ctx->live555_rtsp_es_mux_settings_ctx,
+				LOG_CTX_GET());
+
+		// Reserved for future use: release other new variables here...
 
 		/* Release context structure */
 		free(live555_rtsp_es_mux_ctx);
@@ -1418,54 +2538,47 @@ static void live555_rtsp_es_mux_close(proc_ctx_t **ref_proc_ctx)
 }
 
 /**
- * Implements the proc_if_s::process_frame callback.
+ * Implements the proc_if_s::send_frame callback.
+ * The ES-multiplexer does not run a processing thread of its own: the frame
+ * is duplicated and directly queued into the Live555's "framed source" FIFO,
+ * and the scheduler event is triggered from the calling thread (namely, the
+ * multiplexer processing thread).
  * See .proc_if.h for further details.
  */
-static int live555_rtsp_es_mux_process_frame(proc_ctx_t *proc_ctx,
-		fifo_ctx_t* iput_fifo_ctx, fifo_ctx_t* oput_fifo_ctx)
+static int live555_rtsp_es_mux_send_frame(proc_ctx_t *proc_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx)
 {
-	int ret_code, end_code= STAT_ERROR;
+	int end_code= STAT_ERROR;
 	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx= NULL; //Do not release
-	proc_frame_ctx_t *proc_frame_ctx= NULL;
-	size_t fifo_elem_size= 0;
+	proc_frame_ctx_t *proc_frame_ctx_aux= NULL;
 	SimpleMediaSubsession *simpleMediaSubsession= NULL; //Do not release
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
 	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
-	CHECK_DO(iput_fifo_ctx!= NULL, return STAT_ERROR);
-	CHECK_DO(oput_fifo_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_frame_ctx!= NULL, return STAT_ERROR);
 
 	LOG_CTX_SET(proc_ctx->log_ctx);
 
 	/* Get multiplexer context */
 	live555_rtsp_es_mux_ctx= (live555_rtsp_es_mux_ctx_t*)proc_ctx;
 
-	/* Get input packet from FIFO buffer */
-	ret_code= fifo_get(iput_fifo_ctx, (void**)&proc_frame_ctx, &fifo_elem_size);
-	CHECK_DO(ret_code== STAT_SUCCESS || ret_code== STAT_EAGAIN, goto end);
-	if(ret_code== STAT_EAGAIN) {
-		/* This means FIFO was unblocked, just go out with EOF status */
-		end_code= STAT_EOF;
-		goto end;
-	}
-
-	/* Deliver frame to Live555's "framed source" */
 	simpleMediaSubsession= (SimpleMediaSubsession*)
 					live555_rtsp_es_mux_ctx->simpleMediaSubsession;
 	CHECK_DO(simpleMediaSubsession!= NULL, goto end);
-	simpleMediaSubsession->deliverFrame(&proc_frame_ctx);
 
-	end_code= STAT_SUCCESS;
+	/* Duplicate frame (the caller keeps the ownership of the given one) */
+	proc_frame_ctx_aux= proc_frame_ctx_dup(proc_frame_ctx);
+	CHECK_DO(proc_frame_ctx_aux!= NULL, goto end);
+
+	/* Deliver frame to Live555's "framed sources" (and GOP cache) */
+	end_code= simpleMediaSubsession->deliverFrame(&proc_frame_ctx_aux);
 end:
 	/* If 'deliverFrame()' method did not consume the frame (frame pointer
-	 * was not set to NULL), we must release frame and schedule to avoid
-	 * CPU-consuming closed loops.
+	 * was not set to NULL; e.g. on error), release it.
 	 */
-	if(proc_frame_ctx!= NULL) {
-		proc_frame_ctx_release(&proc_frame_ctx);
-		schedule();
-	}
+	if(proc_frame_ctx_aux!= NULL)
+		proc_frame_ctx_release(&proc_frame_ctx_aux);
 	return end_code;
 }
 
@@ -1480,8 +2593,14 @@ static int live555_rtsp_es_mux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 	volatile live555_rtsp_es_mux_settings_ctx_t *
 			live555_rtsp_es_mux_settings_ctx= NULL;
 	char *sdp_mimetype_str= NULL, *rtp_timestamp_freq_str= NULL,
-			*bit_rate_estimated_str= NULL;
+			*bit_rate_estimated_str= NULL, *gop_cache_max_bytes_str= NULL,
+			*rtp_pacing_bitrate_str= NULL, *rtp_pacing_headroom_str= NULL,
+			*rtp_pacing_max_latency_msecs_str= NULL,
+			*bitrate_adapt_min_str= NULL, *bitrate_adapt_max_str= NULL,
+			*bitrate_adapt_loss_high_str= NULL,
+			*bitrate_adapt_loss_low_str= NULL;
 	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+	rtp_pacing_settings_t rtp_pacing_settings;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
@@ -1528,6 +2647,97 @@ static int live555_rtsp_es_mux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 		if(rtp_timestamp_freq_str!= NULL)
 			live555_rtsp_es_mux_settings_ctx->rtp_timestamp_freq=
 					atoll(rtp_timestamp_freq_str);
+
+		/* 'gop_cache_max_bytes' */
+		gop_cache_max_bytes_str= uri_parser_query_str_get_value(
+				"gop_cache_max_bytes", str);
+		if(gop_cache_max_bytes_str!= NULL) {
+			long long gop_cache_max_bytes= atoll(gop_cache_max_bytes_str);
+			CHECK_DO(gop_cache_max_bytes>= 0,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->gop_cache_max_bytes=
+					(size_t)gop_cache_max_bytes;
+		}
+
+		/* 'rtp_pacing_bitrate' */
+		rtp_pacing_bitrate_str= uri_parser_query_str_get_value(
+				"rtp_pacing_bitrate", str);
+		if(rtp_pacing_bitrate_str!= NULL) {
+			long long rtp_pacing_bitrate= atoll(rtp_pacing_bitrate_str);
+			CHECK_DO(rtp_pacing_bitrate>= 0 && rtp_pacing_bitrate<= UINT_MAX,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_bitrate=
+					(unsigned int)rtp_pacing_bitrate;
+		}
+
+		/* 'rtp_pacing_headroom' */
+		rtp_pacing_headroom_str= uri_parser_query_str_get_value(
+				"rtp_pacing_headroom", str);
+		if(rtp_pacing_headroom_str!= NULL) {
+			int rtp_pacing_headroom= atoi(rtp_pacing_headroom_str);
+			CHECK_DO(rtp_pacing_headroom>= 0 && rtp_pacing_headroom<= 1000,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_headroom=
+					(unsigned int)rtp_pacing_headroom;
+		}
+
+		/* 'rtp_pacing_max_latency_msecs' */
+		rtp_pacing_max_latency_msecs_str= uri_parser_query_str_get_value(
+				"rtp_pacing_max_latency_msecs", str);
+		if(rtp_pacing_max_latency_msecs_str!= NULL) {
+			int rtp_pacing_max_latency_msecs= atoi(
+					rtp_pacing_max_latency_msecs_str);
+			CHECK_DO(rtp_pacing_max_latency_msecs>= 0,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_max_latency_msecs=
+					(unsigned int)rtp_pacing_max_latency_msecs;
+		}
+
+		/* 'bitrate_adapt_min' */
+		bitrate_adapt_min_str= uri_parser_query_str_get_value(
+				"bitrate_adapt_min", str);
+		if(bitrate_adapt_min_str!= NULL) {
+			long long bitrate_adapt_min= atoll(bitrate_adapt_min_str);
+			CHECK_DO(bitrate_adapt_min> 0 && bitrate_adapt_min<= UINT_MAX,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_min=
+					(unsigned int)bitrate_adapt_min;
+		}
+
+		/* 'bitrate_adapt_max' */
+		bitrate_adapt_max_str= uri_parser_query_str_get_value(
+				"bitrate_adapt_max", str);
+		if(bitrate_adapt_max_str!= NULL) {
+			long long bitrate_adapt_max= atoll(bitrate_adapt_max_str);
+			CHECK_DO(bitrate_adapt_max>= 0 && bitrate_adapt_max<= UINT_MAX,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max=
+					(unsigned int)bitrate_adapt_max;
+		}
+
+		/* 'bitrate_adapt_loss_high' */
+		bitrate_adapt_loss_high_str= uri_parser_query_str_get_value(
+				"bitrate_adapt_loss_high", str);
+		if(bitrate_adapt_loss_high_str!= NULL) {
+			int bitrate_adapt_loss_high= atoi(bitrate_adapt_loss_high_str);
+			CHECK_DO(bitrate_adapt_loss_high> 0 &&
+					bitrate_adapt_loss_high<= 100,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_high=
+					(unsigned int)bitrate_adapt_loss_high;
+		}
+
+		/* 'bitrate_adapt_loss_low' */
+		bitrate_adapt_loss_low_str= uri_parser_query_str_get_value(
+				"bitrate_adapt_loss_low", str);
+		if(bitrate_adapt_loss_low_str!= NULL) {
+			int bitrate_adapt_loss_low= atoi(bitrate_adapt_loss_low_str);
+			CHECK_DO(bitrate_adapt_loss_low>= 0 &&
+					bitrate_adapt_loss_low<= 100,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_low=
+					(unsigned int)bitrate_adapt_loss_low;
+		}
 	} else {
 
 		/* In the case string format is JSON-REST, parse to cJSON structure */
@@ -1556,10 +2766,113 @@ static int live555_rtsp_es_mux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 		if(cjson_aux!= NULL)
 			live555_rtsp_es_mux_settings_ctx->rtp_timestamp_freq=
 					cjson_aux->valuedouble;
+
+		/* 'gop_cache_max_bytes' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "gop_cache_max_bytes");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble>= 0,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->gop_cache_max_bytes=
+					(size_t)cjson_aux->valuedouble;
+		}
+
+		/* 'rtp_pacing_bitrate' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "rtp_pacing_bitrate");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble>= 0 &&
+					cjson_aux->valuedouble<= UINT_MAX,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_bitrate=
+					(unsigned int)cjson_aux->valuedouble;
+		}
+
+		/* 'rtp_pacing_headroom' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "rtp_pacing_headroom");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble>= 0 &&
+					cjson_aux->valuedouble<= 1000,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_headroom=
+					(unsigned int)cjson_aux->valuedouble;
+		}
+
+		/* 'rtp_pacing_max_latency_msecs' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest,
+				"rtp_pacing_max_latency_msecs");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble>= 0,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_max_latency_msecs=
+					(unsigned int)cjson_aux->valuedouble;
+		}
+
+		/* 'bitrate_adapt_min' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "bitrate_adapt_min");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble> 0 &&
+					cjson_aux->valuedouble<= UINT_MAX,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_min=
+					(unsigned int)cjson_aux->valuedouble;
+		}
+
+		/* 'bitrate_adapt_max' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "bitrate_adapt_max");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble>= 0 &&
+					cjson_aux->valuedouble<= UINT_MAX,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max=
+					(unsigned int)cjson_aux->valuedouble;
+		}
+
+		/* 'bitrate_adapt_loss_high' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "bitrate_adapt_loss_high");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble> 0 &&
+					cjson_aux->valuedouble<= 100,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_high=
+					(unsigned int)cjson_aux->valuedouble;
+		}
+
+		/* 'bitrate_adapt_loss_low' */
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "bitrate_adapt_loss_low");
+		if(cjson_aux!= NULL) {
+			CHECK_DO(cjson_aux->valuedouble>= 0 &&
+					cjson_aux->valuedouble<= 100,
+					end_code= STAT_EINVAL; goto end);
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_low=
+					(unsigned int)cjson_aux->valuedouble;
+		}
 	}
 
+	/* Check bit-rate adaptation settings consistency */
+	CHECK_DO(live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_low<
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_high,
+			end_code= STAT_EINVAL; goto end);
+	CHECK_DO(live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max== 0 ||
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max>=
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_min,
+			end_code= STAT_EINVAL; goto end);
+
 	/* Finally that we have new settings parsed, reset MUXER */
 	// Reserved for future use
+	/* The GOP cache bound can be updated on the fly; RTP pacing settings
+	 * apply to the client sessions set-up from now on.
+	 */
+	if(live555_rtsp_es_mux_ctx->simpleMediaSubsession!= NULL) {
+		live555_rtsp_es_mux_ctx->simpleMediaSubsession->setGopCacheMaxBytes(
+				live555_rtsp_es_mux_settings_ctx->gop_cache_max_bytes);
+		rtp_pacing_settings.bitrate=
+				live555_rtsp_es_mux_settings_ctx->rtp_pacing_bitrate;
+		rtp_pacing_settings.headroom=
+				live555_rtsp_es_mux_settings_ctx->rtp_pacing_headroom;
+		rtp_pacing_settings.max_latency_msecs=
+				live555_rtsp_es_mux_settings_ctx->rtp_pacing_max_latency_msecs;
+		live555_rtsp_es_mux_ctx->simpleMediaSubsession->setRTPPacing(
+				&rtp_pacing_settings);
+	}
 
 	end_code= STAT_SUCCESS;
 end:
@@ -1569,6 +2882,22 @@ end:
 		free(rtp_timestamp_freq_str);
 	if(bit_rate_estimated_str!= NULL)
 		free(bit_rate_estimated_str);
+	if(gop_cache_max_bytes_str!= NULL)
+		free(gop_cache_max_bytes_str);
+	if(rtp_pacing_bitrate_str!= NULL)
+		free(rtp_pacing_bitrate_str);
+	if(rtp_pacing_headroom_str!= NULL)
+		free(rtp_pacing_headroom_str);
+	if(rtp_pacing_max_latency_msecs_str!= NULL)
+		free(rtp_pacing_max_latency_msecs_str);
+	if(bitrate_adapt_min_str!= NULL)
+		free(bitrate_adapt_min_str);
+	if(bitrate_adapt_max_str!= NULL)
+		free(bitrate_adapt_max_str);
+	if(bitrate_adapt_loss_high_str!= NULL)
+		free(bitrate_adapt_loss_high_str);
+	if(bitrate_adapt_loss_low_str!= NULL)
+		free(bitrate_adapt_loss_low_str);
 	if(cjson_rest!= NULL)
 		cJSON_Delete(cjson_rest);
 	return end_code;
@@ -1606,7 +2935,15 @@ static int live555_rtsp_es_mux_rest_get(proc_ctx_t *proc_ctx,
 	 * {
 	 *     // "settings":{}, //RAL: Do not expose in current implementation!
 	 *     "sdp_mimetype":string,
-	 *     "rtp_timestamp_freq":number
+	 *     "rtp_timestamp_freq":number,
+	 *     "gop_cache_max_bytes":number,
+	 *     "rtp_pacing_bitrate":number,
+	 *     "rtp_pacing_headroom":number,
+	 *     "rtp_pacing_max_latency_msecs":number,
+	 *     "bitrate_adapt_min":number,
+	 *     "bitrate_adapt_max":number,
+	 *     "bitrate_adapt_loss_high":number,
+	 *     "bitrate_adapt_loss_low":number
 	 *     ... // Reserved for future use
 	 * }
 	 */
@@ -1640,6 +2977,55 @@ static int live555_rtsp_es_mux_rest_get(proc_ctx_t *proc_ctx,
 	CHECK_DO(cjson_aux!= NULL, goto end);
 	cJSON_AddItemToObject(cjson_rest, "rtp_timestamp_freq", cjson_aux);
 
+	/* 'gop_cache_max_bytes' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->gop_cache_max_bytes);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "gop_cache_max_bytes", cjson_aux);
+
+	/* 'rtp_pacing_bitrate' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_bitrate);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "rtp_pacing_bitrate", cjson_aux);
+
+	/* 'rtp_pacing_headroom' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_headroom);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "rtp_pacing_headroom", cjson_aux);
+
+	/* 'rtp_pacing_max_latency_msecs' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->rtp_pacing_max_latency_msecs);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "rtp_pacing_max_latency_msecs",
+			cjson_aux);
+
+	/* 'bitrate_adapt_min' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_min);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "bitrate_adapt_min", cjson_aux);
+
+	/* 'bitrate_adapt_max' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "bitrate_adapt_max", cjson_aux);
+
+	/* 'bitrate_adapt_loss_high' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_high);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "bitrate_adapt_loss_high", cjson_aux);
+
+	/* 'bitrate_adapt_loss_low' */
+	cjson_aux= cJSON_CreateNumber((double)
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_low);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_rest, "bitrate_adapt_loss_low", cjson_aux);
+
 	// Reserved for future use
 	/* Example:
 	 * cjson_aux= cJSON_CreateNumber((double)live555_rtsp_es_mux_ctx->var1);
@@ -1675,6 +3061,560 @@ end:
 	return end_code;
 }
 
+/**
+ * Implements the proc_if_s::stats_get_stream callback.
+ * See .proc_if.h for further details.
+ */
+static int live555_rtsp_es_mux_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx)
+{
+	int i, rtcp_rr_stats_num= 0, end_code= STAT_ERROR;
+	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx= NULL;
+	size_t gop_cache_frames= 0, gop_cache_bytes= 0, rtp_pacing_queue_bytes= 0;
+	uint64_t gop_cache_overflows= 0;
+	rtcp_rr_stats_t *rtcp_rr_stats_array= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	/* Members to be written:
+	 *     "elementary_stream_id":number,
+	 *     "gop_cache_frames":number,
+	 *     "gop_cache_bytes":number,
+	 *     "gop_cache_overflows":number,
+	 *     "rtp_pacing_queue_bytes":number,
+	 *     "bitrate_adapt_bitrate":number,
+	 *     "rtcp_receivers":
+	 *     [
+	 *         {
+	 *             "ssrc":number,
+	 *             "address":string,
+	 *             "fraction_lost":number,
+	 *             "packets_lost":number,
+	 *             "jitter_msecs":number,
+	 *             "rtt_msecs":number,
+	 *             "report_age_msecs":number
+	 *         },
+	 *         ...
+	 *     ]
+	 *     ... // Reserved for future use
+	 * Writing errors are "sticky" (see .json_writer.h): only the status of
+	 * the last write is checked.
+	 */
+
+	live555_rtsp_es_mux_ctx= (live555_rtsp_es_mux_ctx_t*)proc_ctx;
+
+	/* 'elementary_stream_id' (== ES-processor Id.) */
+	json_writer_int(json_writer_ctx, "elementary_stream_id",
+			proc_ctx->proc_instance_index);
+
+	/* GOP cache current status */
+	if(live555_rtsp_es_mux_ctx->simpleMediaSubsession!= NULL)
+		live555_rtsp_es_mux_ctx->simpleMediaSubsession->getGopCacheStats(
+				&gop_cache_frames, &gop_cache_bytes, &gop_cache_overflows);
+	json_writer_int(json_writer_ctx, "gop_cache_frames",
+			(int64_t)gop_cache_frames);
+	json_writer_int(json_writer_ctx, "gop_cache_bytes",
+			(int64_t)gop_cache_bytes);
+	json_writer_int(json_writer_ctx, "gop_cache_overflows",
+			(int64_t)gop_cache_overflows);
+
+	/* Bytes queued in the RTP pacers */
+	if(live555_rtsp_es_mux_ctx->simpleMediaSubsession!= NULL)
+		rtp_pacing_queue_bytes= live555_rtsp_es_mux_ctx->
+				simpleMediaSubsession->getRTPPacingQueueBytes();
+	json_writer_int(json_writer_ctx, "rtp_pacing_queue_bytes",
+			(int64_t)rtp_pacing_queue_bytes);
+
+	/* Current encoder bit-rate (zero if no encoder is bound) */
+	json_writer_int(json_writer_ctx, "bitrate_adapt_bitrate",
+			(int64_t)live555_rtsp_es_mux_ctx->bitrate_adapt_ctx.bitrate);
+
+	/* RTCP receiver-reports statistics */
+	rtcp_rr_stats_array= (rtcp_rr_stats_t*)calloc(RTCP_RECEIVERS_MAX,
+			sizeof(rtcp_rr_stats_t));
+	CHECK_DO(rtcp_rr_stats_array!= NULL, goto end);
+	if(live555_rtsp_es_mux_rtcp_stats_get(live555_rtsp_es_mux_ctx,
+			rtcp_rr_stats_array, &rtcp_rr_stats_num)!= STAT_SUCCESS)
+		rtcp_rr_stats_num= 0;
+	json_writer_array_start(json_writer_ctx, "rtcp_receivers");
+	for(i= 0; i< rtcp_rr_stats_num; i++) {
+		rtcp_rr_stats_t *rtcp_rr_stats= &rtcp_rr_stats_array[i];
+
+		json_writer_object_start(json_writer_ctx, NULL);
+		json_writer_int(json_writer_ctx, "ssrc",
+				(int64_t)rtcp_rr_stats->ssrc);
+		json_writer_string(json_writer_ctx, "address",
+				rtcp_rr_stats->address);
+		json_writer_double(json_writer_ctx, "fraction_lost",
+				rtcp_rr_stats->fraction_lost);
+		json_writer_int(json_writer_ctx, "packets_lost",
+				(int64_t)rtcp_rr_stats->packets_lost);
+		json_writer_double(json_writer_ctx, "jitter_msecs",
+				rtcp_rr_stats->jitter_msecs);
+		json_writer_double(json_writer_ctx, "rtt_msecs",
+				rtcp_rr_stats->rtt_msecs);
+		json_writer_int(json_writer_ctx, "report_age_msecs",
+				(int64_t)(rtcp_rr_stats->report_age_usecs/ 1000));
+		json_writer_object_end(json_writer_ctx);
+	}
+	end_code= json_writer_array_end(json_writer_ctx);
+end:
+	if(rtcp_rr_stats_array!= NULL)
+		free(rtcp_rr_stats_array);
+	return end_code;
+}
+
+/**
+ * Implements the proc_if_s::opt callback.
+ * Options:
+ * - "PROCS_ID_ES_MUX_BITRATE_ADAPT": bind an encoder to the elementary
+ * stream for bit-rate adaptation; arguments are the PROCS module instance
+ * (procs_ctx_t*) and the Id. (int) of the encoder processor. Passing a NULL
+ * instance or a negative Id. unbinds the encoder (if any). Binding fails if
+ * the processor does not exist or does not expose a bit-rate setting. The
+ * PROCS module instance must not be released while bound; if the encoder
+ * is deleted, the adaptation stops at the next update.
+ * See .proc_if.h for further details.
+ */
+static int live555_rtsp_es_mux_opt(proc_ctx_t *proc_ctx, const char *tag,
+		va_list arg)
+{
+	int end_code= STAT_ERROR;
+	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(tag!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	live555_rtsp_es_mux_ctx= (live555_rtsp_es_mux_ctx_t*)proc_ctx;
+
+	if(TAG_IS("PROCS_ID_ES_MUX_BITRATE_ADAPT")) {
+		procs_ctx_t *procs_ctx= va_arg(arg, procs_ctx_t*);
+		int proc_id= va_arg(arg, int);
+
+		bitrate_adapt_stop(live555_rtsp_es_mux_ctx);
+		end_code= STAT_SUCCESS;
+		if(procs_ctx!= NULL && proc_id>= 0)
+			end_code= bitrate_adapt_start(live555_rtsp_es_mux_ctx, procs_ctx,
+					proc_id);
+	} else {
+		LOGE("Unknown option\n");
+		end_code= STAT_ENOTFOUND;
+	}
+	return end_code;
+}
+
+/**
+ * Arguments for getting the RTCP receiver-reports statistics in the
+ * event-loop thread (see 'live555_rtsp_es_mux_rtcp_stats_get_on_loop()').
+ */
+typedef struct live555_rtsp_es_mux_rtcp_stats_args_s {
+	SimpleMediaSubsession *simpleMediaSubsession;
+	rtcp_rr_stats_t *rtcp_rr_stats_array;
+	int num;
+} live555_rtsp_es_mux_rtcp_stats_args_t;
+
+/**
+ * Get the RTCP receiver-reports statistics of the clients playing the
+ * given elementary stream.
+ * @param live555_rtsp_es_mux_ctx
+ * @param rtcp_rr_stats_array Array of at least RTCP_RECEIVERS_MAX elements
+ * to be filled.
+ * @param ref_num Reference to the number of receivers reported.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_es_mux_rtcp_stats_get(
+		live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx,
+		rtcp_rr_stats_t *rtcp_rr_stats_array, int *ref_num)
+{
+	int ret_code;
+	live555_rtsp_es_mux_rtcp_stats_args_t live555_rtsp_es_mux_rtcp_stats_args;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_es_mux_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(rtcp_rr_stats_array!= NULL, return STAT_ERROR);
+	CHECK_DO(ref_num!= NULL, return STAT_ERROR);
+
+	*ref_num= 0;
+
+	if(live555_rtsp_es_mux_ctx->simpleMediaSubsession== NULL ||
+			live555_rtsp_es_mux_ctx->live555_event_loop== NULL)
+		return STAT_SUCCESS;
+
+	/* Live555 objects are only accessed in the event-loop thread */
+	live555_rtsp_es_mux_rtcp_stats_args.simpleMediaSubsession=
+			live555_rtsp_es_mux_ctx->simpleMediaSubsession;
+	live555_rtsp_es_mux_rtcp_stats_args.rtcp_rr_stats_array=
+			rtcp_rr_stats_array;
+	live555_rtsp_es_mux_rtcp_stats_args.num= 0;
+	ret_code= live555_event_loop_run_sync(
+			live555_rtsp_es_mux_ctx->live555_event_loop,
+			live555_rtsp_es_mux_rtcp_stats_get_on_loop,
+			&live555_rtsp_es_mux_rtcp_stats_args);
+	CHECK_DO(ret_code== STAT_SUCCESS, return STAT_ERROR);
+
+	*ref_num= live555_rtsp_es_mux_rtcp_stats_args.num;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Get the RTCP receiver-reports statistics (this function is executed in
+ * the event-loop thread).
+ * @param t Pointer to the arguments structure
+ * (live555_rtsp_es_mux_rtcp_stats_args_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_es_mux_rtcp_stats_get_on_loop(void *t)
+{
+	live555_rtsp_es_mux_rtcp_stats_args_t *live555_rtsp_es_mux_rtcp_stats_args=
+			(live555_rtsp_es_mux_rtcp_stats_args_t*)t;
+	LOG_CTX_INIT(NULL);
+
+	CHECK_DO(live555_rtsp_es_mux_rtcp_stats_args!= NULL, return STAT_ERROR);
+
+	live555_rtsp_es_mux_rtcp_stats_args->num=
+			live555_rtsp_es_mux_rtcp_stats_args->simpleMediaSubsession->
+			getRTCPStats(live555_rtsp_es_mux_rtcp_stats_args->
+					rtcp_rr_stats_array, RTCP_RECEIVERS_MAX);
+	return STAT_SUCCESS;
+}
+
+/**
+ * Bind the given encoder processor to the elementary stream and launch the
+ * bit-rate adaptation control thread.
+ * @param live555_rtsp_es_mux_ctx
+ * @param procs_ctx PROCS module instance the encoder belongs to.
+ * @param proc_id Encoder processor Id.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int bitrate_adapt_start(
+		live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx,
+		procs_ctx_t *procs_ctx, int proc_id)
+{
+	int ret_code, end_code= STAT_ERROR;
+	unsigned int bitrate= 0;
+	bitrate_adapt_ctx_t *bitrate_adapt_ctx= NULL;
+	volatile live555_rtsp_es_mux_settings_ctx_t *
+			live555_rtsp_es_mux_settings_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_es_mux_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_id>= 0, return STAT_ERROR);
+
+	LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_es_mux_ctx)->log_ctx);
+
+	bitrate_adapt_ctx= &live555_rtsp_es_mux_ctx->bitrate_adapt_ctx;
+	CHECK_DO(bitrate_adapt_ctx->procs_ctx== NULL, return STAT_ERROR);
+	live555_rtsp_es_mux_settings_ctx=
+			&live555_rtsp_es_mux_ctx->live555_rtsp_es_mux_settings_ctx;
+
+	/* Check the encoder and get its name and current bit-rate */
+	bitrate_adapt_ctx->procs_ctx= procs_ctx;
+	bitrate_adapt_ctx->proc_id= proc_id;
+	ret_code= bitrate_adapt_encoder_get(bitrate_adapt_ctx,
+			&bitrate_adapt_ctx->proc_name, &bitrate, LOG_CTX_GET());
+	if(ret_code!= STAT_SUCCESS) {
+		end_code= ret_code;
+		goto end;
+	}
+
+	bitrate_adapt_ctx->interr_usleep_ctx= interr_usleep_open();
+	CHECK_DO(bitrate_adapt_ctx->interr_usleep_ctx!= NULL, goto end);
+
+	bitrate_adapt_ctx->bitrate= bitrate;
+	bitrate_adapt_ctx->bitrate_max=
+			(live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max> 0)?
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max: bitrate;
+	bitrate_adapt_ctx->clear_reports= 0;
+	bitrate_adapt_ctx->flag_exit= 0;
+	ret_code= pthread_create(&bitrate_adapt_ctx->thread, NULL,
+			bitrate_adapt_thr, live555_rtsp_es_mux_ctx);
+	if(ret_code!= 0) {
+		LOGE("Could not launch bit-rate adaptation thread\n");
+		interr_usleep_close(&bitrate_adapt_ctx->interr_usleep_ctx);
+		goto end;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS) {
+		if(bitrate_adapt_ctx->proc_name!= NULL) {
+			free(bitrate_adapt_ctx->proc_name);
+			bitrate_adapt_ctx->proc_name= NULL;
+		}
+		bitrate_adapt_ctx->procs_ctx= NULL;
+		bitrate_adapt_ctx->proc_id= -1;
+		bitrate_adapt_ctx->bitrate= 0;
+	}
+	return end_code;
+}
+
+/**
+ * Stop the bit-rate adaptation control thread and unbind the encoder, if
+ * applicable.
+ * @param live555_rtsp_es_mux_ctx
+ */
+static void bitrate_adapt_stop(
+		live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx)
+{
+	bitrate_adapt_ctx_t *bitrate_adapt_ctx= NULL;
+
+	if(live555_rtsp_es_mux_ctx== NULL)
+		return;
+
+	bitrate_adapt_ctx= &live555_rtsp_es_mux_ctx->bitrate_adapt_ctx;
+	if(bitrate_adapt_ctx->procs_ctx== NULL)
+		return;
+
+	/* Join control thread:
+	 * - set exit flag and unlock interruptible usleep module instance;
+	 * - join the thread;
+	 * - release (close) the interruptible usleep module instance.
+	 */
+	bitrate_adapt_ctx->flag_exit= 1;
+	interr_usleep_unblock(bitrate_adapt_ctx->interr_usleep_ctx);
+	pthread_join(bitrate_adapt_ctx->thread, NULL);
+	interr_usleep_close(&bitrate_adapt_ctx->interr_usleep_ctx);
+
+	if(bitrate_adapt_ctx->proc_name!= NULL) {
+		free(bitrate_adapt_ctx->proc_name);
+		bitrate_adapt_ctx->proc_name= NULL;
+	}
+	bitrate_adapt_ctx->procs_ctx= NULL;
+	bitrate_adapt_ctx->proc_id= -1;
+	bitrate_adapt_ctx->bitrate= 0;
+}
+
+/**
+ * Encoder bit-rate adaptation control thread.
+ * Each period, the worst loss among the receivers that have reported since
+ * the previous period is fed to the AIMD law; if the resulting bit-rate
+ * differs from the current one, it is applied to the encoder.
+ * @param t Pointer to the ES-multiplexer context structure
+ * (live555_rtsp_es_mux_ctx_t).
+ * @return NULL.
+ */
+static void* bitrate_adapt_thr(void *t)
+{
+	live555_rtsp_es_mux_ctx_t *live555_rtsp_es_mux_ctx=
+			(live555_rtsp_es_mux_ctx_t*)t;
+	bitrate_adapt_ctx_t *bitrate_adapt_ctx= NULL;
+	volatile live555_rtsp_es_mux_settings_ctx_t *
+			live555_rtsp_es_mux_settings_ctx= NULL;
+	rtcp_rr_stats_t *rtcp_rr_stats_array= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_es_mux_ctx!= NULL, return NULL);
+
+	LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_es_mux_ctx)->log_ctx);
+
+	schedule_set_thread_name("bradapt-%d",
+			((proc_ctx_t*)live555_rtsp_es_mux_ctx)->proc_instance_index);
+
+	bitrate_adapt_ctx= &live555_rtsp_es_mux_ctx->bitrate_adapt_ctx;
+	live555_rtsp_es_mux_settings_ctx=
+			&live555_rtsp_es_mux_ctx->live555_rtsp_es_mux_settings_ctx;
+
+	rtcp_rr_stats_array= (rtcp_rr_stats_t*)calloc(RTCP_RECEIVERS_MAX,
+			sizeof(rtcp_rr_stats_t));
+	CHECK_DO(rtcp_rr_stats_array!= NULL, goto end);
+
+	while(bitrate_adapt_ctx->flag_exit== 0) {
+		register int ret_code;
+		int i, rtcp_rr_stats_num= 0, flag_reported= 0;
+		double loss_percent= 0;
+		unsigned int bitrate;
+
+		/* Sleep given time (interruptible by external thread) */
+		ret_code= interr_usleep(bitrate_adapt_ctx->interr_usleep_ctx,
+				BITRATE_ADAPT_PERIOD_USECS);
+		ASSERT(ret_code== STAT_SUCCESS || ret_code== STAT_EINTR);
+		if(bitrate_adapt_ctx->flag_exit!= 0)
+			break;
+
+		/* Get the worst loss among the receivers' new reports (the reports
+		 * received in the last period; each report is considered once).
+		 */
+		ret_code= live555_rtsp_es_mux_rtcp_stats_get(live555_rtsp_es_mux_ctx,
+				rtcp_rr_stats_array, &rtcp_rr_stats_num);
+		if(ret_code!= STAT_SUCCESS)
+			continue;
+		for(i= 0; i< rtcp_rr_stats_num; i++) {
+			rtcp_rr_stats_t *rtcp_rr_stats= &rtcp_rr_stats_array[i];
+			if(rtcp_rr_stats->report_age_usecs< 0 ||
+					rtcp_rr_stats->report_age_usecs>=
+							BITRATE_ADAPT_PERIOD_USECS)
+				continue;
+			flag_reported= 1;
+			if(rtcp_rr_stats->fraction_lost* 100.0> loss_percent)
+				loss_percent= rtcp_rr_stats->fraction_lost* 100.0;
+		}
+		if(flag_reported== 0)
+			continue;
+
+		/* Apply AIMD law and update encoder if applicable */
+		bitrate= bitrate_adapt_update(bitrate_adapt_ctx,
+				live555_rtsp_es_mux_settings_ctx, loss_percent);
+		if(bitrate!= bitrate_adapt_ctx->bitrate) {
+			char settings_str[128];
+
+			/* Check the encoder was not deleted (and its Id. reused by a
+			 * processor of another type) since the last update.
+			 */
+			if(bitrate_adapt_encoder_get(bitrate_adapt_ctx, NULL, NULL,
+					LOG_CTX_GET())!= STAT_SUCCESS) {
+				LOGW("Encoder (Id. %d) is no longer available; bit-rate "
+						"adaptation stopped\n", bitrate_adapt_ctx->proc_id);
+				bitrate_adapt_ctx->bitrate= 0;
+				break;
+			}
+
+			snprintf(settings_str, sizeof(settings_str), "%s=%u",
+					BITRATE_ADAPT_ENCODER_SETTING, bitrate);
+			ret_code= procs_opt(bitrate_adapt_ctx->procs_ctx, "PROCS_ID_PUT",
+					bitrate_adapt_ctx->proc_id, settings_str);
+			if(ret_code!= STAT_SUCCESS) {
+				LOGE("Could not set encoder (Id. %d) bit-rate\n",
+						bitrate_adapt_ctx->proc_id);
+				continue;
+			}
+			LOGD("Encoder (Id. %d) bit-rate: %u -> %u bps (loss %.1f%%)\n",
+					bitrate_adapt_ctx->proc_id, bitrate_adapt_ctx->bitrate,
+					bitrate, loss_percent);
+			bitrate_adapt_ctx->bitrate= bitrate;
+		}
+	}
+
+end:
+	if(rtcp_rr_stats_array!= NULL)
+		free(rtcp_rr_stats_array);
+	return NULL;
+}
+
+/**
+ * Get the bound encoder processor name and current bit-rate (the settings
+ * may be exposed at the representation root or in its "settings" object).
+ * If the encoder name is already known (see 'bitrate_adapt_ctx_s'), it is
+ * checked instead.
+ * @param bitrate_adapt_ctx
+ * @param ref_proc_name Reference to the encoder name to be returned
+ * (allocated; to be released by the caller). If NULL, the encoder name is
+ * checked against the one in 'bitrate_adapt_ctx'.
+ * @param ref_bitrate Reference to the current encoder bit-rate to be
+ * returned (optional, may be NULL).
+ * @param log_ctx Pointer to the LOG module context structure.
+ * @return Status code (STAT_SUCCESS code in case of success; STAT_ENOTFOUND
+ * if the processor does not exist or is not the bound encoder; STAT_EINVAL
+ * if the processor does not expose a bit-rate setting; for other code
+ * values please refer to .stat_codes.h).
+ */
+static int bitrate_adapt_encoder_get(bitrate_adapt_ctx_t *bitrate_adapt_ctx,
+		char **ref_proc_name, unsigned int *ref_bitrate, log_ctx_t *log_ctx)
+{
+	int end_code= STAT_ERROR;
+	char *rest_str= NULL;
+	cJSON *cjson_rest= NULL;
+	cJSON *cjson_settings= NULL, *cjson_aux= NULL; // Do not release
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(bitrate_adapt_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(ref_proc_name!= NULL || bitrate_adapt_ctx->proc_name!= NULL,
+			return STAT_ERROR);
+
+	if(procs_opt(bitrate_adapt_ctx->procs_ctx, "PROCS_ID_GET",
+			bitrate_adapt_ctx->proc_id, &rest_str)!= STAT_SUCCESS ||
+			rest_str== NULL) {
+		LOGE("Could not get encoder (Id. %d) settings\n",
+				bitrate_adapt_ctx->proc_id);
+		end_code= STAT_ENOTFOUND;
+		goto end;
+	}
+	cjson_rest= cJSON_Parse(rest_str);
+	CHECK_DO(cjson_rest!= NULL, goto end);
+	cjson_settings= cJSON_GetObjectItem(cjson_rest, "settings");
+
+	/* Encoder name */
+	if(cjson_settings== NULL ||
+			(cjson_aux= cJSON_GetObjectItem(cjson_settings, "proc_name"))==
+					NULL || cjson_aux->valuestring== NULL) {
+		end_code= STAT_ENOTFOUND;
+		goto end;
+	}
+	if(ref_proc_name== NULL) {
+		if(strcmp(cjson_aux->valuestring, bitrate_adapt_ctx->proc_name)!= 0) {
+			LOGE("Processor Id. %d is not the bound encoder ('%s')\n",
+					bitrate_adapt_ctx->proc_id, bitrate_adapt_ctx->proc_name);
+			end_code= STAT_ENOTFOUND;
+			goto end;
+		}
+	}
+
+	/* Encoder bit-rate */
+	if(cjson_settings== NULL || (cjson_aux= cJSON_GetObjectItem(
+			cjson_settings, BITRATE_ADAPT_ENCODER_SETTING))== NULL)
+		cjson_aux= cJSON_GetObjectItem(cjson_rest,
+				BITRATE_ADAPT_ENCODER_SETTING);
+	if(cjson_aux== NULL || cjson_aux->valuedouble<= 0 ||
+			cjson_aux->valuedouble> UINT_MAX) {
+		LOGE("Processor Id. %d does not expose a '%s' setting\n",
+				bitrate_adapt_ctx->proc_id, BITRATE_ADAPT_ENCODER_SETTING);
+		end_code= STAT_EINVAL;
+		goto end;
+	}
+	if(ref_bitrate!= NULL)
+		*ref_bitrate= (unsigned int)cjson_aux->valuedouble;
+
+	if(ref_proc_name!= NULL) {
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "proc_name");
+		*ref_proc_name= strdup(cjson_aux->valuestring);
+		CHECK_DO(*ref_proc_name!= NULL, goto end);
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(rest_str!= NULL)
+		free(rest_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return end_code;
+}
+
+/**
+ * Apply the AIMD bit-rate law (see 'bitrate_adapt_aimd()') with the
+ * elementary stream settings.
+ * @param bitrate_adapt_ctx
+ * @param live555_rtsp_es_mux_settings_ctx
+ * @param loss_percent Worst loss percentage reported.
+ * @return New bit-rate, in bits per second.
+ */
+static unsigned int bitrate_adapt_update(bitrate_adapt_ctx_t *bitrate_adapt_ctx,
+		volatile live555_rtsp_es_mux_settings_ctx_t *
+		live555_rtsp_es_mux_settings_ctx, double loss_percent)
+{
+	return bitrate_adapt_aimd(bitrate_adapt_ctx->bitrate,
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_min,
+			bitrate_adapt_ctx->bitrate_max,
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_high,
+			live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_low,
+			loss_percent, &bitrate_adapt_ctx->clear_reports);
+}
+
 static int live555_rtsp_es_mux_settings_ctx_init(
 		volatile live555_rtsp_es_mux_settings_ctx_t *
 		live555_rtsp_es_mux_settings_ctx, log_ctx_t *log_ctx)
@@ -1688,96 +3628,509 @@ static int live555_rtsp_es_mux_settings_ctx_init(
 	CHECK_DO(live555_rtsp_es_mux_settings_ctx->sdp_mimetype!= NULL,
 			return STAT_ERROR);
 	live555_rtsp_es_mux_settings_ctx->rtp_timestamp_freq= 9000;
+	live555_rtsp_es_mux_settings_ctx->gop_cache_max_bytes=
+			GOP_CACHE_MAX_BYTES_DEFAULT;
+	live555_rtsp_es_mux_settings_ctx->rtp_pacing_bitrate= 0; // Disabled
+	live555_rtsp_es_mux_settings_ctx->rtp_pacing_headroom=
+			RTP_PACING_HEADROOM_DEFAULT;
+	live555_rtsp_es_mux_settings_ctx->rtp_pacing_max_latency_msecs=
+			RTP_PACING_MAX_LATENCY_MSECS_DEFAULT;
+	live555_rtsp_es_mux_settings_ctx->bitrate_adapt_min=
+			BITRATE_ADAPT_MIN_DEFAULT;
+	live555_rtsp_es_mux_settings_ctx->bitrate_adapt_max= 0; // Encoder's
+	live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_high=
+			BITRATE_ADAPT_LOSS_HIGH_DEFAULT;
+	live555_rtsp_es_mux_settings_ctx->bitrate_adapt_loss_low=
+			BITRATE_ADAPT_LOSS_LOW_DEFAULT;
 
 	return STAT_SUCCESS;
 }
 
-static void live555_rtsp_es_mux_settings_ctx_deinit(
-		volatile live555_rtsp_es_mux_settings_ctx_t *
-		live555_rtsp_es_mux_settings_ctx, log_ctx_t *log_ctx)
+static void live555_rtsp_es_mux_settings_ctx_deinit(
+		volatile live555_rtsp_es_mux_settings_ctx_t *
+		live555_rtsp_es_mux_settings_ctx, log_ctx_t *log_ctx)
+{
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_es_mux_settings_ctx!= NULL, return);
+
+	/* Release ES-MUXER specific settings */
+	if(live555_rtsp_es_mux_settings_ctx->sdp_mimetype!= NULL) {
+		free(live555_rtsp_es_mux_settings_ctx->sdp_mimetype);
+		live555_rtsp_es_mux_settings_ctx->sdp_mimetype= NULL;
+	}
+}
+
+/* **** So-called "framed-sink class implementation **** */
+
+SimpleRTPSink2::SimpleRTPSink2(UsageEnvironment& env, Groupsock* RTPgs,
+		unsigned char rtpPayloadFormat, unsigned rtpTimestampFrequency,
+		char const* sdpMediaTypeString, char const* rtpPayloadFormatName,
+		unsigned numChannels, Boolean allowMultipleFramesPerPacket,
+		Boolean doNormalMBitRule,
+		const rtp_pacing_settings_t *rtp_pacing_settings,
+		volatile size_t *ref_pacing_queue_bytes):
+				MultiFramedRTPSink(env, RTPgs, rtpPayloadFormat,
+						rtpTimestampFrequency, rtpPayloadFormatName,
+						numChannels),
+				fAllowMultipleFramesPerPacket(allowMultipleFramesPerPacket),
+				fSetMBitOnNextPacket(False),
+				m_ref_pacing_queue_bytes(ref_pacing_queue_bytes),
+				m_simpleRTPPacer(NULL)
+{
+  fSDPMediaTypeString= strDup(
+		  sdpMediaTypeString== NULL? "unknown": sdpMediaTypeString);
+  fSetMBitOnLastFrames= doNormalMBitRule
+		  /*&& strcmp(fSDPMediaTypeString, "audio")!= 0*/;
+  memset(&m_rtp_pacing_settings, 0, sizeof(m_rtp_pacing_settings));
+  if(rtp_pacing_settings!= NULL)
+	  m_rtp_pacing_settings= *rtp_pacing_settings;
+}
+
+SimpleRTPSink2::~SimpleRTPSink2()
+{
+  if(m_simpleRTPPacer!= NULL) {
+	  /* As Live555's H.264 RTP sink does with its "fragmenter": stop now,
+	   * as we won't have our pacer when the base class destructor calls
+	   * 'stopPlaying()' later.
+	   */
+	  fSource= m_simpleRTPPacer; // in case 'fSource' had been set to NULL
+	  stopPlaying();
+	  Medium::close(m_simpleRTPPacer);
+	  m_simpleRTPPacer= NULL;
+	  fSource= NULL; // for the base class destructor
+  }
+  delete[] (char*)fSDPMediaTypeString;
+}
+
+SimpleRTPSink2* SimpleRTPSink2::createNew(
+		UsageEnvironment& env, Groupsock* RTPgs,
+		unsigned char rtpPayloadFormat, unsigned rtpTimestampFrequency,
+		char const* sdpMediaTypeString, char const* rtpPayloadFormatName,
+		unsigned numChannels, Boolean allowMultipleFramesPerPacket,
+		Boolean doNormalMBitRule,
+		const rtp_pacing_settings_t *rtp_pacing_settings,
+		volatile size_t *ref_pacing_queue_bytes)
+{
+	return new SimpleRTPSink2(env, RTPgs, rtpPayloadFormat,
+			rtpTimestampFrequency, sdpMediaTypeString, rtpPayloadFormatName,
+			numChannels, allowMultipleFramesPerPacket, doNormalMBitRule,
+			rtp_pacing_settings, ref_pacing_queue_bytes);
+}
+
+Boolean SimpleRTPSink2::continuePlaying()
+{
+	/* If pacing is enabled, insert our pacer between the source and us
+	 * (create it the first time we play).
+	 */
+	if(m_rtp_pacing_settings.bitrate> 0 && fSource!= NULL) {
+		if(m_simpleRTPPacer== NULL)
+			m_simpleRTPPacer= SimpleRTPPacer::createNew(envir(), fSource,
+					OutPacketBuffer::maxSize,
+					ourMaxPacketSize()- 12/*RTP hdr size*/,
+					&m_rtp_pacing_settings, m_ref_pacing_queue_bytes);
+		else
+			m_simpleRTPPacer->reassignInputSource(fSource);
+		fSource= m_simpleRTPPacer;
+	}
+
+	/* Call the parent class implementation */
+	return MultiFramedRTPSink::continuePlaying();
+}
+
+void SimpleRTPSink2::doSpecialFrameHandling(unsigned fragmentationOffset,
+					   unsigned char* frameStart,
+					   unsigned numBytesInFrame,
+					   struct timeval framePresentationTime,
+					   unsigned numRemainingBytes) {
+  if(numRemainingBytes== 0 && (m_simpleRTPPacer== NULL ||
+		  m_simpleRTPPacer->lastSegmentEndsFrame())) {
+    // This packet contains the last (or only) fragment of the frame
+    // (when pacing, each paced segment is delivered as a "frame").
+    // Set the RTP 'M' ('marker') bit, if appropriate:
+    if(fSetMBitOnLastFrames)
+    	setMarkerBit();
+  }
+  if(fSetMBitOnNextPacket) {
+    //An external object asked for the 'M' bit to be set on the next packet:
+    setMarkerBit();
+    fSetMBitOnNextPacket = False;
+  }
+
+  // Important: Also call our base class's doSpecialFrameHandling(),
+  // to set the packet's timestamp:
+  MultiFramedRTPSink::doSpecialFrameHandling(fragmentationOffset,
+		  frameStart, numBytesInFrame, framePresentationTime,
+		  numRemainingBytes);
+}
+
+Boolean SimpleRTPSink2::frameCanAppearAfterPacketStart(
+		unsigned char const* /*frameStart*/, unsigned /*numBytesInFrame*/)
+const
+{
+  return fAllowMultipleFramesPerPacket;
+}
+
+char const* SimpleRTPSink2::sdpMediaType() const
+{
+  return fSDPMediaTypeString;
+}
+
+/* **** RTP packets pacer class implementation **** */
+
+static int64_t pacer_now_usecs()
+{
+	struct timeval tv_now;
+	gettimeofday(&tv_now, NULL);
+	return (int64_t)tv_now.tv_sec* 1000000+ tv_now.tv_usec;
+}
+
+SimpleRTPPacer* SimpleRTPPacer::createNew(UsageEnvironment& env,
+		FramedSource* inputSource, unsigned inputBufferMax,
+		unsigned maxOutputPacketSize,
+		const rtp_pacing_settings_t *rtp_pacing_settings,
+		volatile size_t *ref_pacing_queue_bytes)
+{
+	return new SimpleRTPPacer(env, inputSource, inputBufferMax,
+			maxOutputPacketSize, rtp_pacing_settings, ref_pacing_queue_bytes);
+}
+
+SimpleRTPPacer::SimpleRTPPacer(UsageEnvironment& env,
+		FramedSource* inputSource, unsigned inputBufferMax,
+		unsigned maxOutputPacketSize,
+		const rtp_pacing_settings_t *rtp_pacing_settings,
+		volatile size_t *ref_pacing_queue_bytes):
+				FramedFilter(env, inputSource),
+				m_buf(NULL),
+				m_buf_size(inputBufferMax),
+				m_frame_size(0),
+				m_frame_offset(0),
+				m_flag_frame_ended(True),
+				m_segment_size_max(maxOutputPacketSize),
+				m_tokens(0),
+				m_bucket_size(0),
+				m_rate(0),
+				m_tokens_usecs(0),
+				m_frame_start_usecs(0),
+				m_max_latency_usecs(0),
+				m_task(NULL),
+				m_ref_pacing_queue_bytes(ref_pacing_queue_bytes),
+				m_queue_bytes(0)
+{
+	double bucket_min;
+
+	m_buf= new unsigned char[m_buf_size];
+	memset(&m_presentation_time, 0, sizeof(m_presentation_time));
+	if(m_segment_size_max== 0)
+		m_segment_size_max= 1;
+
+	/* Token-bucket rate: target rate plus headroom, in bytes per
+	 * microsecond.
+	 */
+	m_rate= ((double)rtp_pacing_settings->bitrate/ 8.0)*
+			((100.0+ rtp_pacing_settings->headroom)/ 100.0)/ 1000000.0;
+	m_bucket_size= (double)m_segment_size_max* RTP_PACING_BUCKET_PACKETS;
+	bucket_min= m_rate* RTP_PACING_BUCKET_MIN_USECS;
+	if(m_bucket_size< bucket_min)
+		m_bucket_size= bucket_min;
+	m_tokens= m_bucket_size;
+	m_max_latency_usecs= (int64_t)rtp_pacing_settings->max_latency_msecs*
+			1000;
+}
+
+SimpleRTPPacer::~SimpleRTPPacer()
+{
+	envir().taskScheduler().unscheduleDelayedTask(m_task);
+	queueBytesSet(0);
+	delete[] m_buf;
+	detachInputSource(); // so that the subsequent ~FramedFilter() doesn't
+	                     // delete it
+}
+
+void SimpleRTPPacer::doGetNextFrame()
+{
+	/* Deliver next segment of current frame, if any; otherwise, get a new
+	 * frame from our input source.
+	 */
+	if(m_frame_offset< m_frame_size) {
+		deliverSegment();
+		return;
+	}
+	fInputSource->getNextFrame(m_buf, m_buf_size, afterGettingFrame, this,
+			FramedSource::handleClosure, this);
+}
+
+void SimpleRTPPacer::doStopGettingFrames()
+{
+	/* Drop pending segments (a new frame is requested when playing again) */
+	envir().taskScheduler().unscheduleDelayedTask(m_task);
+	m_frame_size= m_frame_offset= 0;
+	m_flag_frame_ended= True;
+	queueBytesSet(0);
+	FramedFilter::doStopGettingFrames();
+}
+
+void SimpleRTPPacer::afterGettingFrame(void* clientData, unsigned frameSize,
+		unsigned /*numTruncatedBytes*/, struct timeval presentationTime,
+		unsigned /*durationInMicroseconds*/)
+{
+	((SimpleRTPPacer*)clientData)->afterGettingFrame1(frameSize,
+			presentationTime);
+}
+
+void SimpleRTPPacer::afterGettingFrame1(unsigned frameSize,
+		struct timeval presentationTime)
+{
+	m_frame_size= frameSize;
+	m_frame_offset= 0;
+	m_presentation_time= presentationTime;
+	m_frame_start_usecs= pacer_now_usecs();
+	queueBytesSet(m_frame_size);
+	deliverSegment();
+}
+
+void SimpleRTPPacer::deliverSegment0(void* clientData)
+{
+	SimpleRTPPacer *simpleRTPPacer= (SimpleRTPPacer*)clientData;
+	simpleRTPPacer->m_task= NULL;
+	simpleRTPPacer->deliverSegment();
+}
+
+/**
+ * Deliver the next segment of the current frame to the sink if either the
+ * token-bucket allows it or the frame is late with respect to its maximum
+ * latency (the frame is spread uniformly along this interval); otherwise,
+ * schedule the delivery for when one of these conditions will be met.
+ */
+void SimpleRTPPacer::deliverSegment()
+{
+	unsigned segment_size;
+	int64_t now_usecs, wait_usecs, latency_wait_usecs;
+
+	if(!isCurrentlyAwaitingData() || m_frame_offset>= m_frame_size)
+		return;
+
+	segment_size= m_frame_size- m_frame_offset;
+	if(segment_size> m_segment_size_max)
+		segment_size= m_segment_size_max;
+	if(segment_size> fMaxSize)
+		segment_size= fMaxSize;
+
+	/* Fill token-bucket */
+	now_usecs= pacer_now_usecs();
+	if(m_tokens_usecs> 0 && now_usecs> m_tokens_usecs) {
+		m_tokens+= (double)(now_usecs- m_tokens_usecs)* m_rate;
+		if(m_tokens> m_bucket_size)
+			m_tokens= m_bucket_size;
+	}
+	m_tokens_usecs= now_usecs;
+
+	if(m_tokens< (double)segment_size) {
+		/* Time to get the needed tokens at the pacing rate */
+		wait_usecs= (int64_t)(((double)segment_size- m_tokens)/ m_rate)+ 1;
+
+		/* Time when this segment is due to meet the maximum latency */
+		if(m_max_latency_usecs> 0) {
+			latency_wait_usecs= m_frame_start_usecs+ (int64_t)((double)
+					m_max_latency_usecs* (m_frame_offset+ segment_size)/
+					m_frame_size)- now_usecs;
+			if(latency_wait_usecs< wait_usecs)
+				wait_usecs= latency_wait_usecs;
+		}
+
+		if(wait_usecs> 0) {
+			m_task= envir().taskScheduler().scheduleDelayedTask(wait_usecs,
+					(TaskFunc*)deliverSegment0, this);
+			return;
+		}
+	}
+
+	/* Consume tokens (bounded debt if sent ahead of the bucket due to the
+	 * maximum latency).
+	 */
+	m_tokens-= (double)segment_size;
+	if(m_tokens< -m_bucket_size)
+		m_tokens= -m_bucket_size;
+
+	/* Deliver segment */
+	memmove(fTo, m_buf+ m_frame_offset, segment_size);
+	fFrameSize= segment_size;
+	fNumTruncatedBytes= 0;
+	fPresentationTime= m_presentation_time;
+	fDurationInMicroseconds= 0;
+	m_frame_offset+= segment_size;
+	m_flag_frame_ended= (m_frame_offset>= m_frame_size)? True: False;
+	queueBytesSet(m_frame_size- m_frame_offset);
+
+	/* Inform the reader that the data is now available */
+	FramedSource::afterGetting(this);
+}
+
+/**
+ * Update our contribution to the externally provided queued bytes counter.
+ */
+void SimpleRTPPacer::queueBytesSet(size_t queue_bytes)
+{
+	if(m_ref_pacing_queue_bytes!= NULL) {
+		if(queue_bytes>= m_queue_bytes)
+			__atomic_add_fetch(m_ref_pacing_queue_bytes,
+					queue_bytes- m_queue_bytes, __ATOMIC_RELAXED);
+		else
+			__atomic_sub_fetch(m_ref_pacing_queue_bytes,
+					m_queue_bytes- queue_bytes, __ATOMIC_RELAXED);
+	}
+	m_queue_bytes= queue_bytes;
+}
+
+/* **** Shared frames and GOP cache related implementation **** */
+
+/**
+ * Wrap an encoded frame into a shared frame (with one reference).
+ * @param ref_proc_frame_ctx Reference to the pointer to the frame to be
+ * wrapped; the frame is consumed (pointer is set to NULL) on success.
+ * @return Pointer to the new shared frame or NULL on error.
+ */
+static shared_frame_ctx_t* shared_frame_ctx_create(
+		proc_frame_ctx_t **ref_proc_frame_ctx)
 {
-	LOG_CTX_INIT(log_ctx);
+	shared_frame_ctx_t *shared_frame_ctx= NULL;
+	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
-	CHECK_DO(live555_rtsp_es_mux_settings_ctx!= NULL, return);
-
-	/* Release ES-MUXER specific settings */
-	if(live555_rtsp_es_mux_settings_ctx->sdp_mimetype!= NULL) {
-		free(live555_rtsp_es_mux_settings_ctx->sdp_mimetype);
-		live555_rtsp_es_mux_settings_ctx->sdp_mimetype= NULL;
-	}
-}
+	CHECK_DO(ref_proc_frame_ctx!= NULL && *ref_proc_frame_ctx!= NULL,
+			return NULL);
 
-/* **** So-called "framed-sink class implementation **** */
+	shared_frame_ctx= (shared_frame_ctx_t*)calloc(1, sizeof(
+			shared_frame_ctx_t));
+	CHECK_DO(shared_frame_ctx!= NULL, return NULL);
 
-SimpleRTPSink2::SimpleRTPSink2(UsageEnvironment& env, Groupsock* RTPgs,
-		unsigned char rtpPayloadFormat, unsigned rtpTimestampFrequency,
-		char const* sdpMediaTypeString, char const* rtpPayloadFormatName,
-		unsigned numChannels, Boolean allowMultipleFramesPerPacket,
-		Boolean doNormalMBitRule):
-				MultiFramedRTPSink(env, RTPgs, rtpPayloadFormat,
-						rtpTimestampFrequency, rtpPayloadFormatName,
-						numChannels),
-				fAllowMultipleFramesPerPacket(allowMultipleFramesPerPacket),
-				fSetMBitOnNextPacket(False)
-{
-  fSDPMediaTypeString= strDup(
-		  sdpMediaTypeString== NULL? "unknown": sdpMediaTypeString);
-  fSetMBitOnLastFrames= doNormalMBitRule
-		  /*&& strcmp(fSDPMediaTypeString, "audio")!= 0*/;
+	shared_frame_ctx->proc_frame_ctx= *ref_proc_frame_ctx;
+	*ref_proc_frame_ctx= NULL; // Consumed
+	shared_frame_ctx->ref_cnt= 1;
+	return shared_frame_ctx;
 }
 
-SimpleRTPSink2::~SimpleRTPSink2()
+/**
+ * Get a new reference to the given shared frame.
+ * This function is also used as the FIFO element duplication callback.
+ */
+static void* shared_frame_ctx_ref(const void *t)
 {
-  delete[] (char*)fSDPMediaTypeString;
+	shared_frame_ctx_t *shared_frame_ctx= (shared_frame_ctx_t*)t;
+
+	if(shared_frame_ctx== NULL)
+		return NULL;
+	__atomic_add_fetch(&shared_frame_ctx->ref_cnt, 1, __ATOMIC_RELAXED);
+	return (void*)shared_frame_ctx;
 }
 
-SimpleRTPSink2* SimpleRTPSink2::createNew(
-		UsageEnvironment& env, Groupsock* RTPgs,
-		unsigned char rtpPayloadFormat, unsigned rtpTimestampFrequency,
-		char const* sdpMediaTypeString, char const* rtpPayloadFormatName,
-		unsigned numChannels, Boolean allowMultipleFramesPerPacket,
-		Boolean doNormalMBitRule)
+/**
+ * Release a reference to the given shared frame; the frame is released when
+ * the last reference is dropped.
+ * This function is also used as the FIFO element release callback.
+ */
+static void shared_frame_ctx_unref(void **ref_t)
 {
-	return new SimpleRTPSink2(env, RTPgs, rtpPayloadFormat,
-			rtpTimestampFrequency, sdpMediaTypeString, rtpPayloadFormatName,
-			numChannels, allowMultipleFramesPerPacket, doNormalMBitRule);
-}
+	shared_frame_ctx_t *shared_frame_ctx= NULL;
 
-void SimpleRTPSink2::doSpecialFrameHandling(unsigned fragmentationOffset,
-					   unsigned char* frameStart,
-					   unsigned numBytesInFrame,
-					   struct timeval framePresentationTime,
-					   unsigned numRemainingBytes) {
-  if(numRemainingBytes== 0) {
-    // This packet contains the last (or only) fragment of the frame.
-    // Set the RTP 'M' ('marker') bit, if appropriate:
-    if(fSetMBitOnLastFrames)
-    	setMarkerBit();
-  }
-  if(fSetMBitOnNextPacket) {
-    //An external object asked for the 'M' bit to be set on the next packet:
-    setMarkerBit();
-    fSetMBitOnNextPacket = False;
-  }
+	if(ref_t== NULL || (shared_frame_ctx= (shared_frame_ctx_t*)*ref_t)== NULL)
+		return;
+	*ref_t= NULL;
 
-  // Important: Also call our base class's doSpecialFrameHandling(),
-  // to set the packet's timestamp:
-  MultiFramedRTPSink::doSpecialFrameHandling(fragmentationOffset,
-		  frameStart, numBytesInFrame, framePresentationTime,
-		  numRemainingBytes);
+	if(__atomic_sub_fetch(&shared_frame_ctx->ref_cnt, 1, __ATOMIC_ACQ_REL)
+			> 0)
+		return;
+	proc_frame_ctx_release(&shared_frame_ctx->proc_frame_ctx);
+	free(shared_frame_ctx);
 }
 
-Boolean SimpleRTPSink2::frameCanAppearAfterPacketStart(
-		unsigned char const* /*frameStart*/, unsigned /*numBytesInFrame*/)
-const
+/**
+ * Get the size in bytes of the given shared frame encoded data.
+ */
+static size_t shared_frame_ctx_size(const shared_frame_ctx_t *shared_frame_ctx)
 {
-  return fAllowMultipleFramesPerPacket;
+	if(shared_frame_ctx== NULL || shared_frame_ctx->proc_frame_ctx== NULL)
+		return 0;
+	return shared_frame_ctx->proc_frame_ctx->width[0];
 }
 
-char const* SimpleRTPSink2::sdpMediaType() const
+/**
+ * Get the elementary stream codec type, among the ones which key-frames can
+ * be detected, given the SDP MIME type (e.g. "video/avc1").
+ */
+static es_codec_t es_codec_get(const char *sdp_mimetype)
 {
-  return fSDPMediaTypeString;
+	const char *subtype;
+
+	if(sdp_mimetype== NULL || (subtype= strchr(sdp_mimetype, '/'))== NULL)
+		return ES_CODEC_UNKNOWN;
+	subtype++;
+
+	if(strcasecmp(subtype, "avc1")== 0 || strcasecmp(subtype, "H264")== 0)
+		return ES_CODEC_H264;
+	if(strcasecmp(subtype, "mp2v")== 0 || strcasecmp(subtype, "MPV")== 0)
+		return ES_CODEC_MPEG2_VIDEO;
+	if(strcasecmp(subtype, "MP4V-ES")== 0)
+		return ES_CODEC_MPEG4_VIDEO;
+	return ES_CODEC_UNKNOWN;
+}
+
+/**
+ * Parse the given encoded frame (Annex-B/start-code delimited bitstream) to
+ * find out if it is a key-frame (a frame from which decoding can start).
+ * @param es_codec Elementary stream codec type.
+ * @param data Encoded frame data.
+ * @param size Encoded frame data size in bytes.
+ * @return 1 if the frame is a key-frame, 0 if not, -1 if the codec type is
+ * not supported.
+ */
+static int es_frame_is_key(es_codec_t es_codec, const uint8_t *data,
+		size_t size)
+{
+	register size_t i;
+
+	if(es_codec== ES_CODEC_UNKNOWN)
+		return -1;
+	if(data== NULL)
+		return 0;
+
+	for(i= 0; i+ 5< size; i++) {
+		uint8_t code;
+
+		/* Look for next start-code prefix (0x000001) */
+		if(data[i]!= 0 || data[i+ 1]!= 0 || data[i+ 2]!= 1)
+			continue;
+		code= data[i+ 3];
+
+		switch(es_codec) {
+		case ES_CODEC_H264:
+			/* IDR slice or SPS: key-frame; non-IDR slice: not a key-frame */
+			if((code& 0x1F)== 5 || (code& 0x1F)== 7)
+				return 1;
+			if((code& 0x1F)== 1)
+				return 0;
+			break;
+		case ES_CODEC_MPEG2_VIDEO:
+			/* Sequence header or intra-coded picture */
+			if(code== 0xB3)
+				return 1;
+			if(code== 0x00)
+				return (((data[i+ 5]>> 3)& 0x07)== 1)? 1: 0;
+			break;
+		case ES_CODEC_MPEG4_VIDEO:
+			/* VOS or GOV header, or intra-coded VOP */
+			if(code== 0xB0 || code== 0xB3)
+				return 1;
+			if(code== 0xB6)
+				return ((data[i+ 4]>> 6)== 0)? 1: 0;
+			break;
+		default:
+			return -1;
+		}
+		i+= 2;
+	}
+	return 0;
 }
 
 /* **** So-called "framed-source" class implementation **** */
@@ -1791,17 +4144,19 @@ SimpleFramedSource *SimpleFramedSource::createNew(UsageEnvironment& env,
 SimpleFramedSource::SimpleFramedSource(UsageEnvironment& env,
 		log_ctx_t *log_ctx):
 				FramedSource(env),
-				m_log_ctx(log_ctx)
+				m_pacing_queue_bytes(0),
+				m_log_ctx(log_ctx),
+				m_frame_offset(0)
 {
 	fifo_elem_alloc_fxn_t fifo_elem_alloc_fxn= {0};
 	LOG_CTX_INIT(m_log_ctx);
 	LOGD(">>::SimpleFramedSource\n"); //comment-me
 
-	/* Initialize input FIFO buffer as *NON-BLOCKING* */
+	/* Initialize input FIFO buffer as *NON-BLOCKING* (of shared frames) */
 	fifo_elem_alloc_fxn.elem_ctx_dup=
-			(fifo_elem_ctx_dup_fxn_t*)proc_frame_ctx_dup;
+			(fifo_elem_ctx_dup_fxn_t*)shared_frame_ctx_ref;
 	fifo_elem_alloc_fxn.elem_ctx_release=
-			(fifo_elem_ctx_release_fxn_t*)proc_frame_ctx_release;
+			(fifo_elem_ctx_release_fxn_t*)shared_frame_ctx_unref;
 	m_fifo_ctx= fifo_open(FRAMED_SOURCE_FIFO_SLOTS, 0/*unlimited chunk size*/,
 			FIFO_O_NONBLOCK, &fifo_elem_alloc_fxn);
 	ASSERT(m_fifo_ctx!= NULL);
@@ -1822,6 +4177,13 @@ SimpleFramedSource::~SimpleFramedSource()
 	/* Release input and output FIFO's */
 	fifo_close(&m_fifo_ctx);
 
+	/* Release GOP cache burst frames not delivered */
+	while(!m_burst.empty()) {
+		shared_frame_ctx_t *shared_frame_ctx= m_burst.front();
+		m_burst.pop_front();
+		shared_frame_ctx_unref((void**)&shared_frame_ctx);
+	}
+
 	/* Reclaim our 'event trigger' */
 	envir().taskScheduler().deleteEventTrigger(m_eventTriggerId);
 	m_eventTriggerId= 0;
@@ -1829,6 +4191,14 @@ SimpleFramedSource::~SimpleFramedSource()
 	LOGD("<<::~SimpleFramedSource\n"); //comment-me
 }
 
+void SimpleFramedSource::burstFrame(shared_frame_ctx_t *shared_frame_ctx)
+{
+	if(shared_frame_ctx== NULL)
+		return;
+	m_burst.push_back((shared_frame_ctx_t*)shared_frame_ctx_ref(
+			shared_frame_ctx));
+}
+
 void SimpleFramedSource::doGetNextFrame()
 {
 	LOGD_CTX_INIT(m_log_ctx);
@@ -1843,8 +4213,11 @@ void SimpleFramedSource::doGetNextFrame()
 		return;
 	}
 
-	/* Directly deliver the next frame of data if is immediately available */
-	if(m_fifo_ctx!= NULL && fifo_get_buffer_level(m_fifo_ctx)> 0)
+	/* Directly deliver the next frame of data if is immediately available
+	 * (GOP cache burst frames first)
+	 */
+	if(!m_burst.empty() ||
+			(m_fifo_ctx!= NULL && fifo_get_buffer_level(m_fifo_ctx)> 0))
 		deliverFrame();
 
 
@@ -1885,9 +4258,10 @@ void SimpleFramedSource::deliverFrame0(void *simpleFramedSource_opaque)
  */
 void SimpleFramedSource::deliverFrame()
 {
-	uint8_t *newFrame= NULL;
-	int ret_code, newFrameSize= 0;
-	proc_frame_ctx_t *proc_frame_ctx_show= NULL; //Do not release but modify
+	const uint8_t *newFrame= NULL;
+	int ret_code, flag_is_burst_frame= 0;
+	size_t newFrameSize= 0;
+	shared_frame_ctx_t *shared_frame_ctx_show= NULL; //Do not release
 	size_t fifo_elem_size= 0;
 	LOG_CTX_INIT(m_log_ctx);
 	LOGD(">>%s\n", __FUNCTION__); //comment-me
@@ -1897,48 +4271,68 @@ void SimpleFramedSource::deliverFrame()
 		goto end; // we're not ready for the data yet
 	}
 
-	/* Show (but not consume yet) next packet from FIFO buffer.
-	 * The packet, if not fully consumed, will be modified.
+	/* Show (but not consume yet) next frame: GOP cache burst frames are
+	 * delivered first, then frames from the FIFO buffer.
 	 * The 'ret_code' should always be 'STAT_SUCCESS' as this method should
 	 * only be called if there is data available. Also, note that this FIFO is
 	 * *NOT* blocking.
+	 * Shared frames are read-only: if the frame is not fully consumed, we
+	 * just keep track of the delivered data offset.
 	 */
-	ret_code= fifo_show(m_fifo_ctx, (void**)&proc_frame_ctx_show,
-			&fifo_elem_size);
-	CHECK_DO(ret_code== STAT_SUCCESS && proc_frame_ctx_show!= NULL, goto end);
+	if(!m_burst.empty()) {
+		shared_frame_ctx_show= m_burst.front();
+		flag_is_burst_frame= 1;
+	} else {
+		ret_code= fifo_show(m_fifo_ctx, (void**)&shared_frame_ctx_show,
+				&fifo_elem_size);
+		CHECK_DO(ret_code== STAT_SUCCESS && shared_frame_ctx_show!= NULL,
+				goto end);
+	}
+	CHECK_DO(shared_frame_ctx_show->proc_frame_ctx!= NULL, goto end);
 
 	/* Get input frame pointer and size */
-	newFrame= (uint8_t*)proc_frame_ctx_show->p_data[0];
-	newFrameSize= proc_frame_ctx_show->width[0];
-	if(newFrameSize> (int)fMaxSize) {
+	newFrame= shared_frame_ctx_show->proc_frame_ctx->p_data[0]+
+			m_frame_offset;
+	newFrameSize= shared_frame_ctx_size(shared_frame_ctx_show)-
+			m_frame_offset;
+	if(newFrameSize> fMaxSize) {
 		LOGW("Input frame fragmented (Elementary Stream Id.: %d\n)",
-				proc_frame_ctx_show->es_id);
+				shared_frame_ctx_show->proc_frame_ctx->es_id);
 		fFrameSize= fMaxSize;
 		fNumTruncatedBytes= newFrameSize- fMaxSize;
-		/* Update frame pointer and size for next call to deliverFrame() */
-		proc_frame_ctx_show->p_data[0]= (const uint8_t*)(newFrame+ fMaxSize);
-		proc_frame_ctx_show->width[0]-= fMaxSize;
 	} else {
 		fFrameSize= newFrameSize;
 		fNumTruncatedBytes= 0;
 	}
-	gettimeofday(&fPresentationTime, NULL); //TODO
+	fPresentationTime= shared_frame_ctx_show->presentation_time;
 
 	/* Copy frame (or segment) to output buffer */
 	memmove(fTo, newFrame, fFrameSize);
 
-	/* After delivering the data, inform the reader that it is now available */
-	FramedSource::afterGetting(this);
-
-	/* Consume packet from FIFO if fully used (not truncated) */
+	/* Consume frame if fully used (not truncated); otherwise, update
+	 * the offset for the next call to deliverFrame().
+	 * Note that this is done before informing the reader, as it may
+	 * synchronously ask for the next frame.
+	 */
 	if(fNumTruncatedBytes== 0) {
-		proc_frame_ctx_t *proc_frame_ctx= NULL;
-		ret_code= fifo_get(m_fifo_ctx, (void**)&proc_frame_ctx,
-				&fifo_elem_size);
-		ASSERT(ret_code== STAT_SUCCESS);
-		proc_frame_ctx_release(&proc_frame_ctx);
+		shared_frame_ctx_t *shared_frame_ctx= NULL;
+		if(flag_is_burst_frame!= 0) {
+			shared_frame_ctx= m_burst.front();
+			m_burst.pop_front();
+		} else {
+			ret_code= fifo_get(m_fifo_ctx, (void**)&shared_frame_ctx,
+					&fifo_elem_size);
+			ASSERT(ret_code== STAT_SUCCESS);
+		}
+		shared_frame_ctx_unref((void**)&shared_frame_ctx);
+		m_frame_offset= 0;
+	} else {
+		m_frame_offset+= fFrameSize;
 	}
 
+	/* After delivering the data, inform the reader that it is now available */
+	FramedSource::afterGetting(this);
+
 end:
 	LOGD("<<%s\n", __FUNCTION__); //comment-me
 	return;
@@ -1947,70 +4341,283 @@ end:
 /* **** So-called "media sub-session" class implementation **** */
 
 SimpleMediaSubsession * SimpleMediaSubsession::createNew(UsageEnvironment &env,
-		const char *sdp_mimetype, portNumBits initialPortNum,
-		Boolean multiplexRTCPWithRTP)
+		const char *sdp_mimetype, size_t gop_cache_max_bytes,
+		portNumBits initialPortNum, Boolean multiplexRTCPWithRTP)
 {
-	return new SimpleMediaSubsession(env, sdp_mimetype, initialPortNum,
-			multiplexRTCPWithRTP);
+	return new SimpleMediaSubsession(env, sdp_mimetype, gop_cache_max_bytes,
+			initialPortNum, multiplexRTCPWithRTP);
 }
 
 SimpleMediaSubsession::SimpleMediaSubsession(UsageEnvironment &env,
-		const char *sdp_mimetype, portNumBits initialPortNum,
-		Boolean multiplexRTCPWithRTP):
-				OnDemandServerMediaSubsession(env, True/*reuseFirstSource*/,
+		const char *sdp_mimetype, size_t gop_cache_max_bytes,
+		portNumBits initialPortNum, Boolean multiplexRTCPWithRTP):
+				OnDemandServerMediaSubsession(env,
+						False/*do not reuseFirstSource*/,
 						initialPortNum, multiplexRTCPWithRTP),
-				m_simpleFramedSource(NULL),
+				m_es_codec(ES_CODEC_UNKNOWN),
+				m_gop_cache_bytes(0),
+				m_gop_cache_max_bytes(gop_cache_max_bytes),
+				m_gop_cache_overflows(0),
+				m_flag_gop_caching(0),
+				m_flag_pts_anchored(0),
+				m_pts_anchor(0),
+				m_wallclock_anchor_usecs(0),
 				m_log_ctx(NULL)
 {
 	LOGD_CTX_INIT(m_log_ctx);
 	LOGD(">>::SimpleMediaSubsession\n"); //comment-me
 
+	memset(&m_rtp_pacing_settings, 0, sizeof(m_rtp_pacing_settings));
+
 	/* Check members initialization */
 	if(sdp_mimetype!= NULL && strlen(sdp_mimetype)> 0)
 		m_sdp_mimetype= sdp_mimetype;
 	else
 		m_sdp_mimetype= (const char*)"n/a";
+	m_es_codec= es_codec_get(m_sdp_mimetype);
 
 	LOGD("<<::SimpleMediaSubsession\n"); //comment-me
 }
 
-void SimpleMediaSubsession::deliverFrame(proc_frame_ctx_t **ref_proc_frame_ctx)
+SimpleMediaSubsession::~SimpleMediaSubsession()
+{
+	m_simpleFramedSource_mutex.lock();
+	gopCacheEmpty();
+	m_simpleFramedSource_mutex.unlock();
+}
+
+int SimpleMediaSubsession::deliverFrame(proc_frame_ctx_t **ref_proc_frame_ctx)
 {
+	int flag_is_key, end_code= STAT_SUCCESS;
+	size_t frame_size;
+	shared_frame_ctx_t *shared_frame_ctx= NULL;
+	std::list<SimpleFramedSource*>::iterator it;
 	LOG_CTX_INIT(m_log_ctx);
 
 	/* Check arguments */
-	CHECK_DO(ref_proc_frame_ctx!= NULL && *ref_proc_frame_ctx!= NULL, return);
+	CHECK_DO(ref_proc_frame_ctx!= NULL && *ref_proc_frame_ctx!= NULL,
+			return STAT_ERROR);
+
+	/* Detect key-frame before sharing the frame */
+	flag_is_key= es_frame_is_key(m_es_codec, (*ref_proc_frame_ctx)->p_data[0],
+			(*ref_proc_frame_ctx)->width[0]);
+
+	/* Wrap frame to be shared by reference (consumes the given frame) */
+	shared_frame_ctx= shared_frame_ctx_create(ref_proc_frame_ctx);
+	CHECK_DO(shared_frame_ctx!= NULL, return STAT_ERROR);
+	frame_size= shared_frame_ctx_size(shared_frame_ctx);
 
 	m_simpleFramedSource_mutex.lock();
 
-	if(m_simpleFramedSource!= NULL) {
+	presentationTimeGet(shared_frame_ctx->proc_frame_ctx->pts,
+			&shared_frame_ctx->presentation_time);
+
+	/* Update GOP cache: a key-frame starts a new run; the run is dropped
+	 * (until the next key-frame) if it would exceed the maximum size.
+	 */
+	if(m_gop_cache_max_bytes> 0 && flag_is_key>= 0) {
+		if(flag_is_key== 1) {
+			gopCacheEmpty();
+			m_flag_gop_caching= 1;
+		}
+		if(m_flag_gop_caching!= 0) {
+			if(m_gop_cache_bytes+ frame_size> m_gop_cache_max_bytes) {
+				LOGW("GOP cache overflow (%zu bytes max.); increase "
+						"'gop_cache_max_bytes'?\n", m_gop_cache_max_bytes);
+				gopCacheEmpty();
+				m_flag_gop_caching= 0;
+				m_gop_cache_overflows++;
+			} else {
+				m_gop_cache.push_back((shared_frame_ctx_t*)
+						shared_frame_ctx_ref(shared_frame_ctx));
+				m_gop_cache_bytes+= frame_size;
+			}
+		}
+	}
+
+	for(it= m_simpleFramedSources.begin(); it!= m_simpleFramedSources.end();
+			++it) {
 		int ret_code;
+		SimpleFramedSource *simpleFramedSource= *it;
+		shared_frame_ctx_t *shared_frame_ctx_ref_aux= (shared_frame_ctx_t*)
+				shared_frame_ctx_ref(shared_frame_ctx);
 
-		/* Pass input frame reference to framed-source FIFO */
-		ret_code= fifo_put(m_simpleFramedSource->m_fifo_ctx,
-				(void**)ref_proc_frame_ctx, sizeof(void*));
-		if(ret_code== STAT_ENOMEM)
+		/* Pass a frame reference to each playing framed-source FIFO */
+		ret_code= fifo_put(simpleFramedSource->m_fifo_ctx,
+				(void**)&shared_frame_ctx_ref_aux, sizeof(void*));
+		if(ret_code== STAT_ENOMEM) {
 			LOGW("MUXER buffer overflow: throughput may be exceeding "
 					"processing capacity?\n");
-		else
-			ASSERT(*ref_proc_frame_ctx== NULL);
+			shared_frame_ctx_unref((void**)&shared_frame_ctx_ref_aux);
+			end_code= STAT_ENOMEM;
+		} else {
+			ASSERT(shared_frame_ctx_ref_aux== NULL);
+		}
 
 		/* Notify scheduler that we have a new frame!. Note that
-		 * 'm_simpleFramedSource' handler will be available only if a RTSP
-		 * session is established with a RTSP client.
-		 * If handler is available, we just trigger the corresponding
-		 * framed-source event; framed-source will internally read the FIFO
-		 * buffer and consume the input frame. If handler is not available
-		 * (namely, we have a NULL handler reference), we should consume the
-		 * input frame to avoid buffer overflowing (the calling function
-		 * consumes it).
+		 * framed-sources are only registered while a RTSP client is
+		 * playing. We just trigger the corresponding framed-source event;
+		 * framed-source will internally read the FIFO buffer and consume
+		 * the input frame.
 		 */
 		envir().taskScheduler().triggerEvent(
-				m_simpleFramedSource->m_eventTriggerId, m_simpleFramedSource);
+				simpleFramedSource->m_eventTriggerId, simpleFramedSource);
 	}
 
 	m_simpleFramedSource_mutex.unlock();
-	return;
+
+	shared_frame_ctx_unref((void**)&shared_frame_ctx);
+	return end_code;
+}
+
+void SimpleMediaSubsession::setGopCacheMaxBytes(size_t gop_cache_max_bytes)
+{
+	m_simpleFramedSource_mutex.lock();
+	m_gop_cache_max_bytes= gop_cache_max_bytes;
+	if(m_gop_cache_bytes> m_gop_cache_max_bytes) {
+		gopCacheEmpty();
+		m_flag_gop_caching= 0;
+	}
+	m_simpleFramedSource_mutex.unlock();
+}
+
+void SimpleMediaSubsession::getGopCacheStats(size_t *ref_frames,
+		size_t *ref_bytes, uint64_t *ref_overflows)
+{
+	m_simpleFramedSource_mutex.lock();
+	if(ref_frames!= NULL)
+		*ref_frames= m_gop_cache.size();
+	if(ref_bytes!= NULL)
+		*ref_bytes= m_gop_cache_bytes;
+	if(ref_overflows!= NULL)
+		*ref_overflows= m_gop_cache_overflows;
+	m_simpleFramedSource_mutex.unlock();
+}
+
+void SimpleMediaSubsession::setRTPPacing(
+		const rtp_pacing_settings_t *rtp_pacing_settings)
+{
+	if(rtp_pacing_settings== NULL)
+		return;
+	m_simpleFramedSource_mutex.lock();
+	m_rtp_pacing_settings= *rtp_pacing_settings;
+	m_simpleFramedSource_mutex.unlock();
+}
+
+/**
+ * Get the total amount of bytes queued in the RTP pacers of all the playing
+ * client sessions (i.e. not yet sent due to pacing).
+ */
+size_t SimpleMediaSubsession::getRTPPacingQueueBytes()
+{
+	size_t queue_bytes= 0;
+	std::list<SimpleFramedSource*>::iterator it;
+
+	m_simpleFramedSource_mutex.lock();
+	for(it= m_simpleFramedSources.begin(); it!= m_simpleFramedSources.end();
+			++it)
+		queue_bytes+= __atomic_load_n(&(*it)->m_pacing_queue_bytes,
+				__ATOMIC_RELAXED);
+	m_simpleFramedSource_mutex.unlock();
+	return queue_bytes;
+}
+
+/**
+ * Get the RTCP receiver-reports statistics of all the playing RTP sinks.
+ * Must be called in the event-loop thread.
+ * @return Number of receivers reported (at most 'num_max').
+ */
+int SimpleMediaSubsession::getRTCPStats(rtcp_rr_stats_t *rtcp_rr_stats_array,
+		int num_max)
+{
+	int num= 0;
+	struct timeval tv_now;
+	std::map<unsigned, RTPSink*>::iterator it;
+
+	gettimeofday(&tv_now, NULL);
+	for(it= m_rtpSinks.begin(); it!= m_rtpSinks.end() && num< num_max;
+			++it) {
+		RTPSink *rtpSink= it->second;
+		RTPTransmissionStats *rtpTransmissionStats;
+		unsigned rtp_timestamp_freq;
+		if(rtpSink== NULL)
+			continue;
+		rtp_timestamp_freq= rtpSink->rtpTimestampFrequency();
+
+		RTPTransmissionStatsDB::Iterator statsIter(
+				rtpSink->transmissionStatsDB());
+		while((rtpTransmissionStats= statsIter.next())!= NULL &&
+				num< num_max) {
+			rtcp_rr_stats_t *rtcp_rr_stats= &rtcp_rr_stats_array[num++];
+			const struct timeval &tv_rr=
+					rtpTransmissionStats->lastTimeReceived();
+
+			rtcp_rr_stats->ssrc= rtpTransmissionStats->SSRC();
+			if(inet_ntop(AF_INET,
+					&rtpTransmissionStats->lastFromAddress().sin_addr,
+					rtcp_rr_stats->address, sizeof(rtcp_rr_stats->address))==
+							NULL)
+				rtcp_rr_stats->address[0]= 0;
+			rtcp_rr_stats->fraction_lost= (double)
+					rtpTransmissionStats->packetLossRatio()/ 256.0;
+			rtcp_rr_stats->packets_lost=
+					rtpTransmissionStats->totNumPacketsLost();
+			rtcp_rr_stats->jitter_msecs= (rtp_timestamp_freq> 0)?
+					(double)rtpTransmissionStats->jitter()* 1000.0/
+					rtp_timestamp_freq: 0;
+			/* Round-trip delay is given in units of 1/65536 seconds */
+			rtcp_rr_stats->rtt_msecs= (double)
+					rtpTransmissionStats->roundTripDelay()* 1000.0/ 65536.0;
+			rtcp_rr_stats->report_age_usecs=
+					((int64_t)tv_now.tv_sec- tv_rr.tv_sec)* 1000000+
+					((int64_t)tv_now.tv_usec- tv_rr.tv_usec);
+		}
+	}
+	return num;
+}
+
+/**
+ * Release all the GOP cache frame references.
+ * Must be called with 'm_simpleFramedSource_mutex' locked.
+ */
+void SimpleMediaSubsession::gopCacheEmpty()
+{
+	while(!m_gop_cache.empty()) {
+		shared_frame_ctx_t *shared_frame_ctx= m_gop_cache.front();
+		m_gop_cache.pop_front();
+		shared_frame_ctx_unref((void**)&shared_frame_ctx);
+	}
+	m_gop_cache_bytes= 0;
+}
+
+/**
+ * Map the given frame PTS (microseconds) to a wall-clock aligned
+ * presentation time, as required by Live555 to compute RTP time-stamps.
+ * Frames keep their original time-stamps spacing, so GOP cache bursts are
+ * time-stamped correctly. If the PTS is not valid or deviates too much from
+ * the wall-clock, the mapping is re-anchored.
+ * Must be called with 'm_simpleFramedSource_mutex' locked.
+ */
+void SimpleMediaSubsession::presentationTimeGet(int64_t pts,
+		struct timeval *ref_tv)
+{
+	struct timeval tv_now;
+	int64_t now_usecs, ptime_usecs;
+
+	gettimeofday(&tv_now, NULL);
+	now_usecs= (int64_t)tv_now.tv_sec* 1000000+ tv_now.tv_usec;
+
+	ptime_usecs= m_wallclock_anchor_usecs+ (pts- m_pts_anchor);
+	if(pts<= 0 || m_flag_pts_anchored== 0 ||
+			llabs(ptime_usecs- now_usecs)> PTS_REANCHOR_THRESHOLD_USECS) {
+		m_pts_anchor= pts;
+		m_wallclock_anchor_usecs= now_usecs;
+		m_flag_pts_anchored= (pts> 0)? 1: 0;
+		ptime_usecs= now_usecs;
+	}
+
+	ref_tv->tv_sec= ptime_usecs/ 1000000;
+	ref_tv->tv_usec= ptime_usecs% 1000000;
 }
 
 /*
@@ -2026,31 +4633,81 @@ FramedSource* SimpleMediaSubsession::createNewStreamSource(
 	LOGD(">> SimpleMediaSubsession::createNewStreamSource\n"); //comment-me
 
 	estBitrate= 3000; /* Kbps */
-	OutPacketBuffer::increaseMaxSizeTo(SINK_BUFFER_SIZE);
-
-	/* Instantiate (and initialize) simple framed source */
-	framedSource= SimpleFramedSource::createNew(envir(), LOG_CTX_GET());
 	m_simpleFramedSource_mutex.lock();
-	m_simpleFramedSource= (SimpleFramedSource*)framedSource;
+	if(m_rtp_pacing_settings.bitrate> 0)
+		estBitrate= (m_rtp_pacing_settings.bitrate+ 999)/ 1000;
 	m_simpleFramedSource_mutex.unlock();
 
+	/* Instantiate (and initialize) simple framed source.
+	 * Note that the source will not receive frames until the stream is
+	 * started (see 'SimpleMediaSubsession::startStream()').
+	 */
+	framedSource= SimpleFramedSource::createNew(envir(), LOG_CTX_GET());
+
 	// Reserved for future use: here instantiate so-called "discrete framer"
 
 	LOGD("<< SimpleMediaSubsession::createNewStreamSource\n"); //comment-me
 	return framedSource;
 }
 
-void SimpleMediaSubsession::deleteStream(unsigned clientSessionId,
-		void*& streamToken)
+/*
+ * This method is called internally by the parent class
+ * OnDemandServerMediaSubsession on RTSP "PLAY".
+ * The stream source is primed with the GOP cache (burst) and registered to
+ * receive the live frames atomically, so the client starts decoding at the
+ * last key-frame without missing or duplicating frames.
+ */
+void SimpleMediaSubsession::startStream(unsigned clientSessionId,
+		void* streamToken, TaskFunc* rtcpRRHandler,
+		void* rtcpRRHandlerClientData, unsigned short& rtpSeqNum,
+		unsigned& rtpTimestamp,
+		ServerRequestAlternativeByteHandler* serverRequestAlternativeByteHandler,
+		void* serverRequestAlternativeByteHandlerClientData)
 {
+	SimpleFramedSource *simpleFramedSource= NULL;
 	LOGD_CTX_INIT(m_log_ctx);
+	LOGD(">> SimpleMediaSubsession::startStream\n"); //comment-me
+
+	if(streamToken!= NULL) {
+		simpleFramedSource= (SimpleFramedSource*)
+				((StreamState*)streamToken)->mediaSource();
+		m_rtpSinks[clientSessionId]= ((StreamState*)streamToken)->rtpSink();
+	}
+	sourceRegister(simpleFramedSource);
+
+	OnDemandServerMediaSubsession::startStream(clientSessionId, streamToken,
+			rtcpRRHandler, rtcpRRHandlerClientData, rtpSeqNum, rtpTimestamp,
+			serverRequestAlternativeByteHandler,
+			serverRequestAlternativeByteHandlerClientData);
+	LOGD("<< SimpleMediaSubsession::startStream\n"); //comment-me
+}
+
+/**
+ * Register the given source to receive the live frames (if not registered
+ * yet); the source is primed with the GOP cache (burst) atomically.
+ */
+void SimpleMediaSubsession::sourceRegister(
+		SimpleFramedSource *simpleFramedSource)
+{
+	if(simpleFramedSource== NULL)
+		return;
 
-	LOGD(">> SimpleMediaSubsession::deleteStream\n"); //comment-me
 	m_simpleFramedSource_mutex.lock();
-	m_simpleFramedSource= NULL;
+	if(std::find(m_simpleFramedSources.begin(), m_simpleFramedSources.end(),
+			simpleFramedSource)== m_simpleFramedSources.end()) {
+		std::deque<shared_frame_ctx_t*>::iterator it;
+		for(it= m_gop_cache.begin(); it!= m_gop_cache.end(); ++it)
+			simpleFramedSource->burstFrame(*it);
+		m_simpleFramedSources.push_back(simpleFramedSource);
+	}
 	m_simpleFramedSource_mutex.unlock();
+}
+
+void SimpleMediaSubsession::deleteStream(unsigned clientSessionId,
+		void*& streamToken)
+{
+	m_rtpSinks.erase(clientSessionId);
 	OnDemandServerMediaSubsession::deleteStream(clientSessionId, streamToken);
-	LOGD("<< SimpleMediaSubsession::deleteStream\n"); //comment-me
 }
 
 void SimpleMediaSubsession::closeStreamSource(FramedSource* inputSource)
@@ -2058,7 +4715,7 @@ void SimpleMediaSubsession::closeStreamSource(FramedSource* inputSource)
 	LOGD_CTX_INIT(m_log_ctx);
 	LOGD(">> SimpleMediaSubsession::closeStreamSource\n"); //comment-me
 	m_simpleFramedSource_mutex.lock();
-	m_simpleFramedSource= NULL;
+	m_simpleFramedSources.remove((SimpleFramedSource*)inputSource);
 	m_simpleFramedSource_mutex.unlock();
 	OnDemandServerMediaSubsession::closeStreamSource(inputSource);
 	LOGD("<< SimpleMediaSubsession::closeStreamSource\n"); //comment-me
@@ -2070,6 +4727,7 @@ RTPSink* SimpleMediaSubsession::createNewRTPSink(Groupsock* rtpGroupsock,
 	char *sdp_p; // Do not release
 	RTPSink *rtpSink= NULL;
 	char *type_str= NULL, *subtype_str= NULL;
+	rtp_pacing_settings_t rtp_pacing_settings;
 	LOG_CTX_INIT(m_log_ctx);
 	LOGD(">>SimpleMediaSubsession::createNewRTPSink\n"); //comment-me
 
@@ -2093,11 +4751,22 @@ RTPSink* SimpleMediaSubsession::createNewRTPSink(Groupsock* rtpGroupsock,
 	//	"function pointer"= myRTPSink::createNew;
 	//}
 
-	/* Create Sink */
+	/* Get current RTP pacing settings */
+	m_simpleFramedSource_mutex.lock();
+	rtp_pacing_settings= m_rtp_pacing_settings;
+	m_simpleFramedSource_mutex.unlock();
+
+	/* Create Sink.
+	 * Note that the sink's pacer accounts its queued bytes in our framed
+	 * source (the source is closed after the sink).
+	 */
 	rtpSink= SimpleRTPSink2::createNew(envir(), rtpGroupsock,
 			rtpPayloadTypeIfDynamic, 90000, type_str, subtype_str,
 			1,
-			False/*allowMultipleFramesPerPacket*/, True /*doNormalMBitRule*/);
+			False/*allowMultipleFramesPerPacket*/, True /*doNormalMBitRule*/,
+			&rtp_pacing_settings,
+			inputSource!= NULL? &((SimpleFramedSource*)inputSource)->
+					m_pacing_queue_bytes: NULL);
 
 end:
 	if(type_str!= NULL)
@@ -2108,6 +4777,114 @@ end:
 	return rtpSink;
 }
 
+/* **** Multicast "media sub-session" class implementation **** */
+
+SimpleMulticastMediaSubsession* SimpleMulticastMediaSubsession::createNew(
+		UsageEnvironment &env, SimpleMediaSubsession *simpleMediaSubsession,
+		const char *multicast_address, portNumBits rtpPortNum, u_int8_t ttl,
+		log_ctx_t *log_ctx)
+{
+	struct in_addr destinationAddress;
+	unsigned estBitrate= 0;
+	char cname[128]= {0};
+	Groupsock *rtpGroupsock= NULL, *rtcpGroupsock= NULL;
+	FramedSource *framedSource= NULL;
+	RTPSink *rtpSink= NULL;
+	RTCPInstance *rtcpInstance= NULL;
+	SimpleMulticastMediaSubsession *simpleMulticastMediaSubsession= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(simpleMediaSubsession!= NULL, return NULL);
+	CHECK_DO(multicast_address!= NULL, return NULL);
+
+	destinationAddress.s_addr= our_inet_addr(multicast_address);
+	if(!IsMulticastAddress(destinationAddress.s_addr)) {
+		LOGE("Not a multicast address: '%s'\n", multicast_address);
+		goto end;
+	}
+
+	/* Create the RTP and RTCP 'groupsocks' (we only send) */
+	rtpGroupsock= new Groupsock(env, destinationAddress, Port(rtpPortNum),
+			ttl);
+	rtcpGroupsock= new Groupsock(env, destinationAddress,
+			Port(rtpPortNum+ 1), ttl);
+	if(rtpGroupsock->socketNum()< 0 || rtcpGroupsock->socketNum()< 0) {
+		LOGE("Live555: %s\n", env.getResultMsg());
+		goto end;
+	}
+	rtpGroupsock->multicastSendOnly();
+	rtcpGroupsock->multicastSendOnly();
+
+	/* Create the source and the RTP sink (as for any unicast session) */
+	framedSource= simpleMediaSubsession->createNewStreamSource(0, estBitrate);
+	CHECK_DO(framedSource!= NULL, goto end);
+	rtpSink= simpleMediaSubsession->createNewRTPSink(rtpGroupsock,
+			MULTICAST_RTP_PAYLOAD_TYPE, framedSource);
+	CHECK_DO(rtpSink!= NULL, goto end);
+
+	/* Create the RTCP instance */
+	gethostname(cname, sizeof(cname)- 1);
+	rtcpInstance= RTCPInstance::createNew(env, rtcpGroupsock, estBitrate,
+			(unsigned char*)cname, rtpSink, NULL/*we're a server*/,
+			True/*we're a SSM source*/);
+	CHECK_DO(rtcpInstance!= NULL, goto end);
+
+	simpleMulticastMediaSubsession= new SimpleMulticastMediaSubsession(
+			*rtpSink, rtcpInstance, simpleMediaSubsession, framedSource,
+			rtpGroupsock, rtcpGroupsock);
+
+	/* Start streaming: the source receives the live frames from now on */
+	simpleMediaSubsession->sourceRegister((SimpleFramedSource*)framedSource);
+	simpleMediaSubsession->m_rtpSinks[0]= rtpSink;
+	rtpSink->startPlaying(*framedSource, NULL, NULL);
+	return simpleMulticastMediaSubsession;
+
+end:
+	if(rtcpInstance!= NULL)
+		Medium::close(rtcpInstance);
+	if(rtpSink!= NULL)
+		Medium::close(rtpSink);
+	if(framedSource!= NULL)
+		simpleMediaSubsession->closeStreamSource(framedSource);
+	if(rtpGroupsock!= NULL)
+		delete rtpGroupsock;
+	if(rtcpGroupsock!= NULL)
+		delete rtcpGroupsock;
+	return NULL;
+}
+
+SimpleMulticastMediaSubsession::SimpleMulticastMediaSubsession(
+		RTPSink &rtpSink, RTCPInstance *rtcpInstance,
+		SimpleMediaSubsession *simpleMediaSubsession,
+		FramedSource *framedSource, Groupsock *rtpGroupsock,
+		Groupsock *rtcpGroupsock):
+				PassiveServerMediaSubsession(rtpSink, rtcpInstance),
+				m_simpleMediaSubsession(simpleMediaSubsession),
+				m_framedSource(framedSource),
+				m_rtpSink(&rtpSink),
+				m_rtcpInstance(rtcpInstance),
+				m_rtpGroupsock(rtpGroupsock),
+				m_rtcpGroupsock(rtcpGroupsock)
+{
+}
+
+SimpleMulticastMediaSubsession::~SimpleMulticastMediaSubsession()
+{
+	/* Stop streaming and release the stream objects; the source is
+	 * unregistered from the ES-multiplexer sub-session, which is released
+	 * at last.
+	 */
+	m_rtpSink->stopPlaying();
+	m_simpleMediaSubsession->m_rtpSinks.erase(0);
+	Medium::close(m_rtcpInstance);
+	Medium::close(m_rtpSink);
+	m_simpleMediaSubsession->closeStreamSource(m_framedSource);
+	delete m_rtpGroupsock;
+	delete m_rtcpGroupsock;
+	Medium::close(m_simpleMediaSubsession);
+}
+
 /* **** De-multiplexer **** */
 
 /**
@@ -2164,40 +4941,135 @@ static proc_ctx_t* live555_rtsp_dmux_open(const proc_if_t *proc_if,
 	end_code= STAT_SUCCESS;
 end:
     if(end_code!= STAT_SUCCESS)
-    	live555_rtsp_dmux_close((proc_ctx_t**)&live555_rtsp_dmux_ctx);
-	return (proc_ctx_t*)live555_rtsp_dmux_ctx;
+    	live555_rtsp_dmux_close((proc_ctx_t**)&live555_rtsp_dmux_ctx);
+	return (proc_ctx_t*)live555_rtsp_dmux_ctx;
+}
+
+static int live555_rtsp_dmux_init_given_settings(
+		live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx,
+		const muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx,
+		log_ctx_t *log_ctx)
+{
+	int ret_code, end_code= STAT_ERROR;
+	live555_rtsp_dmux_init_args_t live555_rtsp_dmux_init_args;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_dmux_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(muxers_settings_dmux_ctx!= NULL, return STAT_ERROR);
+	// Note: 'log_ctx' is allowed to be NULL
+
+	/* Get a (shared) Live555 event-loop from the pool */
+	live555_rtsp_dmux_ctx->live555_event_loop= live555_event_loop_acquire(
+			LOG_CTX_GET());
+	CHECK_DO(live555_rtsp_dmux_ctx->live555_event_loop!= NULL, goto end);
+	live555_rtsp_dmux_ctx->taskScheduler= live555_event_loop_get_scheduler(
+			live555_rtsp_dmux_ctx->live555_event_loop);
+	CHECK_DO(live555_rtsp_dmux_ctx->taskScheduler!= NULL, goto end);
+
+	/* Create the RTSP client and start the session in the event-loop thread
+	 * (Live555 objects are not thread-safe).
+	 */
+	live555_rtsp_dmux_init_args.live555_rtsp_dmux_ctx= live555_rtsp_dmux_ctx;
+	live555_rtsp_dmux_init_args.muxers_settings_dmux_ctx=
+			muxers_settings_dmux_ctx;
+	live555_rtsp_dmux_init_args.log_ctx= LOG_CTX_GET();
+	ret_code= live555_event_loop_run_sync(
+			live555_rtsp_dmux_ctx->live555_event_loop,
+			live555_rtsp_dmux_init_on_loop, &live555_rtsp_dmux_init_args);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	end_code= STAT_SUCCESS;
+end:
+    if(end_code!= STAT_SUCCESS)
+    	live555_rtsp_dmux_deinit_except_settings(live555_rtsp_dmux_ctx,
+    			LOG_CTX_GET());
+	return end_code;
 }
 
-static int live555_rtsp_dmux_init_given_settings(
-		live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx,
-		const muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx,
-		log_ctx_t *log_ctx)
+/**
+ * Create the Live555's RTSP client and send the RTSP "DESCRIBE" command
+ * (this function is executed in the event-loop thread).
+ * @param t Pointer to the arguments structure (live555_rtsp_dmux_init_args_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_dmux_init_on_loop(void *t)
 {
-	int end_code= STAT_ERROR;
-	LOG_CTX_INIT(log_ctx);
+	const char *rtsp_url;
+	int ret_code;
+	live555_rtsp_dmux_init_args_t *live555_rtsp_dmux_init_args=
+			(live555_rtsp_dmux_init_args_t*)t;
+	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx= NULL; // Do not release
+	const muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx=
+			NULL; // Do not release
+	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
+	CHECK_DO(live555_rtsp_dmux_init_args!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(live555_rtsp_dmux_init_args->log_ctx);
+
+	live555_rtsp_dmux_ctx= live555_rtsp_dmux_init_args->live555_rtsp_dmux_ctx;
 	CHECK_DO(live555_rtsp_dmux_ctx!= NULL, return STAT_ERROR);
+	muxers_settings_dmux_ctx=
+			live555_rtsp_dmux_init_args->muxers_settings_dmux_ctx;
 	CHECK_DO(muxers_settings_dmux_ctx!= NULL, return STAT_ERROR);
-	// Note: 'log_ctx' is allowed to be NULL
-
-	/* Open Live555 scheduler */
-	live555_rtsp_dmux_ctx->taskScheduler= BasicTaskScheduler::createNew();
-	CHECK_DO(live555_rtsp_dmux_ctx->taskScheduler!= NULL, goto end);
 
 	/* Set up Live555 usage environment. */
 	live555_rtsp_dmux_ctx->usageEnvironment= BasicUsageEnvironment::createNew(
 			*live555_rtsp_dmux_ctx->taskScheduler);
-	CHECK_DO(live555_rtsp_dmux_ctx->usageEnvironment!= NULL, goto end);
+	CHECK_DO(live555_rtsp_dmux_ctx->usageEnvironment!= NULL,
+			return STAT_ERROR);
 	live555_rtsp_dmux_ctx->usageEnvironment->liveMediaPriv= NULL;
 	live555_rtsp_dmux_ctx->usageEnvironment->groupsockPriv= NULL;
 
-	end_code= STAT_SUCCESS;
-end:
-    if(end_code!= STAT_SUCCESS)
-    	live555_rtsp_dmux_deinit_except_settings(live555_rtsp_dmux_ctx,
-    			LOG_CTX_GET());
-	return end_code;
+	/* Create a unique "RTSPClient" for the stream that we wish to
+	 * receive ("rtsp://" URL).
+	 * Note that the output FIFO is not created yet (it is created by the
+	 * PROC module after opening this instance); thus, we pass a reference to
+	 * the FIFO pointer.
+	 */
+	rtsp_url= muxers_settings_dmux_ctx->rtsp_url;
+	if(rtsp_url== NULL) {
+		LOGE("A valid RTSP URL must be provided\n");
+		return STAT_ERROR;
+	}
+	live555_rtsp_dmux_ctx->simpleRTSPClient= SimpleRTSPClient::createNew(
+			*live555_rtsp_dmux_ctx->usageEnvironment, rtsp_url,
+			&((proc_ctx_t*)live555_rtsp_dmux_ctx)->flag_exit,
+			&((proc_ctx_t*)live555_rtsp_dmux_ctx)->fifo_ctx_array[PROC_OPUT],
+			&live555_rtsp_dmux_ctx->simpleRTSPClient,
+			(unsigned)live555_rtsp_dmux_ctx->live555_rtsp_dmux_settings_ctx.
+			jitter_buffer_msecs,
+			(unsigned)live555_rtsp_dmux_ctx->live555_rtsp_dmux_settings_ctx.
+			receive_buffer_size,
+			(unsigned)live555_rtsp_dmux_ctx->live555_rtsp_dmux_settings_ctx.
+			receive_buffer_size_max,
+			&live555_rtsp_dmux_ctx->truncated_frames,
+			0/*No-verbose*/, "n/a"/*application-name*/, 0, LOG_CTX_GET());
+	if(live555_rtsp_dmux_ctx->simpleRTSPClient== NULL) {
+		LOGE("Failed to create a RTSP client for URL %s: %s\n", rtsp_url,
+				live555_rtsp_dmux_ctx->usageEnvironment->getResultMsg());
+		return STAT_ERROR;
+	}
+
+	/* Send a RTSP "DESCRIBE" command to get a SDP description for the stream.
+	 * Note that this command -like all RTSP commands- is sent asynchronously;
+	 * we do not block waiting for a response, instead, the following function
+	 * call returns immediately, and we handle the RTSP response later, from
+	 * within the (shared) event-loop thread.
+	 */
+	ret_code= live555_rtsp_dmux_ctx->simpleRTSPClient->sendDescribeCommand(
+			continueAfterDESCRIBE);
+	if(ret_code== 0) {
+		LOGE("Failed to send DESCRIBE to RTSP client for URL %s: %s\n",
+				rtsp_url,
+				live555_rtsp_dmux_ctx->usageEnvironment->getResultMsg());
+		return STAT_ERROR;
+	}
+
+	return STAT_SUCCESS;
 }
 
 /**
@@ -2217,10 +5089,10 @@ static void live555_rtsp_dmux_close(proc_ctx_t **ref_proc_ctx)
 			NULL) {
 		LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_dmux_ctx)->log_ctx);
 
-		/* Implementation note: 'live555_rtsp_dmux_process_frame()' is
-		 * exited first (and previously,
+		/* Implementation note: the RTSP client was already stopped in the
+		 * event-loop thread by 'live555_rtsp_dmux_unblock()' (and previously,
 		 * '((proc_ctx_t*)live555_rtsp_dmux_ctx)->flag_exit' is set to 1
-		 * accordingly.
+		 * accordingly).
 		 */
 
 		/* Release settings */
@@ -2249,6 +5121,41 @@ static void live555_rtsp_dmux_deinit_except_settings(
 	if(live555_rtsp_dmux_ctx== NULL)
 		return;
 
+	/* Live555 objects must be released in the event-loop thread; the
+	 * event-loop itself is shared, thus we just return it to the pool.
+	 */
+	if(live555_rtsp_dmux_ctx->live555_event_loop!= NULL) {
+		int ret_code= live555_event_loop_run_sync(
+				live555_rtsp_dmux_ctx->live555_event_loop,
+				live555_rtsp_dmux_deinit_on_loop, live555_rtsp_dmux_ctx);
+		ASSERT(ret_code== STAT_SUCCESS);
+	}
+	live555_event_loop_release(&live555_rtsp_dmux_ctx->live555_event_loop);
+	live555_rtsp_dmux_ctx->taskScheduler= NULL;
+}
+
+/**
+ * Release the Live555's RTSP de-multiplexer resources (this function is
+ * executed in the event-loop thread).
+ * @param t Pointer to the de-multiplexer context structure
+ * (live555_rtsp_dmux_ctx_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_dmux_deinit_on_loop(void *t)
+{
+	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx=
+			(live555_rtsp_dmux_ctx_t*)t;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_dmux_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(((proc_ctx_t*)live555_rtsp_dmux_ctx)->log_ctx);
+
+	/* Stop client if not done yet (e.g. error while opening) */
+	live555_rtsp_dmux_stop_on_loop(live555_rtsp_dmux_ctx);
+
 	if(live555_rtsp_dmux_ctx->usageEnvironment!= NULL) {
 		Boolean ret_boolean= live555_rtsp_dmux_ctx->usageEnvironment->reclaim();
 		ASSERT(ret_boolean== True);
@@ -2256,10 +5163,60 @@ static void live555_rtsp_dmux_deinit_except_settings(
 			live555_rtsp_dmux_ctx->usageEnvironment= NULL;
 	}
 
-	if(live555_rtsp_dmux_ctx->taskScheduler!= NULL) {
-		delete live555_rtsp_dmux_ctx->taskScheduler;
-		live555_rtsp_dmux_ctx->taskScheduler= NULL;
-	}
+	return STAT_SUCCESS;
+}
+
+/**
+ * Implements the proc_if_s::unblock callback.
+ * The de-multiplexer does not run a processing thread: the RTSP session is
+ * served by the (shared) event-loop thread. Unblocking consists in shutting
+ * down the RTSP session in the event-loop, so no more frames are delivered
+ * to the output FIFO.
+ * See .proc_if.h for further details.
+ */
+static int live555_rtsp_dmux_unblock(proc_ctx_t *proc_ctx)
+{
+	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx= NULL; // Do not release
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_ctx->log_ctx);
+
+	live555_rtsp_dmux_ctx= (live555_rtsp_dmux_ctx_t*)proc_ctx;
+
+	if(live555_rtsp_dmux_ctx->live555_event_loop== NULL)
+		return STAT_SUCCESS;
+
+	return live555_event_loop_run_sync(live555_rtsp_dmux_ctx->live555_event_loop,
+			live555_rtsp_dmux_stop_on_loop, live555_rtsp_dmux_ctx);
+}
+
+/**
+ * Shut down the RTSP session, if still alive (this function is executed in
+ * the event-loop thread).
+ * @param t Pointer to the de-multiplexer context structure
+ * (live555_rtsp_dmux_ctx_t).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+static int live555_rtsp_dmux_stop_on_loop(void *t)
+{
+	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx=
+			(live555_rtsp_dmux_ctx_t*)t;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(live555_rtsp_dmux_ctx!= NULL, return STAT_ERROR);
+
+	/* Note that closing the client sets
+	 * 'live555_rtsp_dmux_ctx::simpleRTSPClient' to NULL (see
+	 * 'SimpleRTSPClient::~SimpleRTSPClient()').
+	 */
+	if(live555_rtsp_dmux_ctx->simpleRTSPClient!= NULL)
+		shutdownStream(live555_rtsp_dmux_ctx->simpleRTSPClient);
+	return STAT_SUCCESS;
 }
 
 /**
@@ -2299,7 +5256,10 @@ static int live555_rtsp_dmux_rest_get(proc_ctx_t *proc_ctx,
 	 * {
 	 *     "settings":
 	 *     {
-	 *         "rtsp_url":string
+	 *         "rtsp_url":string,
+	 *         "jitter_buffer_msecs":number,
+	 *         "receive_buffer_size":number,
+	 *         "receive_buffer_size_max":number
 	 *     },
 	 *     elementary_streams:
 	 *     [
@@ -2332,6 +5292,25 @@ static int live555_rtsp_dmux_rest_get(proc_ctx_t *proc_ctx,
 	CHECK_DO(cjson_aux!= NULL, goto end);
 	cJSON_AddItemToObject(cjson_settings, "rtsp_url", cjson_aux);
 
+	/* 'jitter_buffer_msecs' */
+	cjson_aux= cJSON_CreateNumber(
+			(double)live555_rtsp_dmux_settings_ctx->jitter_buffer_msecs);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "jitter_buffer_msecs", cjson_aux);
+
+	/* 'receive_buffer_size' */
+	cjson_aux= cJSON_CreateNumber(
+			(double)live555_rtsp_dmux_settings_ctx->receive_buffer_size);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "receive_buffer_size", cjson_aux);
+
+	/* 'receive_buffer_size_max' */
+	cjson_aux= cJSON_CreateNumber(
+			(double)live555_rtsp_dmux_settings_ctx->receive_buffer_size_max);
+	CHECK_DO(cjson_aux!= NULL, goto end);
+	cJSON_AddItemToObject(cjson_settings, "receive_buffer_size_max",
+			cjson_aux);
+
 	/* Attach settings object to REST response */
 	cJSON_AddItemToObject(cjson_rest, "settings", cjson_settings);
 	cjson_settings= NULL; // Attached; avoid double referencing
@@ -2342,10 +5321,12 @@ static int live555_rtsp_dmux_rest_get(proc_ctx_t *proc_ctx,
 	cjson_es_array= cJSON_CreateArray();
 	CHECK_DO(cjson_es_array!= NULL, goto end);
 
+	/* Note: the client may have been already shut down (e.g. unrecoverable
+	 * session error); we just report no elementary streams in that case.
+	 */
 	simpleRTSPClient= live555_rtsp_dmux_ctx->simpleRTSPClient;
-	CHECK_DO(simpleRTSPClient!= NULL, goto end);
-
-	session= simpleRTSPClient->streamClientState.session;
+	session= simpleRTSPClient!= NULL?
+			simpleRTSPClient->streamClientState.session: NULL;
 	if(session!= NULL) {
 		MediaSubsession *subsession= NULL;
 		MediaSubsessionIterator iter(*session);
@@ -2387,13 +5368,6 @@ static int live555_rtsp_dmux_rest_get(proc_ctx_t *proc_ctx,
 	cJSON_AddItemToObject(cjson_rest, "elementary_streams", cjson_es_array);
 	cjson_es_array= NULL; // Attached; avoid double referencing
 
-	// Reserved for future use
-	/* Example:
-	 * cjson_aux= cJSON_CreateNumber((double)live555_rtsp_dmux_ctx->var1);
-	 * CHECK_DO(cjson_aux!= NULL, goto end);
-	 * cJSON_AddItemToObject(cjson_rest, "var1_name", cjson_aux);
-	 */
-
 	// Reserved for future use: set other data values here...
 
 	/* Format response to be returned */
@@ -2427,95 +5401,32 @@ end:
 }
 
 /**
- * Implements the proc_if_s::process_frame callback.
+ * Implements the proc_if_s::stats_get_stream callback.
  * See .proc_if.h for further details.
  */
-static int live555_rtsp_dmux_process_frame(proc_ctx_t *proc_ctx,
-		fifo_ctx_t* iput_fifo_ctx, fifo_ctx_t* oput_fifo_ctx)
+static int live555_rtsp_dmux_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx)
 {
-	char *rtsp_url;
-	char volatile *watchVariable;
-	int ret_code, end_code= STAT_ERROR;
-	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx= NULL; // Do not release
-	volatile live555_rtsp_dmux_settings_ctx_t *live555_rtsp_dmux_settings_ctx=
-			NULL; // Do not release (alias)
-	volatile muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx=
-			NULL; // Do not release (alias)
-	UsageEnvironment *usageEnvironment= NULL; // Do not release
+	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx= NULL;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
 	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
-	CHECK_DO(iput_fifo_ctx!= NULL, return STAT_ERROR);
-	CHECK_DO(oput_fifo_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
 
 	LOG_CTX_SET(proc_ctx->log_ctx);
 
-	/* Get multiplexer context */
-	live555_rtsp_dmux_ctx= (live555_rtsp_dmux_ctx_t*)proc_ctx;
-
-	/* Get Live555's usage environment */
-	usageEnvironment= live555_rtsp_dmux_ctx->usageEnvironment;
-	CHECK_DO(usageEnvironment!= NULL, goto end);
-
-	/* Get settings structures */
-	live555_rtsp_dmux_settings_ctx=
-			&live555_rtsp_dmux_ctx->live555_rtsp_dmux_settings_ctx;
-	muxers_settings_dmux_ctx=
-			&live555_rtsp_dmux_settings_ctx->muxers_settings_dmux_ctx;
-
-	/* Create a unique "RTSPClient" for the stream that we wish to
-	 * receive ("rtsp://" URL).
-	 */
-	rtsp_url= muxers_settings_dmux_ctx->rtsp_url;
-	if(rtsp_url== NULL) {
-		LOGE("A valid RTSP URL must be provided\n");
-		goto end;
-	}
-	live555_rtsp_dmux_ctx->simpleRTSPClient= SimpleRTSPClient::createNew(
-			*live555_rtsp_dmux_ctx->usageEnvironment, rtsp_url,
-			&((proc_ctx_t*)live555_rtsp_dmux_ctx)->flag_exit,
-			((proc_ctx_t*)live555_rtsp_dmux_ctx)->fifo_ctx_array[PROC_OPUT],
-			0/*No-verbose*/, "n/a"/*application-name*/, 0, LOG_CTX_GET());
-	if(live555_rtsp_dmux_ctx->simpleRTSPClient== NULL) {
-		LOGE("Failed to create a RTSP client for URL %s: %s\n", rtsp_url,
-				live555_rtsp_dmux_ctx->usageEnvironment->getResultMsg());
-		goto end;
-	}
-
-	/* Send a RTSP "DESCRIBE" command to get a SDP description for the stream.
-	 * Note that this command -like all RTSP commands- is sent asynchronously;
-	 * we do not block waiting for a response, instead, the following function
-	 * call returns immediately, and we handle the RTSP response later, from
-	 * within the event loop 'doEventLoop()'.
-	 *
-	 */
-	ret_code= live555_rtsp_dmux_ctx->simpleRTSPClient->sendDescribeCommand(
-			continueAfterDESCRIBE);
-	if(ret_code== 0) {
-		LOGE("Failed to send DESCRIBE to RTSP client for URL %s: %s\n",
-				rtsp_url,
-				live555_rtsp_dmux_ctx->usageEnvironment->getResultMsg());
-		goto end;
-	}
-
-	/* Implementation note: In the case of the LIVE555's de-multiplexer
-	 * implementation, we use 'live555_rtsp_dmux_process_frame()' just to
-	 * execute the task scheduler event loop. We do not read nor write to
-	 * input or output FIFOs directly. This is performed synchronously using
-	 * the task scheduler registered events.
+	/* Members to be written:
+	 *     "truncated_frames":number
+	 *     ... // Reserved for future use
 	 */
 
-	/* Run the scheduler until "exit flag" is set */
-	watchVariable= (char volatile*)
-			&((proc_ctx_t*)live555_rtsp_dmux_ctx)->flag_exit;
-	usageEnvironment->taskScheduler().doEventLoop(watchVariable);
+	live555_rtsp_dmux_ctx= (live555_rtsp_dmux_ctx_t*)proc_ctx;
 
-	end_code= STAT_SUCCESS;
-end:
-	if(live555_rtsp_dmux_ctx->simpleRTSPClient!= NULL)
-		shutdownStream(live555_rtsp_dmux_ctx->simpleRTSPClient);
-	return end_code;
+	/* 'truncated_frames': frames dropped as exceeding the receive buffer */
+	return json_writer_int(json_writer_ctx, "truncated_frames",
+			(int64_t)__atomic_load_n(&live555_rtsp_dmux_ctx->truncated_frames,
+			__ATOMIC_RELAXED));
 }
 
 /**
@@ -2524,11 +5435,15 @@ end:
  */
 static int live555_rtsp_dmux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 {
-	int ret_code;
+	int ret_code, flag_is_query, end_code= STAT_ERROR;
 	live555_rtsp_dmux_ctx_t *live555_rtsp_dmux_ctx= NULL;
 	volatile live555_rtsp_dmux_settings_ctx_t *
 		live555_rtsp_dmux_settings_ctx= NULL;
 	volatile muxers_settings_dmux_ctx_t *muxers_settings_dmux_ctx= NULL;
+	char *jitter_buffer_msecs_str= NULL, *receive_buffer_size_str= NULL,
+			*receive_buffer_size_max_str= NULL;
+	int jitter_buffer_msecs, receive_buffer_size, receive_buffer_size_max;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
@@ -2552,12 +5467,69 @@ static int live555_rtsp_dmux_rest_put(proc_ctx_t *proc_ctx, const char *str)
 
 
 	/* PUT specific de-multiplexer settings */
-	// Reserved for future use
+
+	/* Guess string representation format (JSON-REST or Query) */
+	flag_is_query= (str[0]=='{' && str[strlen(str)-1]=='}')? 0: 1;
+
+	/* Get jitter and receive buffers settings (parse all before applying) */
+	jitter_buffer_msecs= live555_rtsp_dmux_settings_ctx->jitter_buffer_msecs;
+	receive_buffer_size= live555_rtsp_dmux_settings_ctx->receive_buffer_size;
+	receive_buffer_size_max=
+			live555_rtsp_dmux_settings_ctx->receive_buffer_size_max;
+	if(flag_is_query== 1) {
+		jitter_buffer_msecs_str= uri_parser_query_str_get_value(
+				"jitter_buffer_msecs", str);
+		if(jitter_buffer_msecs_str!= NULL)
+			jitter_buffer_msecs= atoi(jitter_buffer_msecs_str);
+		receive_buffer_size_str= uri_parser_query_str_get_value(
+				"receive_buffer_size", str);
+		if(receive_buffer_size_str!= NULL)
+			receive_buffer_size= atoi(receive_buffer_size_str);
+		receive_buffer_size_max_str= uri_parser_query_str_get_value(
+				"receive_buffer_size_max", str);
+		if(receive_buffer_size_max_str!= NULL)
+			receive_buffer_size_max= atoi(receive_buffer_size_max_str);
+	} else {
+		/* In the case string format is JSON-REST, parse to cJSON structure */
+		cjson_rest= cJSON_Parse(str);
+		CHECK_DO(cjson_rest!= NULL, goto end);
+
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "jitter_buffer_msecs");
+		if(cjson_aux!= NULL)
+			jitter_buffer_msecs= (int)cjson_aux->valuedouble;
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "receive_buffer_size");
+		if(cjson_aux!= NULL)
+			receive_buffer_size= (int)cjson_aux->valuedouble;
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "receive_buffer_size_max");
+		if(cjson_aux!= NULL)
+			receive_buffer_size_max= (int)cjson_aux->valuedouble;
+	}
+	CHECK_DO(jitter_buffer_msecs>= 0 &&
+			jitter_buffer_msecs<= JITTER_BUFFER_MSECS_MAX,
+			end_code= STAT_EINVAL; goto end);
+	CHECK_DO(receive_buffer_size> 0 &&
+			receive_buffer_size<= receive_buffer_size_max &&
+			receive_buffer_size_max<= BUFFER_SIZE_LIMIT,
+			end_code= STAT_EINVAL; goto end);
+	live555_rtsp_dmux_settings_ctx->jitter_buffer_msecs= jitter_buffer_msecs;
+	live555_rtsp_dmux_settings_ctx->receive_buffer_size= receive_buffer_size;
+	live555_rtsp_dmux_settings_ctx->receive_buffer_size_max=
+			receive_buffer_size_max;
 
 	/* Finally that we have new settings parsed, reset processor */
 	live555_rtsp_reset_on_new_settings(proc_ctx, 0, LOG_CTX_GET());
 
-	return STAT_SUCCESS;
+	end_code= STAT_SUCCESS;
+end:
+	if(jitter_buffer_msecs_str!= NULL)
+		free(jitter_buffer_msecs_str);
+	if(receive_buffer_size_str!= NULL)
+		free(receive_buffer_size_str);
+	if(receive_buffer_size_max_str!= NULL)
+		free(receive_buffer_size_max_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return end_code;
 }
 
 /**
@@ -2587,7 +5559,11 @@ static int live555_rtsp_dmux_settings_ctx_init(
 		return ret_code;
 
 	/* Initialize specific de-multiplexer settings */
-	// Reserved for future use
+	live555_rtsp_dmux_settings_ctx->jitter_buffer_msecs=
+			JITTER_BUFFER_MSECS_DEFAULT;
+	live555_rtsp_dmux_settings_ctx->receive_buffer_size= SINK_BUFFER_SIZE;
+	live555_rtsp_dmux_settings_ctx->receive_buffer_size_max=
+			RECEIVE_BUFFER_SIZE_MAX_DEFAULT;
 
 	return STAT_SUCCESS;
 }
@@ -2763,6 +5739,11 @@ static void continueAfterSETUP(RTSPClient *rtspClient, int resultCode,
 		goto end;
 	}
 
+	/* Set the jitter buffer depth (RTP packets re-ordering threshold) */
+	if(subsession->rtpSource()!= NULL)
+		subsession->rtpSource()->setPacketReorderingThresholdTime(
+				((SimpleRTSPClient*)rtspClient)->m_jitterBufferMSecs* 1000);
+
 	port= subsession->clientPortNum();
 	snprintf(extra_port_str, sizeof(extra_port_str), ", %d", port+ 1);
 	LOGW("[URL: '%s'] Set up the sub-session '%s/%s' (client port[s] %d%s)\n",
@@ -2776,8 +5757,11 @@ static void continueAfterSETUP(RTSPClient *rtspClient, int resultCode,
      * happening until later, after we've sent a RTSP "PLAY" command).
      */
     subsession->sink= DummySink::createNew(*usageEnvironment, *subsession,
-    		((SimpleRTSPClient*)rtspClient)->m_fifo_ctx, rtspClient->url(),
-			LOG_CTX_GET());
+    		((SimpleRTSPClient*)rtspClient)->m_ref_fifo_ctx,
+			((SimpleRTSPClient*)rtspClient)->m_receiveBufferSize,
+			((SimpleRTSPClient*)rtspClient)->m_receiveBufferSizeMax,
+			((SimpleRTSPClient*)rtspClient)->m_ref_truncated_frames,
+			rtspClient->url(), LOG_CTX_GET());
     CHECK_DO(subsession->sink!= NULL, goto end);
     // hack to let sub-session handler functions get the "RTSPClient" from
     // the sub-session
@@ -2925,30 +5909,45 @@ static void shutdownStream(RTSPClient *rtspClient, int exitCode)
 
 SimpleRTSPClient* SimpleRTSPClient::createNew(UsageEnvironment& env,
 		char const* rtspURL, volatile int *ref_flag_exit,
-		fifo_ctx_t *fifo_ctx, int verbosityLevel,
-		char const* applicationName,
+		fifo_ctx_t **ref_fifo_ctx, SimpleRTSPClient **ref_simpleRTSPClient,
+		unsigned jitterBufferMSecs, unsigned receiveBufferSize,
+		unsigned receiveBufferSizeMax, volatile uint64_t *ref_truncated_frames,
+		int verbosityLevel, char const* applicationName,
 		portNumBits tunnelOverHTTPPortNum, log_ctx_t *log_ctx)
 {
-	return new SimpleRTSPClient(env, rtspURL, ref_flag_exit, fifo_ctx,
-			verbosityLevel, applicationName, tunnelOverHTTPPortNum, log_ctx);
+	return new SimpleRTSPClient(env, rtspURL, ref_flag_exit, ref_fifo_ctx,
+			ref_simpleRTSPClient, jitterBufferMSecs, receiveBufferSize,
+			receiveBufferSizeMax, ref_truncated_frames, verbosityLevel,
+			applicationName, tunnelOverHTTPPortNum, log_ctx);
 }
 
 SimpleRTSPClient::SimpleRTSPClient(UsageEnvironment& env, char const* rtspURL,
-		volatile int *ref_flag_exit, fifo_ctx_t *fifo_ctx, int verbosityLevel,
+		volatile int *ref_flag_exit, fifo_ctx_t **ref_fifo_ctx,
+		SimpleRTSPClient **ref_simpleRTSPClient, unsigned jitterBufferMSecs,
+		unsigned receiveBufferSize, unsigned receiveBufferSizeMax,
+		volatile uint64_t *ref_truncated_frames, int verbosityLevel,
 		char const* applicationName, portNumBits tunnelOverHTTPPortNum,
 		log_ctx_t *log_ctx):
 				RTSPClient(env,rtspURL, verbosityLevel, applicationName,
 						tunnelOverHTTPPortNum, -1),
 				m_ref_flag_exit(ref_flag_exit),
 				m_log_ctx(log_ctx),
-				m_fifo_ctx(fifo_ctx)
+				m_ref_fifo_ctx(ref_fifo_ctx),
+				m_ref_simpleRTSPClient(ref_simpleRTSPClient),
+				m_jitterBufferMSecs(jitterBufferMSecs),
+				m_receiveBufferSize(receiveBufferSize),
+				m_receiveBufferSizeMax(receiveBufferSizeMax),
+				m_ref_truncated_frames(ref_truncated_frames)
 {
 	LOG_CTX_INIT(m_log_ctx);
-	ASSERT(fifo_ctx!= NULL);
+	ASSERT(ref_fifo_ctx!= NULL);
 }
 
 SimpleRTSPClient::~SimpleRTSPClient()
-{}
+{
+	if(m_ref_simpleRTSPClient!= NULL && *m_ref_simpleRTSPClient== this)
+		*m_ref_simpleRTSPClient= NULL;
+}
 
 SimpleClientMediaSubsession::SimpleClientMediaSubsession(MediaSession& parent):
 		MediaSubsession(parent)
@@ -3006,24 +6005,39 @@ StreamClientState::~StreamClientState()
 }
 
 DummySink* DummySink::createNew(UsageEnvironment& env,
-		MediaSubsession& subsession, fifo_ctx_t *fifo_ctx,
-		char const* streamId, log_ctx_t *log_ctx)
+		MediaSubsession& subsession, fifo_ctx_t **ref_fifo_ctx,
+		unsigned receiveBufferSize, unsigned receiveBufferSizeMax,
+		volatile uint64_t *ref_truncated_frames, char const* streamId,
+		log_ctx_t *log_ctx)
 {
-	return new DummySink(env, subsession, fifo_ctx, streamId, log_ctx);
+	return new DummySink(env, subsession, ref_fifo_ctx, receiveBufferSize,
+			receiveBufferSizeMax, ref_truncated_frames, streamId, log_ctx);
 }
 
 DummySink::DummySink(UsageEnvironment& env, MediaSubsession& subsession,
-		fifo_ctx_t *fifo_ctx, char const* streamId, log_ctx_t *log_ctx):
+		fifo_ctx_t **ref_fifo_ctx, unsigned receiveBufferSize,
+		unsigned receiveBufferSizeMax, volatile uint64_t *ref_truncated_frames,
+		char const* streamId, log_ctx_t *log_ctx):
 			MediaSink(env),
+			fReceiveBufferSize(receiveBufferSize),
+			fReceiveBufferSizeMax(receiveBufferSizeMax),
+			m_flagTruncated(false),
+			m_ref_truncated_frames(ref_truncated_frames),
 			fSubsession(subsession),
 			m_log_ctx(log_ctx),
-			m_fifo_ctx(fifo_ctx),
-			m_proc_frame_ctx(NULL)
+			m_ref_fifo_ctx(ref_fifo_ctx),
+			m_proc_frame_ctx(NULL),
+			m_flagPTSAnchored(false),
+			m_flagRTCPSynced(false),
+			m_rtpTimestampLast(0),
+			m_rtpTimestampExt(0),
+			m_rtpTimestampExtAnchor(0),
+			m_ptsAnchorUSecs(0)
 {
 	LOG_CTX_INIT(m_log_ctx);
 	fStreamId= strDup(streamId);
-	fReceiveBuffer= new u_int8_t[SINK_BUFFER_SIZE];
-	ASSERT(m_fifo_ctx!= NULL);
+	fReceiveBuffer= new u_int8_t[fReceiveBufferSize];
+	ASSERT(m_ref_fifo_ctx!= NULL);
 }
 
 DummySink::~DummySink() {
@@ -3060,9 +6074,11 @@ void DummySink::afterGettingFrame(unsigned frameSize,
 	int ret_code, m_bit= -1;
 	RTPSource *rtpsrc= NULL;
 	uint8_t *data= NULL;
+	fifo_ctx_t *fifo_ctx= NULL; // Do not release
 	LOG_CTX_INIT(m_log_ctx);
 	LOGD(">>%s (frameSize: %d; numTruncatedBytes: %d)\n", __FUNCTION__,
 			(int)frameSize, (int)numTruncatedBytes); //comment-me
+	USDT_PROBE2(dmux_after_getting_frame, frameSize, numTruncatedBytes);
 
 	/* Check arguments */
 	if(frameSize== 0)
@@ -3076,6 +6092,30 @@ void DummySink::afterGettingFrame(unsigned frameSize,
 	LOGD("%s/%s\n", fSubsession.mediumName(),
 			fSubsession.codecName()); //comment-me
 
+	/* A truncated fragment corrupts the whole access unit: account it,
+	 * grow the receive buffer for the next frames and drop the access unit
+	 * (decoders would otherwise waste time concealing corrupt data).
+	 */
+	if(numTruncatedBytes> 0) {
+		if(!m_flagTruncated) {
+			m_flagTruncated= true;
+			if(m_ref_truncated_frames!= NULL)
+				__atomic_add_fetch(m_ref_truncated_frames, 1,
+						__ATOMIC_RELAXED);
+			LOGW("[%s/%s] Frame truncated (%u bytes); dropping access "
+					"unit\n", fSubsession.mediumName(),
+					fSubsession.codecName(), numTruncatedBytes);
+		}
+		receiveBufferGrow(frameSize+ numTruncatedBytes);
+	}
+	if(m_flagTruncated) {
+		if(m_bit== 1) {
+			proc_frame_ctx_release(&m_proc_frame_ctx);
+			m_flagTruncated= false;
+		}
+		goto end;
+	}
+
 	/* Allocate de-multiplexer output frame if applicable */
 	if(m_proc_frame_ctx== NULL) {
 		m_proc_frame_ctx= proc_frame_ctx_allocate();
@@ -3103,7 +6143,7 @@ void DummySink::afterGettingFrame(unsigned frameSize,
 		m_proc_frame_ctx->width[0]= new_size;
 		m_proc_frame_ctx->height[0]= 1; // "1D" data
 		m_proc_frame_ctx->proc_sample_fmt= PROC_IF_FMT_UNDEF;
-		m_proc_frame_ctx->pts= 0; //FIXME!!
+		m_proc_frame_ctx->pts= ptsGet(presentationTime);
 		// We use port as the Id. as is an unique number for each elementary
 		// stream (unless, for example, we send a transport layer as MPEG2-TS,
 		// but it is also valid -elementary stream de-multiplexing will occur
@@ -3111,11 +6151,20 @@ void DummySink::afterGettingFrame(unsigned frameSize,
 		// means for de-multiplexing).
 		m_proc_frame_ctx->es_id= fSubsession.clientPortNum();
 
-		/* Write frame to input FIFO */
-		ret_code= fifo_put(m_fifo_ctx, (void**)&m_proc_frame_ctx,
+		/* Write frame to output FIFO.
+		 * The event-loop thread is shared with other instances, thus we
+		 * must never block here: if the FIFO is not available yet or is
+		 * full (or was unblocked because we are exiting processing), the
+		 * frame is dropped.
+		 */
+		fifo_ctx= __atomic_load_n(m_ref_fifo_ctx, __ATOMIC_ACQUIRE);
+		if(fifo_ctx== NULL) {
+			proc_frame_ctx_release(&m_proc_frame_ctx);
+			goto end;
+		}
+		ret_code= fifo_tryput(fifo_ctx, (void**)&m_proc_frame_ctx,
 				sizeof(void*));
 		if(ret_code== STAT_ENOMEM) {
-			/* This FIFO was unblocked, probably we are exiting processing */
 			proc_frame_ctx_release(&m_proc_frame_ctx);
 			goto end;
 		}
@@ -3138,6 +6187,79 @@ end:
 	return;
 }
 
+int64_t DummySink::ptsGet(struct timeval presentationTime)
+{
+	u_int32_t rtp_timestamp;
+	unsigned frequency;
+	int64_t pts, presentation_time_usecs;
+	bool flag_rtcp_synced;
+	RTPSource *rtpsrc= fSubsession.rtpSource();
+	LOG_CTX_INIT(m_log_ctx);
+
+	presentation_time_usecs= (int64_t)presentationTime.tv_sec* 1000000+
+			presentationTime.tv_usec;
+	if(rtpsrc== NULL || (frequency= rtpsrc->timestampFrequency())== 0)
+		return presentation_time_usecs;
+
+	/* Extend the 32-bit RTP time-stamp to 64 bits (handle wrap-around).
+	 * Note that all the packets of a frame share the same time-stamp.
+	 */
+	rtp_timestamp= rtpsrc->curPacketRTPTimestamp();
+	if(!m_flagPTSAnchored)
+		m_rtpTimestampExt= rtp_timestamp;
+	else
+		m_rtpTimestampExt+= (int32_t)(rtp_timestamp- m_rtpTimestampLast);
+	m_rtpTimestampLast= rtp_timestamp;
+
+	/* Map the extended time-stamp to microseconds relative to the anchor.
+	 * The anchor is (re)set on the first frame, when the stream gets
+	 * synchronized using RTCP (we move to the sender's time-line, the one
+	 * shared by all the streams of the session), and on time-line
+	 * discontinuities (e.g. sender restart).
+	 */
+	flag_rtcp_synced= rtpsrc->hasBeenSynchronizedUsingRTCP()? true: false;
+	if(m_flagPTSAnchored) {
+		pts= m_ptsAnchorUSecs+ ((m_rtpTimestampExt- m_rtpTimestampExtAnchor)*
+				1000000)/ (int64_t)frequency;
+		if(flag_rtcp_synced== m_flagRTCPSynced &&
+				llabs(pts- presentation_time_usecs)<=
+						PTS_REANCHOR_THRESHOLD_USECS)
+			return pts;
+		if(flag_rtcp_synced!= m_flagRTCPSynced)
+			LOGW("[%s/%s] Stream synchronized using RTCP\n",
+					fSubsession.mediumName(), fSubsession.codecName());
+	}
+	m_flagPTSAnchored= true;
+	m_flagRTCPSynced= flag_rtcp_synced;
+	m_rtpTimestampExtAnchor= m_rtpTimestampExt;
+	m_ptsAnchorUSecs= presentation_time_usecs;
+	return presentation_time_usecs;
+}
+
+void DummySink::receiveBufferGrow(unsigned sizeNeeded)
+{
+	unsigned size_new;
+	u_int8_t *receiveBuffer;
+	LOG_CTX_INIT(m_log_ctx);
+
+	if(fReceiveBufferSize>= fReceiveBufferSizeMax)
+		return;
+
+	size_new= (fReceiveBufferSize< fReceiveBufferSizeMax/ 2)?
+			fReceiveBufferSize* 2: fReceiveBufferSizeMax;
+	if(size_new< sizeNeeded)
+		size_new= (sizeNeeded< fReceiveBufferSizeMax)? sizeNeeded:
+				fReceiveBufferSizeMax;
+
+	receiveBuffer= new (std::nothrow) u_int8_t[size_new];
+	CHECK_DO(receiveBuffer!= NULL, return);
+	delete[] fReceiveBuffer;
+	fReceiveBuffer= receiveBuffer;
+	fReceiveBufferSize= size_new;
+	LOGW("[%s/%s] Receive buffer size increased to %u bytes\n",
+			fSubsession.mediumName(), fSubsession.codecName(), size_new);
+}
+
 Boolean DummySink::continuePlaying()
 {
 	if(fSource== NULL)
@@ -3146,8 +6268,8 @@ Boolean DummySink::continuePlaying()
 	/* Request the next frame of data from our input source.
 	 * "afterGettingFrame()" will get called later, when it arrives.
 	 */
-	fSource->getNextFrame(fReceiveBuffer, SINK_BUFFER_SIZE, afterGettingFrame,
-			this, onSourceClosure, this);
+	fSource->getNextFrame(fReceiveBuffer, fReceiveBufferSize,
+			afterGettingFrame, this, onSourceClosure, this);
 	return True;
 }
 
@@ -3171,7 +6293,8 @@ void live555_rtsp_reset_on_new_settings(proc_ctx_t *proc_ctx,
      * - Signal processing to end;
      * - Unlock i/o FIFOs;
      * - Lock i/o critical section (to make FIFOs unreachable);
-     * - Join the thread.
+     * - Join the thread (if any; the de-multiplexer has no processing
+     * thread as it is served by the event-loop thread).
      * IMPORTANT: *do not* set a jump here (return or goto)
      */
 	proc_ctx->flag_exit= 1;
@@ -3180,15 +6303,17 @@ void live555_rtsp_reset_on_new_settings(proc_ctx_t *proc_ctx,
 	fair_lock(proc_ctx->fair_lock_io_array[PROC_IPUT]);
 	fair_lock(proc_ctx->fair_lock_io_array[PROC_OPUT]);
 	flag_io_locked= 1;
-	//LOGV("Waiting thread to join... "); // comment-me
-	pthread_join(proc_ctx->proc_thread, &thread_end_code);
-	if(thread_end_code!= NULL) {
-		ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
-		free(thread_end_code);
-		thread_end_code= NULL;
+	if(proc_ctx->proc_if->process_frame!= NULL) {
+		//LOGV("Waiting thread to join... "); // comment-me
+		pthread_join(proc_ctx->proc_thread, &thread_end_code);
+		if(thread_end_code!= NULL) {
+			ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
+			free(thread_end_code);
+			thread_end_code= NULL;
+		}
+		//LOGV("joined O.K.\n"); // comment-me
+		flag_thr_joined= 1;
 	}
-	//LOGV("joined O.K.\n"); // comment-me
-	flag_thr_joined= 1;
 
 	/* Empty i/o FIFOs */
 	fifo_empty(proc_ctx->fifo_ctx_array[PROC_IPUT]);
@@ -3207,8 +6332,8 @@ end:
 	fifo_set_blocking_mode(proc_ctx->fifo_ctx_array[PROC_OPUT], 1);
 
 	/* Re-launch PROC thread if applicable */
+	proc_ctx->flag_exit= 0;
 	if(flag_thr_joined!= 0) {
-		proc_ctx->flag_exit= 0;
 		ret_code= pthread_create(&proc_ctx->proc_thread, NULL,
 				(void*(*)(void*))proc_ctx->start_routine, proc_ctx);
 		CHECK_DO(ret_code== 0, goto end);
@@ -3225,15 +6350,14 @@ end:
 void live555_rtsp_reset_on_new_settings_es_mux(proc_ctx_t *proc_ctx,
 		log_ctx_t *log_ctx)
 {
-	char *sdp_mimetype;
     int i, ret_code, procs_num= 0;
     live555_rtsp_mux_ctx_t *live555_rtsp_mux_ctx= NULL; // Do not release
 	volatile live555_rtsp_mux_settings_ctx_t *live555_rtsp_mux_settings_ctx=
 			NULL; // Do not release
 	volatile muxers_settings_mux_ctx_t *muxers_settings_mux_ctx=
 			NULL; // Do not release
-    cJSON *cjson_es_array= NULL, *cjson_aux= NULL;
-    char *rest_str= NULL;
+    cJSON *cjson_es_array= NULL;
+    char *rest_str= NULL, *settings_str= NULL;
     LOG_CTX_INIT(log_ctx);
 
     /* Check arguments */
@@ -3265,30 +6389,34 @@ void live555_rtsp_reset_on_new_settings_es_mux(proc_ctx_t *proc_ctx,
 			LOG_CTX_GET());
 	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
 
-	/* Register ES's again */
+	/* Register ES's again (with their whole JSON representation as
+	 * settings, so ES specific settings are kept; read-only members are
+	 * ignored).
+	 */
 	procs_num= cJSON_GetArraySize(cjson_es_array);
 	for(i= 0; i< procs_num; i++) {
-		char settings_str[128]= {0};
 		cJSON *cjson_proc= cJSON_GetArrayItem(cjson_es_array, i);
 		CHECK_DO(cjson_proc!= NULL, continue);
 
-		cjson_aux= cJSON_GetObjectItem(cjson_proc, "sdp_mimetype");
-		CHECK_DO(cjson_aux!= NULL, continue);
-		sdp_mimetype= cjson_aux->valuestring;
-
 		/* Register ES */
 		if(rest_str!= NULL) {
 			free(rest_str);
 			rest_str= NULL;
 		}
-		snprintf(settings_str, sizeof(settings_str), "sdp_mimetype=%s",
-				sdp_mimetype);
+		if(settings_str!= NULL) {
+			free(settings_str);
+			settings_str= NULL;
+		}
+		settings_str= CJSON_PRINT(cjson_proc);
+		CHECK_DO(settings_str!= NULL, continue);
 		ret_code= procs_opt(
 				((proc_muxer_mux_ctx_t*)live555_rtsp_mux_ctx)->
 				procs_ctx_es_muxers, "PROCS_POST",
 				"live555_rtsp_es_mux", settings_str, &rest_str,
 				live555_rtsp_mux_ctx->usageEnvironment,
-				live555_rtsp_mux_ctx->serverMediaSession);
+				live555_rtsp_mux_ctx->serverMediaSession,
+				live555_rtsp_mux_ctx->live555_event_loop,
+				&live555_rtsp_mux_ctx->live555_rtsp_mux_settings_ctx);
 		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL, continue);
 	}
 
@@ -3297,6 +6425,8 @@ end:
 		cJSON_Delete(cjson_es_array);
 	if(rest_str!= NULL)
 		free(rest_str);
+	if(settings_str!= NULL)
+		free(settings_str);
 	return;
 }
 
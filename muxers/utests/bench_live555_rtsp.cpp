@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_live555_rtsp.cpp
+ * @brief RTSP/RTP loopback scale benchmark.
+ * Starts one RTSP multiplexer fed by a synthetic stream and ramps up the
+ * number of RTSP de-multiplexer clients connected over the loopback
+ * interface (1, 2, 4, ... up to the given maximum). For each step, one JSON
+ * line is printed with the aggregate received frames, packets and bit-rate
+ * per second, the CPU usage per stream, the frame latency percentiles (all
+ * clients, and 99th percentile of each client) and the frame loss.
+ * Each synthetic frame carries a sequence number and the (monotonic) time it
+ * was sent, so latency and loss are measured at the receiver side.
+ * Usage:
+ * mediaprocsmuxers_bench [-n max_clients] [-d step_secs] [-r fps]
+ * [-b frame_bytes] [-p rtsp_port]
+ * @author Rafael Antoniello
+ */
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <libcjson/cJSON.h>
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/bench_stats.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/procs.h>
+#include <libmediaprocsmuxers/live555_rtsp.h>
+}
+
+/* **** Definitions **** */
+
+#define BENCH_CLIENTS_MAX_DEFAULT 64
+#define BENCH_STEP_SECS_DEFAULT 5
+#define BENCH_FPS_DEFAULT 30
+#define BENCH_FRAME_BYTES_DEFAULT 16384
+#define BENCH_RTSP_PORT_DEFAULT 8654
+
+/**
+ * Time given to newly added clients to connect and start receiving before
+ * measuring a step.
+ */
+#define BENCH_WARMUP_USECS (2* 1000000)
+
+/**
+ * Maximum RTP payload size used by the Live555's RTP sinks (default
+ * maximum packet size minus the RTP header); used to estimate the number of
+ * RTP packets per frame.
+ */
+#define BENCH_RTP_PAYLOAD_SIZE (1456- 12)
+
+/**
+ * Latency samples kept per client (see 'bench_stats_open()').
+ */
+#define BENCH_LATENCY_SAMPLES_MAX 16384
+
+#define BENCH_FRAME_MAGIC 0x4D505242 // "MPRB"
+
+/**
+ * Header stamped at the beginning of each synthetic frame.
+ */
+typedef struct bench_frame_hdr_s {
+	uint32_t magic;
+	uint32_t seq;
+	int64_t send_usecs;
+} bench_frame_hdr_t;
+
+/**
+ * Benchmark RTSP client (de-multiplexer) context structure.
+ */
+typedef struct bench_client_ctx_s {
+	procs_ctx_t *procs_ctx;
+	int dmux_proc_id;
+	pthread_t thread;
+	volatile int flag_exit;
+	/**
+	 * Measures of the current step (reset at the beginning of each step).
+	 */
+	bench_stats_ctx_t *latency_stats;
+	volatile uint64_t frames;
+	volatile uint64_t bytes;
+	volatile uint64_t lost;
+	/**
+	 * Last received sequence number (only used by the client thread).
+	 */
+	uint32_t seq_last;
+	int flag_seq_valid;
+} bench_client_ctx_t;
+
+/**
+ * Benchmark producer (multiplexer input) context structure.
+ */
+typedef struct bench_producer_ctx_s {
+	procs_ctx_t *procs_ctx;
+	int mux_proc_id;
+	int es_id;
+	int fps;
+	size_t frame_bytes;
+	pthread_t thread;
+	volatile int flag_exit;
+	volatile uint64_t frames_sent;
+} bench_producer_ctx_t;
+
+/* **** Implementations **** */
+
+static void* bench_producer_thr(void *t)
+{
+	int ret_code;
+	int64_t next_usecs, now_usecs, period_usecs;
+	uint8_t *data= NULL;
+	bench_frame_hdr_t bench_frame_hdr;
+	proc_frame_ctx_t proc_frame_ctx;
+	struct timeval tv;
+	bench_producer_ctx_t *bench_producer_ctx= (bench_producer_ctx_t*)t;
+
+	schedule_set_thread_name("bench-producer");
+
+	data= (uint8_t*)calloc(1, bench_producer_ctx->frame_bytes);
+	if(data== NULL)
+		return NULL;
+	for(size_t i= sizeof(bench_frame_hdr_t);
+			i< bench_producer_ctx->frame_bytes; i++)
+		data[i]= (uint8_t)i;
+
+	memset(&proc_frame_ctx, 0, sizeof(proc_frame_ctx));
+	proc_frame_ctx.data= data;
+	proc_frame_ctx.p_data[0]= data;
+	proc_frame_ctx.linesize[0]= bench_producer_ctx->frame_bytes;
+	proc_frame_ctx.width[0]= bench_producer_ctx->frame_bytes;
+	proc_frame_ctx.height[0]= 1; // "1D" data
+	proc_frame_ctx.es_id= bench_producer_ctx->es_id;
+
+	bench_frame_hdr.magic= BENCH_FRAME_MAGIC;
+	bench_frame_hdr.seq= 0;
+	period_usecs= 1000000/ bench_producer_ctx->fps;
+	next_usecs= bench_now_usecs();
+	while(bench_producer_ctx->flag_exit== 0) {
+		/* Stamp frame */
+		bench_frame_hdr.send_usecs= bench_now_usecs();
+		memcpy(data, &bench_frame_hdr, sizeof(bench_frame_hdr));
+		gettimeofday(&tv, NULL);
+		proc_frame_ctx.pts= (int64_t)tv.tv_sec* 1000000+ tv.tv_usec;
+
+		ret_code= procs_send_frame(bench_producer_ctx->procs_ctx,
+				bench_producer_ctx->mux_proc_id, &proc_frame_ctx);
+		if(ret_code== STAT_SUCCESS) {
+			bench_frame_hdr.seq++;
+			__atomic_add_fetch(&bench_producer_ctx->frames_sent, 1,
+					__ATOMIC_RELAXED);
+		}
+
+		/* Pace at the given frame rate (absolute schedule) */
+		next_usecs+= period_usecs;
+		now_usecs= bench_now_usecs();
+		if(next_usecs> now_usecs)
+			usleep((useconds_t)(next_usecs- now_usecs));
+		else
+			next_usecs= now_usecs;
+	}
+
+	free(data);
+	return NULL;
+}
+
+static void* bench_client_thr(void *t)
+{
+	int ret_code;
+	bench_frame_hdr_t bench_frame_hdr;
+	proc_frame_ctx_t *proc_frame_ctx= NULL;
+	bench_client_ctx_t *bench_client_ctx= (bench_client_ctx_t*)t;
+
+	schedule_set_thread_name("bench-client");
+
+	while(bench_client_ctx->flag_exit== 0) {
+		ret_code= procs_recv_frame(bench_client_ctx->procs_ctx,
+				bench_client_ctx->dmux_proc_id, &proc_frame_ctx);
+		if(ret_code!= STAT_SUCCESS || proc_frame_ctx== NULL) {
+			schedule(); // Avoid closed loops
+			continue;
+		}
+
+		if(proc_frame_ctx->width[0]>= sizeof(bench_frame_hdr_t)) {
+			memcpy(&bench_frame_hdr, proc_frame_ctx->p_data[0],
+					sizeof(bench_frame_hdr));
+			if(bench_frame_hdr.magic== BENCH_FRAME_MAGIC) {
+				bench_stats_add(bench_client_ctx->latency_stats,
+						bench_now_usecs()- bench_frame_hdr.send_usecs);
+				if(bench_client_ctx->flag_seq_valid &&
+						bench_frame_hdr.seq> bench_client_ctx->seq_last+ 1)
+					__atomic_add_fetch(&bench_client_ctx->lost,
+							bench_frame_hdr.seq- bench_client_ctx->seq_last-
+							1, __ATOMIC_RELAXED);
+				bench_client_ctx->seq_last= bench_frame_hdr.seq;
+				bench_client_ctx->flag_seq_valid= 1;
+			}
+		}
+		__atomic_add_fetch(&bench_client_ctx->frames, 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&bench_client_ctx->bytes, proc_frame_ctx->width[0],
+				__ATOMIC_RELAXED);
+		proc_frame_ctx_release(&proc_frame_ctx);
+	}
+	proc_frame_ctx_release(&proc_frame_ctx);
+	return NULL;
+}
+
+static bench_client_ctx_t* bench_client_open(procs_ctx_t *procs_ctx,
+		int rtsp_port)
+{
+	int ret_code, end_code= STAT_ERROR;
+	char settings_str[128];
+	bench_client_ctx_t *bench_client_ctx= NULL;
+
+	bench_client_ctx= (bench_client_ctx_t*)calloc(1,
+			sizeof(bench_client_ctx_t));
+	if(bench_client_ctx== NULL)
+		return NULL;
+	bench_client_ctx->procs_ctx= procs_ctx;
+	bench_client_ctx->dmux_proc_id= -1;
+
+	bench_client_ctx->latency_stats= bench_stats_open(
+			BENCH_LATENCY_SAMPLES_MAX);
+	if(bench_client_ctx->latency_stats== NULL)
+		goto end;
+
+	snprintf(settings_str, sizeof(settings_str),
+			"rtsp_url=rtsp://127.0.0.1:%d/session", rtsp_port);
+	ret_code= procs_opt(procs_ctx, "PROCS_POST_ID", "live555_rtsp_dmux",
+			settings_str, &bench_client_ctx->dmux_proc_id);
+	if(ret_code!= STAT_SUCCESS)
+		goto end;
+
+	ret_code= pthread_create(&bench_client_ctx->thread, NULL,
+			bench_client_thr, bench_client_ctx);
+	if(ret_code!= 0) {
+		procs_opt(procs_ctx, "PROCS_ID_DELETE",
+				bench_client_ctx->dmux_proc_id);
+		goto end;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS) {
+		bench_stats_close(&bench_client_ctx->latency_stats);
+		free(bench_client_ctx);
+		bench_client_ctx= NULL;
+	}
+	return bench_client_ctx;
+}
+
+static void bench_client_close(bench_client_ctx_t **ref_bench_client_ctx)
+{
+	bench_client_ctx_t *bench_client_ctx= NULL;
+
+	if(ref_bench_client_ctx== NULL ||
+			(bench_client_ctx= *ref_bench_client_ctx)== NULL)
+		return;
+
+	/* Deleting the de-multiplexer unblocks the client thread */
+	bench_client_ctx->flag_exit= 1;
+	procs_opt(bench_client_ctx->procs_ctx, "PROCS_ID_DELETE",
+			bench_client_ctx->dmux_proc_id);
+	pthread_join(bench_client_ctx->thread, NULL);
+
+	bench_stats_close(&bench_client_ctx->latency_stats);
+	free(bench_client_ctx);
+	*ref_bench_client_ctx= NULL;
+}
+
+static void bench_client_step_reset(bench_client_ctx_t *bench_client_ctx)
+{
+	bench_stats_reset(bench_client_ctx->latency_stats);
+	__atomic_store_n(&bench_client_ctx->frames, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&bench_client_ctx->bytes, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&bench_client_ctx->lost, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Measure one step: reset the clients measures, wait for the step duration
+ * and print the results as a JSON line.
+ */
+static void bench_step(bench_client_ctx_t **bench_client_ctx_array,
+		int clients_num, bench_producer_ctx_t *bench_producer_ctx,
+		int step_secs)
+{
+	int i;
+	int64_t t0_usecs, t1_usecs, cpu0_usecs, cpu1_usecs;
+	uint64_t frames= 0, bytes= 0, lost= 0, frames_sent;
+	double secs, packets_per_frame;
+	bench_stats_summary_t bench_stats_summary;
+	bench_stats_ctx_t *latency_stats= NULL;
+
+	latency_stats= bench_stats_open(BENCH_LATENCY_SAMPLES_MAX* 4);
+	if(latency_stats== NULL)
+		return;
+
+	for(i= 0; i< clients_num; i++)
+		bench_client_step_reset(bench_client_ctx_array[i]);
+	frames_sent= __atomic_load_n(&bench_producer_ctx->frames_sent,
+			__ATOMIC_RELAXED);
+	t0_usecs= bench_now_usecs();
+	cpu0_usecs= bench_cpu_usecs();
+
+	sleep(step_secs);
+
+	t1_usecs= bench_now_usecs();
+	cpu1_usecs= bench_cpu_usecs();
+	frames_sent= __atomic_load_n(&bench_producer_ctx->frames_sent,
+			__ATOMIC_RELAXED)- frames_sent;
+	secs= (double)(t1_usecs- t0_usecs)/ 1000000.0;
+
+	printf("{\"clients\":%d,\"frames_sent_per_sec\":%.1f,", clients_num,
+			(double)frames_sent/ secs);
+	printf("\"clients_p99_latency_usecs\":[");
+	for(i= 0; i< clients_num; i++) {
+		bench_client_ctx_t *bench_client_ctx= bench_client_ctx_array[i];
+		frames+= __atomic_load_n(&bench_client_ctx->frames, __ATOMIC_RELAXED);
+		bytes+= __atomic_load_n(&bench_client_ctx->bytes, __ATOMIC_RELAXED);
+		lost+= __atomic_load_n(&bench_client_ctx->lost, __ATOMIC_RELAXED);
+		printf("%s%" PRId64, i> 0? ",": "", bench_stats_percentile(
+				bench_client_ctx->latency_stats, 99));
+		bench_stats_merge(latency_stats, bench_client_ctx->latency_stats);
+	}
+	bench_stats_summary_get(latency_stats, &bench_stats_summary);
+	packets_per_frame= (double)((bench_producer_ctx->frame_bytes+
+			BENCH_RTP_PAYLOAD_SIZE- 1)/ BENCH_RTP_PAYLOAD_SIZE);
+
+	printf("],\"frames_per_sec\":%.1f,\"packets_per_sec_est\":%.1f,"
+			"\"mbps\":%.2f,", (double)frames/ secs,
+			(double)frames* packets_per_frame/ secs,
+			(double)bytes* 8/ secs/ 1000000.0);
+	printf("\"cpu_percent_per_stream\":%.2f,",
+			(double)(cpu1_usecs- cpu0_usecs)* 100.0/
+			(double)(t1_usecs- t0_usecs)/ clients_num);
+	printf("\"latency_usecs\":{\"p50\":%" PRId64 ",\"p90\":%" PRId64
+			",\"p99\":%" PRId64 ",\"max\":%" PRId64 "},",
+			bench_stats_summary.p50, bench_stats_summary.p90,
+			bench_stats_summary.p99, bench_stats_summary.max);
+	printf("\"loss_percent\":%.3f,\"threads\":%d,\"rss_kbytes\":%ld}\n",
+			(frames+ lost)> 0? (double)lost* 100.0/ (double)(frames+ lost): 0,
+			bench_threads_num(), bench_rss_kbytes());
+	fflush(stdout);
+
+	bench_stats_close(&latency_stats);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, ret_code, i, end_code= EXIT_FAILURE, clients_num= 0, step;
+	int clients_max= BENCH_CLIENTS_MAX_DEFAULT;
+	int step_secs= BENCH_STEP_SECS_DEFAULT;
+	int rtsp_port= BENCH_RTSP_PORT_DEFAULT;
+	char settings_str[128];
+	char *rest_str= NULL;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+	procs_ctx_t *procs_ctx= NULL;
+	bench_client_ctx_t **bench_client_ctx_array= NULL;
+	bench_producer_ctx_t bench_producer_ctx;
+	int flag_producer_started= 0;
+
+	memset(&bench_producer_ctx, 0, sizeof(bench_producer_ctx));
+	bench_producer_ctx.mux_proc_id= -1;
+	bench_producer_ctx.fps= BENCH_FPS_DEFAULT;
+	bench_producer_ctx.frame_bytes= BENCH_FRAME_BYTES_DEFAULT;
+
+	while((opt= getopt(argc, argv, "n:d:r:b:p:"))!= -1) {
+		switch(opt) {
+		case 'n': clients_max= atoi(optarg); break;
+		case 'd': step_secs= atoi(optarg); break;
+		case 'r': bench_producer_ctx.fps= atoi(optarg); break;
+		case 'b': bench_producer_ctx.frame_bytes= (size_t)atoi(optarg); break;
+		case 'p': rtsp_port= atoi(optarg); break;
+		default:
+			fprintf(stderr, "Usage: %s [-n max_clients] [-d step_secs] "
+					"[-r fps] [-b frame_bytes] [-p rtsp_port]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(clients_max< 1 || step_secs< 1 || bench_producer_ctx.fps< 1 ||
+			bench_producer_ctx.frame_bytes< sizeof(bench_frame_hdr_t)) {
+		fprintf(stderr, "Invalid arguments\n");
+		return EXIT_FAILURE;
+	}
+
+	bench_client_ctx_array= (bench_client_ctx_t**)calloc(clients_max,
+			sizeof(bench_client_ctx_t*));
+	if(bench_client_ctx_array== NULL)
+		return EXIT_FAILURE;
+
+	/* Open LOG and PROCS modules; register RTSP processor types */
+	if(log_module_open()!= STAT_SUCCESS || procs_module_open(NULL)!=
+			STAT_SUCCESS)
+		goto end;
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_live555_rtsp_mux)!=
+			STAT_SUCCESS || procs_module_opt("PROCS_REGISTER_TYPE",
+					&proc_if_live555_rtsp_dmux)!= STAT_SUCCESS)
+		goto end;
+	procs_ctx= procs_open(NULL, clients_max+ 16, NULL, NULL);
+	if(procs_ctx== NULL)
+		goto end;
+
+	/* Multiplexer and its elementary stream */
+	snprintf(settings_str, sizeof(settings_str), "rtsp_port=%d", rtsp_port);
+	ret_code= procs_opt(procs_ctx, "PROCS_POST_ID", "live555_rtsp_mux",
+			settings_str, &bench_producer_ctx.mux_proc_id);
+	if(ret_code!= STAT_SUCCESS) {
+		fprintf(stderr, "Could not open RTSP multiplexer (port %d)\n",
+				rtsp_port);
+		goto end;
+	}
+	ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER",
+			bench_producer_ctx.mux_proc_id,
+			"sdp_mimetype=application/bench-data", &rest_str);
+	if(ret_code!= STAT_SUCCESS || rest_str== NULL ||
+			(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+			(cjson_aux= cJSON_GetObjectItem(cjson_rest,
+					"elementary_stream_id"))== NULL)
+		goto end;
+	bench_producer_ctx.es_id= (int)cjson_aux->valuedouble;
+
+	/* Start producer */
+	bench_producer_ctx.procs_ctx= procs_ctx;
+	if(pthread_create(&bench_producer_ctx.thread, NULL, bench_producer_thr,
+			&bench_producer_ctx)!= 0)
+		goto end;
+	flag_producer_started= 1;
+
+	/* Ramp up clients */
+	for(step= 1; clients_num< clients_max; step*= 2) {
+		int clients_num_step= (step< clients_max)? step: clients_max;
+
+		while(clients_num< clients_num_step) {
+			bench_client_ctx_array[clients_num]= bench_client_open(procs_ctx,
+					rtsp_port);
+			if(bench_client_ctx_array[clients_num]== NULL) {
+				fprintf(stderr, "Could not open RTSP client #%d\n",
+						clients_num);
+				goto end;
+			}
+			clients_num++;
+		}
+		usleep(BENCH_WARMUP_USECS);
+		bench_step(bench_client_ctx_array, clients_num, &bench_producer_ctx,
+				step_secs);
+	}
+
+	end_code= EXIT_SUCCESS;
+end:
+	for(i= 0; i< clients_num; i++)
+		bench_client_close(&bench_client_ctx_array[i]);
+	if(flag_producer_started) {
+		bench_producer_ctx.flag_exit= 1;
+		pthread_join(bench_producer_ctx.thread, NULL);
+	}
+	if(procs_ctx!= NULL) {
+		if(bench_producer_ctx.mux_proc_id>= 0)
+			procs_opt(procs_ctx, "PROCS_ID_DELETE",
+					bench_producer_ctx.mux_proc_id);
+		procs_close(&procs_ctx);
+	}
+	procs_module_close();
+	log_module_close();
+	if(rest_str!= NULL)
+		free(rest_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	free(bench_client_ctx_array);
+	return end_code;
+}
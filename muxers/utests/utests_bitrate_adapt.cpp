@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file utests_bitrate_adapt.cpp
+ * @brief Encoder bit-rate adaptation law unit-testing.
+ * @author Rafael Antoniello
+ */
+
+#include <UnitTest++/UnitTest++.h>
+
+extern "C" {
+#include <libmediaprocsmuxers/bitrate_adapt.h>
+}
+
+SUITE(UTESTS_BITRATE_ADAPT)
+{
+#define BITRATE_MIN 100000
+#define BITRATE_MAX 2000000
+#define LOSS_HIGH 5
+#define LOSS_LOW 1
+#define AIMD(BITRATE, LOSS) bitrate_adapt_aimd(BITRATE, BITRATE_MIN, \
+		BITRATE_MAX, LOSS_HIGH, LOSS_LOW, LOSS, &clear_reports)
+
+	TEST(UTESTS_BITRATE_ADAPT_DECREASE)
+	{
+		int clear_reports= 2;
+
+		/* Multiplicative decrease on each congested report, at once */
+		CHECK(AIMD(1000000, LOSS_HIGH)== 1000000*
+				BITRATE_ADAPT_DECREASE_PERCENT/ 100);
+		CHECK(clear_reports== 0);
+		CHECK(AIMD(1000000, 50.0)== 1000000*
+				BITRATE_ADAPT_DECREASE_PERCENT/ 100);
+
+		/* Bounded to the minimum */
+		CHECK(AIMD(BITRATE_MIN+ 1000, 50.0)== BITRATE_MIN);
+		CHECK(AIMD(BITRATE_MIN, 50.0)== BITRATE_MIN);
+	}
+
+	TEST(UTESTS_BITRATE_ADAPT_INCREASE)
+	{
+		int i, clear_reports= 0;
+		unsigned int bitrate= 1000000;
+
+		/* Additive increase only after consecutive clear reports */
+		for(i= 1; i< BITRATE_ADAPT_INCREASE_REPORTS; i++) {
+			CHECK(AIMD(bitrate, 0)== bitrate);
+			CHECK(clear_reports== i);
+		}
+		CHECK(AIMD(bitrate, LOSS_LOW)== bitrate+ BITRATE_MAX*
+				BITRATE_ADAPT_INCREASE_PERCENT/ 100);
+		CHECK(clear_reports== 0);
+
+		/* A report between thresholds holds the bit-rate and restarts the
+		 * clear reports count.
+		 */
+		clear_reports= BITRATE_ADAPT_INCREASE_REPORTS- 1;
+		CHECK(AIMD(bitrate, (LOSS_HIGH+ LOSS_LOW)/ 2.0)== bitrate);
+		CHECK(clear_reports== 0);
+	}
+
+	TEST(UTESTS_BITRATE_ADAPT_MAX)
+	{
+		int i, clear_reports= 0;
+		unsigned int bitrate= BITRATE_MAX- 1000;
+
+		/* Increase is capped at the maximum */
+		for(i= 0; i< BITRATE_ADAPT_INCREASE_REPORTS; i++)
+			bitrate= AIMD(bitrate, 0);
+		CHECK(bitrate== BITRATE_MAX);
+		for(i= 0; i< BITRATE_ADAPT_INCREASE_REPORTS; i++)
+			bitrate= AIMD(bitrate, 0);
+		CHECK(bitrate== BITRATE_MAX);
+
+		/* A minimum above the maximum is bounded to the maximum */
+		CHECK(bitrate_adapt_aimd(BITRATE_MAX, BITRATE_MAX* 2, BITRATE_MAX,
+				LOSS_HIGH, LOSS_LOW, 50.0, &clear_reports)== BITRATE_MAX);
+	}
+
+#undef AIMD
+#undef LOSS_LOW
+#undef LOSS_HIGH
+#undef BITRATE_MAX
+#undef BITRATE_MIN
+}
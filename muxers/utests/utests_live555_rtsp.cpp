@@ -32,6 +32,7 @@ extern "C" {
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <time.h>
 
 #include <libcjson/cJSON.h>
 #include <libmediaprocsutils/log.h>
@@ -166,6 +167,9 @@ SUITE(UTESTS_LIVE555_RTSP)
 				/* Verify size */
 				CHECK(frame_size== FRAME_SIZE);
 
+				/* Verify PTS is set (derived from RTP time-stamps) */
+				CHECK(proc_frame_ctx->pts> 0);
+
 				// { //comment-me
 				//for(i= 0; i< frame_size; i++)
 				//	printf("%d ", data_buf[i]);
@@ -449,4 +453,1159 @@ end:
 			free(rest_str);
 		return;
 	}
+
+	typedef struct pts_thr_ctx_s {
+		volatile int flag_exit;
+		int dmux_proc_id;
+		procs_ctx_t *procs_ctx;
+		int pts_num;
+		int64_t pts[128];
+	} pts_thr_ctx_t;
+
+	/**
+	 * Consumer thread registering the PTS of the de-multiplexed frames (the
+	 * de-multiplexer derives the PTS from the RTP time-stamps).
+	 */
+	static void* pts_consumer_thr(void *t)
+	{
+		int ret_code;
+		proc_frame_ctx_t *proc_frame_ctx= NULL;
+		pts_thr_ctx_t *pts_thr_ctx= (pts_thr_ctx_t*)t;
+
+		if(pts_thr_ctx== NULL) {
+			CHECK(false);
+			exit(-1);
+		}
+
+		while(pts_thr_ctx->flag_exit== 0) {
+			ret_code= procs_recv_frame(pts_thr_ctx->procs_ctx,
+					pts_thr_ctx->dmux_proc_id, &proc_frame_ctx);
+			CHECK(ret_code== STAT_SUCCESS || ret_code== STAT_EAGAIN ||
+					ret_code== STAT_ENOTFOUND || ret_code== STAT_EOF);
+			if(proc_frame_ctx== NULL) {
+				schedule(); // Avoid closed loops
+				continue;
+			}
+			if(pts_thr_ctx->pts_num< (int)(sizeof(pts_thr_ctx->pts)/
+					sizeof(pts_thr_ctx->pts[0])))
+				pts_thr_ctx->pts[pts_thr_ctx->pts_num++]= proc_frame_ctx->pts;
+			proc_frame_ctx_release(&proc_frame_ctx);
+		}
+		return NULL;
+	}
+
+	TEST(UTESTS_LIVE555_RTSP_STEADY_RTP_TIMESTAMPS)
+	{
+#define FRAME_RATE 30
+#define FRAMES_NUM 90 // 3 seconds: longer than the PTS re-anchoring threshold
+		pthread_t consumer_thread;
+		int i, ret_code, mux_proc_id= -1, dmux_proc_id= -1,
+				elem_strem_id= -1, deltas_unsteady= 0;
+		const int64_t frame_period_usec= 1000000/ FRAME_RATE;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+		proc_frame_ctx_t proc_frame_ctx= {0};
+		uint8_t data_buf[FRAME_SIZE]= {0};
+		pts_thr_ctx_t pts_thr_ctx= {0};
+
+	    /* Open LOG module */
+	    log_module_open();
+
+		/* Open processors (PROCS) module */
+		ret_code= procs_module_open(NULL);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Register multiplexer and de-multiplexer processor types */
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE",
+				&proc_if_live555_rtsp_mux);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE",
+				&proc_if_live555_rtsp_dmux);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Get PROCS module's instance */
+		procs_ctx= procs_open(NULL, 16, NULL, NULL);
+		if(procs_ctx== NULL) {
+			CHECK(false);
+			goto end;
+		}
+
+	    /* Register (open) a multiplexer instance */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8556",
+				&mux_proc_id);
+
+	    /* Register an elementary stream for the multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				"sdp_mimetype=application/step-data", &rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		if((cjson_rest= cJSON_Parse(rest_str))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		if((cjson_aux= cJSON_GetObjectItem(cjson_rest,
+				"elementary_stream_id"))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		if((elem_strem_id= cjson_aux->valuedouble)< 0) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		free(rest_str); rest_str= NULL;
+		cJSON_Delete(cjson_rest); cjson_rest= NULL;
+
+	    /* Register RTSP de-multiplexer instance and get corresponding Id. */
+		procs_post(procs_ctx, "live555_rtsp_dmux",
+				"rtsp_url=rtsp://127.0.0.1:8556/session", &dmux_proc_id);
+
+		/* Launch consumer thread */
+		pts_thr_ctx.flag_exit= 0;
+		pts_thr_ctx.procs_ctx= procs_ctx;
+		pts_thr_ctx.dmux_proc_id= dmux_proc_id;
+		ret_code= pthread_create(&consumer_thread, NULL, pts_consumer_thr,
+				&pts_thr_ctx);
+		if(ret_code!= 0) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Send frames at a steady frame rate; PTS are given in microseconds
+		 * (see 'proc_frame_ctx_s::pts').
+		 */
+		proc_frame_ctx.data= data_buf;
+		proc_frame_ctx.p_data[0]= data_buf;
+		proc_frame_ctx.linesize[0]= FRAME_SIZE;
+		proc_frame_ctx.width[0]= FRAME_SIZE;
+		proc_frame_ctx.height[0]= 1; // "1D" data
+		proc_frame_ctx.es_id= elem_strem_id;
+		for(i= 0; i< FRAMES_NUM; i++) {
+			proc_frame_ctx.pts= (i+ 1)* frame_period_usec;
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+					&proc_frame_ctx)== STAT_SUCCESS);
+			usleep((unsigned int)frame_period_usec);
+		}
+
+	    /* Join the consumer thread (delete de-multiplexer to unblock it) */
+		pts_thr_ctx.flag_exit= 1;
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", dmux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+		pthread_join(consumer_thread, NULL);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		/* The RTP time-stamps (thus, the de-multiplexed PTS) must increase
+		 * steadily by one frame period (1 millisecond tolerance). One
+		 * discontinuity is tolerated: the de-multiplexer re-anchors its
+		 * time-line when the stream gets synchronized using RTCP.
+		 */
+		CHECK(pts_thr_ctx.pts_num>= FRAMES_NUM/ 2);
+		for(i= 1; i< pts_thr_ctx.pts_num; i++) {
+			int64_t delta= pts_thr_ctx.pts[i]- pts_thr_ctx.pts[i- 1];
+			if(llabs(delta- frame_period_usec)> 1000)
+				deltas_unsteady++;
+		}
+		CHECK(deltas_unsteady<= 1);
+
+end:
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		log_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+		return;
+#undef FRAMES_NUM
+#undef FRAME_RATE
+	}
+
+	TEST(UTESTS_LIVE555_RTSP_ES_REGISTER_ETAG)
+	{
+		int ret_code, mux_proc_id= -1;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL, *etag_str= NULL, *etag2_str= NULL;
+
+	    /* Open LOG module */
+	    log_module_open();
+
+		/* Open processors (PROCS) module */
+		ret_code= procs_module_open(NULL);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Register multiplexer processor type */
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE",
+				&proc_if_live555_rtsp_mux);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Get PROCS module's instance */
+		procs_ctx= procs_open(NULL, 16, NULL, NULL);
+		if(procs_ctx== NULL) {
+			CHECK(false);
+			goto end;
+		}
+
+	    /* Register (open) a multiplexer instance */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8560",
+				&mux_proc_id);
+
+		/* Get representation (no elementary streams) and its entity-tag */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", mux_proc_id, NULL,
+				&rest_str, &etag_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL || etag_str== NULL) {
+			CHECK(false);
+			goto end;
+		}
+		free(rest_str); rest_str= NULL;
+
+		/* Registering an elementary stream (no PUT) changes the
+		 * representation: the entity-tag must change.
+		 */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				"sdp_mimetype=video/mp2v", &rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL) {
+			CHECK(false);
+			goto end;
+		}
+		free(rest_str); rest_str= NULL;
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", mux_proc_id,
+				etag_str, &rest_str, &etag2_str);
+		CHECK(ret_code== STAT_SUCCESS && rest_str!= NULL);
+		CHECK(etag2_str!= NULL && strcmp(etag_str, etag2_str)!= 0);
+		CHECK(rest_str!= NULL && strstr(rest_str, "video/mp2v")!= NULL);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+		/* Not modified any more */
+		free(etag_str); etag_str= etag2_str;
+		etag2_str= NULL;
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", mux_proc_id,
+				etag_str, &rest_str, &etag2_str);
+		CHECK(ret_code== STAT_NOTMODIFIED && rest_str== NULL);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+
+end:
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		log_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+		if(etag_str!= NULL)
+			free(etag_str);
+		if(etag2_str!= NULL)
+			free(etag2_str);
+		return;
+	}
+
+	/**
+	 * Get the GOP cache status of the given multiplexer elementary stream
+	 * from the multiplexer statistics; wait (up to one second) for the cache
+	 * to hold the expected number of frames, as frames are multiplexed
+	 * asynchronously.
+	 */
+	static void gop_cache_stats_wait(procs_ctx_t *procs_ctx, int mux_proc_id,
+			int elem_stream_id, int frames_expected, int *ref_frames,
+			int *ref_bytes, int *ref_overflows)
+	{
+		int i, j;
+
+		for(i= 0; i< 100; i++) {
+			char *rest_str= NULL;
+			cJSON *cjson_rest= NULL, *cjson_es_array= NULL,
+					*cjson_aux= NULL;
+
+			if(procs_opt(procs_ctx, "PROCS_ID_STATS_GET", mux_proc_id,
+					&rest_str)!= STAT_SUCCESS || rest_str== NULL ||
+					(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+					(cjson_es_array= cJSON_GetObjectItem(cjson_rest,
+							"elementary_streams"))== NULL) {
+				CHECK(false);
+				exit(-1);
+			}
+			for(j= 0; j< cJSON_GetArraySize(cjson_es_array); j++) {
+				cJSON *cjson_es= cJSON_GetArrayItem(cjson_es_array, j);
+				cjson_aux= cJSON_GetObjectItem(cjson_es,
+						"elementary_stream_id");
+				if(cjson_aux== NULL || cjson_aux->valueint!= elem_stream_id)
+					continue;
+				if((cjson_aux= cJSON_GetObjectItem(cjson_es,
+						"gop_cache_frames"))!= NULL)
+					*ref_frames= cjson_aux->valueint;
+				if((cjson_aux= cJSON_GetObjectItem(cjson_es,
+						"gop_cache_bytes"))!= NULL)
+					*ref_bytes= cjson_aux->valueint;
+				if((cjson_aux= cJSON_GetObjectItem(cjson_es,
+						"gop_cache_overflows"))!= NULL)
+					*ref_overflows= cjson_aux->valueint;
+			}
+			free(rest_str);
+			cJSON_Delete(cjson_rest);
+			if(*ref_frames== frames_expected)
+				return;
+			usleep(1000*10);
+		}
+	}
+
+	TEST(UTESTS_LIVE555_RTSP_GOP_CACHE)
+	{
+#define GOP_FRAME_SIZE 1000
+		int i, ret_code, mux_proc_id= -1, elem_strem_id= -1, frames= -1,
+				bytes= -1, overflows= -1;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+		proc_frame_ctx_t proc_frame_ctx_i= {0}, proc_frame_ctx_p= {0};
+		uint8_t data_buf_i[GOP_FRAME_SIZE]= {0}, data_buf_p[GOP_FRAME_SIZE]= {0};
+
+	    /* Open LOG module */
+	    log_module_open();
+
+		/* Open processors (PROCS) module */
+		ret_code= procs_module_open(NULL);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Register multiplexer processor type */
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE",
+				&proc_if_live555_rtsp_mux);
+		if(ret_code!= STAT_SUCCESS) {
+			CHECK(false);
+			goto end;
+		}
+
+		/* Get PROCS module's instance */
+		procs_ctx= procs_open(NULL, 16, NULL, NULL);
+		if(procs_ctx== NULL) {
+			CHECK(false);
+			goto end;
+		}
+
+	    /* Register (open) a multiplexer instance */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8555",
+				&mux_proc_id);
+
+	    /* Register a MPEG-2 video elementary stream with a small GOP cache
+	     * (four frames at most)
+	     */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				"sdp_mimetype=video/mp2v&gop_cache_max_bytes=4096", &rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		if((cjson_rest= cJSON_Parse(rest_str))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		if((cjson_aux= cJSON_GetObjectItem(cjson_rest,
+				"elementary_stream_id"))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		if((elem_strem_id= cjson_aux->valuedouble)< 0) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		free(rest_str); rest_str= NULL;
+		cJSON_Delete(cjson_rest); cjson_rest= NULL;
+
+		/* Prepare frames: intra-coded (sequence header) and predicted
+		 * (picture header with coding type 2) MPEG-2 video pictures.
+		 */
+		data_buf_i[2]= 0x01; data_buf_i[3]= 0xB3;
+		data_buf_p[2]= 0x01; data_buf_p[3]= 0x00; data_buf_p[5]= (2<< 3);
+		proc_frame_ctx_i.data= data_buf_i;
+		proc_frame_ctx_i.p_data[0]= data_buf_i;
+		proc_frame_ctx_i.linesize[0]= GOP_FRAME_SIZE;
+		proc_frame_ctx_i.width[0]= GOP_FRAME_SIZE;
+		proc_frame_ctx_i.height[0]= 1; // "1D" data
+		proc_frame_ctx_i.es_id= elem_strem_id;
+		proc_frame_ctx_p= proc_frame_ctx_i;
+		proc_frame_ctx_p.data= data_buf_p;
+		proc_frame_ctx_p.p_data[0]= data_buf_p;
+
+		/* Frames before the first key-frame are not cached */
+		CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+				&proc_frame_ctx_p)== STAT_SUCCESS);
+
+		/* I-P-P: whole GOP is cached */
+		CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+				&proc_frame_ctx_i)== STAT_SUCCESS);
+		for(i= 0; i< 2; i++)
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+					&proc_frame_ctx_p)== STAT_SUCCESS);
+		gop_cache_stats_wait(procs_ctx, mux_proc_id, elem_strem_id, 3,
+				&frames, &bytes, &overflows);
+		CHECK(frames== 3 && bytes== 3* GOP_FRAME_SIZE && overflows== 0);
+
+		/* A new key-frame restarts the cache */
+		CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+				&proc_frame_ctx_i)== STAT_SUCCESS);
+		gop_cache_stats_wait(procs_ctx, mux_proc_id, elem_strem_id, 1,
+				&frames, &bytes, &overflows);
+		CHECK(frames== 1 && bytes== GOP_FRAME_SIZE && overflows== 0);
+
+		/* Exceeding the maximum size drops the cache until next key-frame */
+		for(i= 0; i< 4; i++)
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+					&proc_frame_ctx_p)== STAT_SUCCESS);
+		gop_cache_stats_wait(procs_ctx, mux_proc_id, elem_strem_id, 0,
+				&frames, &bytes, &overflows);
+		CHECK(frames== 0 && bytes== 0 && overflows== 1);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+
+end:
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		log_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+		return;
+#undef GOP_FRAME_SIZE
+	}
+
+	/**
+	 * Get a numeric value of the given multiplexer elementary stream
+	 * representational state ('get_tag' "PROCS_ID_GET") or statistics
+	 * ('get_tag' "PROCS_ID_STATS_GET"); -1 is returned if not found.
+	 */
+	static double es_mux_number_get_by_tag(procs_ctx_t *procs_ctx,
+			const char *get_tag, int mux_proc_id, int elem_stream_id,
+			const char *key)
+	{
+		int j;
+		double value= -1;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_es_array= NULL, *cjson_aux= NULL;
+
+		if(procs_opt(procs_ctx, get_tag, mux_proc_id, &rest_str)!=
+				STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+				(cjson_es_array= cJSON_GetObjectItem(cjson_rest,
+						"elementary_streams"))== NULL) {
+			CHECK(false);
+			exit(-1);
+		}
+		for(j= 0; j< cJSON_GetArraySize(cjson_es_array); j++) {
+			cJSON *cjson_es= cJSON_GetArrayItem(cjson_es_array, j);
+			cjson_aux= cJSON_GetObjectItem(cjson_es, "elementary_stream_id");
+			if(cjson_aux== NULL || cjson_aux->valueint!= elem_stream_id)
+				continue;
+			if((cjson_aux= cJSON_GetObjectItem(cjson_es, key))!= NULL)
+				value= cjson_aux->valuedouble;
+		}
+		free(rest_str);
+		cJSON_Delete(cjson_rest);
+		return value;
+	}
+
+	static double es_mux_number_get(procs_ctx_t *procs_ctx, int mux_proc_id,
+			int elem_stream_id, const char *key)
+	{
+		return es_mux_number_get_by_tag(procs_ctx, "PROCS_ID_GET",
+				mux_proc_id, elem_stream_id, key);
+	}
+
+	static double es_mux_stats_number_get(procs_ctx_t *procs_ctx,
+			int mux_proc_id, int elem_stream_id, const char *key)
+	{
+		return es_mux_number_get_by_tag(procs_ctx, "PROCS_ID_STATS_GET",
+				mux_proc_id, elem_stream_id, key);
+	}
+
+	/**
+	 * Fixture of the RTSP multiplexer and de-multiplexer settings and
+	 * behavior tests: open the LOG and PROCS modules, register both
+	 * processor types and get a PROCS module's instance; all of it is
+	 * released on destruction.
+	 */
+	struct live555_rtsp_fixture {
+		live555_rtsp_fixture(): procs_ctx(NULL)
+		{
+			log_module_open();
+			if(procs_module_open(NULL)!= STAT_SUCCESS ||
+					procs_module_opt("PROCS_REGISTER_TYPE",
+							&proc_if_live555_rtsp_mux)!= STAT_SUCCESS ||
+					procs_module_opt("PROCS_REGISTER_TYPE",
+							&proc_if_live555_rtsp_dmux)!= STAT_SUCCESS ||
+					(procs_ctx= procs_open(NULL, 16, NULL, NULL))== NULL) {
+				CHECK(false);
+				exit(-1);
+			}
+		}
+		~live555_rtsp_fixture()
+		{
+			if(procs_ctx!= NULL)
+				procs_close(&procs_ctx);
+			procs_module_close();
+			log_module_close();
+		}
+		procs_ctx_t *procs_ctx;
+	};
+
+	/**
+	 * Register an elementary stream for the given multiplexer and get its
+	 * Id. (the test exits on failure).
+	 */
+	static void es_mux_register(procs_ctx_t *procs_ctx, int mux_proc_id,
+			const char *es_settings, int *ref_elem_stream_id)
+	{
+		int ret_code;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				es_settings, &rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+				(cjson_aux= cJSON_GetObjectItem(cjson_rest,
+						"elementary_stream_id"))== NULL ||
+				(*ref_elem_stream_id= cjson_aux->valuedouble)< 0) {
+			CHECK(false);
+			exit(-1);
+		}
+		free(rest_str);
+		cJSON_Delete(cjson_rest);
+	}
+
+	/**
+	 * Get a numeric value of the given processor statistics; -1 is returned
+	 * if not found.
+	 */
+	static double proc_stats_number_get(procs_ctx_t *procs_ctx, int proc_id,
+			const char *key)
+	{
+		double value= -1;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+
+		if(procs_opt(procs_ctx, "PROCS_ID_STATS_GET", proc_id, &rest_str)!=
+				STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL) {
+			CHECK(false);
+			exit(-1);
+		}
+		if((cjson_aux= cJSON_GetObjectItem(cjson_rest, key))!= NULL)
+			value= cjson_aux->valuedouble;
+		free(rest_str);
+		cJSON_Delete(cjson_rest);
+		return value;
+	}
+
+	static int64_t monotonic_usecs_get()
+	{
+		struct timespec monotime_curr;
+
+		clock_gettime(CLOCK_MONOTONIC, &monotime_curr);
+		return (int64_t)monotime_curr.tv_sec* 1000000+
+				monotime_curr.tv_nsec/ 1000;
+	}
+
+	/**
+	 * Prepare a "1D" data frame of the given elementary stream holding a
+	 * step function.
+	 */
+	static void step_frame_init(proc_frame_ctx_t *proc_frame_ctx,
+			uint8_t *data_buf, size_t frame_size, int elem_stream_id)
+	{
+		memset(proc_frame_ctx, 0, sizeof(proc_frame_ctx_t));
+		proc_frame_ctx->data= data_buf;
+		proc_frame_ctx->p_data[0]= data_buf;
+		proc_frame_ctx->linesize[0]= frame_size;
+		proc_frame_ctx->width[0]= frame_size;
+		proc_frame_ctx->height[0]= 1; // "1D" data
+		proc_frame_ctx->es_id= elem_stream_id;
+		for(size_t i= 0, val_32b= 0; i+ 3< frame_size; i+= 4, val_32b++) {
+			data_buf[i+ 0]= ((uint32_t)val_32b>> 24)& 0xFF;
+			data_buf[i+ 1]= ((uint32_t)val_32b>> 16)& 0xFF;
+			data_buf[i+ 2]= ((uint32_t)val_32b>>  8)& 0xFF;
+			data_buf[i+ 3]= ((uint32_t)val_32b>>  0)& 0xFF;
+		}
+	}
+
+	typedef struct recv_thr_ctx_s {
+		volatile int flag_exit;
+		int dmux_proc_id;
+		procs_ctx_t *procs_ctx;
+		/**
+		 * Frame the de-multiplexed frames are compared to.
+		 */
+		const proc_frame_ctx_t *proc_frame_ctx_expected;
+		/**
+		 * Frames received, frames received intact (equal to the expected
+		 * frame) and monotonic time of the last reception (microseconds).
+		 */
+		volatile int frames_num;
+		volatile int frames_intact_num;
+		volatile int64_t last_recv_usecs;
+	} recv_thr_ctx_t;
+
+	/**
+	 * Consumer thread accounting the de-multiplexed frames.
+	 */
+	static void* recv_consumer_thr(void *t)
+	{
+		int ret_code;
+		proc_frame_ctx_t *proc_frame_ctx= NULL;
+		recv_thr_ctx_t *recv_thr_ctx= (recv_thr_ctx_t*)t;
+		const proc_frame_ctx_t *proc_frame_ctx_expected;
+
+		if(recv_thr_ctx== NULL ||
+				recv_thr_ctx->proc_frame_ctx_expected== NULL) {
+			CHECK(false);
+			exit(-1);
+		}
+		proc_frame_ctx_expected= recv_thr_ctx->proc_frame_ctx_expected;
+
+		while(recv_thr_ctx->flag_exit== 0) {
+			ret_code= procs_recv_frame(recv_thr_ctx->procs_ctx,
+					recv_thr_ctx->dmux_proc_id, &proc_frame_ctx);
+			CHECK(ret_code== STAT_SUCCESS || ret_code== STAT_EAGAIN ||
+					ret_code== STAT_ENOTFOUND || ret_code== STAT_EOF);
+			if(proc_frame_ctx== NULL) {
+				schedule(); // Avoid closed loops
+				continue;
+			}
+			if(proc_frame_ctx->width[0]== proc_frame_ctx_expected->width[0]
+					&& memcmp(proc_frame_ctx->p_data[0],
+							proc_frame_ctx_expected->p_data[0],
+							proc_frame_ctx_expected->width[0])== 0)
+				recv_thr_ctx->frames_intact_num++;
+			recv_thr_ctx->last_recv_usecs= monotonic_usecs_get();
+			recv_thr_ctx->frames_num++;
+			proc_frame_ctx_release(&proc_frame_ctx);
+		}
+		return NULL;
+	}
+
+	/**
+	 * Register a RTSP de-multiplexer instance with the given settings and
+	 * launch its consumer thread (the test exits on failure).
+	 */
+	static void recv_consumer_start(procs_ctx_t *procs_ctx,
+			const char *dmux_settings,
+			const proc_frame_ctx_t *proc_frame_ctx_expected,
+			recv_thr_ctx_t *recv_thr_ctx, pthread_t *ref_consumer_thread)
+	{
+		memset(recv_thr_ctx, 0, sizeof(recv_thr_ctx_t));
+		procs_post(procs_ctx, "live555_rtsp_dmux", dmux_settings,
+				&recv_thr_ctx->dmux_proc_id);
+		recv_thr_ctx->procs_ctx= procs_ctx;
+		recv_thr_ctx->proc_frame_ctx_expected= proc_frame_ctx_expected;
+		if(pthread_create(ref_consumer_thread, NULL, recv_consumer_thr,
+				recv_thr_ctx)!= 0) {
+			CHECK(false);
+			exit(-1);
+		}
+	}
+
+	/**
+	 * Join the consumer thread (delete de-multiplexer to unblock it; this
+	 * also closes the client, to avoid O.S. to keep server's ports).
+	 */
+	static void recv_consumer_stop(procs_ctx_t *procs_ctx,
+			recv_thr_ctx_t *recv_thr_ctx, pthread_t consumer_thread)
+	{
+		recv_thr_ctx->flag_exit= 1;
+		CHECK(procs_opt(procs_ctx, "PROCS_ID_DELETE",
+				recv_thr_ctx->dmux_proc_id)== STAT_SUCCESS);
+		pthread_join(consumer_thread, NULL);
+	}
+
+	/**
+	 * Send the given frame every 10 milliseconds until the consumer thread
+	 * receives an intact frame (or five seconds elapse, as the client has to
+	 * connect first).
+	 */
+	static void send_until_received(procs_ctx_t *procs_ctx, int mux_proc_id,
+			proc_frame_ctx_t *proc_frame_ctx, recv_thr_ctx_t *recv_thr_ctx)
+	{
+		for(int i= 0; i< 500 && recv_thr_ctx->frames_intact_num== 0; i++) {
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id, proc_frame_ctx)==
+					STAT_SUCCESS);
+			usleep(1000*10);
+		}
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture, UTESTS_LIVE555_RTSP_PACING_SETTINGS)
+	{
+		int ret_code, mux_proc_id= -1, elem_strem_id= -1;
+		char *rest_str= NULL;
+
+	    /* Register (open) a multiplexer instance */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8556",
+				&mux_proc_id);
+
+		/* Invalid pacing settings are rejected */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				"sdp_mimetype=video/mp2v&rtp_pacing_bitrate=-1", &rest_str);
+		CHECK(ret_code!= STAT_SUCCESS);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+	    /* Register a paced elementary stream */
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=video/mp2v&rtp_pacing_bitrate=4000000"
+				"&rtp_pacing_max_latency_msecs=20", &elem_strem_id);
+
+		/* Check pacing settings and status (no clients: nothing queued) */
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"rtp_pacing_bitrate")== 4000000);
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"rtp_pacing_headroom")== 25);
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"rtp_pacing_max_latency_msecs")== 20);
+		CHECK(es_mux_stats_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"rtp_pacing_queue_bytes")== 0);
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"rtp_pacing_queue_bytes")== -1);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture, UTESTS_LIVE555_RTSP_PACING_BURST)
+	{
+#define BURST_FRAME_SIZE 8192
+#define BURST_FRAMES_NUM 8
+		pthread_t consumer_thread;
+		int i, ret_code, mux_proc_id= -1, elem_strem_id= -1, frames_base;
+		int64_t burst_start_usecs, burst_usecs, queue_bytes_max= 0;
+		proc_frame_ctx_t proc_frame_ctx;
+		uint8_t data_buf[BURST_FRAME_SIZE];
+		recv_thr_ctx_t recv_thr_ctx;
+
+		/* Register a multiplexer and an elementary stream paced at 400kbps
+		 * plus the default headroom (62500 bytes per second), with no
+		 * maximum latency (pace at the token-bucket rate only).
+		 */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8561",
+				&mux_proc_id);
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=application/step-data&rtp_pacing_bitrate=400000"
+				"&rtp_pacing_max_latency_msecs=0", &elem_strem_id);
+		step_frame_init(&proc_frame_ctx, data_buf, BURST_FRAME_SIZE,
+				elem_strem_id);
+
+		/* Connect a client; send frames slower than the pacing rate (no
+		 * queuing) until the first one is received.
+		 */
+		recv_consumer_start(procs_ctx,
+				"rtsp_url=rtsp://127.0.0.1:8561/session", &proc_frame_ctx,
+				&recv_thr_ctx, &consumer_thread);
+		for(i= 0; i< 25 && recv_thr_ctx.frames_intact_num== 0; i++) {
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+					&proc_frame_ctx)== STAT_SUCCESS);
+			usleep(1000*200);
+		}
+		CHECK(recv_thr_ctx.frames_intact_num> 0);
+		usleep(1000*300);
+		frames_base= recv_thr_ctx.frames_num;
+
+		/* Send a burst of 64 kilobytes at once: it must be smoothed along
+		 * about one second (the token-bucket holds just a few packets), with
+		 * the pacer queuing the frame being paced meanwhile.
+		 */
+		burst_start_usecs= monotonic_usecs_get();
+		for(i= 0; i< BURST_FRAMES_NUM; i++)
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+					&proc_frame_ctx)== STAT_SUCCESS);
+		for(i= 0; i< 500 && recv_thr_ctx.frames_num<
+				frames_base+ BURST_FRAMES_NUM; i++) {
+			int64_t queue_bytes= (int64_t)es_mux_stats_number_get(procs_ctx,
+					mux_proc_id, elem_strem_id, "rtp_pacing_queue_bytes");
+			if(queue_bytes> queue_bytes_max)
+				queue_bytes_max= queue_bytes;
+			usleep(1000*10);
+		}
+		burst_usecs= recv_thr_ctx.last_recv_usecs- burst_start_usecs;
+		CHECK(recv_thr_ctx.frames_intact_num>= BURST_FRAMES_NUM);
+		CHECK(recv_thr_ctx.frames_num== frames_base+ BURST_FRAMES_NUM);
+		CHECK(burst_usecs>= 600000 && burst_usecs< 5000000);
+		CHECK(queue_bytes_max> 0 && queue_bytes_max<= BURST_FRAME_SIZE);
+
+		/* Once the burst is sent, nothing is queued */
+		CHECK(es_mux_stats_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"rtp_pacing_queue_bytes")== 0);
+
+		recv_consumer_stop(procs_ctx, &recv_thr_ctx, consumer_thread);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+#undef BURST_FRAMES_NUM
+#undef BURST_FRAME_SIZE
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture, UTESTS_LIVE555_RTSP_MULTICAST_SETTINGS)
+	{
+		int ret_code, mux_proc_id= -1, elem_strem_id= -1;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_settings= NULL, *cjson_aux= NULL;
+
+	    /* Register (open) a multiplexer instance */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8557",
+				&mux_proc_id);
+
+		/* Invalid multicast settings are rejected */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", mux_proc_id,
+				"multicast_address=10.0.0.1");
+		CHECK(ret_code!= STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", mux_proc_id,
+				"multicast_address=239.255.42.42&multicast_port=18891");
+		CHECK(ret_code!= STAT_SUCCESS);
+
+		/* Switch to multicast mode */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", mux_proc_id,
+				"multicast_address=239.255.42.42&multicast_port=18890"
+				"&multicast_ttl=1");
+		CHECK(ret_code== STAT_SUCCESS);
+
+	    /* Register an elementary stream (served as multicast) */
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=video/mp2v&rtp_pacing_bitrate=4000000",
+				&elem_strem_id);
+
+		/* Check settings */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", mux_proc_id, &rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+				(cjson_settings= cJSON_GetObjectItem(cjson_rest,
+						"settings"))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "multicast_address");
+		CHECK(cjson_aux!= NULL &&
+				strcmp(cjson_aux->valuestring, "239.255.42.42")== 0);
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "multicast_port");
+		CHECK(cjson_aux!= NULL && cjson_aux->valueint== 18890);
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "multicast_ttl");
+		CHECK(cjson_aux!= NULL && cjson_aux->valueint== 1);
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "packet_buffer_size");
+		CHECK(cjson_aux!= NULL && cjson_aux->valueint== 200000);
+		free(rest_str); rest_str= NULL;
+		cJSON_Delete(cjson_rest); cjson_rest= NULL;
+
+		/* Each elementary stream uses the next RTP/RTCP ports pair; ports
+		 * have to fit in range (both on port change and on new elementary
+		 * stream registering).
+		 */
+		es_mux_register(procs_ctx, mux_proc_id, "sdp_mimetype=video/mp2v",
+				&elem_strem_id);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", mux_proc_id,
+				"multicast_port=65534");
+		CHECK(ret_code!= STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", mux_proc_id,
+				"multicast_port=65532");
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				"sdp_mimetype=video/mp2v", &rest_str);
+		CHECK(ret_code!= STAT_SUCCESS);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+		/* Back to unicast mode; elementary stream settings are kept */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", mux_proc_id,
+				"multicast_address=");
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", mux_proc_id, &rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+				(cjson_aux= cJSON_GetObjectItem(cjson_rest,
+						"elementary_streams"))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		CHECK(cJSON_GetArraySize(cjson_aux)== 2);
+		if((cjson_aux= cJSON_GetArrayItem(cjson_aux, 0))!= NULL)
+			cjson_aux= cJSON_GetObjectItem(cjson_aux, "rtp_pacing_bitrate");
+		CHECK(cjson_aux!= NULL && cjson_aux->valuedouble== 4000000);
+		free(rest_str); rest_str= NULL;
+		cJSON_Delete(cjson_rest); cjson_rest= NULL;
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture, UTESTS_LIVE555_RTSP_MULTICAST_DELIVERY)
+	{
+		pthread_t consumer_thread;
+		int ret_code, mux_proc_id= -1, elem_strem_id= -1;
+		proc_frame_ctx_t proc_frame_ctx;
+		uint8_t data_buf[FRAME_SIZE];
+		recv_thr_ctx_t recv_thr_ctx;
+
+		/* Register a multicast multiplexer and an elementary stream
+		 * (time-to-live 0: keep the packets in this host).
+		 */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8562"
+				"&multicast_address=239.255.42.43&multicast_port=18900"
+				"&multicast_ttl=0", &mux_proc_id);
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=application/step-data", &elem_strem_id);
+		step_frame_init(&proc_frame_ctx, data_buf, FRAME_SIZE,
+				elem_strem_id);
+
+		/* The client joins the multicast group announced in the session
+		 * description; check frames are delivered intact.
+		 */
+		recv_consumer_start(procs_ctx,
+				"rtsp_url=rtsp://127.0.0.1:8562/session", &proc_frame_ctx,
+				&recv_thr_ctx, &consumer_thread);
+		send_until_received(procs_ctx, mux_proc_id, &proc_frame_ctx,
+				&recv_thr_ctx);
+		CHECK(recv_thr_ctx.frames_intact_num> 0);
+		CHECK(recv_thr_ctx.frames_intact_num== recv_thr_ctx.frames_num);
+
+		recv_consumer_stop(procs_ctx, &recv_thr_ctx, consumer_thread);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture,
+			UTESTS_LIVE555_RTSP_BITRATE_ADAPT_SETTINGS)
+	{
+		int ret_code, mux_proc_id= -1, elem_strem_id= -1;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_es= NULL, *cjson_aux= NULL;
+
+	    /* Register (open) a multiplexer instance */
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8558",
+				&mux_proc_id);
+
+		/* Inconsistent loss thresholds are rejected */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_REGISTER", mux_proc_id,
+				"sdp_mimetype=video/mp2v&bitrate_adapt_loss_high=2"
+				"&bitrate_adapt_loss_low=2", &rest_str);
+		CHECK(ret_code!= STAT_SUCCESS);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+	    /* Register an elementary stream */
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=video/mp2v&bitrate_adapt_min=100000"
+				"&bitrate_adapt_loss_high=8", &elem_strem_id);
+
+		/* Check settings; no encoder bound, no receivers yet */
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"bitrate_adapt_min")== 100000);
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"bitrate_adapt_max")== 0);
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"bitrate_adapt_loss_high")== 8);
+		CHECK(es_mux_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"bitrate_adapt_loss_low")== 1);
+		CHECK(es_mux_stats_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"bitrate_adapt_bitrate")== 0);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_STATS_GET", mux_proc_id,
+				&rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+				(cjson_aux= cJSON_GetObjectItem(cjson_rest,
+						"elementary_streams"))== NULL ||
+				(cjson_es= cJSON_GetArrayItem(cjson_aux, 0))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		cjson_aux= cJSON_GetObjectItem(cjson_es, "rtcp_receivers");
+		CHECK(cjson_aux!= NULL && cJSON_GetArraySize(cjson_aux)== 0);
+		free(rest_str); rest_str= NULL;
+		cJSON_Delete(cjson_rest); cjson_rest= NULL;
+
+		/* Binding an encoder to an unknown elementary stream, or binding an
+		 * unknown encoder, fails; unbinding when no encoder is bound is
+		 * harmless.
+		 */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_BITRATE_ADAPT",
+				mux_proc_id, elem_strem_id+ 1, procs_ctx, 0);
+		CHECK(ret_code!= STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_BITRATE_ADAPT",
+				mux_proc_id, elem_strem_id, procs_ctx, mux_proc_id+ 1);
+		CHECK(ret_code!= STAT_SUCCESS);
+		CHECK(es_mux_stats_number_get(procs_ctx, mux_proc_id, elem_strem_id,
+				"bitrate_adapt_bitrate")== 0);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_ES_MUX_BITRATE_ADAPT",
+				mux_proc_id, elem_strem_id, (procs_ctx_t*)NULL, -1);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture, UTESTS_LIVE555_RTSP_DMUX_SETTINGS)
+	{
+		int ret_code, dmux_proc_id= -1;
+		char *rest_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_settings= NULL, *cjson_aux= NULL;
+
+	    /* Register a de-multiplexer instance (no server is listening; the
+	     * client just keeps trying in the background).
+	     */
+		procs_post(procs_ctx, "live555_rtsp_dmux",
+				"rtsp_url=rtsp://127.0.0.1:8559/session"
+				"&jitter_buffer_msecs=250&receive_buffer_size=4096"
+				"&receive_buffer_size_max=1048576", &dmux_proc_id);
+
+		/* Out of range jitter buffer depths are rejected */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", dmux_proc_id,
+				"jitter_buffer_msecs=-1");
+		CHECK(ret_code!= STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", dmux_proc_id,
+				"jitter_buffer_msecs=100000");
+		CHECK(ret_code!= STAT_SUCCESS);
+
+		/* Receive buffer initial size can not exceed its maximum */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", dmux_proc_id,
+				"receive_buffer_size=2097152");
+		CHECK(ret_code!= STAT_SUCCESS);
+
+		/* Check settings */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", dmux_proc_id,
+				&rest_str);
+		if(ret_code!= STAT_SUCCESS || rest_str== NULL ||
+				(cjson_rest= cJSON_Parse(rest_str))== NULL ||
+				(cjson_settings= cJSON_GetObjectItem(cjson_rest,
+						"settings"))== NULL) {
+			fprintf(stderr, "Error at line: %d\n", __LINE__);
+			exit(-1);
+		}
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "jitter_buffer_msecs");
+		CHECK(cjson_aux!= NULL && cjson_aux->valueint== 250);
+		cjson_aux= cJSON_GetObjectItem(cjson_settings, "receive_buffer_size");
+		CHECK(cjson_aux!= NULL && cjson_aux->valueint== 4096);
+		cjson_aux= cJSON_GetObjectItem(cjson_settings,
+				"receive_buffer_size_max");
+		CHECK(cjson_aux!= NULL && cjson_aux->valueint== 1048576);
+		free(rest_str); rest_str= NULL;
+		cJSON_Delete(cjson_rest); cjson_rest= NULL;
+
+		/* Check statistics */
+		CHECK(proc_stats_number_get(procs_ctx, dmux_proc_id,
+				"truncated_frames")== 0);
+
+		/* Delete de-multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", dmux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture,
+			UTESTS_LIVE555_RTSP_DMUX_RECEIVE_BUFFER_GROWTH)
+	{
+		pthread_t consumer_thread;
+		int ret_code, mux_proc_id= -1, elem_strem_id= -1;
+		proc_frame_ctx_t proc_frame_ctx;
+		uint8_t data_buf[FRAME_SIZE];
+		recv_thr_ctx_t recv_thr_ctx;
+
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8563",
+				&mux_proc_id);
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=application/step-data", &elem_strem_id);
+		step_frame_init(&proc_frame_ctx, data_buf, FRAME_SIZE,
+				elem_strem_id);
+
+		/* The initial receive buffer is smaller than a RTP packet: the first
+		 * frame is truncated (and dropped), the buffer grows and the
+		 * following frames are received intact.
+		 */
+		recv_consumer_start(procs_ctx,
+				"rtsp_url=rtsp://127.0.0.1:8563/session"
+				"&receive_buffer_size=512&receive_buffer_size_max=1048576",
+				&proc_frame_ctx, &recv_thr_ctx, &consumer_thread);
+		send_until_received(procs_ctx, mux_proc_id, &proc_frame_ctx,
+				&recv_thr_ctx);
+		CHECK(recv_thr_ctx.frames_intact_num> 0);
+		CHECK(recv_thr_ctx.frames_intact_num== recv_thr_ctx.frames_num);
+		CHECK(proc_stats_number_get(procs_ctx, recv_thr_ctx.dmux_proc_id,
+				"truncated_frames")>= 1);
+
+		recv_consumer_stop(procs_ctx, &recv_thr_ctx, consumer_thread);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
+
+	TEST_FIXTURE(live555_rtsp_fixture,
+			UTESTS_LIVE555_RTSP_DMUX_TRUNCATED_FRAMES_DROP)
+	{
+		pthread_t consumer_thread;
+		int i, ret_code, mux_proc_id= -1, elem_strem_id= -1;
+		proc_frame_ctx_t proc_frame_ctx;
+		uint8_t data_buf[FRAME_SIZE];
+		recv_thr_ctx_t recv_thr_ctx;
+
+		procs_post(procs_ctx, "live555_rtsp_mux", "rtsp_port=8564",
+				&mux_proc_id);
+		es_mux_register(procs_ctx, mux_proc_id,
+				"sdp_mimetype=application/step-data", &elem_strem_id);
+		step_frame_init(&proc_frame_ctx, data_buf, FRAME_SIZE,
+				elem_strem_id);
+
+		/* The receive buffer can not grow to fit a RTP packet: every frame
+		 * is truncated, thus accounted and dropped (never delivered).
+		 */
+		recv_consumer_start(procs_ctx,
+				"rtsp_url=rtsp://127.0.0.1:8564/session"
+				"&receive_buffer_size=512&receive_buffer_size_max=512",
+				&proc_frame_ctx, &recv_thr_ctx, &consumer_thread);
+		for(i= 0; i< 500 && proc_stats_number_get(procs_ctx,
+				recv_thr_ctx.dmux_proc_id, "truncated_frames")< 3; i++) {
+			CHECK(procs_send_frame(procs_ctx, mux_proc_id,
+					&proc_frame_ctx)== STAT_SUCCESS);
+			usleep(1000*10);
+		}
+		CHECK(proc_stats_number_get(procs_ctx, recv_thr_ctx.dmux_proc_id,
+				"truncated_frames")>= 3);
+		CHECK(recv_thr_ctx.frames_num== 0);
+
+		recv_consumer_stop(procs_ctx, &recv_thr_ctx, consumer_thread);
+
+		/* Delete multiplexer */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", mux_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+	}
 }
@@ -41,8 +41,13 @@
 #include <libmediaprocsutils/fifo.h>
 #include <libmediaprocsutils/fair_lock.h>
 #include <libmediaprocsutils/interr_usleep.h>
+#include <libmediaprocsutils/json_writer.h>
+#include <libmediaprocsutils/uri_parser.h>
+#include <libmediaprocsutils/trace.h>
+#include <libmediaprocsutils/usdt.h>
 
 #include "proc_if.h"
+#include "proc_capture.h"
 
 /* **** Definitions **** */
 
@@ -61,10 +66,36 @@
  */
 #define PROC_STATS_THR_MEASURE_PERIOD_USECS (1000000)
 
+/**
+ * Processing thread CPU time sampling period (10 milliseconds). Reading the
+ * thread CPU-time clock is a system call, thus it is not done on every
+ * processing call (see 'proc_thr()').
+ */
+#define PROC_THR_CPU_TIME_SAMPLE_PERIOD_USECS (10000)
+
+/**
+ * Maximum length of a field name in a fields selection list (see tag
+ * "PROC_GET_FIELDS").
+ */
+#define PROC_FIELD_NAME_MAX_LEN 64
+
+/**
+ * Returns a new processor settings version value (unique among all the
+ * processors instances; see 'proc_ctx_s::settings_version').
+ */
+#define PROC_SETTINGS_VERSION_NEXT() \
+	__atomic_add_fetch(&proc_settings_version_seq, 1, __ATOMIC_RELAXED)
+
 /* **** Prototypes **** */
 
 static int procs_id_get(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
 		proc_if_rest_fmt_t rest_fmt, void **ref_reponse);
+static int procs_id_get_stream(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		json_writer_ctx_t *json_writer_ctx);
+static int procs_id_get_fields(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		json_writer_ctx_t *json_writer_ctx, const char *fields_str);
+static int procs_id_stats_get_stream(proc_ctx_t *proc_ctx,
+		log_ctx_t *log_ctx, json_writer_ctx_t *json_writer_ctx);
 
 static void* proc_stats_thr(void *t);
 static void* proc_thr(void *t);
@@ -73,9 +104,23 @@ static void proc_stats_register_frame_pts(proc_ctx_t *proc_ctx,
 		const proc_frame_ctx_t *proc_frame_ctx, const proc_io_t proc_io);
 static void proc_stats_register_accumulated_io_bits(proc_ctx_t *proc_ctx,
 		const proc_frame_ctx_t *proc_frame_ctx, const proc_io_t proc_io);
+static void proc_stats_update_proc_thr(proc_ctx_t *proc_ctx);
+static uint64_t proc_stats_mono_nsec();
+
+static int proc_capture_put(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		const char *str);
+static void proc_capture_stop(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		const proc_io_t proc_io);
+static void proc_capture_frame(proc_ctx_t *proc_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx, const proc_io_t proc_io);
 
 /* **** Implementations **** */
 
+/**
+ * Processors settings version sequence (see 'PROC_SETTINGS_VERSION_NEXT()').
+ */
+static uint64_t proc_settings_version_seq= 0;
+
 proc_ctx_t* proc_open(const proc_if_t *proc_if, const char *settings_str,
 		int proc_instance_index, const char* href,
 		uint32_t fifo_ctx_maxsize[PROC_IO_NUM], log_ctx_t *log_ctx,
@@ -108,6 +153,9 @@ proc_ctx_t* proc_open(const proc_if_t *proc_if, const char *settings_str,
 	/* Set PROC register index. */
 	proc_ctx->proc_instance_index= proc_instance_index;
 
+	/* Initialize settings version */
+	proc_ctx->settings_version= PROC_SETTINGS_VERSION_NEXT();
+
 	/* Set processor 'href' */
 	if(href!= NULL && strlen(href)> 0) {
 		proc_ctx->href= strdup(href);
@@ -118,6 +166,12 @@ proc_ctx_t* proc_open(const proc_if_t *proc_if, const char *settings_str,
 	ret_code= pthread_mutex_init(&proc_ctx->api_mutex, NULL);
 	CHECK_DO(ret_code== 0, goto end);
 
+	/* Frames capture mutual exclusion lock (capture is initially off) */
+	ret_code= pthread_mutex_init(&proc_ctx->capture_mutex, NULL);
+	CHECK_DO(ret_code== 0, goto end);
+	proc_ctx->capture_ctx_array[PROC_IPUT]= NULL;
+	proc_ctx->capture_ctx_array[PROC_OPUT]= NULL;
+
 	/* Set LOG module:
 	 * IMPORTANT NOTE: LOG module is thought to be set externally (thus
 	 * passed by argument as a pointer). Nevertheless, any specific
@@ -189,6 +243,11 @@ proc_ctx_t* proc_open(const proc_if_t *proc_if, const char *settings_str,
 	ret_code= pthread_mutex_init(&proc_ctx->latency_mutex, NULL);
 	CHECK_DO(ret_code== 0, goto end);
 
+	/* Initialize processing thread statistics sample (CPU usage and
+	 * stage-times are computed when read; see 'proc_stats_update_proc_thr()')
+	 */
+	proc_ctx->stats_prev_mono_nsec= proc_stats_mono_nsec();
+
 	/* Launch statistics thread if applicable */
 	flag_proc_features= proc_if->flag_proc_features;
 	if(flag_proc_features& (PROC_FEATURE_BITRATE|PROC_FEATURE_REGISTER_PTS|
@@ -248,11 +307,13 @@ void proc_close(proc_ctx_t **ref_proc_ctx)
 		ASSERT(unblock(proc_ctx)== STAT_SUCCESS);
 	}
 	LOGD("Waiting processor thread to join... ");
-	pthread_join(proc_ctx->proc_thread, &thread_end_code);
-	if(thread_end_code!= NULL) {
-		ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
-		free(thread_end_code);
-		thread_end_code= NULL;
+	if(proc_if!= NULL && proc_if->process_frame!= NULL) {
+		pthread_join(proc_ctx->proc_thread, &thread_end_code);
+		if(thread_end_code!= NULL) {
+			ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
+			free(thread_end_code);
+			thread_end_code= NULL;
+		}
 	}
 	LOGD("joined O.K;\nWaiting statistics thread to join... ");
 	/* Join periodical statistics thread:
@@ -260,15 +321,16 @@ void proc_close(proc_ctx_t **ref_proc_ctx)
 	 * - Join the statistics thread;
 	 * - Release (close) the interruptible usleep module instance.
 	 */
-	if(proc_ctx->interr_usleep_ctx!= NULL)
+	if(proc_ctx->interr_usleep_ctx!= NULL) {
 		interr_usleep_unblock(proc_ctx->interr_usleep_ctx);
-	pthread_join(proc_ctx->stats_thread, &thread_end_code);
-	if(thread_end_code!= NULL) {
-		ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
-		free(thread_end_code);
-		thread_end_code= NULL;
+		pthread_join(proc_ctx->stats_thread, &thread_end_code);
+		if(thread_end_code!= NULL) {
+			ASSERT(*((int*)thread_end_code)== STAT_SUCCESS);
+			free(thread_end_code);
+			thread_end_code= NULL;
+		}
+		interr_usleep_close(&proc_ctx->interr_usleep_ctx);
 	}
-	interr_usleep_close(&proc_ctx->interr_usleep_ctx);
 	LOGD("joined O.K.\n");
 
 	/* Release processor 'href' if applicable */
@@ -280,6 +342,11 @@ void proc_close(proc_ctx_t **ref_proc_ctx)
 	/* Release API mutual exclusion lock */
 	ASSERT(pthread_mutex_destroy(&proc_ctx->api_mutex)== 0);
 
+	/* Stop (finalize) frames capture if applicable */
+	proc_capture_stop(proc_ctx, LOG_CTX_GET(), PROC_IPUT);
+	proc_capture_stop(proc_ctx, LOG_CTX_GET(), PROC_OPUT);
+	ASSERT(pthread_mutex_destroy(&proc_ctx->capture_mutex)== 0);
+
 	/* Release input and output FIFO's */
 	fifo_close(&proc_ctx->fifo_ctx_array[PROC_IPUT]);
 	fifo_close(&proc_ctx->fifo_ctx_array[PROC_OPUT]);
@@ -297,6 +364,9 @@ void proc_close(proc_ctx_t **ref_proc_ctx)
 	/* Release latency measurement related variables */
 	ASSERT(pthread_mutex_destroy(&proc_ctx->latency_mutex)== 0);
 
+	/* Release REST JSON writer */
+	json_writer_close(&proc_ctx->json_writer_ctx);
+
 	/* Close the specific PROC instance */
 	CHECK_DO(proc_if!= NULL, return); // sanity check
 	CHECK_DO(proc_if->close!= NULL, return); // sanity check
@@ -331,6 +401,8 @@ int proc_send_frame(proc_ctx_t *proc_ctx,
 	/* Send frame to processor
 	 * (perform within input interface critical section).
 	 */
+	USDT_PROBE2(proc_send_frame, proc_ctx->proc_instance_index,
+			proc_frame_ctx!= NULL? proc_frame_ctx->pts: -1);
 	end_code= STAT_ENOTFOUND;
 	if((send_frame= proc_if->send_frame)!= NULL) {
 		fair_lock(fair_lock_p);
@@ -338,6 +410,23 @@ int proc_send_frame(proc_ctx_t *proc_ctx,
 		fair_unlock(fair_lock_p);
 	}
 
+	/* Update frame counters (and trace enqueued/dropped frame) */
+	if(end_code== STAT_SUCCESS) {
+		register uint64_t frame_id= __atomic_add_fetch(
+				&proc_ctx->frame_cnt[PROC_IPUT], 1, __ATOMIC_RELAXED);
+		TRACE_EVENT("fifo_enqueue", TRACE_EVENT_INSTANT,
+				proc_ctx->proc_instance_index, frame_id,
+				proc_frame_ctx!= NULL? proc_frame_ctx->pts: -1);
+		if(proc_ctx->capture_ctx_array[PROC_IPUT]!= NULL &&
+				proc_frame_ctx!= NULL)
+			proc_capture_frame(proc_ctx, proc_frame_ctx, PROC_IPUT);
+	} else if(end_code== STAT_ENOMEM) {
+		__atomic_add_fetch(&proc_ctx->frame_drop_cnt, 1, __ATOMIC_RELAXED);
+		TRACE_EVENT("fifo_drop", TRACE_EVENT_INSTANT,
+				proc_ctx->proc_instance_index, proc_ctx->frame_cnt[PROC_IPUT],
+				proc_frame_ctx!= NULL? proc_frame_ctx->pts: -1);
+	}
+
 	return end_code;
 }
 
@@ -346,6 +435,7 @@ int proc_recv_frame(proc_ctx_t *proc_ctx,
 {
 	const proc_if_t *proc_if;
 	int ret_code, end_code= STAT_ERROR;
+	uint64_t frame_id;
 	int (*recv_frame)(proc_ctx_t*, proc_frame_ctx_t**)= NULL;
 	fair_lock_t *fair_lock_p= NULL;
 	LOG_CTX_INIT(NULL);
@@ -379,6 +469,15 @@ int proc_recv_frame(proc_ctx_t *proc_ctx,
 		goto end;
 	}
 
+	/* Update frame counter (and trace dequeued frame) */
+	frame_id= __atomic_add_fetch(&proc_ctx->frame_cnt[PROC_OPUT], 1,
+			__ATOMIC_RELAXED);
+	TRACE_EVENT("fifo_dequeue", TRACE_EVENT_INSTANT,
+			proc_ctx->proc_instance_index, frame_id,
+			(*ref_proc_frame_ctx)->pts);
+	if(proc_ctx->capture_ctx_array[PROC_OPUT]!= NULL)
+		proc_capture_frame(proc_ctx, *ref_proc_frame_ctx, PROC_OPUT);
+
 	end_code= STAT_SUCCESS;
 end:
 	if(end_code!= STAT_SUCCESS)
@@ -429,14 +528,44 @@ int proc_vopt(proc_ctx_t *proc_ctx, const char *tag, va_list arg)
 		proc_if_rest_fmt_t rest_fmt= va_arg(arg, proc_if_rest_fmt_t);
 		void **ref_reponse= va_arg(arg, void**);
 		end_code= procs_id_get(proc_ctx, LOG_CTX_GET(), rest_fmt, ref_reponse);
+	} else if(TAG_IS("PROC_GET_JSON_WRITER")) {
+		end_code= procs_id_get_stream(proc_ctx, LOG_CTX_GET(),
+				va_arg(arg, json_writer_ctx_t*));
+	} else if(TAG_IS("PROC_GET_FIELDS")) {
+		json_writer_ctx_t *json_writer_ctx= va_arg(arg, json_writer_ctx_t*);
+		const char *fields_str= va_arg(arg, const char*);
+		end_code= procs_id_get_fields(proc_ctx, LOG_CTX_GET(), json_writer_ctx,
+				fields_str);
+	} else if(TAG_IS("PROC_GET_STATS_JSON_WRITER")) {
+		end_code= procs_id_stats_get_stream(proc_ctx, LOG_CTX_GET(),
+				va_arg(arg, json_writer_ctx_t*));
 	} else if(TAG_IS("PROC_PUT")) {
+		const char *str= va_arg(arg, const char*);
+		int capture_code;
 		end_code= STAT_ENOTFOUND;
 		if(proc_if!= NULL && (rest_put= proc_if->rest_put)!= NULL)
-			end_code= rest_put(proc_ctx, va_arg(arg, const char*));
+			end_code= rest_put(proc_ctx, str);
+		if(end_code== STAT_SUCCESS)
+			proc_ctx->settings_version= PROC_SETTINGS_VERSION_NEXT();
+		/* Generic capture settings apply once the processor accepted the
+		 * settings, or if the processor does not implement settings (a
+		 * rejected PUT does not start nor stop any capture).
+		 */
+		if(end_code== STAT_SUCCESS || end_code== STAT_ENOTFOUND) {
+			capture_code= proc_capture_put(proc_ctx, LOG_CTX_GET(), str);
+			if(capture_code!= STAT_ENOTFOUND && (capture_code!=
+					STAT_SUCCESS || end_code== STAT_ENOTFOUND))
+				end_code= capture_code;
+		}
 	} else {
-		if(proc_if!= NULL && (opt= proc_if->opt)!= NULL)
+		if(proc_if!= NULL && (opt= proc_if->opt)!= NULL) {
 			end_code= opt(proc_ctx, tag, arg);
-		else {
+			/* Processor specific options may modify the representational
+			 * state (e.g. registering a multiplexer's elementary stream).
+			 */
+			if(end_code== STAT_SUCCESS)
+				proc_ctx->settings_version= PROC_SETTINGS_VERSION_NEXT();
+		} else {
 			LOGE("Unknown option\n");
 			end_code= STAT_ENOTFOUND;
 		}
@@ -587,11 +716,13 @@ static int procs_id_get(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
 		proc_if_rest_fmt_t rest_fmt, void **ref_reponse)
 {
 	const proc_if_t *proc_if;
-	uint64_t flag_proc_features;
 	int ret_code, end_code= STAT_ERROR;
-	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+	cJSON *cjson_rest= NULL;
 	int (*rest_get)(proc_ctx_t *proc_ctx, proc_if_rest_fmt_t rest_fmt,
 			void **ref_reponse)= NULL;
+	int (*rest_get_stream)(proc_ctx_t *proc_ctx,
+			json_writer_ctx_t *json_writer_ctx)= NULL;
+	const char *rest_str= NULL; // Do not release
 	LOG_CTX_INIT(log_ctx);
 
 	/* Check arguments */
@@ -611,7 +742,45 @@ static int procs_id_get(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
 	proc_if= proc_ctx->proc_if;
 	CHECK_DO(proc_if!= NULL, goto end);
 	rest_get= proc_if->rest_get;
-	flag_proc_features= proc_if->flag_proc_features;
+	rest_get_stream= proc_if->rest_get_stream;
+
+	/* Streaming GET is used in preference if implemented by the specific
+	 * processor (for the cJSON format, only if 'rest_get()' is not available).
+	 * The JSON writer is kept for re-use.
+	 */
+	if(rest_get_stream!= NULL &&
+			(rest_fmt== PROC_IF_REST_FMT_CHAR || rest_get== NULL)) {
+		if(proc_ctx->json_writer_ctx== NULL) {
+			proc_ctx->json_writer_ctx= json_writer_open(0);
+			CHECK_DO(proc_ctx->json_writer_ctx!= NULL, goto end);
+		}
+		json_writer_reset(proc_ctx->json_writer_ctx);
+
+		ret_code= procs_id_get_stream(proc_ctx, LOG_CTX_GET(),
+				proc_ctx->json_writer_ctx);
+		if(ret_code!= STAT_SUCCESS) {
+			end_code= ret_code;
+			goto end;
+		}
+		rest_str= json_writer_get_str(proc_ctx->json_writer_ctx, NULL);
+		CHECK_DO(rest_str!= NULL, goto end);
+
+		switch(rest_fmt) {
+		case PROC_IF_REST_FMT_CHAR:
+			*ref_reponse= (void*)strdup(rest_str);
+			break;
+		case PROC_IF_REST_FMT_CJSON:
+			*ref_reponse= (void*)cJSON_Parse(rest_str);
+			break;
+		default:
+			LOGE("Unknown format requested for processor REST\n");
+			goto end;
+		}
+		CHECK_DO(*ref_reponse!= NULL, goto end);
+
+		end_code= STAT_SUCCESS;
+		goto end;
+	}
 
 	/* Check if GET function callback is implemented by specific processor */
 	if(rest_get== NULL) {
@@ -628,27 +797,6 @@ static int procs_id_get(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
 	}
 	CHECK_DO(cjson_rest!= NULL, goto end);
 
-	/* **** Add some REST elements at top ****
-	 * We do a little HACK to insert elements at top as cJSON library does not
-	 * support it natively -it always insert at the bottom-
-	 * We do this at the risk of braking in a future library version, as we
-	 * base current solution on the internal implementation of function
-	 * 'cJSON_AddItemToObject()' -may change in future-.
-	 */
-
-	if(flag_proc_features&PROC_FEATURE_LATENCY) {
-		/* 'latency_avg_usec' */
-		cjson_aux= cJSON_CreateNumber((double)proc_ctx->latency_avg_usec);
-		CHECK_DO(cjson_aux!= NULL, goto end);
-		// Hack of 'cJSON_AddItemToObject(cjson_rest, "latency_avg_usec",
-		// 		cjson_aux);':
-		cjson_aux->string= (char*)strdup("latency_avg_usec");
-		cjson_aux->type|= cJSON_StringIsConst;
-		//cJSON_AddItemToArray(cjson_rest, cjson_aux);
-		cJSON_InsertItemInArray(cjson_rest, 0, cjson_aux); // Insert at top
-		cjson_aux->type&= ~cJSON_StringIsConst;
-	}
-
 	/* Format response to be returned */
 	switch(rest_fmt) {
 	case PROC_IF_REST_FMT_CHAR:
@@ -673,6 +821,256 @@ end:
 	return end_code;
 }
 
+/**
+ * Write processor's REST representation (as a JSON object) using the given
+ * JSON writer. Processors implementing 'proc_if_s::rest_get_stream()' write
+ * their members directly; otherwise, the printed cJSON representation is
+ * copied.
+ */
+static int procs_id_get_stream(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		json_writer_ctx_t *json_writer_ctx)
+{
+	const proc_if_t *proc_if;
+	int ret_code, end_code= STAT_ERROR;
+	char *rest_str= NULL;
+	int (*rest_get_stream)(proc_ctx_t *proc_ctx,
+			json_writer_ctx_t *json_writer_ctx)= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	//log_ctx allowed to be NULL
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+
+	/* Check that processor API critical section is locked */
+	ret_code= pthread_mutex_trylock(&proc_ctx->api_mutex);
+	CHECK_DO(ret_code== EBUSY, goto end);
+
+	/* Get required variables from PROC interface structure */
+	proc_if= proc_ctx->proc_if;
+	CHECK_DO(proc_if!= NULL, goto end);
+	rest_get_stream= proc_if->rest_get_stream;
+
+	/* Processor does not support streaming: copy printed representation */
+	if(rest_get_stream== NULL) {
+		ret_code= procs_id_get(proc_ctx, LOG_CTX_GET(), PROC_IF_REST_FMT_CHAR,
+				(void**)&rest_str);
+		if(ret_code!= STAT_SUCCESS) {
+			end_code= ret_code;
+			goto end;
+		}
+		end_code= json_writer_raw(json_writer_ctx, NULL, rest_str);
+		goto end;
+	}
+
+	json_writer_object_start(json_writer_ctx, NULL);
+
+	/* Processor's specific members */
+	ret_code= rest_get_stream(proc_ctx, json_writer_ctx);
+	if(ret_code!= STAT_SUCCESS) {
+		end_code= ret_code;
+		goto end;
+	}
+
+	end_code= json_writer_object_end(json_writer_ctx);
+end:
+	if(rest_str!= NULL)
+		free(rest_str);
+	return end_code;
+}
+
+/**
+ * Write the selected fields of the processor's representational state as
+ * members of the object currently open in the given JSON writer.
+ * Generic statistics (latency and bitrate) are read directly from the
+ * processor context structure. Any other field is looked up in the
+ * processor's "settings" (or at the top level of its representation); the
+ * processor's representation is only composed if at least one of these
+ * fields is requested. Fields not found are just skipped.
+ */
+static int procs_id_get_fields(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		json_writer_ctx_t *json_writer_ctx, const char *fields_str)
+{
+	const proc_if_t *proc_if;
+	uint64_t flag_proc_features;
+	const char *field_str;
+	int ret_code, end_code= STAT_ERROR;
+	cJSON *cjson_rest= NULL, *cjson_settings= NULL, *cjson_aux= NULL;
+	char *value_str= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	//log_ctx allowed to be NULL
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(fields_str!= NULL, return STAT_ERROR);
+
+	/* Check that processor API critical section is locked */
+	ret_code= pthread_mutex_trylock(&proc_ctx->api_mutex);
+	CHECK_DO(ret_code== EBUSY, goto end);
+
+	/* Get required variables from PROC interface structure */
+	proc_if= proc_ctx->proc_if;
+	CHECK_DO(proc_if!= NULL, goto end);
+	flag_proc_features= proc_if->flag_proc_features;
+
+	/* Update processing thread statistics if applicable */
+	if(proc_if->process_frame!= NULL)
+		proc_stats_update_proc_thr(proc_ctx);
+
+	/* Iterate comma-separated fields list */
+	for(field_str= fields_str; *field_str!= '\0';) {
+		char field_name[PROC_FIELD_NAME_MAX_LEN];
+		size_t field_len= strcspn(field_str, ",");
+		const char *next_field_str= field_str+ field_len;
+		if(*next_field_str== ',')
+			next_field_str++;
+
+		if(field_len== 0 || field_len>= sizeof(field_name)) {
+			field_str= next_field_str;
+			continue;
+		}
+		memcpy(field_name, field_str, field_len);
+		field_name[field_len]= '\0';
+		field_str= next_field_str;
+
+		/* Generic statistics */
+		if(proc_if->process_frame!= NULL) {
+			if(strcmp(field_name, "cpu_time_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						(int64_t)(proc_ctx->cpu_time_nsec/ 1000));
+				continue;
+			} else if(strcmp(field_name, "cpu_usage")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->cpu_usage);
+				continue;
+			} else if(strcmp(field_name, "stage_iput_wait_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->stage_iput_wait_usec);
+				continue;
+			} else if(strcmp(field_name, "stage_process_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->stage_process_usec);
+				continue;
+			} else if(strcmp(field_name, "stage_oput_wait_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->stage_oput_wait_usec);
+				continue;
+			}
+		}
+		if(flag_proc_features& PROC_FEATURE_LATENCY) {
+			if(strcmp(field_name, "latency_avg_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->latency_avg_usec);
+				continue;
+			} else if(strcmp(field_name, "latency_max_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->latency_max_usec);
+				continue;
+			} else if(strcmp(field_name, "latency_min_usec")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->latency_min_usec);
+				continue;
+			}
+		}
+		if(flag_proc_features& PROC_FEATURE_BITRATE) {
+			if(strcmp(field_name, "bitrate_iput")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->bitrate[PROC_IPUT]);
+				continue;
+			} else if(strcmp(field_name, "bitrate_oput")== 0) {
+				json_writer_int(json_writer_ctx, field_name,
+						proc_ctx->bitrate[PROC_OPUT]);
+				continue;
+			}
+		}
+
+		/* Processor's specific fields: compose representation only once */
+		if(cjson_rest== NULL) {
+			if(proc_if->rest_get== NULL)
+				continue;
+			ret_code= proc_if->rest_get(proc_ctx, PROC_IF_REST_FMT_CJSON,
+					(void**)&cjson_rest);
+			CHECK_DO(ret_code== STAT_SUCCESS && cjson_rest!= NULL, goto end);
+			cjson_settings= cJSON_GetObjectItem(cjson_rest, "settings");
+		}
+		cjson_aux= NULL;
+		if(cjson_settings!= NULL)
+			cjson_aux= cJSON_GetObjectItem(cjson_settings, field_name);
+		if(cjson_aux== NULL)
+			cjson_aux= cJSON_GetObjectItem(cjson_rest, field_name);
+		if(cjson_aux== NULL)
+			continue;
+
+		value_str= cJSON_PrintUnformatted(cjson_aux);
+		CHECK_DO(value_str!= NULL, goto end);
+		json_writer_raw(json_writer_ctx, field_name, value_str);
+		free(value_str);
+		value_str= NULL;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	if(value_str!= NULL)
+		free(value_str);
+	return end_code;
+}
+
+/**
+ * Write the processor statistics as a JSON object using the given JSON
+ * writer: generic statistics (see 'PROC_STATS_FIELDS') followed by the
+ * processor's specific statistics, if any (see
+ * 'proc_if_s::stats_get_stream()').
+ */
+static int procs_id_stats_get_stream(proc_ctx_t *proc_ctx,
+		log_ctx_t *log_ctx, json_writer_ctx_t *json_writer_ctx)
+{
+	const proc_if_t *proc_if;
+	int ret_code, end_code= STAT_ERROR;
+	int (*stats_get_stream)(proc_ctx_t *proc_ctx,
+			json_writer_ctx_t *json_writer_ctx)= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	//log_ctx allowed to be NULL
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+
+	/* Check that processor API critical section is locked */
+	ret_code= pthread_mutex_trylock(&proc_ctx->api_mutex);
+	CHECK_DO(ret_code== EBUSY, goto end);
+
+	/* Get required variables from PROC interface structure */
+	proc_if= proc_ctx->proc_if;
+	CHECK_DO(proc_if!= NULL, goto end);
+	stats_get_stream= proc_if->stats_get_stream;
+
+	json_writer_object_start(json_writer_ctx, NULL);
+
+	/* Generic statistics */
+	ret_code= procs_id_get_fields(proc_ctx, LOG_CTX_GET(), json_writer_ctx,
+			PROC_STATS_FIELDS);
+	if(ret_code!= STAT_SUCCESS) {
+		end_code= ret_code;
+		goto end;
+	}
+
+	/* Processor's specific statistics */
+	if(stats_get_stream!= NULL) {
+		ret_code= stats_get_stream(proc_ctx, json_writer_ctx);
+		if(ret_code!= STAT_SUCCESS) {
+			end_code= ret_code;
+			goto end;
+		}
+	}
+
+	end_code= json_writer_object_end(json_writer_ctx);
+end:
+	return end_code;
+}
+
 static void* proc_stats_thr(void *t)
 {
 	const proc_if_t *proc_if;
@@ -695,6 +1093,8 @@ static void* proc_stats_thr(void *t)
 
 	LOG_CTX_SET(proc_ctx->log_ctx);
 
+	schedule_set_thread_name("stats-%d", proc_ctx->proc_instance_index);
+
 	/* Get required variables from PROC interface structure */
 	proc_if= proc_ctx->proc_if;
 	CHECK_DO(proc_if!= NULL, goto end);
@@ -771,6 +1171,8 @@ static void* proc_thr(void *t)
 	int ret_code, *ref_end_code= NULL;
 	int (*process_frame)(proc_ctx_t*, fifo_ctx_t*, fifo_ctx_t*)= NULL;
 	fifo_ctx_t *iput_fifo_ctx= NULL, *oput_fifo_ctx= NULL;
+	uint64_t start_nsec, end_nsec, cpu_sample_nsec;
+	struct timespec ts_cpu;
 	LOG_CTX_INIT(NULL);
 
 	/* Allocate return context; initialize to a default 'ERROR' value */
@@ -783,6 +1185,9 @@ static void* proc_thr(void *t)
 
 	LOG_CTX_SET(proc_ctx->log_ctx);
 
+	schedule_set_thread_name("proc-%d-%s", proc_ctx->proc_instance_index,
+			proc_ctx->proc_if!= NULL? proc_ctx->proc_if->proc_name: "");
+
 	/* Get PROC processing callback */
 	proc_if= proc_ctx->proc_if;
 	CHECK_DO(proc_if!= NULL, goto end);
@@ -794,15 +1199,53 @@ static void* proc_thr(void *t)
 	oput_fifo_ctx= proc_ctx->fifo_ctx_array[PROC_OPUT];
 	CHECK_DO(iput_fifo_ctx!= NULL && oput_fifo_ctx!= NULL, goto end);
 
-	/* Run processing thread */
+	/* Run processing thread.
+	 * Time spent in the processing callback is accounted on each call
+	 * (see 'proc_ctx_s::acc_proc_nsec'). Only one monotonic time-stamp is
+	 * taken per call in the steady state: the end of a call is the start of
+	 * the next one. The thread CPU time is sampled periodically (see
+	 * 'PROC_THR_CPU_TIME_SAMPLE_PERIOD_USECS').
+	 */
+	start_nsec= cpu_sample_nsec= proc_stats_mono_nsec();
 	while(proc_ctx->flag_exit== 0) {
+		TRACE_EVENT("process_frame", TRACE_EVENT_BEGIN,
+				proc_ctx->proc_instance_index, proc_ctx->proc_frame_cnt, -1);
+		USDT_PROBE1(process_frame_entry, proc_ctx->proc_instance_index);
 		ret_code= process_frame(proc_ctx, iput_fifo_ctx, oput_fifo_ctx);
-		if(ret_code== STAT_EOF)
+		end_nsec= proc_stats_mono_nsec();
+		USDT_PROBE2(process_frame_exit, proc_ctx->proc_instance_index,
+				ret_code);
+		TRACE_EVENT("process_frame", TRACE_EVENT_END,
+				proc_ctx->proc_instance_index, proc_ctx->proc_frame_cnt, -1);
+
+		__atomic_add_fetch(&proc_ctx->acc_proc_nsec, end_nsec- start_nsec,
+				__ATOMIC_RELAXED);
+		if(ret_code== STAT_SUCCESS)
+			__atomic_add_fetch(&proc_ctx->proc_frame_cnt, 1, __ATOMIC_RELAXED);
+		if(end_nsec- cpu_sample_nsec>=
+				(uint64_t)PROC_THR_CPU_TIME_SAMPLE_PERIOD_USECS* 1000 &&
+				clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_cpu)== 0) {
+			__atomic_store_n(&proc_ctx->cpu_time_nsec,
+					(uint64_t)ts_cpu.tv_sec*1000000000+
+					(uint64_t)ts_cpu.tv_nsec, __ATOMIC_RELAXED);
+			cpu_sample_nsec= end_nsec;
+		}
+
+		start_nsec= end_nsec;
+		if(ret_code== STAT_EOF) {
 			proc_ctx->flag_exit= 1;
-		else if(ret_code!= STAT_SUCCESS)
+		} else if(ret_code!= STAT_SUCCESS) {
 			schedule(); // Avoid CPU-consuming closed loops
+			start_nsec= proc_stats_mono_nsec(); // Do not account yielding
+		}
 	}
 
+	/* Last CPU time sample */
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts_cpu)== 0)
+		__atomic_store_n(&proc_ctx->cpu_time_nsec,
+				(uint64_t)ts_cpu.tv_sec*1000000000+
+				(uint64_t)ts_cpu.tv_nsec, __ATOMIC_RELAXED);
+
 	*ref_end_code= STAT_SUCCESS;
 end:
 	return (void*)ref_end_code;
@@ -880,3 +1323,262 @@ static void proc_stats_register_accumulated_io_bits(proc_ctx_t *proc_ctx,
 
 	return;
 }
+
+/**
+ * Compute the processing thread CPU usage and stage-time statistics
+ * (see 'proc_ctx_s::cpu_usage') over the time elapsed since the previous
+ * computation. Statistics are computed on demand when read, at most once per
+ * statistics period (values are kept otherwise); thus, no statistics thread
+ * is needed for processors that do not use any other periodic statistics.
+ * Processor API critical section is assumed to be locked.
+ * Note that the processing callback blocks on the input FIFO (and on the
+ * output FIFO if it is full); these waiting times are taken from the FIFO's
+ * and subtracted to get the actual processing time.
+ */
+static void proc_stats_update_proc_thr(proc_ctx_t *proc_ctx)
+{
+	uint64_t mono_nsec, cpu_nsec, proc_nsec, frame_cnt;
+	uint64_t iput_wait_nsec= 0, oput_wait_nsec= 0;
+	int64_t mono_delta, cpu_delta, frame_cnt_delta, iput_wait_delta,
+			oput_wait_delta, proc_delta;
+
+	/* Note that deltas are computed in signed arithmetic: a counter sampled
+	 * lower than in the previous period (e.g. due to a clock step) yields a
+	 * negative delta that is clamped, instead of wrapping around.
+	 */
+	mono_nsec= proc_stats_mono_nsec();
+	mono_delta= (int64_t)(mono_nsec- proc_ctx->stats_prev_mono_nsec);
+	if(mono_delta< (int64_t)PROC_STATS_THR_MEASURE_PERIOD_USECS* 1000)
+		return;
+
+	cpu_nsec= __atomic_load_n(&proc_ctx->cpu_time_nsec, __ATOMIC_RELAXED);
+	proc_nsec= __atomic_load_n(&proc_ctx->acc_proc_nsec, __ATOMIC_RELAXED);
+	frame_cnt= __atomic_load_n(&proc_ctx->proc_frame_cnt, __ATOMIC_RELAXED);
+	fifo_get_wait_nsec(proc_ctx->fifo_ctx_array[PROC_IPUT], NULL,
+			&iput_wait_nsec);
+	fifo_get_wait_nsec(proc_ctx->fifo_ctx_array[PROC_OPUT], &oput_wait_nsec,
+			NULL);
+
+	cpu_delta= (int64_t)(cpu_nsec- proc_ctx->stats_prev_cpu_nsec);
+	frame_cnt_delta= (int64_t)(frame_cnt- proc_ctx->stats_prev_frame_cnt);
+	iput_wait_delta= (int64_t)(iput_wait_nsec-
+			proc_ctx->stats_prev_iput_wait_nsec);
+	oput_wait_delta= (int64_t)(oput_wait_nsec-
+			proc_ctx->stats_prev_oput_wait_nsec);
+	if(iput_wait_delta< 0)
+		iput_wait_delta= 0;
+	if(oput_wait_delta< 0)
+		oput_wait_delta= 0;
+	proc_delta= (int64_t)(proc_nsec- proc_ctx->stats_prev_proc_nsec)-
+			iput_wait_delta- oput_wait_delta;
+
+	proc_ctx->cpu_usage= cpu_delta> 0? (int)(cpu_delta* 100/ mono_delta): 0;
+	if(frame_cnt_delta> 0) {
+		proc_ctx->stage_iput_wait_usec= iput_wait_delta/ frame_cnt_delta/
+				1000;
+		proc_ctx->stage_process_usec= proc_delta> 0?
+				proc_delta/ frame_cnt_delta/ 1000: 0;
+		proc_ctx->stage_oput_wait_usec= oput_wait_delta/ frame_cnt_delta/
+				1000;
+	} else {
+		proc_ctx->stage_iput_wait_usec= 0;
+		proc_ctx->stage_process_usec= 0;
+		proc_ctx->stage_oput_wait_usec= 0;
+	}
+
+	proc_ctx->stats_prev_mono_nsec= mono_nsec;
+	proc_ctx->stats_prev_cpu_nsec= cpu_nsec;
+	proc_ctx->stats_prev_proc_nsec= proc_nsec;
+	proc_ctx->stats_prev_frame_cnt= frame_cnt;
+	proc_ctx->stats_prev_iput_wait_nsec= iput_wait_nsec;
+	proc_ctx->stats_prev_oput_wait_nsec= oput_wait_nsec;
+}
+
+/**
+ * @return Monotonic clock time, in nanoseconds.
+ */
+static uint64_t proc_stats_mono_nsec()
+{
+	struct timespec monotime_curr= {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime_curr);
+	return (uint64_t)monotime_curr.tv_sec*1000000000+
+			(uint64_t)monotime_curr.tv_nsec;
+}
+
+/**
+ * Treat the generic frames capture settings ("capture" and "capture_file")
+ * of a PUT operation (see tag "PROC_PUT"). Processor API critical section
+ * is assumed to be locked.
+ * @return STAT_ENOTFOUND if no capture action was requested; otherwise,
+ * the status code of the requested action.
+ */
+static int proc_capture_put(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		const char *str)
+{
+	int flag_is_query, i, end_code= STAT_ERROR;
+	proc_io_t proc_io;
+	proc_capture_ctx_t *proc_capture_ctx= NULL;
+	const char *proc_name= NULL;
+	char *capture_str= NULL, *capture_file_str= NULL;
+	cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+	char file_name[PROCS_HREF_MAX_LEN];
+	char path[PROC_CAPTURE_PATH_MAX];
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	if(str== NULL || strlen(str)== 0)
+		return STAT_ENOTFOUND;
+
+	/* Guess string representation format (JSON-REST or Query) and get
+	 * capture settings if any.
+	 */
+	flag_is_query= (str[0]=='{' && str[strlen(str)-1]=='}')? 0: 1;
+	if(flag_is_query== 1) {
+		capture_str= uri_parser_query_str_get_value("capture", str);
+		if(capture_str!= NULL)
+			capture_file_str= uri_parser_query_str_get_value("capture_file",
+					str);
+	} else {
+		cjson_rest= cJSON_Parse(str);
+		if(cjson_rest== NULL) {
+			end_code= STAT_ENOTFOUND; // Let the processor treat the error
+			goto end;
+		}
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "capture");
+		if(cjson_aux!= NULL && cjson_aux->valuestring!= NULL)
+			capture_str= strdup(cjson_aux->valuestring);
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "capture_file");
+		if(capture_str!= NULL && cjson_aux!= NULL &&
+				cjson_aux->valuestring!= NULL)
+			capture_file_str= strdup(cjson_aux->valuestring);
+	}
+	if(capture_str== NULL) {
+		end_code= STAT_ENOTFOUND;
+		goto end;
+	}
+
+	/* Stop capture */
+	if(strcmp(capture_str, "stop")== 0) {
+		for(i= 0; i< PROC_IO_NUM; i++)
+			proc_capture_stop(proc_ctx, LOG_CTX_GET(), (proc_io_t)i);
+		end_code= STAT_SUCCESS;
+		goto end;
+	}
+
+	/* Start (or restart) capture */
+	if(strcmp(capture_str, "input")== 0) {
+		proc_io= PROC_IPUT;
+	} else if(strcmp(capture_str, "output")== 0) {
+		proc_io= PROC_OPUT;
+	} else {
+		LOGE("Invalid 'capture' value '%s' (expected 'input', 'output' or "
+				"'stop')\n", capture_str);
+		end_code= STAT_EINVAL;
+		goto end;
+	}
+	if(capture_file_str!= NULL && strlen(capture_file_str)> 0) {
+		snprintf(file_name, sizeof(file_name), "%s", capture_file_str);
+	} else {
+		struct timespec realtime;
+		clock_gettime(CLOCK_REALTIME, &realtime);
+		snprintf(file_name, sizeof(file_name), PROC_CAPTURE_FILE_DEFAULT,
+				proc_ctx->proc_instance_index,
+				proc_io== PROC_IPUT? "iput": "oput",
+				(long long)realtime.tv_sec* 1000000+ realtime.tv_nsec/ 1000);
+	}
+	if(proc_capture_path_get(file_name, path, sizeof(path), LOG_CTX_GET())!=
+			STAT_SUCCESS) {
+		end_code= STAT_EINVAL;
+		goto end;
+	}
+	proc_capture_stop(proc_ctx, LOG_CTX_GET(), proc_io);
+	if(proc_ctx->proc_if!= NULL)
+		proc_name= proc_ctx->proc_if->proc_name;
+	proc_capture_ctx= proc_capture_open(file_name, proc_name, proc_io,
+			LOG_CTX_GET());
+	if(proc_capture_ctx== NULL) {
+		end_code= STAT_EINVAL;
+		goto end;
+	}
+	ASSERT(pthread_mutex_lock(&proc_ctx->capture_mutex)== 0);
+	proc_ctx->capture_ctx_array[proc_io]= proc_capture_ctx;
+	ASSERT(pthread_mutex_unlock(&proc_ctx->capture_mutex)== 0);
+	LOGW("Processor %d: capturing %s frames to file '%s'\n",
+			proc_ctx->proc_instance_index,
+			proc_io== PROC_IPUT? "input": "output", path);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(capture_str!= NULL)
+		free(capture_str);
+	if(capture_file_str!= NULL)
+		free(capture_file_str);
+	if(cjson_rest!= NULL)
+		cJSON_Delete(cjson_rest);
+	return end_code;
+}
+
+/**
+ * Stop frames capture on the given processor interface (if applicable),
+ * finalizing the capture file.
+ */
+static void proc_capture_stop(proc_ctx_t *proc_ctx, log_ctx_t *log_ctx,
+		const proc_io_t proc_io)
+{
+	proc_capture_ctx_t *proc_capture_ctx;
+	LOG_CTX_INIT(log_ctx);
+
+	ASSERT(pthread_mutex_lock(&proc_ctx->capture_mutex)== 0);
+	proc_capture_ctx= proc_ctx->capture_ctx_array[proc_io];
+	proc_ctx->capture_ctx_array[proc_io]= NULL;
+	ASSERT(pthread_mutex_unlock(&proc_ctx->capture_mutex)== 0);
+
+	if(proc_capture_ctx== NULL)
+		return;
+	LOGW("Processor %d: %s capture stopped (%"PRIu64" frames)\n",
+			proc_ctx->proc_instance_index,
+			proc_io== PROC_IPUT? "input": "output",
+			proc_capture_get_frames_num(proc_capture_ctx));
+	proc_capture_close(&proc_capture_ctx);
+}
+
+/**
+ * Record a frame sent to/received from the processor (frames capture is
+ * enabled on the given interface). Capture is stopped on write failure
+ * (e.g. file-system full).
+ * Note that recording is done on the calling (sending/receiving) thread,
+ * holding the capture lock: the frame is copied into the capture file
+ * buffer, which is written to the file each time it fills up (see
+ * 'proc_capture_write()'). Thus, while capturing, each frame costs a copy
+ * plus, from time to time, a blocking file write on the data path; this
+ * is acceptable for troubleshooting (captures are started on demand), but
+ * captures are not intended to be always running.
+ */
+static void proc_capture_frame(proc_ctx_t *proc_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx, const proc_io_t proc_io)
+{
+	struct timespec monotime_curr;
+	proc_capture_ctx_t *proc_capture_ctx;
+	int ret_code= STAT_SUCCESS;
+	LOG_CTX_INIT(proc_ctx->log_ctx);
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime_curr);
+
+	ASSERT(pthread_mutex_lock(&proc_ctx->capture_mutex)== 0);
+	if((proc_capture_ctx= proc_ctx->capture_ctx_array[proc_io])!= NULL) {
+		ret_code= proc_capture_write(proc_capture_ctx, proc_frame_ctx,
+				(int64_t)monotime_curr.tv_sec* 1000000+
+				monotime_curr.tv_nsec/ 1000);
+		if(ret_code!= STAT_SUCCESS)
+			proc_ctx->capture_ctx_array[proc_io]= NULL;
+	}
+	ASSERT(pthread_mutex_unlock(&proc_ctx->capture_mutex)== 0);
+
+	if(ret_code!= STAT_SUCCESS) {
+		LOGE("Processor %d: could not write capture file; capture "
+				"stopped\n", proc_ctx->proc_instance_index);
+		proc_capture_close(&proc_capture_ctx);
+	}
+}
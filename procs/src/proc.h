@@ -61,14 +61,17 @@ typedef struct fifo_ctx_s fifo_ctx_t;
 typedef struct fair_lock_s fair_lock_t;
 typedef struct proc_frame_ctx_s proc_frame_ctx_t;
 typedef struct interr_usleep_ctx_s interr_usleep_ctx_t;
+typedef struct json_writer_ctx_s json_writer_ctx_t;
+typedef struct proc_capture_ctx_s proc_capture_ctx_t;
 
 /**
  * cJSON to character string conversion function definition.
  * String can be formated or minimized (removing whitespace,
- * carriage return, ...).
+ * carriage return, ...). REST responses are mainly consumed by machine
+ * clients (e.g. monitoring polls), thus minimized output is used by default.
  */
-#define CJSON_PRINT(CJSON_PTR) 	cJSON_Print(CJSON_PTR)
-//#define CJSON_PRINT(CJSON_PTR) 	cJSON_PrintUnformatted(CJSON_PTR)
+//#define CJSON_PRINT(CJSON_PTR) 	cJSON_Print(CJSON_PTR)
+#define CJSON_PRINT(CJSON_PTR) 	cJSON_PrintUnformatted(CJSON_PTR)
 
 /**
  * Processor input-output type enumerator.
@@ -84,6 +87,24 @@ typedef enum {
  */
 #define PROCS_HREF_MAX_LEN 2048
 
+/**
+ * Generic processor statistics fields (see tag "PROC_GET_FIELDS").
+ * These are volatile values, thus, are not part of the processor
+ * representational state returned by tag "PROC_GET".
+ */
+#define PROC_STATS_FIELDS "latency_avg_usec,latency_max_usec,"\
+		"latency_min_usec,bitrate_iput,bitrate_oput,cpu_time_usec,"\
+		"cpu_usage,stage_iput_wait_usec,stage_process_usec,"\
+		"stage_oput_wait_usec"
+
+/**
+ * Default capture file name format (see generic setting "capture" at tag
+ * "PROC_PUT"); formatted with the processor Id., "iput"/"oput" and the
+ * capture start time (microseconds since the Epoch), so that restarting a
+ * capture does not collide with the previous file.
+ */
+#define PROC_CAPTURE_FILE_DEFAULT "mediaprocs_capture_%d_%s_%lld.mpcap"
+
 /**
  * Generic processor (PROC) context structure.
  */
@@ -188,6 +209,78 @@ typedef struct proc_ctx_s {
 	 * callback.
 	 */
 	const void*(*start_routine)(void *);
+	/**
+	 * JSON writer used to compose the REST representation of processors
+	 * implementing the 'proc_if_s::rest_get_stream()' callback.
+	 * It is opened on first use and kept for re-use (thus, its buffer is not
+	 * re-allocated on each request). Accessed only within the API critical
+	 * section.
+	 */
+	json_writer_ctx_t *json_writer_ctx;
+	/**
+	 * Settings version.
+	 * Set on processor opening and updated on every successful PUT (see
+	 * tag "PROC_PUT") or processor specific option (see
+	 * 'proc_if_s::opt()'). Values are unique among all the processors
+	 * instances, thus, can be used as an entity-tag of the processor
+	 * representational state.
+	 */
+	volatile uint64_t settings_version;
+	//@{
+	/**
+	 * Frame counters:
+	 * - Number of frames successfully sent to/received from the processor;
+	 * - Number of frames dropped at the processor input (input FIFO
+	 * overflow).
+	 * Updated in 'proc_send_frame()' and 'proc_recv_frame()'.
+	 */
+	volatile uint64_t frame_cnt[PROC_IO_NUM];
+	volatile uint64_t frame_drop_cnt;
+	//@}
+	//@{
+	/**
+	 * Processing thread CPU time and stage-time accounting (only applicable
+	 * to processors running the generic processing thread 'proc_thr()'):
+	 * - Accumulated CPU time consumed by the processing thread [nanoseconds]
+	 * (CLOCK_THREAD_CPUTIME_ID, sampled after a processing call at most
+	 * once every 10 milliseconds);
+	 * - Accumulated time spent in the processing callback [nanoseconds] and
+	 * number of successful processing calls (namely, processed frames).
+	 * These are updated by the processing thread;
+	 * - CPU usage of the processing thread in the last statistics period
+	 * [percentage of one CPU];
+	 * - Average time per processed frame spent blocked getting from the input
+	 * FIFO, processing (codec call), and blocked putting into the output
+	 * FIFO, in the last statistics period [microseconds];
+	 * - Sample of the counters taken at the start of the current statistics
+	 * period.
+	 * The per-period values are computed when read (see tag
+	 * "PROC_GET_FIELDS"), at most once per statistics period.
+	 */
+	volatile uint64_t cpu_time_nsec;
+	volatile uint64_t acc_proc_nsec;
+	volatile uint64_t proc_frame_cnt;
+	volatile int cpu_usage;
+	volatile int64_t stage_iput_wait_usec;
+	volatile int64_t stage_process_usec;
+	volatile int64_t stage_oput_wait_usec;
+	uint64_t stats_prev_mono_nsec;
+	uint64_t stats_prev_cpu_nsec;
+	uint64_t stats_prev_proc_nsec;
+	uint64_t stats_prev_frame_cnt;
+	uint64_t stats_prev_iput_wait_nsec;
+	uint64_t stats_prev_oput_wait_nsec;
+	//@}
+	//@{
+	/**
+	 * Frames capture related variables (see generic settings "capture" and
+	 * "capture_file" at tag "PROC_PUT"):
+	 * - Input/output capture context structures (NULL if not capturing);
+	 * - Mutual exclusion lock serializing capture start, stop and writes.
+	 */
+	proc_capture_ctx_t *volatile capture_ctx_array[PROC_IO_NUM];
+	pthread_mutex_t capture_mutex;
+	//@}
 } proc_ctx_t;
 
 /* **** Prototypes **** */
@@ -268,6 +361,9 @@ int proc_recv_frame(proc_ctx_t *proc_ctx,
  * The following options are available:
  *     -# PROC_UNBLOCK
  *     -# PROC_GET
+ *     -# PROC_GET_JSON_WRITER
+ *     -# PROC_GET_FIELDS
+ *     -# PROC_GET_STATS_JSON_WRITER
  *     -# PROC_PUT
  *     .
  * @param ... Variable list of parameters according to selected option. Refer
@@ -284,7 +380,8 @@ int proc_recv_frame(proc_ctx_t *proc_ctx,
  * proc_opt() with this tag.
  *
  * Tag "PROC_GET":</b> <br>
- * Get processor representational state (including current settings).<br>
+ * Get processor representational state (including current settings).
+ * Volatile statistics are not included (refer to 'PROC_STATS_FIELDS').<br>
  * Additional variable arguments for function proc_opt() are:<br>
  * @param rest_fmt Indicates the format in which the response data is to
  * be returned. Available formats are enumerated at 'proc_if_rest_fmt_t'.
@@ -293,8 +390,56 @@ int proc_recv_frame(proc_ctx_t *proc_ctx,
  * The returned data structure is formatted according to what is
  * indicated in the parameter 'rest_fmt'.
  *
+ * Tag "PROC_GET_JSON_WRITER":</b> <br>
+ * Write processor representational state (as a JSON object) using the given
+ * JSON writer. Processors not implementing 'proc_if_s::rest_get_stream()'
+ * are supported by copying the printed cJSON representation.<br>
+ * Additional variable arguments for function proc_opt() are:<br>
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * The representation is written as the next value in the writer (i.e. the
+ * caller may write it at the root level or within an array).
+ *
+ * Tag "PROC_GET_FIELDS":</b> <br>
+ * Write only the selected fields of the processor representational state,
+ * as members of the JSON object currently open in the given JSON writer.
+ * Generic statistics "latency_avg_usec", "latency_max_usec",
+ * "latency_min_usec", "bitrate_iput" and "bitrate_oput" are written
+ * without composing the processor's representation (if supported by the
+ * processor features). The same applies to the processing thread CPU and
+ * stage-time statistics "cpu_time_usec", "cpu_usage",
+ * "stage_iput_wait_usec", "stage_process_usec" and "stage_oput_wait_usec"
+ * (if the processor implements 'proc_if_s::process_frame()'). Any other field is looked up in the processor's
+ * "settings" or at the top level of its representation. Fields not found
+ * are skipped.<br>
+ * Additional variable arguments for function proc_opt() are:<br>
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param fields_str Comma-separated list of field names
+ * (e.g. "latency_avg_usec,bit_rate_output").
+ *
+ * Tag "PROC_GET_STATS_JSON_WRITER":</b> <br>
+ * Write the processor statistics (as a JSON object) using the given JSON
+ * writer: the generic statistics (see 'PROC_STATS_FIELDS') followed by the
+ * processor specific ones (see 'proc_if_s::stats_get_stream()').<br>
+ * Additional variable arguments for function proc_opt() are:<br>
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ *
  * Tag "PROC_PUT":</b> <br>
- * Put (pass) new settings to processor.<br>
+ * Put (pass) new settings to processor. On success, the processor
+ * settings version is updated (see 'proc_ctx_s::settings_version').<br>
+ * The following generic settings are treated by this module (for any type
+ * of processor) once the processor accepted the settings (if the processor
+ * rejects them, no capture is started nor stopped):
+ * - "capture": start recording the frames sent to ("input") or received
+ * from ("output") the processor, or stop recording ("stop"). Starting a
+ * capture that is already running restarts it in a new file;
+ * - "capture_file": capture file name, relative to the capture directory
+ * (see tag "PROCS_SET_CAPTURE_DIR" at .procs.h); it can not contain '/'
+ * nor ".." and the file must not exist (default is
+ * 'PROC_CAPTURE_FILE_DEFAULT'). Refer to .proc_capture.h for the file
+ * format. Frames are recorded on the thread sending (input) or receiving
+ * (output) them, adding a copy of each frame and blocking file writes to
+ * the data path while capturing.
+ * .
  * Additional variable arguments for function proc_opt() are:<br>
  * @param str Pointer to a character string containing new settings for
  * the processor. String format can be either a query-string or JSON.
@@ -0,0 +1,722 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file proc_capture.c
+ * @author Rafael Antoniello
+ */
+
+#include "proc_capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+
+#include "proc_if.h"
+
+/* **** Definitions **** */
+
+_Static_assert(sizeof(proc_capture_hdr_t)== 128, "Capture header size");
+_Static_assert(sizeof(proc_capture_rec_t)== 256, "Capture record size");
+_Static_assert(PROC_FRAME_NUM_DATA_POINTERS== 8, "Capture planes number");
+
+/**
+ * Align given offset to 'PROC_CAPTURE_ALIGN' bytes.
+ */
+#define CAPTURE_ALIGN(OFFSET) \
+	(((OFFSET)+ PROC_CAPTURE_ALIGN- 1)& ~((uint64_t)PROC_CAPTURE_ALIGN- 1))
+
+/**
+ * Capture file write buffer size, in bytes.
+ */
+#define CAPTURE_FILE_BUF_SIZE (1024* 1024)
+
+/**
+ * Initial size, in number of entries, of the in-memory records index.
+ */
+#define CAPTURE_INDEX_SIZE_INIT 1024
+
+/**
+ * Capture (recording) context structure.
+ */
+typedef struct proc_capture_ctx_s {
+	FILE *file;
+	/**
+	 * File write buffer (see 'CAPTURE_FILE_BUF_SIZE').
+	 */
+	char *file_buf;
+	/**
+	 * Current file write offset.
+	 */
+	uint64_t offset;
+	/**
+	 * Records index (grown by doubling its size when full).
+	 */
+	uint64_t *index;
+	uint64_t index_size;
+	uint64_t frames_num;
+	/**
+	 * Arrival time of the first recorded frame (monotonic clock,
+	 * microseconds); negative if no frame was recorded yet.
+	 */
+	int64_t arrival_usecs_first;
+	proc_capture_hdr_t hdr;
+	log_ctx_t *log_ctx;
+} proc_capture_ctx_t;
+
+/**
+ * Replay context structure.
+ */
+typedef struct proc_capture_replay_ctx_s {
+	/**
+	 * Mapped file.
+	 */
+	const uint8_t *map;
+	size_t map_size;
+	/**
+	 * Records index. Refers to the mapped file, or to 'index_alloc' if the
+	 * index had to be rebuilt.
+	 */
+	const uint64_t *index;
+	uint64_t *index_alloc;
+	uint64_t frames_num;
+	log_ctx_t *log_ctx;
+} proc_capture_replay_ctx_t;
+
+/**
+ * Capture directory (see 'proc_capture_dir_set()').
+ */
+static char capture_dir[PROC_CAPTURE_PATH_MAX]= PROC_CAPTURE_DIR_DEFAULT;
+static pthread_mutex_t capture_dir_mutex= PTHREAD_MUTEX_INITIALIZER;
+
+/* **** Prototypes **** */
+
+static int capture_dir_open(const char *dir_name, int flag_create,
+		log_ctx_t *log_ctx);
+static int capture_write_padding(proc_capture_ctx_t *proc_capture_ctx,
+		uint64_t offset);
+static int replay_check_rec(proc_capture_replay_ctx_t *proc_capture_replay_ctx,
+		uint64_t rec_offset, uint64_t size_max);
+static int replay_index_rebuild(
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx);
+
+/* **** Implementations **** */
+
+int proc_capture_dir_set(const char *dir_name)
+{
+	LOG_CTX_INIT(NULL);
+
+	if(dir_name== NULL)
+		dir_name= PROC_CAPTURE_DIR_DEFAULT;
+	if(dir_name[0]!= '/' || strlen(dir_name)>= sizeof(capture_dir)) {
+		LOGE("Invalid capture directory '%s' (an absolute path is "
+				"expected)\n", dir_name);
+		return STAT_EINVAL;
+	}
+
+	ASSERT(pthread_mutex_lock(&capture_dir_mutex)== 0);
+	snprintf(capture_dir, sizeof(capture_dir), "%s", dir_name);
+	ASSERT(pthread_mutex_unlock(&capture_dir_mutex)== 0);
+	return STAT_SUCCESS;
+}
+
+int proc_capture_path_get(const char *file_name, char *path,
+		size_t path_size, log_ctx_t *log_ctx)
+{
+	int ret_code;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(path!= NULL && path_size> 0, return STAT_ERROR);
+	// Parameter 'log_ctx' is allowed to be NULL
+
+	/* File name must refer to a file within the capture directory */
+	if(file_name== NULL || strlen(file_name)== 0 ||
+			strcmp(file_name, ".")== 0 || strchr(file_name, '/')!= NULL ||
+			strstr(file_name, "..")!= NULL) {
+		LOGE("Invalid capture file name '%s' (a file name within the "
+				"capture directory is expected)\n",
+				file_name!= NULL? file_name: "");
+		return STAT_EINVAL;
+	}
+
+	ASSERT(pthread_mutex_lock(&capture_dir_mutex)== 0);
+	ret_code= snprintf(path, path_size, "%s/%s", capture_dir, file_name);
+	ASSERT(pthread_mutex_unlock(&capture_dir_mutex)== 0);
+	if(ret_code< 0 || (size_t)ret_code>= path_size) {
+		LOGE("Capture file name '%s' is too long\n", file_name);
+		return STAT_EINVAL;
+	}
+	return STAT_SUCCESS;
+}
+
+proc_capture_ctx_t* proc_capture_open(const char *file_name,
+		const char *proc_name, int proc_io, log_ctx_t *log_ctx)
+{
+	struct timeval tv;
+	char path[PROC_CAPTURE_PATH_MAX];
+	char *dir_end;
+	int fd, dir_fd= -1, ret_code, end_code= STAT_ERROR;
+	proc_capture_ctx_t *proc_capture_ctx= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	// Parameter 'file_name' is checked below
+	// Parameter 'proc_name' is allowed to be NULL
+	// Parameter 'log_ctx' is allowed to be NULL
+
+	/* Get file path in the capture directory */
+	if(proc_capture_path_get(file_name, path, sizeof(path), LOG_CTX_GET())!=
+			STAT_SUCCESS)
+		return NULL;
+
+	/* Allocate context structure */
+	proc_capture_ctx= (proc_capture_ctx_t*)calloc(1, sizeof(
+			proc_capture_ctx_t));
+	CHECK_DO(proc_capture_ctx!= NULL, goto end);
+	proc_capture_ctx->log_ctx= LOG_CTX_GET();
+	proc_capture_ctx->arrival_usecs_first= -1;
+
+	/* Allocate records index */
+	proc_capture_ctx->index= (uint64_t*)malloc(CAPTURE_INDEX_SIZE_INIT*
+			sizeof(uint64_t));
+	CHECK_DO(proc_capture_ctx->index!= NULL, goto end);
+	proc_capture_ctx->index_size= CAPTURE_INDEX_SIZE_INIT;
+
+	/* Open (create if applicable) capture directory */
+	dir_end= strrchr(path, '/');
+	*dir_end= '\0';
+	dir_fd= capture_dir_open(path, 1, LOG_CTX_GET());
+	*dir_end= '/';
+	if(dir_fd< 0)
+		goto end;
+
+	/* Create file (an existing file is never overwritten) and set a large
+	 * write buffer (records are written by pieces: header and planes line
+	 * by line).
+	 */
+	fd= openat(dir_fd, dir_end+ 1, O_WRONLY| O_CREAT| O_EXCL| O_NOFOLLOW|
+			O_CLOEXEC, 0600);
+	if(fd< 0) {
+		LOGE("Could not create capture file '%s'%s\n", path,
+				errno== EEXIST? " (file exists)": "");
+		goto end;
+	}
+	proc_capture_ctx->file= fdopen(fd, "wb");
+	if(proc_capture_ctx->file== NULL) {
+		close(fd);
+		LOGE("Could not open capture file '%s'\n", path);
+		goto end;
+	}
+	proc_capture_ctx->file_buf= (char*)malloc(CAPTURE_FILE_BUF_SIZE);
+	CHECK_DO(proc_capture_ctx->file_buf!= NULL, goto end);
+	ret_code= setvbuf(proc_capture_ctx->file, proc_capture_ctx->file_buf,
+			_IOFBF, CAPTURE_FILE_BUF_SIZE);
+	CHECK_DO(ret_code== 0, goto end);
+
+	/* Write header (index is not available until the capture is closed) */
+	memcpy(proc_capture_ctx->hdr.magic, PROC_CAPTURE_MAGIC,
+			sizeof(proc_capture_ctx->hdr.magic));
+	proc_capture_ctx->hdr.version= PROC_CAPTURE_VERSION;
+	proc_capture_ctx->hdr.hdr_size= sizeof(proc_capture_hdr_t);
+	gettimeofday(&tv, NULL);
+	proc_capture_ctx->hdr.time_start_usecs= (int64_t)tv.tv_sec* 1000000+
+			tv.tv_usec;
+	proc_capture_ctx->hdr.proc_io= proc_io;
+	if(proc_name!= NULL)
+		snprintf(proc_capture_ctx->hdr.proc_name,
+				sizeof(proc_capture_ctx->hdr.proc_name), "%s", proc_name);
+	ret_code= fwrite(&proc_capture_ctx->hdr, sizeof(proc_capture_hdr_t), 1,
+			proc_capture_ctx->file);
+	CHECK_DO(ret_code== 1, goto end);
+	proc_capture_ctx->offset= sizeof(proc_capture_hdr_t);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(dir_fd>= 0)
+		close(dir_fd);
+	if(end_code!= STAT_SUCCESS)
+		proc_capture_close(&proc_capture_ctx);
+	return proc_capture_ctx;
+}
+
+void proc_capture_close(proc_capture_ctx_t **ref_proc_capture_ctx)
+{
+	proc_capture_ctx_t *proc_capture_ctx;
+	int ret_code;
+	LOG_CTX_INIT(NULL);
+
+	if(ref_proc_capture_ctx== NULL ||
+			(proc_capture_ctx= *ref_proc_capture_ctx)== NULL)
+		return;
+
+	LOG_CTX_SET(proc_capture_ctx->log_ctx);
+
+	/* Write records index and update header */
+	if(proc_capture_ctx->file!= NULL && proc_capture_ctx->index!= NULL) {
+		uint64_t index_offset= CAPTURE_ALIGN(proc_capture_ctx->offset);
+		uint64_t frames_num= proc_capture_ctx->frames_num;
+
+		ret_code= capture_write_padding(proc_capture_ctx, index_offset);
+		if(ret_code== STAT_SUCCESS && frames_num> 0)
+			ret_code= fwrite(proc_capture_ctx->index, sizeof(uint64_t),
+					frames_num, proc_capture_ctx->file)== frames_num?
+							STAT_SUCCESS: STAT_ERROR;
+		if(ret_code== STAT_SUCCESS) {
+			proc_capture_ctx->hdr.index_offset= index_offset;
+			proc_capture_ctx->hdr.frames_num= frames_num;
+			ret_code= fseek(proc_capture_ctx->file, 0, SEEK_SET)== 0 &&
+					fwrite(&proc_capture_ctx->hdr, sizeof(proc_capture_hdr_t),
+							1, proc_capture_ctx->file)== 1?
+									STAT_SUCCESS: STAT_ERROR;
+		}
+		if(ret_code!= STAT_SUCCESS)
+			LOGE("Could not write capture file index\n");
+	}
+
+	if(proc_capture_ctx->file!= NULL) {
+		ASSERT(fclose(proc_capture_ctx->file)== 0);
+		proc_capture_ctx->file= NULL;
+	}
+	if(proc_capture_ctx->file_buf!= NULL) {
+		free(proc_capture_ctx->file_buf);
+		proc_capture_ctx->file_buf= NULL;
+	}
+	if(proc_capture_ctx->index!= NULL) {
+		free(proc_capture_ctx->index);
+		proc_capture_ctx->index= NULL;
+	}
+
+	free(proc_capture_ctx);
+	*ref_proc_capture_ctx= NULL;
+}
+
+int proc_capture_write(proc_capture_ctx_t *proc_capture_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx, int64_t arrival_usecs)
+{
+	proc_capture_rec_t rec;
+	uint64_t rec_offset, plane_offset;
+	int i;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_capture_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_frame_ctx!= NULL, return STAT_ERROR);
+
+	LOG_CTX_SET(proc_capture_ctx->log_ctx);
+	CHECK_DO(proc_capture_ctx->file!= NULL, return STAT_ERROR);
+
+	/* Grow index if applicable */
+	if(proc_capture_ctx->frames_num== proc_capture_ctx->index_size) {
+		uint64_t *index= (uint64_t*)realloc(proc_capture_ctx->index,
+				2* proc_capture_ctx->index_size* sizeof(uint64_t));
+		CHECK_DO(index!= NULL, return STAT_ENOMEM);
+		proc_capture_ctx->index= index;
+		proc_capture_ctx->index_size*= 2;
+	}
+
+	/* Compose record header (planes are stored without line padding) */
+	if(proc_capture_ctx->arrival_usecs_first< 0)
+		proc_capture_ctx->arrival_usecs_first= arrival_usecs;
+	memset(&rec, 0, sizeof(rec));
+	rec.magic= PROC_CAPTURE_REC_MAGIC;
+	rec.arrival_usecs= arrival_usecs- proc_capture_ctx->arrival_usecs_first;
+	rec.pts= proc_frame_ctx->pts;
+	rec.dts= proc_frame_ctx->dts;
+	rec.es_id= proc_frame_ctx->es_id;
+	rec.proc_sample_fmt= proc_frame_ctx->proc_sample_fmt;
+	rec.proc_sampling_rate= proc_frame_ctx->proc_sampling_rate;
+	plane_offset= sizeof(proc_capture_rec_t);
+	for(i= 0; i< PROC_FRAME_NUM_DATA_POINTERS; i++) {
+		size_t width= proc_frame_ctx->width[i];
+		size_t height= proc_frame_ctx->height[i];
+
+		if(proc_frame_ctx->p_data[i]== NULL || width== 0 || height== 0)
+			continue;
+		CHECK_DO(width<= UINT32_MAX && height<= UINT32_MAX &&
+				(height== 1 || (size_t)proc_frame_ctx->linesize[i]>= width),
+				return STAT_ERROR);
+		rec.planes[i].offset= plane_offset;
+		rec.planes[i].linesize= (int32_t)width;
+		rec.planes[i].width= (uint32_t)width;
+		rec.planes[i].height= (uint32_t)height;
+		plane_offset= CAPTURE_ALIGN(plane_offset+ (uint64_t)width* height);
+	}
+	rec.size= plane_offset;
+
+	/* Write record (header and planes, line by line) */
+	rec_offset= proc_capture_ctx->offset;
+	CHECK_DO(fwrite(&rec, sizeof(rec), 1, proc_capture_ctx->file)== 1,
+			return STAT_ERROR);
+	proc_capture_ctx->offset+= sizeof(rec);
+	for(i= 0; i< PROC_FRAME_NUM_DATA_POINTERS; i++) {
+		const uint8_t *p_data= proc_frame_ctx->p_data[i];
+		size_t width= rec.planes[i].width, l;
+
+		if(rec.planes[i].offset== 0)
+			continue;
+		if(capture_write_padding(proc_capture_ctx, rec_offset+
+				rec.planes[i].offset)!= STAT_SUCCESS)
+			return STAT_ERROR;
+		if(proc_frame_ctx->linesize[i]== (int)width) {
+			l= (size_t)rec.planes[i].height* width;
+			CHECK_DO(fwrite(p_data, 1, l, proc_capture_ctx->file)== l,
+					return STAT_ERROR);
+			proc_capture_ctx->offset+= l;
+			continue;
+		}
+		for(l= 0; l< rec.planes[i].height; l++) {
+			CHECK_DO(fwrite(p_data, 1, width, proc_capture_ctx->file)== width,
+					return STAT_ERROR);
+			p_data+= proc_frame_ctx->linesize[i];
+			proc_capture_ctx->offset+= width;
+		}
+	}
+	if(capture_write_padding(proc_capture_ctx, rec_offset+ rec.size)!=
+			STAT_SUCCESS)
+		return STAT_ERROR;
+
+	/* Register record in index */
+	proc_capture_ctx->index[proc_capture_ctx->frames_num++]= rec_offset;
+	return STAT_SUCCESS;
+}
+
+uint64_t proc_capture_get_frames_num(proc_capture_ctx_t *proc_capture_ctx)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_capture_ctx!= NULL, return 0);
+
+	return proc_capture_ctx->frames_num;
+}
+
+proc_capture_replay_ctx_t* proc_capture_replay_open(const char *file_name,
+		log_ctx_t *log_ctx)
+{
+	struct stat st;
+	const proc_capture_hdr_t *hdr;
+	void *map;
+	char path[PROC_CAPTURE_PATH_MAX];
+	char *dir_end;
+	int fd= -1, dir_fd= -1, end_code= STAT_ERROR;
+	proc_capture_replay_ctx_t *proc_capture_replay_ctx= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	// Parameter 'file_name' is checked below
+	// Parameter 'log_ctx' is allowed to be NULL
+
+	/* Get file path in the capture directory */
+	if(proc_capture_path_get(file_name, path, sizeof(path), LOG_CTX_GET())!=
+			STAT_SUCCESS)
+		return NULL;
+
+	/* Allocate context structure */
+	proc_capture_replay_ctx= (proc_capture_replay_ctx_t*)calloc(1, sizeof(
+			proc_capture_replay_ctx_t));
+	CHECK_DO(proc_capture_replay_ctx!= NULL, goto end);
+	proc_capture_replay_ctx->log_ctx= LOG_CTX_GET();
+
+	/* Open capture directory */
+	dir_end= strrchr(path, '/');
+	*dir_end= '\0';
+	dir_fd= capture_dir_open(path, 0, LOG_CTX_GET());
+	*dir_end= '/';
+	if(dir_fd< 0)
+		goto end;
+
+	/* Map file (read-only) */
+	fd= openat(dir_fd, dir_end+ 1, O_RDONLY| O_NOFOLLOW| O_CLOEXEC);
+	if(fd< 0) {
+		LOGE("Could not open capture file '%s'\n", path);
+		goto end;
+	}
+	CHECK_DO(fstat(fd, &st)== 0, goto end);
+	if((uint64_t)st.st_size< sizeof(proc_capture_hdr_t)) {
+		LOGE("Invalid capture file '%s'\n", file_name);
+		goto end;
+	}
+	map= mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	CHECK_DO(map!= MAP_FAILED, goto end);
+	proc_capture_replay_ctx->map= (const uint8_t*)map;
+	proc_capture_replay_ctx->map_size= (size_t)st.st_size;
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	/* Check header */
+	hdr= (const proc_capture_hdr_t*)proc_capture_replay_ctx->map;
+	if(memcmp(hdr->magic, PROC_CAPTURE_MAGIC, sizeof(hdr->magic))!= 0 ||
+			hdr->version!= PROC_CAPTURE_VERSION ||
+			hdr->hdr_size< sizeof(proc_capture_hdr_t) ||
+			hdr->hdr_size> proc_capture_replay_ctx->map_size) {
+		LOGE("Invalid capture file '%s'\n", file_name);
+		goto end;
+	}
+
+	/* Use the file index in place if available; rebuild it otherwise */
+	if(hdr->index_offset!= 0 && hdr->index_offset% sizeof(uint64_t)== 0 &&
+			hdr->index_offset<= proc_capture_replay_ctx->map_size &&
+			hdr->frames_num<= (proc_capture_replay_ctx->map_size-
+					hdr->index_offset)/ sizeof(uint64_t)) {
+		proc_capture_replay_ctx->index= (const uint64_t*)
+				(proc_capture_replay_ctx->map+ hdr->index_offset);
+		proc_capture_replay_ctx->frames_num= hdr->frames_num;
+	} else {
+		LOGW("Capture file '%s' was not finalized; rebuilding index\n",
+				file_name);
+		CHECK_DO(replay_index_rebuild(proc_capture_replay_ctx)==
+				STAT_SUCCESS, goto end);
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(fd>= 0)
+		close(fd);
+	if(dir_fd>= 0)
+		close(dir_fd);
+	if(end_code!= STAT_SUCCESS)
+		proc_capture_replay_close(&proc_capture_replay_ctx);
+	return proc_capture_replay_ctx;
+}
+
+void proc_capture_replay_close(
+		proc_capture_replay_ctx_t **ref_proc_capture_replay_ctx)
+{
+	proc_capture_replay_ctx_t *proc_capture_replay_ctx;
+
+	if(ref_proc_capture_replay_ctx== NULL ||
+			(proc_capture_replay_ctx= *ref_proc_capture_replay_ctx)== NULL)
+		return;
+
+	if(proc_capture_replay_ctx->map!= NULL) {
+		munmap((void*)proc_capture_replay_ctx->map,
+				proc_capture_replay_ctx->map_size);
+		proc_capture_replay_ctx->map= NULL;
+	}
+	if(proc_capture_replay_ctx->index_alloc!= NULL) {
+		free(proc_capture_replay_ctx->index_alloc);
+		proc_capture_replay_ctx->index_alloc= NULL;
+	}
+
+	free(proc_capture_replay_ctx);
+	*ref_proc_capture_replay_ctx= NULL;
+}
+
+uint64_t proc_capture_replay_get_frames_num(
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_capture_replay_ctx!= NULL, return 0);
+
+	return proc_capture_replay_ctx->frames_num;
+}
+
+int proc_capture_replay_get_frame(
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx, uint64_t idx,
+		proc_frame_ctx_t *proc_frame_ctx, int64_t *ref_arrival_usecs)
+{
+	const proc_capture_rec_t *rec;
+	uint64_t rec_offset;
+	int i;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(proc_capture_replay_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_frame_ctx!= NULL, return STAT_ERROR);
+	// Parameter 'ref_arrival_usecs' is allowed to be NULL
+
+	LOG_CTX_SET(proc_capture_replay_ctx->log_ctx);
+
+	if(idx>= proc_capture_replay_ctx->frames_num)
+		return STAT_EOF;
+
+	/* Get and check record */
+	rec_offset= proc_capture_replay_ctx->index[idx];
+	CHECK_DO(replay_check_rec(proc_capture_replay_ctx, rec_offset,
+			proc_capture_replay_ctx->map_size)== STAT_SUCCESS,
+			return STAT_ERROR);
+	rec= (const proc_capture_rec_t*)(proc_capture_replay_ctx->map+
+			rec_offset);
+
+	/* Fill frame (data planes refer to the mapped file) */
+	memset(proc_frame_ctx, 0, sizeof(proc_frame_ctx_t));
+	for(i= 0; i< PROC_FRAME_NUM_DATA_POINTERS; i++) {
+		if(rec->planes[i].offset== 0)
+			continue;
+		proc_frame_ctx->p_data[i]= proc_capture_replay_ctx->map+ rec_offset+
+				rec->planes[i].offset;
+		proc_frame_ctx->linesize[i]= rec->planes[i].linesize;
+		proc_frame_ctx->width[i]= rec->planes[i].width;
+		proc_frame_ctx->height[i]= rec->planes[i].height;
+	}
+	proc_frame_ctx->proc_sample_fmt= rec->proc_sample_fmt;
+	proc_frame_ctx->proc_sampling_rate= rec->proc_sampling_rate;
+	proc_frame_ctx->pts= rec->pts;
+	proc_frame_ctx->dts= rec->dts;
+	proc_frame_ctx->es_id= rec->es_id;
+	if(ref_arrival_usecs!= NULL)
+		*ref_arrival_usecs= rec->arrival_usecs;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Open the capture directory, creating it first if applicable.
+ * The directory may live in a location writable by other users (e.g. the
+ * default one, in "/tmp"), thus it is only accepted if it is not a
+ * symbolic link, it is owned by the effective user and it is not writable
+ * by group or others. Capture files are then opened relative to the
+ * returned descriptor, so the directory can not be replaced once checked.
+ * @return Directory file descriptor, or -1 on failure.
+ */
+static int capture_dir_open(const char *dir_name, int flag_create,
+		log_ctx_t *log_ctx)
+{
+	struct stat st;
+	int dir_fd;
+	LOG_CTX_INIT(log_ctx);
+
+	if(flag_create!= 0 && mkdir(dir_name, 0700)!= 0 && errno!= EEXIST) {
+		LOGE("Could not create capture directory '%s'\n", dir_name);
+		return -1;
+	}
+
+	dir_fd= open(dir_name, O_RDONLY| O_DIRECTORY| O_NOFOLLOW| O_CLOEXEC);
+	if(dir_fd< 0) {
+		LOGE("Could not open capture directory '%s' (a directory, not a "
+				"symbolic link, is expected)\n", dir_name);
+		return -1;
+	}
+	if(fstat(dir_fd, &st)!= 0 || !S_ISDIR(st.st_mode) ||
+			st.st_uid!= geteuid() || (st.st_mode& (S_IWGRP| S_IWOTH))!= 0) {
+		LOGE("Capture directory '%s' must be owned by the current user and "
+				"not be writable by others\n", dir_name);
+		close(dir_fd);
+		return -1;
+	}
+	return dir_fd;
+}
+
+/**
+ * Write zero padding up to the given file offset.
+ */
+static int capture_write_padding(proc_capture_ctx_t *proc_capture_ctx,
+		uint64_t offset)
+{
+	static const uint8_t zeros[PROC_CAPTURE_ALIGN]= {0};
+	size_t padding_size;
+	LOG_CTX_INIT(proc_capture_ctx->log_ctx);
+
+	CHECK_DO(offset>= proc_capture_ctx->offset &&
+			offset- proc_capture_ctx->offset<= PROC_CAPTURE_ALIGN,
+			return STAT_ERROR);
+	padding_size= (size_t)(offset- proc_capture_ctx->offset);
+	if(padding_size> 0 && fwrite(zeros, 1, padding_size,
+			proc_capture_ctx->file)!= padding_size)
+		return STAT_ERROR;
+	proc_capture_ctx->offset= offset;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Check that a frame record (header and planes) is within the first
+ * 'size_max' bytes of the mapped file.
+ */
+static int replay_check_rec(proc_capture_replay_ctx_t *proc_capture_replay_ctx,
+		uint64_t rec_offset, uint64_t size_max)
+{
+	const proc_capture_rec_t *rec;
+	int i;
+
+	if(rec_offset% PROC_CAPTURE_ALIGN!= 0 || rec_offset> size_max ||
+			size_max- rec_offset< sizeof(proc_capture_rec_t))
+		return STAT_ERROR;
+	rec= (const proc_capture_rec_t*)(proc_capture_replay_ctx->map+
+			rec_offset);
+	if(rec->magic!= PROC_CAPTURE_REC_MAGIC ||
+			rec->size< sizeof(proc_capture_rec_t) ||
+			rec->size> size_max- rec_offset)
+		return STAT_ERROR;
+	for(i= 0; i< PROC_FRAME_NUM_DATA_POINTERS; i++) {
+		uint64_t offset= rec->planes[i].offset;
+
+		if(offset== 0)
+			continue;
+		if(offset< sizeof(proc_capture_rec_t) || offset> rec->size ||
+				rec->planes[i].linesize!= (int32_t)rec->planes[i].width ||
+				(uint64_t)rec->planes[i].width* rec->planes[i].height>
+						rec->size- offset)
+			return STAT_ERROR;
+	}
+	return STAT_SUCCESS;
+}
+
+/**
+ * Rebuild the records index by scanning the file (used if the capture was
+ * not properly closed). Scanning stops at the first incomplete or invalid
+ * record.
+ */
+static int replay_index_rebuild(
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx)
+{
+	const proc_capture_hdr_t *hdr;
+	uint64_t offset, frames_num, size_max;
+	uint64_t *index;
+	LOG_CTX_INIT(proc_capture_replay_ctx->log_ctx);
+
+	hdr= (const proc_capture_hdr_t*)proc_capture_replay_ctx->map;
+	size_max= proc_capture_replay_ctx->map_size;
+
+	/* Count records */
+	frames_num= 0;
+	for(offset= CAPTURE_ALIGN(hdr->hdr_size); replay_check_rec(
+			proc_capture_replay_ctx, offset, size_max)== STAT_SUCCESS;
+			offset+= ((const proc_capture_rec_t*)
+					(proc_capture_replay_ctx->map+ offset))->size)
+		frames_num++;
+
+	/* Fill index */
+	index= (uint64_t*)malloc((frames_num> 0? frames_num: 1)*
+			sizeof(uint64_t));
+	CHECK_DO(index!= NULL, return STAT_ENOMEM);
+	frames_num= 0;
+	for(offset= CAPTURE_ALIGN(hdr->hdr_size); replay_check_rec(
+			proc_capture_replay_ctx, offset, size_max)== STAT_SUCCESS;
+			offset+= ((const proc_capture_rec_t*)
+					(proc_capture_replay_ctx->map+ offset))->size)
+		index[frames_num++]= offset;
+
+	proc_capture_replay_ctx->index_alloc= index;
+	proc_capture_replay_ctx->index= index;
+	proc_capture_replay_ctx->frames_num= frames_num;
+	return STAT_SUCCESS;
+}
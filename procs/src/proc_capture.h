@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file proc_capture.h
+ * @brief Processor frames capture and replay file module.
+ * Records a stream of processor frames (data planes, geometry, time-stamps,
+ * elementary stream Id. and arrival times) into a file, and gives read
+ * access to a recorded file by memory-mapping it (so frames can be replayed
+ * without copying or allocating memory per frame).
+ *
+ * File layout (all the integers in host byte order):
+ * - File header ('proc_capture_hdr_t');
+ * - Frame records, each one starting at a 'PROC_CAPTURE_ALIGN' aligned
+ * offset: record header ('proc_capture_rec_t') followed by the data planes
+ * (each plane is stored without line padding, starting at an aligned
+ * offset);
+ * - Index: array of 'frames_num' 64-bit record offsets (written when the
+ * capture is closed). If the capture was not properly closed (e.g. the
+ * application crashed), the index is rebuilt when the file is opened for
+ * replay by scanning the records.
+ *
+ * Capture files are only created in, and replayed from, the capture
+ * directory (see 'PROC_CAPTURE_DIR_DEFAULT' and 'proc_capture_dir_set()');
+ * file names are given relative to this directory and can not contain '/'
+ * nor "..". Existing files are never overwritten.
+ * The capture directory must be owned by the effective user, not be a
+ * symbolic link and not be writable by group or others (otherwise, captures
+ * and replays fail); symbolic links are not followed for capture files.
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_SRC_PROC_CAPTURE_H_
+#define MEDIAPROCESSORS_SRC_PROC_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* **** Definitions **** */
+
+/* Forward definitions */
+typedef struct log_ctx_s log_ctx_t;
+typedef struct proc_frame_ctx_s proc_frame_ctx_t;
+typedef struct proc_capture_ctx_s proc_capture_ctx_t;
+typedef struct proc_capture_replay_ctx_s proc_capture_replay_ctx_t;
+
+/**
+ * Default capture directory (can be overridden at build time by defining
+ * this macro, or at start-up by 'proc_capture_dir_set()').
+ */
+#ifndef PROC_CAPTURE_DIR_DEFAULT
+#define PROC_CAPTURE_DIR_DEFAULT "/tmp/mediaprocs_captures"
+#endif
+
+/**
+ * Maximum length of a capture file path (directory plus file name).
+ */
+#define PROC_CAPTURE_PATH_MAX 1024
+
+/**
+ * Capture file magic string (the last character codes the format version).
+ */
+#define PROC_CAPTURE_MAGIC "MPCAPT\0\1"
+
+/**
+ * Capture file format version.
+ */
+#define PROC_CAPTURE_VERSION 1
+
+/**
+ * Frame record magic number ("FRAM").
+ */
+#define PROC_CAPTURE_REC_MAGIC 0x4D415246
+
+/**
+ * Alignment, in bytes, of the frame records and data planes in the file.
+ */
+#define PROC_CAPTURE_ALIGN 64
+
+/**
+ * Capture file header.
+ */
+typedef struct proc_capture_hdr_s {
+	char magic[8];
+	uint32_t version;
+	/**
+	 * Header size in bytes (offset of the first frame record).
+	 */
+	uint32_t hdr_size;
+	/**
+	 * Offset of the records index (zero if the capture was not properly
+	 * closed).
+	 */
+	uint64_t index_offset;
+	/**
+	 * Number of recorded frames (valid if 'index_offset' is non-zero).
+	 */
+	uint64_t frames_num;
+	/**
+	 * Real-time clock at capture start, in microseconds since the Epoch.
+	 */
+	int64_t time_start_usecs;
+	/**
+	 * Captured processor interface: input (0) or output (1).
+	 */
+	int32_t proc_io;
+	uint32_t reserved;
+	/**
+	 * Name of the captured processor type (NULL terminated).
+	 */
+	char proc_name[64];
+	uint8_t padding[16];
+} proc_capture_hdr_t;
+
+/**
+ * Capture file frame record header.
+ */
+typedef struct proc_capture_rec_s {
+	uint32_t magic;
+	uint32_t reserved;
+	/**
+	 * Record size in bytes (header plus planes, aligned).
+	 */
+	uint64_t size;
+	/**
+	 * Frame arrival time, in microseconds, relative to the arrival of the
+	 * first recorded frame (monotonic clock).
+	 */
+	int64_t arrival_usecs;
+	int64_t pts;
+	int64_t dts;
+	int32_t es_id;
+	int32_t proc_sample_fmt;
+	int32_t proc_sampling_rate;
+	uint32_t reserved2;
+	/**
+	 * Data planes description. Offsets are relative to the record start
+	 * (zero offset means the plane is not used).
+	 */
+	struct {
+		uint64_t offset;
+		int32_t linesize;
+		uint32_t width;
+		uint32_t height;
+		uint32_t reserved;
+	} planes[8];
+	uint8_t padding[8];
+} proc_capture_rec_t;
+
+/* **** Prototypes **** */
+
+/**
+ * Set the capture directory.
+ * This is a global setting intended to be set at application start-up; it
+ * applies to the captures and replays opened afterwards.
+ * @param dir_name Absolute path of the capture directory; NULL restores
+ * 'PROC_CAPTURE_DIR_DEFAULT'.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int proc_capture_dir_set(const char *dir_name);
+
+/**
+ * Get the path of a capture file in the capture directory.
+ * @param file_name Capture file name (can not contain '/' nor "..").
+ * @param path Buffer returning the file path.
+ * @param path_size Size of the 'path' buffer, in bytes.
+ * @param log_ctx Pointer to the LOG module context structure (may be NULL).
+ * @return Status code (STAT_SUCCESS code in case of success, STAT_EINVAL if
+ * the file name is not valid; for other code values please refer to
+ * .stat_codes.h).
+ */
+int proc_capture_path_get(const char *file_name, char *path,
+		size_t path_size, log_ctx_t *log_ctx);
+
+/**
+ * Create a capture file for recording frames.
+ * The capture directory is created if it does not exist; the capture file
+ * must not exist (it is never truncated).
+ * @param file_name Capture file name, relative to the capture directory
+ * (see 'proc_capture_path_get()').
+ * @param proc_name Name of the captured processor type (may be NULL).
+ * @param proc_io Captured processor interface (see 'proc_io_t').
+ * @param log_ctx Pointer to the LOG module context structure (may be NULL).
+ * @return Pointer to the capture context structure on success, NULL if
+ * fails.
+ */
+proc_capture_ctx_t* proc_capture_open(const char *file_name,
+		const char *proc_name, int proc_io, log_ctx_t *log_ctx);
+
+/**
+ * Finalize (write the records index) and close a capture file.
+ * @param ref_proc_capture_ctx Reference to the pointer to the capture
+ * context structure obtained in a previous call to 'proc_capture_open()'.
+ * Pointer is set to NULL on return.
+ */
+void proc_capture_close(proc_capture_ctx_t **ref_proc_capture_ctx);
+
+/**
+ * Record a frame.
+ * This function is not thread-safe; calls on the same capture context
+ * should be serialized by the caller.
+ * @param proc_capture_ctx Pointer to the capture context structure.
+ * @param proc_frame_ctx Pointer to the frame to be recorded.
+ * @param arrival_usecs Frame arrival time (monotonic clock), in
+ * microseconds.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int proc_capture_write(proc_capture_ctx_t *proc_capture_ctx,
+		const proc_frame_ctx_t *proc_frame_ctx, int64_t arrival_usecs);
+
+/**
+ * @param proc_capture_ctx Pointer to the capture context structure.
+ * @return Number of frames recorded so far.
+ */
+uint64_t proc_capture_get_frames_num(proc_capture_ctx_t *proc_capture_ctx);
+
+/**
+ * Open a capture file for replay (the file is memory-mapped read-only).
+ * @param file_name Capture file name, relative to the capture directory
+ * (see 'proc_capture_path_get()').
+ * @param log_ctx Pointer to the LOG module context structure (may be NULL).
+ * @return Pointer to the replay context structure on success, NULL if
+ * fails (e.g. the file name is not valid, the file does not exist or is
+ * not a valid capture file).
+ */
+proc_capture_replay_ctx_t* proc_capture_replay_open(const char *file_name,
+		log_ctx_t *log_ctx);
+
+/**
+ * Close a capture file opened for replay.
+ * Frames obtained by 'proc_capture_replay_get_frame()' must not be used
+ * after this call.
+ * @param ref_proc_capture_replay_ctx Reference to the pointer to the replay
+ * context structure obtained in a previous call to
+ * 'proc_capture_replay_open()'. Pointer is set to NULL on return.
+ */
+void proc_capture_replay_close(
+		proc_capture_replay_ctx_t **ref_proc_capture_replay_ctx);
+
+/**
+ * @param proc_capture_replay_ctx Pointer to the replay context structure.
+ * @return Number of frames in the capture file.
+ */
+uint64_t proc_capture_replay_get_frames_num(
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx);
+
+/**
+ * Get a recorded frame.
+ * No memory is allocated nor copied: the given frame structure is filled
+ * with data plane pointers referring to the mapped file ('data' member is
+ * set to NULL, thus, the frame must not be released).
+ * @param proc_capture_replay_ctx Pointer to the replay context structure.
+ * @param idx Frame index, in the range [0, frames_num- 1].
+ * @param proc_frame_ctx Pointer to the frame structure to be filled.
+ * @param ref_arrival_usecs Reference to the value returning the recorded
+ * frame arrival time (see 'proc_capture_rec_s::arrival_usecs'); may be
+ * NULL.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int proc_capture_replay_get_frame(
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx, uint64_t idx,
+		proc_frame_ctx_t *proc_frame_ctx, int64_t *ref_arrival_usecs);
+
+#endif /* MEDIAPROCESSORS_SRC_PROC_CAPTURE_H_ */
@@ -221,6 +221,10 @@ int proc_if_cmp(const proc_if_t* proc_if1, const proc_if_t* proc_if2)
 	if(proc_if1->oput_fifo_elem_opaque_dup!=
 			proc_if2->oput_fifo_elem_opaque_dup)
 		goto end;
+	if(proc_if1->rest_get_stream!= proc_if2->rest_get_stream)
+		goto end;
+	if(proc_if1->stats_get_stream!= proc_if2->stats_get_stream)
+		goto end;
 
 	// Reserved for future use: compare new fields here...
 
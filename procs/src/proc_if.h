@@ -37,6 +37,7 @@ typedef struct proc_ctx_s proc_ctx_t;
 typedef struct proc_if_s proc_if_t;
 typedef struct log_ctx_s log_ctx_t;
 typedef struct fifo_ctx_s fifo_ctx_t;
+typedef struct json_writer_ctx_s json_writer_ctx_t;
 
 /**
  * Maximum width for the input/output processor frame.
@@ -337,6 +338,46 @@ typedef struct proc_if_s {
 	 * This structure will be pushed to the processor output FIFO.
 	 */
 	proc_frame_ctx_t* (*oput_fifo_elem_opaque_dup)(const void *t);
+	/**
+	 * Streaming variant of the 'rest_get()' callback: write the processor's
+	 * representational state (including current settings) using the given
+	 * JSON writer (see .json_writer.h), instead of building a cJSON tree.
+	 * The members are to be written within an object already started by the
+	 * caller (the caller may add its own members, e.g. statistics, before
+	 * and after). Settings are expected to be written in an object named
+	 * "settings", as in 'rest_get()'.
+	 * This method is asynchronous and thread safe.
+	 * This callback is optional (can be set to NULL). If implemented, it is
+	 * used in preference to 'rest_get()' (which still may be implemented to
+	 * support the PROC_IF_REST_FMT_CJSON and PROC_IF_REST_FMT_BINARY
+	 * formats).
+	 * @param proc_ctx Pointer to the processor (PROC) context structure
+	 * obtained in a previous call to the 'open()' callback method.
+	 * @param json_writer_ctx Pointer to the JSON writer context structure.
+	 * @return Status code (STAT_SUCCESS code in case of success, for other
+	 * code values please refer to .stat_codes.h).
+	 */
+	int (*rest_get_stream)(proc_ctx_t *proc_ctx,
+			json_writer_ctx_t *json_writer_ctx);
+	/**
+	 * Write the processor's specific volatile statistics (e.g. frame or byte
+	 * counters) using the given JSON writer (see .json_writer.h).
+	 * Statistics are not part of the representational state returned by the
+	 * 'rest_get()' or 'rest_get_stream()' callbacks (the entity-tag of the
+	 * representation only changes when the processor state is modified; see
+	 * 'proc_ctx_s::settings_version'). The members are to be written within
+	 * the object already started by the caller, after the generic
+	 * statistics (see 'PROC_STATS_FIELDS').
+	 * This method is asynchronous and thread safe.
+	 * This callback is optional (can be set to NULL).
+	 * @param proc_ctx Pointer to the processor (PROC) context structure
+	 * obtained in a previous call to the 'open()' callback method.
+	 * @param json_writer_ctx Pointer to the JSON writer context structure.
+	 * @return Status code (STAT_SUCCESS code in case of success, for other
+	 * code values please refer to .stat_codes.h).
+	 */
+	int (*stats_get_stream)(proc_ctx_t *proc_ctx,
+			json_writer_ctx_t *json_writer_ctx);
 } proc_if_t;
 
 /* **** Prototypes **** */
@@ -32,6 +32,12 @@
 #include <pthread.h>
 #include <errno.h>
 #include <ctype.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <libcjson/cJSON.h>
 #include <libmediaprocsutils/uri_parser.h>
@@ -40,10 +46,17 @@
 #include <libmediaprocsutils/stat_codes.h>
 #include <libmediaprocsutils/check_utils.h>
 #include <libmediaprocsutils/fair_lock.h>
+#include <libmediaprocsutils/fifo.h>
 #include <libmediaprocsutils/llist.h>
+#include <libmediaprocsutils/json_writer.h>
+#include <libmediaprocsutils/interr_usleep.h>
+#include <libmediaprocsutils/trace.h>
+#include <libmediaprocsutils/schedule.h>
 
 #include "proc.h"
 #include "proc_if.h"
+#include "proc_capture.h"
+#include "procs_stats_shm.h"
 
 /* **** Definitions **** */
 
@@ -89,9 +102,16 @@
 /**
  * Limit value for the maximum number of processors that can be instantiated
  * in the system.
- * This value may be just modified, in compilation, if needed.
+ * As the processors register is allocated on demand (see 'procs_reg_dir_t'),
+ * this limit does not imply any memory cost; it just keeps processor Ids.
+ * within the positive integer range.
  */
-#define PROCS_MAX_NUM_PROC_INSTANCES 8192
+#define PROCS_MAX_NUM_PROC_INSTANCES (INT_MAX- PROCS_REG_CHUNK_SIZE)
+
+/**
+ * Number of register slots per register chunk (see 'procs_reg_chunk_t').
+ */
+#define PROCS_REG_CHUNK_SIZE 64
 
 /*
  * Input/output processor's FIFOs size.
@@ -99,6 +119,65 @@
  */
 #define PROCS_FIFO_SIZE 2
 
+/**
+ * Default statistics shared-memory page publishing period (see tag
+ * "PROCS_STATS_SHM_OPEN").
+ */
+#define PROCS_STATS_SHM_PERIOD_USECS_DEFAULT (100000)
+
+/**
+ * Maximum length of the statistics shared-memory page name.
+ */
+#define PROCS_STATS_SHM_NAME_MAX_LEN 256
+
+/**
+ * Processors metrics identifiers (see 'procs_metrics_def').
+ */
+typedef enum procs_metric_e {
+	PROCS_METRIC_BITRATE= 0,
+	PROCS_METRIC_LATENCY_AVG,
+	PROCS_METRIC_LATENCY_MAX,
+	PROCS_METRIC_LATENCY_MIN,
+	PROCS_METRIC_FIFO_LEVEL,
+	PROCS_METRIC_FRAMES,
+	PROCS_METRIC_FRAMES_DROPPED,
+	PROCS_METRIC_CPU_TIME,
+	PROCS_METRIC_NUM
+} procs_metric_t;
+
+/**
+ * Processors metrics definition (Prometheus text exposition format).
+ */
+typedef struct procs_metric_def_s {
+	const char *name;
+	const char *help;
+	const char *type;
+	/**
+	 * Non-zero if the metric has a value per input/output ('io' label).
+	 */
+	int flag_io;
+	/**
+	 * Processor features required for the metric to apply (zero if none).
+	 */
+	uint64_t flag_proc_features;
+	/**
+	 * Non-zero if the metric only applies to processors running the generic
+	 * processing thread (namely, implementing 'proc_if_s::process_frame()').
+	 */
+	int flag_proc_thread;
+} procs_metric_def_t;
+
+/**
+ * Processors metrics snapshot of one processor (see 'procs_metrics_get()').
+ * Processor name and type strings are only valid within the module
+ * instance API critical section.
+ */
+typedef struct procs_metrics_elem_s {
+	int proc_id;
+	const proc_if_t *proc_if;
+	int64_t values[PROCS_METRIC_NUM][PROC_IO_NUM];
+} procs_metrics_elem_t;
+
 /**
  * Module's context structure.
  * PROCS module context structure is statically defined in the program.
@@ -121,6 +200,23 @@ typedef struct procs_module_ctx_s {
 	llist_t *proc_if_llist;
 } procs_module_ctx_t;
 
+/**
+ * Processors register slot state enumeration.
+ * A register slot goes through the following states:
+ * FREE -> RESERVED (processor is being opened) -> ACTIVE -> DELETING
+ * (processor is being closed) -> FREE.
+ * Processor opening and closing are performed *outside* the module instance
+ * API critical section; RESERVED and DELETING states keep the slot busy in
+ * the meanwhile (thus the processor Id. can not be reused) while it is not
+ * accessible for API nor i/o operations.
+ */
+typedef enum procs_reg_elem_state_enum {
+	PROCS_REG_ELEM_STATE_FREE= 0,
+	PROCS_REG_ELEM_STATE_RESERVED,
+	PROCS_REG_ELEM_STATE_ACTIVE,
+	PROCS_REG_ELEM_STATE_DELETING
+} procs_reg_elem_state_t;
+
 /**
  * Processors registration structure.
  */
@@ -132,31 +228,107 @@ typedef struct procs_reg_elem_s {
 	 * asynchronously on any of the registered processor instances.
 	 * Processor's API options are available through the function 'proc_opt()'
 	 * (see .proc.h).
-	 * This lock is initialized when opening this module, and is kept
-	 * through the whole life of the module.
+	 * This lock is initialized the first time the register slot is used, and
+	 * is kept through the whole life of the module instance.
 	 */
 	pthread_mutex_t api_mutex;
 	/**
 	 * A pair of locks used to provide a critical section to execute, in mutual
 	 * exclusion, the processor's instantiating operations
 	 * (register/unregister) and the input/output operations (send/receive).
-	 * These locks are initialized when opening this module, and are kept
-	 * through the whole life of the module.
+	 * These locks are initialized the first time the register slot is used,
+	 * and are kept through the whole life of the module instance. As i/o
+	 * operations fetch these locks without any other locking, the references
+	 * are published using atomic operations (NULL means not initialized).
 	 */
 	fair_lock_t *fair_lock_io_array[PROC_IO_NUM];
+	/**
+	 * Set to non-zero when the locks above are initialized.
+	 */
+	int flag_locks_initialized;
+	/**
+	 * Register chunk this slot belongs to (see 'procs_reg_chunk_t').
+	 */
+	struct procs_reg_chunk_s *procs_reg_chunk;
+	/**
+	 * JSON writer used to compose the REST representation of the registered
+	 * processor (if it implements 'proc_if_s::rest_get_stream()').
+	 * It is opened on first use and kept for re-use; accessed only within
+	 * the register element API critical section.
+	 */
+	json_writer_ctx_t *json_writer_ctx;
 	/**
 	 * Processor context structure.
 	 * Each instantiated processor will be registered using this pointer, in a
-	 * registration array. This pointer may be NULL in the register, meaning
-	 * that an empty slot is available for registering new processors.
+	 * register slot. This pointer may be NULL in the register, meaning
+	 * that no processor is accessible through this slot.
 	 * To access a registered processor, this pointer will be fetched from the
-	 * registration array.
+	 * register.
 	 * @see procs_module_ctx_t
-	 * @see procs_reg_elem_array
+	 * @see procs_reg_dir_t
 	 */
 	proc_ctx_t *proc_ctx;
+	/**
+	 * Register slot state (see 'procs_reg_elem_state_t').
+	 * This field is only accessed within the module instance API critical
+	 * section.
+	 */
+	procs_reg_elem_state_t state;
+	/**
+	 * Processor interface of the processor being opened or closed.
+	 * Only meaningful in the RESERVED and DELETING states, used to be able
+	 * to represent pending processors in REST.
+	 */
+	const proc_if_t *proc_if_pending;
 } procs_reg_elem_t;
 
+/**
+ * Processors register chunk.
+ * The processors register is organized as a sparse set of fixed size chunks
+ * of register slots, indexed by processor Id. Chunks are allocated on demand
+ * when registering new processors, and are never moved nor released until
+ * the module instance is closed; thus, the address of a register slot is
+ * stable and can be fetched without locking (see 'procs_reg_elem_lookup()').
+ */
+typedef struct procs_reg_chunk_s {
+	/**
+	 * Register slots; processor Id. of slot 'i' is
+	 * 'chunk_index* PROCS_REG_CHUNK_SIZE+ i'.
+	 */
+	procs_reg_elem_t procs_reg_elem_array[PROCS_REG_CHUNK_SIZE];
+	/**
+	 * Number of slots in this chunk that are not in the FREE state.
+	 * Used to skip empty chunks when traversing the register, and full
+	 * chunks when looking for a free slot. This field is only accessed
+	 * within the module instance API critical section.
+	 */
+	int used_cnt;
+} procs_reg_chunk_t;
+
+/**
+ * Processors register chunks directory.
+ * To grow the register, a new (bigger) directory is allocated, the chunk
+ * references are copied and the new directory is published atomically.
+ * Replaced directories are retained (linked through 'prev') until the module
+ * instance is closed, so that a lock-free reader holding a reference to an
+ * old directory is always safe (the memory overhead is bounded, as the
+ * directory size is doubled on each growth).
+ */
+typedef struct procs_reg_dir_s {
+	/**
+	 * Previous (replaced) directory, if any.
+	 */
+	struct procs_reg_dir_s *prev;
+	/**
+	 * Number of elements in 'chunk_array'.
+	 */
+	size_t chunk_array_size;
+	/**
+	 * Chunk references (NULL if the chunk was not allocated yet).
+	 */
+	procs_reg_chunk_t *chunk_array[];
+} procs_reg_dir_t;
+
 /**
  * Module's instance context structure.
  * PROCS module context structure is statically defined in the program.
@@ -182,20 +354,63 @@ typedef struct procs_ctx_s {
 	 */
 	pthread_mutex_t api_mutex;
 	/**
-	 * Array listing the registered processor instances.
-	 * The idea behind using an array is to have a mean to fast fetch
-	 * a processor for input (receive) or output (send) operations.
-	 * This array is defined with a fixed maximum size (set when calling
+	 * Number of register slots in a pending state (RESERVED or DELETING),
+	 * and conditional signaled each time a pending slot is resolved.
+	 * Both are used in the module instance API critical section (the
+	 * conditional is associated to 'procs_ctx_s::api_mutex'), mainly to let
+	 * 'procs_close()' wait for asynchronous processor deletions to finish.
+	 */
+	volatile int pending_cnt;
+	pthread_cond_t pending_cond;
+	int flag_pending_cond_initialized;
+	/**
+	 * Register of processor instances (chunks directory).
+	 * The idea behind indexing the register by processor Id. is to have a
+	 * mean to fast fetch a processor for input (receive) or output (send)
+	 * operations. The register grows on demand (see 'procs_reg_dir_t' and
+	 * 'procs_reg_chunk_t'); it is only modified within the module instance
+	 * API critical section, but is read by i/o operations without locking
+	 * (thus this reference is published using atomic operations).
+	 */
+	procs_reg_dir_t *procs_reg_dir;
+	/**
+	 * Maximum number of processors that can be registered (set when calling
 	 * the function 'procs_open()', but limited to a maximum of
-	 * PROCS_MAX_NUM_PROC_INSTANCES); each element of the array has a set of
-	 * locks already initialized to enable concurrency.
+	 * PROCS_MAX_NUM_PROC_INSTANCES).
+	 */
+	size_t max_procs_num;
+	/**
+	 * JSON writer used to compose the REST list of processors.
+	 * It is opened on first use and kept for re-use; accessed only within
+	 * the module instance API critical section.
 	 */
-	procs_reg_elem_t *procs_reg_elem_array;
+	json_writer_ctx_t *json_writer_ctx;
+	//@{
 	/**
-	 * Size of the array of registered processors.
-	 * See 'procs_ctx_s::procs_reg_elem_array'
+	 * Processors metrics snapshot array and text buffer (see
+	 * 'procs_metrics_get()'). Allocated on first use and kept for re-use;
+	 * accessed only within the module instance API critical section.
 	 */
-	size_t procs_reg_elem_array_size;
+	procs_metrics_elem_t *metrics_elem_array;
+	size_t metrics_elem_array_size;
+	char *metrics_buf;
+	size_t metrics_buf_size;
+	size_t metrics_buf_len;
+	//@}
+	//@{
+	/**
+	 * Statistics shared-memory page (see procs_stats_shm.h) and its
+	 * publishing thread.
+	 * The page reference and the exit flag are accessed within the module
+	 * instance API critical section.
+	 */
+	procs_stats_shm_hdr_t *stats_shm_hdr;
+	size_t stats_shm_size;
+	char stats_shm_name[PROCS_STATS_SHM_NAME_MAX_LEN];
+	int flag_stats_shm_exit;
+	interr_usleep_ctx_t *stats_shm_interr_usleep_ctx;
+	pthread_t stats_shm_thread;
+	//@}
 	/**
 	 * Externally defined LOG module instance context structure.
 	 */
@@ -213,16 +428,42 @@ static int procs_instance_opt(procs_ctx_t *procs_ctx, const char *tag,
 		log_ctx_t *log_ctx, va_list arg);
 
 static int procs_rest_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
-		char **ref_rest_str, const char *filter_str);
+		char **ref_rest_str, const char *filter_str, const char *fields_str);
+static int procs_metrics_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
+		char **ref_metrics_str);
+static int procs_stats_shm_open(procs_ctx_t *procs_ctx, const char *shm_name,
+		int period_usec, log_ctx_t *log_ctx);
+static int procs_stats_shm_close(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx);
+static void* procs_stats_shm_thr(void *t);
+static void procs_stats_shm_publish(procs_ctx_t *procs_ctx);
+static int procs_metrics_printf(procs_ctx_t *procs_ctx, const char *fmt, ...)
+		__attribute__((format(printf, 2, 3)));
+static int procs_metrics_print_label(procs_ctx_t *procs_ctx,
+		const char *label, const char *value);
 static int proc_register(procs_ctx_t *procs_ctx, const char *proc_name,
 		const char *settings_str, log_ctx_t *log_ctx, int *ref_id, va_list arg);
-static int proc_unregister(procs_ctx_t *procs_ctx, int id, log_ctx_t *log_ctx);
+static int proc_unregister(procs_ctx_t *procs_ctx, int id, int flag_async,
+		log_ctx_t *log_ctx);
+static void* proc_unregister_async_thr(void *t);
+static void proc_unregister_release_slot(procs_ctx_t *procs_ctx,
+		int proc_id);
+
+static procs_reg_elem_t* procs_reg_elem_lookup(procs_ctx_t *procs_ctx,
+		int proc_id);
+static procs_reg_elem_t* procs_reg_elem_create(procs_ctx_t *procs_ctx,
+		int proc_id, log_ctx_t *log_ctx);
+static int procs_reg_get_free_id(procs_ctx_t *procs_ctx);
 
 static int procs_id_opt(procs_ctx_t *procs_ctx, const char *tag,
 		log_ctx_t *log_ctx, va_list arg);
 
 static int procs_id_get(procs_reg_elem_t *procs_reg_elem, proc_ctx_t *proc_ctx,
 		log_ctx_t *log_ctx, void **ref_reponse);
+static int procs_id_get_cond(procs_reg_elem_t *procs_reg_elem,
+		proc_ctx_t *proc_ctx, log_ctx_t *log_ctx, const char *if_none_match_str,
+		char **ref_rest_str, char **ref_etag_str);
+static int procs_id_stats_get(procs_reg_elem_t *procs_reg_elem,
+		proc_ctx_t *proc_ctx, log_ctx_t *log_ctx, char **ref_rest_str);
 static proc_ctx_t* procs_id_opt_fetch_proc_ctx(procs_ctx_t *procs_ctx,
 		int proc_id, const char *tag, va_list arg, log_ctx_t *log_ctx);
 
@@ -233,6 +474,37 @@ static proc_ctx_t* procs_id_opt_fetch_proc_ctx(procs_ctx_t *procs_ctx,
  */
 static procs_module_ctx_t *procs_module_ctx= NULL;
 
+/**
+ * Processors metrics definitions (indexed by 'procs_metric_t').
+ */
+static const procs_metric_def_t procs_metrics_def[PROCS_METRIC_NUM]=
+{
+	{"mediaprocs_bitrate_bits_per_second",
+			"Processor input/output bitrate.", "gauge", 1,
+			PROC_FEATURE_BITRATE, 0},
+	{"mediaprocs_latency_avg_usec",
+			"Processor average latency in microseconds.", "gauge", 0,
+			PROC_FEATURE_LATENCY, 0},
+	{"mediaprocs_latency_max_usec",
+			"Processor maximum latency in microseconds.", "gauge", 0,
+			PROC_FEATURE_LATENCY, 0},
+	{"mediaprocs_latency_min_usec",
+			"Processor minimum latency in microseconds.", "gauge", 0,
+			PROC_FEATURE_LATENCY, 0},
+	{"mediaprocs_fifo_level",
+			"Number of frames queued in the processor input/output FIFO.",
+			"gauge", 1, 0, 0},
+	{"mediaprocs_frames_total",
+			"Number of frames sent to/received from the processor.",
+			"counter", 1, 0, 0},
+	{"mediaprocs_frames_dropped_total",
+			"Number of frames dropped at the processor input.",
+			"counter", 0, 0, 0},
+	{"mediaprocs_cpu_time_usec_total",
+			"CPU time consumed by the processing thread in microseconds.",
+			"counter", 0, 0, 1}
+};
+
 int procs_module_open(log_ctx_t *log_ctx)
 {
 	int ret_code, end_code= STAT_ERROR;
@@ -275,6 +547,9 @@ void procs_module_close()
 	/* Module's API mutual exclusion lock */
 	ASSERT(pthread_mutex_destroy(&procs_module_ctx->module_api_mutex)== 0);
 
+	/* Restore default capture directory */
+	proc_capture_dir_set(NULL);
+
 	/* List of supported/registered processor types */
 	LLIST_RELEASE(&procs_module_ctx->proc_if_llist, proc_if_release, proc_if_t);
 
@@ -315,6 +590,8 @@ int procs_module_opt(const char *tag, ...)
 		else
 			*ref_proc_if_cpy= NULL;
 		end_code= (*ref_proc_if_cpy!= NULL)? STAT_SUCCESS: STAT_ENOTFOUND;
+	} else if (TAG_IS("PROCS_SET_CAPTURE_DIR")) {
+		end_code= proc_capture_dir_set(va_arg(arg, const char*));
 	} else {
 		LOGE("Unknown option\n");
 		end_code= STAT_ENOTFOUND;
@@ -328,7 +605,7 @@ int procs_module_opt(const char *tag, ...)
 procs_ctx_t* procs_open(log_ctx_t *log_ctx, size_t max_procs_num,
 		const char *prefix_name, const char *procs_href)
 {
-	int proc_id, i, ret_code, end_code= STAT_ERROR;
+	int ret_code, end_code= STAT_ERROR;
 	procs_ctx_t *procs_ctx= NULL;
 	LOG_CTX_INIT(log_ctx);
 
@@ -370,32 +647,14 @@ procs_ctx_t* procs_open(log_ctx_t *log_ctx, size_t max_procs_num,
 	ret_code= pthread_mutex_init(&procs_ctx->api_mutex, NULL);
 	CHECK_DO(ret_code== 0, goto end);
 
-	procs_ctx->procs_reg_elem_array= (procs_reg_elem_t*)malloc(max_procs_num*
-			sizeof(procs_reg_elem_t));
-	CHECK_DO(procs_ctx->procs_reg_elem_array!= NULL, goto end)
-	for(proc_id= 0; proc_id< max_procs_num; proc_id++) {
-		procs_reg_elem_t *procs_reg_elem=
-				&procs_ctx->procs_reg_elem_array[proc_id];
-
-		ret_code= pthread_mutex_init(&procs_reg_elem->api_mutex, NULL);
-		CHECK_DO(ret_code== 0, goto end);
-
-		for(i= 0; i< PROC_IO_NUM; i++) {
-			fair_lock_t *fair_lock= fair_lock_open();
-			CHECK_DO(fair_lock!= NULL, goto end);
-			procs_reg_elem->fair_lock_io_array[i]= fair_lock;
-		}
-
-		procs_reg_elem->proc_ctx= NULL;
-	}
+	procs_ctx->pending_cnt= 0;
+	ret_code= pthread_cond_init(&procs_ctx->pending_cond, NULL);
+	CHECK_DO(ret_code== 0, goto end);
+	procs_ctx->flag_pending_cond_initialized= 1;
 
-	/* Important note:
-	 * We update the register array size *after* we successfully allocated and
-	 * initialized the array; otherwise the size keeps set to zero
-	 * (thus, we can securely execute 'procs_close()' on failure, as other
-	 * PROCS module functions).
-	 */
-	procs_ctx->procs_reg_elem_array_size= max_procs_num;
+	/* Processors register is allocated on demand (when registering) */
+	procs_ctx->procs_reg_dir= NULL;
+	procs_ctx->max_procs_num= max_procs_num;
 
 	procs_ctx->log_ctx= log_ctx;
 
@@ -409,7 +668,9 @@ end:
 void procs_close(procs_ctx_t **ref_procs_ctx)
 {
 	procs_ctx_t *procs_ctx;
-	int procs_reg_elem_array_size, proc_id, i;
+	procs_reg_dir_t *procs_reg_dir;
+	size_t chunk_idx;
+	int proc_id, i;
 	LOG_CTX_INIT(NULL);
 	LOGD(">>%s\n", __FUNCTION__);
 
@@ -418,17 +679,40 @@ void procs_close(procs_ctx_t **ref_procs_ctx)
 
 	LOG_CTX_SET(procs_ctx->log_ctx);
 
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
+	/* Stop publishing statistics (if applicable) */
+	procs_stats_shm_close(procs_ctx, LOG_CTX_GET());
 
 	/* First of all release all the processors (note that for deleting
 	 * the processors we need the processor IF type to be still available).
+	 * We also wait for any pending processor opening or (asynchronous)
+	 * deletion to finish.
 	 */
 	LOCK_PROCS_CTX_API(procs_ctx);
-	if(procs_ctx->procs_reg_elem_array!= NULL) {
-		for(proc_id= 0; proc_id< procs_reg_elem_array_size; proc_id++) {
+	/* Note that the instance API critical section is released while
+	 * unregistering or waiting, thus processors being opened concurrently
+	 * may become active (and the register may grow) meanwhile. We loop
+	 * until a whole pass of the register finds no active processor and
+	 * nothing is pending (fetching the directory on each iteration).
+	 */
+	for(;;) {
+		int unregistered_cnt= 0;
+		for(proc_id= 0; (procs_reg_dir= procs_ctx->procs_reg_dir)!= NULL &&
+				proc_id< procs_reg_dir->chunk_array_size*
+				PROCS_REG_CHUNK_SIZE; proc_id++) {
+			procs_reg_elem_t *procs_reg_elem= procs_reg_elem_lookup(
+					procs_ctx, proc_id);
+			if(procs_reg_elem== NULL ||
+					procs_reg_elem->state!= PROCS_REG_ELEM_STATE_ACTIVE)
+				continue;
 			LOGD("unregistering proc with Id.: %d\n", proc_id);
-			proc_unregister(procs_ctx, proc_id, LOG_CTX_GET());
+			proc_unregister(procs_ctx, proc_id, 0, LOG_CTX_GET());
+			unregistered_cnt++;
 		}
+		if(procs_ctx->flag_pending_cond_initialized== 0 ||
+				(unregistered_cnt== 0 && procs_ctx->pending_cnt== 0))
+			break;
+		while(procs_ctx->pending_cnt> 0)
+			pthread_cond_wait(&procs_ctx->pending_cond, &procs_ctx->api_mutex);
 	}
 	UNLOCK_PROCS_CTX_API(procs_ctx);
 
@@ -441,19 +725,56 @@ void procs_close(procs_ctx_t **ref_procs_ctx)
 	/* Module's instance API mutual exclusion lock */
 	ASSERT(pthread_mutex_destroy(&procs_ctx->api_mutex)== 0);
 
-	/* Array listing the registered processor instances */
-	if(procs_ctx->procs_reg_elem_array!= NULL) {
-		for(proc_id= 0; proc_id< procs_reg_elem_array_size; proc_id++) {
-			procs_reg_elem_t *procs_reg_elem=
-					&procs_ctx->procs_reg_elem_array[proc_id];
+	/* REST list JSON writer */
+	json_writer_close(&procs_ctx->json_writer_ctx);
 
-			ASSERT(pthread_mutex_destroy(&procs_reg_elem->api_mutex)== 0);
+	/* Metrics snapshot and text buffer */
+	if(procs_ctx->metrics_elem_array!= NULL) {
+		free(procs_ctx->metrics_elem_array);
+		procs_ctx->metrics_elem_array= NULL;
+	}
+	if(procs_ctx->metrics_buf!= NULL) {
+		free(procs_ctx->metrics_buf);
+		procs_ctx->metrics_buf= NULL;
+	}
 
-			for(i= 0; i< PROC_IO_NUM; i++)
-				fair_lock_close(&procs_reg_elem->fair_lock_io_array[i]);
+	/* Pending register slots conditional */
+	if(procs_ctx->flag_pending_cond_initialized!= 0) {
+		ASSERT(pthread_cond_destroy(&procs_ctx->pending_cond)== 0);
+		procs_ctx->flag_pending_cond_initialized= 0;
+	}
+
+	/* Processors register (chunks are referenced by the current directory;
+	 * older directories just hold copies of the references).
+	 */
+	if((procs_reg_dir= procs_ctx->procs_reg_dir)!= NULL) {
+		for(chunk_idx= 0; chunk_idx< procs_reg_dir->chunk_array_size;
+				chunk_idx++) {
+			procs_reg_chunk_t *procs_reg_chunk=
+					procs_reg_dir->chunk_array[chunk_idx];
+			if(procs_reg_chunk== NULL)
+				continue;
+			for(proc_id= 0; proc_id< PROCS_REG_CHUNK_SIZE; proc_id++) {
+				procs_reg_elem_t *procs_reg_elem=
+						&procs_reg_chunk->procs_reg_elem_array[proc_id];
+				if(procs_reg_elem->flag_locks_initialized== 0)
+					continue;
+
+				ASSERT(pthread_mutex_destroy(&procs_reg_elem->api_mutex)== 0);
+
+				for(i= 0; i< PROC_IO_NUM; i++)
+					fair_lock_close(&procs_reg_elem->fair_lock_io_array[i]);
+
+				json_writer_close(&procs_reg_elem->json_writer_ctx);
+			}
+			free(procs_reg_chunk);
+		}
+		while(procs_reg_dir!= NULL) {
+			procs_reg_dir_t *procs_reg_dir_prev= procs_reg_dir->prev;
+			free(procs_reg_dir);
+			procs_reg_dir= procs_reg_dir_prev;
 		}
-		free(procs_ctx->procs_reg_elem_array);
-		procs_ctx->procs_reg_elem_array= NULL;
+		procs_ctx->procs_reg_dir= NULL;
 	}
 
 	/* Release module's instance context structure */
@@ -483,8 +804,23 @@ int procs_opt(procs_ctx_t *procs_ctx, const char *tag, ...)
 
 	LOG_CTX_SET(procs_ctx->log_ctx);
 
-	if(TAG_HAS("PROCS_ID") && !TAG_IS("PROCS_ID_DELETE")) {
+	if(TAG_HAS("PROCS_ID") && !TAG_HAS("PROCS_ID_DELETE")) {
 		end_code= procs_id_opt(procs_ctx, tag, LOG_CTX_GET(), arg);
+	} else if(TAG_IS("PROCS_STATS_SHM_CLOSE")) {
+		// Treated out of the instance API critical section (joins thread)
+		end_code= procs_stats_shm_close(procs_ctx, LOG_CTX_GET());
+	} else if(TAG_HAS("PROCS_TRACE_")) {
+		// Tracing is process-wide (TRACE module has its own locking)
+		if(TAG_IS("PROCS_TRACE_START"))
+			end_code= trace_start();
+		else if(TAG_IS("PROCS_TRACE_STOP"))
+			end_code= trace_stop();
+		else if(TAG_IS("PROCS_TRACE_GET"))
+			end_code= trace_get_chrome_json(va_arg(arg, char**));
+		else {
+			LOGE("Unknown option\n");
+			end_code= STAT_ENOTFOUND;
+		}
 	} else {
 		end_code= procs_instance_opt(procs_ctx, tag, LOG_CTX_GET(), arg);
 	}
@@ -496,7 +832,7 @@ int procs_opt(procs_ctx_t *procs_ctx, const char *tag, ...)
 int procs_send_frame(procs_ctx_t *procs_ctx, int proc_id,
 		const proc_frame_ctx_t *proc_frame_ctx)
 {
-	int procs_reg_elem_array_size, end_code= STAT_ERROR;
+	int end_code= STAT_ERROR;
 	procs_reg_elem_t *procs_reg_elem;
 	fair_lock_t *p_fair_lock= NULL;
 	proc_ctx_t *proc_ctx= NULL;
@@ -505,17 +841,21 @@ int procs_send_frame(procs_ctx_t *procs_ctx, int proc_id,
 	/* Check arguments */
 	CHECK_DO(procs_module_ctx!= NULL, return STAT_ERROR);
 	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
-	CHECK_DO(proc_id>= 0 && proc_id< procs_reg_elem_array_size,
+	CHECK_DO(proc_id>= 0 && (size_t)proc_id< procs_ctx->max_procs_num,
 			return STAT_ERROR);
 	CHECK_DO(proc_frame_ctx!= NULL, return STAT_ERROR);
 
 	LOG_CTX_SET(procs_ctx->log_ctx);
 
-	procs_reg_elem= &procs_ctx->procs_reg_elem_array[proc_id];
-
-	p_fair_lock= procs_reg_elem->fair_lock_io_array[PROC_IPUT];
-	CHECK_DO(p_fair_lock!= NULL, goto end);
+	/* Fetch register slot and its i/o lock (lock-free; see
+	 * 'procs_reg_elem_lookup()'). A slot that was never used has no
+	 * processor registered.
+	 */
+	if((procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id))== NULL ||
+			(p_fair_lock= __atomic_load_n(
+					&procs_reg_elem->fair_lock_io_array[PROC_IPUT],
+					__ATOMIC_ACQUIRE))== NULL)
+		return STAT_ENOTFOUND;
 
 	fair_lock(p_fair_lock);
 
@@ -537,7 +877,7 @@ end:
 int procs_recv_frame(procs_ctx_t *procs_ctx, int proc_id,
 		proc_frame_ctx_t **ref_proc_frame_ctx)
 {
-	int procs_reg_elem_array_size, end_code= STAT_ERROR;
+	int end_code= STAT_ERROR;
 	procs_reg_elem_t *procs_reg_elem;
 	fair_lock_t *p_fair_lock= NULL;
 	proc_ctx_t *proc_ctx= NULL;
@@ -546,8 +886,7 @@ int procs_recv_frame(procs_ctx_t *procs_ctx, int proc_id,
 	/* Check arguments */
 	CHECK_DO(procs_module_ctx!= NULL, return STAT_ERROR);
 	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
-	CHECK_DO(proc_id>= 0 && proc_id< procs_reg_elem_array_size,
+	CHECK_DO(proc_id>= 0 && (size_t)proc_id< procs_ctx->max_procs_num,
 			return STAT_ERROR);
 	CHECK_DO(ref_proc_frame_ctx!= NULL, return STAT_ERROR);
 
@@ -555,10 +894,14 @@ int procs_recv_frame(procs_ctx_t *procs_ctx, int proc_id,
 
 	LOG_CTX_SET(procs_ctx->log_ctx);
 
-	procs_reg_elem= &procs_ctx->procs_reg_elem_array[proc_id];
-
-	p_fair_lock= procs_reg_elem->fair_lock_io_array[PROC_OPUT];
-	CHECK_DO(p_fair_lock!= NULL, goto end);
+	/* Fetch register slot and its i/o lock (lock-free; see
+	 * 'procs_reg_elem_lookup()').
+	 */
+	if((procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id))== NULL ||
+			(p_fair_lock= __atomic_load_n(
+					&procs_reg_elem->fair_lock_io_array[PROC_OPUT],
+					__ATOMIC_ACQUIRE))== NULL)
+		return STAT_ENOTFOUND;
 
 	fair_lock(p_fair_lock);
 
@@ -710,30 +1053,57 @@ static int procs_instance_opt(procs_ctx_t *procs_ctx, const char *tag,
 		} else {
 			*ref_rest_str= NULL;
 		}
+	} else if(TAG_IS("PROCS_POST_ID")) {
+		const char *proc_name= va_arg(arg, const char*);
+		const char *settings_str= va_arg(arg, const char*);
+		int *ref_proc_id= va_arg(arg, int*);
+		CHECK_DO(ref_proc_id!= NULL, end_code= STAT_EINVAL; goto end);
+		end_code= proc_register(procs_ctx, proc_name, settings_str,
+				LOG_CTX_GET(), ref_proc_id, arg);
 	} else if(TAG_IS("PROCS_GET")) {
 		char **ref_rest_str= va_arg(arg, char**);
 		const char *filter_str= va_arg(arg, const char*);
 		end_code= procs_rest_get(procs_ctx, LOG_CTX_GET(), ref_rest_str,
-				filter_str);
+				filter_str, NULL);
+	} else if(TAG_IS("PROCS_GET_FIELDS")) {
+		char **ref_rest_str= va_arg(arg, char**);
+		const char *filter_str= va_arg(arg, const char*);
+		const char *fields_str= va_arg(arg, const char*);
+		CHECK_DO(fields_str!= NULL, end_code= STAT_EINVAL; goto end);
+		end_code= procs_rest_get(procs_ctx, LOG_CTX_GET(), ref_rest_str,
+				filter_str, fields_str);
+	} else if(TAG_IS("PROCS_GET_METRICS")) {
+		end_code= procs_metrics_get(procs_ctx, LOG_CTX_GET(),
+				va_arg(arg, char**));
+	} else if(TAG_IS("PROCS_STATS_SHM_OPEN")) {
+		const char *shm_name= va_arg(arg, const char*);
+		int period_usec= va_arg(arg, int);
+		end_code= procs_stats_shm_open(procs_ctx, shm_name, period_usec,
+				LOG_CTX_GET());
 	}  else if(TAG_IS("PROCS_ID_DELETE")) {
 		register int id= va_arg(arg, int);
-		end_code= proc_unregister(procs_ctx, id, LOG_CTX_GET());
+		end_code= proc_unregister(procs_ctx, id, 0, LOG_CTX_GET());
+	}  else if(TAG_IS("PROCS_ID_DELETE_ASYNC")) {
+		register int id= va_arg(arg, int);
+		end_code= proc_unregister(procs_ctx, id, 1, LOG_CTX_GET());
 	} else {
 		LOGE("Unknown option\n");
 		end_code= STAT_ENOTFOUND;
 	}
 
+end:
 	UNLOCK_PROCS_CTX_API(procs_ctx);
 	return end_code;
 #undef PROC_ID_STR_FMT
 }
 
 static int procs_rest_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
-		char **ref_rest_str, const char *filter_str)
+		char **ref_rest_str, const char *filter_str, const char *fields_str)
 {
 	int i, ret_code, end_code= STAT_ERROR;
-	cJSON *cjson_rest= NULL, *cjson_proc= NULL;
-	cJSON *cjson_aux= NULL, *cjson_procs; // Do not release
+	procs_reg_dir_t *procs_reg_dir;
+	json_writer_ctx_t *json_writer_ctx;
+	const char *rest_str= NULL; // Do not release
 	const char *filter_proc_name= NULL, *filter_proc_notname= NULL;
 	LOG_CTX_INIT(log_ctx);
 
@@ -742,6 +1112,7 @@ static int procs_rest_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
 	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
 	CHECK_DO(ref_rest_str!= NULL, return STAT_ERROR);
 	//argument 'filter_str' is allowed to be NULL
+	//argument 'fields_str' is allowed to be NULL
 
 	/*  Check that module instance API critical section is locked */
 	ret_code= pthread_mutex_trylock(&procs_ctx->api_mutex);
@@ -763,16 +1134,24 @@ static int procs_rest_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
 	 *         ....
 	 *     ]
 	 * }
+	 * Processors being currently created or deleted are listed without
+	 * "links" and with an additional field: "state":"creating"|"deleting".
+	 * If a fields selection is given, "links" are substituted by the
+	 * selected fields of each processor (see tag "PROC_GET_FIELDS") and
+	 * processors being created or deleted are not listed. The whole list is
+	 * composed in one pass of the register.
 	 */
 
-	/* Create cJSON tree-root object */
-	cjson_rest= cJSON_CreateObject();
-	CHECK_DO(cjson_rest!= NULL, goto end);
+	/* Get JSON writer (kept for re-use, as this is typically polled) */
+	if((json_writer_ctx= procs_ctx->json_writer_ctx)== NULL) {
+		json_writer_ctx= procs_ctx->json_writer_ctx= json_writer_open(0);
+		CHECK_DO(json_writer_ctx!= NULL, goto end);
+	}
+	json_writer_reset(json_writer_ctx);
 
-	/* Create and attach 'PROCS' array */
-	cjson_procs= cJSON_CreateArray();
-	CHECK_DO(cjson_procs!= NULL, goto end);
-	cJSON_AddItemToObject(cjson_rest, procs_ctx->prefix_name, cjson_procs);
+	/* Start tree-root object and 'PROCS' array */
+	json_writer_object_start(json_writer_ctx, NULL);
+	json_writer_array_start(json_writer_ctx, procs_ctx->prefix_name);
 
 	/* Parse the filter if available */
 	if(filter_str!= NULL) {
@@ -783,24 +1162,50 @@ static int procs_rest_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
 			filter_proc_notname= filter_str+ filter_proc_name_len;
 	}
 
-	/* Compose the REST list */
-	for(i= 0; i< procs_ctx->procs_reg_elem_array_size; i++) {
+	/* Compose the REST list.
+	 * Register chunks with no processors are skipped as a whole (note that
+	 * we always enter a chunk at its first slot).
+	 */
+	procs_reg_dir= procs_ctx->procs_reg_dir;
+	for(i= 0; procs_reg_dir!= NULL &&
+			i< procs_reg_dir->chunk_array_size* PROCS_REG_CHUNK_SIZE; i++) {
 		const char *proc_name;
 		const proc_if_t *proc_if;
-		register int proc_instance_index;
-		cJSON *cjson_links, *cjson_link;
+		const char *state_str= NULL;
+		register int proc_instance_index= i;
 		proc_ctx_t *proc_ctx= NULL;
-		procs_reg_elem_t *procs_reg_elem=
-				&procs_ctx->procs_reg_elem_array[i];
+		procs_reg_elem_t *procs_reg_elem;
+		procs_reg_chunk_t *procs_reg_chunk=
+				procs_reg_dir->chunk_array[i/ PROCS_REG_CHUNK_SIZE];
 		char href[PROCS_HREF_MAX_LEN+ sizeof(".json")]= {0};
 
-		if((proc_ctx= procs_reg_elem->proc_ctx)== NULL)
+		if(procs_reg_chunk== NULL || procs_reg_chunk->used_cnt== 0) {
+			i+= PROCS_REG_CHUNK_SIZE- 1;
+			continue;
+		}
+		procs_reg_elem= &procs_reg_chunk->procs_reg_elem_array[
+				i% PROCS_REG_CHUNK_SIZE];
+
+		switch(procs_reg_elem->state) {
+		case PROCS_REG_ELEM_STATE_ACTIVE:
+			proc_ctx= procs_reg_elem->proc_ctx;
+			CHECK_DO(proc_ctx!= NULL, continue);
+			CHECK_DO(proc_ctx->proc_instance_index== i, continue);
+			proc_if= proc_ctx->proc_if;
+			break;
+		case PROCS_REG_ELEM_STATE_RESERVED:
+			proc_if= procs_reg_elem->proc_if_pending;
+			state_str= "creating";
+			break;
+		case PROCS_REG_ELEM_STATE_DELETING:
+			proc_if= procs_reg_elem->proc_if_pending;
+			state_str= "deleting";
+			break;
+		default:
+			continue;
+		}
+		if(state_str!= NULL && fields_str!= NULL)
 			continue;
-
-		proc_instance_index= proc_ctx->proc_instance_index;
-		CHECK_DO(proc_instance_index== i, continue);
-
-		proc_if= proc_ctx->proc_if;
 		CHECK_DO(proc_if!= NULL, continue);
 		proc_name= proc_if->proc_name;
 		CHECK_DO(proc_name!= NULL, continue);
@@ -814,67 +1219,520 @@ static int procs_rest_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
 				continue;
 		}
 
-		if(cjson_proc!= NULL) {
-			cJSON_Delete(cjson_proc);
-			cjson_proc= NULL;
-		}
-		cjson_proc= cJSON_CreateObject();
-		CHECK_DO(cjson_proc!= NULL, goto end);
-		//cJSON_AddItemToArray(cjson_procs, cjson_proc); //at the end of loop
+		json_writer_object_start(json_writer_ctx, NULL);
 
 		/* 'proc_id' */
-		cjson_aux= cJSON_CreateNumber((double)proc_instance_index);
-		CHECK_DO(cjson_aux!= NULL, goto end);
-		cJSON_AddItemToObject(cjson_proc, "proc_id", cjson_aux);
+		json_writer_int(json_writer_ctx, "proc_id", proc_instance_index);
 
 		/* 'proc_name' */
-		cjson_aux= cJSON_CreateString(proc_name);
-		CHECK_DO(cjson_aux!= NULL, goto end);
-		cJSON_AddItemToObject(cjson_proc, "proc_name", cjson_aux);
+		json_writer_string(json_writer_ctx, "proc_name", proc_name);
+
+		if(fields_str!= NULL) {
+			/* Selected fields */
+			LOCK_PROCS_REG_ELEM_API(procs_ctx, procs_reg_elem, goto end);
+			ret_code= proc_opt(proc_ctx, "PROC_GET_FIELDS", json_writer_ctx,
+					fields_str);
+			UNLOCK_PROCS_REG_ELEM_API(procs_reg_elem);
+			if(ret_code!= STAT_SUCCESS)
+				LOGW("Could not get fields of processor Id. %d\n",
+						proc_instance_index);
+		} else if(state_str!= NULL) {
+			/* 'state' (only for pending processors; these are not linked) */
+			json_writer_string(json_writer_ctx, "state", state_str);
+		} else {
+			/* 'links' */
+			json_writer_array_start(json_writer_ctx, "links");
+			json_writer_object_start(json_writer_ctx, NULL);
+			json_writer_string(json_writer_ctx, "rel", "self");
+			snprintf(href, sizeof(href), "%s.json", proc_ctx->href);
+			json_writer_string(json_writer_ctx, "href", href);
+			json_writer_object_end(json_writer_ctx);
+			json_writer_array_end(json_writer_ctx);
+		}
+
+		ret_code= json_writer_object_end(json_writer_ctx);
+		CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+	}
+
+	json_writer_array_end(json_writer_ctx);
+	json_writer_object_end(json_writer_ctx);
+
+	/* Get JSON character string */
+	rest_str= json_writer_get_str(json_writer_ctx, NULL);
+	CHECK_DO(rest_str!= NULL, goto end);
+	*ref_rest_str= strdup(rest_str);
+	CHECK_DO(*ref_rest_str!= NULL && strlen(*ref_rest_str)> 0, goto end);
+
+	end_code= STAT_SUCCESS;
+end:
+	return end_code;
+}
+
+static int procs_metrics_get(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx,
+		char **ref_metrics_str)
+{
+	int i, m, io, ret_code, end_code= STAT_ERROR;
+	size_t metrics_elem_cnt= 0;
+	procs_reg_dir_t *procs_reg_dir;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_module_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(ref_metrics_str!= NULL, return STAT_ERROR);
+
+	/*  Check that module instance API critical section is locked */
+	ret_code= pthread_mutex_trylock(&procs_ctx->api_mutex);
+	CHECK_DO(ret_code== EBUSY, return STAT_ERROR);
+
+	*ref_metrics_str= NULL;
+
+	/* Take a snapshot of the counters of all the registered processors in
+	 * one pass of the register (metrics have to be grouped by metric name in
+	 * the exposition format, thus we can not print while traversing).
+	 */
+	procs_reg_dir= procs_ctx->procs_reg_dir;
+	for(i= 0; procs_reg_dir!= NULL &&
+			i< procs_reg_dir->chunk_array_size* PROCS_REG_CHUNK_SIZE; i++) {
+		proc_ctx_t *proc_ctx;
+		procs_reg_elem_t *procs_reg_elem;
+		procs_metrics_elem_t *metrics_elem;
+		procs_reg_chunk_t *procs_reg_chunk=
+				procs_reg_dir->chunk_array[i/ PROCS_REG_CHUNK_SIZE];
+
+		if(procs_reg_chunk== NULL || procs_reg_chunk->used_cnt== 0) {
+			i+= PROCS_REG_CHUNK_SIZE- 1;
+			continue;
+		}
+		procs_reg_elem= &procs_reg_chunk->procs_reg_elem_array[
+				i% PROCS_REG_CHUNK_SIZE];
+		if(procs_reg_elem->state!= PROCS_REG_ELEM_STATE_ACTIVE ||
+				(proc_ctx= procs_reg_elem->proc_ctx)== NULL ||
+				proc_ctx->proc_if== NULL)
+			continue;
 
-		/* 'links' */
-		cjson_links= cJSON_CreateArray();
-		CHECK_DO(cjson_links!= NULL, goto end);
-		cJSON_AddItemToObject(cjson_proc, "links", cjson_links);
+		/* Grow snapshot array if needed */
+		if(metrics_elem_cnt>= procs_ctx->metrics_elem_array_size) {
+			size_t new_size= procs_ctx->metrics_elem_array_size> 0?
+					procs_ctx->metrics_elem_array_size* 2:
+					PROCS_REG_CHUNK_SIZE;
+			procs_metrics_elem_t *new_array= (procs_metrics_elem_t*)realloc(
+					procs_ctx->metrics_elem_array,
+					new_size* sizeof(procs_metrics_elem_t));
+			CHECK_DO(new_array!= NULL, goto end);
+			procs_ctx->metrics_elem_array= new_array;
+			procs_ctx->metrics_elem_array_size= new_size;
+		}
+		metrics_elem= &procs_ctx->metrics_elem_array[metrics_elem_cnt++];
+
+		metrics_elem->proc_id= i;
+		metrics_elem->proc_if= proc_ctx->proc_if;
+		for(io= 0; io< PROC_IO_NUM; io++) {
+			metrics_elem->values[PROCS_METRIC_BITRATE][io]=
+					proc_ctx->bitrate[io];
+			metrics_elem->values[PROCS_METRIC_FIFO_LEVEL][io]=
+					fifo_get_slots_used(proc_ctx->fifo_ctx_array[io]);
+			metrics_elem->values[PROCS_METRIC_FRAMES][io]=
+					(int64_t)proc_ctx->frame_cnt[io];
+		}
+		metrics_elem->values[PROCS_METRIC_LATENCY_AVG][0]=
+				proc_ctx->latency_avg_usec;
+		metrics_elem->values[PROCS_METRIC_LATENCY_MAX][0]=
+				proc_ctx->latency_max_usec;
+		metrics_elem->values[PROCS_METRIC_LATENCY_MIN][0]=
+				proc_ctx->latency_min_usec;
+		metrics_elem->values[PROCS_METRIC_FRAMES_DROPPED][0]=
+				(int64_t)proc_ctx->frame_drop_cnt;
+		metrics_elem->values[PROCS_METRIC_CPU_TIME][0]=
+				(int64_t)(proc_ctx->cpu_time_nsec/ 1000);
+	}
 
-		cjson_link= cJSON_CreateObject();
-		CHECK_DO(cjson_link!= NULL, goto end);
-		cJSON_AddItemToArray(cjson_links, cjson_link);
+	/* Print metrics grouped by metric name */
+	procs_ctx->metrics_buf_len= 0;
+	for(m= 0; m< PROCS_METRIC_NUM; m++) {
+		const procs_metric_def_t *metric_def= &procs_metrics_def[m];
 
-		cjson_aux= cJSON_CreateString("self");
-		CHECK_DO(cjson_aux!= NULL, goto end);
-		cJSON_AddItemToObject(cjson_link, "rel", cjson_aux);
+		ret_code= procs_metrics_printf(procs_ctx, "# HELP %s %s\n# TYPE %s %s\n",
+				metric_def->name, metric_def->help, metric_def->name,
+				metric_def->type);
+		if(ret_code!= STAT_SUCCESS) {
+			end_code= ret_code;
+			goto end;
+		}
+
+		for(i= 0; i< (int)metrics_elem_cnt; i++) {
+			const procs_metrics_elem_t *metrics_elem=
+					&procs_ctx->metrics_elem_array[i];
+			const proc_if_t *proc_if= metrics_elem->proc_if;
 
-		snprintf(href, sizeof(href), "%s.json", proc_ctx->href);
-		cjson_aux= cJSON_CreateString(href);
-		CHECK_DO(cjson_aux!= NULL, goto end);
-		cJSON_AddItemToObject(cjson_link, "href", cjson_aux);
+			if((proc_if->flag_proc_features& metric_def->flag_proc_features)!=
+					metric_def->flag_proc_features)
+				continue;
+			if(metric_def->flag_proc_thread && proc_if->process_frame== NULL)
+				continue;
 
-		/* Finally attach to REST list */
-		cJSON_AddItemToArray(cjson_procs, cjson_proc);
-		cjson_proc= NULL; // Avoid double referencing
+			/* Every append is checked: a sample line is never left
+			 * truncated (the whole request fails instead).
+			 */
+			for(io= 0; io< (metric_def->flag_io? PROC_IO_NUM: 1); io++) {
+				ret_code= procs_metrics_printf(procs_ctx, "%s{proc_id=\"%d\"",
+						metric_def->name, metrics_elem->proc_id);
+				if(ret_code== STAT_SUCCESS)
+					ret_code= procs_metrics_print_label(procs_ctx,
+							"proc_name", proc_if->proc_name);
+				if(ret_code== STAT_SUCCESS)
+					ret_code= procs_metrics_print_label(procs_ctx,
+							"proc_type", proc_if->proc_type);
+				if(ret_code== STAT_SUCCESS && metric_def->flag_io)
+					ret_code= procs_metrics_print_label(procs_ctx, "io",
+							io== PROC_IPUT? "input": "output");
+				if(ret_code== STAT_SUCCESS)
+					ret_code= procs_metrics_printf(procs_ctx,
+							"} %"PRId64"\n", metrics_elem->values[m][io]);
+				if(ret_code!= STAT_SUCCESS) {
+					LOGE("Could not compose metrics (processor Id. %d)\n",
+							metrics_elem->proc_id);
+					end_code= ret_code;
+					goto end;
+				}
+			}
+		}
 	}
 
-	/* Print cJSON structure data to char string */
-	*ref_rest_str= CJSON_PRINT(cjson_rest);
-	CHECK_DO(*ref_rest_str!= NULL && strlen(*ref_rest_str)> 0, goto end);
+	CHECK_DO(procs_ctx->metrics_buf!= NULL, goto end);
+	*ref_metrics_str= strdup(procs_ctx->metrics_buf);
+	CHECK_DO(*ref_metrics_str!= NULL, goto end);
 
 	end_code= STAT_SUCCESS;
 end:
-	if(cjson_rest!= NULL)
-		cJSON_Delete(cjson_rest);
-	if(cjson_proc!= NULL)
-		cJSON_Delete(cjson_proc);
 	return end_code;
 }
 
+/**
+ * Append formatted text to the metrics text buffer (growing it as needed).
+ */
+static int procs_metrics_printf(procs_ctx_t *procs_ctx, const char *fmt, ...)
+{
+	va_list arg;
+	int len;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(fmt!= NULL, return STAT_ERROR);
+
+	for(;;) {
+		size_t available= procs_ctx->metrics_buf_size-
+				procs_ctx->metrics_buf_len;
+		size_t new_size;
+		char *new_buf;
+
+		if(procs_ctx->metrics_buf!= NULL) {
+			va_start(arg, fmt);
+			len= vsnprintf(procs_ctx->metrics_buf+ procs_ctx->metrics_buf_len,
+					available, fmt, arg);
+			va_end(arg);
+			CHECK_DO(len>= 0, return STAT_ERROR);
+			if((size_t)len< available) {
+				procs_ctx->metrics_buf_len+= len;
+				return STAT_SUCCESS;
+			}
+		}
+
+		/* Grow buffer (keeping already printed text) */
+		new_size= procs_ctx->metrics_buf_size> 0?
+				procs_ctx->metrics_buf_size* 2: 4096;
+		new_buf= (char*)realloc(procs_ctx->metrics_buf, new_size);
+		CHECK_DO(new_buf!= NULL, return STAT_ENOMEM);
+		procs_ctx->metrics_buf= new_buf;
+		procs_ctx->metrics_buf_size= new_size;
+		procs_ctx->metrics_buf[procs_ctx->metrics_buf_len]= '\0';
+	}
+	return STAT_ERROR; // Never reached
+}
+
+/**
+ * Append a label (',label="value"') to the metrics text buffer, escaping the
+ * value as defined by the exposition format.
+ */
+static int procs_metrics_print_label(procs_ctx_t *procs_ctx,
+		const char *label, const char *value)
+{
+	int ret_code;
+	const char *p;
+
+	if(value== NULL)
+		value= "";
+
+	/* Fast path: nothing to escape */
+	if(strpbrk(value, "\\\"\n")== NULL)
+		return procs_metrics_printf(procs_ctx, ",%s=\"%s\"", label, value);
+
+	ret_code= procs_metrics_printf(procs_ctx, ",%s=\"", label);
+	for(p= value; *p!= '\0' && ret_code== STAT_SUCCESS; p++) {
+		switch(*p) {
+		case '\\':
+			ret_code= procs_metrics_printf(procs_ctx, "\\\\");
+			break;
+		case '"':
+			ret_code= procs_metrics_printf(procs_ctx, "\\\"");
+			break;
+		case '\n':
+			ret_code= procs_metrics_printf(procs_ctx, "\\n");
+			break;
+		default:
+			ret_code= procs_metrics_printf(procs_ctx, "%c", *p);
+			break;
+		}
+	}
+	if(ret_code== STAT_SUCCESS)
+		ret_code= procs_metrics_printf(procs_ctx, "\"");
+	return ret_code;
+}
+
+static int procs_stats_shm_open(procs_ctx_t *procs_ctx, const char *shm_name,
+		int period_usec, log_ctx_t *log_ctx)
+{
+	size_t elem_num, shm_size;
+	int ret_code, end_code= STAT_ERROR, shm_fd= -1;
+	procs_stats_shm_hdr_t *stats_shm_hdr= NULL;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(shm_name!= NULL && shm_name[0]== '/' &&
+			strlen(shm_name)< PROCS_STATS_SHM_NAME_MAX_LEN, return STAT_EINVAL);
+	CHECK_DO(period_usec>= 0, return STAT_EINVAL);
+
+	/*  Check that module instance API critical section is locked */
+	ret_code= pthread_mutex_trylock(&procs_ctx->api_mutex);
+	CHECK_DO(ret_code== EBUSY, return STAT_ERROR);
+
+	/* Check if statistics page is already being published */
+	if(procs_ctx->stats_shm_hdr!= NULL) {
+		LOGE("Statistics shared-memory page already opened ('%s')\n",
+				procs_ctx->stats_shm_name);
+		return STAT_ECONFLICT;
+	}
+
+	/* Compute page size. Processors with Id. greater than the number of
+	 * elements are not published.
+	 */
+	elem_num= procs_ctx->max_procs_num< PROCS_STATS_SHM_ELEM_MAX?
+			procs_ctx->max_procs_num: PROCS_STATS_SHM_ELEM_MAX;
+	shm_size= sizeof(procs_stats_shm_hdr_t)+
+			elem_num* sizeof(procs_stats_shm_elem_t);
+
+	/* Create and map the shared memory segment. The segment is always
+	 * created afresh (never re-used with foreign ownership or permissions):
+	 * a segment left behind with the same name (e.g. by a terminated process)
+	 * is unlinked and creation is retried once.
+	 */
+	shm_fd= shm_open(shm_name, O_CREAT| O_EXCL| O_RDWR, S_IRUSR | S_IWUSR);
+	if(shm_fd< 0 && errno== EEXIST) {
+		LOGW("Replacing existing shared-memory object '%s'\n", shm_name);
+		if(shm_unlink(shm_name)!= 0 && errno!= ENOENT) {
+			LOGE("Could not unlink shared-memory object '%s' (errno: %d)\n",
+					shm_name, errno);
+			goto end;
+		}
+		shm_fd= shm_open(shm_name, O_CREAT| O_EXCL| O_RDWR,
+				S_IRUSR | S_IWUSR);
+	}
+	CHECK_DO(shm_fd>= 0, LOGE("errno: %d\n", errno); goto end);
+	CHECK_DO(ftruncate(shm_fd, shm_size)== 0, goto end);
+	stats_shm_hdr= (procs_stats_shm_hdr_t*)mmap(NULL, shm_size,
+			PROT_READ| PROT_WRITE, MAP_SHARED, shm_fd, 0);
+	if(stats_shm_hdr== MAP_FAILED)
+		stats_shm_hdr= NULL;
+	CHECK_DO(stats_shm_hdr!= NULL, goto end);
+	memset(stats_shm_hdr, 0, shm_size);
+
+	/* Initialize header (magic number is set last) */
+	stats_shm_hdr->version= PROCS_STATS_SHM_VERSION;
+	stats_shm_hdr->hdr_size= sizeof(procs_stats_shm_hdr_t);
+	stats_shm_hdr->elem_size= sizeof(procs_stats_shm_elem_t);
+	stats_shm_hdr->elem_num= elem_num;
+	stats_shm_hdr->period_usec= period_usec> 0? period_usec:
+			PROCS_STATS_SHM_PERIOD_USECS_DEFAULT;
+	__atomic_store_n(&stats_shm_hdr->magic, PROCS_STATS_SHM_MAGIC,
+			__ATOMIC_RELEASE);
+
+	procs_ctx->stats_shm_interr_usleep_ctx= interr_usleep_open();
+	CHECK_DO(procs_ctx->stats_shm_interr_usleep_ctx!= NULL, goto end);
+
+	procs_ctx->stats_shm_hdr= stats_shm_hdr;
+	procs_ctx->stats_shm_size= shm_size;
+	snprintf(procs_ctx->stats_shm_name, sizeof(procs_ctx->stats_shm_name),
+			"%s", shm_name);
+	procs_ctx->flag_stats_shm_exit= 0;
+
+	/* Launch publishing thread (first publishing is done right away) */
+	procs_stats_shm_publish(procs_ctx);
+	ret_code= pthread_create(&procs_ctx->stats_shm_thread, NULL,
+			procs_stats_shm_thr, procs_ctx);
+	CHECK_DO(ret_code== 0, procs_ctx->stats_shm_hdr= NULL; goto end);
+	stats_shm_hdr= NULL; // Avoid double referencing
+
+	end_code= STAT_SUCCESS;
+end:
+	/* We will not need file descriptor any more */
+	if(shm_fd>= 0) {
+		ASSERT(close(shm_fd)== 0);
+	}
+	if(end_code!= STAT_SUCCESS) {
+		interr_usleep_close(&procs_ctx->stats_shm_interr_usleep_ctx);
+		if(stats_shm_hdr!= NULL)
+			ASSERT(munmap(stats_shm_hdr, shm_size)== 0);
+		if(shm_fd>= 0)
+			ASSERT(shm_unlink(shm_name)== 0);
+	}
+	return end_code;
+}
+
+/**
+ * Stop publishing the statistics shared-memory page and release it.
+ * This function should be called *out* of the module instance API critical
+ * section, as it waits for the publishing thread to finish.
+ */
+static int procs_stats_shm_close(procs_ctx_t *procs_ctx, log_ctx_t *log_ctx)
+{
+	procs_stats_shm_hdr_t *stats_shm_hdr;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
+
+	/* Signal publishing thread to exit */
+	LOCK_PROCS_CTX_API(procs_ctx);
+	if((stats_shm_hdr= procs_ctx->stats_shm_hdr)== NULL) {
+		UNLOCK_PROCS_CTX_API(procs_ctx);
+		return STAT_ENOTFOUND;
+	}
+	procs_ctx->flag_stats_shm_exit= 1;
+	procs_ctx->stats_shm_hdr= NULL;
+	UNLOCK_PROCS_CTX_API(procs_ctx);
+
+	interr_usleep_unblock(procs_ctx->stats_shm_interr_usleep_ctx);
+	ASSERT(pthread_join(procs_ctx->stats_shm_thread, NULL)== 0);
+	interr_usleep_close(&procs_ctx->stats_shm_interr_usleep_ctx);
+
+	/* Release page */
+	ASSERT(munmap(stats_shm_hdr, procs_ctx->stats_shm_size)== 0);
+	ASSERT(shm_unlink(procs_ctx->stats_shm_name)== 0);
+	memset(procs_ctx->stats_shm_name, 0, sizeof(procs_ctx->stats_shm_name));
+	procs_ctx->stats_shm_size= 0;
+	return STAT_SUCCESS;
+}
+
+/**
+ * Statistics shared-memory page publishing thread.
+ */
+static void* procs_stats_shm_thr(void *t)
+{
+	procs_ctx_t *procs_ctx= (procs_ctx_t*)t;
+	uint32_t period_usec;
+	LOG_CTX_INIT(NULL);
+
+	/* Check argument */
+	CHECK_DO(procs_ctx!= NULL, return NULL);
+
+	LOG_CTX_SET(procs_ctx->log_ctx);
+
+	schedule_set_thread_name("stats-shm");
+
+	LOCK_PROCS_CTX_API(procs_ctx);
+	period_usec= (uint32_t)procs_ctx->stats_shm_hdr->period_usec;
+	UNLOCK_PROCS_CTX_API(procs_ctx);
+
+	for(;;) {
+		if(interr_usleep(procs_ctx->stats_shm_interr_usleep_ctx,
+				period_usec)!= STAT_SUCCESS)
+			break;
+
+		LOCK_PROCS_CTX_API(procs_ctx);
+		if(procs_ctx->flag_stats_shm_exit!= 0) {
+			UNLOCK_PROCS_CTX_API(procs_ctx);
+			break;
+		}
+		procs_stats_shm_publish(procs_ctx);
+		UNLOCK_PROCS_CTX_API(procs_ctx);
+	}
+	return NULL;
+}
+
+/**
+ * Publish the counters of all the registered processors in the statistics
+ * shared-memory page (module instance API critical section must be locked).
+ */
+static void procs_stats_shm_publish(procs_ctx_t *procs_ctx)
+{
+	uint32_t i;
+	struct timespec monotime_curr;
+	procs_stats_shm_hdr_t *stats_shm_hdr= procs_ctx->stats_shm_hdr;
+	procs_stats_shm_elem_t *elem_array= (procs_stats_shm_elem_t*)
+			((uint8_t*)stats_shm_hdr+ sizeof(procs_stats_shm_hdr_t));
+
+	for(i= 0; i< stats_shm_hdr->elem_num; i++) {
+		register int io;
+		register uint32_t seq;
+		procs_stats_shm_elem_t *elem= &elem_array[i];
+		proc_ctx_t *proc_ctx= NULL;
+		procs_reg_elem_t *procs_reg_elem= procs_reg_elem_lookup(procs_ctx, i);
+
+		if(procs_reg_elem!= NULL &&
+				procs_reg_elem->state== PROCS_REG_ELEM_STATE_ACTIVE)
+			proc_ctx= procs_reg_elem->proc_ctx;
+		if(proc_ctx== NULL || proc_ctx->proc_if== NULL) {
+			if(elem->flags== 0)
+				continue; // Nothing to update
+		}
+
+		/* Enter sequence lock (odd) */
+		seq= elem->seq;
+		__atomic_store_n(&elem->seq, seq+ 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		if(proc_ctx== NULL || proc_ctx->proc_if== NULL) {
+			memset((uint8_t*)elem+ sizeof(elem->seq), 0,
+					sizeof(procs_stats_shm_elem_t)- sizeof(elem->seq));
+		} else {
+			const proc_if_t *proc_if= proc_ctx->proc_if;
+			elem->flags= PROCS_STATS_SHM_ELEM_FLAG_ACTIVE;
+			elem->proc_id= i;
+			snprintf(elem->proc_name, sizeof(elem->proc_name), "%s",
+					proc_if->proc_name);
+			snprintf(elem->proc_type, sizeof(elem->proc_type), "%s",
+					proc_if->proc_type);
+			for(io= 0; io< PROC_IO_NUM; io++) {
+				elem->bitrate[io]= proc_ctx->bitrate[io];
+				elem->fifo_level[io]= fifo_get_slots_used(
+						proc_ctx->fifo_ctx_array[io]);
+				elem->frame_cnt[io]= proc_ctx->frame_cnt[io];
+			}
+			elem->latency_avg_usec= proc_ctx->latency_avg_usec;
+			elem->latency_max_usec= proc_ctx->latency_max_usec;
+			elem->latency_min_usec= proc_ctx->latency_min_usec;
+			elem->frame_drop_cnt= proc_ctx->frame_drop_cnt;
+			elem->cpu_time_nsec= proc_ctx->cpu_time_nsec;
+		}
+
+		/* Leave sequence lock (even) */
+		__atomic_store_n(&elem->seq, seq+ 2, __ATOMIC_RELEASE);
+	}
+
+	if(clock_gettime(CLOCK_MONOTONIC, &monotime_curr)== 0)
+		stats_shm_hdr->update_nsec= (uint64_t)monotime_curr.tv_sec*
+				1000000000+ (uint64_t)monotime_curr.tv_nsec;
+}
+
 static int proc_register(procs_ctx_t *procs_ctx, const char *proc_name,
 		const char *settings_str, log_ctx_t *log_ctx, int *ref_id, va_list arg)
 {
-	procs_reg_elem_t *procs_reg_elem;
+	procs_reg_elem_t *procs_reg_elem= NULL;
 	const proc_if_t *proc_if;
-	int procs_reg_elem_array_size, ret_code, end_code= STAT_ERROR;
-	int proc_id= -1, flag_force_proc_id= 0;
+	int ret_code, end_code= STAT_ERROR;
+	int proc_id= -1, flag_force_proc_id= 0, flag_reserved= 0;
 	int flag_is_query= 0; // 0-> JSON / 1->query string
 	char *proc_id_str= NULL;
 	cJSON *cjson_settings= NULL;
@@ -892,8 +1750,6 @@ static int proc_register(procs_ctx_t *procs_ctx, const char *proc_name,
 	// Note: argument 'log_ctx' is allowed to be NULL
 	CHECK_DO(ref_id!= NULL, return STAT_ERROR);
 
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
-
 	*ref_id= -1; // Set to invalid (undefined) value
 
 	/* Check that module instance critical section is locked */
@@ -930,37 +1786,37 @@ static int proc_register(procs_ctx_t *procs_ctx, const char *proc_name,
 	/* If a forced processor Id. was not requested, get one */
 	if(flag_force_proc_id== 0) {
 		/* Get free slot where to register new processor */
-		for(proc_id= 0; proc_id< procs_reg_elem_array_size; proc_id++) {
-			if(procs_ctx->procs_reg_elem_array[proc_id].proc_ctx== NULL)
-				break;
-		}
+		proc_id= procs_reg_get_free_id(procs_ctx);
 	}
 	if(proc_id< 0) {
 		LOGE("Invalid procesor identifier requested (Id. %d)\n", proc_id);
 		end_code= STAT_EINVAL;
 		goto end;
 	}
-	if(proc_id>= procs_reg_elem_array_size) {
+	if((size_t)proc_id>= procs_ctx->max_procs_num) {
 		LOGE("Maximum number of allowed processor instances exceeded\n");
 		end_code= STAT_ENOMEM;
 		goto end;
 	}
+	/* A forced Id. may not lie more than one chunk beyond the current
+	 * register size; otherwise a single request could grow the register
+	 * directory up to 'max_procs_num' entries.
+	 */
+	if(flag_force_proc_id!= 0 && (size_t)proc_id/ PROCS_REG_CHUNK_SIZE>
+			((procs_ctx->procs_reg_dir!= NULL)?
+			procs_ctx->procs_reg_dir->chunk_array_size: 0)) {
+		LOGE("Forced processor Id. %d exceeds the register size\n", proc_id);
+		end_code= STAT_EINVAL;
+		goto end;
+	}
 	// In case Id. was forced, we need to check if slot is empty
-	if(procs_ctx->procs_reg_elem_array[proc_id].proc_ctx!= NULL) {
+	if((procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id))!= NULL &&
+			procs_reg_elem->state!= PROCS_REG_ELEM_STATE_FREE) {
 		LOGE("Processor Id. conflict: requested Id. is being used.\n");
 		end_code= STAT_ECONFLICT;
 		goto end;
 	}
 
-	/* Note that working on a locked module instance API critical section
-	 * guarantee that 'procs_reg_elem_array' is not accessed concurrently
-	 * for registering/unregistering. Nevertheless, 'procs_reg_elem_array'
-	 * is still accessible concurrently by module's i/o operations, until
-	 * corresponding "fair-lock" is locked (in the code below we will lock
-	 * i/o "fair-locks" to register the new processor).
-	 */
-	procs_reg_elem= &procs_ctx->procs_reg_elem_array[proc_id];
-
 	/* Get processor interface (lock module!) */
 	ASSERT(pthread_mutex_lock(&procs_module_ctx->module_api_mutex)== 0);
 	proc_if= get_proc_if_by_name(proc_name, LOG_CTX_GET());
@@ -970,14 +1826,41 @@ static int proc_register(procs_ctx_t *procs_ctx, const char *proc_name,
 		goto end;
 	}
 
+	/* Reserve register slot (allocate it if applicable).
+	 * Note that working on a locked module instance API critical section
+	 * guarantee that the register is not modified concurrently
+	 * for registering/unregistering. Once reserved, the slot will not be
+	 * used by any other registering operation, and is not accessible by
+	 * i/o operations until the processor context structure is set (in the
+	 * code below we will lock i/o "fair-locks" to register the new
+	 * processor).
+	 */
+	procs_reg_elem= procs_reg_elem_create(procs_ctx, proc_id, LOG_CTX_GET());
+	if(procs_reg_elem== NULL) {
+		end_code= STAT_ENOMEM;
+		goto end;
+	}
+	procs_reg_elem->state= PROCS_REG_ELEM_STATE_RESERVED;
+	procs_reg_elem->proc_if_pending= proc_if;
+	procs_reg_elem->procs_reg_chunk->used_cnt++;
+	procs_ctx->pending_cnt++;
+	flag_reserved= 1;
+
 	/* Compose processor 'href' */
 	snprintf(href, sizeof(href), "%s/%s/%d",
 			procs_ctx->procs_href!= NULL? procs_ctx->procs_href: "",
 			procs_ctx->prefix_name, proc_id);
 
-	/* Open processor */
+	/* Open processor.
+	 * Opening a processor may take a considerable amount of time (e.g.
+	 * initializing a video encoder). Thus, we do it *outside* the module
+	 * instance API critical section, letting other API operations (including
+	 * the registration of other processors) to execute concurrently.
+	 */
+	UNLOCK_PROCS_CTX_API(procs_ctx);
 	proc_ctx= proc_open(proc_if, settings_str, proc_id, href, fifo_ctx_maxsize,
 			LOG_CTX_GET(), arg);
+	LOCK_PROCS_CTX_API(procs_ctx);
 	CHECK_DO(proc_ctx!= NULL, goto end);
 
 	/* Register processor context structure.
@@ -994,11 +1877,24 @@ static int proc_register(procs_ctx_t *procs_ctx, const char *proc_name,
 	UNLOCK_PROCS_REG_ELEM_API(procs_reg_elem);
 	proc_ctx= NULL; // Avoid double referencing
 
+	procs_reg_elem->state= PROCS_REG_ELEM_STATE_ACTIVE;
+	procs_reg_elem->proc_if_pending= NULL;
+	procs_ctx->pending_cnt--;
+	pthread_cond_broadcast(&procs_ctx->pending_cond);
+
 	*ref_id= proc_id;
 	end_code= STAT_SUCCESS;
 end:
 	if(proc_ctx!= NULL)
 		proc_close(&proc_ctx);
+	if(end_code!= STAT_SUCCESS && flag_reserved!= 0) {
+		/* Release slot reservation */
+		procs_reg_elem->state= PROCS_REG_ELEM_STATE_FREE;
+		procs_reg_elem->proc_if_pending= NULL;
+		procs_reg_elem->procs_reg_chunk->used_cnt--;
+		procs_ctx->pending_cnt--;
+		pthread_cond_broadcast(&procs_ctx->pending_cond);
+	}
 	if(proc_id_str!= NULL)
 		free(proc_id_str);
 	if(cjson_settings!= NULL)
@@ -1006,20 +1902,34 @@ end:
 	return end_code;
 }
 
-static int proc_unregister(procs_ctx_t *procs_ctx, int proc_id,
+/**
+ * Unregister and release a processor instance.
+ * The processor is first unregistered (namely, it is not accessible any more
+ * by API or i/o operations, and its register slot is set to the DELETING
+ * state). Then, the processor is closed *outside* the module instance API
+ * critical section, as closing may take a considerable amount of time (e.g.
+ * joining processing threads). Finally, the register slot is released.
+ * If 'flag_async' is set, closing the processor is delegated to a detached
+ * thread and this function returns immediately after unregistering.
+ * This function must be called with the module instance API critical section
+ * locked, and returns also with the critical section locked (but note that
+ * it may be temporarily unlocked in the meanwhile).
+ */
+static int proc_unregister(procs_ctx_t *procs_ctx, int proc_id, int flag_async,
 		log_ctx_t *log_ctx)
 {
 	procs_reg_elem_t *procs_reg_elem;
-	int procs_reg_elem_array_size, ret_code;
+	int ret_code;
 	proc_ctx_t *proc_ctx= NULL;
+	void **async_thr_args= NULL;
+	pthread_t async_thread;
 	LOG_CTX_INIT(log_ctx);
 	LOGD(">>%s\n", __FUNCTION__);
 
 	/* Check arguments */
 	CHECK_DO(procs_module_ctx!= NULL, return STAT_ERROR);
 	CHECK_DO(procs_ctx!= NULL, return STAT_ERROR);
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
-	CHECK_DO(proc_id>= 0 && proc_id< procs_reg_elem_array_size,
+	CHECK_DO(proc_id>= 0 && (size_t)proc_id< procs_ctx->max_procs_num,
 			return STAT_ERROR);
 	// Note: argument 'log_ctx' is allowed to be NULL
 
@@ -1027,16 +1937,17 @@ static int proc_unregister(procs_ctx_t *procs_ctx, int proc_id,
 	ret_code= pthread_mutex_trylock(&procs_ctx->api_mutex);
 	CHECK_DO(ret_code== EBUSY, return STAT_ERROR);
 
-	procs_reg_elem= &procs_ctx->procs_reg_elem_array[proc_id];
-
 	/* Fetch processor.
 	 * Note that working on locked module's API critical section guarantee that
-	 * 'procs_reg_elem_array' is not accessed concurrently for
+	 * the register is not modified concurrently for
 	 * registering/unregistering.
 	 */
-	proc_ctx= procs_reg_elem->proc_ctx;
-	if(proc_ctx== NULL)
+	procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id);
+	if(procs_reg_elem== NULL ||
+			procs_reg_elem->state!= PROCS_REG_ELEM_STATE_ACTIVE)
 		return STAT_ENOTFOUND;
+	proc_ctx= procs_reg_elem->proc_ctx;
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
 	ASSERT(proc_ctx->proc_instance_index== proc_id);
 
 	/* Unblock processor input/output FIFOs to be able to acquire i/o locks */
@@ -1054,21 +1965,258 @@ static int proc_unregister(procs_ctx_t *procs_ctx, int proc_id,
 	fair_unlock(procs_reg_elem->fair_lock_io_array[PROC_OPUT]);
 	UNLOCK_PROCS_REG_ELEM_API(procs_reg_elem);
 
+	/* Keep slot busy until the processor is actually released */
+	procs_reg_elem->state= PROCS_REG_ELEM_STATE_DELETING;
+	procs_reg_elem->proc_if_pending= proc_ctx->proc_if;
+	procs_ctx->pending_cnt++;
+
+	/* Asynchronous deletion: launch a detached thread to close the
+	 * processor. If the thread can not be launched, we just fall back to
+	 * synchronous deletion.
+	 */
+	if(flag_async!= 0) {
+		async_thr_args= (void**)malloc(3* sizeof(void*));
+		CHECK_DO(async_thr_args!= NULL, goto close_sync);
+		async_thr_args[0]= (void*)procs_ctx;
+		async_thr_args[1]= (void*)proc_ctx;
+		async_thr_args[2]= (void*)(intptr_t)proc_id;
+		ret_code= pthread_create(&async_thread, NULL,
+				proc_unregister_async_thr, (void*)async_thr_args);
+		CHECK_DO(ret_code== 0, free(async_thr_args); goto close_sync);
+		ASSERT(pthread_detach(async_thread)== 0);
+		LOGD("<<%s\n", __FUNCTION__);
+		return STAT_SUCCESS;
+	}
+
+close_sync:
 	/* Once processor register was deleted (and thus not accessible
 	 * by any concurrent thread performing i/o), release corresponding context
-	 * structure.
+	 * structure (outside the module instance API critical section).
 	 */
+	UNLOCK_PROCS_CTX_API(procs_ctx);
 	proc_close(&proc_ctx);
 	ASSERT(proc_ctx== NULL);
+	LOCK_PROCS_CTX_API(procs_ctx);
+
+	proc_unregister_release_slot(procs_ctx, proc_id);
 	LOGD("<<%s\n", __FUNCTION__);
 	return STAT_SUCCESS;
 }
 
+/**
+ * Asynchronous processor deletion thread (see 'proc_unregister()').
+ * Thread argument is an allocated array of three pointers: the module
+ * instance context structure, the processor context structure and the
+ * processor Id. (the array is released by this thread).
+ */
+static void* proc_unregister_async_thr(void *t)
+{
+	procs_ctx_t *procs_ctx;
+	proc_ctx_t *proc_ctx;
+	int proc_id;
+	void **async_thr_args= (void**)t;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(async_thr_args!= NULL, return NULL);
+
+	procs_ctx= (procs_ctx_t*)async_thr_args[0];
+	proc_ctx= (proc_ctx_t*)async_thr_args[1];
+	proc_id= (int)(intptr_t)async_thr_args[2];
+	free(async_thr_args);
+
+	schedule_set_thread_name("delete-%d", proc_id);
+
+	proc_close(&proc_ctx);
+	ASSERT(proc_ctx== NULL);
+
+	LOCK_PROCS_CTX_API(procs_ctx);
+	proc_unregister_release_slot(procs_ctx, proc_id);
+	UNLOCK_PROCS_CTX_API(procs_ctx);
+	return NULL;
+}
+
+/**
+ * Release register slot of a deleted processor (DELETING -> FREE).
+ * Must be called with the module instance API critical section locked.
+ */
+static void proc_unregister_release_slot(procs_ctx_t *procs_ctx, int proc_id)
+{
+	procs_reg_elem_t *procs_reg_elem;
+	LOG_CTX_INIT(NULL);
+
+	procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id);
+	CHECK_DO(procs_reg_elem!= NULL, return);
+	ASSERT(procs_reg_elem->state== PROCS_REG_ELEM_STATE_DELETING);
+
+	procs_reg_elem->state= PROCS_REG_ELEM_STATE_FREE;
+	procs_reg_elem->proc_if_pending= NULL;
+	procs_reg_elem->procs_reg_chunk->used_cnt--;
+	procs_ctx->pending_cnt--;
+	pthread_cond_broadcast(&procs_ctx->pending_cond);
+}
+
+/**
+ * Fetch the register slot corresponding to the given processor Id.
+ * This function does not lock any critical section, and thus can be used in
+ * the i/o operations fast path: register chunks and directories are never
+ * released until the module instance is closed (see 'procs_reg_dir_t').
+ * Returns NULL if the slot was not allocated yet (thus no processor can be
+ * registered with the given Id.).
+ */
+static procs_reg_elem_t* procs_reg_elem_lookup(procs_ctx_t *procs_ctx,
+		int proc_id)
+{
+	procs_reg_dir_t *procs_reg_dir;
+	procs_reg_chunk_t *procs_reg_chunk;
+	size_t chunk_idx;
+
+	if(proc_id< 0 || (size_t)proc_id>= procs_ctx->max_procs_num)
+		return NULL;
+
+	procs_reg_dir= __atomic_load_n(&procs_ctx->procs_reg_dir,
+			__ATOMIC_ACQUIRE);
+	if(procs_reg_dir== NULL)
+		return NULL;
+
+	chunk_idx= (size_t)proc_id/ PROCS_REG_CHUNK_SIZE;
+	if(chunk_idx>= procs_reg_dir->chunk_array_size)
+		return NULL;
+
+	procs_reg_chunk= __atomic_load_n(&procs_reg_dir->chunk_array[chunk_idx],
+			__ATOMIC_ACQUIRE);
+	if(procs_reg_chunk== NULL)
+		return NULL;
+
+	return &procs_reg_chunk->procs_reg_elem_array[proc_id%
+			PROCS_REG_CHUNK_SIZE];
+}
+
+/**
+ * Get the register slot corresponding to the given processor Id., growing
+ * the register (directory, chunk and slot locks) as needed.
+ * Must be called with the module instance API critical section locked.
+ */
+static procs_reg_elem_t* procs_reg_elem_create(procs_ctx_t *procs_ctx,
+		int proc_id, log_ctx_t *log_ctx)
+{
+	procs_reg_dir_t *procs_reg_dir, *procs_reg_dir_new;
+	procs_reg_chunk_t *procs_reg_chunk;
+	procs_reg_elem_t *procs_reg_elem;
+	size_t chunk_idx, chunk_array_size;
+	int i, ret_code;
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_ctx!= NULL, return NULL);
+	CHECK_DO(proc_id>= 0 && (size_t)proc_id< procs_ctx->max_procs_num,
+			return NULL);
+
+	/* Check that module instance critical section is locked */
+	ret_code= pthread_mutex_trylock(&procs_ctx->api_mutex);
+	CHECK_DO(ret_code== EBUSY, return NULL);
+
+	chunk_idx= (size_t)proc_id/ PROCS_REG_CHUNK_SIZE;
+
+	/* Grow directory if applicable (doubling its size) */
+	procs_reg_dir= procs_ctx->procs_reg_dir;
+	if(procs_reg_dir== NULL || chunk_idx>= procs_reg_dir->chunk_array_size) {
+		chunk_array_size= (procs_reg_dir!= NULL)?
+				procs_reg_dir->chunk_array_size: 1;
+		while(chunk_array_size<= chunk_idx)
+			chunk_array_size<<= 1;
+		procs_reg_dir_new= (procs_reg_dir_t*)calloc(1, sizeof(procs_reg_dir_t)+
+				chunk_array_size* sizeof(procs_reg_chunk_t*));
+		CHECK_DO(procs_reg_dir_new!= NULL, return NULL);
+		procs_reg_dir_new->chunk_array_size= chunk_array_size;
+		if(procs_reg_dir!= NULL)
+			memcpy(procs_reg_dir_new->chunk_array, procs_reg_dir->chunk_array,
+					procs_reg_dir->chunk_array_size*
+					sizeof(procs_reg_chunk_t*));
+		procs_reg_dir_new->prev= procs_reg_dir;
+		__atomic_store_n(&procs_ctx->procs_reg_dir, procs_reg_dir_new,
+				__ATOMIC_RELEASE);
+		procs_reg_dir= procs_reg_dir_new;
+	}
+
+	/* Allocate chunk if applicable (all slots are initialized FREE) */
+	if((procs_reg_chunk= procs_reg_dir->chunk_array[chunk_idx])== NULL) {
+		procs_reg_chunk= (procs_reg_chunk_t*)calloc(1,
+				sizeof(procs_reg_chunk_t));
+		CHECK_DO(procs_reg_chunk!= NULL, return NULL);
+		for(i= 0; i< PROCS_REG_CHUNK_SIZE; i++) {
+			procs_reg_elem= &procs_reg_chunk->procs_reg_elem_array[i];
+			procs_reg_elem->state= PROCS_REG_ELEM_STATE_FREE;
+			procs_reg_elem->procs_reg_chunk= procs_reg_chunk;
+		}
+		__atomic_store_n(&procs_reg_dir->chunk_array[chunk_idx],
+				procs_reg_chunk, __ATOMIC_RELEASE);
+	}
+	procs_reg_elem= &procs_reg_chunk->procs_reg_elem_array[proc_id%
+			PROCS_REG_CHUNK_SIZE];
+
+	/* Initialize slot locks on first use */
+	if(procs_reg_elem->flag_locks_initialized== 0) {
+		fair_lock_t *fair_lock_io_array[PROC_IO_NUM]= {NULL};
+
+		for(i= 0; i< PROC_IO_NUM; i++) {
+			fair_lock_io_array[i]= fair_lock_open();
+			CHECK_DO(fair_lock_io_array[i]!= NULL, goto failure);
+		}
+		ret_code= pthread_mutex_init(&procs_reg_elem->api_mutex, NULL);
+		CHECK_DO(ret_code== 0, goto failure);
+
+		for(i= 0; i< PROC_IO_NUM; i++)
+			__atomic_store_n(&procs_reg_elem->fair_lock_io_array[i],
+					fair_lock_io_array[i], __ATOMIC_RELEASE);
+		procs_reg_elem->flag_locks_initialized= 1;
+		goto end;
+failure:
+		for(i= 0; i< PROC_IO_NUM; i++)
+			fair_lock_close(&fair_lock_io_array[i]);
+		return NULL;
+	}
+end:
+	return procs_reg_elem;
+}
+
+/**
+ * Get the lowest processor Id. corresponding to a FREE register slot
+ * (allocated or not). Full register chunks are skipped.
+ * Must be called with the module instance API critical section locked.
+ * Note that the returned value may exceed the maximum number of processors.
+ */
+static int procs_reg_get_free_id(procs_ctx_t *procs_ctx)
+{
+	procs_reg_dir_t *procs_reg_dir= procs_ctx->procs_reg_dir;
+	size_t chunk_idx, chunk_array_size;
+	int i;
+
+	chunk_array_size= (procs_reg_dir!= NULL)?
+			procs_reg_dir->chunk_array_size: 0;
+
+	for(chunk_idx= 0; chunk_idx< chunk_array_size; chunk_idx++) {
+		procs_reg_chunk_t *procs_reg_chunk=
+				procs_reg_dir->chunk_array[chunk_idx];
+
+		if(procs_reg_chunk== NULL)
+			return chunk_idx* PROCS_REG_CHUNK_SIZE;
+		if(procs_reg_chunk->used_cnt>= PROCS_REG_CHUNK_SIZE)
+			continue;
+		for(i= 0; i< PROCS_REG_CHUNK_SIZE; i++) {
+			if(procs_reg_chunk->procs_reg_elem_array[i].state==
+					PROCS_REG_ELEM_STATE_FREE)
+				return chunk_idx* PROCS_REG_CHUNK_SIZE+ i;
+		}
+	}
+	return chunk_array_size* PROCS_REG_CHUNK_SIZE;
+}
+
 static int procs_id_opt(procs_ctx_t *procs_ctx, const char *tag,
 		log_ctx_t *log_ctx, va_list arg)
 {
 	procs_reg_elem_t *procs_reg_elem;
-	int procs_reg_elem_array_size, end_code= STAT_ERROR, proc_id= -1;
+	int end_code= STAT_ERROR, proc_id= -1;
 	int flag_procs_api_locked= 0, flag_proc_ctx_api_locked= 0;
 	proc_ctx_t *proc_ctx= NULL;
 	LOG_CTX_INIT(log_ctx);
@@ -1096,9 +2244,14 @@ static int procs_id_opt(procs_ctx_t *procs_ctx, const char *tag,
 
 	/* Lock processor (PROC) API critical section */
 	proc_id= va_arg(arg, int);
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
-	CHECK_DO(proc_id>= 0 && proc_id< procs_reg_elem_array_size, goto end);
-	procs_reg_elem= &procs_ctx->procs_reg_elem_array[proc_id];
+	CHECK_DO(proc_id>= 0 && (size_t)proc_id< procs_ctx->max_procs_num,
+			goto end);
+	procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id);
+	if(procs_reg_elem== NULL ||
+			procs_reg_elem->state!= PROCS_REG_ELEM_STATE_ACTIVE) {
+		end_code= STAT_ENOTFOUND;
+		goto end;
+	}
 	LOCK_PROCS_REG_ELEM_API(procs_ctx, procs_reg_elem, goto end);
 	flag_proc_ctx_api_locked= 1;
 
@@ -1119,6 +2272,15 @@ static int procs_id_opt(procs_ctx_t *procs_ctx, const char *tag,
 	if(TAG_IS("PROCS_ID_GET")) {
 		end_code= procs_id_get(procs_reg_elem, proc_ctx, LOG_CTX_GET(),
 				(void**)va_arg(arg, char**));
+	} else if(TAG_IS("PROCS_ID_GET_COND")) {
+		const char *if_none_match_str= va_arg(arg, const char*);
+		char **ref_rest_str= va_arg(arg, char**);
+		char **ref_etag_str= va_arg(arg, char**);
+		end_code= procs_id_get_cond(procs_reg_elem, proc_ctx, LOG_CTX_GET(),
+				if_none_match_str, ref_rest_str, ref_etag_str);
+	} else if(TAG_IS("PROCS_ID_STATS_GET")) {
+		end_code= procs_id_stats_get(procs_reg_elem, proc_ctx, LOG_CTX_GET(),
+				va_arg(arg, char**));
 	} else if(TAG_IS("PROCS_ID_PUT")) {
 		end_code= proc_opt(proc_ctx, "PROC_PUT", va_arg(arg, const char*));
 	} else if(TAG_IS("PROCS_ID_UNBLOCK")) {
@@ -1156,6 +2318,38 @@ static int procs_id_get(procs_reg_elem_t *procs_reg_elem, proc_ctx_t *proc_ctx,
 	ret_code= pthread_mutex_trylock(&procs_reg_elem->api_mutex);
 	CHECK_DO(ret_code== EBUSY, goto end);
 
+	/* If the processor supports it, write the REST response directly (no
+	 * intermediate cJSON tree is built). The 'proc_name' is written at the
+	 * top of the 'settings' object by the writer itself.
+	 */
+	if(proc_ctx->proc_if->rest_get_stream!= NULL) {
+		json_writer_ctx_t *json_writer_ctx;
+		const char *rest_str= NULL; // Do not release
+
+		if((json_writer_ctx= procs_reg_elem->json_writer_ctx)== NULL) {
+			json_writer_ctx= procs_reg_elem->json_writer_ctx=
+					json_writer_open(0);
+			CHECK_DO(json_writer_ctx!= NULL, goto end);
+		}
+		json_writer_reset(json_writer_ctx);
+
+		ret_code= json_writer_set_object_prefix(json_writer_ctx, "settings",
+				"proc_name", proc_ctx->proc_if->proc_name);
+		CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+		ret_code= proc_opt(proc_ctx, "PROC_GET_JSON_WRITER", json_writer_ctx);
+		CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+		rest_str= json_writer_get_str(json_writer_ctx, NULL);
+		CHECK_DO(rest_str!= NULL, goto end);
+		*ref_reponse= (void*)strdup(rest_str);
+		CHECK_DO(*ref_reponse!= NULL && strlen((char*)*ref_reponse)> 0,
+				goto end);
+
+		end_code= STAT_SUCCESS;
+		goto end;
+	}
+
 	/* GET processor's REST response */
 	ret_code= proc_opt(proc_ctx, "PROC_GET", PROC_IF_REST_FMT_CJSON,
 			&cjson_rest);
@@ -1197,6 +2391,107 @@ end:
 	return end_code;
 }
 
+/**
+ * Conditional GET of the processor representational state.
+ * The entity-tag is the processor settings version (see
+ * 'proc_ctx_s::settings_version'); if it matches the given 'If-None-Match'
+ * value, STAT_NOTMODIFIED is returned and the representation is not
+ * composed at all.
+ */
+static int procs_id_get_cond(procs_reg_elem_t *procs_reg_elem,
+		proc_ctx_t *proc_ctx, log_ctx_t *log_ctx, const char *if_none_match_str,
+		char **ref_rest_str, char **ref_etag_str)
+{
+	int ret_code, end_code= STAT_ERROR;
+	char etag[32]= {0};
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_reg_elem!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	//log_ctx allowed to be NULL
+	//if_none_match_str allowed to be NULL
+	CHECK_DO(ref_rest_str!= NULL, return STAT_ERROR);
+	CHECK_DO(ref_etag_str!= NULL, return STAT_ERROR);
+
+	*ref_rest_str= NULL;
+	*ref_etag_str= NULL;
+
+	/* Check that processor API level critical section is locked (settings
+	 * version can not change while we hold it).
+	 */
+	ret_code= pthread_mutex_trylock(&procs_reg_elem->api_mutex);
+	CHECK_DO(ret_code== EBUSY, goto end);
+
+	/* Compose entity-tag (quoted, as it goes "as is" in the HTTP header) */
+	snprintf(etag, sizeof(etag), "\"%"PRIu64"\"", proc_ctx->settings_version);
+	*ref_etag_str= strdup(etag);
+	CHECK_DO(*ref_etag_str!= NULL, goto end);
+
+	/* Check 'If-None-Match' (may be a list of entity-tags or "*") */
+	if(if_none_match_str!= NULL && (strstr(if_none_match_str, etag)!= NULL ||
+			strcmp(if_none_match_str, "*")== 0)) {
+		end_code= STAT_NOTMODIFIED;
+		goto end;
+	}
+
+	end_code= procs_id_get(procs_reg_elem, proc_ctx, LOG_CTX_GET(),
+			(void**)ref_rest_str);
+end:
+	if(end_code!= STAT_SUCCESS && end_code!= STAT_NOTMODIFIED) {
+		if(*ref_etag_str!= NULL) {
+			free(*ref_etag_str);
+			*ref_etag_str= NULL;
+		}
+	}
+	return end_code;
+}
+
+/**
+ * Get the processor statistics (generic statistics, see
+ * 'PROC_STATS_FIELDS', and processor's specific statistics, see
+ * 'proc_if_s::stats_get_stream()').
+ */
+static int procs_id_stats_get(procs_reg_elem_t *procs_reg_elem,
+		proc_ctx_t *proc_ctx, log_ctx_t *log_ctx, char **ref_rest_str)
+{
+	int ret_code, end_code= STAT_ERROR;
+	json_writer_ctx_t *json_writer_ctx;
+	const char *rest_str= NULL; // Do not release
+	LOG_CTX_INIT(log_ctx);
+
+	/* Check arguments */
+	CHECK_DO(procs_reg_elem!= NULL, return STAT_ERROR);
+	CHECK_DO(proc_ctx!= NULL, return STAT_ERROR);
+	//log_ctx allowed to be NULL
+	CHECK_DO(ref_rest_str!= NULL, return STAT_ERROR);
+
+	*ref_rest_str= NULL;
+
+	/* Check that processor API level critical section is locked */
+	ret_code= pthread_mutex_trylock(&procs_reg_elem->api_mutex);
+	CHECK_DO(ret_code== EBUSY, goto end);
+
+	if((json_writer_ctx= procs_reg_elem->json_writer_ctx)== NULL) {
+		json_writer_ctx= procs_reg_elem->json_writer_ctx= json_writer_open(0);
+		CHECK_DO(json_writer_ctx!= NULL, goto end);
+	}
+	json_writer_reset(json_writer_ctx);
+
+	ret_code= proc_opt(proc_ctx, "PROC_GET_STATS_JSON_WRITER",
+			json_writer_ctx);
+	CHECK_DO(ret_code== STAT_SUCCESS, goto end);
+
+	rest_str= json_writer_get_str(json_writer_ctx, NULL);
+	CHECK_DO(rest_str!= NULL, goto end);
+	*ref_rest_str= strdup(rest_str);
+	CHECK_DO(*ref_rest_str!= NULL, goto end);
+
+	end_code= STAT_SUCCESS;
+end:
+	return end_code;
+}
+
 /**
  * This function fetches the processor context structure to be used for
  * API options requests.
@@ -1216,7 +2511,7 @@ static proc_ctx_t* procs_id_opt_fetch_proc_ctx(procs_ctx_t *procs_ctx,
 {
 	va_list arg_cpy, va_list_empty;
 	procs_reg_elem_t *procs_reg_elem;
-	int procs_reg_elem_array_size, ret_code;
+	int ret_code;
 	int flag_is_query= 0; // 0-> JSON / 1->query string
 	proc_ctx_t *proc_ctx_ret= NULL, *proc_ctx_curr= NULL, *proc_ctx_new= NULL;
 	const char *settings_str_arg= NULL; // Do not release
@@ -1231,14 +2526,13 @@ static proc_ctx_t* procs_id_opt_fetch_proc_ctx(procs_ctx_t *procs_ctx,
 
 	/* Check arguments */
 	CHECK_DO(procs_ctx!= NULL, return NULL);
-	procs_reg_elem_array_size= procs_ctx->procs_reg_elem_array_size;
-	CHECK_DO(proc_id>= 0 && proc_id< procs_reg_elem_array_size, return NULL);
 	CHECK_DO(tag!= NULL, return NULL);
 	//arg nothing to check
 	//log_ctx allowed to be NULL
 
 	/* Get register element and current processor references */
-	procs_reg_elem= &procs_ctx->procs_reg_elem_array[proc_id];
+	procs_reg_elem= procs_reg_elem_lookup(procs_ctx, proc_id);
+	CHECK_DO(procs_reg_elem!= NULL, return NULL);
 	proc_ctx_curr= procs_reg_elem->proc_ctx;
 	if(proc_ctx_curr== NULL)
 		goto end;
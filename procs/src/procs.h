@@ -61,6 +61,8 @@ void procs_module_close();
  * The following options are available:
  *     -# "PROCS_REGISTER_TYPE"
  *     -# "PROCS_UNREGISTER_TYPE"
+ *     -# "PROCS_GET_TYPE"
+ *     -# "PROCS_SET_CAPTURE_DIR"
  *     .
  * @param ... Variable list of parameters according to selected option. Refer
  * to <b>Tags description</b> below to see the different additional parameters
@@ -119,6 +121,20 @@ void procs_module_close();
  * ret_code= procs_module_opt("PROCS_GET_TYPE", "bypass_processor",
  * 		&proc_if_cpy);
  * @endcode
+ *
+ * <li> <b>Tag "PROCS_SET_CAPTURE_DIR":</b><br>
+ * Set the directory where the processors frame captures are created and
+ * replayed from (see generic setting "capture" at .proc.h). Intended to be
+ * set at application start-up; it is restored to the default
+ * ('PROC_CAPTURE_DIR_DEFAULT' at .proc_capture.h) when the module is
+ * closed.<br>
+ * Additional variable arguments for function procs_module_opt() are:<br>
+ * @param dir_name Pointer to a character string with the absolute path of
+ * the capture directory (NULL restores the default directory).
+ * Code example:
+ * @code
+ * ret_code= procs_module_opt("PROCS_SET_CAPTURE_DIR", "/var/lib/captures");
+ * @endcode
  * </ul>
  */
 int procs_module_opt(const char *tag, ...);
@@ -128,7 +144,8 @@ int procs_module_opt(const char *tag, ...);
  * structure.
  * @param log_ctx Pointer to the LOG module context structure.
  * @param max_procs_num Maximum number of processors that can be created
- * (and managed) by this instance.
+ * (and managed) by this instance. Processors register grows on demand, thus
+ * this value does not imply any preallocation.
  * @param prefix_name Module's API REST prefix name (256 characters maximum).
  * This parameter is optional (NULL may be passed); if not specified, the
  * default name "procs" is used.
@@ -171,9 +188,20 @@ void procs_close(procs_ctx_t **ref_procs_ctx);
  * @param tag Processors option tag, namely, option identifier string.
  * The following options are available:
  *     -# "PROCS_POST"
+ *     -# "PROCS_POST_ID"
  *     -# "PROCS_GET"
+ *     -# "PROCS_GET_FIELDS"
+ *     -# "PROCS_GET_METRICS"
+ *     -# "PROCS_STATS_SHM_OPEN"
+ *     -# "PROCS_STATS_SHM_CLOSE"
+ *     -# "PROCS_TRACE_START"
+ *     -# "PROCS_TRACE_STOP"
+ *     -# "PROCS_TRACE_GET"
  *     -# "PROCS_ID_DELETE"
+ *     -# "PROCS_ID_DELETE_ASYNC"
  *     -# "PROCS_ID_GET"
+ *     -# "PROCS_ID_GET_COND"
+ *     -# "PROCS_ID_STATS_GET"
  *     -# "PROCS_ID_PUT"
  *     .
  * @param ... Variable list of parameters according to selected option. Refer
@@ -202,6 +230,24 @@ void procs_close(procs_ctx_t **ref_procs_ctx);
  *     "setting1=100", &rest_str);
  * @endcode
  *
+ * <li> <b>Tag "PROCS_POST_ID":</b><br>
+ * Same as "PROCS_POST", but the processor identifier is returned as an
+ * integer (no JSON response to be parsed).<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param proc_name Pointer to a character string with the unambiguous
+ * processor type name.
+ * @param settings_str Character string containing initial settings for
+ * the processor. String format can be either a query-string or JSON.
+ * @param ref_proc_id Reference to the integer returning the processor
+ * identifier (set to -1 on failure).
+ * Code example:
+ * @code
+ * int proc_id= -1;
+ * ...
+ * ret_code= procs_opt(procs_ctx, "PROCS_POST_ID", "bypass_processor",
+ *     "setting1=100", &proc_id);
+ * @endcode
+ *
  * <li> <b>Tag "PROCS_GET":</b><br>
  * Get the representational state of the processors instances list.<br>
  * Additional variable arguments for function procs_opt() are:<br>
@@ -221,8 +267,110 @@ void procs_close(procs_ctx_t **ref_procs_ctx);
  * ret_code= procs_opt(procs_ctx, "PROCS_GET", &rest_str, NULL);
  * @endcode
  *
+ * <li> <b>Tag "PROCS_GET_FIELDS":</b><br>
+ * Get the selected fields of all the (filtered) processors instances in one
+ * response (e.g. for collecting statistics). The list is the same as for
+ * "PROCS_GET", but each processor element includes the selected fields
+ * instead of the "links" (see tag "PROC_GET_FIELDS" in proc.h);
+ * processors being created or deleted are not listed.<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param ref_str Reference to the pointer to a character string
+ * returning the processors list representational state.
+ * @param filter_str Filter as described for tag "PROCS_GET" (optional, can
+ * be set to NULL).
+ * @param fields_str Comma-separated list of field names.
+ * Code example:
+ * @code
+ * char *rest_str= NULL;
+ * ...
+ * ret_code= procs_opt(procs_ctx, "PROCS_GET_FIELDS", &rest_str, NULL,
+ *     "latency_avg_usec,bitrate_oput");
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_GET_METRICS":</b><br>
+ * Get the metrics of all the processors instances in the Prometheus text
+ * exposition format (bitrate, latency, FIFO levels, frame counters and
+ * processing thread CPU time, labelled by 'proc_id', 'proc_name' and 'proc_type'). Metrics are
+ * rendered directly from the processors counters, in one pass of the
+ * register.<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param ref_str Reference to the pointer to a character string
+ * returning the metrics text.
+ * Code example:
+ * @code
+ * char *metrics_str= NULL;
+ * ...
+ * ret_code= procs_opt(procs_ctx, "PROCS_GET_METRICS", &metrics_str);
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_STATS_SHM_OPEN":</b><br>
+ * Start publishing the processors counters (bitrate, latency, FIFO levels,
+ * frame counters and CPU time) in a POSIX shared-memory page, refreshed
+ * periodically. The page has a fixed binary layout (see procs_stats_shm.h)
+ * and each element is protected by a sequence lock, thus monitoring agents
+ * can map it read-only and poll it without any call to this module.
+ * Only one page can be published per module instance. The page is always
+ * created anew with owner-only permissions: an existing shared-memory
+ * object with the same name (e.g. left behind by a terminated process) is
+ * unlinked and replaced.<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param shm_name Shared memory object name (e.g. "/mediaprocs_stats"; refer
+ * to shm_open()).
+ * @param period_usec Publishing period in microseconds (zero selects the
+ * default period).
+ * Code example:
+ * @code
+ * ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_OPEN", "/mediaprocs_stats",
+ *     0);
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_STATS_SHM_CLOSE":</b><br>
+ * Stop publishing the statistics page and unlink it. The page is also
+ * released by procs_close().<br>
+ * No additional arguments are used.
+ * Code example:
+ * @code
+ * ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_CLOSE");
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_TRACE_START":</b><br>
+ * Start a per-frame trace capture (see trace.h). While the capture is
+ * running, the processors record the begin/end of each processing call and
+ * the frames enqueued/dequeued at their FIFO's (with the frame counter and
+ * PTS). Tracing is process-wide: it applies to all the module instances.
+ * Events of a previous capture are discarded.<br>
+ * No additional arguments are used.
+ * Code example:
+ * @code
+ * ret_code= procs_opt(procs_ctx, "PROCS_TRACE_START");
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_TRACE_STOP":</b><br>
+ * Stop the running trace capture.<br>
+ * No additional arguments are used.
+ * Code example:
+ * @code
+ * ret_code= procs_opt(procs_ctx, "PROCS_TRACE_STOP");
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_TRACE_GET":</b><br>
+ * Get the events of the last (stopped) trace capture in the Chrome trace
+ * event JSON format.<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param ref_str Reference to the pointer to a character string
+ * returning the trace.
+ * Code example:
+ * @code
+ * char *trace_str= NULL;
+ * ...
+ * ret_code= procs_opt(procs_ctx, "PROCS_TRACE_GET", &trace_str);
+ * @endcode
+ *
  * <li> <b>Tag "PROCS_ID_DELETE":</b><br>
  * Unregister and release a processor instance.<br>
+ * The call returns when the processor is completely released; nevertheless,
+ * other API calls on this module instance are not blocked while the
+ * processor is being closed.<br>
  * Additional variable arguments for function procs_opt() are:<br>
  * @param proc_id Processor instance unambiguous Id.
  * Code example:
@@ -230,9 +378,23 @@ void procs_close(procs_ctx_t **ref_procs_ctx);
  * ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", proc_id);
  * @endcode
  *
+ * <li> <b>Tag "PROCS_ID_DELETE_ASYNC":</b><br>
+ * Same as "PROCS_ID_DELETE", but the call returns as soon as the processor
+ * is unregistered; the processor is closed and released in a background
+ * thread. Until then, the processor is listed by "PROCS_GET" with
+ * '"state":"deleting"' and its Id. can not be reused. procs_close() waits
+ * for any pending deletion to finish.<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param proc_id Processor instance unambiguous Id.
+ * Code example:
+ * @code
+ * ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE_ASYNC", proc_id);
+ * @endcode
+ *
  * <li> <b>Tag "PROCS_ID_GET":</b><br>
  * Get the representational state of a processor instance (including
- * current settings).<br>
+ * current settings). Volatile statistics are not included (see
+ * "PROCS_ID_STATS_GET").<br>
  * Additional variable arguments for function procs_opt() are:<br>
  * @param proc_id Processor instance unambiguous Id.
  * @param ref_str Reference to the pointer to a character string
@@ -244,6 +406,50 @@ void procs_close(procs_ctx_t **ref_procs_ctx);
  * ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", proc_id, &rest_str);
  * @endcode
  *
+ * <li> <b>Tag "PROCS_ID_GET_COND":</b><br>
+ * Conditional version of "PROCS_ID_GET". The processor representational
+ * state is only composed if the given 'If-None-Match' value does not match
+ * the current entity-tag of the processor; otherwise, STAT_NOTMODIFIED is
+ * returned. The entity-tag changes on every successful settings PUT or
+ * processor specific option (e.g. registering a multiplexer's elementary
+ * stream).<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param proc_id Processor instance unambiguous Id.
+ * @param if_none_match_str Character string with the entity-tag(s) known by
+ * the client (as in the HTTP 'If-None-Match' header); may be NULL.
+ * @param ref_str Reference to the pointer to a character string
+ * returning the processor's representational state (NULL is returned if
+ * not modified).
+ * @param ref_etag_str Reference to the pointer to a character string
+ * returning the current (quoted) entity-tag of the processor.
+ * Code example:
+ * @code
+ * char *rest_str= NULL, *etag_str= NULL;
+ * ...
+ * ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", proc_id,
+ *     if_none_match_str, &rest_str, &etag_str);
+ * @endcode
+ *
+ * <li> <b>Tag "PROCS_ID_STATS_GET":</b><br>
+ * Get the statistics of a processor instance (e.g.
+ * '{"latency_avg_usec":number,...}', according to the processor
+ * features). Processors running the generic processing thread also report
+ * the thread CPU time ("cpu_time_usec"), the CPU usage percentage
+ * ("cpu_usage") and the average time per frame spent waiting for input,
+ * processing and waiting for output room ("stage_iput_wait_usec",
+ * "stage_process_usec" and "stage_oput_wait_usec"). Processor specific
+ * statistics (e.g. frame counters) follow the generic ones.<br>
+ * Additional variable arguments for function procs_opt() are:<br>
+ * @param proc_id Processor instance unambiguous Id.
+ * @param ref_str Reference to the pointer to a character string
+ * returning the processor's statistics.
+ * Code example:
+ * @code
+ * char *rest_str= NULL;
+ * ...
+ * ret_code= procs_opt(procs_ctx, "PROCS_ID_STATS_GET", proc_id, &rest_str);
+ * @endcode
+ *
  * <li> <b>Tag "PROCS_ID_PUT":</b><br>
  * Put (pass) new settings to a processor instance.<br>
  * Additional variable arguments for function procs_opt() are:<br>
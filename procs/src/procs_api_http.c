@@ -82,18 +82,37 @@
 int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 		const char *query_string, const char *request_method, char *content,
 		size_t content_len, char **ref_str_response)
+{
+	int end_code;
+	char *etag_str= NULL;
+
+	end_code= procs_api_http_req_handler_etag(procs_ctx, url, query_string,
+			request_method, NULL, content, content_len, ref_str_response,
+			&etag_str);
+	if(etag_str!= NULL)
+		free(etag_str);
+	return end_code;
+}
+
+int procs_api_http_req_handler_etag(procs_ctx_t *procs_ctx, const char *url,
+		const char *query_string, const char *request_method,
+		const char *if_none_match, char *content, size_t content_len,
+		char **ref_str_response, char **ref_etag_str)
 {
 	int proc_id, ret_code, end_code= STAT_ERROR;
 	int64_t aux_id= -1;
 	char *proc_name_str= NULL, *data_obj_str= NULL, *response_str= NULL;
+	char *fields_str= NULL, *filter_str= NULL, *action_str= NULL;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments.
-	 * NOTE: Arguments 'query_string' and 'content' are allowed to be NULL.
+	 * NOTE: Arguments 'query_string', 'if_none_match' and 'content' are
+	 * allowed to be NULL.
 	 */
 	CHECK_DO(url!= NULL, return STAT_ERROR);
 	CHECK_DO(request_method!= NULL, return STAT_ERROR);
 	CHECK_DO(ref_str_response!= NULL, return STAT_ERROR);
+	CHECK_DO(ref_etag_str!= NULL, return STAT_ERROR);
 
 	//LOGV("\n//----------------------------------------------------------//\n"
 	//		"HTTP REQUEST: url: '%s?%s'; request_method: %s\n"
@@ -101,6 +120,7 @@ int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 	//				request_method, (int)content_len, content); //comment-me
 
 	*ref_str_response= NULL;
+	*ref_etag_str= NULL;
 
 	/* Check 'PROCS' URL tree root existence */
 	if(!URL_HAS("/procs")) {
@@ -108,7 +128,50 @@ int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 		goto end;
 	}
 
-	if(URL_HAS("/procs.json")) {
+	if(URL_HAS("/procs/metrics")) {
+
+		/* **** Handle PROCS metrics requests ****
+		 * Metrics are returned "as is" (text exposition format, not wrapped
+		 * in a JSON response).
+		 */
+		if(URL_METHOD_IS("GET")) {
+			end_code= procs_opt(procs_ctx, "PROCS_GET_METRICS",
+					ref_str_response);
+		} else {
+			end_code= STAT_ENOTFOUND;
+		}
+		goto end;
+	} else if(URL_HAS("/procs/trace.json")) {
+
+		/* **** Handle PROCS trace download requests ****
+		 * Trace is returned "as is" (Chrome trace event JSON format, not
+		 * wrapped in a JSON response).
+		 */
+		if(URL_METHOD_IS("GET")) {
+			end_code= procs_opt(procs_ctx, "PROCS_TRACE_GET",
+					ref_str_response);
+		} else {
+			end_code= STAT_ENOTFOUND;
+		}
+		goto end;
+	} else if(URL_HAS("/procs/trace")) {
+
+		/* **** Handle PROCS trace capture control requests ****
+		 * Query-string parameter "action" is mandatory ("start" or "stop").
+		 */
+		if(URL_METHOD_IS("PUT") && query_string!= NULL &&
+				(action_str= uri_parser_query_str_get_value("action",
+						query_string))!= NULL) {
+			if(strcmp(action_str, "start")== 0)
+				end_code= procs_opt(procs_ctx, "PROCS_TRACE_START");
+			else if(strcmp(action_str, "stop")== 0)
+				end_code= procs_opt(procs_ctx, "PROCS_TRACE_STOP");
+			else
+				end_code= STAT_EINVAL;
+		} else {
+			end_code= STAT_ENOTFOUND;
+		}
+	} else if(URL_HAS("/procs.json")) {
 
 		/* **** Handle PROCS list related requests **** */
 
@@ -130,7 +193,32 @@ int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 					query_string, &data_obj_str);
 
 		} else if(URL_METHOD_IS("GET")) {
-			end_code= procs_opt(procs_ctx, "PROCS_GET", &data_obj_str, NULL);
+
+			/* Query-string parameters (both optional):
+			 * - "fields": comma-separated list of fields to be returned for
+			 * each processor (e.g. 'fields=latency_avg_usec,bitrate_oput');
+			 * - "proc_name": only list processors of the given type.
+			 */
+			if(query_string!= NULL) {
+				fields_str= uri_parser_query_str_get_value("fields",
+						query_string);
+				proc_name_str= uri_parser_query_str_get_value("proc_name",
+						query_string);
+			}
+			if(proc_name_str!= NULL) {
+				size_t filter_size= strlen("proc_name==")+
+						strlen(proc_name_str)+ 1;
+				filter_str= (char*)malloc(filter_size);
+				CHECK_DO(filter_str!= NULL, goto end);
+				snprintf(filter_str, filter_size, "proc_name==%s",
+						proc_name_str);
+			}
+			if(fields_str!= NULL)
+				end_code= procs_opt(procs_ctx, "PROCS_GET_FIELDS",
+						&data_obj_str, filter_str, fields_str);
+			else
+				end_code= procs_opt(procs_ctx, "PROCS_GET", &data_obj_str,
+						filter_str);
 		} else {
 			end_code= STAT_ENOTFOUND;
 		}
@@ -147,12 +235,19 @@ int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 			goto end;
 		}
 
-		if(URL_METHOD_IS("PUT"))
+		if(URL_HAS("/stats")) {
+			/* Processor statistics sub-resource (volatile; not tagged) */
+			if(URL_METHOD_IS("GET"))
+				end_code= procs_opt(procs_ctx, "PROCS_ID_STATS_GET", proc_id,
+						&data_obj_str);
+			else
+				end_code= STAT_ENOTFOUND;
+		} else if(URL_METHOD_IS("PUT"))
 			end_code= procs_opt(procs_ctx, "PROCS_ID_PUT", proc_id,
 					query_string);
 		else if (URL_METHOD_IS("GET"))
-			end_code= procs_opt(procs_ctx, "PROCS_ID_GET", proc_id,
-					&data_obj_str);
+			end_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", proc_id,
+					if_none_match, &data_obj_str, ref_etag_str);
 		//else if(URL_METHOD_IS("DELETE"))
 		//	end_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", proc_id);
 		else
@@ -169,6 +264,12 @@ int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 end:
 	if(proc_name_str!= NULL)
 		free(proc_name_str);
+	if(fields_str!= NULL)
+		free(fields_str);
+	if(filter_str!= NULL)
+		free(filter_str);
+	if(action_str!= NULL)
+		free(action_str);
 	if(data_obj_str!= NULL)
 		free(data_obj_str);
 	if(response_str!= NULL)
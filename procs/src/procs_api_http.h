@@ -49,6 +49,42 @@ int procs_api_http_req_handler(procs_ctx_t *procs_ctx, const char *url,
 		const char *query_string, const char *request_method, char *content,
 		size_t content_len, char **ref_str_response);
 
+/**
+ * HTTP-API request handler function supporting conditional requests.
+ * Same as 'procs_api_http_req_handler()', but processor instance GET
+ * requests ('/procs/<id>.json') are answered with an entity-tag; if the
+ * given 'If-None-Match' header value matches the current entity-tag,
+ * STAT_NOTMODIFIED is returned (HTTP 304) without composing the processor
+ * representational state.
+ * Processor statistics are available as a separate sub-resource
+ * ('/procs/<id>/stats.json'), not subject to the entity-tag.
+ * Metrics of all the processors are available in the Prometheus text
+ * exposition format at '/procs/metrics'; this response is returned "as is"
+ * (it is not wrapped in a JSON response).
+ * A per-frame trace capture is started/stopped with
+ * 'PUT /procs/trace?action=start|stop', and the captured trace is downloaded
+ * "as is" (Chrome trace event JSON format) at '/procs/trace.json'.
+ * @param procs_ctx
+ * @param url
+ * @param query_string
+ * @param request_method
+ * @param if_none_match Value of the HTTP 'If-None-Match' request header
+ * (may be NULL).
+ * @param content
+ * @param content_len
+ * @param ref_str_response Reference to the pointer to a character string
+ * returning the representational state associated with this request.
+ * @param ref_etag_str Reference to the pointer to a character string
+ * returning the entity-tag to be set in the HTTP 'ETag' response header
+ * (NULL is returned if not applicable).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int procs_api_http_req_handler_etag(procs_ctx_t *procs_ctx, const char *url,
+		const char *query_string, const char *request_method,
+		const char *if_none_match, char *content, size_t content_len,
+		char **ref_str_response, char **ref_etag_str);
+
 /**
  * //TODO
  */
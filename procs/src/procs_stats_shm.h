@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2017 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file procs_stats_shm.h
+ * @brief Processors statistics shared-memory page.
+ * The PROCS module can publish the counters of each processor in a POSIX
+ * shared-memory segment (see tag "PROCS_STATS_SHM_OPEN" in procs.h), so that
+ * external agents can map it read-only and sample it at any rate without
+ * using the PROCS API at all.
+ *
+ * The segment layout is fixed and versioned: a header
+ * ('procs_stats_shm_hdr_t') followed by an array of processor elements
+ * ('procs_stats_shm_elem_t') indexed by processor Id.
+ * Each element is protected by a sequence lock: the writer makes the
+ * sequence number odd while updating the element, and even again when done.
+ * Readers should use 'procs_stats_shm_elem_read()' to obtain a consistent
+ * copy of an element.
+ *
+ * This header only depends on the C standard library, so it can be used by
+ * external agents as is.
+ * @author Rafael Antoniello
+ */
+
+#ifndef MEDIAPROCESSORS_SRC_PROCS_STATS_SHM_H_
+#define MEDIAPROCESSORS_SRC_PROCS_STATS_SHM_H_
+
+#include <inttypes.h>
+#include <string.h>
+
+/* **** Definitions **** */
+
+/**
+ * Statistics page magic number ("MPST").
+ */
+#define PROCS_STATS_SHM_MAGIC 0x4d505354
+
+/**
+ * Statistics page layout (schema) version. Increment on any change of
+ * 'procs_stats_shm_hdr_t' or 'procs_stats_shm_elem_t'.
+ */
+#define PROCS_STATS_SHM_VERSION 1
+
+/**
+ * Maximum number of processor elements in the statistics page.
+ */
+#define PROCS_STATS_SHM_ELEM_MAX 4096
+
+/**
+ * Processor element flag: element corresponds to a registered processor.
+ */
+#define PROCS_STATS_SHM_ELEM_FLAG_ACTIVE 1
+
+/**
+ * Maximum length of processor name and type strings (including the
+ * terminating null character).
+ */
+#define PROCS_STATS_SHM_NAME_SIZE 64
+
+/**
+ * Statistics page header.
+ */
+typedef struct procs_stats_shm_hdr_s {
+	/**
+	 * Magic number (PROCS_STATS_SHM_MAGIC).
+	 */
+	uint32_t magic;
+	/**
+	 * Layout version (PROCS_STATS_SHM_VERSION).
+	 */
+	uint32_t version;
+	/**
+	 * Size of this header, in bytes (processor elements array starts at this
+	 * offset).
+	 */
+	uint32_t hdr_size;
+	/**
+	 * Size of each processor element, in bytes.
+	 */
+	uint32_t elem_size;
+	/**
+	 * Number of processor elements in the page.
+	 */
+	uint32_t elem_num;
+	uint32_t reserved;
+	/**
+	 * Publishing period, in microseconds.
+	 */
+	uint64_t period_usec;
+	/**
+	 * Monotonic time of the last publishing, in nanoseconds.
+	 */
+	volatile uint64_t update_nsec;
+} procs_stats_shm_hdr_t;
+
+/**
+ * Statistics page processor element.
+ */
+typedef struct procs_stats_shm_elem_s {
+	/**
+	 * Sequence lock number (odd while the element is being updated).
+	 */
+	volatile uint32_t seq;
+	/**
+	 * Element flags (e.g. PROCS_STATS_SHM_ELEM_FLAG_ACTIVE).
+	 */
+	uint32_t flags;
+	/**
+	 * Processor Id.
+	 */
+	int32_t proc_id;
+	uint32_t reserved;
+	/**
+	 * Processor type name and type (null-terminated).
+	 */
+	char proc_name[PROCS_STATS_SHM_NAME_SIZE];
+	char proc_type[PROCS_STATS_SHM_NAME_SIZE];
+	/**
+	 * Input/output bitrate [bits per second].
+	 */
+	int64_t bitrate[2];
+	/**
+	 * Latency statistics [microseconds].
+	 */
+	int64_t latency_avg_usec;
+	int64_t latency_max_usec;
+	int64_t latency_min_usec;
+	/**
+	 * Input/output FIFO levels [number of frames].
+	 */
+	int64_t fifo_level[2];
+	/**
+	 * Input/output frame counters and input dropped frames counter.
+	 */
+	uint64_t frame_cnt[2];
+	uint64_t frame_drop_cnt;
+	/**
+	 * Processing thread CPU time [nanoseconds] (zero if not available, see
+	 * 'proc_ctx_s::cpu_time_nsec').
+	 */
+	uint64_t cpu_time_nsec;
+} procs_stats_shm_elem_t;
+
+/* **** Implementations **** */
+
+/**
+ * Get a consistent copy of a processor element of the statistics page.
+ * @param elem Pointer to the processor element in the (mapped) page.
+ * @param elem_cpy Pointer to the structure where the element is copied.
+ * @param max_retries Maximum number of attempts if the element is being
+ * updated concurrently.
+ * @return Zero on success, -1 if a consistent copy could not be obtained.
+ */
+static inline int procs_stats_shm_elem_read(
+		const volatile procs_stats_shm_elem_t *elem,
+		procs_stats_shm_elem_t *elem_cpy, int max_retries)
+{
+	uint32_t seq1, seq2;
+
+	do {
+		seq1= __atomic_load_n(&elem->seq, __ATOMIC_ACQUIRE);
+		if((seq1& 1)== 0) {
+			memcpy(elem_cpy, (const void*)elem,
+					sizeof(procs_stats_shm_elem_t));
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			seq2= __atomic_load_n(&elem->seq, __ATOMIC_RELAXED);
+			if(seq1== seq2)
+				return 0;
+		}
+	} while(max_retries-- > 0);
+	return -1;
+}
+
+#endif /* MEDIAPROCESSORS_SRC_PROCS_STATS_SHM_H_ */
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_procs.cpp
+ * @brief PROCS I/O round-trip micro-benchmark.
+ * Each client thread owns a bypass processor and repeatedly sends a frame
+ * ('procs_send_frame()') and receives it back ('procs_recv_frame()'), so
+ * the whole data path (input FIFO, processing thread, output FIFO and the
+ * frame duplications on both ends) is measured for each round-trip.
+ * The frames are one-dimensional (a single data plane of one line) with
+ * the requested size.
+ * One JSON line is printed per case with the round-trips per second (all
+ * the threads) and the round-trip latency percentiles.
+ * Usage:
+ * mediaprocs_bench [-t threads] [-s frame_sizes] [-d msecs]
+ * where lists are comma separated.
+ * @author Rafael Antoniello
+ */
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/bench_stats.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/procs.h>
+}
+
+#include "bypass_proc.h"
+
+/* **** Definitions **** */
+
+#define BENCH_THREADS_DEFAULT "1,2,4,8,16,32,64"
+#define BENCH_SIZES_DEFAULT "64,4096,65536,1048576,12582912"
+#define BENCH_MSECS_DEFAULT 1000
+#define BENCH_LIST_MAX 16
+#define BENCH_THREADS_MAX 64
+
+/**
+ * Cases needing more memory than this (each round-trip keeps up to
+ * 'BENCH_FRAME_COPIES' copies of the frame alive per thread) are skipped.
+ */
+#define BENCH_MEMORY_MAX (1024LL* 1024* 1024)
+#define BENCH_FRAME_COPIES 4
+
+#define BENCH_LATENCY_SAMPLES_MAX 16384
+
+/**
+ * Benchmark thread context structure.
+ */
+typedef struct bench_thr_ctx_s {
+	pthread_t thread;
+	procs_ctx_t *procs_ctx;
+	int proc_id;
+	const proc_frame_ctx_t *proc_frame_ctx;
+	volatile int *ref_flag_exit;
+	uint64_t ops;
+	uint64_t errors;
+	bench_stats_ctx_t *latency_stats;
+} bench_thr_ctx_t;
+
+/**
+ * Bypass processor interface (see "bypass_proc.h").
+ */
+static const proc_if_t proc_if_bench_bypass= {
+	"bench_bypass", "encoder", "application/octet-stream",
+	(uint64_t)(PROC_FEATURE_BITRATE|PROC_FEATURE_REGISTER_PTS|
+			PROC_FEATURE_LATENCY),
+	bypass_proc_open,
+	bypass_proc_close,
+	proc_send_frame_default1,
+	NULL, // no 'send-no-dup'
+	proc_recv_frame_default1,
+	NULL, // no specific unblock function extension
+	bypass_proc_rest_put,
+	bypass_proc_rest_get,
+	bypass_proc_process_frame,
+	NULL,
+	(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+	(void(*)(void**))proc_frame_ctx_release,
+	(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+};
+
+/* **** Implementations **** */
+
+static void* bench_client_thr(void *t)
+{
+	int ret_code;
+	int64_t seq, t0_usecs;
+	proc_frame_ctx_t proc_frame_ctx, *proc_frame_ctx_recv= NULL;
+	bench_thr_ctx_t *bench_thr_ctx= (bench_thr_ctx_t*)t;
+
+	schedule_set_thread_name("bench-client");
+
+	/* Shallow copy: data is duplicated when sent to the processor */
+	memcpy(&proc_frame_ctx, bench_thr_ctx->proc_frame_ctx,
+			sizeof(proc_frame_ctx));
+
+	for(seq= 1; *bench_thr_ctx->ref_flag_exit== 0; seq++) {
+		proc_frame_ctx.pts= proc_frame_ctx.dts= seq;
+
+		t0_usecs= bench_now_usecs();
+		ret_code= procs_send_frame(bench_thr_ctx->procs_ctx,
+				bench_thr_ctx->proc_id, &proc_frame_ctx);
+		if(ret_code!= STAT_SUCCESS) {
+			bench_thr_ctx->errors++;
+			break;
+		}
+		ret_code= procs_recv_frame(bench_thr_ctx->procs_ctx,
+				bench_thr_ctx->proc_id, &proc_frame_ctx_recv);
+		if(ret_code!= STAT_SUCCESS || proc_frame_ctx_recv== NULL) {
+			bench_thr_ctx->errors++;
+			break;
+		}
+		bench_stats_add(bench_thr_ctx->latency_stats, bench_now_usecs()-
+				t0_usecs);
+
+		if(proc_frame_ctx_recv->pts!= seq)
+			bench_thr_ctx->errors++;
+		else
+			bench_thr_ctx->ops++;
+		proc_frame_ctx_release(&proc_frame_ctx_recv);
+	}
+	proc_frame_ctx_release(&proc_frame_ctx_recv);
+	return NULL;
+}
+
+static int bench_case_run(procs_ctx_t *procs_ctx, int threads_num,
+		size_t frame_size, int msecs)
+{
+	int i, end_code= STAT_ERROR;
+	volatile int flag_exit= 0;
+	uint64_t ops= 0, errors= 0;
+	int64_t t0_usecs, t1_usecs;
+	double secs;
+	uint8_t *data= NULL;
+	proc_frame_ctx_t proc_frame_ctx;
+	bench_thr_ctx_t *bench_thr_ctx_array= NULL;
+	bench_stats_summary_t bench_stats_summary;
+	bench_stats_ctx_t *latency_stats= NULL;
+
+	if((long long)threads_num* frame_size* BENCH_FRAME_COPIES>
+			BENCH_MEMORY_MAX) {
+		fprintf(stderr, "Skipping case (threads: %d, frame size: %zu): "
+				"exceeds memory limit\n", threads_num, frame_size);
+		return STAT_SUCCESS;
+	}
+
+	/* Source frame (shared, read-only, by all the threads) */
+	if((data= (uint8_t*)calloc(1, frame_size))== NULL)
+		goto end;
+	memset(&proc_frame_ctx, 0, sizeof(proc_frame_ctx));
+	proc_frame_ctx.data= data;
+	proc_frame_ctx.p_data[0]= data;
+	proc_frame_ctx.width[0]= proc_frame_ctx.linesize[0]= frame_size;
+	proc_frame_ctx.height[0]= 1;
+	proc_frame_ctx.proc_sample_fmt= PROC_IF_FMT_UNDEF;
+	proc_frame_ctx.es_id= 0;
+
+	bench_thr_ctx_array= (bench_thr_ctx_t*)calloc(threads_num,
+			sizeof(bench_thr_ctx_t));
+	if(bench_thr_ctx_array== NULL)
+		goto end;
+	for(i= 0; i< threads_num; i++) {
+		bench_thr_ctx_t *bench_thr_ctx= &bench_thr_ctx_array[i];
+		bench_thr_ctx->procs_ctx= procs_ctx;
+		bench_thr_ctx->proc_id= -1;
+		bench_thr_ctx->proc_frame_ctx= &proc_frame_ctx;
+		bench_thr_ctx->ref_flag_exit= &flag_exit;
+		if((bench_thr_ctx->latency_stats= bench_stats_open(
+				BENCH_LATENCY_SAMPLES_MAX))== NULL)
+			goto end;
+		if(procs_opt(procs_ctx, "PROCS_POST_ID",
+				proc_if_bench_bypass.proc_name, "",
+				&bench_thr_ctx->proc_id)!= STAT_SUCCESS) {
+			fprintf(stderr, "Could not open bypass processor\n");
+			goto end;
+		}
+	}
+
+	/* Run */
+	t0_usecs= bench_now_usecs();
+	for(i= 0; i< threads_num; i++)
+		pthread_create(&bench_thr_ctx_array[i].thread, NULL,
+				bench_client_thr, &bench_thr_ctx_array[i]);
+	usleep((useconds_t)msecs* 1000);
+	flag_exit= 1;
+	t1_usecs= bench_now_usecs();
+	for(i= 0; i< threads_num; i++)
+		pthread_join(bench_thr_ctx_array[i].thread, NULL);
+
+	/* Aggregate results */
+	memset(&bench_stats_summary, 0, sizeof(bench_stats_summary));
+	latency_stats= bench_stats_open(BENCH_LATENCY_SAMPLES_MAX* 4);
+	for(i= 0; i< threads_num; i++) {
+		ops+= bench_thr_ctx_array[i].ops;
+		errors+= bench_thr_ctx_array[i].errors;
+		if(latency_stats!= NULL)
+			bench_stats_merge(latency_stats,
+					bench_thr_ctx_array[i].latency_stats);
+	}
+	if(latency_stats!= NULL)
+		bench_stats_summary_get(latency_stats, &bench_stats_summary);
+	secs= (double)(t1_usecs- t0_usecs)/ 1000000.0;
+
+	printf("{\"bench\":\"procs_round_trip\",\"threads\":%d,"
+			"\"frame_bytes\":%zu,\"ops_per_sec\":%.1f,"
+			"\"mbytes_per_sec\":%.1f,\"errors\":%" PRIu64 ","
+			"\"rtt_usecs\":{\"p50\":%" PRId64 ",\"p90\":%" PRId64 ",\"p99\":%"
+			PRId64 ",\"p999\":%" PRId64 ",\"max\":%" PRId64 "}}\n",
+			threads_num, frame_size, (double)ops/ secs,
+			(double)ops* frame_size/ secs/ 1000000.0, errors,
+			bench_stats_summary.p50, bench_stats_summary.p90,
+			bench_stats_summary.p99, bench_stats_summary.p999,
+			bench_stats_summary.max);
+	fflush(stdout);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(bench_thr_ctx_array!= NULL) {
+		for(i= 0; i< threads_num; i++) {
+			if(bench_thr_ctx_array[i].proc_id>= 0)
+				procs_opt(procs_ctx, "PROCS_ID_DELETE",
+						bench_thr_ctx_array[i].proc_id);
+			bench_stats_close(&bench_thr_ctx_array[i].latency_stats);
+		}
+		free(bench_thr_ctx_array);
+	}
+	bench_stats_close(&latency_stats);
+	if(data!= NULL)
+		free(data);
+	return end_code;
+}
+
+static void usage(const char *prog_name)
+{
+	fprintf(stderr, "Usage: %s [-t threads] [-s frame_sizes] [-d msecs]\n"
+			"Lists are comma separated; defaults: -t " BENCH_THREADS_DEFAULT
+			" -s " BENCH_SIZES_DEFAULT " -d %d\n", prog_name,
+			BENCH_MSECS_DEFAULT);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, t, s, msecs= BENCH_MSECS_DEFAULT, end_code= EXIT_FAILURE;
+	int threads_list_num, sizes_num, threads_max= 1;
+	char threads_str[256]= BENCH_THREADS_DEFAULT;
+	char sizes_str[256]= BENCH_SIZES_DEFAULT;
+	char *threads_list[BENCH_LIST_MAX], *sizes[BENCH_LIST_MAX];
+	procs_ctx_t *procs_ctx= NULL;
+
+	while((opt= getopt(argc, argv, "t:s:d:"))!= -1) {
+		switch(opt) {
+		case 't':
+			snprintf(threads_str, sizeof(threads_str), "%s", optarg);
+			break;
+		case 's':
+			snprintf(sizes_str, sizeof(sizes_str), "%s", optarg);
+			break;
+		case 'd':
+			msecs= atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	threads_list_num= bench_list_parse(threads_str, threads_list,
+			BENCH_LIST_MAX);
+	sizes_num= bench_list_parse(sizes_str, sizes, BENCH_LIST_MAX);
+	for(t= 0; t< threads_list_num; t++) {
+		int threads_num= atoi(threads_list[t]);
+		if(threads_num< 1 || threads_num> BENCH_THREADS_MAX) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		if(threads_num> threads_max)
+			threads_max= threads_num;
+	}
+	for(s= 0; s< sizes_num; s++) {
+		if(atol(sizes[s])< 1) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(msecs< 1 || threads_list_num< 1 || sizes_num< 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Open LOG and PROCS modules; register bypass processor type */
+	if(log_module_open()!= STAT_SUCCESS || procs_module_open(NULL)!=
+			STAT_SUCCESS)
+		goto end;
+	if(procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_bench_bypass)!=
+			STAT_SUCCESS)
+		goto end;
+	procs_ctx= procs_open(NULL, threads_max+ 16, NULL, NULL);
+	if(procs_ctx== NULL)
+		goto end;
+
+	for(s= 0; s< sizes_num; s++)
+		for(t= 0; t< threads_list_num; t++)
+			if(bench_case_run(procs_ctx, atoi(threads_list[t]),
+					(size_t)atol(sizes[s]), msecs)!= STAT_SUCCESS)
+				fprintf(stderr, "PROCS benchmark case failed\n");
+
+	end_code= EXIT_SUCCESS;
+end:
+	procs_close(&procs_ctx);
+	procs_module_opt("PROCS_UNREGISTER_TYPE", proc_if_bench_bypass.proc_name);
+	procs_module_close();
+	log_module_close();
+	return end_code;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bypass_proc.h
+ * @brief Very simple "bypass" processor (frames are passed from the input
+ * to the output FIFO as is), shared by the PROCS module unit-tests and
+ * benchmarks.
+ * Each user defines its own 'proc_if_t' (e.g. with different features)
+ * using these callbacks.
+ * @author Rafael Antoniello
+ */
+
+#ifndef PROCS_UTESTS_BYPASS_PROC_H_
+#define PROCS_UTESTS_BYPASS_PROC_H_
+
+extern "C" {
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/fifo.h>
+#include <libmediaprocs/proc_if.h>
+#include <libmediaprocs/proc.h>
+}
+
+static proc_ctx_t* bypass_proc_open(const proc_if_t*, const char*,
+		const char*, log_ctx_t*, va_list)
+{
+	return (proc_ctx_t*)calloc(1, sizeof(proc_ctx_t));
+}
+
+static void bypass_proc_close(proc_ctx_t **ref_proc_ctx)
+{
+	proc_ctx_t *proc_ctx= NULL;
+
+	if(ref_proc_ctx== NULL)
+		return;
+
+	if((proc_ctx= *ref_proc_ctx)!= NULL) {
+		free(proc_ctx);
+		*ref_proc_ctx= NULL;
+	}
+}
+
+static int bypass_proc_rest_put(proc_ctx_t*, const char*)
+{
+	return STAT_SUCCESS;
+}
+
+static int bypass_proc_rest_get(proc_ctx_t*, const proc_if_rest_fmt_t,
+		void**)
+{
+	return STAT_SUCCESS;
+}
+
+static int bypass_proc_process_frame(proc_ctx_t *proc_ctx,
+		fifo_ctx_t *fifo_ctx_iput, fifo_ctx_t *fifo_ctx_oput)
+{
+	int ret_code, end_code= STAT_ERROR;
+	size_t fifo_elem_size= 0;
+	proc_frame_ctx_t *proc_frame_ctx= NULL;
+
+	/* Just "bypass" frame from input to output */
+	ret_code= fifo_get(fifo_ctx_iput, (void**)&proc_frame_ctx,
+			&fifo_elem_size);
+	if(ret_code!= STAT_SUCCESS) {
+		end_code= ret_code;
+		goto end;
+	}
+
+	ret_code= fifo_put_dup(fifo_ctx_oput, proc_frame_ctx, sizeof(void*));
+	if(ret_code!= STAT_SUCCESS && ret_code!= STAT_ENOMEM) {
+		end_code= ret_code;
+		goto end;
+	}
+
+	end_code= STAT_SUCCESS;
+end:
+	if(proc_frame_ctx!= NULL)
+		proc_frame_ctx_release(&proc_frame_ctx);
+	return end_code;
+}
+
+#endif /* PROCS_UTESTS_BYPASS_PROC_H_ */
@@ -38,63 +38,10 @@ extern "C" {
 #include <libmediaprocsutils/fifo.h>
 #include <libmediaprocs/proc_if.h>
 #include <libmediaprocs/proc.h>
+#include <libmediaprocs/proc_capture.h>
 }
 
-/* **** Define a very simple bypass processor **** */
-
-static proc_ctx_t* bypass_proc_open(const proc_if_t*, const char *settings_str,
-		const char* href, log_ctx_t *log_ctx, va_list arg)
-{
-	return (proc_ctx_t*)calloc(1, sizeof(proc_ctx_t));
-}
-
-static void bypass_proc_close(proc_ctx_t **ref_proc_ctx)
-{
-	proc_ctx_t *proc_ctx= NULL;
-
-	if(ref_proc_ctx== NULL)
-		return;
-
-	if((proc_ctx= *ref_proc_ctx)!= NULL) {
-		free(proc_ctx);
-		*ref_proc_ctx= NULL;
-	}
-}
-
-static int bypass_proc_rest_put(proc_ctx_t*, const char *str)
-{
-	return STAT_SUCCESS;
-}
-
-static int bypass_proc_rest_get(proc_ctx_t*, const proc_if_rest_fmt_t rest_fmt,
-		void **ref_reponse)
-{
-	return STAT_SUCCESS;
-}
-
-static int bypass_proc_process_frame(proc_ctx_t *proc_ctx,
-		fifo_ctx_t *fifo_ctx_iput, fifo_ctx_t *fifo_ctx_oput)
-{
-	int ret_code;
-	size_t fifo_elem_size= 0;
-	proc_frame_ctx_t *proc_frame_ctx= NULL;
-
-	/* Just "bypass" frame from input to output */
-	ret_code= fifo_get(proc_ctx->fifo_ctx_array[PROC_IPUT],
-			(void**)&proc_frame_ctx, &fifo_elem_size);
-	CHECK(ret_code== STAT_SUCCESS || ret_code== STAT_EAGAIN);
-	if(ret_code!= STAT_SUCCESS)
-		goto end;
-
-	ret_code= fifo_put_dup(proc_ctx->fifo_ctx_array[PROC_OPUT],
-			proc_frame_ctx, sizeof(void*));
-	CHECK(ret_code== STAT_SUCCESS || ret_code== STAT_ENOMEM);
-
-end:
-	if(proc_frame_ctx!= NULL)
-		proc_frame_ctx_release(&proc_frame_ctx);
-	return STAT_SUCCESS;
-}
+#include "bypass_proc.h"
 
 SUITE(UTESTS_PROC)
 {
@@ -204,4 +151,189 @@ end:
 		log_module_close();
 #undef FIFO_SIZE
 	}
+
+	TEST(NO_FEATURES_NO_STATS_THREAD)
+	{
+		proc_ctx_t *proc_ctx= NULL;
+		const proc_if_t proc_if_bypass_proc= {
+			"bypass_processor", "encoder", "application/octet-stream",
+			(uint64_t)0, // no features
+			bypass_proc_open,
+			bypass_proc_close,
+			proc_send_frame_default1,
+			NULL, // no 'send-no-dup'
+			proc_recv_frame_default1,
+			NULL, // no specific unblock function extension
+			bypass_proc_rest_put,
+			bypass_proc_rest_get,
+			bypass_proc_process_frame,
+			NULL,
+			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+			(void(*)(void**))proc_frame_ctx_release,
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+		};
+		uint32_t fifo_ctx_maxsize[PROC_IO_NUM]= {2, 2};
+
+		if(log_module_open()!= STAT_SUCCESS) {
+			printf("Could not initialize LOG module\n");
+			return;
+		}
+
+		/* A processing thread alone must not start the statistics thread
+		 * (CPU usage and stage-times are computed when read).
+		 */
+		proc_ctx= proc_open(&proc_if_bypass_proc, ""/*settings*/, 0/*index*/,
+				NULL/*'href'*/, fifo_ctx_maxsize, NULL/*LOG*/, NULL);
+		CHECK(proc_ctx!= NULL);
+		if(proc_ctx!= NULL)
+			CHECK(proc_ctx->interr_usleep_ctx== NULL);
+
+		proc_close(&proc_ctx);
+		log_module_close();
+	}
+
+	TEST(CAPTURE_FILES_IN_CAPTURE_DIR)
+	{
+#define CAPTURE_DIR "/tmp/utests_proc_capture"
+		char path[PROC_CAPTURE_PATH_MAX];
+		proc_capture_ctx_t *proc_capture_ctx= NULL,
+				*proc_capture_ctx_dup= NULL;
+		proc_capture_replay_ctx_t *proc_capture_replay_ctx= NULL;
+
+		if(log_module_open()!= STAT_SUCCESS) {
+			printf("Could not initialize LOG module\n");
+			return;
+		}
+
+		CHECK(proc_capture_dir_set("relative_dir")== STAT_EINVAL);
+		CHECK(proc_capture_dir_set(CAPTURE_DIR)== STAT_SUCCESS);
+
+		/* File names can not leave the capture directory */
+		CHECK(proc_capture_path_get("a.mpcap", path, sizeof(path), NULL)==
+				STAT_SUCCESS && strcmp(path, CAPTURE_DIR "/a.mpcap")== 0);
+		CHECK(proc_capture_path_get("", path, sizeof(path), NULL)==
+				STAT_EINVAL);
+		CHECK(proc_capture_path_get(".", path, sizeof(path), NULL)==
+				STAT_EINVAL);
+		CHECK(proc_capture_path_get("/etc/passwd", path, sizeof(path),
+				NULL)== STAT_EINVAL);
+		CHECK(proc_capture_path_get("..", path, sizeof(path), NULL)==
+				STAT_EINVAL);
+		CHECK(proc_capture_path_get("..a.mpcap", path, sizeof(path), NULL)==
+				STAT_EINVAL);
+		CHECK(proc_capture_open("../a.mpcap", NULL, PROC_OPUT, NULL)== NULL);
+		CHECK(proc_capture_replay_open("../a.mpcap", NULL)== NULL);
+
+		/* Capture directory is created; existing files are not overwritten */
+		unlink(CAPTURE_DIR "/a.mpcap");
+		rmdir(CAPTURE_DIR);
+		proc_capture_ctx= proc_capture_open("a.mpcap", NULL, PROC_OPUT, NULL);
+		CHECK(proc_capture_ctx!= NULL);
+		proc_capture_ctx_dup= proc_capture_open("a.mpcap", NULL, PROC_OPUT,
+				NULL);
+		CHECK(proc_capture_ctx_dup== NULL);
+		proc_capture_close(&proc_capture_ctx_dup);
+		proc_capture_close(&proc_capture_ctx);
+		proc_capture_replay_ctx= proc_capture_replay_open("a.mpcap", NULL);
+		CHECK(proc_capture_replay_ctx!= NULL);
+		if(proc_capture_replay_ctx!= NULL)
+			CHECK(proc_capture_replay_get_frames_num(
+					proc_capture_replay_ctx)== 0);
+		proc_capture_replay_close(&proc_capture_replay_ctx);
+
+		/* Capture directory can not be writable by others */
+		CHECK(chmod(CAPTURE_DIR, 0777)== 0);
+		proc_capture_ctx= proc_capture_open("b.mpcap", NULL, PROC_OPUT, NULL);
+		CHECK(proc_capture_ctx== NULL);
+		proc_capture_close(&proc_capture_ctx);
+		CHECK(proc_capture_replay_open("a.mpcap", NULL)== NULL);
+		CHECK(chmod(CAPTURE_DIR, 0700)== 0);
+
+		/* Capture directory can not be a symbolic link */
+		unlink(CAPTURE_DIR "_link");
+		CHECK(symlink(CAPTURE_DIR, CAPTURE_DIR "_link")== 0);
+		CHECK(proc_capture_dir_set(CAPTURE_DIR "_link")== STAT_SUCCESS);
+		proc_capture_ctx= proc_capture_open("b.mpcap", NULL, PROC_OPUT, NULL);
+		CHECK(proc_capture_ctx== NULL);
+		proc_capture_close(&proc_capture_ctx);
+		CHECK(proc_capture_replay_open("a.mpcap", NULL)== NULL);
+		unlink(CAPTURE_DIR "_link");
+		CHECK(access(CAPTURE_DIR "/b.mpcap", F_OK)!= 0);
+
+		unlink(CAPTURE_DIR "/a.mpcap");
+		rmdir(CAPTURE_DIR);
+		CHECK(proc_capture_dir_set(NULL)== STAT_SUCCESS);
+		log_module_close();
+#undef CAPTURE_DIR
+	}
+
+	static int reject_proc_rest_put(proc_ctx_t*, const char*)
+	{
+		return STAT_EINVAL;
+	}
+
+	TEST(CAPTURE_STARTED_ON_ACCEPTED_PUT_ONLY)
+	{
+#define CAPTURE_DIR "/tmp/utests_proc_capture_put"
+		proc_ctx_t *proc_ctx= NULL;
+		proc_if_t proc_if_bypass_proc= {
+			"bypass_processor", "encoder", "application/octet-stream",
+			(uint64_t)0, // no features
+			bypass_proc_open,
+			bypass_proc_close,
+			proc_send_frame_default1,
+			NULL, // no 'send-no-dup'
+			proc_recv_frame_default1,
+			NULL, // no specific unblock function extension
+			reject_proc_rest_put,
+			bypass_proc_rest_get,
+			bypass_proc_process_frame,
+			NULL,
+			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+			(void(*)(void**))proc_frame_ctx_release,
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+		};
+		uint32_t fifo_ctx_maxsize[PROC_IO_NUM]= {2, 2};
+
+		if(log_module_open()!= STAT_SUCCESS) {
+			printf("Could not initialize LOG module\n");
+			return;
+		}
+		CHECK(proc_capture_dir_set(CAPTURE_DIR)== STAT_SUCCESS);
+		unlink(CAPTURE_DIR "/a.mpcap");
+
+		/* Settings rejected by the processor do not start a capture */
+		proc_ctx= proc_open(&proc_if_bypass_proc, ""/*settings*/, 0/*index*/,
+				NULL/*'href'*/, fifo_ctx_maxsize, NULL/*LOG*/, NULL);
+		CHECK(proc_ctx!= NULL);
+		if(proc_ctx!= NULL) {
+			CHECK(proc_opt(proc_ctx, "PROC_PUT",
+					"capture=output&capture_file=a.mpcap")!= STAT_SUCCESS);
+			CHECK(proc_ctx->capture_ctx_array[PROC_OPUT]== NULL);
+			CHECK(access(CAPTURE_DIR "/a.mpcap", F_OK)!= 0);
+		}
+		proc_close(&proc_ctx);
+
+		/* Accepted settings do */
+		proc_if_bypass_proc.rest_put= bypass_proc_rest_put;
+		proc_ctx= proc_open(&proc_if_bypass_proc, ""/*settings*/, 0/*index*/,
+				NULL/*'href'*/, fifo_ctx_maxsize, NULL/*LOG*/, NULL);
+		CHECK(proc_ctx!= NULL);
+		if(proc_ctx!= NULL) {
+			CHECK(proc_opt(proc_ctx, "PROC_PUT",
+					"capture=output&capture_file=a.mpcap")== STAT_SUCCESS);
+			CHECK(proc_ctx->capture_ctx_array[PROC_OPUT]!= NULL);
+			CHECK(proc_opt(proc_ctx, "PROC_PUT", "capture=stop")==
+					STAT_SUCCESS);
+			CHECK(proc_ctx->capture_ctx_array[PROC_OPUT]== NULL);
+		}
+		proc_close(&proc_ctx);
+		CHECK(access(CAPTURE_DIR "/a.mpcap", F_OK)== 0);
+
+		unlink(CAPTURE_DIR "/a.mpcap");
+		rmdir(CAPTURE_DIR);
+		CHECK(proc_capture_dir_set(NULL)== STAT_SUCCESS);
+		log_module_close();
+#undef CAPTURE_DIR
+	}
 }
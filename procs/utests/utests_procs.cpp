@@ -29,8 +29,12 @@ extern "C" {
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <string.h>
 
 #include <libcjson/cJSON.h>
@@ -40,9 +44,11 @@ extern "C" {
 #include <libmediaprocsutils/check_utils.h>
 #include <libmediaprocsutils/stat_codes.h>
 #include <libmediaprocsutils/fifo.h>
+#include <libmediaprocsutils/json_writer.h>
 #include <libmediaprocs/proc_if.h>
 #include <libmediaprocs/procs.h>
 #include <libmediaprocs/proc.h>
+#include <libmediaprocs/procs_stats_shm.h>
 }
 
 /* **** Define a very simple bypass processor **** */
@@ -59,6 +65,11 @@ typedef struct bypass_proc_ctx_s {
 	 * Just a variable extending proc_ctx_s
 	 */
 	int setting1;
+	/**
+	 * Number of 'setting1' increments (see 'bypass_proc_opt()'); reported as
+	 * a processor specific statistic.
+	 */
+	int setting1_incs;
 } bypass_proc_ctx_t;
 
 static proc_ctx_t* bypass_proc_open(const proc_if_t *proc_if,
@@ -211,6 +222,47 @@ end:
 	return end_code;
 }
 
+static int bypass_proc_rest_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx)
+{
+	/* Check arguments */
+	if(proc_ctx== NULL || json_writer_ctx== NULL)
+		return STAT_ERROR;
+
+	/* Same representation as 'bypass_proc_rest_get()' */
+	json_writer_object_start(json_writer_ctx, "settings");
+	json_writer_int(json_writer_ctx, "setting1",
+			((bypass_proc_ctx_t*)proc_ctx)->setting1);
+	return json_writer_object_end(json_writer_ctx);
+}
+
+static int bypass_proc_opt(proc_ctx_t *proc_ctx, const char *tag,
+		va_list arg)
+{
+	bypass_proc_ctx_t *bypass_proc_ctx= (bypass_proc_ctx_t*)proc_ctx;
+
+	/* Check arguments */
+	if(proc_ctx== NULL || tag== NULL)
+		return STAT_ERROR;
+
+	if(strcmp(tag, "PROCS_ID_BYPASS_SETTING1_INC")!= 0)
+		return STAT_ENOTFOUND;
+	bypass_proc_ctx->setting1++;
+	bypass_proc_ctx->setting1_incs++;
+	return STAT_SUCCESS;
+}
+
+static int bypass_proc_stats_get_stream(proc_ctx_t *proc_ctx,
+		json_writer_ctx_t *json_writer_ctx)
+{
+	/* Check arguments */
+	if(proc_ctx== NULL || json_writer_ctx== NULL)
+		return STAT_ERROR;
+
+	return json_writer_int(json_writer_ctx, "setting1_incs",
+			((bypass_proc_ctx_t*)proc_ctx)->setting1_incs);
+}
+
 static int bypass_proc_process_frame(proc_ctx_t *proc_ctx,
 		fifo_ctx_t *fifo_ctx_iput, fifo_ctx_t *fifo_ctx_oput)
 {
@@ -238,6 +290,59 @@ end:
 	return end_code;
 }
 
+/* **** Define a bypass processor which is slow to open **** */
+
+/**
+ * Time taken to open the slow processor [usecs].
+ */
+#define SLOW_PROC_OPEN_USECS (300* 1000)
+
+static volatile int slow_proc_open_cnt= 0, slow_proc_close_cnt= 0;
+
+static proc_ctx_t* slow_proc_open(const proc_if_t *proc_if,
+		const char *settings_str, const char* href, log_ctx_t *log_ctx,
+		va_list arg)
+{
+	__atomic_add_fetch(&slow_proc_open_cnt, 1, __ATOMIC_SEQ_CST);
+	usleep(SLOW_PROC_OPEN_USECS); // e.g. initializing a video encoder
+	return bypass_proc_open(proc_if, settings_str, href, log_ctx, arg);
+}
+
+static void slow_proc_close(proc_ctx_t **ref_proc_ctx)
+{
+	if(ref_proc_ctx!= NULL && *ref_proc_ctx!= NULL)
+		__atomic_add_fetch(&slow_proc_close_cnt, 1, __ATOMIC_SEQ_CST);
+	bypass_proc_close(ref_proc_ctx);
+}
+
+typedef struct slow_post_thr_ctx_s {
+	procs_ctx_t *procs_ctx;
+	int proc_id;
+	int ret_code;
+} slow_post_thr_ctx_t;
+
+static void* slow_post_thr(void *t)
+{
+	slow_post_thr_ctx_t *slow_post_thr_ctx= (slow_post_thr_ctx_t*)t;
+
+	slow_post_thr_ctx->ret_code= procs_opt(slow_post_thr_ctx->procs_ctx,
+			"PROCS_POST_ID", "slow_processor", "setting1=100",
+			&slow_post_thr_ctx->proc_id);
+	return NULL;
+}
+
+/**
+ * Wait (up to one second) for the slow processor to start opening.
+ */
+static int slow_proc_open_wait(int open_cnt)
+{
+	int i;
+
+	for(i= 0; i< 1000 && slow_proc_open_cnt< open_cnt; i++)
+		usleep(1000);
+	return slow_proc_open_cnt>= open_cnt? STAT_SUCCESS: STAT_ETIMEDOUT;
+}
+
 SUITE(UTESTS_PROCS)
 {
 	TEST(REGISTER_UNREGISTER_PROC_IF)
@@ -387,14 +492,14 @@ end:
 		log_module_close();
 	}
 
-	TEST(GET_PUT_PROCS)
+	TEST(POST_DELETE_ASYNC_PROCS)
 	{
-		int ret_code, proc_id= -1;
+		int i, ret_code, proc_id[2]= {-1, -1};
 		procs_ctx_t *procs_ctx= NULL;
 		char *rest_str= NULL;
 		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
 		const proc_if_t proc_if_bypass_proc= {
-			"bypass_processor", "encoder", "application/encoder",
+			"bypass_processor", "encoder", "application/octet-stream",
 			(uint64_t)(PROC_FEATURE_BITRATE|PROC_FEATURE_REGISTER_PTS|
 					PROC_FEATURE_LATENCY),
 			bypass_proc_open,
@@ -411,6 +516,350 @@ end:
 			(void(*)(void**))proc_frame_ctx_release,
 			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
 		};
+		LOG_CTX_INIT(NULL);
+
+		ret_code= log_module_open();
+		CHECK_DO(ret_code== STAT_SUCCESS, CHECK(false); goto end);
+
+		ret_code= procs_module_open(NULL);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_bypass_proc);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		/* Get PROCS module's instance */
+		procs_ctx= procs_open(NULL, 16, NULL, NULL);
+		CHECK_DO(procs_ctx!= NULL, CHECK(false); goto end);
+
+		for(i= 0; i< 2; i++) {
+			ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+					"setting1=100", &rest_str);
+			CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+					CHECK(false); goto end);
+			cjson_rest= cJSON_Parse(rest_str);
+			CHECK_DO(cjson_rest!= NULL, CHECK(false); goto end);
+			cjson_aux= cJSON_GetObjectItem(cjson_rest, "proc_id");
+			CHECK_DO(cjson_aux!= NULL, CHECK(false); goto end);
+			CHECK((proc_id[i]= cjson_aux->valuedouble)>= 0);
+			free(rest_str);
+			rest_str= NULL;
+			cJSON_Delete(cjson_rest);
+			cjson_rest= NULL;
+		}
+		CHECK(proc_id[0]!= proc_id[1]);
+
+		/* Delete asynchronously; processor is not accessible any more */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE_ASYNC", proc_id[0]);
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE_ASYNC", proc_id[0]);
+		CHECK(ret_code== STAT_ENOTFOUND);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", proc_id[0], &rest_str);
+		CHECK(ret_code!= STAT_SUCCESS && rest_str== NULL);
+
+		/* Other processor is still fully operative */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", proc_id[1], &rest_str);
+		CHECK(ret_code== STAT_SUCCESS && rest_str!= NULL);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+		/* Leave the second processor pending of asynchronous deletion:
+		 * 'procs_close()' must wait for it.
+		 */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE_ASYNC", proc_id[1]);
+		CHECK(ret_code== STAT_SUCCESS);
+		procs_close(&procs_ctx);
+
+		ret_code= procs_module_opt("PROCS_UNREGISTER_TYPE", "bypass_processor");
+		CHECK(ret_code== STAT_SUCCESS);
+
+end:
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+		if(cjson_rest!= NULL)
+			cJSON_Delete(cjson_rest);
+		log_module_close();
+	}
+
+	TEST(POST_CONCURRENT_GET_CLOSE_PROCS)
+	{
+		int ret_code;
+		int64_t get_usecs;
+		struct timespec ts_start, ts_end;
+		pthread_t post_thread;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL;
+		slow_post_thr_ctx_t slow_post_thr_ctx= {0};
+		const proc_if_t proc_if_slow_proc= {
+			"slow_processor", "encoder", "application/octet-stream",
+			(uint64_t)0,
+			slow_proc_open,
+			slow_proc_close,
+			proc_send_frame_default1,
+			NULL, // no 'send-no-dup'
+			proc_recv_frame_default1,
+			NULL, // no specific unblock function extension
+			bypass_proc_rest_put,
+			bypass_proc_rest_get,
+			bypass_proc_process_frame,
+			NULL,
+			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+			(void(*)(void**))proc_frame_ctx_release,
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+		};
+		LOG_CTX_INIT(NULL);
+
+		slow_proc_open_cnt= slow_proc_close_cnt= 0;
+
+		ret_code= log_module_open();
+		CHECK_DO(ret_code== STAT_SUCCESS, CHECK(false); goto end);
+
+		ret_code= procs_module_open(NULL);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_slow_proc);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		procs_ctx= procs_open(NULL, 16, NULL, NULL);
+		CHECK_DO(procs_ctx!= NULL, CHECK(false); goto end);
+
+		/* A slow processor opening does not block a concurrent GET (the
+		 * processor is listed as being created).
+		 */
+		slow_post_thr_ctx.procs_ctx= procs_ctx;
+		slow_post_thr_ctx.proc_id= -1;
+		ret_code= pthread_create(&post_thread, NULL, slow_post_thr,
+				&slow_post_thr_ctx);
+		CHECK_DO(ret_code== 0, CHECK(false); goto end);
+		CHECK(slow_proc_open_wait(1)== STAT_SUCCESS);
+		clock_gettime(CLOCK_MONOTONIC, &ts_start);
+		ret_code= procs_opt(procs_ctx, "PROCS_GET", &rest_str, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &ts_end);
+		get_usecs= (int64_t)(ts_end.tv_sec- ts_start.tv_sec)* 1000000+
+				(ts_end.tv_nsec- ts_start.tv_nsec)/ 1000;
+		CHECK(ret_code== STAT_SUCCESS && rest_str!= NULL);
+		CHECK(get_usecs< SLOW_PROC_OPEN_USECS/ 2);
+		CHECK(rest_str!= NULL &&
+				strstr(rest_str, "\"state\":\"creating\"")!= NULL);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+		pthread_join(post_thread, NULL);
+		CHECK(slow_post_thr_ctx.ret_code== STAT_SUCCESS &&
+				slow_post_thr_ctx.proc_id>= 0);
+
+		/* Closing the instance while a processor is being opened leaves
+		 * nothing behind: the processor is closed once opened.
+		 */
+		slow_post_thr_ctx.proc_id= -1;
+		ret_code= pthread_create(&post_thread, NULL, slow_post_thr,
+				&slow_post_thr_ctx);
+		CHECK_DO(ret_code== 0, CHECK(false); goto end);
+		CHECK(slow_proc_open_wait(2)== STAT_SUCCESS);
+		procs_close(&procs_ctx);
+		pthread_join(post_thread, NULL);
+		CHECK(slow_proc_open_cnt== 2);
+		CHECK(slow_proc_close_cnt== 2);
+
+		ret_code= procs_module_opt("PROCS_UNREGISTER_TYPE", "slow_processor");
+		CHECK(ret_code== STAT_SUCCESS);
+
+end:
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+		log_module_close();
+	}
+
+	TEST(POST_DELETE_MANY_PROCS)
+	{
+		int i, ret_code, proc_id= -1;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL;
+		const char *p;
+		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+		const int procs_num= 80; // Spans more than one register chunk
+		const int forced_proc_id= 150; // One chunk past the register size
+		const proc_if_t proc_if_bypass_proc= {
+			"bypass_processor", "encoder", "application/octet-stream",
+			(uint64_t)0,
+			bypass_proc_open,
+			bypass_proc_close,
+			proc_send_frame_default1,
+			NULL, // no 'send-no-dup'
+			proc_recv_frame_default1,
+			NULL, // no specific unblock function extension
+			bypass_proc_rest_put,
+			bypass_proc_rest_get,
+			bypass_proc_process_frame,
+			NULL,
+			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+			(void(*)(void**))proc_frame_ctx_release,
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+		};
+		LOG_CTX_INIT(NULL);
+
+		ret_code= log_module_open();
+		CHECK_DO(ret_code== STAT_SUCCESS, CHECK(false); goto end);
+
+		ret_code= procs_module_open(NULL);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_bypass_proc);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		/* Get PROCS module's instance */
+		procs_ctx= procs_open(NULL, 32768, NULL, NULL);
+		CHECK_DO(procs_ctx!= NULL, CHECK(false); goto end);
+
+		/* Processor Ids. are assigned in ascending order */
+		for(i= 0; i< procs_num; i++) {
+			ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+					"setting1=100", &rest_str);
+			CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+					CHECK(false); goto end);
+			cjson_rest= cJSON_Parse(rest_str);
+			CHECK_DO(cjson_rest!= NULL, CHECK(false); goto end);
+			cjson_aux= cJSON_GetObjectItem(cjson_rest, "proc_id");
+			CHECK_DO(cjson_aux!= NULL, CHECK(false); goto end);
+			CHECK((proc_id= cjson_aux->valuedouble)== i);
+			free(rest_str);
+			rest_str= NULL;
+			cJSON_Delete(cjson_rest);
+			cjson_rest= NULL;
+		}
+
+		/* Forced Id. far away in the register is rejected (no growth) */
+		ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+				"forced_proc_id=20000", &rest_str);
+		CHECK(ret_code== STAT_EINVAL);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+		/* Forced Id. within one chunk past the register size */
+		ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+				"forced_proc_id=150", &rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		free(rest_str);
+		rest_str= NULL;
+		ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+				"forced_proc_id=150", &rest_str);
+		CHECK(ret_code== STAT_ECONFLICT);
+		if(rest_str!= NULL) {
+			free(rest_str);
+			rest_str= NULL;
+		}
+
+		/* Check listing */
+		ret_code= procs_opt(procs_ctx, "PROCS_GET", &rest_str, NULL);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		cjson_rest= cJSON_Parse(rest_str);
+		CHECK_DO(cjson_rest!= NULL, CHECK(false); goto end);
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "procs");
+		CHECK_DO(cjson_aux!= NULL, CHECK(false); goto end);
+		CHECK(cJSON_GetArraySize(cjson_aux)== procs_num+ 1);
+		free(rest_str);
+		rest_str= NULL;
+		cJSON_Delete(cjson_rest);
+		cjson_rest= NULL;
+
+		/* Metrics of all the processors are complete (the text buffer is
+		 * grown several times; no sample line is truncated).
+		 */
+		ret_code= procs_opt(procs_ctx, "PROCS_GET_METRICS", &rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		CHECK(strlen(rest_str)> 4096);
+		for(i= 0, p= rest_str; (p= strstr(p, "mediaprocs_frames_total{"))!=
+				NULL; i++, p++);
+		CHECK(i== 2* (procs_num+ 1));
+		CHECK(strstr(rest_str, "mediaprocs_frames_dropped_total{"
+				"proc_id=\"150\",proc_name=\"bypass_processor\","
+				"proc_type=\"encoder\"} 0\n")!= NULL);
+		CHECK(rest_str[strlen(rest_str)- 1]== '\n');
+		free(rest_str);
+		rest_str= NULL;
+
+		/* Free slots are recycled (lowest Id. first) */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", 5);
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", forced_proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", forced_proc_id);
+		CHECK(ret_code== STAT_ENOTFOUND);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", forced_proc_id+ 1);
+		CHECK(ret_code== STAT_ENOTFOUND);
+		ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+				"setting1=100", &rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		cjson_rest= cJSON_Parse(rest_str);
+		CHECK_DO(cjson_rest!= NULL, CHECK(false); goto end);
+		cjson_aux= cJSON_GetObjectItem(cjson_rest, "proc_id");
+		CHECK_DO(cjson_aux!= NULL, CHECK(false); goto end);
+		CHECK(cjson_aux->valuedouble== 5);
+
+		/* Identifier may be returned directly as an integer */
+		ret_code= procs_opt(procs_ctx, "PROCS_POST_ID", "bypass_processor",
+				"setting1=100", &proc_id);
+		CHECK(ret_code== STAT_SUCCESS && proc_id== procs_num);
+		ret_code= procs_opt(procs_ctx, "PROCS_POST_ID", "bypass_processor",
+				"forced_proc_id=0", &proc_id);
+		CHECK(ret_code== STAT_ECONFLICT && proc_id== -1);
+
+		procs_close(&procs_ctx);
+
+		ret_code= procs_module_opt("PROCS_UNREGISTER_TYPE", "bypass_processor");
+		CHECK(ret_code== STAT_SUCCESS);
+
+end:
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+		if(cjson_rest!= NULL)
+			cJSON_Delete(cjson_rest);
+		log_module_close();
+	}
+
+	TEST(GET_PUT_PROCS)
+	{
+		int ret_code, proc_id= -1;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL, *etag_str= NULL, *etag2_str= NULL;
+		cJSON *cjson_rest= NULL, *cjson_aux= NULL;
+		const proc_if_t proc_if_bypass_proc= {
+			"bypass_processor", "encoder", "application/encoder",
+			(uint64_t)(PROC_FEATURE_BITRATE|PROC_FEATURE_REGISTER_PTS|
+					PROC_FEATURE_LATENCY),
+			bypass_proc_open,
+			bypass_proc_close,
+			proc_send_frame_default1,
+			NULL, // no 'send-no-dup'
+			proc_recv_frame_default1,
+			NULL, // no specific unblock function extension
+			bypass_proc_rest_put,
+			bypass_proc_rest_get,
+			bypass_proc_process_frame,
+			bypass_proc_opt,
+			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+			(void(*)(void**))proc_frame_ctx_release,
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup,
+			NULL, // no JSON writer based GET
+			bypass_proc_stats_get_stream
+		};
 		const proc_if_t proc_if_bypass_proc2= {
 			"bypass_processor2", "encoder2", "application/encoder2",
 			(uint64_t)(PROC_FEATURE_BITRATE|PROC_FEATURE_REGISTER_PTS|
@@ -427,7 +876,8 @@ end:
 			NULL,
 			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
 			(void(*)(void**))proc_frame_ctx_release,
-			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup,
+			bypass_proc_rest_get_stream // JSON writer based GET
 		};
 		LOG_CTX_INIT(NULL);
 
@@ -496,6 +946,75 @@ end:
 		free(rest_str); rest_str= NULL;
 		cJSON_Delete(cjson_rest); cjson_rest= NULL;
 
+		/* Conditional GET: not modified unless settings are PUT */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", proc_id, NULL,
+				&rest_str, &etag_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL &&
+				etag_str!= NULL, CHECK(false); goto end);
+		CHECK(strstr(rest_str, "latency_avg_usec")== NULL);
+		free(rest_str); rest_str= NULL;
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", proc_id, etag_str,
+				&rest_str, &etag2_str);
+		CHECK(ret_code== STAT_NOTMODIFIED && rest_str== NULL);
+		CHECK_DO(etag2_str!= NULL, CHECK(false); goto end);
+		CHECK(strcmp(etag_str, etag2_str)== 0);
+		free(etag2_str); etag2_str= NULL;
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", proc_id, "setting1=200");
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", proc_id, etag_str,
+				&rest_str, &etag2_str);
+		CHECK(ret_code== STAT_SUCCESS && rest_str!= NULL);
+		CHECK_DO(etag2_str!= NULL, CHECK(false); goto end);
+		CHECK(strcmp(etag_str, etag2_str)!= 0);
+		free(rest_str); rest_str= NULL;
+		free(etag_str); etag_str= etag2_str;
+		etag2_str= NULL;
+
+		/* A processor specific option also modifies the representation */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_BYPASS_SETTING1_INC", proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET_COND", proc_id, etag_str,
+				&rest_str, &etag2_str);
+		CHECK(ret_code== STAT_SUCCESS && rest_str!= NULL);
+		CHECK_DO(etag2_str!= NULL, CHECK(false); goto end);
+		CHECK(strcmp(etag_str, etag2_str)!= 0);
+		CHECK(rest_str!= NULL && strstr(rest_str, "201")!= NULL);
+		free(rest_str); rest_str= NULL;
+		free(etag_str); etag_str= NULL;
+		free(etag2_str); etag2_str= NULL;
+
+		/* Statistics sub-resource (processor specific statistics last) */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_STATS_GET", proc_id,
+				&rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		CHECK(strstr(rest_str, "{\"latency_avg_usec\":")== rest_str);
+		CHECK(strstr(rest_str, "\"bitrate_oput\":")!= NULL);
+		CHECK(strstr(rest_str, "\"cpu_usage\":")!= NULL);
+		CHECK(strstr(rest_str, "\"stage_process_usec\":")!= NULL);
+		CHECK(strstr(rest_str, ",\"setting1_incs\":1}")!= NULL);
+		free(rest_str); rest_str= NULL;
+
+		/* Get selected fields of all the processors */
+		ret_code= procs_opt(procs_ctx, "PROCS_GET_FIELDS", &rest_str, NULL,
+				"setting1,latency_avg_usec,unknown_field");
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		//printf("GET fields returns: '%s'\n", rest_str); //comment-me
+		CHECK(strstr(rest_str, "\"proc_name\":\"bypass_processor\","
+				"\"setting1\":201,\"latency_avg_usec\":")!= NULL);
+		CHECK(strstr(rest_str, "unknown_field")== NULL);
+		CHECK(strstr(rest_str, "links")== NULL);
+		free(rest_str); rest_str= NULL;
+
+		/* Filtered out: empty list */
+		ret_code= procs_opt(procs_ctx, "PROCS_GET_FIELDS", &rest_str,
+				"proc_name==bypass_processor2", "setting1");
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		CHECK(strcmp(rest_str, "{\"procs\":[]}")== 0);
+		free(rest_str); rest_str= NULL;
+
 		/* Test putting same processor name setting! */
 		ret_code= procs_opt(procs_ctx, "PROCS_ID_PUT", proc_id,
 				"proc_name=bypass_processor");
@@ -506,18 +1025,23 @@ end:
 				"proc_name=bypass_processor2");
 		CHECK(ret_code== STAT_SUCCESS);
 
-		/* Get setting again and check that 'setting1' is preserved */
+		/* Get setting again and check that 'setting1' is preserved.
+		 * Note that 'bypass_processor2' uses the JSON writer based GET; check
+		 * that 'proc_name' is inserted at the top of the settings.
+		 */
 		ret_code= procs_opt(procs_ctx, "PROCS_ID_GET", proc_id, &rest_str);
 		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
 				CHECK(false); goto end);
 		//printf("GET returns: '%s'\n", rest_str); //comment-me
+		CHECK(strstr(rest_str, "\"settings\":{\"proc_name\":"
+				"\"bypass_processor2\",\"setting1\":201}")!= NULL);
 		cjson_rest= cJSON_Parse(rest_str);
 		CHECK_DO(cjson_rest!= NULL, CHECK(false); goto end);
 		cjson_aux= cJSON_GetObjectItem(cjson_rest, "settings");
 		CHECK_DO(cjson_aux!= NULL, CHECK(false); goto end);
 		cjson_aux= cJSON_GetObjectItem(cjson_aux, "setting1");
 		CHECK_DO(cjson_aux!= NULL, CHECK(false); goto end);
-		CHECK(cjson_aux->valuedouble== 200);
+		CHECK(cjson_aux->valuedouble== 201);
 		free(rest_str); rest_str= NULL;
 		cJSON_Delete(cjson_rest); cjson_rest= NULL;
 
@@ -534,6 +1058,10 @@ end:
 		log_module_close();
 		if(rest_str!= NULL)
 			free(rest_str);
+		if(etag_str!= NULL)
+			free(etag_str);
+		if(etag2_str!= NULL)
+			free(etag2_str);
 		if(cjson_rest!= NULL)
 			cJSON_Delete(cjson_rest);
 	}
@@ -616,6 +1144,10 @@ end:
 		free(rest_str);
 		rest_str= NULL;
 
+		/* Trace the frames path */
+		ret_code= procs_opt(procs_ctx, "PROCS_TRACE_START");
+		CHECK(ret_code== STAT_SUCCESS);
+
 		/* Fill processor input FIFO with two equal YUV frames */
 		for(frame_idx= 0; frame_idx< FIFO_SIZE; frame_idx++) {
 			ret_code= procs_send_frame(procs_ctx, proc_id, &proc_frame_ctx_yuv);
@@ -651,6 +1183,48 @@ end:
 			}
 		}
 
+		/* Check trace */
+		ret_code= procs_opt(procs_ctx, "PROCS_TRACE_STOP");
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_TRACE_GET", &rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		//printf("PROCS_TRACE_GET: '%s'\n", rest_str); // comment-me
+		CHECK(strstr(rest_str, "{\"name\":\"fifo_enqueue\",\"ph\":\"i\"")!=
+				NULL);
+		CHECK(strstr(rest_str, "\"args\":{\"id\":0,\"frame_id\":2,"
+				"\"pts\":-1}")!= NULL);
+		CHECK(strstr(rest_str, "{\"name\":\"process_frame\",\"ph\":\"B\"")!=
+				NULL);
+		CHECK(strstr(rest_str, "{\"name\":\"process_frame\",\"ph\":\"E\"")!=
+				NULL);
+		CHECK(strstr(rest_str, "{\"name\":\"fifo_dequeue\",\"ph\":\"i\"")!=
+				NULL);
+		free(rest_str);
+		rest_str= NULL;
+
+		/* Check metrics (frame counters) */
+		ret_code= procs_opt(procs_ctx, "PROCS_GET_METRICS", &rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		//printf("PROCS_GET_METRICS: '%s'\n", rest_str); // comment-me
+		CHECK(strstr(rest_str, "# TYPE mediaprocs_frames_total counter\n")!=
+				NULL);
+		CHECK(strstr(rest_str, "mediaprocs_frames_total{proc_id=\"0\","
+				"proc_name=\"bypass_processor\",proc_type=\"encoder\","
+				"io=\"input\"} 2\n")!= NULL);
+		CHECK(strstr(rest_str, "mediaprocs_frames_total{proc_id=\"0\","
+				"proc_name=\"bypass_processor\",proc_type=\"encoder\","
+				"io=\"output\"} 2\n")!= NULL);
+		CHECK(strstr(rest_str, "mediaprocs_fifo_level{proc_id=\"0\","
+				"proc_name=\"bypass_processor\",proc_type=\"encoder\","
+				"io=\"input\"} 0\n")!= NULL);
+		CHECK(strstr(rest_str, "mediaprocs_cpu_time_usec_total{proc_id=\"0\","
+				"proc_name=\"bypass_processor\",proc_type=\"encoder\"} ")!=
+				NULL);
+		free(rest_str);
+		rest_str= NULL;
+
 end:
 		//CHECK(procs_opt(procs_ctx, PROCS_ID_DELETE, proc_id)==
 		//		STAT_SUCCESS); // Let function 'procs_close()' do this
@@ -668,4 +1242,140 @@ end:
 		proc_frame_ctx_release(&proc_frame_ctx);
 #undef FIFO_SIZE
 	}
+
+	TEST(STATS_SHM_PROCS)
+	{
+#define SHM_NAME "/mediaprocs_utests_stats"
+		int ret_code, shm_fd= -1, proc_id= -1;
+		size_t shm_size= 0;
+		procs_ctx_t *procs_ctx= NULL;
+		char *rest_str= NULL;
+		const procs_stats_shm_hdr_t *stats_shm_hdr= NULL;
+		const procs_stats_shm_elem_t *elem_array;
+		procs_stats_shm_elem_t elem_cpy;
+		struct stat shm_stat;
+		const proc_if_t proc_if_bypass_proc= {
+			"bypass_processor", "encoder", "application/octet-stream",
+			(uint64_t)(PROC_FEATURE_BITRATE|PROC_FEATURE_REGISTER_PTS|
+					PROC_FEATURE_LATENCY),
+			bypass_proc_open,
+			bypass_proc_close,
+			proc_send_frame_default1,
+			NULL, // no 'send-no-dup'
+			proc_recv_frame_default1,
+			NULL, // no specific unblock function extension
+			bypass_proc_rest_put,
+			bypass_proc_rest_get,
+			bypass_proc_process_frame,
+			NULL,
+			(void*(*)(const proc_frame_ctx_t*))proc_frame_ctx_dup,
+			(void(*)(void**))proc_frame_ctx_release,
+			(proc_frame_ctx_t*(*)(const void*))proc_frame_ctx_dup
+		};
+		LOG_CTX_INIT(NULL);
+
+		log_module_open();
+
+		ret_code= procs_module_open(NULL);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		ret_code= procs_module_opt("PROCS_REGISTER_TYPE", &proc_if_bypass_proc);
+		CHECK(ret_code== STAT_SUCCESS);
+
+		/* Get PROCS module's instance */
+		procs_ctx= procs_open(NULL, 16, NULL, NULL);
+		CHECK_DO(procs_ctx!= NULL, CHECK(false); goto end);
+
+		/* Leave a stale object behind with the same name: it is replaced */
+		shm_fd= shm_open(SHM_NAME, O_CREAT| O_RDWR, S_IRUSR| S_IWUSR);
+		CHECK_DO(shm_fd>= 0, CHECK(false); goto end);
+		CHECK(ftruncate(shm_fd, 1)== 0);
+		close(shm_fd);
+		shm_fd= -1;
+
+		/* Start publishing statistics page (bad name and re-opening fail) */
+		ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_OPEN", "no_slash", 0);
+		CHECK(ret_code== STAT_EINVAL);
+		ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_OPEN", SHM_NAME,
+				10000);
+		CHECK_DO(ret_code== STAT_SUCCESS, CHECK(false); goto end);
+		ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_OPEN", SHM_NAME,
+				10000);
+		CHECK(ret_code== STAT_ECONFLICT);
+
+		ret_code= procs_opt(procs_ctx, "PROCS_POST", "bypass_processor",
+				"setting1=100", &rest_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && rest_str!= NULL,
+				CHECK(false); goto end);
+		CHECK(strcmp(rest_str, "{\"proc_id\":0}")== 0);
+		proc_id= 0;
+		free(rest_str);
+		rest_str= NULL;
+
+		/* Let the page be refreshed */
+		usleep(100000);
+
+		/* Map page read-only as a monitoring agent would do */
+		shm_fd= shm_open(SHM_NAME, O_RDONLY, 0);
+		CHECK_DO(shm_fd>= 0, CHECK(false); goto end);
+		CHECK_DO(fstat(shm_fd, &shm_stat)== 0, CHECK(false); goto end);
+		shm_size= (size_t)shm_stat.st_size;
+		CHECK_DO(shm_size>= sizeof(procs_stats_shm_hdr_t), CHECK(false);
+				goto end);
+		stats_shm_hdr= (const procs_stats_shm_hdr_t*)mmap(NULL, shm_size,
+				PROT_READ, MAP_SHARED, shm_fd, 0);
+		CHECK_DO(stats_shm_hdr!= MAP_FAILED, stats_shm_hdr= NULL;
+				CHECK(false); goto end);
+
+		CHECK(stats_shm_hdr->magic== PROCS_STATS_SHM_MAGIC);
+		CHECK(stats_shm_hdr->version== PROCS_STATS_SHM_VERSION);
+		CHECK(stats_shm_hdr->hdr_size== sizeof(procs_stats_shm_hdr_t));
+		CHECK(stats_shm_hdr->elem_size== sizeof(procs_stats_shm_elem_t));
+		CHECK(stats_shm_hdr->elem_num== 16);
+		CHECK(stats_shm_hdr->period_usec== 10000);
+		CHECK(stats_shm_hdr->update_nsec> 0);
+		CHECK_DO(shm_size== stats_shm_hdr->hdr_size+ stats_shm_hdr->elem_num*
+				stats_shm_hdr->elem_size, CHECK(false); goto end);
+		elem_array= (const procs_stats_shm_elem_t*)((const uint8_t*)
+				stats_shm_hdr+ stats_shm_hdr->hdr_size);
+
+		ret_code= procs_stats_shm_elem_read(&elem_array[proc_id], &elem_cpy,
+				100);
+		CHECK_DO(ret_code== 0, CHECK(false); goto end);
+		CHECK(elem_cpy.flags== PROCS_STATS_SHM_ELEM_FLAG_ACTIVE);
+		CHECK(elem_cpy.proc_id== proc_id);
+		CHECK(strcmp(elem_cpy.proc_name, "bypass_processor")== 0);
+		CHECK(strcmp(elem_cpy.proc_type, "encoder")== 0);
+		CHECK(elem_cpy.frame_cnt[PROC_IPUT]== 0);
+
+		/* Unused slot */
+		ret_code= procs_stats_shm_elem_read(&elem_array[1], &elem_cpy, 100);
+		CHECK(ret_code== 0 && elem_cpy.flags== 0);
+
+		/* Deleted processors are cleared from the page */
+		ret_code= procs_opt(procs_ctx, "PROCS_ID_DELETE", proc_id);
+		CHECK(ret_code== STAT_SUCCESS);
+		usleep(100000);
+		ret_code= procs_stats_shm_elem_read(&elem_array[proc_id], &elem_cpy,
+				100);
+		CHECK(ret_code== 0 && elem_cpy.flags== 0);
+
+		ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_CLOSE");
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= procs_opt(procs_ctx, "PROCS_STATS_SHM_CLOSE");
+		CHECK(ret_code== STAT_ENOTFOUND);
+
+end:
+		if(stats_shm_hdr!= NULL)
+			munmap((void*)stats_shm_hdr, shm_size);
+		if(shm_fd>= 0)
+			close(shm_fd);
+		if(procs_ctx!= NULL)
+			procs_close(&procs_ctx);
+		procs_module_close();
+		log_module_close();
+		if(rest_str!= NULL)
+			free(rest_str);
+#undef SHM_NAME
+	}
 }
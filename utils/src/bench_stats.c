@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bench_stats.c
+ * @author Rafael Antoniello
+ */
+
+#include "bench_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "log.h"
+#include "stat_codes.h"
+#include "check_utils.h"
+
+/* **** Definitions **** */
+
+/**
+ * Benchmarking statistics context structure.
+ */
+typedef struct bench_stats_ctx_s {
+	pthread_mutex_t mutex;
+	/**
+	 * Kept samples (at most 'samples_max').
+	 */
+	int64_t *samples;
+	size_t samples_max;
+	size_t samples_num;
+	/**
+	 * Set when 'samples' is sorted (percentiles computation).
+	 */
+	int flag_sorted;
+	/**
+	 * Exact statistics (computed over all the added samples).
+	 */
+	uint64_t count;
+	int64_t min;
+	int64_t max;
+	double sum;
+	/**
+	 * Reservoir sampling pseudo-random generator state.
+	 */
+	uint64_t rand_state;
+} bench_stats_ctx_t;
+
+/* **** Prototypes **** */
+
+static void bench_stats_add_locked(bench_stats_ctx_t *bench_stats_ctx,
+		int64_t value);
+static int64_t bench_stats_percentile_locked(
+		bench_stats_ctx_t *bench_stats_ctx, double percentile);
+static int samples_cmp(const void *a, const void *b);
+
+/* **** Implementations **** */
+
+bench_stats_ctx_t* bench_stats_open(size_t samples_max)
+{
+	int ret_code, end_code= STAT_ERROR;
+	bench_stats_ctx_t *bench_stats_ctx= NULL;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(samples_max> 0, return NULL);
+
+	/* Allocate context structure */
+	bench_stats_ctx= (bench_stats_ctx_t*)calloc(1, sizeof(
+			bench_stats_ctx_t));
+	CHECK_DO(bench_stats_ctx!= NULL, goto end);
+
+	/* Initialize context structure */
+	ret_code= pthread_mutex_init(&bench_stats_ctx->mutex, NULL);
+	CHECK_DO(ret_code== 0, free(bench_stats_ctx); return NULL);
+
+	bench_stats_ctx->samples= (int64_t*)malloc(samples_max* sizeof(int64_t));
+	CHECK_DO(bench_stats_ctx->samples!= NULL, goto end);
+	bench_stats_ctx->samples_max= samples_max;
+	bench_stats_ctx->rand_state= 0x9E3779B97F4A7C15ULL;
+	bench_stats_reset(bench_stats_ctx);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS)
+		bench_stats_close(&bench_stats_ctx);
+	return bench_stats_ctx;
+}
+
+void bench_stats_close(bench_stats_ctx_t **ref_bench_stats_ctx)
+{
+	bench_stats_ctx_t *bench_stats_ctx= NULL;
+
+	if(ref_bench_stats_ctx== NULL ||
+			(bench_stats_ctx= *ref_bench_stats_ctx)== NULL)
+		return;
+
+	if(bench_stats_ctx->samples!= NULL)
+		free(bench_stats_ctx->samples);
+	pthread_mutex_destroy(&bench_stats_ctx->mutex);
+	free(bench_stats_ctx);
+	*ref_bench_stats_ctx= NULL;
+}
+
+void bench_stats_reset(bench_stats_ctx_t *bench_stats_ctx)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(bench_stats_ctx!= NULL, return);
+
+	pthread_mutex_lock(&bench_stats_ctx->mutex);
+	bench_stats_ctx->samples_num= 0;
+	bench_stats_ctx->flag_sorted= 1;
+	bench_stats_ctx->count= 0;
+	bench_stats_ctx->min= INT64_MAX;
+	bench_stats_ctx->max= INT64_MIN;
+	bench_stats_ctx->sum= 0;
+	pthread_mutex_unlock(&bench_stats_ctx->mutex);
+}
+
+void bench_stats_add(bench_stats_ctx_t *bench_stats_ctx, int64_t value)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(bench_stats_ctx!= NULL, return);
+
+	pthread_mutex_lock(&bench_stats_ctx->mutex);
+	bench_stats_add_locked(bench_stats_ctx, value);
+	pthread_mutex_unlock(&bench_stats_ctx->mutex);
+}
+
+void bench_stats_merge(bench_stats_ctx_t *bench_stats_ctx,
+		bench_stats_ctx_t *bench_stats_ctx_src)
+{
+	size_t i;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(bench_stats_ctx!= NULL, return);
+	CHECK_DO(bench_stats_ctx_src!= NULL, return);
+	CHECK_DO(bench_stats_ctx!= bench_stats_ctx_src, return);
+
+	pthread_mutex_lock(&bench_stats_ctx_src->mutex);
+	pthread_mutex_lock(&bench_stats_ctx->mutex);
+	for(i= 0; i< bench_stats_ctx_src->samples_num; i++)
+		bench_stats_add_locked(bench_stats_ctx,
+				bench_stats_ctx_src->samples[i]);
+	/* Exact statistics account for all the source samples (not only the
+	 * ones kept).
+	 */
+	bench_stats_ctx->count+= bench_stats_ctx_src->count-
+			bench_stats_ctx_src->samples_num;
+	bench_stats_ctx->sum+= bench_stats_ctx_src->sum;
+	for(i= 0; i< bench_stats_ctx_src->samples_num; i++)
+		bench_stats_ctx->sum-= (double)bench_stats_ctx_src->samples[i];
+	if(bench_stats_ctx_src->count> 0) {
+		if(bench_stats_ctx_src->min< bench_stats_ctx->min)
+			bench_stats_ctx->min= bench_stats_ctx_src->min;
+		if(bench_stats_ctx_src->max> bench_stats_ctx->max)
+			bench_stats_ctx->max= bench_stats_ctx_src->max;
+	}
+	pthread_mutex_unlock(&bench_stats_ctx->mutex);
+	pthread_mutex_unlock(&bench_stats_ctx_src->mutex);
+}
+
+int64_t bench_stats_percentile(bench_stats_ctx_t *bench_stats_ctx,
+		double percentile)
+{
+	int64_t value;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(bench_stats_ctx!= NULL, return 0);
+
+	pthread_mutex_lock(&bench_stats_ctx->mutex);
+	value= bench_stats_percentile_locked(bench_stats_ctx, percentile);
+	pthread_mutex_unlock(&bench_stats_ctx->mutex);
+	return value;
+}
+
+void bench_stats_summary_get(bench_stats_ctx_t *bench_stats_ctx,
+		bench_stats_summary_t *bench_stats_summary)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(bench_stats_ctx!= NULL, return);
+	CHECK_DO(bench_stats_summary!= NULL, return);
+
+	memset(bench_stats_summary, 0, sizeof(bench_stats_summary_t));
+
+	pthread_mutex_lock(&bench_stats_ctx->mutex);
+	if(bench_stats_ctx->count> 0) {
+		bench_stats_summary->count= bench_stats_ctx->count;
+		bench_stats_summary->min= bench_stats_ctx->min;
+		bench_stats_summary->max= bench_stats_ctx->max;
+		bench_stats_summary->mean= bench_stats_ctx->sum/
+				(double)bench_stats_ctx->count;
+		bench_stats_summary->p50= bench_stats_percentile_locked(
+				bench_stats_ctx, 50);
+		bench_stats_summary->p90= bench_stats_percentile_locked(
+				bench_stats_ctx, 90);
+		bench_stats_summary->p99= bench_stats_percentile_locked(
+				bench_stats_ctx, 99);
+		bench_stats_summary->p999= bench_stats_percentile_locked(
+				bench_stats_ctx, 99.9);
+	}
+	pthread_mutex_unlock(&bench_stats_ctx->mutex);
+}
+
+int64_t bench_now_usecs()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec* 1000000+ ts.tv_nsec/ 1000;
+}
+
+int64_t bench_cpu_usecs()
+{
+	struct timespec ts;
+
+	if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts)!= 0)
+		return 0;
+	return (int64_t)ts.tv_sec* 1000000+ ts.tv_nsec/ 1000;
+}
+
+long bench_rss_kbytes()
+{
+	long pages_resident= -1;
+	FILE *file= fopen("/proc/self/statm", "r");
+
+	if(file== NULL)
+		return -1;
+	if(fscanf(file, "%*s %ld", &pages_resident)!= 1)
+		pages_resident= -1;
+	fclose(file);
+	if(pages_resident< 0)
+		return -1;
+	return pages_resident* (sysconf(_SC_PAGESIZE)/ 1024);
+}
+
+long bench_rss_peak_kbytes()
+{
+	struct rusage rusage;
+
+	if(getrusage(RUSAGE_SELF, &rusage)!= 0)
+		return -1;
+	return rusage.ru_maxrss;
+}
+
+int bench_threads_num()
+{
+	char line[128];
+	int threads_num= -1;
+	FILE *file= fopen("/proc/self/status", "r");
+
+	if(file== NULL)
+		return -1;
+	while(fgets(line, sizeof(line), file)!= NULL) {
+		if(sscanf(line, "Threads: %d", &threads_num)== 1)
+			break;
+	}
+	fclose(file);
+	return threads_num;
+}
+
+int bench_list_parse(char *str, char **list, int list_max)
+{
+	int num= 0;
+	char *saveptr= NULL, *token;
+
+	if(str== NULL || list== NULL)
+		return 0;
+
+	for(token= strtok_r(str, ",", &saveptr); token!= NULL && num< list_max;
+			token= strtok_r(NULL, ",", &saveptr))
+		list[num++]= token;
+	return num;
+}
+
+/**
+ * Add a sample (statistics context mutex must be locked).
+ * If the samples array is full, the new sample replaces a random kept
+ * sample with probability 'samples_max/count' (reservoir sampling).
+ */
+static void bench_stats_add_locked(bench_stats_ctx_t *bench_stats_ctx,
+		int64_t value)
+{
+	uint64_t x;
+
+	bench_stats_ctx->count++;
+	bench_stats_ctx->sum+= (double)value;
+	if(value< bench_stats_ctx->min)
+		bench_stats_ctx->min= value;
+	if(value> bench_stats_ctx->max)
+		bench_stats_ctx->max= value;
+
+	if(bench_stats_ctx->samples_num< bench_stats_ctx->samples_max) {
+		bench_stats_ctx->samples[bench_stats_ctx->samples_num++]= value;
+	} else {
+		/* xorshift64 */
+		x= bench_stats_ctx->rand_state;
+		x^= x<< 13;
+		x^= x>> 7;
+		x^= x<< 17;
+		bench_stats_ctx->rand_state= x;
+		x%= bench_stats_ctx->count;
+		if(x< bench_stats_ctx->samples_max)
+			bench_stats_ctx->samples[x]= value;
+	}
+	bench_stats_ctx->flag_sorted= 0;
+}
+
+/**
+ * Compute percentile (nearest-rank method) of the kept samples (statistics
+ * context mutex must be locked).
+ */
+static int64_t bench_stats_percentile_locked(
+		bench_stats_ctx_t *bench_stats_ctx, double percentile)
+{
+	size_t rank;
+
+	if(bench_stats_ctx->samples_num== 0)
+		return 0;
+
+	if(!bench_stats_ctx->flag_sorted) {
+		qsort(bench_stats_ctx->samples, bench_stats_ctx->samples_num,
+				sizeof(int64_t), samples_cmp);
+		bench_stats_ctx->flag_sorted= 1;
+	}
+
+	if(percentile<= 0)
+		return bench_stats_ctx->samples[0];
+	if(percentile>= 100)
+		return bench_stats_ctx->samples[bench_stats_ctx->samples_num- 1];
+	rank= (size_t)ceil(percentile/ 100.0*
+			(double)bench_stats_ctx->samples_num);
+	if(rank< 1)
+		rank= 1;
+	return bench_stats_ctx->samples[rank- 1];
+}
+
+static int samples_cmp(const void *a, const void *b)
+{
+	int64_t va= *(const int64_t*)a, vb= *(const int64_t*)b;
+
+	return (va> vb)- (va< vb);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bench_stats.h
+ * @brief Benchmarking statistics module.
+ * Collects samples (e.g. latencies in microseconds) and computes summary
+ * statistics (count, minimum, maximum, mean and percentiles). When more
+ * samples than the configured capacity are added, a uniform random subset
+ * of the samples is kept (reservoir sampling); count, minimum, maximum and
+ * mean are always exact.
+ * Also provides process-wide measures commonly used in benchmarks (monotonic
+ * time, CPU time, resident memory and number of threads).
+ * @author Rafael Antoniello
+ */
+
+#ifndef UTILS_SRC_BENCH_STATS_H_
+#define UTILS_SRC_BENCH_STATS_H_
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/* **** Definitions **** */
+
+/* Forward definitions */
+typedef struct bench_stats_ctx_s bench_stats_ctx_t;
+
+/**
+ * Samples summary structure.
+ */
+typedef struct bench_stats_summary_s {
+	uint64_t count;
+	int64_t min;
+	int64_t max;
+	double mean;
+	int64_t p50;
+	int64_t p90;
+	int64_t p99;
+	int64_t p999;
+} bench_stats_summary_t;
+
+/* **** Prototypes **** */
+
+/**
+ * Allocate and initialize benchmarking statistics context structure.
+ * @param samples_max Maximum number of samples kept to compute percentiles.
+ * @return Pointer to the statistics context structure on success, NULL if
+ * fails.
+ */
+bench_stats_ctx_t* bench_stats_open(size_t samples_max);
+
+/**
+ * Release benchmarking statistics context structure.
+ * @param ref_bench_stats_ctx Reference to the pointer to the statistics
+ * context structure to be released, that was obtained in a previous call to
+ * 'bench_stats_open()'. Pointer is set to NULL on return.
+ */
+void bench_stats_close(bench_stats_ctx_t **ref_bench_stats_ctx);
+
+/**
+ * Discard all the samples.
+ * @param bench_stats_ctx Pointer to the statistics context structure.
+ */
+void bench_stats_reset(bench_stats_ctx_t *bench_stats_ctx);
+
+/**
+ * Add a sample.
+ * This function is thread-safe and can be called concurrently.
+ * @param bench_stats_ctx Pointer to the statistics context structure.
+ * @param value Sample value.
+ */
+void bench_stats_add(bench_stats_ctx_t *bench_stats_ctx, int64_t value);
+
+/**
+ * Add all the samples kept in a statistics context to another one (e.g. to
+ * aggregate per-thread statistics).
+ * @param bench_stats_ctx Pointer to the destination statistics context.
+ * @param bench_stats_ctx_src Pointer to the source statistics context.
+ */
+void bench_stats_merge(bench_stats_ctx_t *bench_stats_ctx,
+		bench_stats_ctx_t *bench_stats_ctx_src);
+
+/**
+ * Get the value of the given percentile of the kept samples.
+ * @param bench_stats_ctx Pointer to the statistics context structure.
+ * @param percentile Percentile, in the range [0, 100].
+ * @return Percentile value (zero if no samples were added).
+ */
+int64_t bench_stats_percentile(bench_stats_ctx_t *bench_stats_ctx,
+		double percentile);
+
+/**
+ * Get the samples summary.
+ * @param bench_stats_ctx Pointer to the statistics context structure.
+ * @param bench_stats_summary Pointer to the summary structure to be filled.
+ */
+void bench_stats_summary_get(bench_stats_ctx_t *bench_stats_ctx,
+		bench_stats_summary_t *bench_stats_summary);
+
+/**
+ * @return Monotonic clock time, in microseconds.
+ */
+int64_t bench_now_usecs();
+
+/**
+ * @return CPU time consumed by the calling process (all threads), in
+ * microseconds.
+ */
+int64_t bench_cpu_usecs();
+
+/**
+ * @return Current resident set size of the calling process, in kilobytes
+ * (-1 if not available).
+ */
+long bench_rss_kbytes();
+
+/**
+ * @return Peak resident set size of the calling process, in kilobytes
+ * (-1 if not available).
+ */
+long bench_rss_peak_kbytes();
+
+/**
+ * @return Current number of threads of the calling process (-1 if not
+ * available).
+ */
+int bench_threads_num();
+
+/**
+ * Split a comma separated list (e.g. a benchmark command line argument such
+ * as "1,4,16") in place.
+ * @param str Character string to be split; commas are replaced by string
+ * terminators.
+ * @param list Array of pointers to be filled with the list elements (each
+ * pointing inside 'str').
+ * @param list_max Size of the array 'list'; further elements are ignored.
+ * @return Number of elements put in 'list'.
+ */
+int bench_list_parse(char *str, char **list, int list_max);
+
+#endif /* UTILS_SRC_BENCH_STATS_H_ */
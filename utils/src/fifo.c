@@ -48,6 +48,7 @@
 #include "check_utils.h"
 #include "log.h"
 #include "stat_codes.h"
+#include "usdt.h"
 
 /* **** Definitions **** */
 
@@ -150,6 +151,12 @@ typedef struct fifo_ctx_s {
 	 * processed.
 	 */
 	volatile int output_idx;
+	/**
+	 * Accumulated time spent blocked waiting for a free slot (put) and for
+	 * a new element (get), in nanoseconds.
+	 */
+	volatile uint64_t put_wait_nsec;
+	volatile uint64_t get_wait_nsec;
 	/**
 	 * Maximum number of element-slots (namely, maximum number of possible
 	 * chunks) of the FIFO buffer.
@@ -181,7 +188,7 @@ static int fifo_init(fifo_ctx_t *fifo_ctx, size_t slots_max,
 static void fifo_deinit(fifo_ctx_t *fifo_ctx);
 
 static inline int fifo_input(fifo_ctx_t *fifo_ctx, void **ref_elem,
-		size_t elem_size, int dup_flag);
+		size_t elem_size, int dup_flag, int nonblock_flag);
 static inline int fifo_output(fifo_ctx_t *fifo_ctx, void **ref_elem,
 		size_t *ref_elem_size, int flush_flag, int64_t tout_usecs);
 
@@ -190,6 +197,8 @@ static int fifo_mutex_init(pthread_mutex_t * const pthread_mutex_p,
 static int fifo_cond_init(pthread_cond_t * const pthread_cond_p,
 		int flag_use_shm, log_ctx_t *log_ctx);
 
+static inline uint64_t fifo_monotonic_nsec();
+
 /* **** Implementations **** */
 
 fifo_ctx_t* fifo_open(size_t slots_max, size_t chunk_size_max,
@@ -359,12 +368,20 @@ void fifo_set_blocking_mode(fifo_ctx_t *fifo_ctx, int do_block)
 int fifo_put_dup(fifo_ctx_t *fifo_ctx, const void *elem, size_t elem_size)
 {
 	void *p= (void*)elem;
-	return fifo_input(fifo_ctx, &p, elem_size, 1/*duplicate*/);
+	return fifo_input(fifo_ctx, &p, elem_size, 1/*duplicate*/,
+			0/*use FIFO blocking mode*/);
 }
 
 int fifo_put(fifo_ctx_t *fifo_ctx, void **ref_elem, size_t elem_size)
 {
-	return fifo_input(fifo_ctx, ref_elem, elem_size, 0/*do not duplicate*/);
+	return fifo_input(fifo_ctx, ref_elem, elem_size, 0/*do not duplicate*/,
+			0/*use FIFO blocking mode*/);
+}
+
+int fifo_tryput(fifo_ctx_t *fifo_ctx, void **ref_elem, size_t elem_size)
+{
+	return fifo_input(fifo_ctx, ref_elem, elem_size, 0/*do not duplicate*/,
+			1/*never block*/);
 }
 
 int fifo_get(fifo_ctx_t *fifo_ctx, void **ref_elem, size_t *ref_elem_size)
@@ -401,6 +418,39 @@ ssize_t fifo_get_buffer_level(fifo_ctx_t *fifo_ctx)
 	return buf_level;
 }
 
+ssize_t fifo_get_slots_used(fifo_ctx_t *fifo_ctx)
+{
+	ssize_t slots_used_cnt= -1; // invalid value to indicate STAT_ERROR
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(fifo_ctx!= NULL, return -1);
+
+	pthread_mutex_lock(&fifo_ctx->api_mutex);
+	slots_used_cnt= fifo_ctx->slots_used_cnt;
+	pthread_mutex_unlock(&fifo_ctx->api_mutex);
+
+	return slots_used_cnt;
+}
+
+int fifo_get_wait_nsec(fifo_ctx_t *fifo_ctx, uint64_t *ref_put_wait_nsec,
+		uint64_t *ref_get_wait_nsec)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(fifo_ctx!= NULL, return STAT_ERROR);
+
+	pthread_mutex_lock(&fifo_ctx->api_mutex);
+	if(ref_put_wait_nsec!= NULL)
+		*ref_put_wait_nsec= fifo_ctx->put_wait_nsec;
+	if(ref_get_wait_nsec!= NULL)
+		*ref_get_wait_nsec= fifo_ctx->get_wait_nsec;
+	pthread_mutex_unlock(&fifo_ctx->api_mutex);
+
+	return STAT_SUCCESS;
+}
+
 int fifo_traverse(fifo_ctx_t *fifo_ctx, int elem_cnt,
 		void (*it_fxn)(void *elem, ssize_t elem_size, int idx, void *it_arg,
 				int *ref_flag_break),
@@ -562,6 +612,10 @@ static int fifo_init(fifo_ctx_t *fifo_ctx, size_t slots_max,
 	/* Exit flag */
 	fifo_ctx->flag_exit= 0;
 
+	/* Waiting time accounting */
+	fifo_ctx->put_wait_nsec= 0;
+	fifo_ctx->get_wait_nsec= 0;
+
 	/* Shared FIFO name */
 	if(fifo_file_name!= NULL) {
 		size_t file_name_len;
@@ -711,12 +765,13 @@ static void fifo_deinit(fifo_ctx_t *fifo_ctx)
 }
 
 static inline int fifo_input(fifo_ctx_t *fifo_ctx, void **ref_elem,
-		size_t elem_size, int dup_flag)
+		size_t elem_size, int dup_flag, int nonblock_flag)
 {
 	int flag_use_shm;
 	size_t buf_slots_max, chunk_size_max;
 	fifo_elem_ctx_t *fifo_elem_ctx= NULL;
 	int end_code= STAT_ERROR;
+	uint64_t wait_start_nsec= 0;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
@@ -746,15 +801,18 @@ static inline int fifo_input(fifo_ctx_t *fifo_ctx, void **ref_elem,
 	 * element is consumed and a new free slot is available.
 	 * In the case of a non-blocking FIFO, if buffer is full we exit
 	 * returning 'STAT_ENOMEM' status.
+	 * Blocking time is accounted (clock is only read if we actually block).
 	 */
 	while(fifo_ctx->slots_used_cnt>= buf_slots_max &&
-			!(fifo_ctx->flags& FIFO_O_NONBLOCK) &&
+			!(fifo_ctx->flags& FIFO_O_NONBLOCK) && nonblock_flag== 0 &&
 			fifo_ctx->flag_exit== 0) {
+		if(wait_start_nsec== 0)
+			wait_start_nsec= fifo_monotonic_nsec();
 		pthread_cond_broadcast(&fifo_ctx->buf_put_signal);
 		pthread_cond_wait(&fifo_ctx->buf_get_signal, &fifo_ctx->api_mutex);
 	}
 	if(fifo_ctx->slots_used_cnt>= buf_slots_max &&
-			(fifo_ctx->flags& FIFO_O_NONBLOCK)) {
+			((fifo_ctx->flags& FIFO_O_NONBLOCK) || nonblock_flag!= 0)) {
 		LOGD("FIFO buffer overflow!\n");
 		end_code= STAT_ENOMEM;
 		goto end;
@@ -795,9 +853,12 @@ static inline int fifo_input(fifo_ctx_t *fifo_ctx, void **ref_elem,
 	//		fifo_ctx->slots_used_cnt= buf_slots_max); //comment-me
 	fifo_ctx->input_idx= (fifo_ctx->input_idx+ 1)% buf_slots_max;
 	pthread_cond_broadcast(&fifo_ctx->buf_put_signal);
+	USDT_PROBE3(fifo_put, fifo_ctx, elem_size, fifo_ctx->slots_used_cnt);
 
 	end_code= STAT_SUCCESS;
 end:
+	if(wait_start_nsec!= 0)
+		fifo_ctx->put_wait_nsec+= fifo_monotonic_nsec()- wait_start_nsec;
 	pthread_mutex_unlock(&fifo_ctx->api_mutex);
 	return end_code;
 }
@@ -813,6 +874,7 @@ static inline int fifo_output(fifo_ctx_t *fifo_ctx, void **ref_elem,
 	ssize_t elem_size= 0;  // Do not release
 	void *elem_cpy= NULL;
 	struct timespec ts_tout= {0};
+	uint64_t wait_start_nsec= 0;
 	LOG_CTX_INIT(NULL);
 
 	/* Check arguments */
@@ -858,10 +920,13 @@ static inline int fifo_output(fifo_ctx_t *fifo_ctx, void **ref_elem,
 	 * new element is inserted, or if it is the case, time-out occur.
 	 * In the case of a non-blocking FIFO, if buffer is empty we exit
 	 * returning 'STAT_EAGAIN' status.
+	 * Blocking time is accounted (clock is only read if we actually block).
 	 */
 	while(fifo_ctx->slots_used_cnt<= 0 && !(fifo_ctx->flags& FIFO_O_NONBLOCK)
 			&& fifo_ctx->flag_exit== 0) {
 		LOGD("FIFO buffer underrun!\n");
+		if(wait_start_nsec== 0)
+			wait_start_nsec= fifo_monotonic_nsec();
 		pthread_cond_broadcast(&fifo_ctx->buf_get_signal);
 		if(tout_usecs>= 0) {
 			ret_code= pthread_cond_timedwait(&fifo_ctx->buf_put_signal,
@@ -921,9 +986,12 @@ static inline int fifo_output(fifo_ctx_t *fifo_ctx, void **ref_elem,
 		elem_cpy= NULL; // Avoid double referencing
 	}
 	*ref_elem_size= (size_t)elem_size;
+	USDT_PROBE3(fifo_get, fifo_ctx, elem_size, fifo_ctx->slots_used_cnt);
 
 	end_code= STAT_SUCCESS;
 end:
+	if(wait_start_nsec!= 0)
+		fifo_ctx->get_wait_nsec+= fifo_monotonic_nsec()- wait_start_nsec;
 	pthread_mutex_unlock(&fifo_ctx->api_mutex);
 	if(elem_cpy!= NULL)
 		free(elem_cpy);
@@ -982,3 +1050,15 @@ end:
 	}
 	return end_code;
 }
+
+/**
+ * Get monotonic clock time in nanoseconds (zero if fails).
+ */
+static inline uint64_t fifo_monotonic_nsec()
+{
+	struct timespec ts_curr;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &ts_curr)!= 0)
+		return 0;
+	return (uint64_t)ts_curr.tv_sec*1000000000+ (uint64_t)ts_curr.tv_nsec;
+}
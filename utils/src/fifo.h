@@ -108,6 +108,20 @@ int fifo_put_dup(fifo_ctx_t *fifo_ctx, const void *elem, size_t elem_size);
  */
 int fifo_put(fifo_ctx_t *fifo_ctx, void **ref_elem, size_t elem_size);
 
+/**
+ * Same as 'fifo_put()', but never blocks regardless of the FIFO blocking
+ * mode: if the FIFO is full, 'STAT_ENOMEM' is returned and the element is
+ * not consumed (the caller keeps its ownership).
+ * This is intended for producers that must not be stalled by a slow
+ * consumer (e.g. a thread running an event loop shared by several streams).
+ * @param fifo_ctx Pointer to the FIFO context structure.
+ * @param ref_elem Reference to the pointer to the element to be put.
+ * @param elem_size Size of the element.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int fifo_tryput(fifo_ctx_t *fifo_ctx, void **ref_elem, size_t elem_size);
+
 /**
  * //TODO
  */
@@ -129,6 +143,28 @@ int fifo_show(fifo_ctx_t *fifo_ctx, void **elem, size_t *elem_size);
  */
 ssize_t fifo_get_buffer_level(fifo_ctx_t *fifo_ctx);
 
+/**
+ * Get the number of elements currently stored in the FIFO.
+ * @param fifo_ctx Pointer to the FIFO context structure.
+ * @return Number of elements, or -1 if fails.
+ */
+ssize_t fifo_get_slots_used(fifo_ctx_t *fifo_ctx);
+
+/**
+ * Get the accumulated time the FIFO users have been blocked waiting for a
+ * free slot (putting into a full FIFO) and for a new element (getting from
+ * an empty FIFO). Only blocking-mode waits are accounted.
+ * @param fifo_ctx Pointer to the FIFO context structure.
+ * @param ref_put_wait_nsec Reference to the accumulated put waiting time
+ * [nanoseconds] (optional, may be NULL).
+ * @param ref_get_wait_nsec Reference to the accumulated get waiting time
+ * [nanoseconds] (optional, may be NULL).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int fifo_get_wait_nsec(fifo_ctx_t *fifo_ctx, uint64_t *ref_put_wait_nsec,
+		uint64_t *ref_get_wait_nsec);
+
 /**
  * //TODO
  */
@@ -0,0 +1,503 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file json_writer.c
+ * @author Rafael Antoniello
+ */
+
+#include "json_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "check_utils.h"
+#include "log.h"
+#include "stat_codes.h"
+
+/* **** Definitions **** */
+
+/**
+ * Default initial size for the writer buffer.
+ */
+#define JSON_WRITER_DEFAULT_SIZE 1024
+
+/**
+ * Container (object or array) nesting level context structure.
+ */
+typedef struct json_writer_level_s {
+	/**
+	 * Container type: '{' for objects, '[' for arrays.
+	 */
+	char type;
+	/**
+	 * Set to non-zero when at least one value was written in the container
+	 * (thus, a separator is needed before next value).
+	 */
+	int flag_not_empty;
+} json_writer_level_t;
+
+/**
+ * JSON writer context structure.
+ */
+typedef struct json_writer_ctx_s {
+	/**
+	 * Writer buffer (always null-terminated) and its allocated size.
+	 */
+	char *buf;
+	size_t buf_size;
+	/**
+	 * Length of the JSON text currently written.
+	 */
+	size_t len;
+	/**
+	 * Current nesting level (0 means root level).
+	 */
+	int depth;
+	/**
+	 * Nesting levels stack ('levels[depth- 1]' is the current container).
+	 */
+	json_writer_level_t levels[JSON_WRITER_MAX_DEPTH];
+	/**
+	 * Set to non-zero when the root value is completely written.
+	 */
+	int flag_root_done;
+	/**
+	 * Sticky status code (see 'json_writer_object_start()').
+	 */
+	int status;
+	/**
+	 * Pending object prefix request (see 'json_writer_set_object_prefix()').
+	 */
+	const char *prefix_object_key;
+	const char *prefix_key;
+	const char *prefix_value;
+} json_writer_ctx_t;
+
+/* **** Prototypes **** */
+
+static int json_writer_reserve(json_writer_ctx_t *json_writer_ctx,
+		size_t size);
+static void json_writer_put(json_writer_ctx_t *json_writer_ctx,
+		const char *str, size_t len);
+static void json_writer_put_escaped(json_writer_ctx_t *json_writer_ctx,
+		const char *str);
+static int json_writer_value_begin(json_writer_ctx_t *json_writer_ctx,
+		const char *key);
+static void json_writer_value_end(json_writer_ctx_t *json_writer_ctx);
+static int json_writer_container_start(json_writer_ctx_t *json_writer_ctx,
+		const char *key, char type);
+static int json_writer_container_end(json_writer_ctx_t *json_writer_ctx,
+		char type);
+
+/* **** Implementations **** */
+
+json_writer_ctx_t* json_writer_open(size_t size_hint)
+{
+	json_writer_ctx_t *json_writer_ctx= NULL;
+	int end_code= STAT_ERROR;
+	LOG_CTX_INIT(NULL);
+
+	/* Allocate context structure */
+	json_writer_ctx= (json_writer_ctx_t*)calloc(1, sizeof(json_writer_ctx_t));
+	CHECK_DO(json_writer_ctx!= NULL, goto end);
+
+	/* Allocate writer buffer */
+	json_writer_ctx->buf_size= (size_hint> 0)? size_hint:
+			JSON_WRITER_DEFAULT_SIZE;
+	json_writer_ctx->buf= (char*)malloc(json_writer_ctx->buf_size);
+	CHECK_DO(json_writer_ctx->buf!= NULL, goto end);
+
+	json_writer_reset(json_writer_ctx);
+
+	end_code= STAT_SUCCESS;
+end:
+	if(end_code!= STAT_SUCCESS)
+		json_writer_close(&json_writer_ctx);
+	return json_writer_ctx;
+}
+
+void json_writer_close(json_writer_ctx_t **ref_json_writer_ctx)
+{
+	json_writer_ctx_t *json_writer_ctx;
+
+	if(ref_json_writer_ctx== NULL ||
+			(json_writer_ctx= *ref_json_writer_ctx)== NULL)
+		return;
+
+	if(json_writer_ctx->buf!= NULL) {
+		free(json_writer_ctx->buf);
+		json_writer_ctx->buf= NULL;
+	}
+
+	free(json_writer_ctx);
+	*ref_json_writer_ctx= NULL;
+}
+
+void json_writer_reset(json_writer_ctx_t *json_writer_ctx)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(json_writer_ctx!= NULL, return);
+
+	json_writer_ctx->len= 0;
+	json_writer_ctx->buf[0]= '\0';
+	json_writer_ctx->depth= 0;
+	json_writer_ctx->flag_root_done= 0;
+	json_writer_ctx->status= STAT_SUCCESS;
+	json_writer_ctx->prefix_object_key= NULL;
+	json_writer_ctx->prefix_key= NULL;
+	json_writer_ctx->prefix_value= NULL;
+}
+
+int json_writer_object_start(json_writer_ctx_t *json_writer_ctx,
+		const char *key)
+{
+	int ret_code;
+	const char *prefix_key, *prefix_value;
+
+	ret_code= json_writer_container_start(json_writer_ctx, key, '{');
+	if(ret_code!= STAT_SUCCESS)
+		return ret_code;
+
+	/* Apply pending object prefix request if applicable */
+	if(json_writer_ctx->prefix_object_key!= NULL &&
+			json_writer_ctx->depth== 2 && key!= NULL &&
+			strcmp(key, json_writer_ctx->prefix_object_key)== 0) {
+		prefix_key= json_writer_ctx->prefix_key;
+		prefix_value= json_writer_ctx->prefix_value;
+		json_writer_ctx->prefix_object_key= NULL;
+		json_writer_ctx->prefix_key= NULL;
+		json_writer_ctx->prefix_value= NULL;
+		return json_writer_string(json_writer_ctx, prefix_key, prefix_value);
+	}
+	return STAT_SUCCESS;
+}
+
+int json_writer_object_end(json_writer_ctx_t *json_writer_ctx)
+{
+	return json_writer_container_end(json_writer_ctx, '{');
+}
+
+int json_writer_array_start(json_writer_ctx_t *json_writer_ctx,
+		const char *key)
+{
+	return json_writer_container_start(json_writer_ctx, key, '[');
+}
+
+int json_writer_array_end(json_writer_ctx_t *json_writer_ctx)
+{
+	return json_writer_container_end(json_writer_ctx, '[');
+}
+
+int json_writer_string(json_writer_ctx_t *json_writer_ctx, const char *key,
+		const char *value)
+{
+	int ret_code;
+
+	if(value== NULL)
+		return json_writer_null(json_writer_ctx, key);
+
+	ret_code= json_writer_value_begin(json_writer_ctx, key);
+	if(ret_code!= STAT_SUCCESS)
+		return ret_code;
+	json_writer_put_escaped(json_writer_ctx, value);
+	json_writer_value_end(json_writer_ctx);
+	return json_writer_ctx->status;
+}
+
+int json_writer_int(json_writer_ctx_t *json_writer_ctx, const char *key,
+		int64_t value)
+{
+	int ret_code, len;
+	char num_str[32];
+
+	ret_code= json_writer_value_begin(json_writer_ctx, key);
+	if(ret_code!= STAT_SUCCESS)
+		return ret_code;
+	len= snprintf(num_str, sizeof(num_str), "%"PRId64, value);
+	json_writer_put(json_writer_ctx, num_str, (size_t)len);
+	json_writer_value_end(json_writer_ctx);
+	return json_writer_ctx->status;
+}
+
+int json_writer_double(json_writer_ctx_t *json_writer_ctx, const char *key,
+		double value)
+{
+	int ret_code, len;
+	char num_str[64];
+
+	if(!isfinite(value))
+		return json_writer_null(json_writer_ctx, key);
+
+	ret_code= json_writer_value_begin(json_writer_ctx, key);
+	if(ret_code!= STAT_SUCCESS)
+		return ret_code;
+	if(value== (double)(int64_t)value && fabs(value)< 1.0e15)
+		len= snprintf(num_str, sizeof(num_str), "%"PRId64, (int64_t)value);
+	else
+		len= snprintf(num_str, sizeof(num_str), "%.15g", value);
+	json_writer_put(json_writer_ctx, num_str, (size_t)len);
+	json_writer_value_end(json_writer_ctx);
+	return json_writer_ctx->status;
+}
+
+int json_writer_bool(json_writer_ctx_t *json_writer_ctx, const char *key,
+		int value)
+{
+	return json_writer_raw(json_writer_ctx, key, value!= 0? "true": "false");
+}
+
+int json_writer_null(json_writer_ctx_t *json_writer_ctx, const char *key)
+{
+	return json_writer_raw(json_writer_ctx, key, "null");
+}
+
+int json_writer_raw(json_writer_ctx_t *json_writer_ctx, const char *key,
+		const char *raw_value)
+{
+	int ret_code;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(raw_value!= NULL, return STAT_ERROR);
+
+	ret_code= json_writer_value_begin(json_writer_ctx, key);
+	if(ret_code!= STAT_SUCCESS)
+		return ret_code;
+	json_writer_put(json_writer_ctx, raw_value, strlen(raw_value));
+	json_writer_value_end(json_writer_ctx);
+	return json_writer_ctx->status;
+}
+
+int json_writer_set_object_prefix(json_writer_ctx_t *json_writer_ctx,
+		const char *object_key, const char *key, const char *value)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+	CHECK_DO(object_key!= NULL, return STAT_ERROR);
+	CHECK_DO(key!= NULL, return STAT_ERROR);
+	// Argument 'value' is allowed to be NULL (written as 'null')
+
+	json_writer_ctx->prefix_object_key= object_key;
+	json_writer_ctx->prefix_key= key;
+	json_writer_ctx->prefix_value= value;
+	return STAT_SUCCESS;
+}
+
+const char* json_writer_get_str(json_writer_ctx_t *json_writer_ctx,
+		size_t *ref_len)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(json_writer_ctx!= NULL, return NULL);
+	// Argument 'ref_len' is allowed to be NULL
+
+	if(json_writer_ctx->status!= STAT_SUCCESS ||
+			json_writer_ctx->flag_root_done== 0)
+		return NULL;
+
+	if(ref_len!= NULL)
+		*ref_len= json_writer_ctx->len;
+	return json_writer_ctx->buf;
+}
+
+/**
+ * Make sure the writer buffer has room for 'size' more bytes (plus the
+ * terminating null character). On failure, the sticky status is set.
+ */
+static int json_writer_reserve(json_writer_ctx_t *json_writer_ctx,
+		size_t size)
+{
+	size_t buf_size_new;
+	char *buf_new;
+	LOG_CTX_INIT(NULL);
+
+	if(json_writer_ctx->len+ size+ 1<= json_writer_ctx->buf_size)
+		return STAT_SUCCESS;
+
+	buf_size_new= json_writer_ctx->buf_size;
+	while(json_writer_ctx->len+ size+ 1> buf_size_new)
+		buf_size_new<<= 1;
+	buf_new= (char*)realloc(json_writer_ctx->buf, buf_size_new);
+	CHECK_DO(buf_new!= NULL,
+			json_writer_ctx->status= STAT_ENOMEM; return STAT_ENOMEM);
+	json_writer_ctx->buf= buf_new;
+	json_writer_ctx->buf_size= buf_size_new;
+	return STAT_SUCCESS;
+}
+
+static void json_writer_put(json_writer_ctx_t *json_writer_ctx,
+		const char *str, size_t len)
+{
+	if(json_writer_reserve(json_writer_ctx, len)!= STAT_SUCCESS)
+		return;
+	memcpy(&json_writer_ctx->buf[json_writer_ctx->len], str, len);
+	json_writer_ctx->len+= len;
+	json_writer_ctx->buf[json_writer_ctx->len]= '\0';
+}
+
+/**
+ * Write given string quoted and escaped (as specified in RFC 8259).
+ */
+static void json_writer_put_escaped(json_writer_ctx_t *json_writer_ctx,
+		const char *str)
+{
+	const unsigned char *p;
+	const char *run= str; // Start of current run of non-escaped characters
+	char esc[8];
+
+	json_writer_put(json_writer_ctx, "\"", 1);
+	for(p= (const unsigned char*)str; *p!= '\0'; p++) {
+		const char *esc_str= NULL;
+		size_t esc_len= 2;
+
+		switch(*p) {
+		case '"': esc_str= "\\\""; break;
+		case '\\': esc_str= "\\\\"; break;
+		case '\b': esc_str= "\\b"; break;
+		case '\f': esc_str= "\\f"; break;
+		case '\n': esc_str= "\\n"; break;
+		case '\r': esc_str= "\\r"; break;
+		case '\t': esc_str= "\\t"; break;
+		default:
+			if(*p< 0x20) {
+				snprintf(esc, sizeof(esc), "\\u%04x", (unsigned int)*p);
+				esc_str= esc;
+				esc_len= 6;
+			}
+			break;
+		}
+		if(esc_str== NULL)
+			continue;
+
+		json_writer_put(json_writer_ctx, run, (const char*)p- run);
+		json_writer_put(json_writer_ctx, esc_str, esc_len);
+		run= (const char*)p+ 1;
+	}
+	json_writer_put(json_writer_ctx, run, (const char*)p- run);
+	json_writer_put(json_writer_ctx, "\"", 1);
+}
+
+/**
+ * Check writer state and write value separator and member name as
+ * applicable.
+ */
+static int json_writer_value_begin(json_writer_ctx_t *json_writer_ctx,
+		const char *key)
+{
+	json_writer_level_t *level;
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+
+	if(json_writer_ctx->status!= STAT_SUCCESS)
+		return json_writer_ctx->status;
+
+	/* Root level: only one value is allowed, with no member name */
+	if(json_writer_ctx->depth== 0) {
+		CHECK_DO(json_writer_ctx->flag_root_done== 0 && key== NULL,
+				json_writer_ctx->status= STAT_EINVAL; return STAT_EINVAL);
+		return STAT_SUCCESS;
+	}
+
+	/* Member name is mandatory within objects, forbidden within arrays */
+	level= &json_writer_ctx->levels[json_writer_ctx->depth- 1];
+	CHECK_DO((level->type== '{')== (key!= NULL),
+			json_writer_ctx->status= STAT_EINVAL; return STAT_EINVAL);
+
+	if(level->flag_not_empty!= 0)
+		json_writer_put(json_writer_ctx, ",", 1);
+	level->flag_not_empty= 1;
+
+	if(key!= NULL) {
+		json_writer_put_escaped(json_writer_ctx, key);
+		json_writer_put(json_writer_ctx, ":", 1);
+	}
+	return json_writer_ctx->status;
+}
+
+/**
+ * Update writer state once a value is completely written.
+ */
+static void json_writer_value_end(json_writer_ctx_t *json_writer_ctx)
+{
+	if(json_writer_ctx->depth== 0)
+		json_writer_ctx->flag_root_done= 1;
+}
+
+static int json_writer_container_start(json_writer_ctx_t *json_writer_ctx,
+		const char *key, char type)
+{
+	json_writer_level_t *level;
+	int ret_code;
+	char type_str[2]= {type, '\0'};
+	LOG_CTX_INIT(NULL);
+
+	ret_code= json_writer_value_begin(json_writer_ctx, key);
+	if(ret_code!= STAT_SUCCESS)
+		return ret_code;
+
+	CHECK_DO(json_writer_ctx->depth< JSON_WRITER_MAX_DEPTH,
+			json_writer_ctx->status= STAT_ENOMEM; return STAT_ENOMEM);
+
+	json_writer_put(json_writer_ctx, type_str, 1);
+	level= &json_writer_ctx->levels[json_writer_ctx->depth++];
+	level->type= type;
+	level->flag_not_empty= 0;
+	return json_writer_ctx->status;
+}
+
+static int json_writer_container_end(json_writer_ctx_t *json_writer_ctx,
+		char type)
+{
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(json_writer_ctx!= NULL, return STAT_ERROR);
+
+	if(json_writer_ctx->status!= STAT_SUCCESS)
+		return json_writer_ctx->status;
+
+	CHECK_DO(json_writer_ctx->depth> 0 &&
+			json_writer_ctx->levels[json_writer_ctx->depth- 1].type== type,
+			json_writer_ctx->status= STAT_EINVAL; return STAT_EINVAL);
+
+	json_writer_put(json_writer_ctx, type== '{'? "}": "]", 1);
+	json_writer_ctx->depth--;
+	json_writer_value_end(json_writer_ctx);
+	return json_writer_ctx->status;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file json_writer.h
+ * @brief Streaming JSON writer.
+ * Writes JSON text directly into a growable character buffer, without
+ * building any intermediate tree structure. The buffer is kept between uses
+ * (see 'json_writer_reset()'), thus, once grown to the typical response size,
+ * writing does not perform any memory allocation.
+ * Output is always compact (no whitespace).
+ * @author Rafael Antoniello
+ */
+
+#ifndef UTILS_SRC_JSON_WRITER_H_
+#define UTILS_SRC_JSON_WRITER_H_
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/* **** Definitions **** */
+
+/**
+ * Maximum nesting level of JSON objects/arrays supported by the writer.
+ */
+#define JSON_WRITER_MAX_DEPTH 32
+
+/* Forward definitions */
+typedef struct json_writer_ctx_s json_writer_ctx_t;
+
+/* **** Prototypes **** */
+
+/**
+ * Allocate and initialize JSON writer context structure.
+ * @param size_hint Initial size of the writer buffer, in bytes (if zero is
+ * specified, a default size is used). Buffer grows automatically as needed.
+ * @return Pointer to the JSON writer context structure on success, NULL if
+ * fails.
+ */
+json_writer_ctx_t* json_writer_open(size_t size_hint);
+
+/**
+ * Release JSON writer context structure.
+ * @param ref_json_writer_ctx Reference to the pointer to the JSON writer
+ * context structure to be released, obtained in a previous call to
+ * 'json_writer_open()'. Pointer is set to NULL on return.
+ */
+void json_writer_close(json_writer_ctx_t **ref_json_writer_ctx);
+
+/**
+ * Reset the JSON writer to start writing a new JSON text. Allocated buffer is
+ * kept for re-use.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ */
+void json_writer_reset(json_writer_ctx_t *json_writer_ctx);
+
+/**
+ * Write the beginning of an object (JSON '{').
+ * All the "json_writer_*" writing functions receive a 'key' argument: it is
+ * the member name to be used if the value is written within an object, and
+ * must be NULL if the value is written at the root level or within an array.
+ * Errors are "sticky": once a writing function fails, all the subsequent
+ * writing operations fail and no text is returned (see
+ * 'json_writer_get_str()'); thus, checking the status of every call is not
+ * mandatory.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see above).
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_object_start(json_writer_ctx_t *json_writer_ctx,
+		const char *key);
+
+/**
+ * Write the end of the current object (JSON '}').
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_object_end(json_writer_ctx_t *json_writer_ctx);
+
+/**
+ * Write the beginning of an array (JSON '[').
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_array_start(json_writer_ctx_t *json_writer_ctx,
+		const char *key);
+
+/**
+ * Write the end of the current array (JSON ']').
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_array_end(json_writer_ctx_t *json_writer_ctx);
+
+/**
+ * Write a string value (escaped as needed). NULL value is written as JSON
+ * 'null'.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @param value String value.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_string(json_writer_ctx_t *json_writer_ctx, const char *key,
+		const char *value);
+
+/**
+ * Write an integer number value.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @param value Integer value.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_int(json_writer_ctx_t *json_writer_ctx, const char *key,
+		int64_t value);
+
+/**
+ * Write a floating point number value. Integral values are written without
+ * decimals; non-finite values are written as JSON 'null'.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @param value Floating point value.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_double(json_writer_ctx_t *json_writer_ctx, const char *key,
+		double value);
+
+/**
+ * Write a boolean value (JSON 'true' if non-zero, 'false' otherwise).
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @param value Boolean value.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_bool(json_writer_ctx_t *json_writer_ctx, const char *key,
+		int value);
+
+/**
+ * Write JSON 'null' value.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_null(json_writer_ctx_t *json_writer_ctx, const char *key);
+
+/**
+ * Write an already formatted JSON value (e.g. an object printed by other
+ * means). The value is copied "as is" (not validated).
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param key Member name (see 'json_writer_object_start()').
+ * @param raw_value Formatted JSON value character string.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_raw(json_writer_ctx_t *json_writer_ctx, const char *key,
+		const char *raw_value);
+
+/**
+ * Request a string member to be written at the top of a given object.
+ * The member is written as the first member of the next object started with
+ * member name 'object_key' as a direct child of the root object. This is
+ * used to decorate a representation written by a third party (e.g. a
+ * processor callback) without having to re-parse it.
+ * Only one request can be pending at a time; it is cleared once applied or
+ * when the writer is reset. Given strings must be kept available until then.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param object_key Member name of the object to be decorated.
+ * @param key Member name of the string member to be inserted.
+ * @param value String value of the member to be inserted.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h).
+ */
+int json_writer_set_object_prefix(json_writer_ctx_t *json_writer_ctx,
+		const char *object_key, const char *key, const char *value);
+
+/**
+ * Get the written JSON text.
+ * @param json_writer_ctx Pointer to the JSON writer context structure.
+ * @param ref_len Reference to the length of the returned text (optional, may
+ * be NULL).
+ * @return Pointer to the null-terminated JSON text (owned by the writer, valid
+ * until next writing operation, reset or close). NULL is returned if any
+ * writing error occurred or the JSON text is not complete (unbalanced
+ * objects/arrays).
+ */
+const char* json_writer_get_str(json_writer_ctx_t *json_writer_ctx,
+		size_t *ref_len);
+
+#endif /* UTILS_SRC_JSON_WRITER_H_ */
@@ -32,11 +32,39 @@
  */
 
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // 'pthread_setname_np()'
+#endif
+
 #include "schedule.h"
 
+#include <stdio.h>
+#include <stdarg.h>
 #include <unistd.h>
+#include <pthread.h>
+
+/**
+ * Maximum thread name length supported by the system (including terminating
+ * null character).
+ */
+#define SCHEDULE_THREAD_NAME_SIZE 16
 
 void schedule()
 {
 	usleep(1);
 }
+
+void schedule_set_thread_name(const char *format, ...)
+{
+	va_list arg;
+	char name[SCHEDULE_THREAD_NAME_SIZE];
+
+	if(format== NULL)
+		return;
+
+	va_start(arg, format);
+	vsnprintf(name, sizeof(name), format, arg); // truncates if needed
+	va_end(arg);
+
+	pthread_setname_np(pthread_self(), name);
+}
@@ -36,4 +36,12 @@
 
 void schedule();
 
+/**
+ * Set the name of the calling thread (as shown by 'top -H', 'perf', 'gdb',
+ * etc.). Names longer than 15 characters are truncated.
+ * @param format printf-like format string of the thread name, followed by
+ * the corresponding variable arguments.
+ */
+void schedule_set_thread_name(const char *format, ...);
+
 #endif /* UTILS_SRC_SCHEDULE_H_ */
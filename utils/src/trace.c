@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file trace.c
+ * @author Rafael Antoniello
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // 'pthread_getname_np()'
+#endif
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/syscall.h>
+
+#include "check_utils.h"
+#include "log.h"
+#include "stat_codes.h"
+#include "json_writer.h"
+
+/* **** Definitions **** */
+
+/**
+ * Maximum thread name length (including terminating null character).
+ */
+#define TRACE_THREAD_NAME_SIZE 16
+
+/**
+ * Trace event (compact representation).
+ */
+typedef struct trace_event_s {
+	/**
+	 * Monotonic clock time of the event [nanoseconds].
+	 */
+	uint64_t ts_nsec;
+	uint64_t frame_id;
+	int64_t pts;
+	/**
+	 * Static event name string.
+	 */
+	const char *name;
+	int32_t id;
+	int32_t type;
+} trace_event_t;
+
+/**
+ * Per-thread events ring buffer.
+ * Only the owner thread writes events (and resets the write index); the
+ * write index is published with release semantics so a reader sees complete
+ * events.
+ */
+typedef struct trace_ring_s {
+	struct trace_ring_s *next;
+	/**
+	 * Owner thread identifier (kernel thread Id.) and name.
+	 */
+	pid_t tid;
+	char thread_name[TRACE_THREAD_NAME_SIZE];
+	/**
+	 * Set when the owner thread exits; the ring buffer is released when the
+	 * next capture is started.
+	 */
+	volatile int flag_orphan;
+	/**
+	 * Number of events written since the capture started (the ring buffer
+	 * keeps the last 'TRACE_RING_EVENTS_NUM' ones).
+	 */
+	volatile uint64_t head;
+	/**
+	 * Capture the events of this ring buffer belong to (see 'trace_epoch').
+	 * The owner thread resets the write index on its first event of a new
+	 * capture; other threads never write the ring buffer indexes.
+	 */
+	volatile uint64_t epoch;
+	trace_event_t event_array[TRACE_RING_EVENTS_NUM];
+} trace_ring_t;
+
+volatile int trace_flag_enabled= 0;
+
+/**
+ * Current capture number (incremented each time a capture is started).
+ */
+static volatile uint64_t trace_epoch= 0;
+
+/**
+ * List of ring buffers of all the traced threads, and critical section to
+ * modify it.
+ */
+static trace_ring_t *trace_ring_list= NULL;
+static pthread_mutex_t trace_mutex= PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Ring buffer of the calling thread (NULL until its first event).
+ */
+static __thread trace_ring_t *trace_ring_local= NULL;
+
+/**
+ * Thread specific key used to be notified on thread exit.
+ */
+static pthread_key_t trace_ring_key;
+static pthread_once_t trace_ring_key_once= PTHREAD_ONCE_INIT;
+
+/* **** Prototypes **** */
+
+static trace_ring_t* trace_ring_local_open();
+static void trace_ring_key_create();
+static void trace_ring_key_destructor(void *t);
+
+/* **** Implementations **** */
+
+void trace_event_add(const char *name, trace_event_type_t type, int id,
+		uint64_t frame_id, int64_t pts)
+{
+	register uint64_t head, epoch;
+	trace_event_t *trace_event;
+	trace_ring_t *trace_ring;
+	struct timespec monotime_curr;
+
+	if((trace_ring= trace_ring_local)== NULL &&
+			(trace_ring= trace_ring_local_open())== NULL)
+		return;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &monotime_curr)!= 0)
+		return;
+
+	/* First event of a new capture: discard previous events. The write
+	 * index is reset before the epoch is published (a reader seeing the new
+	 * epoch sees the reset index).
+	 */
+	epoch= __atomic_load_n(&trace_epoch, __ATOMIC_ACQUIRE);
+	if(trace_ring->epoch!= epoch) {
+		__atomic_store_n(&trace_ring->head, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&trace_ring->epoch, epoch, __ATOMIC_RELEASE);
+	}
+
+	head= trace_ring->head; // only written by this thread
+	trace_event= &trace_ring->event_array[head& (TRACE_RING_EVENTS_NUM- 1)];
+	trace_event->ts_nsec= (uint64_t)monotime_curr.tv_sec*1000000000+
+			(uint64_t)monotime_curr.tv_nsec;
+	trace_event->frame_id= frame_id;
+	trace_event->pts= pts;
+	trace_event->name= name;
+	trace_event->id= id;
+	trace_event->type= type;
+	__atomic_store_n(&trace_ring->head, head+ 1, __ATOMIC_RELEASE);
+}
+
+int trace_start()
+{
+	trace_ring_t **ref_trace_ring;
+	int end_code= STAT_ERROR;
+	LOG_CTX_INIT(NULL);
+
+	ASSERT(pthread_mutex_lock(&trace_mutex)== 0);
+
+	if(trace_flag_enabled!= 0) {
+		end_code= STAT_ECONFLICT;
+		goto end;
+	}
+
+	/* Discard previous capture: release the ring buffers of the threads
+	 * that already exited, and start a new epoch. Note that the ring buffers
+	 * of running threads are not modified here, as the owner thread may be
+	 * still recording an event of the previous capture; each thread resets
+	 * its own ring buffer on its first event of the new epoch.
+	 */
+	ref_trace_ring= &trace_ring_list;
+	while(*ref_trace_ring!= NULL) {
+		trace_ring_t *trace_ring= *ref_trace_ring;
+		if(trace_ring->flag_orphan!= 0) {
+			*ref_trace_ring= trace_ring->next;
+			free(trace_ring);
+			continue;
+		}
+		ref_trace_ring= &trace_ring->next;
+	}
+
+	__atomic_add_fetch(&trace_epoch, 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&trace_flag_enabled, 1, __ATOMIC_RELEASE);
+	end_code= STAT_SUCCESS;
+end:
+	ASSERT(pthread_mutex_unlock(&trace_mutex)== 0);
+	return end_code;
+}
+
+int trace_stop()
+{
+	int end_code= STAT_ERROR;
+	LOG_CTX_INIT(NULL);
+
+	ASSERT(pthread_mutex_lock(&trace_mutex)== 0);
+	if(trace_flag_enabled== 0) {
+		end_code= STAT_ENOTFOUND;
+	} else {
+		__atomic_store_n(&trace_flag_enabled, 0, __ATOMIC_RELEASE);
+		end_code= STAT_SUCCESS;
+	}
+	ASSERT(pthread_mutex_unlock(&trace_mutex)== 0);
+	return end_code;
+}
+
+int trace_get_chrome_json(char **ref_str)
+{
+	trace_ring_t *trace_ring;
+	const char *json_str;
+	json_writer_ctx_t *json_writer_ctx= NULL;
+	int pid= (int)getpid(), end_code= STAT_ERROR;
+	static const char *ph_str[TRACE_EVENT_TYPE_MAX]= {"B", "E", "i"};
+	LOG_CTX_INIT(NULL);
+
+	/* Check arguments */
+	CHECK_DO(ref_str!= NULL, return STAT_ERROR);
+
+	*ref_str= NULL;
+
+	ASSERT(pthread_mutex_lock(&trace_mutex)== 0);
+
+	if(trace_flag_enabled!= 0) {
+		end_code= STAT_ECONFLICT;
+		goto end;
+	}
+
+	json_writer_ctx= json_writer_open(0);
+	CHECK_DO(json_writer_ctx!= NULL, goto end);
+
+	json_writer_object_start(json_writer_ctx, NULL);
+	json_writer_array_start(json_writer_ctx, "traceEvents");
+	for(trace_ring= trace_ring_list; trace_ring!= NULL;
+			trace_ring= trace_ring->next) {
+		register uint64_t i, head;
+
+		/* Skip ring buffers not written in the last capture */
+		if(__atomic_load_n(&trace_ring->epoch, __ATOMIC_ACQUIRE)!=
+				trace_epoch)
+			continue;
+		head= __atomic_load_n(&trace_ring->head, __ATOMIC_ACQUIRE);
+		if(head== 0)
+			continue;
+
+		/* Thread name metadata event */
+		json_writer_object_start(json_writer_ctx, NULL);
+		json_writer_string(json_writer_ctx, "name", "thread_name");
+		json_writer_string(json_writer_ctx, "ph", "M");
+		json_writer_int(json_writer_ctx, "pid", pid);
+		json_writer_int(json_writer_ctx, "tid", trace_ring->tid);
+		json_writer_object_start(json_writer_ctx, "args");
+		json_writer_string(json_writer_ctx, "name", trace_ring->thread_name);
+		json_writer_object_end(json_writer_ctx);
+		json_writer_object_end(json_writer_ctx);
+
+		/* Events, in chronological order (last ones if ring wrapped) */
+		i= head> TRACE_RING_EVENTS_NUM? head- TRACE_RING_EVENTS_NUM: 0;
+		for(; i< head; i++) {
+			const trace_event_t *trace_event= &trace_ring->event_array[i&
+					(TRACE_RING_EVENTS_NUM- 1)];
+			if(trace_event->name== NULL || trace_event->type< 0 ||
+					trace_event->type>= TRACE_EVENT_TYPE_MAX)
+				continue;
+
+			json_writer_object_start(json_writer_ctx, NULL);
+			json_writer_string(json_writer_ctx, "name", trace_event->name);
+			json_writer_string(json_writer_ctx, "ph",
+					ph_str[trace_event->type]);
+			if(trace_event->type== TRACE_EVENT_INSTANT)
+				json_writer_string(json_writer_ctx, "s", "t");
+			json_writer_double(json_writer_ctx, "ts",
+					(double)trace_event->ts_nsec/ 1000.0);
+			json_writer_int(json_writer_ctx, "pid", pid);
+			json_writer_int(json_writer_ctx, "tid", trace_ring->tid);
+			json_writer_object_start(json_writer_ctx, "args");
+			json_writer_int(json_writer_ctx, "id", trace_event->id);
+			json_writer_int(json_writer_ctx, "frame_id",
+					(int64_t)trace_event->frame_id);
+			json_writer_int(json_writer_ctx, "pts", trace_event->pts);
+			json_writer_object_end(json_writer_ctx);
+			json_writer_object_end(json_writer_ctx);
+		}
+	}
+	json_writer_array_end(json_writer_ctx);
+	json_writer_string(json_writer_ctx, "displayTimeUnit", "ms");
+	json_writer_object_end(json_writer_ctx);
+
+	json_str= json_writer_get_str(json_writer_ctx, NULL);
+	CHECK_DO(json_str!= NULL, goto end);
+	*ref_str= strdup(json_str);
+	CHECK_DO(*ref_str!= NULL, goto end);
+
+	end_code= STAT_SUCCESS;
+end:
+	ASSERT(pthread_mutex_unlock(&trace_mutex)== 0);
+	json_writer_close(&json_writer_ctx);
+	return end_code;
+}
+
+/**
+ * Allocate and register the ring buffer of the calling thread.
+ */
+static trace_ring_t* trace_ring_local_open()
+{
+	trace_ring_t *trace_ring;
+	LOG_CTX_INIT(NULL);
+
+	trace_ring= (trace_ring_t*)calloc(1, sizeof(trace_ring_t));
+	CHECK_DO(trace_ring!= NULL, return NULL);
+
+	trace_ring->tid= (pid_t)syscall(SYS_gettid);
+	if(pthread_getname_np(pthread_self(), trace_ring->thread_name,
+			sizeof(trace_ring->thread_name))!= 0)
+		snprintf(trace_ring->thread_name, sizeof(trace_ring->thread_name),
+				"%d", (int)trace_ring->tid);
+
+	/* Get notified when this thread exits */
+	ASSERT(pthread_once(&trace_ring_key_once, trace_ring_key_create)== 0);
+	ASSERT(pthread_setspecific(trace_ring_key, trace_ring)== 0);
+
+	ASSERT(pthread_mutex_lock(&trace_mutex)== 0);
+	trace_ring->next= trace_ring_list;
+	trace_ring_list= trace_ring;
+	ASSERT(pthread_mutex_unlock(&trace_mutex)== 0);
+
+	trace_ring_local= trace_ring;
+	return trace_ring;
+}
+
+static void trace_ring_key_create()
+{
+	LOG_CTX_INIT(NULL);
+
+	ASSERT(pthread_key_create(&trace_ring_key, trace_ring_key_destructor)==
+			0);
+}
+
+/**
+ * Thread exit notification: the ring buffer is kept (its events may still
+ * be exported) but it is marked to be released on next capture.
+ */
+static void trace_ring_key_destructor(void *t)
+{
+	trace_ring_t *trace_ring= (trace_ring_t*)t;
+	LOG_CTX_INIT(NULL);
+
+	if(trace_ring== NULL)
+		return;
+
+	ASSERT(pthread_mutex_lock(&trace_mutex)== 0);
+	trace_ring->flag_orphan= 1;
+	ASSERT(pthread_mutex_unlock(&trace_mutex)== 0);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file trace.h
+ * @brief Per-frame tracing module.
+ * Records compact events (e.g. begin/end of the processing of a frame, FIFO
+ * enqueue/dequeue) into per-thread ring buffers, and exports the captured
+ * events in the Chrome trace event JSON format (that can be loaded in
+ * 'chrome://tracing' or in the Perfetto UI).
+ * Each thread writes only in its own ring buffer, thus, recording an event
+ * does not take any lock. When the ring buffer is full, the oldest events
+ * are overwritten.
+ * When tracing is not enabled, the cost of a trace point (see
+ * 'TRACE_EVENT()') is a single predictable branch.
+ * @author Rafael Antoniello
+ */
+
+#ifndef UTILS_SRC_TRACE_H_
+#define UTILS_SRC_TRACE_H_
+
+#include <sys/types.h>
+#include <inttypes.h>
+
+/* **** Definitions **** */
+
+/**
+ * Number of events of each per-thread ring buffer (must be a power of 2).
+ */
+#define TRACE_RING_EVENTS_NUM 8192
+
+/**
+ * Trace event types.
+ */
+typedef enum trace_event_type_e {
+	TRACE_EVENT_BEGIN= 0, ///< Beginning of a duration event
+	TRACE_EVENT_END, ///< End of a duration event
+	TRACE_EVENT_INSTANT, ///< Instant event
+	TRACE_EVENT_TYPE_MAX
+} trace_event_type_t;
+
+/**
+ * Tracing enabled indicator (non-zero while a capture is running).
+ * Do not modify directly; use 'trace_start()' and 'trace_stop()'.
+ */
+extern volatile int trace_flag_enabled;
+
+/**
+ * Record a trace event in the ring buffer of the calling thread, if tracing
+ * is enabled.
+ * @param NAME Event name. Must be a static character string (only the
+ * pointer is recorded).
+ * @param TYPE Event type (see 'trace_event_type_t').
+ * @param ID Identifier of the traced object (e.g. processor Id.).
+ * @param FRAME_ID Frame identifier (e.g. frame counter).
+ * @param PTS Frame presentation time-stamp (-1 if not applicable).
+ */
+#define TRACE_EVENT(NAME, TYPE, ID, FRAME_ID, PTS) \
+	do { \
+		if(__builtin_expect(trace_flag_enabled!= 0, 0)) \
+			trace_event_add(NAME, TYPE, ID, FRAME_ID, PTS); \
+	} while(0)
+
+/* **** Prototypes **** */
+
+/**
+ * Record a trace event in the ring buffer of the calling thread
+ * (unconditionally; use 'TRACE_EVENT()' in trace points instead).
+ * The ring buffer of the thread is allocated on its first event.
+ * @param name Event name (static character string).
+ * @param type Event type (see 'trace_event_type_t').
+ * @param id Identifier of the traced object (e.g. processor Id.).
+ * @param frame_id Frame identifier.
+ * @param pts Frame presentation time-stamp (-1 if not applicable).
+ */
+void trace_event_add(const char *name, trace_event_type_t type, int id,
+		uint64_t frame_id, int64_t pts);
+
+/**
+ * Start a new trace capture. Events of any previous capture are discarded.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h). STAT_ECONFLICT is returned if a
+ * capture is already running.
+ */
+int trace_start();
+
+/**
+ * Stop the running trace capture. Captured events are kept until the next
+ * capture is started.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h). STAT_ENOTFOUND is returned if no
+ * capture is running.
+ */
+int trace_stop();
+
+/**
+ * Get the events of the last capture in the Chrome trace event JSON format.
+ * The capture must be stopped.
+ * @param ref_str Reference to the pointer to the returned (allocated)
+ * null-terminated JSON text. Must be released by the calling application.
+ * @return Status code (STAT_SUCCESS code in case of success, for other code
+ * values please refer to .stat_codes.h). STAT_ECONFLICT is returned if a
+ * capture is running.
+ */
+int trace_get_chrome_json(char **ref_str);
+
+#endif /* UTILS_SRC_TRACE_H_ */
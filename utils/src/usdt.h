@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file usdt.h
+ * @brief User-level statically defined tracing (USDT) probes.
+ * Probes are compiled in only if the SystemTap 'sys/sdt.h' header is
+ * available (and 'DISABLE_USDT' is not defined); otherwise, they expand to
+ * nothing. Probes can be listed and attached to with 'perf', 'bpftrace',
+ * etc. (e.g. 'bpftrace -l "usdt:./libmediaprocs.so:mediaprocs:*"').
+ * All the probes are defined under the 'mediaprocs' provider.
+ * @author Rafael Antoniello
+ */
+
+#ifndef UTILS_SRC_USDT_H_
+#define UTILS_SRC_USDT_H_
+
+#if !defined(DISABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define USDT_ENABLED
+#endif
+#endif
+
+#ifdef USDT_ENABLED
+#define USDT_PROBE0(NAME) DTRACE_PROBE(mediaprocs, NAME)
+#define USDT_PROBE1(NAME, A1) DTRACE_PROBE1(mediaprocs, NAME, A1)
+#define USDT_PROBE2(NAME, A1, A2) DTRACE_PROBE2(mediaprocs, NAME, A1, A2)
+#define USDT_PROBE3(NAME, A1, A2, A3) \
+	DTRACE_PROBE3(mediaprocs, NAME, A1, A2, A3)
+#else
+#define USDT_PROBE0(NAME)
+#define USDT_PROBE1(NAME, A1)
+#define USDT_PROBE2(NAME, A1, A2)
+#define USDT_PROBE3(NAME, A1, A2, A3)
+#endif
+
+#endif /* UTILS_SRC_USDT_H_ */
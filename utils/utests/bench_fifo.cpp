@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_fifo.cpp
+ * @brief FIFO and fair-lock micro-benchmarks.
+ * - FIFO: producer threads put elements ('fifo_put_dup()') that consumer
+ * threads get ('fifo_get()'), on a local or a shared-memory FIFO, in
+ * blocking or non-blocking mode (in non-blocking mode, full/empty FIFO
+ * operations are retried). Each element carries the (monotonic) time it was
+ * put, so the put-to-get latency (queuing included) is measured at the
+ * consumers. With one thread, the same thread puts and gets each element.
+ * With N> 1 threads, N/2 producers and N/2 consumers share the FIFO.
+ * - Fair-lock: threads repeatedly acquire and release the same fair-lock
+ * (and, as a baseline, the same pthread mutex); the lock acquisition
+ * waiting time is measured.
+ * One JSON line is printed per case with the operations per second and the
+ * latency percentiles.
+ * Usage:
+ * mediaprocsutils_bench [-b fifo,fair_lock] [-t threads] [-s elem_sizes]
+ * [-d msecs]
+ * where lists are comma separated.
+ * @author Rafael Antoniello
+ */
+
+extern "C" {
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/fifo.h>
+#include <libmediaprocsutils/fair_lock.h>
+#include <libmediaprocsutils/bench_stats.h>
+}
+
+/* **** Definitions **** */
+
+#define BENCH_BENCHES_DEFAULT "fifo,fair_lock"
+#define BENCH_THREADS_DEFAULT "1,2,4,8,16,32,64"
+#define BENCH_SIZES_DEFAULT "64,4096,65536,1048576,12582912"
+#define BENCH_MSECS_DEFAULT 1000
+#define BENCH_LIST_MAX 16
+#define BENCH_THREADS_MAX 64
+
+/**
+ * FIFO slots: as many as fit in 'BENCH_FIFO_BYTES_MAX', within the range
+ * ['BENCH_FIFO_SLOTS_MIN', 'BENCH_FIFO_SLOTS_MAX'].
+ */
+#define BENCH_FIFO_SLOTS_MIN 2
+#define BENCH_FIFO_SLOTS_MAX 64
+#define BENCH_FIFO_BYTES_MAX (64* 1024* 1024)
+
+/**
+ * Cases needing more memory than this (elements owned by the producers,
+ * stored in the FIFO and owned by the consumers) are skipped.
+ */
+#define BENCH_MEMORY_MAX (1024LL* 1024* 1024)
+
+#define BENCH_FIFO_SHM_NAME "/fifo_shm_bench"
+
+#define BENCH_LATENCY_SAMPLES_MAX 16384
+
+/**
+ * Header written at the beginning of each FIFO element.
+ */
+typedef struct bench_elem_hdr_s {
+	int64_t put_usecs;
+} bench_elem_hdr_t;
+
+/**
+ * FIFO benchmark case.
+ */
+typedef struct bench_fifo_case_s {
+	fifo_ctx_t *fifo_ctx;
+	size_t elem_size;
+	int flag_nonblock;
+	volatile int flag_exit;
+	volatile int flag_producers_exited;
+} bench_fifo_case_t;
+
+/**
+ * Benchmark thread context structure (per-thread counters and statistics
+ * avoid sharing cache lines and locks among the measured threads).
+ */
+typedef struct bench_thr_ctx_s {
+	pthread_t thread;
+	bench_fifo_case_t *bench_fifo_case;
+	fair_lock_t *fair_lock;
+	pthread_mutex_t *mutex;
+	volatile int *ref_flag_exit;
+	uint64_t ops;
+	bench_stats_ctx_t *latency_stats;
+} bench_thr_ctx_t;
+
+/* **** Implementations **** */
+
+static inline int bench_fifo_put(bench_fifo_case_t *bench_fifo_case,
+		uint8_t *elem)
+{
+	int ret_code;
+	bench_elem_hdr_t bench_elem_hdr;
+
+	bench_elem_hdr.put_usecs= bench_now_usecs();
+	memcpy(elem, &bench_elem_hdr, sizeof(bench_elem_hdr));
+	while((ret_code= fifo_put_dup(bench_fifo_case->fifo_ctx, elem,
+			bench_fifo_case->elem_size))== STAT_ENOMEM &&
+			bench_fifo_case->flag_exit== 0)
+		schedule(); // Non-blocking mode: retry
+	return ret_code;
+}
+
+/**
+ * @return STAT_SUCCESS if an element was got and accounted, STAT_EAGAIN if
+ * FIFO is empty (non-blocking mode), other code if fails.
+ */
+static inline int bench_fifo_get(bench_fifo_case_t *bench_fifo_case,
+		bench_thr_ctx_t *bench_thr_ctx)
+{
+	int ret_code;
+	void *elem= NULL;
+	size_t elem_size= 0;
+	bench_elem_hdr_t bench_elem_hdr;
+
+	ret_code= fifo_get(bench_fifo_case->fifo_ctx, &elem, &elem_size);
+	if(ret_code!= STAT_SUCCESS || elem== NULL)
+		return ret_code!= STAT_SUCCESS? ret_code: STAT_ERROR;
+	memcpy(&bench_elem_hdr, elem, sizeof(bench_elem_hdr));
+	bench_stats_add(bench_thr_ctx->latency_stats, bench_now_usecs()-
+			bench_elem_hdr.put_usecs);
+	bench_thr_ctx->ops++;
+	free(elem);
+	return STAT_SUCCESS;
+}
+
+static void* bench_fifo_producer_thr(void *t)
+{
+	bench_thr_ctx_t *bench_thr_ctx= (bench_thr_ctx_t*)t;
+	bench_fifo_case_t *bench_fifo_case= bench_thr_ctx->bench_fifo_case;
+	uint8_t *elem= NULL;
+
+	schedule_set_thread_name("bench-producer");
+
+	elem= (uint8_t*)calloc(1, bench_fifo_case->elem_size);
+	if(elem== NULL)
+		return NULL;
+	while(bench_fifo_case->flag_exit== 0)
+		bench_fifo_put(bench_fifo_case, elem);
+	free(elem);
+	return NULL;
+}
+
+static void* bench_fifo_consumer_thr(void *t)
+{
+	int ret_code;
+	bench_thr_ctx_t *bench_thr_ctx= (bench_thr_ctx_t*)t;
+	bench_fifo_case_t *bench_fifo_case= bench_thr_ctx->bench_fifo_case;
+
+	schedule_set_thread_name("bench-consumer");
+
+	/* Consumers exit when the FIFO is empty after the producers exited
+	 * (FIFO is then set to non-blocking mode).
+	 */
+	for(;;) {
+		ret_code= bench_fifo_get(bench_fifo_case, bench_thr_ctx);
+		if(ret_code== STAT_SUCCESS)
+			continue;
+		if(bench_fifo_case->flag_producers_exited)
+			break;
+		schedule(); // Non-blocking mode: retry
+	}
+	return NULL;
+}
+
+/**
+ * Single-thread case: the same thread puts and gets each element.
+ */
+static void* bench_fifo_put_get_thr(void *t)
+{
+	bench_thr_ctx_t *bench_thr_ctx= (bench_thr_ctx_t*)t;
+	bench_fifo_case_t *bench_fifo_case= bench_thr_ctx->bench_fifo_case;
+	uint8_t *elem= NULL;
+
+	elem= (uint8_t*)calloc(1, bench_fifo_case->elem_size);
+	if(elem== NULL)
+		return NULL;
+	while(bench_fifo_case->flag_exit== 0) {
+		if(bench_fifo_put(bench_fifo_case, elem)!= STAT_SUCCESS ||
+				bench_fifo_get(bench_fifo_case, bench_thr_ctx)!=
+						STAT_SUCCESS)
+			break;
+	}
+	free(elem);
+	return NULL;
+}
+
+/**
+ * Print the aggregated results of the given threads as a JSON line.
+ */
+static void bench_results_print(const char *prefix_json,
+		bench_thr_ctx_t *bench_thr_ctx_array, int threads_num,
+		int64_t elapsed_usecs, size_t elem_size, const char *latency_name)
+{
+	int i;
+	uint64_t ops= 0;
+	double secs= (double)elapsed_usecs/ 1000000.0;
+	bench_stats_summary_t bench_stats_summary;
+	bench_stats_ctx_t *latency_stats= NULL;
+
+	memset(&bench_stats_summary, 0, sizeof(bench_stats_summary));
+	latency_stats= bench_stats_open(BENCH_LATENCY_SAMPLES_MAX* 4);
+	for(i= 0; i< threads_num; i++) {
+		if(bench_thr_ctx_array[i].latency_stats== NULL)
+			continue;
+		ops+= bench_thr_ctx_array[i].ops;
+		if(latency_stats!= NULL)
+			bench_stats_merge(latency_stats,
+					bench_thr_ctx_array[i].latency_stats);
+	}
+	if(latency_stats!= NULL)
+		bench_stats_summary_get(latency_stats, &bench_stats_summary);
+	bench_stats_close(&latency_stats);
+
+	printf("{%s,\"ops_per_sec\":%.1f,\"mbytes_per_sec\":%.1f,"
+			"\"%s\":{\"p50\":%" PRId64 ",\"p90\":%" PRId64 ",\"p99\":%" PRId64
+			",\"p999\":%" PRId64 ",\"max\":%" PRId64 "}}\n", prefix_json,
+			(double)ops/ secs, (double)ops* elem_size/ secs/ 1000000.0,
+			latency_name, bench_stats_summary.p50, bench_stats_summary.p90,
+			bench_stats_summary.p99, bench_stats_summary.p999,
+			bench_stats_summary.max);
+	fflush(stdout);
+}
+
+static int bench_fifo_case_run(int flag_shm, int flag_nonblock,
+		int threads_num, size_t elem_size, int msecs)
+{
+	int i, end_code= STAT_ERROR;
+	int producers_num= threads_num> 1? threads_num/ 2: 0;
+	int consumers_num= threads_num> 1? threads_num/ 2: 1;
+	size_t slots_max;
+	int64_t t0_usecs, t1_usecs;
+	char prefix_json[256];
+	bench_fifo_case_t bench_fifo_case;
+	bench_thr_ctx_t *bench_thr_ctx_array= NULL;
+
+	memset(&bench_fifo_case, 0, sizeof(bench_fifo_case));
+	bench_fifo_case.elem_size= elem_size;
+	bench_fifo_case.flag_nonblock= flag_nonblock;
+
+	slots_max= BENCH_FIFO_BYTES_MAX/ elem_size;
+	if(slots_max< BENCH_FIFO_SLOTS_MIN)
+		slots_max= BENCH_FIFO_SLOTS_MIN;
+	if(slots_max> BENCH_FIFO_SLOTS_MAX)
+		slots_max= BENCH_FIFO_SLOTS_MAX;
+	if((long long)(slots_max+ producers_num+ consumers_num)* elem_size>
+			BENCH_MEMORY_MAX) {
+		fprintf(stderr, "Skipping FIFO case (threads: %d, element size: "
+				"%zu): exceeds memory limit\n", threads_num, elem_size);
+		return STAT_SUCCESS;
+	}
+
+	/* Open FIFO */
+	if(flag_shm)
+		bench_fifo_case.fifo_ctx= fifo_shm_open(slots_max, elem_size,
+				flag_nonblock? FIFO_O_NONBLOCK: 0, BENCH_FIFO_SHM_NAME);
+	else
+		bench_fifo_case.fifo_ctx= fifo_open(slots_max, 0,
+				flag_nonblock? FIFO_O_NONBLOCK: 0, NULL);
+	if(bench_fifo_case.fifo_ctx== NULL)
+		goto end;
+
+	bench_thr_ctx_array= (bench_thr_ctx_t*)calloc(threads_num,
+			sizeof(bench_thr_ctx_t));
+	if(bench_thr_ctx_array== NULL)
+		goto end;
+	for(i= 0; i< threads_num; i++) {
+		bench_thr_ctx_array[i].bench_fifo_case= &bench_fifo_case;
+		if(i< consumers_num && (bench_thr_ctx_array[i].latency_stats=
+				bench_stats_open(BENCH_LATENCY_SAMPLES_MAX))== NULL)
+			goto end;
+	}
+
+	/* Run: consumers are the first 'consumers_num' threads */
+	t0_usecs= bench_now_usecs();
+	for(i= 0; i< threads_num; i++) {
+		void*(*start_routine)(void*)= threads_num== 1?
+				bench_fifo_put_get_thr: (i< consumers_num?
+						bench_fifo_consumer_thr: bench_fifo_producer_thr);
+		pthread_create(&bench_thr_ctx_array[i].thread, NULL, start_routine,
+				&bench_thr_ctx_array[i]);
+	}
+	usleep((useconds_t)msecs* 1000);
+
+	/* Stop: producers first, then drain FIFO and stop consumers */
+	bench_fifo_case.flag_exit= 1;
+	t1_usecs= bench_now_usecs();
+	for(i= consumers_num; i< threads_num; i++)
+		pthread_join(bench_thr_ctx_array[i].thread, NULL);
+	bench_fifo_case.flag_producers_exited= 1;
+	fifo_set_blocking_mode(bench_fifo_case.fifo_ctx, 0);
+	for(i= 0; i< consumers_num; i++)
+		pthread_join(bench_thr_ctx_array[i].thread, NULL);
+
+	snprintf(prefix_json, sizeof(prefix_json), "\"bench\":\"fifo\","
+			"\"fifo\":\"%s\",\"mode\":\"%s\",\"threads\":%d,"
+			"\"elem_bytes\":%zu,\"slots\":%zu", flag_shm? "shm": "local",
+			flag_nonblock? "nonblocking": "blocking", threads_num, elem_size,
+			slots_max);
+	bench_results_print(prefix_json, bench_thr_ctx_array, consumers_num,
+			t1_usecs- t0_usecs, elem_size, "latency_usecs");
+
+	end_code= STAT_SUCCESS;
+end:
+	if(bench_thr_ctx_array!= NULL) {
+		for(i= 0; i< threads_num; i++)
+			bench_stats_close(&bench_thr_ctx_array[i].latency_stats);
+		free(bench_thr_ctx_array);
+	}
+	fifo_close(&bench_fifo_case.fifo_ctx);
+	return end_code;
+}
+
+static void* bench_lock_thr(void *t)
+{
+	bench_thr_ctx_t *bench_thr_ctx= (bench_thr_ctx_t*)t;
+	static volatile uint64_t shared_counter= 0;
+
+	schedule_set_thread_name("bench-lock");
+
+	while(*bench_thr_ctx->ref_flag_exit== 0) {
+		int64_t t0_usecs= bench_now_usecs();
+
+		if(bench_thr_ctx->fair_lock!= NULL)
+			fair_lock(bench_thr_ctx->fair_lock);
+		else
+			pthread_mutex_lock(bench_thr_ctx->mutex);
+		bench_stats_add(bench_thr_ctx->latency_stats, bench_now_usecs()-
+				t0_usecs);
+		shared_counter++; // Critical section
+		if(bench_thr_ctx->fair_lock!= NULL)
+			fair_unlock(bench_thr_ctx->fair_lock);
+		else
+			pthread_mutex_unlock(bench_thr_ctx->mutex);
+		bench_thr_ctx->ops++;
+	}
+	return NULL;
+}
+
+/**
+ * Lock contention case: 'flag_fair' selects the fair-lock or the pthread
+ * mutex (baseline).
+ */
+static int bench_lock_case_run(int flag_fair, int threads_num, int msecs)
+{
+	int i, end_code= STAT_ERROR;
+	volatile int flag_exit= 0;
+	int64_t t0_usecs, t1_usecs;
+	char prefix_json[128];
+	fair_lock_t *fair_lock= NULL;
+	pthread_mutex_t mutex;
+	bench_thr_ctx_t *bench_thr_ctx_array= NULL;
+
+	pthread_mutex_init(&mutex, NULL);
+	if(flag_fair && (fair_lock= fair_lock_open())== NULL)
+		goto end;
+
+	bench_thr_ctx_array= (bench_thr_ctx_t*)calloc(threads_num,
+			sizeof(bench_thr_ctx_t));
+	if(bench_thr_ctx_array== NULL)
+		goto end;
+	for(i= 0; i< threads_num; i++) {
+		bench_thr_ctx_array[i].fair_lock= fair_lock;
+		bench_thr_ctx_array[i].mutex= &mutex;
+		bench_thr_ctx_array[i].ref_flag_exit= &flag_exit;
+		if((bench_thr_ctx_array[i].latency_stats= bench_stats_open(
+				BENCH_LATENCY_SAMPLES_MAX))== NULL)
+			goto end;
+	}
+
+	t0_usecs= bench_now_usecs();
+	for(i= 0; i< threads_num; i++)
+		pthread_create(&bench_thr_ctx_array[i].thread, NULL, bench_lock_thr,
+				&bench_thr_ctx_array[i]);
+	usleep((useconds_t)msecs* 1000);
+	flag_exit= 1;
+	t1_usecs= bench_now_usecs();
+	for(i= 0; i< threads_num; i++)
+		pthread_join(bench_thr_ctx_array[i].thread, NULL);
+
+	snprintf(prefix_json, sizeof(prefix_json), "\"bench\":\"%s\","
+			"\"threads\":%d", flag_fair? "fair_lock": "pthread_mutex",
+			threads_num);
+	bench_results_print(prefix_json, bench_thr_ctx_array, threads_num,
+			t1_usecs- t0_usecs, 0, "wait_usecs");
+
+	end_code= STAT_SUCCESS;
+end:
+	if(bench_thr_ctx_array!= NULL) {
+		for(i= 0; i< threads_num; i++)
+			bench_stats_close(&bench_thr_ctx_array[i].latency_stats);
+		free(bench_thr_ctx_array);
+	}
+	fair_lock_close(&fair_lock);
+	pthread_mutex_destroy(&mutex);
+	return end_code;
+}
+
+static void usage(const char *prog_name)
+{
+	fprintf(stderr, "Usage: %s [-b benches] [-t threads] [-s elem_sizes] "
+			"[-d msecs]\nLists are comma separated; defaults: -b "
+			BENCH_BENCHES_DEFAULT " -t " BENCH_THREADS_DEFAULT " -s "
+			BENCH_SIZES_DEFAULT " -d %d\n", prog_name, BENCH_MSECS_DEFAULT);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, b, t, s, shm, nonblock, msecs= BENCH_MSECS_DEFAULT;
+	int benches_num, threads_list_num, sizes_num;
+	char benches_str[256]= BENCH_BENCHES_DEFAULT;
+	char threads_str[256]= BENCH_THREADS_DEFAULT;
+	char sizes_str[256]= BENCH_SIZES_DEFAULT;
+	char *benches[BENCH_LIST_MAX], *threads_list[BENCH_LIST_MAX],
+			*sizes[BENCH_LIST_MAX];
+
+	while((opt= getopt(argc, argv, "b:t:s:d:"))!= -1) {
+		switch(opt) {
+		case 'b':
+			snprintf(benches_str, sizeof(benches_str), "%s", optarg);
+			break;
+		case 't':
+			snprintf(threads_str, sizeof(threads_str), "%s", optarg);
+			break;
+		case 's':
+			snprintf(sizes_str, sizeof(sizes_str), "%s", optarg);
+			break;
+		case 'd':
+			msecs= atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	benches_num= bench_list_parse(benches_str, benches, BENCH_LIST_MAX);
+	threads_list_num= bench_list_parse(threads_str, threads_list,
+			BENCH_LIST_MAX);
+	sizes_num= bench_list_parse(sizes_str, sizes, BENCH_LIST_MAX);
+	for(t= 0; t< threads_list_num; t++) {
+		int threads_num= atoi(threads_list[t]);
+		if(threads_num< 1 || threads_num> BENCH_THREADS_MAX) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	for(s= 0; s< sizes_num; s++) {
+		if(atol(sizes[s])< (long)sizeof(bench_elem_hdr_t)) {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(msecs< 1 || benches_num< 1 || threads_list_num< 1 || sizes_num< 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if(log_module_open()!= STAT_SUCCESS)
+		return EXIT_FAILURE;
+
+	for(b= 0; b< benches_num; b++) {
+		if(strcmp(benches[b], "fifo")== 0) {
+			for(shm= 0; shm< 2; shm++)
+				for(nonblock= 0; nonblock< 2; nonblock++)
+					for(s= 0; s< sizes_num; s++)
+						for(t= 0; t< threads_list_num; t++)
+							if(bench_fifo_case_run(shm, nonblock,
+									atoi(threads_list[t]),
+									(size_t)atol(sizes[s]), msecs)!=
+											STAT_SUCCESS)
+								fprintf(stderr, "FIFO benchmark case "
+										"failed\n");
+		} else if(strcmp(benches[b], "fair_lock")== 0) {
+			for(t= 0; t< threads_list_num; t++) {
+				bench_lock_case_run(1, atoi(threads_list[t]), msecs);
+				bench_lock_case_run(0, atoi(threads_list[t]), msecs);
+			}
+		} else {
+			fprintf(stderr, "Unknown benchmark '%s'\n", benches[b]);
+		}
+	}
+
+	log_module_close();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file utests_bench_stats.cpp
+ * @brief Benchmarking statistics module unit-testing
+ * @author Rafael Antoniello
+ */
+
+#include <UnitTest++/UnitTest++.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/bench_stats.h>
+}
+
+SUITE(UTESTS_BENCH_STATS)
+{
+	TEST(BENCH_STATS_PERCENTILES)
+	{
+		int i;
+		bench_stats_summary_t bench_stats_summary;
+		bench_stats_ctx_t *bench_stats_ctx= NULL;
+
+		bench_stats_ctx= bench_stats_open(1000);
+		CHECK(bench_stats_ctx!= NULL);
+		if(bench_stats_ctx== NULL)
+			return;
+
+		/* No samples */
+		bench_stats_summary_get(bench_stats_ctx, &bench_stats_summary);
+		CHECK(bench_stats_summary.count== 0);
+		CHECK(bench_stats_percentile(bench_stats_ctx, 50)== 0);
+
+		/* Samples 1..100 added in reverse order */
+		for(i= 100; i> 0; i--)
+			bench_stats_add(bench_stats_ctx, i);
+		bench_stats_summary_get(bench_stats_ctx, &bench_stats_summary);
+		CHECK(bench_stats_summary.count== 100);
+		CHECK(bench_stats_summary.min== 1);
+		CHECK(bench_stats_summary.max== 100);
+		CHECK_CLOSE(50.5, bench_stats_summary.mean, 0.001);
+		CHECK(bench_stats_summary.p50== 50);
+		CHECK(bench_stats_summary.p90== 90);
+		CHECK(bench_stats_summary.p99== 99);
+		CHECK(bench_stats_summary.p999== 100);
+		CHECK(bench_stats_percentile(bench_stats_ctx, 0)== 1);
+		CHECK(bench_stats_percentile(bench_stats_ctx, 100)== 100);
+
+		/* Reset */
+		bench_stats_reset(bench_stats_ctx);
+		bench_stats_summary_get(bench_stats_ctx, &bench_stats_summary);
+		CHECK(bench_stats_summary.count== 0);
+
+		bench_stats_close(&bench_stats_ctx);
+		CHECK(bench_stats_ctx== NULL);
+	}
+
+	TEST(BENCH_STATS_RESERVOIR_AND_MERGE)
+	{
+		int i;
+		bench_stats_summary_t bench_stats_summary;
+		bench_stats_ctx_t *bench_stats_ctx= NULL, *bench_stats_ctx_src= NULL;
+
+		bench_stats_ctx= bench_stats_open(16);
+		bench_stats_ctx_src= bench_stats_open(16);
+		CHECK(bench_stats_ctx!= NULL && bench_stats_ctx_src!= NULL);
+		if(bench_stats_ctx== NULL || bench_stats_ctx_src== NULL)
+			goto end;
+
+		/* More samples than capacity: exact statistics are kept */
+		for(i= 0; i< 10000; i++)
+			bench_stats_add(bench_stats_ctx_src, i% 100);
+		bench_stats_summary_get(bench_stats_ctx_src, &bench_stats_summary);
+		CHECK(bench_stats_summary.count== 10000);
+		CHECK(bench_stats_summary.min== 0);
+		CHECK(bench_stats_summary.max== 99);
+		CHECK_CLOSE(49.5, bench_stats_summary.mean, 0.001);
+		CHECK(bench_stats_summary.p50>= 0 && bench_stats_summary.p50<= 99);
+
+		/* Merge */
+		bench_stats_add(bench_stats_ctx, 1000);
+		bench_stats_merge(bench_stats_ctx, bench_stats_ctx_src);
+		bench_stats_summary_get(bench_stats_ctx, &bench_stats_summary);
+		CHECK(bench_stats_summary.count== 10001);
+		CHECK(bench_stats_summary.min== 0);
+		CHECK(bench_stats_summary.max== 1000);
+		CHECK_CLOSE((49.5* 10000+ 1000)/ 10001, bench_stats_summary.mean,
+				0.001);
+
+		/* Process measures */
+		CHECK(bench_now_usecs()> 0);
+		CHECK(bench_rss_kbytes()> 0);
+		CHECK(bench_rss_peak_kbytes()> 0);
+		CHECK(bench_threads_num()>= 1);
+
+end:
+		bench_stats_close(&bench_stats_ctx);
+		bench_stats_close(&bench_stats_ctx_src);
+	}
+
+	TEST(BENCH_LIST_PARSE)
+	{
+		char str[]= "1,4,,16,64";
+		char *list[3]= {NULL};
+
+		CHECK(bench_list_parse(str, list, 3)== 3);
+		CHECK(strcmp(list[0], "1")== 0);
+		CHECK(strcmp(list[1], "4")== 0);
+		CHECK(strcmp(list[2], "16")== 0);
+		CHECK(bench_list_parse(NULL, list, 3)== 0);
+	}
+}
@@ -283,4 +283,86 @@ SUITE(UTESTS_FIFO)
 
 		LOGV("... passed O.K.\n");
 	}
+
+	TEST(FIFO_WAIT_TIME)
+	{
+		fifo_ctx_t *fifo_ctx;
+		int ret_val;
+		uint8_t elem[16]= {0}, *elem2= NULL;
+		size_t elem2_size= 0;
+		uint64_t put_wait_nsec= 1, get_wait_nsec= 1;
+		LOG_CTX_INIT(NULL);
+
+	    LOGV("\n\nExecuting UTESTS_FIFO::FIFO_WAIT_TIME...\n");
+
+	    fifo_ctx= fifo_open(1, 0, 0, NULL);
+	    CHECK_DO(fifo_ctx!= NULL, CHECK(false); return);
+
+	    /* Nothing accounted yet */
+	    ret_val= fifo_get_wait_nsec(fifo_ctx, &put_wait_nsec, &get_wait_nsec);
+	    CHECK(ret_val== STAT_SUCCESS);
+	    CHECK(put_wait_nsec== 0 && get_wait_nsec== 0);
+
+	    /* Non-blocking transactions are not accounted */
+	    ret_val= fifo_put_dup(fifo_ctx, elem, sizeof(elem));
+	    CHECK(ret_val== STAT_SUCCESS);
+	    ret_val= fifo_get(fifo_ctx, (void**)&elem2, &elem2_size);
+	    CHECK(ret_val== STAT_SUCCESS && elem2!= NULL);
+	    free(elem2);
+	    elem2= NULL;
+	    ret_val= fifo_get_wait_nsec(fifo_ctx, &put_wait_nsec, &get_wait_nsec);
+	    CHECK(ret_val== STAT_SUCCESS);
+	    CHECK(put_wait_nsec== 0 && get_wait_nsec== 0);
+
+	    /* Block on empty FIFO until time-out */
+	    ret_val= fifo_timedget(fifo_ctx, (void**)&elem2, &elem2_size, 20000);
+	    CHECK(ret_val== STAT_ETIMEDOUT);
+	    ret_val= fifo_get_wait_nsec(fifo_ctx, NULL, &get_wait_nsec);
+	    CHECK(ret_val== STAT_SUCCESS);
+	    CHECK(get_wait_nsec>= 20000000);
+
+	    fifo_close(&fifo_ctx);
+
+		LOGV("... passed O.K.\n");
+	}
+
+	TEST(FIFO_TRYPUT)
+	{
+		fifo_ctx_t *fifo_ctx;
+		int ret_val;
+		uint8_t *elem= NULL, *elem2= NULL;
+		size_t elem2_size= 0;
+		LOG_CTX_INIT(NULL);
+
+	    LOGV("\n\nExecuting UTESTS_FIFO::FIFO_TRYPUT...\n");
+
+	    /* Blocking FIFO of one slot */
+	    fifo_ctx= fifo_open(1, 0, 0, NULL);
+	    CHECK_DO(fifo_ctx!= NULL, CHECK(false); return);
+
+	    elem= (uint8_t*)calloc(1, 16);
+	    CHECK_DO(elem!= NULL, CHECK(false); goto end);
+	    ret_val= fifo_tryput(fifo_ctx, (void**)&elem, 16);
+	    CHECK(ret_val== STAT_SUCCESS && elem== NULL);
+
+	    /* FIFO is full: must not block, element is not consumed */
+	    elem= (uint8_t*)calloc(1, 16);
+	    CHECK_DO(elem!= NULL, CHECK(false); goto end);
+	    ret_val= fifo_tryput(fifo_ctx, (void**)&elem, 16);
+	    CHECK(ret_val== STAT_ENOMEM && elem!= NULL);
+	    CHECK(fifo_get_slots_used(fifo_ctx)== 1);
+
+	    /* Blocking mode of the FIFO is preserved for the consumer */
+	    ret_val= fifo_get(fifo_ctx, (void**)&elem2, &elem2_size);
+	    CHECK(ret_val== STAT_SUCCESS && elem2!= NULL && elem2_size== 16);
+
+end:
+		if(elem!= NULL)
+			free(elem);
+		if(elem2!= NULL)
+			free(elem2);
+	    fifo_close(&fifo_ctx);
+
+		LOGV("... passed O.K.\n");
+	}
 }
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file utests_json_writer.cpp
+ * @brief Streaming JSON writer unit-testing
+ * @author Rafael Antoniello
+ */
+
+#include <UnitTest++/UnitTest++.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define ENABLE_DEBUG_LOGS //uncomment to trace logs
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/json_writer.h>
+}
+
+SUITE(UTESTS_JSON_WRITER)
+{
+	TEST(JSON_WRITER_SIMPLE_TEST)
+	{
+		json_writer_ctx_t *json_writer_ctx= NULL;
+		const char *str;
+		const char *expected_str=
+				"{\"id\":-3,\"name\":\"a\\\"b\\\\c\\n\\u0001\","
+				"\"settings\":{\"proc_name\":\"bypass\",\"rate\":2.5,"
+				"\"count\":25,\"flag\":true,\"none\":null},"
+				"\"list\":[1,{\"raw\":[0]},\"x\"],\"empty\":{}}";
+		LOG_CTX_INIT(NULL);
+
+		/* Use a tiny initial size to force buffer growth */
+		json_writer_ctx= json_writer_open(4);
+		CHECK_DO(json_writer_ctx!= NULL, CHECK(false); goto end);
+
+		CHECK(json_writer_set_object_prefix(json_writer_ctx, "settings",
+				"proc_name", "bypass")== STAT_SUCCESS);
+
+		json_writer_object_start(json_writer_ctx, NULL);
+		json_writer_int(json_writer_ctx, "id", -3);
+		json_writer_string(json_writer_ctx, "name", "a\"b\\c\n\001");
+		json_writer_object_start(json_writer_ctx, "settings");
+		json_writer_double(json_writer_ctx, "rate", 2.5);
+		json_writer_double(json_writer_ctx, "count", 25.0);
+		json_writer_bool(json_writer_ctx, "flag", 1);
+		json_writer_string(json_writer_ctx, "none", NULL);
+		json_writer_object_end(json_writer_ctx);
+		json_writer_array_start(json_writer_ctx, "list");
+		json_writer_int(json_writer_ctx, NULL, 1);
+		json_writer_object_start(json_writer_ctx, NULL);
+		json_writer_raw(json_writer_ctx, "raw", "[0]");
+		json_writer_object_end(json_writer_ctx);
+		json_writer_string(json_writer_ctx, NULL, "x");
+		json_writer_array_end(json_writer_ctx);
+		json_writer_object_start(json_writer_ctx, "empty");
+		json_writer_object_end(json_writer_ctx);
+		CHECK(json_writer_object_end(json_writer_ctx)== STAT_SUCCESS);
+
+		str= json_writer_get_str(json_writer_ctx, NULL);
+		CHECK_DO(str!= NULL, CHECK(false); goto end);
+		CHECK(strcmp(str, expected_str)== 0);
+
+		/* Re-use writer */
+		json_writer_reset(json_writer_ctx);
+		CHECK(json_writer_get_str(json_writer_ctx, NULL)== NULL);
+		CHECK(json_writer_array_start(json_writer_ctx, NULL)== STAT_SUCCESS);
+		CHECK(json_writer_array_end(json_writer_ctx)== STAT_SUCCESS);
+		str= json_writer_get_str(json_writer_ctx, NULL);
+		CHECK(str!= NULL && strcmp(str, "[]")== 0);
+
+end:
+		json_writer_close(&json_writer_ctx);
+	}
+
+	TEST(JSON_WRITER_ERRORS_TEST)
+	{
+		json_writer_ctx_t *json_writer_ctx= NULL;
+		LOG_CTX_INIT(NULL);
+
+		json_writer_ctx= json_writer_open(0);
+		CHECK_DO(json_writer_ctx!= NULL, CHECK(false); goto end);
+
+		/* Unbalanced text is not returned */
+		json_writer_object_start(json_writer_ctx, NULL);
+		CHECK(json_writer_get_str(json_writer_ctx, NULL)== NULL);
+
+		/* Member name is mandatory within objects; errors are sticky */
+		CHECK(json_writer_int(json_writer_ctx, NULL, 1)== STAT_EINVAL);
+		CHECK(json_writer_int(json_writer_ctx, "a", 1)== STAT_EINVAL);
+		CHECK(json_writer_object_end(json_writer_ctx)== STAT_EINVAL);
+		CHECK(json_writer_get_str(json_writer_ctx, NULL)== NULL);
+
+		/* Mismatched container end */
+		json_writer_reset(json_writer_ctx);
+		json_writer_array_start(json_writer_ctx, NULL);
+		CHECK(json_writer_object_end(json_writer_ctx)== STAT_EINVAL);
+
+end:
+		json_writer_close(&json_writer_ctx);
+	}
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2017, 2018 Rafael Antoniello
+ *
+ * This file is part of MediaProcessors.
+ *
+ * MediaProcessors is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MediaProcessors is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with MediaProcessors. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file utests_trace.cpp
+ * @brief Per-frame tracing module unit-testing
+ * @author Rafael Antoniello
+ */
+
+#include <UnitTest++/UnitTest++.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <inttypes.h>
+
+#define ENABLE_DEBUG_LOGS //uncomment to trace logs
+#include <libmediaprocsutils/log.h>
+#include <libmediaprocsutils/stat_codes.h>
+#include <libmediaprocsutils/check_utils.h>
+#include <libmediaprocsutils/schedule.h>
+#include <libmediaprocsutils/trace.h>
+}
+
+static void* trace_utest_thr(void *t)
+{
+	int i;
+
+	schedule_set_thread_name("trace_utest_thr");
+	for(i= 0; i< 3; i++) {
+		TRACE_EVENT("thr_process", TRACE_EVENT_BEGIN, 7, i, i* 10);
+		TRACE_EVENT("thr_process", TRACE_EVENT_END, 7, i, i* 10);
+	}
+	return NULL;
+}
+
+/**
+ * Number of events recorded by 'trace_utest_writer_thr()' (an event is
+ * completely recorded once counted).
+ */
+static volatile uint64_t trace_utest_writer_cnt= 0;
+static volatile int trace_utest_writer_exit= 0;
+
+static void* trace_utest_writer_thr(void *t)
+{
+	uint64_t i;
+
+	for(i= 0; __atomic_load_n(&trace_utest_writer_exit,
+			__ATOMIC_ACQUIRE)== 0; i++) {
+		TRACE_EVENT("writer", TRACE_EVENT_INSTANT, 9, i, -1);
+		__atomic_store_n(&trace_utest_writer_cnt, i+ 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+SUITE(UTESTS_TRACE)
+{
+	TEST(TRACE_CAPTURE)
+	{
+		int i, ret_code;
+		pthread_t thread;
+		char *json_str= NULL;
+		const char *p;
+		LOG_CTX_INIT(NULL);
+
+		/* Not running: events are not recorded */
+		ret_code= trace_stop();
+		CHECK(ret_code== STAT_ENOTFOUND);
+		TRACE_EVENT("not_recorded", TRACE_EVENT_INSTANT, 0, 0, -1);
+
+		ret_code= trace_start();
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= trace_start();
+		CHECK(ret_code== STAT_ECONFLICT);
+		ret_code= trace_get_chrome_json(&json_str);
+		CHECK(ret_code== STAT_ECONFLICT && json_str== NULL);
+
+		/* Record events from this and from other thread */
+		TRACE_EVENT("main_enqueue", TRACE_EVENT_INSTANT, 1, 100, 2000);
+		CHECK(pthread_create(&thread, NULL, trace_utest_thr, NULL)== 0);
+		CHECK(pthread_join(thread, NULL)== 0);
+
+		ret_code= trace_stop();
+		CHECK(ret_code== STAT_SUCCESS);
+		TRACE_EVENT("not_recorded", TRACE_EVENT_INSTANT, 0, 0, -1);
+
+		ret_code= trace_get_chrome_json(&json_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && json_str!= NULL,
+				CHECK(false); return);
+		//printf("Trace: '%s'\n", json_str); fflush(stdout); //comment-me
+		CHECK(strstr(json_str, "{\"traceEvents\":[")== json_str);
+		CHECK(strstr(json_str, "not_recorded")== NULL);
+		CHECK(strstr(json_str, "{\"name\":\"main_enqueue\",\"ph\":\"i\","
+				"\"s\":\"t\",\"ts\":")!= NULL);
+		CHECK(strstr(json_str, "\"args\":{\"id\":1,\"frame_id\":100,"
+				"\"pts\":2000}}")!= NULL);
+		CHECK(strstr(json_str, "\"args\":{\"name\":\"trace_utest_thr\"}")!=
+				NULL);
+		for(i= 0, p= json_str; (p= strstr(p, "\"name\":\"thr_process\""))!=
+				NULL; p++, i++);
+		CHECK(i== 6);
+		CHECK(strstr(json_str, "\"displayTimeUnit\":\"ms\"}")!= NULL);
+		free(json_str);
+		json_str= NULL;
+
+		/* New capture discards previous events (exited thread ring is
+		 * released).
+		 */
+		ret_code= trace_start();
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= trace_stop();
+		CHECK(ret_code== STAT_SUCCESS);
+		ret_code= trace_get_chrome_json(&json_str);
+		CHECK_DO(ret_code== STAT_SUCCESS && json_str!= NULL,
+				CHECK(false); return);
+		CHECK(strcmp(json_str, "{\"traceEvents\":[],"
+				"\"displayTimeUnit\":\"ms\"}")== 0);
+		free(json_str);
+	}
+
+	TEST(TRACE_RESTART_WHILE_RECORDING)
+	{
+		int capture, ret_code;
+		pthread_t thread;
+		char *json_str= NULL;
+		const char *p;
+		const char *frame_id_str= "\"args\":{\"id\":9,\"frame_id\":";
+		LOG_CTX_INIT(NULL);
+
+		__atomic_store_n(&trace_utest_writer_exit, 0, __ATOMIC_RELEASE);
+		CHECK(pthread_create(&thread, NULL, trace_utest_writer_thr, NULL)==
+				0);
+
+		/* Restart captures while the other thread is recording: no event
+		 * completed before a capture started may be exported with it.
+		 */
+		for(capture= 0; capture< 50; capture++) {
+			uint64_t cnt_at_start, frame_id_min= UINT64_MAX;
+
+			cnt_at_start= __atomic_load_n(&trace_utest_writer_cnt,
+					__ATOMIC_ACQUIRE);
+			ret_code= trace_start();
+			CHECK(ret_code== STAT_SUCCESS);
+			usleep(1000);
+			ret_code= trace_stop();
+			CHECK(ret_code== STAT_SUCCESS);
+
+			ret_code= trace_get_chrome_json(&json_str);
+			CHECK_DO(ret_code== STAT_SUCCESS && json_str!= NULL,
+					CHECK(false); break);
+			for(p= json_str; (p= strstr(p, frame_id_str))!= NULL; p++) {
+				uint64_t frame_id= strtoull(p+ strlen(frame_id_str), NULL,
+						10);
+				if(frame_id< frame_id_min)
+					frame_id_min= frame_id;
+			}
+			CHECK(frame_id_min== UINT64_MAX || frame_id_min>= cnt_at_start);
+			free(json_str);
+			json_str= NULL;
+		}
+
+		__atomic_store_n(&trace_utest_writer_exit, 1, __ATOMIC_RELEASE);
+		CHECK(pthread_join(thread, NULL)== 0);
+	}
+}